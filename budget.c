@@ -0,0 +1,78 @@
+#include "budget.h"
+
+_Thread_local Budget *currentBudget;
+
+void initializeBudget(Budget *budget, double timeLimit, long memoryLimit) {
+    memset(budget, 0, sizeof(Budget));
+    budget->timeLimit = timeLimit;
+    budget->memoryLimit = memoryLimit;
+}
+
+// Makes budget current on this thread; the deadline is whatever time earlier stages left over.
+void beginBudget(Budget *budget) {
+    budget->startTime = getCurrentTime();
+    budget->deadline = (budget->timeLimit > 0) ? budget->startTime + budget->timeLimit - budget->timeUsed : 0;
+    budget->countdown = BUDGET_CHECK_INTERVAL;
+    currentBudget = budget;
+}
+
+void endBudget(Budget *budget) {
+    budget->timeUsed += getCurrentTime() - budget->startTime;
+    currentBudget = NULL;
+}
+
+bool isOverBudget() {
+    Budget *budget = currentBudget;
+
+    if (budget == NULL) {
+        return false;
+    }
+
+    budget->steps++;
+
+    if (budget->status != BUDGET_OK) {
+        return true;
+    }
+
+    if (budget->deadline > 0 && --budget->countdown <= 0) {
+        budget->countdown = BUDGET_CHECK_INTERVAL;
+
+        if (getCurrentTime() > budget->deadline) {
+            budget->status = BUDGET_TIME_EXCEEDED;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Records an allocation against the current file and reports whether it is now over either ceiling.
+bool chargeBudget(long bytes) {
+    Budget *budget = currentBudget;
+
+    if (budget == NULL) {
+        return false;
+    }
+
+    budget->memoryUsed += bytes;
+
+    if (budget->memoryLimit > 0 && budget->memoryUsed > budget->memoryLimit && budget->status == BUDGET_OK) {
+        budget->status = BUDGET_MEMORY_EXCEEDED;
+    }
+
+    return isOverBudget();
+}
+
+const char *getBudgetStatusName(int status) {
+    switch (status) {
+        case BUDGET_TIME_EXCEEDED: {
+            return "time";
+        }
+        case BUDGET_MEMORY_EXCEEDED: {
+            return "memory";
+        }
+        default: {
+            return "none";
+        }
+    }
+}
\ No newline at end of file
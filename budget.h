@@ -0,0 +1,35 @@
+#pragma once
+
+#include "util.h"
+
+// clock reads are amortized over this many budget checks
+#define BUDGET_CHECK_INTERVAL 1024
+
+enum BudgetStatus {
+    BUDGET_OK,
+    BUDGET_TIME_EXCEEDED,
+    BUDGET_MEMORY_EXCEEDED
+};
+
+// Per-file ceilings; a zero limit means unlimited. Time is summed over the stages that check it.
+// steps counts the checks themselves, a deterministic measure of work that cost tests can compare across sizes.
+typedef struct Budget {
+    double timeLimit;
+    long memoryLimit;
+    double timeUsed;
+    long memoryUsed;
+    double startTime;
+    double deadline;
+    long steps;
+    int countdown;
+    int status;
+} Budget;
+
+extern _Thread_local Budget *currentBudget;
+
+void initializeBudget(Budget *budget, double timeLimit, long memoryLimit);
+void beginBudget(Budget *budget);
+void endBudget(Budget *budget);
+bool isOverBudget();
+bool chargeBudget(long bytes);
+const char *getBudgetStatusName(int status);
\ No newline at end of file
@@ -0,0 +1,505 @@
+#include "buildstate.h"
+#include "scan.h"
+#include "typelib.h"
+
+#define BUILD_STATE_MAGIC   0x53544256
+#define BUILD_STATE_VERSION 2
+
+typedef struct ModuleCheck {
+    ProjectFile *file;
+    const BuildState *previous;
+    ModuleState *module;
+    int status;
+    int changedCount;
+    uint64_t *changed;
+} ModuleCheck;
+
+BuildState *buildBuildState(int capacity) {
+    BuildState *state = malloc(sizeof(BuildState));
+    state->optionsHash = 0;
+    state->modules = buildVectorList();
+    state->moduleMap = buildStringMap(capacity * 2 + 1);
+
+    return state;
+}
+
+void pushModuleState(BuildState *state, ModuleState *module) {
+    pushVector(state->modules, module);
+    appendStringMap(state->moduleMap, module->path, module);
+}
+
+void freeModuleState(ModuleState *module) {
+    free(module->path);
+    free(module->definitionNames);
+    free(module->definitionSignatures);
+    free(module->references);
+    free(module);
+}
+
+void freeBuildState(BuildState *state) {
+    for (int i = 0; i < state->modules->size; i++) {
+        freeModuleState(state->modules->contents[i]);
+    }
+
+    free(state->modules->contents);
+    free(state->modules);
+    freeStringMap(state->moduleMap);
+    free(state);
+}
+
+// Defines are summed so their order in the map does not matter, and a type library counts by its contents.
+uint64_t calculateOptionsHash(const Project *project) {
+    uint64_t hash = calculateContentHash(TOOL_VERSION, strlen(TOOL_VERSION));
+    uint64_t defineHash = 0;
+
+    hash = updateContentHash(hash, (const char*)&project->codePage, sizeof(project->codePage));
+
+    for (int i = 0; project->defines != NULL && i < project->defines->capacity; i++) {
+        for (const StringIntegerMapEntry *entry = project->defines->entries[i]; entry != NULL; entry = entry->next) {
+            const uint64_t nameHash = calculateContentHash(entry->key, strlen(entry->key));
+            defineHash += updateContentHash(nameHash, (const char*)&entry->value, sizeof(entry->value));
+        }
+    }
+
+    hash = updateContentHash(hash, (const char*)&defineHash, sizeof(defineHash));
+
+    for (int i = 0; project->typeLibraries != NULL && i < project->typeLibraries->size; i++) {
+        const TypeLibrary *library = project->typeLibraries->contents[i];
+        hash = updateContentHash(hash, library->data, library->size);
+    }
+
+    return hash;
+}
+
+bool readStateValue(FILE *fp, void *value, size_t size) {
+    return (fread(value, size, 1, fp) == 1);
+}
+
+uint64_t *readStateArray(FILE *fp, int count) {
+    uint64_t *array = malloc(sizeof(uint64_t) * (count + 1));
+
+    if (fread(array, sizeof(uint64_t), count, fp) != (size_t)count) {
+        free(array);
+        return NULL;
+    }
+
+    return array;
+}
+
+BuildState *readBuildState(const char *path) {
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    uint32_t magic = 0, version = 0, count = 0;
+    uint64_t optionsHash = 0;
+
+    if (!readStateValue(fp, &magic, sizeof(magic)) || !readStateValue(fp, &version, sizeof(version)) || !readStateValue(fp, &count, sizeof(count))
+        || !readStateValue(fp, &optionsHash, sizeof(optionsHash)) || magic != BUILD_STATE_MAGIC || version != BUILD_STATE_VERSION) {
+        printf("warning: ignoring unreadable build state \"%s\".\n", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    BuildState *state = buildBuildState(count);
+    state->optionsHash = optionsHash;
+
+    for (uint32_t i = 0; i < count; i++) {
+        ModuleState *module = calloc(1, sizeof(ModuleState));
+        uint16_t pathLength = 0;
+        int64_t size = 0, modifiedTime = 0;
+        uint32_t definitionCount = 0, referenceCount = 0;
+
+        if (!readStateValue(fp, &pathLength, sizeof(pathLength))) {
+            free(module);
+            break;
+        }
+
+        module->path = calloc(pathLength + 1, sizeof(char));
+
+        if (fread(module->path, 1, pathLength, fp) != pathLength
+            || !readStateValue(fp, &size, sizeof(size))
+            || !readStateValue(fp, &modifiedTime, sizeof(modifiedTime))
+            || !readStateValue(fp, &module->contentHash, sizeof(module->contentHash))
+            || !readStateValue(fp, &definitionCount, sizeof(definitionCount))
+            || (module->definitionNames = readStateArray(fp, definitionCount)) == NULL
+            || (module->definitionSignatures = readStateArray(fp, definitionCount)) == NULL
+            || !readStateValue(fp, &referenceCount, sizeof(referenceCount))
+            || (module->references = readStateArray(fp, referenceCount)) == NULL) {
+            printf("warning: build state \"%s\" is truncated.\n", path);
+            freeModuleState(module);
+            break;
+        }
+
+        module->size = size;
+        module->modifiedTime = modifiedTime;
+        module->definitionCount = definitionCount;
+        module->referenceCount = referenceCount;
+        pushModuleState(state, module);
+    }
+
+    fclose(fp);
+    return state;
+}
+
+bool writeBuildState(const char *path, const BuildState *state) {
+    char *temporaryPath = malloc(strlen(path) + 5);
+    sprintf(temporaryPath, "%s.tmp", path);
+
+    FILE *fp = fopen(temporaryPath, "wb");
+
+    if (fp == NULL) {
+        printf("error: could not write build state \"%s\".\n", temporaryPath);
+        free(temporaryPath);
+        return false;
+    }
+
+    const uint32_t header[3] = { BUILD_STATE_MAGIC, BUILD_STATE_VERSION, state->modules->size };
+    fwrite(header, sizeof(uint32_t), 3, fp);
+    fwrite(&state->optionsHash, sizeof(state->optionsHash), 1, fp);
+
+    for (int i = 0; i < state->modules->size; i++) {
+        const ModuleState *module = state->modules->contents[i];
+        const uint16_t pathLength = strlen(module->path);
+        const int64_t size = module->size;
+        const int64_t modifiedTime = module->modifiedTime;
+        const uint32_t definitionCount = module->definitionCount;
+        const uint32_t referenceCount = module->referenceCount;
+
+        fwrite(&pathLength, sizeof(pathLength), 1, fp);
+        fwrite(module->path, 1, pathLength, fp);
+        fwrite(&size, sizeof(size), 1, fp);
+        fwrite(&modifiedTime, sizeof(modifiedTime), 1, fp);
+        fwrite(&module->contentHash, sizeof(module->contentHash), 1, fp);
+        fwrite(&definitionCount, sizeof(definitionCount), 1, fp);
+        fwrite(module->definitionNames, sizeof(uint64_t), definitionCount, fp);
+        fwrite(module->definitionSignatures, sizeof(uint64_t), definitionCount, fp);
+        fwrite(&referenceCount, sizeof(referenceCount), 1, fp);
+        fwrite(module->references, sizeof(uint64_t), referenceCount, fp);
+    }
+
+    const bool succeeded = (fclose(fp) == 0 && rename(temporaryPath, path) == 0);
+
+    if (!succeeded) {
+        printf("error: could not replace build state \"%s\".\n", path);
+    }
+
+    free(temporaryPath);
+    return succeeded;
+}
+
+int compareDefinition(const void *left, const void *right) {
+    const ScannedSymbol *a = *(ScannedSymbol *const *)left;
+    const ScannedSymbol *b = *(ScannedSymbol *const *)right;
+
+    if (a->nameHash != b->nameHash) {
+        return (a->nameHash > b->nameHash) ? 1 : -1;
+    }
+
+    return (a->signatureHash > b->signatureHash) - (a->signatureHash < b->signatureHash);
+}
+
+ModuleState *makeModuleState(const ProjectFile *file, const char *source, long length, uint64_t contentHash) {
+    ModuleScan *scan = scanModule(source, length, file->type != PROJECT_MODULE);
+    ModuleState *module = calloc(1, sizeof(ModuleState));
+    module->path = strdup(file->path);
+    module->contentHash = contentHash;
+
+    qsort(scan->symbols->contents, scan->symbols->size, sizeof(void*), compareDefinition);
+
+    module->definitionCount = scan->symbols->size;
+    module->definitionNames = malloc(sizeof(uint64_t) * (module->definitionCount + 1));
+    module->definitionSignatures = malloc(sizeof(uint64_t) * (module->definitionCount + 1));
+
+    for (int i = 0; i < scan->symbols->size; i++) {
+        const ScannedSymbol *symbol = scan->symbols->contents[i];
+        module->definitionNames[i] = symbol->nameHash;
+        module->definitionSignatures[i] = symbol->signatureHash;
+    }
+
+    module->referenceCount = scan->referenceCount;
+    module->references = malloc(sizeof(uint64_t) * (scan->referenceCount + 1));
+    memcpy(module->references, scan->references, sizeof(uint64_t) * scan->referenceCount);
+
+    freeModuleScan(scan);
+    return module;
+}
+
+uint64_t *copyStateArray(const uint64_t *source, int count) {
+    uint64_t *array = malloc(sizeof(uint64_t) * (count + 1));
+    memcpy(array, source, sizeof(uint64_t) * count);
+
+    return array;
+}
+
+// a deep copy, so the previous state can be freed once the plan is made
+ModuleState *copyModuleState(const ModuleState *source) {
+    ModuleState *module = malloc(sizeof(ModuleState));
+    *module = *source;
+    module->path = strdup(source->path);
+    module->definitionNames = copyStateArray(source->definitionNames, source->definitionCount);
+    module->definitionSignatures = copyStateArray(source->definitionSignatures, source->definitionCount);
+    module->references = copyStateArray(source->references, source->referenceCount);
+
+    return module;
+}
+
+// Names whose (name, signature) pairs differ between two sorted definition lists.
+void collectChangedDefinitions(const ModuleState *before, const ModuleState *after, ModuleCheck *check) {
+    const int beforeCount = (before != NULL) ? before->definitionCount : 0;
+    const int afterCount = (after != NULL) ? after->definitionCount : 0;
+    int i = 0, j = 0;
+
+    check->changed = malloc(sizeof(uint64_t) * (beforeCount + afterCount + 1));
+    check->changedCount = 0;
+
+    while (i < beforeCount || j < afterCount) {
+        if (j >= afterCount || (i < beforeCount && before->definitionNames[i] < after->definitionNames[j])) {
+            check->changed[check->changedCount++] = before->definitionNames[i++];
+        }
+        else if (i >= beforeCount || after->definitionNames[j] < before->definitionNames[i]) {
+            check->changed[check->changedCount++] = after->definitionNames[j++];
+        }
+        else {
+            if (before->definitionSignatures[i] != after->definitionSignatures[j]) {
+                check->changed[check->changedCount++] = after->definitionNames[j];
+            }
+
+            i++;
+            j++;
+        }
+    }
+}
+
+// a module whose source is unchanged still has to be emitted again if its output has gone
+bool isOutputMissing(const ProjectFile *file) {
+    char *outputPath = getOutputPath(file);
+    const bool isMissing = (outputPath != NULL && access(outputPath, F_OK) != 0);
+
+    free(outputPath);
+    return isMissing;
+}
+
+void checkModule(void *argument) {
+    ModuleCheck *check = argument;
+    const ProjectFile *file = check->file;
+    const ModuleState *previous = NULL;
+    struct stat st;
+
+    if (check->previous != NULL) {
+        previous = getStringMap(check->previous->moduleMap, file->path);
+    }
+
+    if (stat(file->path, &st) != 0) {
+        check->status = MODULE_DIRTY;
+        return;
+    }
+
+    const long modifiedTime = st.st_mtim.tv_sec * 1000000000L + st.st_mtim.tv_nsec;
+
+    if (previous != NULL && previous->contentHash != 0 && previous->size == st.st_size && previous->modifiedTime == modifiedTime) {
+        check->module = copyModuleState(previous);
+        check->status = isOutputMissing(file) ? MODULE_DIRTY : MODULE_CLEAN;
+        return;
+    }
+
+    char *source = readFile(file->path);
+
+    if (source == NULL) {
+        check->status = MODULE_DIRTY;
+        return;
+    }
+
+    const uint64_t contentHash = calculateContentHash(source, st.st_size);
+
+    if (previous != NULL && previous->contentHash == contentHash) {
+        check->module = copyModuleState(previous);
+        check->status = isOutputMissing(file) ? MODULE_DIRTY : MODULE_CLEAN;
+    }
+    else {
+        check->module = makeModuleState(file, source, st.st_size, contentHash);
+        check->status = MODULE_DIRTY;
+        collectChangedDefinitions(previous, check->module, check);
+    }
+
+    check->module->size = st.st_size;
+    check->module->modifiedTime = modifiedTime;
+    free(source);
+}
+
+int compareNameHash(const void *left, const void *right) {
+    const uint64_t a = *(const uint64_t*)left;
+    const uint64_t b = *(const uint64_t*)right;
+
+    return (a > b) - (a < b);
+}
+
+bool referencesChangedName(const ModuleState *module, const uint64_t *changed, int changedCount) {
+    int i = 0, j = 0;
+
+    while (i < module->referenceCount && j < changedCount) {
+        if (module->references[i] == changed[j]) {
+            return true;
+        }
+        else if (module->references[i] < changed[j]) {
+            i++;
+        }
+        else {
+            j++;
+        }
+    }
+
+    return false;
+}
+
+RebuildPlan *planRebuild(const Project *project, const BuildState *previous, ThreadPool *pool) {
+    const int count = project->files->size;
+    const uint64_t optionsHash = calculateOptionsHash(project);
+
+    // every module's output may differ under other options, so nothing from the previous build carries over
+    if (previous != NULL && previous->optionsHash != optionsHash) {
+        previous = NULL;
+    }
+
+    ModuleCheck *checks = calloc(count, sizeof(ModuleCheck));
+
+    for (int i = 0; i < count; i++) {
+        checks[i].file = getProjectFile(project, i);
+        checks[i].previous = previous;
+        submitThreadPool(pool, checkModule, &checks[i]);
+    }
+
+    waitThreadPool(pool);
+
+    RebuildPlan *plan = calloc(1, sizeof(RebuildPlan));
+    plan->fileCount = count;
+    plan->optionsHash = optionsHash;
+    plan->status = calloc(count, sizeof(int));
+    plan->selection = calloc(count, sizeof(bool));
+    plan->modules = calloc(count, sizeof(ModuleState*));
+
+    Vector *changed = buildVectorList();
+    int changedCount = 0;
+    StringMap *present = buildStringMap(count * 2 + 1);
+
+    for (int i = 0; i < count; i++) {
+        plan->status[i] = checks[i].status;
+        plan->modules[i] = checks[i].module;
+        appendStringMap(present, checks[i].file->path, &checks[i]);
+
+        if (checks[i].changedCount > 0) {
+            pushVector(changed, &checks[i]);
+            changedCount += checks[i].changedCount;
+        }
+    }
+
+    // modules dropped from the project take their definitions with them
+    if (previous != NULL) {
+        for (int i = 0; i < previous->modules->size; i++) {
+            const ModuleState *module = previous->modules->contents[i];
+
+            if (!stringMapContains(present, module->path)) {
+                ModuleCheck *check = calloc(1, sizeof(ModuleCheck));
+                collectChangedDefinitions(module, NULL, check);
+                pushVector(changed, check);
+                changedCount += check->changedCount;
+            }
+        }
+    }
+
+    uint64_t *changedNames = malloc(sizeof(uint64_t) * (changedCount + 1));
+    changedCount = 0;
+
+    for (int i = 0; i < changed->size; i++) {
+        const ModuleCheck *check = changed->contents[i];
+        memcpy(&changedNames[changedCount], check->changed, sizeof(uint64_t) * check->changedCount);
+        changedCount += check->changedCount;
+    }
+
+    qsort(changedNames, changedCount, sizeof(uint64_t), compareNameHash);
+
+    // a dropped module's check has no file and was allocated on its own
+    for (int i = 0; i < changed->size; i++) {
+        ModuleCheck *check = changed->contents[i];
+
+        if (check->file == NULL) {
+            free(check->changed);
+            free(check);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(checks[i].changed);
+    }
+
+    free(changed->contents);
+    free(changed);
+    freeStringMap(present);
+
+    for (int i = 0; i < count; i++) {
+        if (plan->status[i] == MODULE_CLEAN && referencesChangedName(plan->modules[i], changedNames, changedCount)) {
+            plan->status[i] = MODULE_DEPENDENT;
+        }
+
+        if (plan->status[i] == MODULE_DIRTY) {
+            plan->dirtyCount++;
+        }
+        else if (plan->status[i] == MODULE_DEPENDENT) {
+            plan->dependentCount++;
+        }
+
+        plan->selection[i] = (plan->status[i] != MODULE_CLEAN);
+    }
+
+    free(changedNames);
+    free(checks);
+    return plan;
+}
+
+// the plan's module states move into the new state
+BuildState *makeNextBuildState(RebuildPlan *plan, const bool *succeeded) {
+    BuildState *state = buildBuildState(plan->fileCount);
+    state->optionsHash = plan->optionsHash;
+
+    for (int i = 0; i < plan->fileCount; i++) {
+        ModuleState *module = plan->modules[i];
+
+        if (module == NULL) {
+            continue;
+        }
+
+        plan->modules[i] = NULL;
+
+        // a failed module is recorded with no content hash so the next run retries it
+        if (plan->selection[i] && !succeeded[i]) {
+            module->contentHash = 0;
+        }
+
+        pushModuleState(state, module);
+    }
+
+    return state;
+}
+
+// module states makeNextBuildState did not take go with the plan
+void freeRebuildPlan(RebuildPlan *plan) {
+    for (int i = 0; i < plan->fileCount; i++) {
+        if (plan->modules[i] != NULL) {
+            freeModuleState(plan->modules[i]);
+        }
+    }
+
+    free(plan->status);
+    free(plan->selection);
+    free(plan->modules);
+    free(plan);
+}
+
+char *getDefaultStatePath(const Project *project) {
+    char *path = malloc(strlen(project->directory) + strlen(project->name) + 16);
+    sprintf(path, "%s/.%s.vbtstate", project->directory, project->name);
+
+    return path;
+}
\ No newline at end of file
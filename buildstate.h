@@ -0,0 +1,49 @@
+#pragma once
+
+#include "project.h"
+#include "threadpool.h"
+
+enum ModuleStatus {
+    MODULE_CLEAN,
+    MODULE_DIRTY,
+    MODULE_DEPENDENT
+};
+
+typedef struct ModuleState {
+    char *path;
+    long size;
+    long modifiedTime;
+    uint64_t contentHash;
+    int definitionCount;
+    uint64_t *definitionNames;
+    uint64_t *definitionSignatures;
+    int referenceCount;
+    uint64_t *references;
+} ModuleState;
+
+// optionsHash covers what changes every module's output: -D defines, code page, type libraries and vbt itself
+typedef struct BuildState {
+    uint64_t optionsHash;
+    Vector *modules;
+    StringMap *moduleMap;
+} BuildState;
+
+typedef struct RebuildPlan {
+    int fileCount;
+    int dirtyCount;
+    int dependentCount;
+    uint64_t optionsHash;
+    int *status;
+    bool *selection;
+    ModuleState **modules;
+} RebuildPlan;
+
+BuildState *buildBuildState(int capacity);
+void freeBuildState(BuildState *state);
+uint64_t calculateOptionsHash(const Project *project);
+BuildState *readBuildState(const char *path);
+bool writeBuildState(const char *path, const BuildState *state);
+RebuildPlan *planRebuild(const Project *project, const BuildState *previous, ThreadPool *pool);
+BuildState *makeNextBuildState(RebuildPlan *plan, const bool *succeeded);
+void freeRebuildPlan(RebuildPlan *plan);
+char *getDefaultStatePath(const Project *project);
\ No newline at end of file
@@ -0,0 +1,1130 @@
+#include "cfg.h"
+
+#define CFG_ARENA_BLOCK_SIZE 16384
+
+// innermost Exit/break target; kind is an IterationType, or -1 for Select Case
+typedef struct CfgTarget {
+    int kind;
+    bool isWend;
+    int breakBlock;
+    int continueBlock;
+} CfgTarget;
+
+// a statement's instructions, nested ones included, and the block it starts in for one that has none
+typedef struct CfgStatementSpan {
+    const StatementNode *node;
+    int entryBlock;
+    int firstInstruction;
+    int endInstruction;
+} CfgStatementSpan;
+
+// a GoTo, GoSub or error handler naming a label that may not have been seen yet
+typedef struct CfgPendingJump {
+    int block;
+    const char *label;
+    int kind;
+} CfgPendingJump;
+
+typedef struct CfgBuilder {
+    CfgBlock *blocks;
+    int blockCount;
+    int blockCapacity;
+    CfgEdge *edges;
+    int edgeCount;
+    int edgeCapacity;
+    CfgInstruction *instructions;
+    int instructionCount;
+    int instructionCapacity;
+    CfgReference *references;
+    int referenceCount;
+    int referenceCapacity;
+    CfgVariable *variables;
+    int variableCount;
+    int variableCapacity;
+    CfgStatementSpan *statements;
+    int statementCount;
+    int statementCapacity;
+    CfgPendingJump *jumps;
+    int jumpCount;
+    int jumpCapacity;
+    CfgTarget *targets;
+    int targetCount;
+    int targetCapacity;
+    StringIntegerMap *variableIds;
+    StringIntegerMap *labels;
+    IntegerStack *gosubContinuations;
+    IntegerStack *gosubReturns;
+    IntegerStack *resumes;
+    int current;
+    int instruction;
+    const char *handlerLabel;
+} CfgBuilder;
+
+void buildCfgStatement(CfgBuilder *builder, const StatementNode *statementNode);
+void collectCfgExpression(CfgBuilder *builder, const ExpressionNode *expressionNode);
+void collectCfgAssignment(CfgBuilder *builder, const AssignmentExpressionNode *assignmentExpressionNode);
+void collectCfgConditional(CfgBuilder *builder, const ConditionalExpressionNode *conditionalExpressionNode);
+void collectCfgCast(CfgBuilder *builder, const CastExpressionNode *castExpressionNode);
+
+void *reserveCfgArray(void *array, int count, int *capacity, size_t elementSize) {
+    if (count < *capacity) {
+        return array;
+    }
+
+    *capacity = (*capacity > 0) ? *capacity * 2 : 16;
+    return realloc(array, elementSize * *capacity);
+}
+
+// VB names are case-insensitive, so variables and labels are keyed by their lower-case spelling
+void lowerCfgName(const char *name, char *key, int size) {
+    int i = 0;
+
+    for (; name[i] != '\0' && i < size - 1; i++) {
+        key[i] = tolower((unsigned char)name[i]);
+    }
+
+    key[i] = '\0';
+}
+
+int lookupCfgName(StringIntegerMap *map, const char *name) {
+    char key[256];
+
+    if (name == NULL) {
+        return -1;
+    }
+
+    lowerCfgName(name, key, sizeof(key));
+    return stringIntegerMapContains(map, key) ? getIntegerMap(map, key) : -1;
+}
+
+void addCfgVariable(CfgBuilder *builder, const char *name, int kind, const DeclarationNode *declarationNode) {
+    char key[256];
+
+    if (name == NULL || lookupCfgName(builder->variableIds, name) >= 0) {
+        return;
+    }
+
+    lowerCfgName(name, key, sizeof(key));
+    appendStringIntegerMap(builder->variableIds, key, builder->variableCount);
+
+    builder->variables = reserveCfgArray(builder->variables, builder->variableCount, &builder->variableCapacity, sizeof(CfgVariable));
+    builder->variables[builder->variableCount++] = (CfgVariable){ name, kind, declarationNode };
+}
+
+// Dim is procedure-wide in VB whatever block it appears in, so every local is known before the first use.
+void collectCfgLocals(CfgBuilder *builder, const StatementNode *statementNode);
+
+void collectCfgDeclaration(CfgBuilder *builder, const DeclarationNode *declarationNode) {
+    for (int i = 0; declarationNode->initializeDeclaratorNodes != NULL && i < declarationNode->initializeDeclaratorNodes->size; i++) {
+        const InitializeDeclaratorNode *initializeDeclaratorNode = declarationNode->initializeDeclaratorNodes->contents[i];
+
+        if (initializeDeclaratorNode->declaratorNode != NULL) {
+            addCfgVariable(builder, getDeclaratorName(initializeDeclaratorNode->declaratorNode), VARIABLE_LOCAL, declarationNode);
+        }
+    }
+}
+
+void collectCfgCompoundLocals(CfgBuilder *builder, const CompoundStatementNode *compoundStatementNode) {
+    for (int i = 0; compoundStatementNode->blockItemNodes != NULL && i < compoundStatementNode->blockItemNodes->size; i++) {
+        const BlockItemNode *blockItemNode = compoundStatementNode->blockItemNodes->contents[i];
+
+        if (blockItemNode->declarationNode != NULL) {
+            collectCfgDeclaration(builder, blockItemNode->declarationNode);
+        }
+        else if (blockItemNode->statementNode != NULL) {
+            collectCfgLocals(builder, blockItemNode->statementNode);
+        }
+    }
+}
+
+void collectCfgLocals(CfgBuilder *builder, const StatementNode *statementNode) {
+    if (statementNode == NULL) {
+        return;
+    }
+
+    if (statementNode->compoundStatementNode != NULL) {
+        collectCfgCompoundLocals(builder, statementNode->compoundStatementNode);
+    }
+    else if (statementNode->selectionStatementNode != NULL) {
+        collectCfgLocals(builder, statementNode->selectionStatementNode->statementNode1);
+        collectCfgLocals(builder, statementNode->selectionStatementNode->statementNode2);
+    }
+    else if (statementNode->iterationStatementNode != NULL) {
+        const IterationStatementNode *iterationStatementNode = statementNode->iterationStatementNode;
+
+        for (int i = 0; iterationStatementNode->declarationNodes != NULL && i < iterationStatementNode->declarationNodes->size; i++) {
+            collectCfgDeclaration(builder, iterationStatementNode->declarationNodes->contents[i]);
+        }
+
+        collectCfgLocals(builder, iterationStatementNode->statementNode);
+    }
+    else if (statementNode->labeledStatementNode != NULL) {
+        collectCfgLocals(builder, statementNode->labeledStatementNode->statementNode);
+    }
+}
+
+int addCfgBlock(CfgBuilder *builder) {
+    builder->blocks = reserveCfgArray(builder->blocks, builder->blockCount, &builder->blockCapacity, sizeof(CfgBlock));
+
+    CfgBlock *block = &builder->blocks[builder->blockCount];
+    memset(block, 0, sizeof(CfgBlock));
+    block->firstInstruction = builder->instructionCount;
+    block->handler = -1;
+    block->order = -1;
+
+    if (builder->handlerLabel != NULL) {
+        builder->jumps = reserveCfgArray(builder->jumps, builder->jumpCount, &builder->jumpCapacity, sizeof(CfgPendingJump));
+        builder->jumps[builder->jumpCount++] = (CfgPendingJump){ builder->blockCount, builder->handlerLabel, EDGE_EXCEPTION };
+    }
+
+    return builder->blockCount++;
+}
+
+void addCfgEdge(CfgBuilder *builder, int from, int to, int kind) {
+    builder->edges = reserveCfgArray(builder->edges, builder->edgeCount, &builder->edgeCapacity, sizeof(CfgEdge));
+    builder->edges[builder->edgeCount++] = (CfgEdge){ from, to, kind, -1 };
+}
+
+void addCfgJump(CfgBuilder *builder, const char *label, int kind) {
+    builder->jumps = reserveCfgArray(builder->jumps, builder->jumpCount, &builder->jumpCapacity, sizeof(CfgPendingJump));
+    builder->jumps[builder->jumpCount++] = (CfgPendingJump){ builder->current, label, kind };
+}
+
+// Instructions only ever go to the current block, and a block is never resumed once left, so each block's
+// instructions are contiguous.
+void addCfgInstruction(CfgBuilder *builder, int kind, const void *node) {
+    builder->instructions = reserveCfgArray(builder->instructions, builder->instructionCount, &builder->instructionCapacity, sizeof(CfgInstruction));
+    builder->instructions[builder->instructionCount] = (CfgInstruction){ kind, builder->current, node, builder->referenceCount, 0 };
+
+    // blocks are often created before they become current, so a block starts at its first instruction
+    if (builder->blocks[builder->current].instructionCount == 0) {
+        builder->blocks[builder->current].firstInstruction = builder->instructionCount;
+    }
+
+    builder->instruction = builder->instructionCount++;
+    builder->blocks[builder->current].instructionCount++;
+}
+
+void addCfgReference(CfgBuilder *builder, int variable, bool isDefinition, int operatorType, const void *node) {
+    if (variable < 0) {
+        return;
+    }
+
+    builder->references = reserveCfgArray(builder->references, builder->referenceCount, &builder->referenceCapacity, sizeof(CfgReference));
+    builder->references[builder->referenceCount++] = (CfgReference){ builder->instruction, variable, -1, isDefinition, operatorType, node };
+    builder->instructions[builder->instruction].referenceCount++;
+}
+
+// Ends the current block after a jump; what follows is unreachable unless a label makes it a target.
+void startCfgBlock(CfgBuilder *builder) {
+    builder->current = addCfgBlock(builder);
+}
+
+// Falls through from the current block into a fresh one.
+void continueCfgBlock(CfgBuilder *builder, int block) {
+    addCfgEdge(builder, builder->current, block, EDGE_FALLTHROUGH);
+    builder->current = block;
+}
+
+void pushCfgTarget(CfgBuilder *builder, int kind, bool isWend, int breakBlock, int continueBlock) {
+    builder->targets = reserveCfgArray(builder->targets, builder->targetCount, &builder->targetCapacity, sizeof(CfgTarget));
+    builder->targets[builder->targetCount++] = (CfgTarget){ kind, isWend, breakBlock, continueBlock };
+}
+
+// Innermost target of the given kind; -2 matches any loop.
+const CfgTarget *findCfgTarget(const CfgBuilder *builder, int kind) {
+    for (int i = builder->targetCount - 1; i >= 0; i--) {
+        const CfgTarget *target = &builder->targets[i];
+        const bool isLoop = (target->kind >= 0);
+
+        if (target->kind == kind || (kind == -2 && isLoop)) {
+            return target;
+        }
+
+        // Exit Do leaves the innermost Do, and VB's Do and While loops both become ITERATION_WHILE or ITERATION_DO
+        if (kind == ITERATION_DO && target->kind == ITERATION_WHILE && !target->isWend) {
+            return target;
+        }
+    }
+
+    return NULL;
+}
+
+// the variable an assignment writes as a whole, or -1 for element, member and non-local targets
+int getAssignedCfgVariable(CfgBuilder *builder, const UnaryExpressionNode *unaryExpressionNode) {
+    if (unaryExpressionNode == NULL || unaryExpressionNode->type != UNARY_NONE || unaryExpressionNode->postfixExpressionNode == NULL) {
+        return -1;
+    }
+
+    const PostfixExpressionNode *postfixExpressionNode = unaryExpressionNode->postfixExpressionNode;
+
+    if (postfixExpressionNode->postfixExpressionType != POSTFIX_PRIMARY || postfixExpressionNode->primaryExpressionNode == NULL) {
+        return -1;
+    }
+
+    return lookupCfgName(builder->variableIds, postfixExpressionNode->primaryExpressionNode->identifier);
+}
+
+void collectCfgPrimary(CfgBuilder *builder, const PrimaryExpressionNode *primaryExpressionNode) {
+    if (primaryExpressionNode->identifier != NULL) {
+        addCfgReference(builder, lookupCfgName(builder->variableIds, primaryExpressionNode->identifier), false, OPERATOR_NONE, primaryExpressionNode);
+    }
+    else if (primaryExpressionNode->expressionNode != NULL) {
+        collectCfgExpression(builder, primaryExpressionNode->expressionNode);
+    }
+}
+
+void collectCfgPostfix(CfgBuilder *builder, const PostfixExpressionNode *postfixExpressionNode) {
+    if (postfixExpressionNode->postfixExpressionType == POSTFIX_PRIMARY || postfixExpressionNode->postfixExpressionNode == NULL) {
+        if (postfixExpressionNode->primaryExpressionNode != NULL) {
+            collectCfgPrimary(builder, postfixExpressionNode->primaryExpressionNode);
+        }
+
+        return;
+    }
+
+    collectCfgPostfix(builder, postfixExpressionNode->postfixExpressionNode);
+
+    if (postfixExpressionNode->expressionNode != NULL) {
+        collectCfgExpression(builder, postfixExpressionNode->expressionNode);
+    }
+
+    for (int i = 0; postfixExpressionNode->assignExpressionNodes != NULL && i < postfixExpressionNode->assignExpressionNodes->size; i++) {
+        collectCfgAssignment(builder, postfixExpressionNode->assignExpressionNodes->contents[i]);
+    }
+
+    const int type = postfixExpressionNode->postfixExpressionType;
+    const PostfixExpressionNode *base = postfixExpressionNode->postfixExpressionNode;
+
+    if ((type == POSTFIX_INCREMENT || type == POSTFIX_DECREMENT) && base->postfixExpressionType == POSTFIX_PRIMARY && base->primaryExpressionNode != NULL) {
+        addCfgReference(builder, lookupCfgName(builder->variableIds, base->primaryExpressionNode->identifier), true, (type == POSTFIX_INCREMENT) ? OPERATOR_ADD_EQUAL : OPERATOR_SUBTRACT_EQUAL, NULL);
+    }
+}
+
+void collectCfgUnary(CfgBuilder *builder, const UnaryExpressionNode *unaryExpressionNode) {
+    switch (unaryExpressionNode->type) {
+        case UNARY_INCREMENT:
+        case UNARY_DECREMENT: {
+            collectCfgUnary(builder, unaryExpressionNode->unaryExpressionNode);
+            addCfgReference(builder, getAssignedCfgVariable(builder, unaryExpressionNode->unaryExpressionNode), true, (unaryExpressionNode->type == UNARY_INCREMENT) ? OPERATOR_ADD_EQUAL : OPERATOR_SUBTRACT_EQUAL, NULL);
+            break;
+        }
+        case UNARY_OPERATOR: {
+            collectCfgCast(builder, unaryExpressionNode->castExpressionNode);
+            break;
+        }
+        case UNARY_SIZE_IDENTIFIER:
+        case UNARY_SIZE_TYPE:
+        case UNARY_NEW: {
+            break;
+        }
+        default: {
+            if (unaryExpressionNode->postfixExpressionNode != NULL) {
+                collectCfgPostfix(builder, unaryExpressionNode->postfixExpressionNode);
+            }
+
+            break;
+        }
+    }
+}
+
+void collectCfgCast(CfgBuilder *builder, const CastExpressionNode *castExpressionNode) {
+    if (castExpressionNode->typeNameNode != NULL && castExpressionNode->castExpressionNode != NULL) {
+        collectCfgCast(builder, castExpressionNode->castExpressionNode);
+    }
+    else if (castExpressionNode->unaryExpressionNode != NULL) {
+        collectCfgUnary(builder, castExpressionNode->unaryExpressionNode);
+    }
+}
+
+// The binary levels below all evaluate left operand, then right; only the node types differ.
+void collectCfgMultiplication(CfgBuilder *builder, const MultiplicationExpressionNode *node) {
+    if (node->multiplicationExpressionNode != NULL) {
+        collectCfgMultiplication(builder, node->multiplicationExpressionNode);
+    }
+
+    collectCfgCast(builder, node->castExpressionNode);
+}
+
+void collectCfgAddition(CfgBuilder *builder, const AdditionExpressionNode *node) {
+    if (node->additionExpressionNode != NULL) {
+        collectCfgAddition(builder, node->additionExpressionNode);
+    }
+
+    collectCfgMultiplication(builder, node->multiplicationExpressionNode);
+}
+
+void collectCfgShift(CfgBuilder *builder, const ShiftExpressionNode *node) {
+    if (node->shiftExpressionNode != NULL) {
+        collectCfgShift(builder, node->shiftExpressionNode);
+    }
+
+    collectCfgAddition(builder, node->additionExpressionNode);
+}
+
+void collectCfgRelational(CfgBuilder *builder, const RelationalExpressionNode *node) {
+    if (node->relationalExpressionNode != NULL) {
+        collectCfgRelational(builder, node->relationalExpressionNode);
+    }
+
+    collectCfgShift(builder, node->shiftExpressionNode);
+}
+
+void collectCfgEqual(CfgBuilder *builder, const EqualExpressionNode *node) {
+    if (node->equalExpressionNode != NULL) {
+        collectCfgEqual(builder, node->equalExpressionNode);
+    }
+
+    collectCfgRelational(builder, node->relationalExpressionNode);
+}
+
+void collectCfgAnd(CfgBuilder *builder, const AndExpressionNode *node) {
+    if (node->andExpressionNode != NULL) {
+        collectCfgAnd(builder, node->andExpressionNode);
+    }
+
+    collectCfgEqual(builder, node->equalExpressionNode);
+}
+
+void collectCfgExclusiveOr(CfgBuilder *builder, const ExclusiveOrExpressionNode *node) {
+    if (node->exclusiveOrExpressionNode != NULL) {
+        collectCfgExclusiveOr(builder, node->exclusiveOrExpressionNode);
+    }
+
+    collectCfgAnd(builder, node->andExpressionNode);
+}
+
+void collectCfgInclusiveOr(CfgBuilder *builder, const InclusiveOrExpressionNode *node) {
+    if (node->inclusiveOrExpressionNode != NULL) {
+        collectCfgInclusiveOr(builder, node->inclusiveOrExpressionNode);
+    }
+
+    collectCfgExclusiveOr(builder, node->exclusiveOrExpressionNode);
+}
+
+void collectCfgLogicalAnd(CfgBuilder *builder, const LogicalAndExpressionNode *node) {
+    if (node->logicalAndExpressionNode != NULL) {
+        collectCfgLogicalAnd(builder, node->logicalAndExpressionNode);
+    }
+
+    collectCfgInclusiveOr(builder, node->inclusiveOrExpressionNode);
+}
+
+void collectCfgOr(CfgBuilder *builder, const OrExpressionNode *node) {
+    if (node->orExpressionNode != NULL) {
+        collectCfgOr(builder, node->orExpressionNode);
+    }
+
+    collectCfgLogicalAnd(builder, node->logicalAndExpressionNode);
+}
+
+void collectCfgConditional(CfgBuilder *builder, const ConditionalExpressionNode *conditionalExpressionNode) {
+    collectCfgOr(builder, conditionalExpressionNode->orExpressionNode);
+
+    if (conditionalExpressionNode->expressionNode != NULL && conditionalExpressionNode->conditionalExpressionNode != NULL) {
+        collectCfgExpression(builder, conditionalExpressionNode->expressionNode);
+        collectCfgConditional(builder, conditionalExpressionNode->conditionalExpressionNode);
+    }
+}
+
+// A whole-variable store is a definition; a compound one reads the variable first, and an element or member
+// store only reads the variables in its target.
+void collectCfgAssignment(CfgBuilder *builder, const AssignmentExpressionNode *assignmentExpressionNode) {
+    if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL) {
+        const int variable = getAssignedCfgVariable(builder, assignmentExpressionNode->unaryExpressionNode);
+
+        if (variable < 0 || assignmentExpressionNode->assignOperator != OPERATOR_ASSIGN) {
+            collectCfgUnary(builder, assignmentExpressionNode->unaryExpressionNode);
+        }
+
+        collectCfgAssignment(builder, assignmentExpressionNode->assignExpressionNode);
+        addCfgReference(builder, variable, true, assignmentExpressionNode->assignOperator, assignmentExpressionNode->assignExpressionNode);
+    }
+    else if (assignmentExpressionNode->conditionalExpressionNode != NULL) {
+        collectCfgConditional(builder, assignmentExpressionNode->conditionalExpressionNode);
+    }
+}
+
+void collectCfgExpression(CfgBuilder *builder, const ExpressionNode *expressionNode) {
+    if (expressionNode == NULL) {
+        return;
+    }
+
+    if (expressionNode->expressionNode != NULL) {
+        collectCfgExpression(builder, expressionNode->expressionNode);
+    }
+
+    collectCfgAssignment(builder, expressionNode->assignExpressionNode);
+}
+
+void collectCfgInitializer(CfgBuilder *builder, const InitializerNode *initializerNode) {
+    if (initializerNode->assignmentExpressionNode != NULL) {
+        collectCfgAssignment(builder, initializerNode->assignmentExpressionNode);
+        return;
+    }
+
+    for (int i = 0; initializerNode->initializerListNode != NULL && i < initializerNode->initializerListNode->initializerNodes->size; i++) {
+        collectCfgInitializer(builder, initializerNode->initializerListNode->initializerNodes->contents[i]);
+    }
+}
+
+void addCfgExpression(CfgBuilder *builder, int kind, const ExpressionNode *expressionNode) {
+    addCfgInstruction(builder, kind, expressionNode);
+    collectCfgExpression(builder, expressionNode);
+}
+
+void buildCfgDeclaration(CfgBuilder *builder, const DeclarationNode *declarationNode) {
+    for (int i = 0; declarationNode->initializeDeclaratorNodes != NULL && i < declarationNode->initializeDeclaratorNodes->size; i++) {
+        const InitializeDeclaratorNode *initializeDeclaratorNode = declarationNode->initializeDeclaratorNodes->contents[i];
+
+        addCfgInstruction(builder, CFG_DECLARATION, initializeDeclaratorNode);
+
+        if (initializeDeclaratorNode->initializerNode != NULL) {
+            collectCfgInitializer(builder, initializeDeclaratorNode->initializerNode);
+        }
+
+        if (initializeDeclaratorNode->declaratorNode != NULL) {
+            const InitializerNode *initializerNode = initializeDeclaratorNode->initializerNode;
+            const int variable = lookupCfgName(builder->variableIds, getDeclaratorName(initializeDeclaratorNode->declaratorNode));
+
+            addCfgReference(builder, variable, true, (initializerNode != NULL) ? OPERATOR_ASSIGN : OPERATOR_NONE, (initializerNode != NULL) ? initializerNode->assignmentExpressionNode : NULL);
+        }
+    }
+}
+
+void buildCfgBlockItems(CfgBuilder *builder, const CompoundStatementNode *compoundStatementNode) {
+    for (int i = 0; compoundStatementNode->blockItemNodes != NULL && i < compoundStatementNode->blockItemNodes->size; i++) {
+        const BlockItemNode *blockItemNode = compoundStatementNode->blockItemNodes->contents[i];
+
+        if (blockItemNode->declarationNode != NULL) {
+            buildCfgDeclaration(builder, blockItemNode->declarationNode);
+        }
+        else if (blockItemNode->statementNode != NULL) {
+            buildCfgStatement(builder, blockItemNode->statementNode);
+        }
+    }
+}
+
+void buildCfgIf(CfgBuilder *builder, const SelectionStatementNode *selectionStatementNode) {
+    addCfgExpression(builder, CFG_BRANCH, selectionStatementNode->expressionNode);
+
+    const int branch = builder->current;
+    const int thenBlock = addCfgBlock(builder);
+    const bool hasElse = (selectionStatementNode->selectionType == SELECTION_IF_ELSE && selectionStatementNode->statementNode2 != NULL);
+    const int elseBlock = hasElse ? addCfgBlock(builder) : -1;
+    const int join = addCfgBlock(builder);
+
+    addCfgEdge(builder, branch, thenBlock, EDGE_TRUE);
+    addCfgEdge(builder, branch, hasElse ? elseBlock : join, EDGE_FALSE);
+
+    builder->current = thenBlock;
+    buildCfgStatement(builder, selectionStatementNode->statementNode1);
+    addCfgEdge(builder, builder->current, join, EDGE_FALLTHROUGH);
+
+    if (hasElse) {
+        builder->current = elseBlock;
+        buildCfgStatement(builder, selectionStatementNode->statementNode2);
+        addCfgEdge(builder, builder->current, join, EDGE_FALLTHROUGH);
+    }
+
+    builder->current = join;
+}
+
+// Select Case: the dispatch block evaluates the selector and every Case test in order, with an edge to each
+// case body; a body ends at the next Case and leaves the Select, since VB cases never fall through.
+void buildCfgSelect(CfgBuilder *builder, const SelectionStatementNode *selectionStatementNode) {
+    const StatementNode *body = selectionStatementNode->statementNode1;
+    const Vector *items = (body != NULL && body->compoundStatementNode != NULL) ? body->compoundStatementNode->blockItemNodes : NULL;
+    const int itemCount = (items != NULL) ? items->size : 0;
+    int *caseBlocks = calloc(itemCount + 1, sizeof(int));
+    bool hasDefault = false;
+
+    addCfgExpression(builder, CFG_SWITCH, selectionStatementNode->expressionNode);
+
+    const int dispatch = builder->current;
+    const int exit = addCfgBlock(builder);
+
+    for (int i = 0; i < itemCount; i++) {
+        const BlockItemNode *blockItemNode = items->contents[i];
+        const LabelStatementNode *label = (blockItemNode->statementNode != NULL) ? blockItemNode->statementNode->labeledStatementNode : NULL;
+
+        caseBlocks[i] = -1;
+
+        if (label == NULL || label->labeledStatementType == LABEL_NAMED) {
+            continue;
+        }
+
+        // "Case 1, 2" nests one case label in the other, and all of them lead to the same body
+        for (const LabelStatementNode *value = label; value != NULL && value->labeledStatementType != LABEL_NAMED; value = (value->statementNode != NULL) ? value->statementNode->labeledStatementNode : NULL) {
+            addCfgInstruction(builder, CFG_CASE, value->conditionalExpressionNode);
+
+            if (value->conditionalExpressionNode != NULL) {
+                collectCfgConditional(builder, value->conditionalExpressionNode);
+            }
+
+            hasDefault = hasDefault || (value->labeledStatementType == LABEL_DEFAULT);
+        }
+
+        caseBlocks[i] = addCfgBlock(builder);
+        addCfgEdge(builder, dispatch, caseBlocks[i], EDGE_CASE);
+    }
+
+    if (!hasDefault) {
+        addCfgEdge(builder, dispatch, exit, EDGE_FALSE);
+    }
+
+    pushCfgTarget(builder, -1, false, exit, -1);
+    startCfgBlock(builder);
+
+    for (int i = 0; i < itemCount; i++) {
+        const BlockItemNode *blockItemNode = items->contents[i];
+
+        if (caseBlocks[i] >= 0) {
+            addCfgEdge(builder, builder->current, exit, EDGE_FALLTHROUGH);
+            const LabelStatementNode *label = blockItemNode->statementNode->labeledStatementNode;
+
+            while (label->statementNode != NULL && label->statementNode->labeledStatementNode != NULL && label->statementNode->labeledStatementNode->labeledStatementType != LABEL_NAMED) {
+                label = label->statementNode->labeledStatementNode;
+            }
+
+            builder->current = caseBlocks[i];
+            buildCfgStatement(builder, label->statementNode);
+        }
+        else if (blockItemNode->declarationNode != NULL) {
+            buildCfgDeclaration(builder, blockItemNode->declarationNode);
+        }
+        else if (blockItemNode->statementNode != NULL) {
+            buildCfgStatement(builder, blockItemNode->statementNode);
+        }
+    }
+
+    addCfgEdge(builder, builder->current, exit, EDGE_FALLTHROUGH);
+    builder->targetCount--;
+    builder->current = exit;
+    free(caseBlocks);
+}
+
+void buildCfgIteration(CfgBuilder *builder, const IterationStatementNode *iterationStatementNode) {
+    const int type = iterationStatementNode->type;
+
+    if (type == ITERATION_DO) {
+        const int body = addCfgBlock(builder);
+        const int test = addCfgBlock(builder);
+        const int exit = addCfgBlock(builder);
+
+        continueCfgBlock(builder, body);
+        pushCfgTarget(builder, type, false, exit, test);
+        buildCfgStatement(builder, iterationStatementNode->statementNode);
+        builder->targetCount--;
+        continueCfgBlock(builder, test);
+        addCfgExpression(builder, CFG_BRANCH, iterationStatementNode->expressionNode1);
+        addCfgEdge(builder, test, body, EDGE_TRUE);
+        addCfgEdge(builder, test, exit, EDGE_FALSE);
+        builder->current = exit;
+        return;
+    }
+
+    if (type == ITERATION_FOR && iterationStatementNode->expressionNode1 != NULL) {
+        addCfgExpression(builder, CFG_EXPRESSION, iterationStatementNode->expressionNode1);
+    }
+
+    const int header = addCfgBlock(builder);
+    const int body = addCfgBlock(builder);
+    const int step = (type == ITERATION_FOR) ? addCfgBlock(builder) : header;
+    const int exit = addCfgBlock(builder);
+    const ExpressionNode *condition = (type == ITERATION_FOR) ? iterationStatementNode->expressionNode2 : iterationStatementNode->expressionNode1;
+
+    continueCfgBlock(builder, header);
+
+    // a For without a condition only leaves through Exit For
+    if (condition != NULL) {
+        addCfgExpression(builder, CFG_BRANCH, condition);
+        addCfgEdge(builder, header, body, EDGE_TRUE);
+        addCfgEdge(builder, header, exit, EDGE_FALSE);
+    }
+    else {
+        addCfgEdge(builder, header, body, EDGE_FALLTHROUGH);
+    }
+
+    builder->current = body;
+    pushCfgTarget(builder, type, iterationStatementNode->isWend, exit, step);
+    buildCfgStatement(builder, iterationStatementNode->statementNode);
+    builder->targetCount--;
+
+    if (step != header) {
+        continueCfgBlock(builder, step);
+
+        if (iterationStatementNode->expressionNode3 != NULL) {
+            addCfgExpression(builder, CFG_EXPRESSION, iterationStatementNode->expressionNode3);
+        }
+    }
+
+    addCfgEdge(builder, builder->current, header, EDGE_FALLTHROUGH);
+    builder->current = exit;
+}
+
+void jumpToCfgTarget(CfgBuilder *builder, int kind, bool isContinue) {
+    const CfgTarget *target = findCfgTarget(builder, kind);
+
+    if (target == NULL || (isContinue && target->continueBlock < 0)) {
+        addCfgEdge(builder, builder->current, CFG_EXIT, EDGE_JUMP);
+    }
+    else {
+        addCfgEdge(builder, builder->current, isContinue ? target->continueBlock : target->breakBlock, EDGE_JUMP);
+    }
+
+    startCfgBlock(builder);
+}
+
+// On Error changes which handler the following blocks report to, so it always ends its block.
+void buildCfgErrorHandler(CfgBuilder *builder, const JumpStatementNode *jumpStatementNode) {
+    const bool isDisabled = (jumpStatementNode->type == JUMP_ON_ERROR_GOTO && (jumpStatementNode->identifier == NULL || strcmp(jumpStatementNode->identifier, "0") == 0));
+
+    addCfgInstruction(builder, CFG_ERROR_HANDLER, jumpStatementNode);
+    builder->handlerLabel = (jumpStatementNode->type == JUMP_ON_ERROR_GOTO && !isDisabled) ? jumpStatementNode->identifier : NULL;
+    continueCfgBlock(builder, addCfgBlock(builder));
+}
+
+void buildCfgJump(CfgBuilder *builder, const JumpStatementNode *jumpStatementNode) {
+    switch (jumpStatementNode->type) {
+        case JUMP_CONTINUE: {
+            jumpToCfgTarget(builder, -2, true);
+            break;
+        }
+        case JUMP_STOP: {
+            // Stop only pauses under a debugger, and execution carries on after it
+            break;
+        }
+        case JUMP_EXIT_FOR: {
+            jumpToCfgTarget(builder, ITERATION_FOR, false);
+            break;
+        }
+        case JUMP_EXIT_DO: {
+            jumpToCfgTarget(builder, ITERATION_DO, false);
+            break;
+        }
+        case JUMP_RETURN: {
+            addCfgExpression(builder, CFG_RETURN, jumpStatementNode->expressionNode);
+            addCfgEdge(builder, builder->current, CFG_EXIT, EDGE_JUMP);
+            startCfgBlock(builder);
+            break;
+        }
+        case JUMP_GOTO: {
+            addCfgJump(builder, jumpStatementNode->identifier, EDGE_JUMP);
+            startCfgBlock(builder);
+            break;
+        }
+        case JUMP_GOSUB: {
+            // control comes back through the subroutine's Return, not straight from here
+            addCfgJump(builder, jumpStatementNode->identifier, EDGE_GOSUB);
+            startCfgBlock(builder);
+            pushIntegerStack(builder->gosubContinuations, builder->current);
+            break;
+        }
+        case JUMP_GOSUB_RETURN: {
+            pushIntegerStack(builder->gosubReturns, builder->current);
+            startCfgBlock(builder);
+            break;
+        }
+        case JUMP_ON_ERROR_GOTO:
+        case JUMP_ON_ERROR_RESUME_NEXT: {
+            buildCfgErrorHandler(builder, jumpStatementNode);
+            break;
+        }
+        case JUMP_RESUME:
+        case JUMP_RESUME_NEXT: {
+            pushIntegerStack(builder->resumes, builder->current);
+            startCfgBlock(builder);
+            break;
+        }
+    }
+}
+
+void buildCfgLabel(CfgBuilder *builder, const LabelStatementNode *labelStatementNode) {
+    if (labelStatementNode->labeledStatementType == LABEL_NAMED && labelStatementNode->identifier != NULL) {
+        char key[256];
+        const int block = addCfgBlock(builder);
+
+        continueCfgBlock(builder, block);
+        builder->blocks[block].label = labelStatementNode->identifier;
+        lowerCfgName(labelStatementNode->identifier, key, sizeof(key));
+        setStringIntegerMap(builder->labels, key, block);
+    }
+
+    buildCfgStatement(builder, labelStatementNode->statementNode);
+}
+
+// ReDim defines the whole array; only Preserve reads what was there before
+void buildCfgRedim(CfgBuilder *builder, const RedimStatementNode *redimStatementNode) {
+    const PostfixExpressionNode *postfixExpressionNode = redimStatementNode->postfixExpressionNode;
+    const PostfixExpressionNode *array = (postfixExpressionNode->postfixExpressionNode != NULL) ? postfixExpressionNode->postfixExpressionNode : postfixExpressionNode;
+
+    addCfgInstruction(builder, CFG_REDIM, redimStatementNode);
+
+    if (redimStatementNode->isPreserve || array->postfixExpressionType != POSTFIX_PRIMARY) {
+        collectCfgPostfix(builder, array);
+    }
+
+    for (int i = 0; postfixExpressionNode->assignExpressionNodes != NULL && i < postfixExpressionNode->assignExpressionNodes->size; i++) {
+        collectCfgAssignment(builder, postfixExpressionNode->assignExpressionNodes->contents[i]);
+    }
+
+    if (array->postfixExpressionType == POSTFIX_PRIMARY && array->primaryExpressionNode != NULL) {
+        addCfgReference(builder, lookupCfgName(builder->variableIds, array->primaryExpressionNode->identifier), true, OPERATOR_NONE, NULL);
+    }
+}
+
+void buildCfgStatement(CfgBuilder *builder, const StatementNode *statementNode) {
+    if (statementNode == NULL) {
+        return;
+    }
+
+    const int span = builder->statementCount;
+    builder->statements = reserveCfgArray(builder->statements, builder->statementCount, &builder->statementCapacity, sizeof(CfgStatementSpan));
+    builder->statements[builder->statementCount++] = (CfgStatementSpan){ statementNode, builder->current, builder->instructionCount, -1 };
+
+    if (statementNode->compoundStatementNode != NULL) {
+        buildCfgBlockItems(builder, statementNode->compoundStatementNode);
+    }
+    else if (statementNode->expressionStatementNode != NULL) {
+        addCfgExpression(builder, CFG_EXPRESSION, statementNode->expressionStatementNode->expressionNode);
+    }
+    else if (statementNode->selectionStatementNode != NULL) {
+        if (statementNode->selectionStatementNode->selectionType == SELECTION_MATCH) {
+            buildCfgSelect(builder, statementNode->selectionStatementNode);
+        }
+        else {
+            buildCfgIf(builder, statementNode->selectionStatementNode);
+        }
+    }
+    else if (statementNode->iterationStatementNode != NULL) {
+        buildCfgIteration(builder, statementNode->iterationStatementNode);
+    }
+    else if (statementNode->jumpStatementNode != NULL) {
+        buildCfgJump(builder, statementNode->jumpStatementNode);
+    }
+    else if (statementNode->labeledStatementNode != NULL) {
+        buildCfgLabel(builder, statementNode->labeledStatementNode);
+    }
+    else if (statementNode->redimStatementNode != NULL) {
+        buildCfgRedim(builder, statementNode->redimStatementNode);
+    }
+
+    builder->statements[span].endInstruction = builder->instructionCount;
+}
+
+// Labels are known only at the end: GoTo and handler edges go in now, a missing label goes to the exit.
+// Return may go back to any GoSub, and Resume to any block a handler protects.
+void resolveCfgJumps(CfgBuilder *builder, ControlFlowGraph *graph) {
+    for (int i = 0; i < builder->jumpCount; i++) {
+        const CfgPendingJump *jump = &builder->jumps[i];
+        const int target = lookupCfgName(builder->labels, jump->label);
+
+        if (target < 0) {
+            graph->unresolvedLabelCount++;
+        }
+
+        if (jump->kind == EDGE_EXCEPTION) {
+            builder->blocks[jump->block].handler = (target >= 0) ? target : CFG_EXIT;
+        }
+
+        addCfgEdge(builder, jump->block, (target >= 0) ? target : CFG_EXIT, jump->kind);
+    }
+
+    for (int i = 0; i <= builder->gosubReturns->top; i++) {
+        for (int j = 0; j <= builder->gosubContinuations->top; j++) {
+            addCfgEdge(builder, builder->gosubReturns->elements[i], builder->gosubContinuations->elements[j], EDGE_GOSUB_RETURN);
+        }
+
+        if (builder->gosubContinuations->top < 0) {
+            addCfgEdge(builder, builder->gosubReturns->elements[i], CFG_EXIT, EDGE_GOSUB_RETURN);
+        }
+    }
+
+    for (int i = 0; i <= builder->resumes->top; i++) {
+        bool isProtected = false;
+
+        for (int block = 0; block < builder->blockCount; block++) {
+            if (builder->blocks[block].handler >= 0) {
+                addCfgEdge(builder, builder->resumes->elements[i], block, EDGE_RESUME);
+                isProtected = true;
+            }
+        }
+
+        if (!isProtected) {
+            addCfgEdge(builder, builder->resumes->elements[i], CFG_EXIT, EDGE_RESUME);
+        }
+    }
+}
+
+// Edges grouped by source and by target, each copy pointing at its mate in the other array.
+void layoutCfgEdges(CfgBuilder *builder, ControlFlowGraph *graph) {
+    const int blockCount = builder->blockCount;
+    int *successorNext = calloc(blockCount + 1, sizeof(int));
+    int *predecessorNext = calloc(blockCount + 1, sizeof(int));
+
+    graph->edgeCount = builder->edgeCount;
+    graph->successors = allocateArena(graph->arena, sizeof(CfgEdge) * (builder->edgeCount + 1));
+    graph->predecessors = allocateArena(graph->arena, sizeof(CfgEdge) * (builder->edgeCount + 1));
+
+    for (int i = 0; i < builder->edgeCount; i++) {
+        graph->blocks[builder->edges[i].from].successorCount++;
+        graph->blocks[builder->edges[i].to].predecessorCount++;
+    }
+
+    for (int block = 0, successor = 0, predecessor = 0; block < blockCount; block++) {
+        graph->blocks[block].firstSuccessor = successorNext[block] = successor;
+        graph->blocks[block].firstPredecessor = predecessorNext[block] = predecessor;
+        successor += graph->blocks[block].successorCount;
+        predecessor += graph->blocks[block].predecessorCount;
+    }
+
+    for (int i = 0; i < builder->edgeCount; i++) {
+        const CfgEdge *edge = &builder->edges[i];
+        const int successor = successorNext[edge->from]++;
+        const int predecessor = predecessorNext[edge->to]++;
+
+        graph->successors[successor] = (CfgEdge){ edge->from, edge->to, edge->kind, predecessor };
+        graph->predecessors[predecessor] = (CfgEdge){ edge->from, edge->to, edge->kind, successor };
+    }
+
+    free(successorNext);
+    free(predecessorNext);
+}
+
+// Reverse postorder of the blocks reachable from the entry, by an explicit-stack depth-first search.
+void orderCfgBlocks(ControlFlowGraph *graph) {
+    int *stack = malloc(sizeof(int) * (graph->blockCount + 1));
+    int *nextEdge = calloc(graph->blockCount, sizeof(int));
+    int *postorder = malloc(sizeof(int) * graph->blockCount);
+    bool *visited = calloc(graph->blockCount, sizeof(bool));
+    int top = 0, count = 0;
+
+    stack[0] = CFG_ENTRY;
+    visited[CFG_ENTRY] = true;
+
+    while (top >= 0) {
+        const int block = stack[top];
+        const CfgBlock *node = &graph->blocks[block];
+
+        if (nextEdge[block] < node->successorCount) {
+            const int successor = graph->successors[node->firstSuccessor + nextEdge[block]++].to;
+
+            if (!visited[successor]) {
+                visited[successor] = true;
+                stack[++top] = successor;
+            }
+        }
+        else {
+            postorder[count++] = block;
+            top--;
+        }
+    }
+
+    graph->order = allocateArena(graph->arena, sizeof(int) * (count + 1));
+    graph->reachableCount = count;
+
+    for (int i = 0; i < count; i++) {
+        graph->order[i] = postorder[count - 1 - i];
+        graph->blocks[graph->order[i]].order = i;
+    }
+
+    free(stack);
+    free(nextEdge);
+    free(postorder);
+    free(visited);
+}
+
+int joinResumeStates(int state, int other) {
+    if (state < 0 || other < 0) {
+        return (state < 0) ? other : state;
+    }
+
+    return (state == other) ? state : RESUME_UNKNOWN;
+}
+
+// the state a block hands its successors: On Error always ends its block, so only a last instruction can change it
+int getResumeExitState(const ControlFlowGraph *graph, const CfgBlock *block) {
+    const CfgInstruction *last = (block->instructionCount > 0) ? &graph->instructions[block->firstInstruction + block->instructionCount - 1] : NULL;
+
+    if (last == NULL || last->kind != CFG_ERROR_HANDLER) {
+        return block->resumeNext;
+    }
+
+    return (((const JumpStatementNode *)last->node)->type == JUMP_ON_ERROR_RESUME_NEXT) ? RESUME_ON : RESUME_OFF;
+}
+
+// On Error Resume Next lasts until the next On Error that runs, which is a matter of flow rather than of
+// where the statements stand: forward over reverse postorder until nothing changes, with the entry off.
+// A state only moves from unreachable to one value to unknown, so this settles after a few passes.
+void computeCfgResumeStates(ControlFlowGraph *graph) {
+    bool isChanged = true;
+
+    for (int i = 0; i < graph->blockCount; i++) {
+        graph->blocks[i].resumeNext = -1;
+    }
+
+    while (isChanged) {
+        isChanged = false;
+
+        for (int i = 0; i < graph->reachableCount; i++) {
+            CfgBlock *block = &graph->blocks[graph->order[i]];
+            int state = (graph->order[i] == CFG_ENTRY) ? RESUME_OFF : -1;
+
+            for (int j = 0; j < block->predecessorCount; j++) {
+                state = joinResumeStates(state, getResumeExitState(graph, &graph->blocks[graph->predecessors[block->firstPredecessor + j].from]));
+            }
+
+            if (state != block->resumeNext) {
+                block->resumeNext = state;
+                isChanged = true;
+            }
+        }
+    }
+}
+
+int compareCfgStatements(const void *left, const void *right) {
+    const uintptr_t leftNode = (uintptr_t)((const CfgStatement *)left)->node;
+    const uintptr_t rightNode = (uintptr_t)((const CfgStatement *)right)->node;
+    return (leftNode > rightNode) - (leftNode < rightNode);
+}
+
+// Each statement's state, sorted by node for getCfgResumeState; code that never runs counts as off.
+void layoutCfgStatements(CfgBuilder *builder, ControlFlowGraph *graph) {
+    graph->statementCount = builder->statementCount;
+    graph->statements = allocateArena(graph->arena, sizeof(CfgStatement) * (builder->statementCount + 1));
+
+    for (int i = 0; i < builder->statementCount; i++) {
+        const CfgStatementSpan *span = &builder->statements[i];
+        int state = (span->firstInstruction == span->endInstruction) ? graph->blocks[span->entryBlock].resumeNext : -1;
+
+        for (int instruction = span->firstInstruction; instruction < span->endInstruction; instruction++) {
+            state = joinResumeStates(state, graph->blocks[graph->instructions[instruction].block].resumeNext);
+        }
+
+        graph->statements[i] = (CfgStatement){ span->node, (state < 0) ? RESUME_OFF : state };
+    }
+
+    qsort(graph->statements, graph->statementCount, sizeof(CfgStatement), compareCfgStatements);
+}
+
+void *copyToCfgArena(ControlFlowGraph *graph, const void *source, int count, size_t elementSize) {
+    void *target = allocateArena(graph->arena, elementSize * (count + 1));
+
+    if (count > 0) {
+        memcpy(target, source, elementSize * count);
+    }
+
+    return target;
+}
+
+void addCfgParameters(CfgBuilder *builder, const FunctionDefinitionNode *functionDefinitionNode) {
+    const ParameterTypeListNode *parameterTypeListNode = getParameterTypeList(functionDefinitionNode->declaratorNode);
+
+    for (const ParameterListNode *parameterListNode = (parameterTypeListNode != NULL) ? parameterTypeListNode->parameterListNode : NULL; parameterListNode != NULL; parameterListNode = parameterListNode->parameterListNode) {
+        const ParameterDeclarationNode *parameterDeclarationNode = parameterListNode->parameterDeclarationNode;
+
+        if (parameterDeclarationNode != NULL && parameterDeclarationNode->declaratorNode != NULL) {
+            addCfgVariable(builder, getDeclaratorName(parameterDeclarationNode->declaratorNode), VARIABLE_PARAMETER, NULL);
+        }
+    }
+}
+
+// Builds in growable scratch arrays, then packs the result into the graph's arena.
+ControlFlowGraph *buildControlFlowGraph(const FunctionDefinitionNode *functionDefinitionNode) {
+    CfgBuilder builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.variableIds = buildStringIntegerMap(64);
+    builder.labels = buildStringIntegerMap(16);
+    builder.gosubContinuations = initializeIntegerStack();
+    builder.gosubReturns = initializeIntegerStack();
+    builder.resumes = initializeIntegerStack();
+
+    // a Function's return value is assigned through its own name
+    addCfgVariable(&builder, getDeclaratorName(functionDefinitionNode->declaratorNode), VARIABLE_RESULT, NULL);
+    addCfgParameters(&builder, functionDefinitionNode);
+
+    if (functionDefinitionNode->compoundStatementNode != NULL) {
+        collectCfgCompoundLocals(&builder, functionDefinitionNode->compoundStatementNode);
+    }
+
+    addCfgBlock(&builder);
+    addCfgBlock(&builder);
+    builder.current = CFG_ENTRY;
+
+    if (functionDefinitionNode->compoundStatementNode != NULL) {
+        buildCfgBlockItems(&builder, functionDefinitionNode->compoundStatementNode);
+    }
+
+    addCfgEdge(&builder, builder.current, CFG_EXIT, EDGE_FALLTHROUGH);
+
+    Arena *arena = buildArena(CFG_ARENA_BLOCK_SIZE);
+    ControlFlowGraph *graph = allocateArena(arena, sizeof(ControlFlowGraph));
+    graph->arena = arena;
+    graph->procedure = functionDefinitionNode;
+
+    resolveCfgJumps(&builder, graph);
+
+    graph->blockCount = builder.blockCount;
+    graph->blocks = copyToCfgArena(graph, builder.blocks, builder.blockCount, sizeof(CfgBlock));
+    graph->instructionCount = builder.instructionCount;
+    graph->instructions = copyToCfgArena(graph, builder.instructions, builder.instructionCount, sizeof(CfgInstruction));
+    graph->referenceCount = builder.referenceCount;
+    graph->references = copyToCfgArena(graph, builder.references, builder.referenceCount, sizeof(CfgReference));
+    graph->variableCount = builder.variableCount;
+    graph->variables = copyToCfgArena(graph, builder.variables, builder.variableCount, sizeof(CfgVariable));
+
+    layoutCfgEdges(&builder, graph);
+    orderCfgBlocks(graph);
+    computeCfgResumeStates(graph);
+    layoutCfgStatements(&builder, graph);
+
+    free(builder.blocks);
+    free(builder.edges);
+    free(builder.instructions);
+    free(builder.references);
+    free(builder.variables);
+    free(builder.statements);
+    free(builder.jumps);
+    free(builder.targets);
+    freeStringIntegerMap(builder.variableIds);
+    freeStringIntegerMap(builder.labels);
+    free(builder.gosubContinuations->elements);
+    free(builder.gosubContinuations);
+    free(builder.gosubReturns->elements);
+    free(builder.gosubReturns);
+    free(builder.resumes->elements);
+    free(builder.resumes);
+
+    return graph;
+}
+
+// Built on first request and kept on the procedure's node for every later analysis.
+ControlFlowGraph *getControlFlowGraph(FunctionDefinitionNode *functionDefinitionNode) {
+    if (functionDefinitionNode->controlFlowGraph == NULL) {
+        functionDefinitionNode->controlFlowGraph = buildControlFlowGraph(functionDefinitionNode);
+    }
+
+    return functionDefinitionNode->controlFlowGraph;
+}
+
+void freeControlFlowGraph(ControlFlowGraph *graph) {
+    freeArena(graph->arena);
+}
+
+int findCfgVariable(const ControlFlowGraph *graph, const char *name) {
+    for (int i = 0; name != NULL && i < graph->variableCount; i++) {
+        if (strcasecmp(graph->variables[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// whether On Error Resume Next is in effect where statementNode runs, as a CfgResumeState
+int getCfgResumeState(const ControlFlowGraph *graph, const StatementNode *statementNode) {
+    const CfgStatement key = { statementNode, RESUME_OFF };
+    const CfgStatement *statement = bsearch(&key, graph->statements, graph->statementCount, sizeof(CfgStatement), compareCfgStatements);
+    return (statement != NULL) ? statement->resumeNext : RESUME_OFF;
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "parser.h"
+
+// what one instruction does; node points back into the AST
+enum CfgInstructionKind {
+    CFG_DECLARATION,
+    CFG_EXPRESSION,
+    CFG_BRANCH,
+    CFG_SWITCH,
+    CFG_CASE,
+    CFG_RETURN,
+    CFG_ERROR_HANDLER,
+    CFG_REDIM
+};
+
+enum CfgEdgeKind {
+    EDGE_FALLTHROUGH,
+    EDGE_TRUE,
+    EDGE_FALSE,
+    EDGE_CASE,
+    EDGE_JUMP,
+    EDGE_GOSUB,
+    EDGE_GOSUB_RETURN,
+    EDGE_EXCEPTION,
+    EDGE_RESUME
+};
+
+// whether On Error Resume Next is in effect; unknown where paths that disagree about it meet
+enum CfgResumeState {
+    RESUME_OFF,
+    RESUME_ON,
+    RESUME_UNKNOWN
+};
+
+enum CfgVariableKind {
+    VARIABLE_PARAMETER,
+    VARIABLE_LOCAL,
+    VARIABLE_RESULT
+};
+
+// node is an InitializeDeclaratorNode for CFG_DECLARATION, a ConditionalExpressionNode (or NULL for
+// Case Else) for CFG_CASE, a JumpStatementNode for CFG_ERROR_HANDLER, a RedimStatementNode for CFG_REDIM
+// and an ExpressionNode (or NULL) otherwise
+typedef struct CfgInstruction {
+    int kind;
+    int block;
+    const void *node;
+    int firstReference;
+    int referenceCount;
+} CfgInstruction;
+
+// mate is the index of the same edge in the other direction's array, which phi operands are ordered by
+typedef struct CfgEdge {
+    int from;
+    int to;
+    int kind;
+    int mate;
+} CfgEdge;
+
+// handler is the block an error in this block goes to, or -1; resumeNext is the CfgResumeState the block
+// starts in, -1 if unreachable; order is the reverse postorder index, -1 if unreachable
+typedef struct CfgBlock {
+    int firstInstruction;
+    int instructionCount;
+    int firstSuccessor;
+    int successorCount;
+    int firstPredecessor;
+    int predecessorCount;
+    int handler;
+    int resumeNext;
+    int order;
+    const char *label;
+} CfgBlock;
+
+// resumeNext joins the states of the blocks a statement's instructions, nested ones included, run in
+typedef struct CfgStatement {
+    const StatementNode *node;
+    int resumeNext;
+} CfgStatement;
+
+typedef struct CfgVariable {
+    const char *name;
+    int kind;
+    const DeclarationNode *declarationNode;
+} CfgVariable;
+
+// A read or write of a procedure variable, in evaluation order; value is its SSA value once built.
+// A read's node is its PrimaryExpressionNode. A write's node is the AssignmentExpressionNode it stores and
+// operatorType how it stores it: OPERATOR_ASSIGN, a compound operator (++ and -- store no node with
+// OPERATOR_ADD_EQUAL or OPERATOR_SUBTRACT_EQUAL), or OPERATOR_NONE for a Dim without initializer or a ReDim.
+typedef struct CfgReference {
+    int instruction;
+    int variable;
+    int value;
+    bool isDefinition;
+    int operatorType;
+    const void *node;
+} CfgReference;
+
+// One procedure's blocks, edges and instructions, all in one arena and addressed by dense integer ids.
+// Block 0 is the entry and block 1 the single exit; successors and predecessors are grouped per block.
+typedef struct ControlFlowGraph {
+    Arena *arena;
+    const FunctionDefinitionNode *procedure;
+    CfgBlock *blocks;
+    int blockCount;
+    CfgEdge *successors;
+    CfgEdge *predecessors;
+    int edgeCount;
+    CfgInstruction *instructions;
+    int instructionCount;
+    CfgReference *references;
+    int referenceCount;
+    CfgVariable *variables;
+    int variableCount;
+    CfgStatement *statements;
+    int statementCount;
+    int *order;
+    int reachableCount;
+    int unresolvedLabelCount;
+    struct SsaForm *ssa;
+    struct InferredTypes *types;
+    struct CollectionLowering *collections;
+} ControlFlowGraph;
+
+#define CFG_ENTRY 0
+#define CFG_EXIT 1
+
+ControlFlowGraph *getControlFlowGraph(FunctionDefinitionNode *functionDefinitionNode);
+ControlFlowGraph *buildControlFlowGraph(const FunctionDefinitionNode *functionDefinitionNode);
+void freeControlFlowGraph(ControlFlowGraph *graph);
+int findCfgVariable(const ControlFlowGraph *graph, const char *name);
+int getCfgResumeState(const ControlFlowGraph *graph, const StatementNode *statementNode);
\ No newline at end of file
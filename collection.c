@@ -0,0 +1,386 @@
+#include "collection.h"
+
+// What one variable's uses have shown so far. kind is COLLECTION_LIST for any Collection until its keys
+// are seen, and COLLECTION_NONE for an Object or Variant that nothing has constructed yet.
+typedef struct CollectionCandidate {
+    int kind;
+    bool isRejected;
+    bool isKeyed;
+    bool isIndexed;
+    bool isUnkeyed;
+    bool isTextCompare;
+    int uses;
+    InferredType key;
+    InferredType value;
+} CollectionCandidate;
+
+// elements is the item type each candidate was assumed to have for this pass; claimed is the "c.Add" of
+// a "c.Add x" just scanned, which the walk visits next
+typedef struct CollectionScan {
+    const ControlFlowGraph *graph;
+    const InferredTypes *types;
+    CollectionCandidate *candidates;
+    InferredType *elements;
+    const PostfixExpressionNode *claimed;
+} CollectionScan;
+
+int getCollectionMember(const char *name) {
+    static const char *const names[] = { "", "Add", "Item", "Remove", "Exists", "Count", "RemoveAll", "Keys", "Items", "CompareMode" };
+
+    for (int member = MEMBER_ADD; name != NULL && member <= MEMBER_COMPARE_MODE; member++) {
+        if (strcasecmp(name, names[member]) == 0) {
+            return member;
+        }
+    }
+
+    return MEMBER_UNKNOWN;
+}
+
+int getCollectionClass(const TypeSpecifierNode *typeSpecifierNode) {
+    const char *name = (typeSpecifierNode != NULL) ? typeSpecifierNode->flockName : NULL;
+
+    if (name == NULL && typeSpecifierNode != NULL && typeSpecifierNode->flockSpecifierNode != NULL) {
+        name = typeSpecifierNode->flockSpecifierNode->identifier;
+    }
+
+    if (name != NULL && (strcasecmp(name, "Collection") == 0 || strcasecmp(name, "VBA.Collection") == 0)) {
+        return COLLECTION_LIST;
+    }
+
+    if (name != NULL && (strcasecmp(name, "Dictionary") == 0 || strcasecmp(name, "Scripting.Dictionary") == 0)) {
+        return COLLECTION_DICTIONARY;
+    }
+
+    return COLLECTION_NONE;
+}
+
+// COLLECTION_LIST for "New Collection", COLLECTION_DICTIONARY for "New Dictionary" or
+// CreateObject("Scripting.Dictionary"), and COLLECTION_NONE for anything else
+int getConstructedCollection(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const UnaryExpressionNode *unaryExpressionNode = getAssignmentUnary(assignmentExpressionNode);
+
+    if (unaryExpressionNode != NULL && unaryExpressionNode->type == UNARY_NEW) {
+        const SpecifierQualifierNode *specifierQualifierNode = unaryExpressionNode->typeNameNode->specifierQualifierNode;
+        return getCollectionClass((specifierQualifierNode != NULL) ? specifierQualifierNode->typeSpecifierNode : NULL);
+    }
+
+    const PostfixExpressionNode *postfixExpressionNode = getUnaryPostfix(unaryExpressionNode);
+    const Vector *arguments = (postfixExpressionNode != NULL && postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS) ? postfixExpressionNode->assignExpressionNodes : NULL;
+    const char *function = (arguments != NULL && arguments->size == 1) ? getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode) : NULL;
+
+    if (function == NULL || strcasecmp(function, "CreateObject") != 0) {
+        return COLLECTION_NONE;
+    }
+
+    const PostfixExpressionNode *argument = getUnaryPostfix(getAssignmentUnary(arguments->contents[0]));
+    const PrimaryExpressionNode *primaryExpressionNode = (argument != NULL && argument->postfixExpressionType == POSTFIX_PRIMARY) ? argument->primaryExpressionNode : NULL;
+
+    return (primaryExpressionNode != NULL && primaryExpressionNode->str != NULL && strcasecmp(primaryExpressionNode->str, "Scripting.Dictionary") == 0) ? COLLECTION_DICTIONARY : COLLECTION_NONE;
+}
+
+bool getCollectionUse(const ControlFlowGraph *graph, const PostfixExpressionNode *postfixExpressionNode, CollectionUse *use) {
+    const PostfixExpressionNode *base = (postfixExpressionNode != NULL) ? postfixExpressionNode->postfixExpressionNode : NULL;
+    const char *name = NULL;
+
+    if (base == NULL || postfixExpressionNode->postfixExpressionType == POSTFIX_PRIMARY) {
+        return false;
+    }
+
+    if (postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS && base->postfixExpressionType == POSTFIX_DOT) {
+        name = getPostfixIdentifier(base->postfixExpressionNode);
+        use->member = getCollectionMember(base->identifier);
+        use->arguments = postfixExpressionNode->assignExpressionNodes;
+    }
+    else if (postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS) {
+        // Item is the default member
+        name = getPostfixIdentifier(base);
+        use->member = MEMBER_ITEM;
+        use->arguments = postfixExpressionNode->assignExpressionNodes;
+    }
+    else if (postfixExpressionNode->postfixExpressionType == POSTFIX_DOT) {
+        name = getPostfixIdentifier(base);
+        use->member = getCollectionMember(postfixExpressionNode->identifier);
+        use->arguments = NULL;
+    }
+
+    use->variable = (name != NULL) ? findCfgVariable(graph, name) : -1;
+    return use->variable >= 0 && use->member != MEMBER_UNKNOWN;
+}
+
+// vbBinaryCompare is 0 and vbTextCompare 1; -1 for anything not a constant
+int getCompareMode(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const PostfixExpressionNode *postfixExpressionNode = getUnaryPostfix(getAssignmentUnary(assignmentExpressionNode));
+    const PrimaryExpressionNode *primaryExpressionNode = (postfixExpressionNode != NULL && postfixExpressionNode->postfixExpressionType == POSTFIX_PRIMARY) ? postfixExpressionNode->primaryExpressionNode : NULL;
+
+    if (primaryExpressionNode == NULL) {
+        return -1;
+    }
+
+    if (primaryExpressionNode->identifier != NULL) {
+        return (strcasecmp(primaryExpressionNode->identifier, "vbBinaryCompare") == 0) ? 0
+            : (strcasecmp(primaryExpressionNode->identifier, "vbTextCompare") == 0) ? 1
+            : -1;
+    }
+
+    const ConstantNode *constantNode = primaryExpressionNode->constantNode;
+    const bool isInteger = (constantNode != NULL && constantNode->constantType != CONSTANT_STRING && constantNode->constantType != CONSTANT_FP64
+        && constantNode->constantType != CONSTANT_B8);
+
+    return (isInteger && (constantNode->integerConstant == 0 || constantNode->integerConstant == 1)) ? constantNode->integerConstant : -1;
+}
+
+InferredType joinCollectionType(const CollectionScan *scan, InferredType type, const AssignmentExpressionNode *assignmentExpressionNode) {
+    return joinInferredTypes(type, getExpressionInferredType(scan->types, scan->elements, assignmentExpressionNode));
+}
+
+void scanCollectionUse(const PostfixExpressionNode *postfixExpressionNode, void *context) {
+    CollectionScan *scan = context;
+    CollectionUse use;
+
+    if (postfixExpressionNode == scan->claimed || !getCollectionUse(scan->graph, postfixExpressionNode, &use)) {
+        return;
+    }
+
+    CollectionCandidate *candidate = &scan->candidates[use.variable];
+    const int count = (use.arguments != NULL) ? use.arguments->size : 0;
+    const bool isDictionary = (candidate->kind == COLLECTION_DICTIONARY);
+    bool isValid = true;
+
+    scan->claimed = postfixExpressionNode->postfixExpressionNode;
+    candidate->uses++;
+
+    if (candidate->kind == COLLECTION_NONE || candidate->isRejected) {
+        return;
+    }
+
+    switch (use.member) {
+        case MEMBER_ADD: {
+            // Collection.Add item, key and Dictionary.Add key, item; Before and After are not lowered
+            isValid = isDictionary ? (count == 2) : (count == 1 || count == 2);
+
+            if (isValid && isDictionary) {
+                candidate->key = joinCollectionType(scan, candidate->key, use.arguments->contents[0]);
+                candidate->value = joinCollectionType(scan, candidate->value, use.arguments->contents[1]);
+            }
+            else if (isValid) {
+                candidate->value = joinCollectionType(scan, candidate->value, use.arguments->contents[0]);
+                candidate->key = (count == 2) ? joinCollectionType(scan, candidate->key, use.arguments->contents[1]) : candidate->key;
+                candidate->isKeyed |= (count == 2);
+                candidate->isUnkeyed |= (count == 1);
+            }
+
+            break;
+        }
+        case MEMBER_ITEM:
+        case MEMBER_REMOVE: {
+            isValid = (count == 1);
+
+            if (isValid && isDictionary) {
+                candidate->key = joinCollectionType(scan, candidate->key, use.arguments->contents[0]);
+            }
+            else if (isValid) {
+                // a Collection takes a position or a key through the same argument
+                const int kind = getExpressionInferredType(scan->types, scan->elements, use.arguments->contents[0]).kind;
+
+                candidate->isIndexed |= (kind == INFERRED_INT);
+                candidate->isKeyed |= (kind == INFERRED_STRING);
+                isValid = (kind == INFERRED_INT || kind == INFERRED_STRING);
+            }
+
+            break;
+        }
+        case MEMBER_EXISTS: {
+            isValid = isDictionary && count == 1;
+
+            if (isValid) {
+                candidate->key = joinCollectionType(scan, candidate->key, use.arguments->contents[0]);
+            }
+
+            break;
+        }
+        case MEMBER_COUNT: {
+            isValid = (count == 0);
+            break;
+        }
+        default: {
+            isValid = isDictionary && count == 0;
+            break;
+        }
+    }
+
+    candidate->isRejected |= !isValid;
+}
+
+// "d(k) = v" and "d.CompareMode = vbTextCompare"; a Collection's items are read-only
+void scanCollectionStore(const StatementNode *statementNode, void *context) {
+    CollectionScan *scan = context;
+    const ExpressionNode *expressionNode = (statementNode->expressionStatementNode != NULL) ? statementNode->expressionStatementNode->expressionNode : NULL;
+    const AssignmentExpressionNode *assignmentExpressionNode = (expressionNode != NULL) ? expressionNode->assignExpressionNode : NULL;
+    CollectionUse use;
+
+    if (assignmentExpressionNode == NULL || assignmentExpressionNode->assignExpressionNode == NULL || !getCollectionUse(scan->graph, getUnaryPostfix(assignmentExpressionNode->unaryExpressionNode), &use)) {
+        return;
+    }
+
+    CollectionCandidate *candidate = &scan->candidates[use.variable];
+
+    if (candidate->kind != COLLECTION_DICTIONARY || assignmentExpressionNode->assignOperator != OPERATOR_ASSIGN) {
+        candidate->isRejected = true;
+    }
+    else if (use.member == MEMBER_ITEM) {
+        candidate->value = joinCollectionType(scan, candidate->value, assignmentExpressionNode->assignExpressionNode);
+    }
+    else if (use.member == MEMBER_COMPARE_MODE && getCompareMode(assignmentExpressionNode->assignExpressionNode) >= 0) {
+        candidate->isTextCompare = (getCompareMode(assignmentExpressionNode->assignExpressionNode) == 1);
+    }
+    else {
+        candidate->isRejected = true;
+    }
+}
+
+// whether a local declared with this type could hold a collection the scan can lower
+bool isCollectionCandidate(const TypeSpecifierNode *typeSpecifierNode) {
+    if (typeSpecifierNode == NULL || typeSpecifierNode->typeSpecifier == TYPE_VARIANT || getCollectionClass(typeSpecifierNode) != COLLECTION_NONE) {
+        return true;
+    }
+
+    return typeSpecifierNode->flockName != NULL && strcasecmp(typeSpecifierNode->flockName, "Object") == 0;
+}
+
+// Only locals are lowered: parameters and the result escape the procedure, and arrays are indexed
+// with the same parentheses as a collection's default member.
+void declareCollectionCandidates(const ControlFlowGraph *graph, CollectionCandidate *candidates) {
+    for (int variable = 0; variable < graph->variableCount; variable++) {
+        const CfgVariable *cfgVariable = &graph->variables[variable];
+        CollectionCandidate *candidate = &candidates[variable];
+
+        if (cfgVariable->kind != VARIABLE_LOCAL) {
+            candidate->isRejected = true;
+            continue;
+        }
+
+        bool isConstant = false;
+        const TypeSpecifierNode *typeSpecifierNode = findTypeSpecifier(cfgVariable->declarationNode->declarationSpecifierNodes, &isConstant);
+        const Vector *initializeDeclaratorNodes = cfgVariable->declarationNode->initializeDeclaratorNodes;
+
+        candidate->kind = getCollectionClass(typeSpecifierNode);
+        candidate->isRejected = !isCollectionCandidate(typeSpecifierNode);
+
+        for (int i = 0; initializeDeclaratorNodes != NULL && i < initializeDeclaratorNodes->size; i++) {
+            const InitializeDeclaratorNode *initializeDeclaratorNode = initializeDeclaratorNodes->contents[i];
+
+            if (initializeDeclaratorNode->declaratorNode != NULL && strcasecmp(getDeclaratorName(initializeDeclaratorNode->declaratorNode), cfgVariable->name) == 0) {
+                candidate->isRejected |= isArrayDeclarator(initializeDeclaratorNode->declaratorNode) || initializeDeclaratorNode->initializerNode != NULL;
+            }
+        }
+    }
+}
+
+// Every store to the variable itself has to construct the same kind of collection or set it to Nothing.
+void scanCollectionDefinitions(const ControlFlowGraph *graph, CollectionCandidate *candidates) {
+    for (int i = 0; i < graph->referenceCount; i++) {
+        const CfgReference *reference = &graph->references[i];
+
+        if (!reference->isDefinition || reference->variable < 0 || reference->operatorType == OPERATOR_NONE) {
+            continue;
+        }
+
+        CollectionCandidate *candidate = &candidates[reference->variable];
+        const AssignmentExpressionNode *assignmentExpressionNode = (reference->operatorType == OPERATOR_ASSIGN) ? reference->node : NULL;
+        const char *name = (assignmentExpressionNode != NULL) ? getAssignmentIdentifier(assignmentExpressionNode) : NULL;
+        const int kind = (assignmentExpressionNode != NULL) ? getConstructedCollection(assignmentExpressionNode) : COLLECTION_NONE;
+
+        if (kind == COLLECTION_NONE) {
+            candidate->isRejected |= (name == NULL || strcasecmp(name, "Nothing") != 0);
+        }
+        else if (candidate->kind == COLLECTION_NONE) {
+            candidate->kind = kind;
+        }
+        else {
+            candidate->isRejected |= (candidate->kind != kind);
+        }
+    }
+}
+
+// One pass over the procedure, assuming the item types in scan->elements; true when the items it saw
+// need a wider type than it assumed.
+bool scanCollections(CollectionScan *scan, const StatementNode *body) {
+    const ControlFlowGraph *graph = scan->graph;
+    bool isChanged = false;
+
+    memset(scan->candidates, 0, sizeof(CollectionCandidate) * (graph->variableCount + 1));
+    declareCollectionCandidates(graph, scan->candidates);
+    scanCollectionDefinitions(graph, scan->candidates);
+    walkStatements(body, scanCollectionStore, scan);
+    walkStatementPostfixes(body, scanCollectionUse, scan);
+
+    for (int variable = 0; variable < graph->variableCount; variable++) {
+        const CollectionCandidate *candidate = &scan->candidates[variable];
+        const bool isCandidate = (candidate->kind != COLLECTION_NONE && !candidate->isRejected);
+        const InferredType element = joinInferredTypes(scan->elements[variable], isCandidate ? candidate->value : (InferredType){ INFERRED_OBJECT, NULL });
+
+        isChanged |= (element.kind != scan->elements[variable].kind);
+        scan->elements[variable] = element;
+    }
+
+    return isChanged;
+}
+
+// A candidate lowers once every read of it is a member use the scan understood and its keys and items
+// have concrete types. A Collection used both by key and by position needs the shim's ordered map.
+// Item types start unknown and only widen, so "d(k) = d(k) + 1" settles on the type of its other stores.
+CollectionLowering *buildCollectionLowerings(ControlFlowGraph *graph, const SymbolIndex *symbols) {
+    CollectionLowering *lowerings = allocateArena(graph->arena, sizeof(CollectionLowering) * (graph->variableCount + 1));
+    CollectionCandidate *candidates = malloc(sizeof(CollectionCandidate) * (graph->variableCount + 1));
+    InferredType *elements = calloc(graph->variableCount + 1, sizeof(InferredType));
+    int *reads = calloc(graph->variableCount + 1, sizeof(int));
+    CollectionScan scan = { graph, getInferredTypes(graph, symbols), candidates, elements, NULL };
+    const StatementNode body = { .compoundStatementNode = graph->procedure->compoundStatementNode };
+
+    for (bool isChanged = true; isChanged;) {
+        isChanged = scanCollections(&scan, &body);
+    }
+
+    for (int i = 0; i < graph->referenceCount; i++) {
+        if (!graph->references[i].isDefinition && graph->references[i].variable >= 0) {
+            reads[graph->references[i].variable]++;
+        }
+    }
+
+    for (int variable = 0; variable < graph->variableCount; variable++) {
+        const CollectionCandidate *candidate = &candidates[variable];
+        CollectionLowering *lowering = &lowerings[variable];
+
+        if (candidate->isRejected || candidate->kind == COLLECTION_NONE || candidate->uses != reads[variable] || getCSharpInferredName(candidate->value) == NULL) {
+            continue;
+        }
+
+        if (candidate->kind == COLLECTION_LIST && candidate->isKeyed) {
+            // Collection keys are strings, compared without regard to case
+            if (!candidate->isIndexed && !candidate->isUnkeyed && (candidate->key.kind == INFERRED_STRING || candidate->key.kind == INFERRED_UNKNOWN)) {
+                *lowering = (CollectionLowering){ COLLECTION_KEYED, { INFERRED_STRING, NULL }, candidate->value, true };
+            }
+        }
+        else if (candidate->kind == COLLECTION_LIST) {
+            *lowering = (CollectionLowering){ COLLECTION_LIST, { INFERRED_INT, NULL }, candidate->value, false };
+        }
+        else if (getCSharpInferredName(candidate->key) != NULL && (!candidate->isTextCompare || candidate->key.kind == INFERRED_STRING)) {
+            *lowering = (CollectionLowering){ COLLECTION_DICTIONARY, candidate->key, candidate->value, candidate->isTextCompare };
+        }
+    }
+
+    free(candidates);
+    free(elements);
+    free(reads);
+
+    return lowerings;
+}
+
+// Built on first request into the graph's arena, like the inferred types it reads.
+const CollectionLowering *getCollectionLowerings(ControlFlowGraph *graph, const SymbolIndex *symbols) {
+    if (graph->collections == NULL) {
+        graph->collections = buildCollectionLowerings(graph, symbols);
+    }
+
+    return graph->collections;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "infer.h"
+#include "walk.h"
+
+// What a procedure's Collection or Scripting.Dictionary local lowers to. A Collection only ever indexed by
+// position becomes a List, one only ever addressed by key a Dictionary keyed by string; either way the
+// element type has to be proven, or the variable keeps the late-bound shim (COLLECTION_NONE).
+enum CollectionKind {
+    COLLECTION_NONE,
+    COLLECTION_LIST,
+    COLLECTION_KEYED,
+    COLLECTION_DICTIONARY
+};
+
+enum CollectionMember {
+    MEMBER_UNKNOWN,
+    MEMBER_ADD,
+    MEMBER_ITEM,
+    MEMBER_REMOVE,
+    MEMBER_EXISTS,
+    MEMBER_COUNT,
+    MEMBER_REMOVE_ALL,
+    MEMBER_KEYS,
+    MEMBER_ITEMS,
+    MEMBER_COMPARE_MODE
+};
+
+// isTextCompare is a case-insensitive key comparison: always for a keyed Collection, and for a
+// Dictionary whose CompareMode is set to vbTextCompare
+typedef struct CollectionLowering {
+    int kind;
+    InferredType key;
+    InferredType value;
+    bool isTextCompare;
+} CollectionLowering;
+
+// One member access on a procedure variable: "c.Add x", "c.Item(k)", "c(k)" (MEMBER_ITEM) or "c.Count".
+// arguments is NULL for a property read without parentheses.
+typedef struct CollectionUse {
+    int variable;
+    int member;
+    const Vector *arguments;
+} CollectionUse;
+
+int getCollectionClass(const TypeSpecifierNode *typeSpecifierNode);
+bool isCollectionCandidate(const TypeSpecifierNode *typeSpecifierNode);
+const CollectionLowering *getCollectionLowerings(ControlFlowGraph *graph, const SymbolIndex *symbols);
+bool getCollectionUse(const ControlFlowGraph *graph, const PostfixExpressionNode *postfixExpressionNode, CollectionUse *use);
+int getConstructedCollection(const AssignmentExpressionNode *assignmentExpressionNode);
\ No newline at end of file
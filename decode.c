@@ -0,0 +1,272 @@
+#include <errno.h>
+#include <iconv.h>
+#include <strings.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "decode.h"
+
+// 0x80-0x9F of Windows-1252; the five unassigned bytes keep their C1 code points as Windows does
+static const uint16_t westernTable[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+
+typedef struct DecoderCache {
+    int codePage;
+    iconv_t descriptor;
+} DecoderCache;
+
+static _Thread_local DecoderCache decoderCache = { 0, (iconv_t)-1 };
+
+bool isSupportedCodePage(int codePage) {
+    switch (codePage) {
+        case CODE_PAGE_SHIFT_JIS:
+        case CODE_PAGE_GBK:
+        case CODE_PAGE_KOREAN:
+        case CODE_PAGE_BIG5:
+        case CODE_PAGE_WESTERN:
+        case CODE_PAGE_UTF8: {
+            return true;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+int parseCodePage(const char *text) {
+    if (strcasecmp(text, "utf8") == 0 || strcasecmp(text, "utf-8") == 0) {
+        return CODE_PAGE_UTF8;
+    }
+
+    if (strcasecmp(text, "sjis") == 0 || strcasecmp(text, "shift-jis") == 0) {
+        return CODE_PAGE_SHIFT_JIS;
+    }
+
+    if (strcasecmp(text, "gbk") == 0) {
+        return CODE_PAGE_GBK;
+    }
+
+    const int codePage = atoi(text);
+    return isSupportedCodePage(codePage) ? codePage : -1;
+}
+
+const char *getIconvName(int codePage) {
+    switch (codePage) {
+        case CODE_PAGE_SHIFT_JIS: {
+            return "CP932";
+        }
+        case CODE_PAGE_GBK: {
+            return "GBK";
+        }
+        case CODE_PAGE_KOREAN: {
+            return "CP949";
+        }
+        case CODE_PAGE_BIG5: {
+            return "BIG5";
+        }
+        default: {
+            return NULL;
+        }
+    }
+}
+
+bool isLeadByte(int codePage, unsigned char c) {
+    if (codePage == CODE_PAGE_SHIFT_JIS) {
+        return (c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC);
+    }
+
+    return (c >= 0x81 && c <= 0xFE);
+}
+
+// Index of the first byte >= 0x80, or length; sixteen bytes per step where SSE2 is available.
+long findNonAscii(const char *data, long length) {
+    long i = 0;
+
+#ifdef __SSE2__
+    for (; i + 16 <= length; i += 16) {
+        const int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)&data[i]));
+
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, &data[i], sizeof(word));
+
+        if (word & 0x8080808080808080ULL) {
+            break;
+        }
+    }
+
+    while (i < length && (unsigned char)data[i] < 0x80) {
+        i++;
+    }
+
+    return i;
+}
+
+// Whether data is well-formed UTF-8: no stray trail bytes, overlong forms, surrogates or code points past
+// U+10FFFF. Text in a legacy code page almost never is, since a lead byte there is rarely followed by the
+// right number of bytes from 0x80-0xBF.
+bool isValidUtf8(const char *data, long length) {
+    long i = findNonAscii(data, length);
+
+    while (i < length) {
+        const unsigned char c = data[i];
+        const int trailCount = (c >= 0xC2 && c <= 0xDF) ? 1 : (c >= 0xE0 && c <= 0xEF) ? 2 : (c >= 0xF0 && c <= 0xF4) ? 3 : -1;
+
+        if (trailCount < 0 || i + trailCount >= length) {
+            return false;
+        }
+
+        const unsigned char second = data[i + 1];
+        const unsigned char low = (c == 0xE0) ? 0xA0 : (c == 0xF0) ? 0x90 : 0x80;
+        const unsigned char high = (c == 0xED) ? 0x9F : (c == 0xF4) ? 0x8F : 0xBF;
+
+        if (second < low || second > high) {
+            return false;
+        }
+
+        for (int j = 2; j <= trailCount; j++) {
+            if (((unsigned char)data[i + j] & 0xC0) != 0x80) {
+                return false;
+            }
+        }
+
+        i += trailCount + 1;
+        i += findNonAscii(&data[i], length - i);
+    }
+
+    return true;
+}
+
+int encodeUtf8(char *output, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        output[0] = codePoint;
+        return 1;
+    }
+
+    if (codePoint < 0x800) {
+        output[0] = 0xC0 | (codePoint >> 6);
+        output[1] = 0x80 | (codePoint & 0x3F);
+        return 2;
+    }
+
+    output[0] = 0xE0 | (codePoint >> 12);
+    output[1] = 0x80 | ((codePoint >> 6) & 0x3F);
+    output[2] = 0x80 | (codePoint & 0x3F);
+    return 3;
+}
+
+long decodeWesternRun(const char *data, long length, char *output, long *outputLength) {
+    long i = 0;
+
+    for (; i < length && (unsigned char)data[i] >= 0x80; i++) {
+        const unsigned char c = data[i];
+        *outputLength += encodeUtf8(&output[*outputLength], (c < 0xA0) ? westernTable[c - 0x80] : c);
+    }
+
+    return i;
+}
+
+iconv_t getDecoder(int codePage) {
+    if (decoderCache.codePage != codePage) {
+        if (decoderCache.descriptor != (iconv_t)-1) {
+            iconv_close(decoderCache.descriptor);
+        }
+
+        decoderCache.codePage = codePage;
+        decoderCache.descriptor = iconv_open("UTF-8", getIconvName(codePage));
+    }
+
+    return decoderCache.descriptor;
+}
+
+// A run of double-byte text: lead bytes take their trail byte with them even when it is in the ASCII range.
+long decodeDoubleByteRun(const char *data, long length, int codePage, char *output, long *outputLength) {
+    long run = 0;
+
+    while (run < length && (unsigned char)data[run] >= 0x80) {
+        run += (isLeadByte(codePage, data[run]) && run + 1 < length) ? 2 : 1;
+    }
+
+    iconv_t descriptor = getDecoder(codePage);
+    char *input = (char*)data;
+    size_t inputLeft = run;
+    char *target = &output[*outputLength];
+    size_t targetLeft = run * 3;
+
+    iconv(descriptor, NULL, NULL, NULL, NULL);
+
+    while (inputLeft > 0) {
+        if (iconv(descriptor, &input, &inputLeft, &target, &targetLeft) != (size_t)-1) {
+            break;
+        }
+
+        // an unmappable byte becomes U+FFFD and decoding resumes after it
+        target += encodeUtf8(target, 0xFFFD);
+        targetLeft -= 3;
+        input++;
+        inputLeft--;
+        iconv(descriptor, NULL, NULL, NULL, NULL);
+    }
+
+    *outputLength = target - output;
+    return run;
+}
+
+// Returns UTF-8 text. Pure-ASCII and UTF-8 sources come back as the same buffer, less any byte order mark;
+// otherwise source is freed. A file that is already UTF-8, by its mark or because it is well-formed as
+// such, is taken as it is whatever the code page, which only decodes the rest.
+char *decodeSource(char *source, long length, int codePage, long *decodedLength) {
+    if (length >= 3 && memcmp(source, "\xEF\xBB\xBF", 3) == 0) {
+        length -= 3;
+        memmove(source, &source[3], length + 1);
+        codePage = CODE_PAGE_UTF8;
+    }
+
+    long pos = findNonAscii(source, length);
+    *decodedLength = length;
+
+    if (pos == length || codePage == CODE_PAGE_UTF8 || isValidUtf8(&source[pos], length - pos)) {
+        return source;
+    }
+
+    if (getIconvName(codePage) != NULL && getDecoder(codePage) == (iconv_t)-1) {
+        reportDiagnostic(DIAGNOSTIC_CODE_PAGE_UNAVAILABLE, -1, "code page %d is not available", codePage);
+        return source;
+    }
+
+    char *output = malloc(length * 3 + 1);
+    long outputLength = pos;
+    memcpy(output, source, pos);
+
+    while (pos < length) {
+        if (codePage == CODE_PAGE_WESTERN) {
+            pos += decodeWesternRun(&source[pos], length - pos, output, &outputLength);
+        }
+        else {
+            pos += decodeDoubleByteRun(&source[pos], length - pos, codePage, output, &outputLength);
+        }
+
+        const long span = findNonAscii(&source[pos], length - pos);
+        memcpy(&output[outputLength], &source[pos], span);
+        outputLength += span;
+        pos += span;
+    }
+
+    output[outputLength] = '\0';
+    *decodedLength = outputLength;
+
+    free(source);
+    return output;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "diagnostics.h"
+#include "util.h"
+
+enum CodePage {
+    CODE_PAGE_SHIFT_JIS = 932,
+    CODE_PAGE_GBK = 936,
+    CODE_PAGE_KOREAN = 949,
+    CODE_PAGE_BIG5 = 950,
+    CODE_PAGE_WESTERN = 1252,
+    CODE_PAGE_UTF8 = 65001
+};
+
+#define DEFAULT_CODE_PAGE CODE_PAGE_WESTERN
+
+bool isSupportedCodePage(int codePage);
+int parseCodePage(const char *text);
+long findNonAscii(const char *data, long length);
+bool isValidUtf8(const char *data, long length);
+char *decodeSource(char *source, long length, int codePage, long *decodedLength);
\ No newline at end of file
@@ -0,0 +1,260 @@
+#include "decode.h"
+#include "diagnostics.h"
+
+static const char *const codeNames[DIAGNOSTIC_CODE_COUNT] = {
+    "read-failed",
+    "code-page-unavailable",
+    "invalid-character",
+    "unterminated-string",
+    "invalid-token",
+    "invalid-directive",
+    "unbalanced-directive",
+    "syntax-error",
+    "budget-exceeded",
+    "output-failed",
+    "worker-crashed",
+    "unsupported-construct",
+    "type-library-ignored"
+};
+
+static _Atomic(DiagnosticBuffer*) diagnosticBuffers;
+static atomic_long diagnosticSequence;
+static _Thread_local DiagnosticBuffer *diagnosticBuffer;
+static _Thread_local int diagnosticFile = -1;
+
+void setDiagnosticFile(int fileIndex) {
+    diagnosticFile = fileIndex;
+}
+
+int getDiagnosticFile() {
+    return diagnosticFile;
+}
+
+DiagnosticBuffer *getDiagnosticBuffer() {
+    if (diagnosticBuffer == NULL) {
+        DiagnosticBuffer *buffer = calloc(1, sizeof(DiagnosticBuffer));
+        buffer->next = atomic_load(&diagnosticBuffers);
+
+        while (!atomic_compare_exchange_weak(&diagnosticBuffers, &buffer->next, buffer)) {
+        }
+
+        diagnosticBuffer = buffer;
+    }
+
+    return diagnosticBuffer;
+}
+
+void recordDiagnostic(int fileIndex, long offset, int severity, int code, const char *message) {
+    DiagnosticBuffer *buffer = getDiagnosticBuffer();
+
+    if (buffer->size == buffer->capacity) {
+        buffer->capacity = (buffer->capacity > 0) ? buffer->capacity * 2 : 16;
+        buffer->diagnostics = realloc(buffer->diagnostics, sizeof(Diagnostic) * buffer->capacity);
+    }
+
+    Diagnostic *diagnostic = &buffer->diagnostics[buffer->size++];
+    diagnostic->fileIndex = fileIndex;
+    diagnostic->offset = offset;
+    diagnostic->severity = severity;
+    diagnostic->code = code;
+    diagnostic->sequence = atomic_fetch_add(&diagnosticSequence, 1);
+    diagnostic->message = strdup(message);
+}
+
+// An error against the file the calling thread is working on.
+void reportDiagnostic(int code, long offset, const char *format, ...) {
+    char message[512];
+    va_list arguments;
+
+    va_start(arguments, format);
+    vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+
+    recordDiagnostic(diagnosticFile, offset, DIAGNOSTIC_ERROR, code, message);
+}
+
+// Something the file's C# does not carry over exactly, though the file still transpiles.
+void reportWarning(int code, long offset, const char *format, ...) {
+    char message[512];
+    va_list arguments;
+
+    va_start(arguments, format);
+    vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+
+    recordDiagnostic(diagnosticFile, offset, DIAGNOSTIC_WARNING, code, message);
+}
+
+int compareDiagnostics(const void *left, const void *right) {
+    const Diagnostic *a = *(Diagnostic *const *)left;
+    const Diagnostic *b = *(Diagnostic *const *)right;
+
+    if (a->fileIndex != b->fileIndex) {
+        return (a->fileIndex < b->fileIndex) ? -1 : 1;
+    }
+
+    if (a->offset != b->offset) {
+        return (a->offset < b->offset) ? -1 : 1;
+    }
+
+    return (a->sequence < b->sequence) ? -1 : (a->sequence > b->sequence);
+}
+
+// Takes everything recorded so far, ordered by file, offset and report order. No thread may be reporting meanwhile.
+Vector *collectDiagnostics() {
+    Vector *diagnostics = buildVectorList();
+
+    for (DiagnosticBuffer *buffer = atomic_load(&diagnosticBuffers); buffer != NULL; buffer = buffer->next) {
+        for (int i = 0; i < buffer->size; i++) {
+            Diagnostic *diagnostic = malloc(sizeof(Diagnostic));
+            *diagnostic = buffer->diagnostics[i];
+            pushVector(diagnostics, diagnostic);
+        }
+
+        buffer->size = 0;
+    }
+
+    qsort(diagnostics->contents, diagnostics->size, sizeof(Diagnostic*), compareDiagnostics);
+    return diagnostics;
+}
+
+void freeDiagnostics(Vector *diagnostics) {
+    for (int i = 0; i < diagnostics->size; i++) {
+        Diagnostic *diagnostic = diagnostics->contents[i];
+        free(diagnostic->message);
+        free(diagnostic);
+    }
+
+    free(diagnostics->contents);
+    free(diagnostics);
+}
+
+const char *getDiagnosticCodeName(int code) {
+    return (code >= 0 && code < DIAGNOSTIC_CODE_COUNT) ? codeNames[code] : "unknown";
+}
+
+int parseDiagnosticFormat(const char *text) {
+    if (strcmp(text, "text") == 0) {
+        return DIAGNOSTIC_FORMAT_TEXT;
+    }
+
+    if (strcmp(text, "json") == 0) {
+        return DIAGNOSTIC_FORMAT_JSON;
+    }
+
+    return -1;
+}
+
+void printJsonString(const char *text) {
+    putchar('"');
+
+    for (const unsigned char *p = (const unsigned char*)text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            printf("\\%c", *p);
+        }
+        else if (*p < 0x20) {
+            printf("\\u%04x", *p);
+        }
+        else {
+            putchar(*p);
+        }
+    }
+
+    putchar('"');
+}
+
+// Line and column are only worked out here, from a fresh read of the few files that have diagnostics.
+void locateOffset(const char *source, long length, long offset, int *line, int *column) {
+    *line = 1;
+    *column = 1;
+
+    for (long i = 0; i < offset && i < length; i++) {
+        if (source[i] == '\n') {
+            (*line)++;
+            *column = 1;
+        }
+        else {
+            (*column)++;
+        }
+    }
+}
+
+void printDiagnostics(const Project *project, const Vector *diagnostics, int format) {
+    char *source = NULL;
+    long length = 0;
+    int sourceIndex = -1;
+
+    if (format == DIAGNOSTIC_FORMAT_JSON) {
+        printf("[");
+    }
+
+    for (int i = 0; i < diagnostics->size; i++) {
+        const Diagnostic *diagnostic = diagnostics->contents[i];
+        const ProjectFile *file = (diagnostic->fileIndex >= 0) ? getProjectFile(project, diagnostic->fileIndex) : NULL;
+        const char *path = (file != NULL) ? file->path : project->path;
+        int line = 0, column = 0;
+
+        if (file != NULL && diagnostic->offset >= 0) {
+            if (sourceIndex != diagnostic->fileIndex) {
+                free(source);
+                source = readFile(file->path);
+                length = 0;
+                sourceIndex = diagnostic->fileIndex;
+
+                if (source != NULL) {
+                    source = decodeSource(source, strlen(source), project->codePage, &length);
+                }
+            }
+
+            locateOffset((source != NULL) ? source : "", length, diagnostic->offset, &line, &column);
+        }
+
+        if (format == DIAGNOSTIC_FORMAT_JSON) {
+            printf("%s\n  {\"file\": ", (i > 0) ? "," : "");
+            printJsonString((path != NULL) ? path : "");
+            printf(", \"offset\": %ld, \"line\": %d, \"column\": %d, \"severity\": \"%s\", \"code\": \"%s\", \"message\": ",
+                diagnostic->offset,
+                line,
+                column,
+                (diagnostic->severity == DIAGNOSTIC_ERROR) ? "error" : "warning",
+                getDiagnosticCodeName(diagnostic->code));
+            printJsonString(diagnostic->message);
+            printf("}");
+        }
+        else if (line > 0) {
+            printf("%s:%d:%d: %s: %s [%s]\n",
+                path,
+                line,
+                column,
+                (diagnostic->severity == DIAGNOSTIC_ERROR) ? "error" : "warning",
+                diagnostic->message,
+                getDiagnosticCodeName(diagnostic->code));
+        }
+        else {
+            printf("%s: %s: %s [%s]\n",
+                (path != NULL) ? path : "",
+                (diagnostic->severity == DIAGNOSTIC_ERROR) ? "error" : "warning",
+                diagnostic->message,
+                getDiagnosticCodeName(diagnostic->code));
+        }
+    }
+
+    if (format == DIAGNOSTIC_FORMAT_JSON) {
+        printf("%s]\n", (diagnostics->size > 0) ? "\n" : "");
+    }
+
+    free(source);
+}
+
+// Prints and drops everything recorded so far; once per run, after the workers are idle.
+int flushDiagnostics(const Project *project, int format) {
+    Vector *diagnostics = collectDiagnostics();
+    const int count = diagnostics->size;
+
+    if (count > 0 || format == DIAGNOSTIC_FORMAT_JSON) {
+        printDiagnostics(project, diagnostics, format);
+    }
+
+    freeDiagnostics(diagnostics);
+    return count;
+}
\ No newline at end of file
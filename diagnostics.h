@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "project.h"
+
+enum DiagnosticSeverity {
+    DIAGNOSTIC_ERROR,
+    DIAGNOSTIC_WARNING
+};
+
+enum DiagnosticCode {
+    DIAGNOSTIC_READ_FAILED,
+    DIAGNOSTIC_CODE_PAGE_UNAVAILABLE,
+    DIAGNOSTIC_INVALID_CHARACTER,
+    DIAGNOSTIC_UNTERMINATED_STRING,
+    DIAGNOSTIC_INVALID_TOKEN,
+    DIAGNOSTIC_INVALID_DIRECTIVE,
+    DIAGNOSTIC_UNBALANCED_DIRECTIVE,
+    DIAGNOSTIC_SYNTAX_ERROR,
+    DIAGNOSTIC_BUDGET_EXCEEDED,
+    DIAGNOSTIC_OUTPUT_FAILED,
+    DIAGNOSTIC_WORKER_CRASHED,
+    DIAGNOSTIC_UNSUPPORTED_CONSTRUCT,
+    DIAGNOSTIC_TYPE_LIBRARY_IGNORED,
+    DIAGNOSTIC_CODE_COUNT
+};
+
+enum DiagnosticFormat {
+    DIAGNOSTIC_FORMAT_TEXT,
+    DIAGNOSTIC_FORMAT_JSON
+};
+
+// offset is a byte offset into the decoded (UTF-8) source, or -1 when the diagnostic is about the whole file
+typedef struct Diagnostic {
+    int fileIndex;
+    long offset;
+    int severity;
+    int code;
+    long sequence;
+    char *message;
+} Diagnostic;
+
+// Each thread appends to its own buffer without locking; buffers are chained once, on a thread's first diagnostic.
+typedef struct DiagnosticBuffer {
+    Diagnostic *diagnostics;
+    int size;
+    int capacity;
+    struct DiagnosticBuffer *next;
+} DiagnosticBuffer;
+
+void setDiagnosticFile(int fileIndex);
+int getDiagnosticFile();
+void reportDiagnostic(int code, long offset, const char *format, ...);
+void reportWarning(int code, long offset, const char *format, ...);
+void recordDiagnostic(int fileIndex, long offset, int severity, int code, const char *message);
+Vector *collectDiagnostics();
+void freeDiagnostics(Vector *diagnostics);
+const char *getDiagnosticCodeName(int code);
+int parseDiagnosticFormat(const char *text);
+void printDiagnostics(const Project *project, const Vector *diagnostics, int format);
+int flushDiagnostics(const Project *project, int format);
\ No newline at end of file
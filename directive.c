@@ -0,0 +1,509 @@
+#include <strings.h>
+
+#include "directive.h"
+
+typedef struct DirectiveParser {
+    const char *p;
+    ConditionalState *state;
+    bool failed;
+} DirectiveParser;
+
+int evaluateOr(DirectiveParser *parser);
+
+void initializeConditionalState(ConditionalState *state, StringIntegerMap *defines) {
+    state->depth = 0;
+    state->constants = NULL;
+    state->defines = defines;
+}
+
+void finishConditionalState(ConditionalState *state) {
+    if (state->constants != NULL) {
+        freeStringIntegerMap(state->constants);
+        state->constants = NULL;
+    }
+}
+
+bool isConditionActive(const ConditionalState *state) {
+    return (state->depth == 0 || state->frames[state->depth - 1].active);
+}
+
+// conditional constants are case-insensitive like every other VB name
+void foldDefineName(char *name) {
+    for (; *name; name++) {
+        *name = tolower((unsigned char)*name);
+    }
+}
+
+bool isDirectiveStart(const char *p, int pos) {
+    while (pos > 0 && (p[pos - 1] == ' ' || p[pos - 1] == '\t')) {
+        pos--;
+    }
+
+    return (pos == 0 || p[pos - 1] == '\n');
+}
+
+// Lines of an inactive branch are never tokenized: each one costs a memchr for its newline.
+int skipInactiveLines(const char *p, int pos, long length) {
+    while (pos < length) {
+        int start = pos;
+
+        while (p[start] == ' ' || p[start] == '\t') {
+            start++;
+        }
+
+        if (p[start] == '#') {
+            return start;
+        }
+
+        const char *newline = memchr(&p[start], '\n', length - start);
+
+        if (newline == NULL) {
+            return length;
+        }
+
+        pos = newline - p + 1;
+    }
+
+    return length;
+}
+
+void skipDirectiveSpace(DirectiveParser *parser) {
+    while (*parser->p == ' ' || *parser->p == '\t') {
+        parser->p++;
+    }
+}
+
+bool matchDirectiveWord(DirectiveParser *parser, const char *word) {
+    const int length = strlen(word);
+
+    skipDirectiveSpace(parser);
+
+    if (strncasecmp(parser->p, word, length) != 0 || isalnum((unsigned char)parser->p[length]) || parser->p[length] == '_') {
+        return false;
+    }
+
+    parser->p += length;
+    return true;
+}
+
+bool matchDirectiveSymbol(DirectiveParser *parser, const char *symbol) {
+    const int length = strlen(symbol);
+
+    skipDirectiveSpace(parser);
+
+    if (strncmp(parser->p, symbol, length) != 0) {
+        return false;
+    }
+
+    parser->p += length;
+    return true;
+}
+
+// the compiler constants VB6 itself defines, folded; a project or -D value of the same name wins
+typedef struct IntrinsicConstant {
+    const char *name;
+    int value;
+} IntrinsicConstant;
+
+const IntrinsicConstant intrinsicConstants[] = {
+    { "win32", -1 },
+    { "win16", 0 },
+    { "vba6", -1 }
+};
+
+int lookupDirectiveConstant(ConditionalState *state, char *name) {
+    foldDefineName(name);
+
+    if (state->constants != NULL && stringIntegerMapContains(state->constants, name)) {
+        return getIntegerMap(state->constants, name);
+    }
+
+    if (state->defines != NULL && stringIntegerMapContains(state->defines, name)) {
+        return getIntegerMap(state->defines, name);
+    }
+
+    for (size_t i = 0; i < sizeof(intrinsicConstants) / sizeof(intrinsicConstants[0]); i++) {
+        if (strcmp(intrinsicConstants[i].name, name) == 0) {
+            return intrinsicConstants[i].value;
+        }
+    }
+
+    // an undefined constant is Empty, which compares as 0
+    return 0;
+}
+
+int evaluatePrimary(DirectiveParser *parser) {
+    skipDirectiveSpace(parser);
+
+    if (matchDirectiveSymbol(parser, "(")) {
+        const int value = evaluateOr(parser);
+
+        if (!matchDirectiveSymbol(parser, ")")) {
+            parser->failed = true;
+        }
+
+        return value;
+    }
+
+    if (matchDirectiveWord(parser, "True")) {
+        return -1;
+    }
+
+    if (matchDirectiveWord(parser, "False")) {
+        return 0;
+    }
+
+    if (parser->p[0] == '&' && (parser->p[1] == 'H' || parser->p[1] == 'h')) {
+        char *end;
+        const int value = strtol(parser->p + 2, &end, 16);
+        parser->failed |= (end == parser->p + 2);
+        parser->p = (*end == '&') ? end + 1 : end;
+        return value;
+    }
+
+    if (isdigit((unsigned char)*parser->p)) {
+        char *end;
+        const int value = strtol(parser->p, &end, 10);
+        parser->p = (*end == '&' || *end == '%') ? end + 1 : end;
+        return value;
+    }
+
+    if (isalpha((unsigned char)*parser->p) || *parser->p == '_') {
+        int len = 0;
+        char name[256];
+
+        while ((isalnum((unsigned char)parser->p[len]) || parser->p[len] == '_') && len < (int)sizeof(name) - 1) {
+            name[len] = parser->p[len];
+            len++;
+        }
+
+        name[len] = '\0';
+        parser->p += len;
+
+        return lookupDirectiveConstant(parser->state, name);
+    }
+
+    parser->failed = true;
+    return 0;
+}
+
+int evaluateUnary(DirectiveParser *parser) {
+    if (matchDirectiveSymbol(parser, "-")) {
+        return -evaluateUnary(parser);
+    }
+
+    if (matchDirectiveSymbol(parser, "+")) {
+        return evaluateUnary(parser);
+    }
+
+    return evaluatePrimary(parser);
+}
+
+int evaluateMultiplicative(DirectiveParser *parser) {
+    int value = evaluateUnary(parser);
+
+    while (!parser->failed) {
+        if (matchDirectiveSymbol(parser, "*")) {
+            value *= evaluateUnary(parser);
+        }
+        else if (matchDirectiveSymbol(parser, "/") || matchDirectiveSymbol(parser, "\\")) {
+            const int divisor = evaluateUnary(parser);
+
+            if (divisor == 0) {
+                parser->failed = true;
+                return 0;
+            }
+
+            value /= divisor;
+        }
+        else if (matchDirectiveWord(parser, "Mod")) {
+            const int divisor = evaluateUnary(parser);
+
+            if (divisor == 0) {
+                parser->failed = true;
+                return 0;
+            }
+
+            value %= divisor;
+        }
+        else {
+            break;
+        }
+    }
+
+    return value;
+}
+
+int evaluateAdditive(DirectiveParser *parser) {
+    int value = evaluateMultiplicative(parser);
+
+    while (!parser->failed) {
+        if (matchDirectiveSymbol(parser, "+")) {
+            value += evaluateMultiplicative(parser);
+        }
+        else if (matchDirectiveSymbol(parser, "-")) {
+            value -= evaluateMultiplicative(parser);
+        }
+        else {
+            break;
+        }
+    }
+
+    return value;
+}
+
+// VB comparisons yield True (-1) or False (0)
+int evaluateComparison(DirectiveParser *parser) {
+    int value = evaluateAdditive(parser);
+
+    while (!parser->failed) {
+        if (matchDirectiveSymbol(parser, "<>")) {
+            value = -(value != evaluateAdditive(parser));
+        }
+        else if (matchDirectiveSymbol(parser, "<=")) {
+            value = -(value <= evaluateAdditive(parser));
+        }
+        else if (matchDirectiveSymbol(parser, ">=")) {
+            value = -(value >= evaluateAdditive(parser));
+        }
+        else if (matchDirectiveSymbol(parser, "<")) {
+            value = -(value < evaluateAdditive(parser));
+        }
+        else if (matchDirectiveSymbol(parser, ">")) {
+            value = -(value > evaluateAdditive(parser));
+        }
+        else if (matchDirectiveSymbol(parser, "=")) {
+            value = -(value == evaluateAdditive(parser));
+        }
+        else {
+            break;
+        }
+    }
+
+    return value;
+}
+
+int evaluateNot(DirectiveParser *parser) {
+    if (matchDirectiveWord(parser, "Not")) {
+        return ~evaluateNot(parser);
+    }
+
+    return evaluateComparison(parser);
+}
+
+int evaluateAnd(DirectiveParser *parser) {
+    int value = evaluateNot(parser);
+
+    while (!parser->failed && matchDirectiveWord(parser, "And")) {
+        value &= evaluateNot(parser);
+    }
+
+    return value;
+}
+
+int evaluateOr(DirectiveParser *parser) {
+    int value = evaluateAnd(parser);
+
+    while (!parser->failed) {
+        if (matchDirectiveWord(parser, "Or")) {
+            value |= evaluateAnd(parser);
+        }
+        else if (matchDirectiveWord(parser, "Xor")) {
+            value ^= evaluateAnd(parser);
+        }
+        else {
+            break;
+        }
+    }
+
+    return value;
+}
+
+bool evaluateDirectiveExpression(const char *text, ConditionalState *state, int *value) {
+    DirectiveParser parser = { text, state, false };
+
+    *value = evaluateOr(&parser);
+    matchDirectiveWord(&parser, "Then");
+    skipDirectiveSpace(&parser);
+
+    return (!parser.failed && *parser.p == '\0');
+}
+
+char *copyDirectiveLine(const char *p, int *pos) {
+    int len = 0;
+    bool inString = false;
+
+    while (p[*pos + len] != '\0' && p[*pos + len] != '\n') {
+        len++;
+    }
+
+    char *line = strndup(&p[*pos], len);
+    *pos += len;
+
+    for (int i = 0; i < len; i++) {
+        if (line[i] == '"') {
+            inString = !inString;
+        }
+        else if ((line[i] == '\'' && !inString) || line[i] == '\r') {
+            line[i] = '\0';
+            break;
+        }
+    }
+
+    return line;
+}
+
+bool defineDirectiveConstant(ConditionalState *state, const char *text) {
+    DirectiveParser parser = { text, state, false };
+    char name[256];
+    int len = 0;
+
+    skipDirectiveSpace(&parser);
+
+    while ((isalnum((unsigned char)parser.p[len]) || parser.p[len] == '_') && len < (int)sizeof(name) - 1) {
+        name[len] = parser.p[len];
+        len++;
+    }
+
+    name[len] = '\0';
+    parser.p += len;
+
+    if (len == 0 || !matchDirectiveSymbol(&parser, "=")) {
+        return false;
+    }
+
+    int value = 0;
+
+    if (!evaluateDirectiveExpression(parser.p, state, &value)) {
+        return false;
+    }
+
+    if (state->constants == NULL) {
+        state->constants = buildStringIntegerMap(16);
+    }
+
+    foldDefineName(name);
+    setStringIntegerMap(state->constants, name, value);
+    return true;
+}
+
+// Handles one #If/#ElseIf/#Else/#End If/#Const line starting at the '#'; *pos is left at its newline.
+bool readDirective(const char *p, int *pos, ConditionalState *state) {
+    const int start = *pos;
+    char *line = copyDirectiveLine(p, pos);
+    DirectiveParser parser = { line + 1, state, false };
+    const bool active = isConditionActive(state);
+    bool succeeded = true;
+    int value = 0;
+
+    if (matchDirectiveWord(&parser, "If")) {
+        if (state->depth == MAX_CONDITIONAL_DEPTH) {
+            reportDiagnostic(DIAGNOSTIC_UNBALANCED_DIRECTIVE, start, "#If nested deeper than %d", MAX_CONDITIONAL_DEPTH);
+            free(line);
+            return false;
+        }
+
+        ConditionalFrame *frame = &state->frames[state->depth++];
+        frame->parentActive = active;
+        succeeded = !active || evaluateDirectiveExpression(parser.p, state, &value);
+        frame->active = active && value != 0;
+        frame->taken = frame->active;
+    }
+    else if (matchDirectiveWord(&parser, "ElseIf")) {
+        if (state->depth == 0) {
+            reportDiagnostic(DIAGNOSTIC_UNBALANCED_DIRECTIVE, start, "#ElseIf without #If");
+            free(line);
+            return false;
+        }
+
+        ConditionalFrame *frame = &state->frames[state->depth - 1];
+
+        if (frame->parentActive && !frame->taken) {
+            succeeded = evaluateDirectiveExpression(parser.p, state, &value);
+            frame->active = (value != 0);
+            frame->taken = frame->active;
+        }
+        else {
+            frame->active = false;
+        }
+    }
+    else if (matchDirectiveWord(&parser, "Else")) {
+        if (state->depth == 0) {
+            reportDiagnostic(DIAGNOSTIC_UNBALANCED_DIRECTIVE, start, "#Else without #If");
+            free(line);
+            return false;
+        }
+
+        ConditionalFrame *frame = &state->frames[state->depth - 1];
+        frame->active = frame->parentActive && !frame->taken;
+        frame->taken = true;
+    }
+    else if (matchDirectiveWord(&parser, "End")) {
+        if (!matchDirectiveWord(&parser, "If") || state->depth == 0) {
+            reportDiagnostic(DIAGNOSTIC_UNBALANCED_DIRECTIVE, start, "#End If without #If");
+            free(line);
+            return false;
+        }
+
+        state->depth--;
+    }
+    else if (matchDirectiveWord(&parser, "Const")) {
+        succeeded = !active || defineDirectiveConstant(state, parser.p);
+    }
+    else {
+        succeeded = false;
+    }
+
+    if (!succeeded) {
+        reportDiagnostic(DIAGNOSTIC_INVALID_DIRECTIVE, start, "invalid directive \"%s\"", line);
+    }
+
+    free(line);
+    return succeeded;
+}
+
+// "NAME", "NAME=value" or a CondComp list "A = 1 : B = 0"; a bare NAME is True, -1 as in VB
+bool parseConditionalDefine(StringIntegerMap *defines, const char *text) {
+    char *copy = strdup(text);
+    char *savePointer = NULL;
+    bool succeeded = true;
+    ConditionalState state;
+
+    initializeConditionalState(&state, defines);
+
+    for (char *item = strtok_r(copy, ":", &savePointer); item != NULL; item = strtok_r(NULL, ":", &savePointer)) {
+        char name[256];
+        int len = 0;
+
+        while (*item == ' ' || *item == '\t') {
+            item++;
+        }
+
+        while ((isalnum((unsigned char)item[len]) || item[len] == '_') && len < (int)sizeof(name) - 1) {
+            name[len] = item[len];
+            len++;
+        }
+
+        name[len] = '\0';
+
+        const char *rest = &item[len];
+
+        while (*rest == ' ' || *rest == '\t') {
+            rest++;
+        }
+
+        int value = -1;
+
+        if (len == 0 || (*rest != '\0' && (*rest != '=' || !evaluateDirectiveExpression(rest + 1, &state, &value)))) {
+            printf("error: invalid conditional constant \"%s\".\n", item);
+            succeeded = false;
+            continue;
+        }
+
+        foldDefineName(name);
+        setStringIntegerMap(defines, name, value);
+    }
+
+    free(copy);
+    return succeeded;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "diagnostics.h"
+#include "util.h"
+
+#define MAX_CONDITIONAL_DEPTH 64
+
+typedef struct ConditionalFrame {
+    bool parentActive;
+    bool active;
+    bool taken;
+} ConditionalFrame;
+
+// #If nesting for one file; #Const values live in constants, project/-D values in defines
+typedef struct ConditionalState {
+    int depth;
+    ConditionalFrame frames[MAX_CONDITIONAL_DEPTH];
+    StringIntegerMap *constants;
+    StringIntegerMap *defines;
+} ConditionalState;
+
+void initializeConditionalState(ConditionalState *state, StringIntegerMap *defines);
+void finishConditionalState(ConditionalState *state);
+bool isConditionActive(const ConditionalState *state);
+bool isDirectiveStart(const char *p, int pos);
+bool readDirective(const char *p, int *pos, ConditionalState *state);
+int skipInactiveLines(const char *p, int pos, long length);
+bool evaluateDirectiveExpression(const char *text, ConditionalState *state, int *value);
+bool parseConditionalDefine(StringIntegerMap *defines, const char *text);
+void foldDefineName(char *name);
\ No newline at end of file
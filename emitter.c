@@ -0,0 +1,3006 @@
+#include "emitter.h"
+
+void emitCastExpression(Emitter *emitter, const CastExpressionNode *castExpressionNode);
+void emitConditionalExpression(Emitter *emitter, const ConditionalExpressionNode *conditionalExpressionNode);
+void emitResultDeclaration(Emitter *emitter);
+void emitResultReturn(Emitter *emitter);
+const TypeSpecifierNode *findDeclaredType(Emitter *emitter, const char *name);
+void emitLoopCopyBack(Emitter *emitter, int firstBuilder, int firstArray);
+int getArrayLowerBound(Emitter *emitter, const char *name);
+int getArrayRank(Emitter *emitter, const char *name);
+
+Emitter *buildEmitter(const ProjectFile *file, const char *namespaceName) {
+    Emitter *emitter = calloc(1, sizeof(Emitter));
+    emitter->output = buildOutputBuffer();
+    emitter->file = file;
+    emitter->namespaceName = namespaceName;
+    emitter->symbols = (file->project != NULL) ? file->project->symbols : NULL;
+    emitter->isStatic = (file->type == PROJECT_MODULE);
+    emitter->accumulators = buildVectorList();
+    emitter->growableArrays = buildVectorList();
+    emitter->breakTargets = buildVectorList();
+    emitter->memberDeclarations = buildVectorList();
+
+    return emitter;
+}
+
+void freeEmitter(Emitter *emitter) {
+    freeOutputBuffer(emitter->output);
+    free(emitter->accumulators->contents);
+    free(emitter->accumulators);
+    free(emitter->growableArrays->contents);
+    free(emitter->growableArrays);
+    free(emitter->breakTargets->contents);
+    free(emitter->breakTargets);
+    free(emitter->memberDeclarations->contents);
+    free(emitter->memberDeclarations);
+    free(emitter);
+}
+
+// VB's own Collection is the runtime's late-bound shim; other classes keep their names
+const char *getCSharpClassName(const char *name) {
+    return (strcasecmp(name, "Collection") == 0 || strcasecmp(name, "VBA.Collection") == 0) ? "Microsoft.VisualBasic.Collection" : name;
+}
+
+const char *getCSharpTypeName(const TypeSpecifierNode *typeSpecifierNode) {
+    if (typeSpecifierNode == NULL) {
+        return "object";
+    }
+
+    switch (typeSpecifierNode->typeSpecifier) {
+        case TYPE_UI0: {
+            return "void";
+        }
+        case TYPE_SC8: {
+            return "string";
+        }
+        case TYPE_SI32: {
+            return (typeSpecifierNode->numericType == NUMERIC_INTEGER) ? "short" : (typeSpecifierNode->numericType == NUMERIC_BYTE) ? "byte" : "int";
+        }
+        case TYPE_FP64: {
+            return (typeSpecifierNode->numericType == NUMERIC_SINGLE) ? "float" : (typeSpecifierNode->numericType == NUMERIC_DECIMAL) ? "decimal" : "double";
+        }
+        case TYPE_B8: {
+            return "bool";
+        }
+        case TYPE_FLOCK:
+        case TYPE_GAGGLE:
+        case TYPENAME: {
+            if (typeSpecifierNode->flockName != NULL) {
+                return getCSharpClassName(typeSpecifierNode->flockName);
+            }
+
+            if (typeSpecifierNode->flockSpecifierNode != NULL && typeSpecifierNode->flockSpecifierNode->identifier != NULL) {
+                return getCSharpClassName(typeSpecifierNode->flockSpecifierNode->identifier);
+            }
+
+            return "object";
+        }
+        default: {
+            return "object";
+        }
+    }
+}
+
+const char *getAssignmentOperator(int assignOperator) {
+    switch (assignOperator) {
+        case OPERATOR_MULTIPLY_EQUAL: {
+            return " *= ";
+        }
+        case OPERATOR_DIVIDE_EQUAL: {
+            return " /= ";
+        }
+        case OPERATOR_MODULO_EQUAL: {
+            return " %= ";
+        }
+        case OPERATOR_ADD_EQUAL: {
+            return " += ";
+        }
+        case OPERATOR_SUBTRACT_EQUAL: {
+            return " -= ";
+        }
+        default: {
+            return " = ";
+        }
+    }
+}
+
+const char *getComparisonOperator(int compareType) {
+    switch (compareType) {
+        case COMPARE_LESS_THAN: {
+            return " < ";
+        }
+        case COMPARE_GREATER_THAN: {
+            return " > ";
+        }
+        case COMPARE_EQUAL: {
+            return " == ";
+        }
+        case COMPARE_NOT_EQUAL: {
+            return " != ";
+        }
+        case COMPARE_LESS_OR_EQUAL: {
+            return " <= ";
+        }
+        case COMPARE_GREATER_OR_EQUAL: {
+            return " >= ";
+        }
+        default: {
+            return " == ";
+        }
+    }
+}
+
+void emitStringLiteral(Emitter *emitter, const char *text) {
+    OutputBuffer *output = emitter->output;
+    const char *start = text;
+
+    appendOutputLength(output, "\"", 1);
+
+    for (const char *p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            appendOutputLength(output, start, p - start);
+            appendOutputLength(output, "\\", 1);
+            start = p;
+        }
+    }
+
+    appendOutput(output, start);
+    appendOutputLength(output, "\"", 1);
+}
+
+void emitConstant(Emitter *emitter, const ConstantNode *constantNode) {
+    emitter->nodeCount++;
+
+    switch (constantNode->constantType) {
+        case CONSTANT_SI32:
+        case CONSTANT_BYTE: {
+            appendOutputInteger(emitter->output, constantNode->integerConstant);
+            break;
+        }
+        case CONSTANT_STRING: {
+            emitStringLiteral(emitter, (constantNode->characterConstant != NULL) ? constantNode->characterConstant : "");
+            break;
+        }
+        case CONSTANT_FP64: {
+            if (constantNode->characterConstant != NULL) {
+                appendOutput(emitter->output, constantNode->characterConstant);
+            }
+            else {
+                appendOutputInteger(emitter->output, constantNode->integerConstant);
+                appendOutput(emitter->output, ".0");
+            }
+
+            break;
+        }
+        case CONSTANT_B8: {
+            appendOutput(emitter->output, (constantNode->integerConstant != 0) ? "true" : "false");
+            break;
+        }
+        default: {
+            appendOutputInteger(emitter->output, constantNode->integerConstant);
+            break;
+        }
+    }
+}
+
+// VB's conversion functions compile to calls into the runtime's Conversions helpers, with its rounding and
+// overflow checks, and Err is a function of Information that VB calls without parentheses. The rest of the
+// runtime's functions are imported with using static, as VB imports them.
+static const char *const runtimeNames[][2] = {
+    { "CBool", "Conversions.ToBoolean" },
+    { "CByte", "Conversions.ToByte" },
+    { "CCur", "Conversions.ToDecimal" },
+    { "CDate", "Conversions.ToDate" },
+    { "CDbl", "Conversions.ToDouble" },
+    { "CDec", "Conversions.ToDecimal" },
+    { "CInt", "Conversions.ToShort" },
+    { "CLng", "Conversions.ToInteger" },
+    { "CSng", "Conversions.ToSingle" },
+    { "CStr", "Conversions.ToString" },
+    { "CVar", "(object)" },
+    { "Err", "Err()" }
+};
+
+const char *getRuntimeName(const char *identifier) {
+    for (size_t i = 0; i < sizeof(runtimeNames) / sizeof(runtimeNames[0]); i++) {
+        if (strcasecmp(runtimeNames[i][0], identifier) == 0) {
+            return runtimeNames[i][1];
+        }
+    }
+
+    return NULL;
+}
+
+bool isDeclaredVariable(Emitter *emitter, const char *name);
+
+// VB resolves public procedures of standard modules project-wide; C# needs the class name. A name the
+// project does not declare may be one of the runtime's that C# spells differently.
+void emitQualifiedIdentifier(Emitter *emitter, const char *identifier) {
+    const bool isVariable = isDeclaredVariable(emitter, identifier);
+    const IndexedSymbol *symbol = (emitter->symbols != NULL && !isVariable) ? findSymbol(emitter->symbols, identifier) : NULL;
+    const char *runtimeName = (symbol == NULL && !isVariable) ? getRuntimeName(identifier) : NULL;
+
+    if (runtimeName != NULL) {
+        appendOutput(emitter->output, runtimeName);
+        return;
+    }
+
+    if (symbol != NULL && symbol->next < 0 && symbol->fileIndex != emitter->file->index
+        && (symbol->kind == SYMBOL_SUB || symbol->kind == SYMBOL_FUNCTION || symbol->kind == SYMBOL_DECLARE)) {
+        const ProjectFile *owner = getProjectFile(emitter->file->project, symbol->fileIndex);
+
+        if (owner->type == PROJECT_MODULE) {
+            appendOutput(emitter->output, getModuleName(emitter->symbols, owner));
+            appendOutputLength(emitter->output, ".", 1);
+        }
+    }
+
+    appendOutput(emitter->output, identifier);
+}
+
+void emitPrimaryExpression(Emitter *emitter, const PrimaryExpressionNode *primaryExpressionNode) {
+    emitter->nodeCount++;
+
+    if (primaryExpressionNode->identifier != NULL && emitter->resultName != NULL && strcasecmp(primaryExpressionNode->identifier, emitter->resultName) == 0) {
+        appendOutput(emitter->output, "_result");
+    }
+    else if (primaryExpressionNode->identifier != NULL) {
+        emitQualifiedIdentifier(emitter, primaryExpressionNode->identifier);
+    }
+    else if (primaryExpressionNode->constantNode != NULL) {
+        emitConstant(emitter, primaryExpressionNode->constantNode);
+    }
+    else if (primaryExpressionNode->expressionNode != NULL) {
+        appendOutputLength(emitter->output, "(", 1);
+        emitExpression(emitter, primaryExpressionNode->expressionNode);
+        appendOutputLength(emitter->output, ")", 1);
+    }
+    else if (primaryExpressionNode->str != NULL) {
+        emitStringLiteral(emitter, primaryExpressionNode->str);
+    }
+}
+
+const InitializeDeclaratorNode *findDeclaredName(const DeclarationNode *declarationNode, const char *name) {
+    for (int i = 0; declarationNode != NULL && i < declarationNode->initializeDeclaratorNodes->size; i++) {
+        const InitializeDeclaratorNode *initializeDeclaratorNode = declarationNode->initializeDeclaratorNodes->contents[i];
+
+        if (strcasecmp(getDeclaratorName(initializeDeclaratorNode->declaratorNode), name) == 0) {
+            return initializeDeclaratorNode;
+        }
+    }
+
+    return NULL;
+}
+
+bool isDeclaredArray(const DeclarationNode *declarationNode, const char *name) {
+    const InitializeDeclaratorNode *initializeDeclaratorNode = findDeclaredName(declarationNode, name);
+    return initializeDeclaratorNode != NULL && isArrayDeclarator(initializeDeclaratorNode->declaratorNode);
+}
+
+// the procedure's parameter called name, or NULL
+const ParameterDeclarationNode *findParameter(const FunctionDefinitionNode *functionDefinitionNode, const char *name) {
+    const ParameterTypeListNode *parameterTypeListNode = getParameterTypeList(functionDefinitionNode->declaratorNode);
+
+    for (const ParameterListNode *parameterListNode = (parameterTypeListNode != NULL) ? parameterTypeListNode->parameterListNode : NULL; parameterListNode != NULL; parameterListNode = parameterListNode->parameterListNode) {
+        const ParameterDeclarationNode *parameterDeclarationNode = parameterListNode->parameterDeclarationNode;
+
+        if (parameterDeclarationNode != NULL && parameterDeclarationNode->declaratorNode != NULL && strcasecmp(getDeclaratorName(parameterDeclarationNode->declaratorNode), name) == 0) {
+            return parameterDeclarationNode;
+        }
+    }
+
+    return NULL;
+}
+
+// A parameter, local or field of this module, which VB finds before any procedure of the project: a
+// local a hides a Public Sub A in another module.
+bool isDeclaredVariable(Emitter *emitter, const char *name) {
+    if (emitter->procedure != NULL) {
+        const ControlFlowGraph *graph = getControlFlowGraph(emitter->procedure);
+        const int variable = findCfgVariable(graph, name);
+
+        if (findParameter(emitter->procedure, name) != NULL || (variable >= 0 && graph->variables[variable].kind != VARIABLE_RESULT)) {
+            return true;
+        }
+    }
+
+    for (int i = 0; i < emitter->memberDeclarations->size; i++) {
+        if (findDeclaredName(emitter->memberDeclarations->contents[i], name) != NULL) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// name(i) indexes an array rather than calling a procedure when name is an array parameter, local or field
+bool isArrayVariable(Emitter *emitter, const char *name) {
+    const IndexedSymbol *symbol = (emitter->symbols != NULL && !isDeclaredVariable(emitter, name)) ? findSymbol(emitter->symbols, name) : NULL;
+
+    if (symbol != NULL && (symbol->kind == SYMBOL_SUB || symbol->kind == SYMBOL_FUNCTION || symbol->kind == SYMBOL_PROPERTY || symbol->kind == SYMBOL_DECLARE)) {
+        return false;
+    }
+
+    if (emitter->procedure != NULL) {
+        const ParameterDeclarationNode *parameterDeclarationNode = findParameter(emitter->procedure, name);
+
+        if (parameterDeclarationNode != NULL) {
+            return isArrayDeclarator(parameterDeclarationNode->declaratorNode);
+        }
+
+        const ControlFlowGraph *graph = getControlFlowGraph(emitter->procedure);
+        const int variable = findCfgVariable(graph, name);
+
+        if (variable >= 0) {
+            return graph->variables[variable].kind == VARIABLE_LOCAL && isDeclaredArray(graph->variables[variable].declarationNode, name);
+        }
+    }
+
+    for (int i = 0; i < emitter->memberDeclarations->size; i++) {
+        if (isDeclaredArray(emitter->memberDeclarations->contents[i], name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// the name a loop rewrite declared a variable under, or NULL when the loop leaves it alone
+const char *findLoopVariable(const Vector *names, const char *name) {
+    for (int i = 0; name != NULL && i < names->size; i++) {
+        if (strcasecmp(names->contents[i], name) == 0) {
+            return names->contents[i];
+        }
+    }
+
+    return NULL;
+}
+
+// the array x in a call like "UBound(x)" to function, or NULL
+const char *getBoundArray(const PostfixExpressionNode *postfixExpressionNode, const char *function) {
+    const Vector *arguments = postfixExpressionNode->assignExpressionNodes;
+
+    if (postfixExpressionNode->postfixExpressionType != POSTFIX_LEFT_PARENTHESIS || arguments == NULL || arguments->size != 1) {
+        return NULL;
+    }
+
+    const char *name = getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode);
+    return (name != NULL && strcasecmp(name, function) == 0) ? getAssignmentIdentifier(arguments->contents[0]) : NULL;
+}
+
+// the C# name of a proven key or item type
+const char *getCollectionTypeName(InferredType type) {
+    const char *name = getCSharpInferredName(type);
+    return (type.kind == INFERRED_CLASS) ? getCSharpClassName(name) : name;
+}
+
+void emitCollectionType(Emitter *emitter, const CollectionLowering *lowering) {
+    if (lowering->kind == COLLECTION_LIST) {
+        appendOutputFormat(emitter->output, "System.Collections.Generic.List<%s>", getCollectionTypeName(lowering->value));
+    }
+    else {
+        appendOutputFormat(emitter->output, "System.Collections.Generic.Dictionary<%s, %s>", getCollectionTypeName(lowering->key), getCollectionTypeName(lowering->value));
+    }
+}
+
+void emitCollectionConstructor(Emitter *emitter, const CollectionLowering *lowering) {
+    appendOutput(emitter->output, "new ");
+    emitCollectionType(emitter, lowering);
+    appendOutput(emitter->output, lowering->isTextCompare ? "(StringComparer.OrdinalIgnoreCase)" : "()");
+}
+
+const CollectionLowering *getCollectionLowering(const Emitter *emitter, const char *name) {
+    const int variable = (emitter->collections != NULL && name != NULL) ? findCfgVariable(emitter->procedure->controlFlowGraph, name) : -1;
+    return (variable >= 0 && emitter->collections[variable].kind != COLLECTION_NONE) ? &emitter->collections[variable] : NULL;
+}
+
+// the lowering a member access goes through, or NULL when it is not on a lowered collection
+const CollectionLowering *findCollectionUse(const Emitter *emitter, const PostfixExpressionNode *postfixExpressionNode, CollectionUse *use) {
+    if (emitter->collections == NULL || !getCollectionUse(emitter->procedure->controlFlowGraph, postfixExpressionNode, use)) {
+        return NULL;
+    }
+
+    return (emitter->collections[use->variable].kind != COLLECTION_NONE) ? &emitter->collections[use->variable] : NULL;
+}
+
+// A position is 1-based in VB and 0-based in C#; anything looser than a sum is parenthesized first.
+void emitCollectionIndex(Emitter *emitter, const CollectionLowering *lowering, const AssignmentExpressionNode *assignmentExpressionNode) {
+    const AdditionExpressionNode *additionExpressionNode = getAssignmentAddition(assignmentExpressionNode);
+    const PostfixExpressionNode *postfixExpressionNode = (additionExpressionNode != NULL) ? getAdditionPostfix(additionExpressionNode) : NULL;
+    const ConstantNode *constantNode = (postfixExpressionNode != NULL && postfixExpressionNode->primaryExpressionNode != NULL) ? postfixExpressionNode->primaryExpressionNode->constantNode : NULL;
+    const bool isGrouped = (lowering->kind == COLLECTION_LIST && additionExpressionNode == NULL);
+
+    if (lowering->kind == COLLECTION_LIST && constantNode != NULL && constantNode->constantType != CONSTANT_STRING && constantNode->constantType != CONSTANT_FP64) {
+        appendOutputFormat(emitter->output, "%d", constantNode->integerConstant - 1);
+        return;
+    }
+
+    appendOutput(emitter->output, isGrouped ? "(" : "");
+    emitAssignmentExpression(emitter, assignmentExpressionNode);
+    appendOutput(emitter->output, isGrouped ? ")" : "");
+    appendOutput(emitter->output, (lowering->kind == COLLECTION_LIST) ? " - 1" : "");
+}
+
+// A missing Scripting.Dictionary key reads as Empty, which C# spells as the item type's default; the
+// key is not added as the COM object would.
+void emitCollectionUse(Emitter *emitter, const CollectionLowering *lowering, const CollectionUse *use) {
+    OutputBuffer *output = emitter->output;
+    const char *name = emitter->procedure->controlFlowGraph->variables[use->variable].name;
+    const Vector *arguments = use->arguments;
+
+    switch (use->member) {
+        case MEMBER_ADD: {
+            // Collection.Add takes the item before its key
+            const bool isSwapped = (lowering->kind == COLLECTION_KEYED);
+
+            appendOutputFormat(output, "%s.Add(", name);
+            emitAssignmentExpression(emitter, arguments->contents[isSwapped ? 1 : 0]);
+
+            if (arguments->size > 1) {
+                appendOutputLength(output, ", ", 2);
+                emitAssignmentExpression(emitter, arguments->contents[isSwapped ? 0 : 1]);
+            }
+
+            appendOutputLength(output, ")", 1);
+            break;
+        }
+        case MEMBER_ITEM: {
+            if (lowering->kind == COLLECTION_DICTIONARY) {
+                appendOutputFormat(output, "System.Collections.Generic.CollectionExtensions.GetValueOrDefault(%s, ", name);
+                emitAssignmentExpression(emitter, arguments->contents[0]);
+                appendOutput(output, (lowering->value.kind == INFERRED_STRING) ? ", \"\")" : ")");
+            }
+            else {
+                appendOutputFormat(output, "%s[", name);
+                emitCollectionIndex(emitter, lowering, arguments->contents[0]);
+                appendOutputLength(output, "]", 1);
+            }
+
+            break;
+        }
+        case MEMBER_REMOVE: {
+            appendOutputFormat(output, (lowering->kind == COLLECTION_LIST) ? "%s.RemoveAt(" : "%s.Remove(", name);
+            emitCollectionIndex(emitter, lowering, arguments->contents[0]);
+            appendOutputLength(output, ")", 1);
+            break;
+        }
+        case MEMBER_EXISTS: {
+            appendOutputFormat(output, "%s.ContainsKey(", name);
+            emitAssignmentExpression(emitter, arguments->contents[0]);
+            appendOutputLength(output, ")", 1);
+            break;
+        }
+        case MEMBER_COUNT: {
+            appendOutputFormat(output, "%s.Count", name);
+            break;
+        }
+        case MEMBER_REMOVE_ALL: {
+            appendOutputFormat(output, "%s.Clear()", name);
+            break;
+        }
+        case MEMBER_KEYS:
+        case MEMBER_ITEMS: {
+            appendOutputFormat(output, "System.Linq.Enumerable.ToArray(%s.%s)", name, (use->member == MEMBER_KEYS) ? "Keys" : "Values");
+            break;
+        }
+        default: {
+            appendOutput(output, lowering->isTextCompare ? "1" : "0");
+            break;
+        }
+    }
+}
+
+// c(k) or c.Item(k) on a Collection or Dictionary that keeps the runtime's object: C# reaches the default Item
+// member through an indexer, which for the runtime's Collection is 1-based as in VB. The variable, or NULL.
+const char *getShimCollection(Emitter *emitter, const PostfixExpressionNode *postfixExpressionNode) {
+    const PostfixExpressionNode *base = postfixExpressionNode->postfixExpressionNode;
+    const char *name = NULL;
+
+    if (postfixExpressionNode->postfixExpressionType != POSTFIX_LEFT_PARENTHESIS || base == NULL
+        || postfixExpressionNode->assignExpressionNodes == NULL || postfixExpressionNode->assignExpressionNodes->size != 1) {
+        return NULL;
+    }
+
+    if (base->postfixExpressionType == POSTFIX_DOT && strcasecmp(base->identifier, "Item") == 0) {
+        name = (base->postfixExpressionNode != NULL) ? getPostfixIdentifier(base->postfixExpressionNode) : NULL;
+    }
+    else {
+        name = getPostfixIdentifier(base);
+    }
+
+    return (name != NULL && getCollectionClass(findDeclaredType(emitter, name)) != COLLECTION_NONE) ? name : NULL;
+}
+
+// Debug.member, where Debug is VB's own object rather than something the project declares
+bool isDebugMember(Emitter *emitter, const PostfixExpressionNode *postfixExpressionNode) {
+    const char *name = (postfixExpressionNode->postfixExpressionType == POSTFIX_DOT) ? getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode) : NULL;
+    return name != NULL && strcasecmp(name, "Debug") == 0 && !isDeclaredVariable(emitter, name);
+}
+
+// The member of a referenced library that object.member names, where object is declared as one of the
+// library's types; library is set to the one that defines it.
+const LibraryMember *findLibraryMemberUse(Emitter *emitter, const PostfixExpressionNode *postfixExpressionNode, const TypeLibrary **library) {
+    const char *name = (postfixExpressionNode->postfixExpressionType == POSTFIX_DOT) ? getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode) : NULL;
+    const TypeSpecifierNode *typeSpecifierNode = (name != NULL) ? findDeclaredType(emitter, name) : NULL;
+    const LibraryType *type = NULL;
+
+    if (typeSpecifierNode == NULL || typeSpecifierNode->flockName == NULL || emitter->symbols == NULL) {
+        return NULL;
+    }
+
+    type = findReferencedType(emitter->symbols, typeSpecifierNode->flockName, library);
+    return (type != NULL) ? findLibraryMember(*library, type, postfixExpressionNode->identifier) : NULL;
+}
+
+void emitPostfixExpression(Emitter *emitter, const PostfixExpressionNode *postfixExpressionNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+    const char *bounded = getBoundArray(postfixExpressionNode, "UBound");
+    const char *lowered = getBoundArray(postfixExpressionNode, "LBound");
+    const char *growable = findLoopVariable(emitter->growableArrays, bounded);
+
+    CollectionUse use;
+    const CollectionLowering *lowering = findCollectionUse(emitter, postfixExpressionNode, &use);
+
+    // a growing array's length is its count, not its capacity
+    if (growable != NULL) {
+        appendOutputFormat(output, "(_%sCount - 1)", growable);
+        return;
+    }
+
+    // the C# array always runs from 0 to VB's upper bound, whatever the lower one, so UBound is one below its length
+    if (bounded != NULL && isArrayVariable(emitter, bounded)) {
+        appendOutputFormat(output, (getArrayRank(emitter, bounded) > 1) ? "%s.GetUpperBound(0)" : "(%s.Length - 1)", bounded);
+        return;
+    }
+
+    // and LBound is a constant wherever the array's lower bound is known
+    if (lowered != NULL && isArrayVariable(emitter, lowered) && getArrayLowerBound(emitter, lowered) >= 0) {
+        appendOutputFormat(output, "%d", getArrayLowerBound(emitter, lowered));
+        return;
+    }
+
+    if (lowering != NULL) {
+        emitCollectionUse(emitter, lowering, &use);
+        return;
+    }
+
+    const char *shim = getShimCollection(emitter, postfixExpressionNode);
+
+    if (shim != NULL) {
+        appendOutputFormat(output, "%s[", shim);
+        emitAssignmentExpression(emitter, postfixExpressionNode->assignExpressionNodes->contents[0]);
+        appendOutputLength(output, "]", 1);
+        return;
+    }
+
+    if (postfixExpressionNode->postfixExpressionType == POSTFIX_PRIMARY || postfixExpressionNode->postfixExpressionNode == NULL) {
+        if (postfixExpressionNode->primaryExpressionNode != NULL) {
+            emitPrimaryExpression(emitter, postfixExpressionNode->primaryExpressionNode);
+        }
+
+        return;
+    }
+
+    const PostfixExpressionNode *calleeNode = postfixExpressionNode->postfixExpressionNode;
+    const char *callee = (calleeNode->postfixExpressionType == POSTFIX_PRIMARY && calleeNode->primaryExpressionNode != NULL) ? calleeNode->primaryExpressionNode->identifier : NULL;
+    const TypeLibrary *library = NULL;
+    const LibraryMember *member = findLibraryMemberUse(emitter, postfixExpressionNode, &library);
+    const LibraryMember *calleeMember = (postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS) ? findLibraryMemberUse(emitter, calleeNode, &library) : NULL;
+
+    // a library's property that takes arguments is indexed in C#, as an array is
+    const bool isIndex = (postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS
+        && ((callee != NULL && isArrayVariable(emitter, callee)) || (calleeMember != NULL && calleeMember->kind == LIBRARY_PROPERTY)));
+
+    // Debug.Print writes any value on a line of its own, which is Debug.WriteLine in C#
+    if (isDebugMember(emitter, postfixExpressionNode)) {
+        emitter->nodeCount += 2;
+        appendOutput(output, "System.Diagnostics.Debug.");
+        appendOutput(output, (strcasecmp(postfixExpressionNode->identifier, "Print") == 0) ? "WriteLine" : postfixExpressionNode->identifier);
+        return;
+    }
+
+    // and separates the values of a list with tabs
+    const bool isPrintList = (postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS && isDebugMember(emitter, calleeNode)
+        && strcasecmp(calleeNode->identifier, "Print") == 0 && postfixExpressionNode->assignExpressionNodes != NULL && postfixExpressionNode->assignExpressionNodes->size > 1);
+
+    // a Function calling itself names the function, not its result
+    if (postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS && callee != NULL && !isIndex && emitter->resultName != NULL && strcasecmp(callee, emitter->resultName) == 0) {
+        emitter->nodeCount += 2;
+        appendOutput(output, callee);
+    }
+    else if (calleeMember != NULL) {
+        emitter->nodeCount++;
+        emitPostfixExpression(emitter, calleeNode->postfixExpressionNode);
+        appendOutputFormat(output, ".%s", getLibraryString(library, calleeMember->nameOffset));
+    }
+    else {
+        emitPostfixExpression(emitter, calleeNode);
+    }
+
+    switch (postfixExpressionNode->postfixExpressionType) {
+        case POSTFIX_LEFT_SQUARE: {
+            appendOutputLength(output, "[", 1);
+            emitExpression(emitter, postfixExpressionNode->expressionNode);
+            appendOutputLength(output, "]", 1);
+            break;
+        }
+        case POSTFIX_LEFT_PARENTHESIS: {
+            appendOutputLength(output, isIndex ? "[" : "(", 1);
+            appendOutput(output, isPrintList ? "string.Join(\"\\t\", " : "");
+
+            for (int i = 0; postfixExpressionNode->assignExpressionNodes != NULL && i < postfixExpressionNode->assignExpressionNodes->size; i++) {
+                if (i > 0) {
+                    appendOutputLength(output, ", ", 2);
+                }
+
+                emitAssignmentExpression(emitter, postfixExpressionNode->assignExpressionNodes->contents[i]);
+            }
+
+            appendOutput(output, isPrintList ? ")" : "");
+            appendOutputLength(output, isIndex ? "]" : ")", 1);
+            break;
+        }
+        case POSTFIX_DOT:
+        case POSTFIX_POINTER: {
+            // a library's member is spelt as the library spells it, and a method VB calls without parentheses is called
+            appendOutputLength(output, ".", 1);
+            appendOutput(output, (member != NULL) ? getLibraryString(library, member->nameOffset) : postfixExpressionNode->identifier);
+            appendOutput(output, (member != NULL && member->kind == LIBRARY_METHOD) ? "()" : "");
+            break;
+        }
+        case POSTFIX_INCREMENT: {
+            appendOutputLength(output, "++", 2);
+            break;
+        }
+        case POSTFIX_DECREMENT: {
+            appendOutputLength(output, "--", 2);
+            break;
+        }
+    }
+}
+
+void emitTypeName(Emitter *emitter, const TypeNameNode *typeNameNode) {
+    emitter->nodeCount++;
+
+    const SpecifierQualifierNode *specifierQualifierNode = typeNameNode->specifierQualifierNode;
+    appendOutput(emitter->output, getCSharpTypeName((specifierQualifierNode != NULL) ? specifierQualifierNode->typeSpecifierNode : NULL));
+}
+
+void emitUnaryExpression(Emitter *emitter, const UnaryExpressionNode *unaryExpressionNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+
+    switch (unaryExpressionNode->type) {
+        case UNARY_INCREMENT: {
+            appendOutputLength(output, "++", 2);
+            emitUnaryExpression(emitter, unaryExpressionNode->unaryExpressionNode);
+            break;
+        }
+        case UNARY_DECREMENT: {
+            appendOutputLength(output, "--", 2);
+            emitUnaryExpression(emitter, unaryExpressionNode->unaryExpressionNode);
+            break;
+        }
+        case UNARY_OPERATOR: {
+            switch (unaryExpressionNode->operatorType) {
+                case OPERATOR_SUBTRACT: {
+                    appendOutputLength(output, "-", 1);
+                    break;
+                }
+                case OPERATOR_EXCLAMATION: {
+                    appendOutputLength(output, "!", 1);
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+
+            emitCastExpression(emitter, unaryExpressionNode->castExpressionNode);
+            break;
+        }
+        case UNARY_SIZE_IDENTIFIER: {
+            appendOutput(output, "System.Runtime.InteropServices.Marshal.SizeOf(");
+            appendOutput(output, unaryExpressionNode->sizeName);
+            appendOutputLength(output, ")", 1);
+            break;
+        }
+        case UNARY_SIZE_TYPE: {
+            appendOutput(output, "sizeof(");
+            emitTypeName(emitter, unaryExpressionNode->typeNameNode);
+            appendOutputLength(output, ")", 1);
+            break;
+        }
+        case UNARY_NEW: {
+            appendOutput(output, "new ");
+            emitTypeName(emitter, unaryExpressionNode->typeNameNode);
+            appendOutputLength(output, "()", 2);
+            break;
+        }
+        default: {
+            emitPostfixExpression(emitter, unaryExpressionNode->postfixExpressionNode);
+            break;
+        }
+    }
+}
+
+void emitCastExpression(Emitter *emitter, const CastExpressionNode *castExpressionNode) {
+    emitter->nodeCount++;
+
+    if (castExpressionNode->typeNameNode != NULL && castExpressionNode->castExpressionNode != NULL) {
+        appendOutputLength(emitter->output, "(", 1);
+        emitTypeName(emitter, castExpressionNode->typeNameNode);
+        appendOutputLength(emitter->output, ")", 1);
+        emitCastExpression(emitter, castExpressionNode->castExpressionNode);
+    }
+    else {
+        emitUnaryExpression(emitter, castExpressionNode->unaryExpressionNode);
+    }
+}
+
+// Arithmetic a try for On Error encloses is checked, so it raises VB's overflow where the catch sees it; the
+// outermost operator's checked covers the whole expression.
+bool beginCheckedArithmetic(Emitter *emitter, bool isOperator) {
+    if (!emitter->isChecked || !isOperator) {
+        return false;
+    }
+
+    appendOutputLength(emitter->output, "checked(", 8);
+    emitter->isChecked = false;
+    return true;
+}
+
+void endCheckedArithmetic(Emitter *emitter, bool isBegun) {
+    if (isBegun) {
+        appendOutputLength(emitter->output, ")", 1);
+        emitter->isChecked = true;
+    }
+}
+
+void emitMultiplicationExpression(Emitter *emitter, const MultiplicationExpressionNode *multiplicationExpressionNode) {
+    emitter->nodeCount++;
+
+    const bool isBegun = beginCheckedArithmetic(emitter, multiplicationExpressionNode->multiplicationExpressionNode != NULL);
+
+    if (multiplicationExpressionNode->multiplicationExpressionNode != NULL) {
+        emitMultiplicationExpression(emitter, multiplicationExpressionNode->multiplicationExpressionNode);
+
+        switch (multiplicationExpressionNode->operatorType) {
+            case OPERATOR_DIVIDE: {
+                appendOutputLength(emitter->output, " / ", 3);
+                break;
+            }
+            case OPERATOR_MODULO: {
+                appendOutputLength(emitter->output, " % ", 3);
+                break;
+            }
+            default: {
+                appendOutputLength(emitter->output, " * ", 3);
+                break;
+            }
+        }
+    }
+
+    emitCastExpression(emitter, multiplicationExpressionNode->castExpressionNode);
+    endCheckedArithmetic(emitter, isBegun);
+}
+
+void emitAdditionExpression(Emitter *emitter, const AdditionExpressionNode *additionExpressionNode) {
+    emitter->nodeCount++;
+
+    const bool isBegun = beginCheckedArithmetic(emitter, additionExpressionNode->additionExpressionNode != NULL);
+
+    if (additionExpressionNode->additionExpressionNode != NULL) {
+        emitAdditionExpression(emitter, additionExpressionNode->additionExpressionNode);
+        appendOutputLength(emitter->output, (additionExpressionNode->operatorType == OPERATOR_SUBTRACT) ? " - " : " + ", 3);
+    }
+
+    emitMultiplicationExpression(emitter, additionExpressionNode->multiplicationExpressionNode);
+    endCheckedArithmetic(emitter, isBegun);
+}
+
+void emitShiftExpression(Emitter *emitter, const ShiftExpressionNode *shiftExpressionNode);
+
+bool isConcatenation(const ShiftExpressionNode *shiftExpressionNode) {
+    return shiftExpressionNode->shiftExpressionNode != NULL && shiftExpressionNode->operatorType == OPERATOR_CONCAT;
+}
+
+// a & chain's operands, left to right; a nested chain is flattened into the same list
+void emitConcatOperands(Emitter *emitter, const ShiftExpressionNode *shiftExpressionNode, const char *separator) {
+    if (isConcatenation(shiftExpressionNode->shiftExpressionNode)) {
+        emitConcatOperands(emitter, shiftExpressionNode->shiftExpressionNode, separator);
+    }
+    else {
+        emitShiftExpression(emitter, shiftExpressionNode->shiftExpressionNode);
+    }
+
+    appendOutput(emitter->output, separator);
+    emitAdditionExpression(emitter, shiftExpressionNode->additionExpressionNode);
+}
+
+void emitShiftExpression(Emitter *emitter, const ShiftExpressionNode *shiftExpressionNode) {
+    emitter->nodeCount++;
+
+    // one string.Concat per chain, rather than a temporary string per &
+    if (isConcatenation(shiftExpressionNode)) {
+        appendOutput(emitter->output, "string.Concat(");
+        emitConcatOperands(emitter, shiftExpressionNode, ", ");
+        appendOutputLength(emitter->output, ")", 1);
+        return;
+    }
+
+    if (shiftExpressionNode->shiftExpressionNode != NULL) {
+        emitShiftExpression(emitter, shiftExpressionNode->shiftExpressionNode);
+        appendOutputLength(emitter->output, " << ", 4);
+    }
+
+    emitAdditionExpression(emitter, shiftExpressionNode->additionExpressionNode);
+}
+
+void emitRelationalExpression(Emitter *emitter, const RelationalExpressionNode *relationalExpressionNode) {
+    emitter->nodeCount++;
+
+    if (relationalExpressionNode->relationalExpressionNode != NULL) {
+        emitRelationalExpression(emitter, relationalExpressionNode->relationalExpressionNode);
+        appendOutput(emitter->output, getComparisonOperator(relationalExpressionNode->compareType));
+    }
+
+    emitShiftExpression(emitter, relationalExpressionNode->shiftExpressionNode);
+}
+
+void emitEqualExpression(Emitter *emitter, const EqualExpressionNode *equalExpressionNode) {
+    emitter->nodeCount++;
+
+    if (equalExpressionNode->equalExpressionNode != NULL) {
+        emitEqualExpression(emitter, equalExpressionNode->equalExpressionNode);
+        appendOutput(emitter->output, getComparisonOperator(equalExpressionNode->compareType));
+    }
+
+    emitRelationalExpression(emitter, equalExpressionNode->relationalExpressionNode);
+}
+
+void emitAndExpression(Emitter *emitter, const AndExpressionNode *andExpressionNode) {
+    emitter->nodeCount++;
+
+    if (andExpressionNode->andExpressionNode != NULL) {
+        emitAndExpression(emitter, andExpressionNode->andExpressionNode);
+        appendOutputLength(emitter->output, " & ", 3);
+    }
+
+    emitEqualExpression(emitter, andExpressionNode->equalExpressionNode);
+}
+
+void emitExclusiveOrExpression(Emitter *emitter, const ExclusiveOrExpressionNode *exclusiveOrExpressionNode) {
+    emitter->nodeCount++;
+
+    if (exclusiveOrExpressionNode->exclusiveOrExpressionNode != NULL) {
+        emitExclusiveOrExpression(emitter, exclusiveOrExpressionNode->exclusiveOrExpressionNode);
+        appendOutputLength(emitter->output, " ^ ", 3);
+    }
+
+    emitAndExpression(emitter, exclusiveOrExpressionNode->andExpressionNode);
+}
+
+void emitInclusiveOrExpression(Emitter *emitter, const InclusiveOrExpressionNode *inclusiveOrExpressionNode) {
+    emitter->nodeCount++;
+
+    if (inclusiveOrExpressionNode->inclusiveOrExpressionNode != NULL) {
+        emitInclusiveOrExpression(emitter, inclusiveOrExpressionNode->inclusiveOrExpressionNode);
+        appendOutputLength(emitter->output, " | ", 3);
+    }
+
+    emitExclusiveOrExpression(emitter, inclusiveOrExpressionNode->exclusiveOrExpressionNode);
+}
+
+void emitLogicalAndExpression(Emitter *emitter, const LogicalAndExpressionNode *logicalAndExpressionNode) {
+    emitter->nodeCount++;
+
+    if (logicalAndExpressionNode->logicalAndExpressionNode != NULL) {
+        emitLogicalAndExpression(emitter, logicalAndExpressionNode->logicalAndExpressionNode);
+        appendOutputLength(emitter->output, " && ", 4);
+    }
+
+    emitInclusiveOrExpression(emitter, logicalAndExpressionNode->inclusiveOrExpressionNode);
+}
+
+void emitOrExpression(Emitter *emitter, const OrExpressionNode *orExpressionNode) {
+    emitter->nodeCount++;
+
+    if (orExpressionNode->orExpressionNode != NULL) {
+        emitOrExpression(emitter, orExpressionNode->orExpressionNode);
+        appendOutputLength(emitter->output, " || ", 4);
+    }
+
+    emitLogicalAndExpression(emitter, orExpressionNode->logicalAndExpressionNode);
+}
+
+void emitConditionalExpression(Emitter *emitter, const ConditionalExpressionNode *conditionalExpressionNode) {
+    emitter->nodeCount++;
+
+    emitOrExpression(emitter, conditionalExpressionNode->orExpressionNode);
+
+    if (conditionalExpressionNode->expressionNode != NULL && conditionalExpressionNode->conditionalExpressionNode != NULL) {
+        appendOutputLength(emitter->output, " ? ", 3);
+        emitExpression(emitter, conditionalExpressionNode->expressionNode);
+        appendOutputLength(emitter->output, " : ", 3);
+        emitConditionalExpression(emitter, conditionalExpressionNode->conditionalExpressionNode);
+    }
+}
+
+bool isNumericTypeName(const char *typeName) {
+    return typeName != NULL && (strcmp(typeName, "byte") == 0 || strcmp(typeName, "short") == 0 || strcmp(typeName, "int") == 0
+        || strcmp(typeName, "float") == 0 || strcmp(typeName, "double") == 0 || strcmp(typeName, "decimal") == 0);
+}
+
+// byte, short and int in order of width, or 0 for the floating-point types
+int getIntegralRank(const char *typeName) {
+    return (strcmp(typeName, "byte") == 0) ? 1 : (strcmp(typeName, "short") == 0) ? 2 : (strcmp(typeName, "int") == 0) ? 3 : 0;
+}
+
+// The numeric C# type name is declared with, as the result being assigned or a parameter, local or field,
+// or NULL when it is not numeric or not declared here. An array stands for its elements.
+// the declared type of a parameter, local or field of this module, or NULL
+const TypeSpecifierNode *findDeclaredType(Emitter *emitter, const char *name) {
+    const ParameterDeclarationNode *parameterDeclarationNode = (emitter->procedure != NULL) ? findParameter(emitter->procedure, name) : NULL;
+    const ControlFlowGraph *graph = (emitter->procedure != NULL) ? getControlFlowGraph(emitter->procedure) : NULL;
+    const int variable = (graph != NULL) ? findCfgVariable(graph, name) : -1;
+    bool isConstant = false;
+
+    if (parameterDeclarationNode != NULL) {
+        return findTypeSpecifier(parameterDeclarationNode->declaratorSpecifierNodes, &isConstant);
+    }
+
+    if (variable >= 0) {
+        const DeclarationNode *declarationNode = graph->variables[variable].declarationNode;
+        return (declarationNode != NULL) ? findTypeSpecifier(declarationNode->declarationSpecifierNodes, &isConstant) : NULL;
+    }
+
+    for (int i = 0; i < emitter->memberDeclarations->size; i++) {
+        const DeclarationNode *declarationNode = emitter->memberDeclarations->contents[i];
+
+        if (findDeclaredName(declarationNode, name) != NULL) {
+            return findTypeSpecifier(declarationNode->declarationSpecifierNodes, &isConstant);
+        }
+    }
+
+    return NULL;
+}
+
+const char *getDeclaredTypeName(Emitter *emitter, const char *name) {
+    if (name == NULL) {
+        return NULL;
+    }
+
+    if (emitter->resultName != NULL && strcasecmp(name, emitter->resultName) == 0) {
+        return isNumericTypeName(emitter->resultTypeName) ? emitter->resultTypeName : NULL;
+    }
+
+    const TypeSpecifierNode *typeSpecifierNode = findDeclaredType(emitter, name);
+    return (typeSpecifierNode != NULL && (typeSpecifierNode->typeSpecifier == TYPE_SI32 || typeSpecifierNode->typeSpecifier == TYPE_FP64)) ? getCSharpTypeName(typeSpecifierNode) : NULL;
+}
+
+// the numeric type an assignment stores into: a variable, or an element of an array
+const char *getTargetTypeName(Emitter *emitter, const UnaryExpressionNode *unaryExpressionNode) {
+    const PostfixExpressionNode *postfixExpressionNode = getUnaryPostfix(unaryExpressionNode);
+    const char *name = getPostfixIdentifier(postfixExpressionNode);
+
+    if (name == NULL && postfixExpressionNode != NULL && postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS) {
+        name = getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode);
+        name = (name != NULL && isArrayVariable(emitter, name)) ? name : NULL;
+    }
+
+    return getDeclaredTypeName(emitter, name);
+}
+
+// A variable's declared type, and otherwise what the procedure's inference makes of the value: int for
+// any integer arithmetic and double for anything in floating point, as C# types them.
+const char *getValueTypeName(Emitter *emitter, const AssignmentExpressionNode *assignmentExpressionNode) {
+    const char *name = getAssignmentIdentifier(assignmentExpressionNode);
+
+    if (name != NULL && (isDeclaredVariable(emitter, name) || (emitter->resultName != NULL && strcasecmp(name, emitter->resultName) == 0))) {
+        const TypeSpecifierNode *typeSpecifierNode = findDeclaredType(emitter, name);
+
+        // a Variant reads as whatever inference narrowed it to
+        if (getDeclaredTypeName(emitter, name) != NULL || (typeSpecifierNode != NULL && typeSpecifierNode->typeSpecifier != TYPE_VARIANT)) {
+            return getDeclaredTypeName(emitter, name);
+        }
+    }
+
+    if (emitter->procedure == NULL) {
+        return NULL;
+    }
+
+    if (emitter->types == NULL) {
+        emitter->types = getInferredTypes(getControlFlowGraph(emitter->procedure), emitter->symbols);
+    }
+
+    const InferredType type = getExpressionInferredType(emitter->types, NULL, assignmentExpressionNode);
+    return (type.kind == INFERRED_INT) ? "int" : (type.kind == INFERRED_DOUBLE) ? "double" : NULL;
+}
+
+bool isIntegerConstant(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const AdditionExpressionNode *additionExpressionNode = getAssignmentAddition(assignmentExpressionNode);
+    const PostfixExpressionNode *postfixExpressionNode = (additionExpressionNode != NULL) ? getAdditionPostfix(additionExpressionNode) : NULL;
+    const ConstantNode *constantNode = (postfixExpressionNode != NULL && postfixExpressionNode->primaryExpressionNode != NULL) ? postfixExpressionNode->primaryExpressionNode->constantNode : NULL;
+
+    return constantNode != NULL && (constantNode->constantType == CONSTANT_SI32 || constantNode->constantType == CONSTANT_BYTE);
+}
+
+// The conversion VB makes on its own when a value of type source is stored as target, which C# wants
+// written out. Into an integer VB rounds half to even and raises an overflow, as checked Math.Round does; a
+// constant C# converts itself. Returns how many parentheses the conversion leaves open around the value.
+int emitImplicitConversion(Emitter *emitter, const char *target, const char *source, bool isConstant) {
+    OutputBuffer *output = emitter->output;
+
+    if (source == NULL || strcmp(target, source) == 0) {
+        return 0;
+    }
+
+    const int targetRank = getIntegralRank(target);
+    const int sourceRank = getIntegralRank(source);
+
+    if (targetRank > 0 && sourceRank == 0) {
+        appendOutputFormat(output, "checked((%s)Math.Round(", target);
+        return 2;
+    }
+
+    if (targetRank > 0 && targetRank < sourceRank && !isConstant) {
+        appendOutputFormat(output, "checked((%s)(", target);
+        return 2;
+    }
+
+    if (targetRank == 0 && sourceRank == 0 && (strcmp(target, "float") == 0 || strcmp(source, "decimal") == 0 || strcmp(target, "decimal") == 0)) {
+        appendOutputFormat(output, "(%s)(", target);
+        return 1;
+    }
+
+    return 0;
+}
+
+void emitAssignmentExpression(Emitter *emitter, const AssignmentExpressionNode *assignmentExpressionNode) {
+    emitter->nodeCount++;
+
+    const CollectionLowering *lowering = NULL;
+    CollectionUse use;
+
+    if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL && assignmentExpressionNode->assignOperator == OPERATOR_CONCAT_EQUAL) {
+        const ShiftExpressionNode *concatenation = getConcatenation(assignmentExpressionNode->assignExpressionNode);
+
+        // C# has no &=, and += is only defined when the target is already a string
+        emitUnaryExpression(emitter, assignmentExpressionNode->unaryExpressionNode);
+        appendOutput(emitter->output, " = string.Concat(");
+        emitUnaryExpression(emitter, assignmentExpressionNode->unaryExpressionNode);
+        appendOutputLength(emitter->output, ", ", 2);
+
+        if (concatenation != NULL) {
+            emitConcatOperands(emitter, concatenation, ", ");
+        }
+        else {
+            emitAssignmentExpression(emitter, assignmentExpressionNode->assignExpressionNode);
+        }
+
+        appendOutputLength(emitter->output, ")", 1);
+    }
+    else if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL
+        && (lowering = getCollectionLowering(emitter, getUnaryIdentifier(assignmentExpressionNode->unaryExpressionNode))) != NULL) {
+        // the only stores a lowered collection takes are its constructor and Nothing
+        emitUnaryExpression(emitter, assignmentExpressionNode->unaryExpressionNode);
+        appendOutputLength(emitter->output, " = ", 3);
+
+        if (getConstructedCollection(assignmentExpressionNode->assignExpressionNode) != COLLECTION_NONE) {
+            emitCollectionConstructor(emitter, lowering);
+        }
+        else {
+            appendOutput(emitter->output, "null");
+        }
+    }
+    else if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL
+        && (lowering = findCollectionUse(emitter, getUnaryPostfix(assignmentExpressionNode->unaryExpressionNode), &use)) != NULL && use.member == MEMBER_ITEM) {
+        // "d(k) = v" adds or replaces, as the indexer does
+        appendOutputFormat(emitter->output, "%s[", emitter->procedure->controlFlowGraph->variables[use.variable].name);
+        emitAssignmentExpression(emitter, use.arguments->contents[0]);
+        appendOutputLength(emitter->output, "]", 1);
+        appendOutput(emitter->output, getAssignmentOperator(assignmentExpressionNode->assignOperator));
+        emitAssignmentExpression(emitter, assignmentExpressionNode->assignExpressionNode);
+    }
+    else if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL) {
+        const AssignmentExpressionNode *value = assignmentExpressionNode->assignExpressionNode;
+        const char *target = (assignmentExpressionNode->assignOperator == OPERATOR_ASSIGN) ? getTargetTypeName(emitter, assignmentExpressionNode->unaryExpressionNode) : NULL;
+
+        emitUnaryExpression(emitter, assignmentExpressionNode->unaryExpressionNode);
+        appendOutput(emitter->output, getAssignmentOperator(assignmentExpressionNode->assignOperator));
+
+        const int openCount = (target != NULL) ? emitImplicitConversion(emitter, target, getValueTypeName(emitter, value), isIntegerConstant(value)) : 0;
+
+        emitAssignmentExpression(emitter, value);
+        appendOutputLength(emitter->output, "))", openCount);
+    }
+    else if (assignmentExpressionNode->conditionalExpressionNode != NULL) {
+        emitConditionalExpression(emitter, assignmentExpressionNode->conditionalExpressionNode);
+    }
+}
+
+void emitExpression(Emitter *emitter, const ExpressionNode *expressionNode) {
+    emitter->nodeCount++;
+
+    if (expressionNode->expressionNode != NULL) {
+        emitExpression(emitter, expressionNode->expressionNode);
+        appendOutputLength(emitter->output, ", ", 2);
+    }
+
+    emitAssignmentExpression(emitter, expressionNode->assignExpressionNode);
+}
+
+void emitInitializer(Emitter *emitter, const InitializerNode *initializerNode) {
+    emitter->nodeCount++;
+
+    if (initializerNode->assignmentExpressionNode != NULL) {
+        emitAssignmentExpression(emitter, initializerNode->assignmentExpressionNode);
+        return;
+    }
+
+    appendOutputLength(emitter->output, "{ ", 2);
+
+    for (int i = 0; initializerNode->initializerListNode != NULL && i < initializerNode->initializerListNode->initializerNodes->size; i++) {
+        if (i > 0) {
+            appendOutputLength(emitter->output, ", ", 2);
+        }
+
+        emitInitializer(emitter, initializerNode->initializerListNode->initializerNodes->contents[i]);
+    }
+
+    appendOutputLength(emitter->output, " }", 2);
+}
+
+// The C# type a procedure's Variant local or result narrows to, or object.
+const char *getVariantTypeName(Emitter *emitter, const char *name) {
+    if (emitter->types == NULL) {
+        emitter->types = getInferredTypes(getControlFlowGraph(emitter->procedure), emitter->symbols);
+    }
+
+    const char *typeName = getInferredTypeName(emitter->types, findCfgVariable(emitter->procedure->controlFlowGraph, name));
+
+    emitter->variantCount++;
+    emitter->narrowedVariantCount += (typeName != NULL);
+    return (typeName != NULL) ? getCSharpClassName(typeName) : "object";
+}
+
+bool isVariantType(const TypeSpecifierNode *typeSpecifierNode) {
+    return typeSpecifierNode == NULL || typeSpecifierNode->typeSpecifier == TYPE_VARIANT;
+}
+
+void emitDeclaration(Emitter *emitter, const DeclarationNode *declarationNode, bool isMember) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+    bool isConstant = false;
+    const TypeSpecifierNode *typeSpecifierNode = findTypeSpecifier(declarationNode->declarationSpecifierNodes, &isConstant);
+    const bool isVariant = (!isMember && emitter->procedure != NULL && isVariantType(typeSpecifierNode));
+    const char *declaredName = getCSharpTypeName(typeSpecifierNode);
+
+    if (isMember) {
+        pushVector(emitter->memberDeclarations, (void *)declarationNode);
+    }
+    else if (emitter->procedure != NULL && emitter->collections == NULL && isCollectionCandidate(typeSpecifierNode)) {
+        emitter->collections = getCollectionLowerings(getControlFlowGraph(emitter->procedure), emitter->symbols);
+    }
+
+    for (int i = 0; i < declarationNode->initializeDeclaratorNodes->size; i++) {
+        const InitializeDeclaratorNode *initializeDeclaratorNode = declarationNode->initializeDeclaratorNodes->contents[i];
+        const DirectDeclaratorNode *directDeclaratorNode = getNamedDirectDeclarator(initializeDeclaratorNode->declaratorNode->directDeclaratorNode);
+        const bool isArray = (directDeclaratorNode != NULL && (directDeclaratorNode->conditionalExpressionNode != NULL || directDeclaratorNode->isDynamic));
+        const CollectionLowering *lowering = isMember ? NULL : getCollectionLowering(emitter, getDeclaratorName(initializeDeclaratorNode->declaratorNode));
+        const char *typeName = (isVariant && !isArray && lowering == NULL) ? getVariantTypeName(emitter, getDeclaratorName(initializeDeclaratorNode->declaratorNode)) : declaredName;
+
+        if (isMember) {
+            appendOutput(output, (isConstant || emitter->isStatic) ? "internal static " : "internal ");
+        }
+
+        if (isConstant) {
+            appendOutput(output, isMember ? "readonly " : "const ");
+        }
+
+        if (lowering != NULL) {
+            emitCollectionType(emitter, lowering);
+        }
+        else {
+            appendOutput(output, typeName);
+        }
+
+        if (isArray) {
+            appendOutputLength(output, "[", 1);
+
+            for (int j = 0; directDeclaratorNode->dimensionNodes != NULL && j < directDeclaratorNode->dimensionNodes->size; j++) {
+                appendOutputLength(output, ",", 1);
+            }
+
+            appendOutputLength(output, "]", 1);
+        }
+
+        appendOutputLength(output, " ", 1);
+        appendOutput(output, getDeclaratorName(initializeDeclaratorNode->declaratorNode));
+
+        if (initializeDeclaratorNode->initializerNode != NULL) {
+            appendOutputLength(output, " = ", 3);
+            emitInitializer(emitter, initializeDeclaratorNode->initializerNode);
+        }
+        else if (isArray && directDeclaratorNode->isDynamic) {
+            // a dynamic array is unallocated until its first ReDim
+            appendOutput(output, isMember ? "" : " = null");
+        }
+        else if (isArray) {
+            // VB array bounds are inclusive
+            appendOutput(output, " = new ");
+            appendOutput(output, typeName);
+            appendOutputLength(output, "[", 1);
+            emitConditionalExpression(emitter, directDeclaratorNode->conditionalExpressionNode);
+            appendOutput(output, " + 1");
+
+            for (int j = 0; directDeclaratorNode->dimensionNodes != NULL && j < directDeclaratorNode->dimensionNodes->size; j++) {
+                appendOutputLength(output, ", ", 2);
+                emitConditionalExpression(emitter, directDeclaratorNode->dimensionNodes->contents[j]);
+                appendOutput(output, " + 1");
+            }
+
+            appendOutputLength(output, "]", 1);
+        }
+        else if (lowering != NULL && typeSpecifierNode != NULL && typeSpecifierNode->isNew) {
+            appendOutputLength(output, " = ", 3);
+            emitCollectionConstructor(emitter, lowering);
+        }
+        else if (typeSpecifierNode != NULL && typeSpecifierNode->isNew) {
+            // VB creates an As New object on first use; creating it up front is the same unless it is never used
+            appendOutputFormat(output, " = new %s()", typeName);
+        }
+        else if (!isMember) {
+            // VB zeroes every local, where C# rejects a read before the first write
+            appendOutput(output, (strcmp(typeName, "string") == 0) ? " = \"\"" : " = default");
+        }
+
+        appendOutputLine(output, ";");
+    }
+}
+
+void emitParameters(Emitter *emitter, const ParameterTypeListNode *parameterTypeListNode) {
+    emitter->nodeCount++;
+
+    const ParameterListNode *parameterListNode = (parameterTypeListNode != NULL) ? parameterTypeListNode->parameterListNode : NULL;
+    bool first = true;
+
+    for (; parameterListNode != NULL; parameterListNode = parameterListNode->parameterListNode) {
+        const ParameterDeclarationNode *parameterDeclarationNode = parameterListNode->parameterDeclarationNode;
+        bool isConstant = false;
+
+        if (parameterDeclarationNode == NULL) {
+            continue;
+        }
+
+        if (!first) {
+            appendOutputLength(emitter->output, ", ", 2);
+        }
+
+        appendOutput(emitter->output, getCSharpTypeName(findTypeSpecifier(parameterDeclarationNode->declaratorSpecifierNodes, &isConstant)));
+
+        if (parameterDeclarationNode->declaratorNode != NULL && isArrayDeclarator(parameterDeclarationNode->declaratorNode)) {
+            appendOutputLength(emitter->output, "[]", 2);
+        }
+
+        if (parameterDeclarationNode->declaratorNode != NULL) {
+            appendOutputLength(emitter->output, " ", 1);
+            appendOutput(emitter->output, getDeclaratorName(parameterDeclarationNode->declaratorNode));
+        }
+
+        first = false;
+    }
+}
+
+// the catch every guarded region ends with: Err describes the exception, as it would in VB, and a region
+// numbered region is re-entered to resume after the statement that failed. isConditional leaves the
+// exception alone unless _resumeNext says Resume Next is in effect after all.
+void emitErrorCatch(Emitter *emitter, int region, bool isConditional) {
+    OutputBuffer *output = emitter->output;
+
+    appendOutputLine(output, isConditional ? "catch (Exception _exception) when (_resumeNext)" : "catch (Exception _exception)");
+    appendOutputLine(output, "{");
+    indentOutput(output);
+    appendOutputLine(output, "Microsoft.VisualBasic.CompilerServices.ProjectData.SetProjectError(_exception);");
+
+    if (region > 0) {
+        appendOutputFormat(output, "goto _region%d;\n", region);
+    }
+
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+}
+
+bool canEmittedStatementThrow(Emitter *emitter, const StatementNode *statementNode, bool isNested) {
+    return canStatementThrow(getControlFlowGraph(emitter->procedure), emitter->symbols, statementNode, isNested);
+}
+
+// whether On Error Resume Next is in effect where statementNode runs, as a CfgResumeState
+int getResumeState(Emitter *emitter, const StatementNode *statementNode) {
+    return emitter->hasResumeNext ? getCfgResumeState(getControlFlowGraph(emitter->procedure), statementNode) : RESUME_OFF;
+}
+
+void findResumeNext(const StatementNode *statementNode, void *context) {
+    const JumpStatementNode *jumpStatementNode = statementNode->jumpStatementNode;
+    *(bool *)context |= (jumpStatementNode != NULL && jumpStatementNode->type == JUMP_ON_ERROR_RESUME_NEXT);
+}
+
+// whether any statement may run both with and without Resume Next in effect, depending on the path to it
+bool hasUnknownResumeState(const ControlFlowGraph *graph) {
+    for (int i = 0; i < graph->statementCount; i++) {
+        if (graph->statements[i].resumeNext == RESUME_UNKNOWN) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// a statement On Error Resume Next runs in sequence with its neighbours; a label can be jumped to from
+// outside a try and an On Error statement changes what the next ones need, so either ends the run
+bool isRegionStatement(const StatementNode *statementNode) {
+    if (statementNode == NULL || statementNode->labeledStatementNode != NULL) {
+        return false;
+    }
+
+    const JumpStatementNode *jumpStatementNode = statementNode->jumpStatementNode;
+    return jumpStatementNode == NULL || (jumpStatementNode->type != JUMP_ON_ERROR_GOTO && jumpStatementNode->type != JUMP_ON_ERROR_RESUME_NEXT);
+}
+
+// one statement under On Error Resume Next: whatever it raises is recorded in Err and skipped
+void emitGuardedStatement(Emitter *emitter, const StatementNode *statementNode, bool isConditional) {
+    OutputBuffer *output = emitter->output;
+
+    appendOutputLine(output, "try");
+    appendOutputLine(output, "{");
+    indentOutput(output);
+    const bool isChecked = emitter->isChecked;
+    emitter->isGuarded = true;
+    emitter->isChecked = true;
+    emitStatement(emitter, statementNode);
+    emitter->isGuarded = false;
+    emitter->isChecked = isChecked;
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+    emitErrorCatch(emitter, 0, isConditional);
+}
+
+// A run of statements under On Error Resume Next. Those that cannot throw at either end of the run stay
+// outside any try, and a lone one that can gets a try of its own. Otherwise the run shares one try: each
+// statement that can throw first stores its index, and the catch re-enters the try through a switch that
+// jumps past the statement that failed, so the run costs one protected region rather than one per statement.
+// isConditional is for a run that may or may not be under Resume Next, depending on the path to it.
+void emitResumeRegion(Emitter *emitter, const Vector *blockItemNodes, int first, int end, bool isConditional) {
+    OutputBuffer *output = emitter->output;
+    int firstThrow = end;
+    int lastThrow = first - 1;
+    int throwCount = 0;
+
+    for (int i = first; i < end; i++) {
+        if (canEmittedStatementThrow(emitter, ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode, false)) {
+            firstThrow = (throwCount == 0) ? i : firstThrow;
+            lastThrow = i;
+            throwCount++;
+        }
+    }
+
+    if (throwCount < 2) {
+        for (int i = first; i < end; i++) {
+            emitStatement(emitter, ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode);
+        }
+
+        return;
+    }
+
+    for (int i = first; i < firstThrow; i++) {
+        emitStatement(emitter, ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode);
+    }
+
+    const int region = ++emitter->regionCount;
+
+    appendOutputFormat(output, "int _resume%d = 0;\n", region);
+    appendOutputFormat(output, "_region%d:\n", region);
+    appendOutputLine(output, "try");
+    appendOutputLine(output, "{");
+    indentOutput(output);
+    appendOutputFormat(output, "switch (_resume%d)\n", region);
+    appendOutputLine(output, "{");
+    indentOutput(output);
+
+    for (int i = 1; i <= throwCount; i++) {
+        appendOutputFormat(output, "case %d: goto _next%d_%d;\n", i, region, i);
+    }
+
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+    const bool isChecked = emitter->isChecked;
+    emitter->isGuarded = true;
+    emitter->isChecked = true;
+
+    for (int i = firstThrow, index = 0; i <= lastThrow; i++) {
+        const StatementNode *statementNode = ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode;
+
+        if (!canEmittedStatementThrow(emitter, statementNode, false)) {
+            emitStatement(emitter, statementNode);
+            continue;
+        }
+
+        index++;
+        appendOutputFormat(output, "_resume%d = %d;\n", region, index);
+        emitStatement(emitter, statementNode);
+        appendOutputFormat(output, "_next%d_%d:\n", region, index);
+    }
+
+    // the last label needs a statement to label
+    appendOutputLine(output, ";");
+    emitter->isGuarded = false;
+    emitter->isChecked = isChecked;
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+    emitErrorCatch(emitter, region, isConditional);
+
+    for (int i = lastThrow + 1; i < end; i++) {
+        emitStatement(emitter, ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode);
+    }
+}
+
+// What the On Error statements of part of a procedure need: the labels the part defines, the ones its
+// GoTo, GoSub and "Resume label" statements jump to, and how many plain Resume and Resume Next it has.
+// An On Error GoTo handlerLabel only repeats what is already in effect, so it is counted apart.
+typedef struct ErrorScan {
+    const char *handlerLabel;
+    int onErrorCount;
+    int repeatCount;
+    int retryCount;
+    int resumeNextCount;
+    Vector *labels;
+    Vector *targets;
+} ErrorScan;
+
+void scanErrorStatement(const StatementNode *statementNode, void *context) {
+    ErrorScan *scan = context;
+    const LabelStatementNode *labelStatementNode = statementNode->labeledStatementNode;
+    const JumpStatementNode *jumpStatementNode = statementNode->jumpStatementNode;
+
+    if (labelStatementNode != NULL && labelStatementNode->labeledStatementType == LABEL_NAMED && labelStatementNode->identifier != NULL) {
+        pushVector(scan->labels, labelStatementNode->identifier);
+    }
+
+    if (jumpStatementNode == NULL) {
+        return;
+    }
+
+    switch (jumpStatementNode->type) {
+        case JUMP_ON_ERROR_GOTO:
+        case JUMP_ON_ERROR_RESUME_NEXT: {
+            const bool isRepeat = (jumpStatementNode->type == JUMP_ON_ERROR_GOTO && scan->handlerLabel != NULL && jumpStatementNode->identifier != NULL
+                && strcasecmp(jumpStatementNode->identifier, scan->handlerLabel) == 0);
+
+            scan->repeatCount += isRepeat;
+            scan->onErrorCount += !isRepeat;
+            break;
+        }
+        case JUMP_RESUME: {
+            // "Resume 0" retries, as a bare Resume does
+            if (jumpStatementNode->identifier != NULL && strcmp(jumpStatementNode->identifier, "0") != 0) {
+                pushVector(scan->targets, jumpStatementNode->identifier);
+            }
+            else {
+                scan->retryCount++;
+            }
+
+            break;
+        }
+        case JUMP_RESUME_NEXT: {
+            scan->resumeNextCount++;
+            break;
+        }
+        case JUMP_GOTO:
+        case JUMP_GOSUB: {
+            pushVector(scan->targets, jumpStatementNode->identifier);
+            break;
+        }
+    }
+}
+
+ErrorScan scanErrorStatements(const Vector *blockItemNodes, int first, int end, const char *handlerLabel) {
+    ErrorScan scan = { handlerLabel, 0, 0, 0, 0, buildVectorList(), buildVectorList() };
+
+    for (int i = first; i < end; i++) {
+        walkStatements(((const BlockItemNode *)blockItemNodes->contents[i])->statementNode, scanErrorStatement, &scan);
+    }
+
+    return scan;
+}
+
+void freeErrorScan(ErrorScan *scan) {
+    free(scan->labels->contents);
+    free(scan->labels);
+    free(scan->targets->contents);
+    free(scan->targets);
+}
+
+// The index of the label of a procedure's one On Error GoTo handler, or -1 when it has none or the handler
+// does not lower to a single try. The first On Error GoTo has to sit in the procedure's outermost block, as
+// does the label after it, and the only other On Error statements the body may have are ones that name the
+// same label again; C# cannot jump into a try, so nothing after the label may go back to a label before it,
+// and Resume has to be in the handler.
+int findErrorHandler(const Vector *blockItemNodes, int *onError, bool *hasRetry, bool *hasResumeNext) {
+    *onError = -1;
+
+    for (int i = 0; blockItemNodes != NULL && i < blockItemNodes->size && *onError < 0; i++) {
+        const StatementNode *statementNode = ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode;
+        const JumpStatementNode *jumpStatementNode = (statementNode != NULL) ? statementNode->jumpStatementNode : NULL;
+
+        if (jumpStatementNode != NULL && jumpStatementNode->type == JUMP_ON_ERROR_GOTO && jumpStatementNode->identifier != NULL && strcmp(jumpStatementNode->identifier, "0") != 0) {
+            *onError = i;
+        }
+    }
+
+    if (*onError < 0) {
+        return -1;
+    }
+
+    const char *label = ((const BlockItemNode *)blockItemNodes->contents[*onError])->statementNode->jumpStatementNode->identifier;
+    int handler = -1;
+
+    for (int i = *onError + 1; i < blockItemNodes->size && handler < 0; i++) {
+        const StatementNode *statementNode = ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode;
+        const LabelStatementNode *labelStatementNode = (statementNode != NULL) ? statementNode->labeledStatementNode : NULL;
+
+        if (labelStatementNode != NULL && labelStatementNode->labeledStatementType == LABEL_NAMED && labelStatementNode->identifier != NULL && strcasecmp(labelStatementNode->identifier, label) == 0) {
+            handler = i;
+        }
+    }
+
+    if (handler < 0) {
+        return -1;
+    }
+
+    ErrorScan body = scanErrorStatements(blockItemNodes, 0, handler, label);
+    ErrorScan handlerScan = scanErrorStatements(blockItemNodes, handler, blockItemNodes->size, label);
+    bool isLowered = (body.onErrorCount + handlerScan.onErrorCount + handlerScan.repeatCount == 0 && body.retryCount + body.resumeNextCount == 0);
+
+    for (int i = 0; isLowered && i < handlerScan.targets->size; i++) {
+        isLowered = (findLoopVariable(body.labels, handlerScan.targets->contents[i]) == NULL);
+    }
+
+    *hasRetry = (handlerScan.retryCount > 0);
+    *hasResumeNext = (handlerScan.resumeNextCount > 0);
+    freeErrorScan(&body);
+    freeErrorScan(&handlerScan);
+
+    return isLowered ? handler : -1;
+}
+
+// Where emitHandledBody has got to in the statements it protects: the last line it numbered and If it
+// flattened, whether the last thing it emitted is a label, and whether it has warned of a Resume it cannot place.
+typedef struct HandledLines {
+    bool hasRetry;
+    bool hasResumeNext;
+    int line;
+    int ifCount;
+    bool isLabelled;
+    bool isWarned;
+} HandledLines;
+
+const Vector *getBranchStatements(const StatementNode *statementNode) {
+    return (statementNode != NULL && statementNode->compoundStatementNode != NULL) ? statementNode->compoundStatementNode->blockItemNodes : NULL;
+}
+
+bool hasBranchDeclaration(const StatementNode *statementNode) {
+    const Vector *blockItemNodes = getBranchStatements(statementNode);
+
+    for (int i = 0; blockItemNodes != NULL && i < blockItemNodes->size; i++) {
+        if (((const BlockItemNode *)blockItemNodes->contents[i])->declarationNode != NULL) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// An If whose branches can throw is flattened into gotos under Resume, so that the statements in its
+// branches are numbered like the ones around it; a Dim in a branch would then be jumped over, so that If is not.
+bool isFlattenedIf(Emitter *emitter, const StatementNode *statementNode) {
+    const SelectionStatementNode *selectionStatementNode = statementNode->selectionStatementNode;
+
+    return selectionStatementNode != NULL && selectionStatementNode->selectionType != SELECTION_MATCH
+        && (canEmittedStatementThrow(emitter, selectionStatementNode->statementNode1, true) || canEmittedStatementThrow(emitter, selectionStatementNode->statementNode2, true))
+        && !hasBranchDeclaration(selectionStatementNode->statementNode1) && !hasBranchDeclaration(selectionStatementNode->statementNode2);
+}
+
+int countHandledLines(Emitter *emitter, const StatementNode *statementNode);
+
+int countBranchLines(Emitter *emitter, const StatementNode *statementNode) {
+    const Vector *blockItemNodes = getBranchStatements(statementNode);
+    int lineCount = 0;
+
+    if (blockItemNodes == NULL) {
+        return countHandledLines(emitter, statementNode);
+    }
+
+    for (int i = 0; i < blockItemNodes->size; i++) {
+        lineCount += countHandledLines(emitter, ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode);
+    }
+
+    return lineCount;
+}
+
+int countHandledLines(Emitter *emitter, const StatementNode *statementNode) {
+    if (statementNode == NULL) {
+        return 0;
+    }
+
+    if (!isFlattenedIf(emitter, statementNode)) {
+        return canEmittedStatementThrow(emitter, statementNode, true);
+    }
+
+    const SelectionStatementNode *selectionStatementNode = statementNode->selectionStatementNode;
+    return canEmittedStatementThrow(emitter, statementNode, false) + countBranchLines(emitter, selectionStatementNode->statementNode1)
+        + countBranchLines(emitter, selectionStatementNode->statementNode2);
+}
+
+// numbers the next line: Resume goes back to its label, and Resume Next on to the one emitHandledLineEnd puts after it
+void emitHandledLineStart(Emitter *emitter, HandledLines *lines) {
+    lines->line++;
+
+    if (lines->hasRetry) {
+        appendOutputFormat(emitter->output, "_line%d:\n", lines->line);
+    }
+
+    appendOutputFormat(emitter->output, "_errorLine = %d;\n", lines->line);
+}
+
+void emitHandledLineEnd(Emitter *emitter, HandledLines *lines) {
+    if (lines->hasResumeNext) {
+        appendOutputFormat(emitter->output, "_next%d:\n", lines->line);
+        lines->isLabelled = true;
+    }
+}
+
+void emitHandledStatement(Emitter *emitter, const StatementNode *statementNode, HandledLines *lines);
+
+void emitHandledBranch(Emitter *emitter, const StatementNode *statementNode, HandledLines *lines) {
+    const Vector *blockItemNodes = getBranchStatements(statementNode);
+
+    if (blockItemNodes == NULL) {
+        emitHandledStatement(emitter, statementNode, lines);
+        return;
+    }
+
+    for (int i = 0; i < blockItemNodes->size; i++) {
+        emitHandledStatement(emitter, ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode, lines);
+    }
+}
+
+// whether a statement other than an If flattened can throw inside the statements it nests
+bool canNestedStatementThrow(Emitter *emitter, const StatementNode *statementNode) {
+    if (statementNode->selectionStatementNode != NULL) {
+        return canEmittedStatementThrow(emitter, statementNode->selectionStatementNode->statementNode1, true)
+            || canEmittedStatementThrow(emitter, statementNode->selectionStatementNode->statementNode2, true);
+    }
+
+    if (statementNode->iterationStatementNode != NULL) {
+        return canEmittedStatementThrow(emitter, statementNode->iterationStatementNode->statementNode, true);
+    }
+
+    return statementNode->compoundStatementNode != NULL && canEmittedStatementThrow(emitter, statementNode, true);
+}
+
+// One statement the try protects. A flattened If tests its condition as a line of its own, and VB's Resume
+// Next after a condition that failed goes into the Then branch. An error nested in a loop or a Select Case
+// resumes around the whole statement, which is not where VB resumes, so that is warned of once.
+void emitHandledStatement(Emitter *emitter, const StatementNode *statementNode, HandledLines *lines) {
+    OutputBuffer *output = emitter->output;
+
+    if (statementNode == NULL) {
+        return;
+    }
+
+    if (!isFlattenedIf(emitter, statementNode)) {
+        if (!canEmittedStatementThrow(emitter, statementNode, true)) {
+            emitStatement(emitter, statementNode);
+            lines->isLabelled = false;
+            return;
+        }
+
+        if (!lines->isWarned && canNestedStatementThrow(emitter, statementNode)) {
+            reportWarning(DIAGNOSTIC_UNSUPPORTED_CONSTRUCT, -1, "Resume in \"%s\" resumes after the whole loop, Select Case or If in which the error is raised",
+                getDeclaratorName(emitter->procedure->declaratorNode));
+            lines->isWarned = true;
+        }
+
+        emitHandledLineStart(emitter, lines);
+        emitStatement(emitter, statementNode);
+        lines->isLabelled = false;
+        emitHandledLineEnd(emitter, lines);
+        return;
+    }
+
+    const SelectionStatementNode *selectionStatementNode = statementNode->selectionStatementNode;
+    const int index = ++lines->ifCount;
+    const bool isLine = canEmittedStatementThrow(emitter, statementNode, false);
+
+    if (isLine) {
+        emitHandledLineStart(emitter, lines);
+    }
+
+    appendOutput(output, "if (!(");
+    emitExpression(emitter, selectionStatementNode->expressionNode);
+    appendOutputFormat(output, ")) goto _else%d;\n", index);
+    lines->isLabelled = false;
+
+    if (isLine) {
+        emitHandledLineEnd(emitter, lines);
+    }
+
+    emitHandledBranch(emitter, selectionStatementNode->statementNode1, lines);
+
+    if (selectionStatementNode->selectionType == SELECTION_IF_ELSE && selectionStatementNode->statementNode2 != NULL) {
+        appendOutputFormat(output, "goto _endIf%d;\n", index);
+        appendOutputFormat(output, "_else%d:\n", index);
+        emitHandledBranch(emitter, selectionStatementNode->statementNode2, lines);
+        appendOutputFormat(output, "_endIf%d:\n", index);
+    }
+    else {
+        appendOutputFormat(output, "_else%d:\n", index);
+    }
+
+    lines->isLabelled = true;
+}
+
+// whether control cannot fall out of the statement, so nothing emitted after it runs
+bool isJumpStatement(const StatementNode *statementNode) {
+    const JumpStatementNode *jumpStatementNode = (statementNode != NULL) ? statementNode->jumpStatementNode : NULL;
+
+    return jumpStatementNode != NULL && (jumpStatementNode->type == JUMP_RETURN || jumpStatementNode->type == JUMP_GOTO
+        || jumpStatementNode->type == JUMP_RESUME || jumpStatementNode->type == JUMP_RESUME_NEXT);
+}
+
+// On Error GoTo lowers to a single try around the statements it protects, with the handler after it. The
+// catch falls into the handler as VB's jump to the label does, and the body reaches it as falling through
+// to the label does. Arithmetic in the try is checked, as VB's overflows. For Resume, each statement that
+// can throw stores its line first, and the handler re-enters the try through a switch on it; Ifs are
+// flattened so that their statements get lines too, while an error inside a loop or a Select Case resumes
+// around that whole statement.
+bool emitHandledBody(Emitter *emitter, const CompoundStatementNode *compoundStatementNode) {
+    const Vector *blockItemNodes = compoundStatementNode->blockItemNodes;
+    OutputBuffer *output = emitter->output;
+    int onError = -1;
+    HandledLines lines = { false, false, 0, 0, false, false };
+    const int handler = findErrorHandler(blockItemNodes, &onError, &lines.hasRetry, &lines.hasResumeNext);
+    const bool hasResume = (lines.hasRetry || lines.hasResumeNext);
+
+    if (handler < 0) {
+        return false;
+    }
+
+    emitter->nodeCount++;
+    appendOutputLine(output, "{");
+    indentOutput(output);
+    emitResultDeclaration(emitter);
+
+    // VB locals live for the whole procedure, and the handler after the try reads them too
+    for (int i = 0; i < blockItemNodes->size; i++) {
+        const BlockItemNode *blockItemNode = blockItemNodes->contents[i];
+
+        if (blockItemNode->declarationNode != NULL) {
+            emitDeclaration(emitter, blockItemNode->declarationNode, false);
+        }
+        else if (i < onError && blockItemNode->statementNode != NULL) {
+            emitStatement(emitter, blockItemNode->statementNode);
+        }
+    }
+
+    int lineCount = 0;
+
+    for (int i = onError + 1; hasResume && i < handler; i++) {
+        lineCount += countHandledLines(emitter, ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode);
+    }
+
+    if (hasResume) {
+        appendOutputLine(output, "int _errorLine = 0;");
+        appendOutputLine(output, "int _errorResume = 0;");
+        appendOutputLine(output, "_try:");
+    }
+
+    appendOutputLine(output, "try");
+    appendOutputLine(output, "{");
+    indentOutput(output);
+
+    if (hasResume) {
+        appendOutputLine(output, "switch (_errorResume)");
+        appendOutputLine(output, "{");
+        indentOutput(output);
+
+        for (int i = 1; i <= lineCount; i++) {
+            if (lines.hasResumeNext) {
+                appendOutputFormat(output, "case %d: goto _next%d;\n", i, i);
+            }
+
+            if (lines.hasRetry) {
+                appendOutputFormat(output, "case %d: goto _line%d;\n", -i, i);
+            }
+        }
+
+        dedentOutput(output);
+        appendOutputLine(output, "}");
+    }
+
+    const bool isChecked = emitter->isChecked;
+    emitter->isChecked = true;
+
+    for (int i = onError + 1; i < handler; i++) {
+        const StatementNode *statementNode = ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode;
+
+        if (lineCount == 0) {
+            if (statementNode != NULL) {
+                emitStatement(emitter, statementNode);
+            }
+
+            continue;
+        }
+
+        emitHandledStatement(emitter, statementNode, &lines);
+    }
+
+    emitter->isChecked = isChecked;
+
+    // the last label needs a statement to label
+    if (lines.isLabelled) {
+        appendOutputLine(output, ";");
+    }
+
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+    emitErrorCatch(emitter, 0, false);
+
+    emitter->handlerLabel = ((const BlockItemNode *)blockItemNodes->contents[onError])->statementNode->jumpStatementNode->identifier;
+
+    for (int i = handler; i < blockItemNodes->size; i++) {
+        const BlockItemNode *blockItemNode = blockItemNodes->contents[i];
+
+        if (blockItemNode->statementNode != NULL) {
+            emitStatement(emitter, blockItemNode->statementNode);
+        }
+    }
+
+    emitter->handlerLabel = NULL;
+
+    if (!isJumpStatement(((const BlockItemNode *)blockItemNodes->contents[blockItemNodes->size - 1])->statementNode)) {
+        emitResultReturn(emitter);
+    }
+
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+
+    return true;
+}
+
+// Resume in a handler emitHandledBody lowered: Err is cleared and the try re-entered past, or at, the
+// statement that failed
+void emitResumeStatement(Emitter *emitter, const JumpStatementNode *jumpStatementNode) {
+    OutputBuffer *output = emitter->output;
+
+    if (emitter->handlerLabel == NULL) {
+        return;
+    }
+
+    appendOutputLine(output, "Microsoft.VisualBasic.CompilerServices.ProjectData.ClearProjectError();");
+
+    if (jumpStatementNode->type == JUMP_RESUME && jumpStatementNode->identifier != NULL && strcmp(jumpStatementNode->identifier, "0") != 0) {
+        appendOutputFormat(output, "goto %s;\n", jumpStatementNode->identifier);
+        return;
+    }
+
+    appendOutputLine(output, (jumpStatementNode->type == JUMP_RESUME_NEXT) ? "_errorResume = _errorLine;" : "_errorResume = -_errorLine;");
+    appendOutputLine(output, "goto _try;");
+}
+
+// A Function's result is a local that the body assigns through the function's name; every exit returns it.
+// A property setter copies C#'s value into the Let or Set's own parameter, unless that is already value.
+void emitResultDeclaration(Emitter *emitter) {
+    if (emitter->resultName != NULL) {
+        appendOutputFormat(emitter->output, "%s _result = %s;\n", emitter->resultTypeName, (strcmp(emitter->resultTypeName, "string") == 0) ? "\"\"" : "default");
+    }
+
+    const ParameterDeclarationNode *parameterDeclarationNode = emitter->propertyValue;
+
+    if (parameterDeclarationNode != NULL && strcmp(getDeclaratorName(parameterDeclarationNode->declaratorNode), "value") != 0) {
+        bool isConstant = false;
+        appendOutputFormat(emitter->output, "%s %s = value;\n", getCSharpTypeName(findTypeSpecifier(parameterDeclarationNode->declaratorSpecifierNodes, &isConstant)),
+            getDeclaratorName(parameterDeclarationNode->declaratorNode));
+    }
+}
+
+void emitResultReturn(Emitter *emitter) {
+    if (emitter->resultName != NULL) {
+        appendOutputLine(emitter->output, "return _result;");
+    }
+}
+
+void findHandlerJump(const StatementNode *statementNode, void *context) {
+    const JumpStatementNode *jumpStatementNode = statementNode->jumpStatementNode;
+
+    if (jumpStatementNode != NULL && jumpStatementNode->type == JUMP_ON_ERROR_GOTO && jumpStatementNode->identifier != NULL && strcmp(jumpStatementNode->identifier, "0") != 0) {
+        *(const char **)context = jumpStatementNode->identifier;
+    }
+}
+
+// an On Error GoTo that emitHandledBody could not lower leaves its errors unhandled, so that is said rather than left silent
+void warnUnloweredHandler(Emitter *emitter, const CompoundStatementNode *compoundStatementNode) {
+    const char *label = NULL;
+
+    for (int i = 0; compoundStatementNode != NULL && i < compoundStatementNode->blockItemNodes->size; i++) {
+        walkStatements(((const BlockItemNode *)compoundStatementNode->blockItemNodes->contents[i])->statementNode, findHandlerJump, &label);
+    }
+
+    if (label != NULL) {
+        reportWarning(DIAGNOSTIC_UNSUPPORTED_CONSTRUCT, -1, "On Error GoTo %s in \"%s\" is not lowered to a try, so its errors are not handled",
+            label, getDeclaratorName(emitter->procedure->declaratorNode));
+    }
+}
+
+// the procedure's braced body, with resultTypeName already set for a Function or Property Get
+void emitProcedureBody(Emitter *emitter, FunctionDefinitionNode *functionDefinitionNode) {
+    bool isConstant = false;
+
+    emitter->procedure = functionDefinitionNode;
+    emitter->types = NULL;
+    emitter->collections = NULL;
+    emitter->hasResumeNext = false;
+    emitter->regionCount = 0;
+    emitter->exitCount = 0;
+    emitter->resultName = (findTypeSpecifier(functionDefinitionNode->declarationSpecifierNodes, &isConstant) != NULL) ? getDeclaratorName(functionDefinitionNode->declaratorNode) : NULL;
+
+    for (int i = 0; functionDefinitionNode->compoundStatementNode != NULL && i < functionDefinitionNode->compoundStatementNode->blockItemNodes->size; i++) {
+        walkStatements(((const BlockItemNode *)functionDefinitionNode->compoundStatementNode->blockItemNodes->contents[i])->statementNode, findResumeNext, &emitter->hasResumeNext);
+    }
+
+    emitter->isResumeFlagged = emitter->hasResumeNext && hasUnknownResumeState(getControlFlowGraph(functionDefinitionNode));
+
+    if (!emitHandledBody(emitter, functionDefinitionNode->compoundStatementNode)) {
+        warnUnloweredHandler(emitter, functionDefinitionNode->compoundStatementNode);
+        emitCompoundStatement(emitter, functionDefinitionNode->compoundStatementNode);
+    }
+
+    // nothing after the emitter reads the graph, so it goes now rather than with the AST
+    if (functionDefinitionNode->controlFlowGraph != NULL) {
+        freeControlFlowGraph(functionDefinitionNode->controlFlowGraph);
+        functionDefinitionNode->controlFlowGraph = NULL;
+    }
+
+    emitter->procedure = NULL;
+    emitter->types = NULL;
+    emitter->collections = NULL;
+    emitter->resultName = NULL;
+    emitter->propertyValue = NULL;
+}
+
+void emitFunctionDefinition(Emitter *emitter, FunctionDefinitionNode *functionDefinitionNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+    bool isConstant = false;
+    const TypeSpecifierNode *typeSpecifierNode = findTypeSpecifier(functionDefinitionNode->declarationSpecifierNodes, &isConstant);
+
+    appendOutput(output, emitter->isStatic ? "public static " : "public ");
+
+    if (typeSpecifierNode != NULL && typeSpecifierNode->typeSpecifier == TYPE_VARIANT) {
+        emitter->procedure = functionDefinitionNode;
+        emitter->resultTypeName = getVariantTypeName(emitter, getDeclaratorName(functionDefinitionNode->declaratorNode));
+    }
+    else {
+        emitter->resultTypeName = (typeSpecifierNode != NULL) ? getCSharpTypeName(typeSpecifierNode) : "void";
+    }
+
+    appendOutput(output, emitter->resultTypeName);
+    appendOutputLength(output, " ", 1);
+    appendOutput(output, getDeclaratorName(functionDefinitionNode->declaratorNode));
+    appendOutputLength(output, "(", 1);
+    emitParameters(emitter, getParameterTypeList(functionDefinitionNode->declaratorNode));
+    appendOutputLine(output, ")");
+
+    emitProcedureBody(emitter, functionDefinitionNode);
+    appendOutputLength(output, "\n", 1);
+}
+
+// the only parameter of a Property Let or Set, or NULL when it takes more or none
+const ParameterDeclarationNode *getSoleParameter(const FunctionDefinitionNode *functionDefinitionNode) {
+    const ParameterTypeListNode *parameterTypeListNode = getParameterTypeList(functionDefinitionNode->declaratorNode);
+    const ParameterListNode *parameterListNode = (parameterTypeListNode != NULL) ? parameterTypeListNode->parameterListNode : NULL;
+
+    if (parameterListNode == NULL || parameterListNode->parameterListNode != NULL || parameterListNode->parameterDeclarationNode == NULL
+        || parameterListNode->parameterDeclarationNode->declaratorNode == NULL || isArrayDeclarator(parameterListNode->parameterDeclarationNode->declaratorNode)) {
+        return NULL;
+    }
+
+    return parameterListNode->parameterDeclarationNode;
+}
+
+// A parameterless Property Get and the one Let or Set of the same name and type become a C# property; anything
+// else, such as an indexed property or one with both a Let and a Set, stays a pair of methods. Finds the other
+// half of the pair the accessor at index belongs to, or -1.
+int findPropertyPartner(const Vector *externalDeclarationNodes, int index) {
+    const FunctionDefinitionNode *accessors[3] = { NULL, NULL, NULL };
+    const FunctionDefinitionNode *functionDefinitionNode = ((const ExternalDeclarationNode *)externalDeclarationNodes->contents[index])->functionDefinitionNode;
+    const char *name = getDeclaratorName(functionDefinitionNode->declaratorNode);
+    int positions[3] = { -1, -1, -1 };
+    bool isRepeated = false;
+
+    for (int i = 0; i < externalDeclarationNodes->size; i++) {
+        const ExternalDeclarationNode *externalDeclarationNode = externalDeclarationNodes->contents[i];
+        const FunctionDefinitionNode *candidate = (externalDeclarationNode != NULL) ? externalDeclarationNode->functionDefinitionNode : NULL;
+
+        if (candidate != NULL && candidate->accessor != 0 && strcasecmp(getDeclaratorName(candidate->declaratorNode), name) == 0) {
+            const int slot = (candidate->accessor == TK_GET) ? 0 : (candidate->accessor == TK_LET) ? 1 : 2;
+            isRepeated = isRepeated || positions[slot] >= 0;
+            positions[slot] = i;
+            accessors[slot] = candidate;
+        }
+    }
+
+    const int setter = (positions[1] >= 0) ? 1 : 2;
+    bool isConstant = false;
+
+    if (isRepeated || positions[0] < 0 || (positions[1] >= 0) == (positions[2] >= 0)
+        || getParameterTypeList(accessors[0]->declaratorNode)->parameterListNode != NULL || getSoleParameter(accessors[setter]) == NULL) {
+        return -1;
+    }
+
+    const TypeSpecifierNode *resultType = findTypeSpecifier(accessors[0]->declarationSpecifierNodes, &isConstant);
+    const TypeSpecifierNode *valueType = findTypeSpecifier(getSoleParameter(accessors[setter])->declaratorSpecifierNodes, &isConstant);
+
+    if (strcmp(getCSharpTypeName(resultType), getCSharpTypeName(valueType)) != 0) {
+        return -1;
+    }
+
+    return (positions[0] == index) ? positions[setter] : positions[0];
+}
+
+// A property's type is the one its callers see, so a Variant one stays object rather than narrowing.
+void emitProperty(Emitter *emitter, FunctionDefinitionNode *getter, FunctionDefinitionNode *setter) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+    bool isConstant = false;
+
+    emitter->resultTypeName = getCSharpTypeName(findTypeSpecifier(getter->declarationSpecifierNodes, &isConstant));
+    appendOutputFormat(output, emitter->isStatic ? "public static %s %s\n" : "public %s %s\n", emitter->resultTypeName, getDeclaratorName(getter->declaratorNode));
+    appendOutputLine(output, "{");
+    indentOutput(output);
+
+    appendOutputLine(output, "get");
+    emitProcedureBody(emitter, getter);
+
+    appendOutputLine(output, "set");
+    emitter->propertyValue = getSoleParameter(setter);
+    emitProcedureBody(emitter, setter);
+
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+    appendOutputLength(output, "\n", 1);
+}
+
+void emitCompoundStatement(Emitter *emitter, const CompoundStatementNode *compoundStatementNode) {
+    emitter->nodeCount++;
+
+    const Vector *blockItemNodes = compoundStatementNode->blockItemNodes;
+    const bool isGuarded = emitter->isGuarded;
+    const bool isProcedureBody = (emitter->procedure != NULL && compoundStatementNode == emitter->procedure->compoundStatementNode);
+
+    appendOutputLine(emitter->output, "{");
+    indentOutput(emitter->output);
+
+    if (isProcedureBody) {
+        emitResultDeclaration(emitter);
+    }
+
+    if (isProcedureBody && emitter->isResumeFlagged) {
+        appendOutputLine(emitter->output, "bool _resumeNext = false;");
+    }
+
+    // a nested block guards its own statements, so they resume where they stand
+    emitter->isGuarded = false;
+
+    for (int i = 0; blockItemNodes != NULL && i < blockItemNodes->size; i++) {
+        const BlockItemNode *blockItemNode = blockItemNodes->contents[i];
+
+        if (blockItemNode->declarationNode != NULL) {
+            emitDeclaration(emitter, blockItemNode->declarationNode, false);
+        }
+        else if (isRegionStatement(blockItemNode->statementNode) && getResumeState(emitter, blockItemNode->statementNode) != RESUME_OFF) {
+            const int state = getResumeState(emitter, blockItemNode->statementNode);
+            int end = i + 1;
+
+            // a run shares one catch, so it stops where the state does
+            while (end < blockItemNodes->size && ((const BlockItemNode *)blockItemNodes->contents[end])->declarationNode == NULL
+                && isRegionStatement(((const BlockItemNode *)blockItemNodes->contents[end])->statementNode)
+                && getResumeState(emitter, ((const BlockItemNode *)blockItemNodes->contents[end])->statementNode) == state) {
+                end++;
+            }
+
+            emitResumeRegion(emitter, blockItemNodes, i, end, state == RESUME_UNKNOWN);
+            i = end - 1;
+        }
+        else if (blockItemNode->statementNode != NULL) {
+            emitStatement(emitter, blockItemNode->statementNode);
+        }
+    }
+
+    if (isProcedureBody) {
+        emitResultReturn(emitter);
+    }
+
+    emitter->isGuarded = isGuarded;
+    dedentOutput(emitter->output);
+    appendOutputLine(emitter->output, "}");
+}
+
+// bodies of if/while/for are always braced
+void emitBodyStatement(Emitter *emitter, const StatementNode *statementNode) {
+    emitter->nodeCount++;
+
+    if (statementNode != NULL && statementNode->compoundStatementNode != NULL) {
+        emitCompoundStatement(emitter, statementNode->compoundStatementNode);
+        return;
+    }
+
+    const bool isGuarded = emitter->isGuarded;
+
+    appendOutputLine(emitter->output, "{");
+    indentOutput(emitter->output);
+    emitter->isGuarded = false;
+
+    if (statementNode != NULL) {
+        emitStatement(emitter, statementNode);
+    }
+
+    emitter->isGuarded = isGuarded;
+    dedentOutput(emitter->output);
+    appendOutputLine(emitter->output, "}");
+}
+
+void emitSelectionStatement(Emitter *emitter, const SelectionStatementNode *selectionStatementNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+
+    const bool isSwitch = (selectionStatementNode->selectionType == SELECTION_MATCH);
+    BreakTarget target = { NULL, 0, emitter->accumulators->size, emitter->growableArrays->size };
+
+    appendOutput(output, isSwitch ? "switch (" : "if (");
+    emitExpression(emitter, selectionStatementNode->expressionNode);
+    appendOutputLine(output, ")");
+
+    if (isSwitch) {
+        pushVector(emitter->breakTargets, &target);
+    }
+
+    emitBodyStatement(emitter, selectionStatementNode->statementNode1);
+
+    if (isSwitch) {
+        emitter->breakTargets->size--;
+    }
+
+    if (selectionStatementNode->selectionType == SELECTION_IF_ELSE && selectionStatementNode->statementNode2 != NULL) {
+        const StatementNode *elseNode = selectionStatementNode->statementNode2;
+
+        if (elseNode->selectionStatementNode != NULL && elseNode->selectionStatementNode->selectionType != SELECTION_MATCH) {
+            appendOutput(output, "else ");
+            emitSelectionStatement(emitter, elseNode->selectionStatementNode);
+        }
+        else {
+            appendOutputLine(output, "else");
+            emitBodyStatement(emitter, elseNode);
+        }
+    }
+}
+
+void emitIterationStatement(Emitter *emitter, const IterationStatementNode *iterationStatementNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+    BreakTarget target = { iterationStatementNode, 0, emitter->accumulators->size, emitter->growableArrays->size };
+
+    pushVector(emitter->breakTargets, &target);
+
+    if (iterationStatementNode->type == ITERATION_DO) {
+        appendOutputLine(output, "do");
+        emitBodyStatement(emitter, iterationStatementNode->statementNode);
+        appendOutput(output, "while (");
+        emitExpression(emitter, iterationStatementNode->expressionNode1);
+        appendOutputLine(output, ");");
+    }
+    else if (iterationStatementNode->type == ITERATION_WHILE) {
+        appendOutput(output, "while (");
+        emitExpression(emitter, iterationStatementNode->expressionNode1);
+        appendOutputLine(output, ")");
+    }
+    else {
+        appendOutput(output, "for (");
+
+        if (iterationStatementNode->expressionNode1 != NULL) {
+            emitExpression(emitter, iterationStatementNode->expressionNode1);
+        }
+
+        appendOutputLength(output, "; ", 2);
+
+        if (iterationStatementNode->expressionNode2 != NULL) {
+            emitExpression(emitter, iterationStatementNode->expressionNode2);
+        }
+
+        appendOutputLength(output, "; ", 2);
+
+        if (iterationStatementNode->expressionNode3 != NULL) {
+            emitExpression(emitter, iterationStatementNode->expressionNode3);
+        }
+
+        appendOutputLine(output, ")");
+    }
+
+    if (iterationStatementNode->type != ITERATION_DO) {
+        emitBodyStatement(emitter, iterationStatementNode->statementNode);
+    }
+
+    emitter->breakTargets->size--;
+
+    // the label sits inside any block of rewritten variables around the loop, so their copy-back still runs
+    if (target.exitLabel > 0) {
+        appendOutputFormat(output, "_exit%d:\n", target.exitLabel);
+        appendOutputLine(output, ";");
+    }
+}
+
+// A break leaves the innermost C# loop or switch. That is the VB loop being exited unless the Exit sits in a
+// Select Case or in a loop of the other kind; then it jumps to a label after the loop, copying back first
+// whatever the loops it leaves on the way have rewritten.
+void emitExitStatement(Emitter *emitter, int type) {
+    OutputBuffer *output = emitter->output;
+    const Vector *breakTargets = emitter->breakTargets;
+    BreakTarget *target = NULL;
+
+    for (int i = breakTargets->size - 1; i >= 0 && target == NULL; i--) {
+        BreakTarget *candidate = breakTargets->contents[i];
+        const IterationStatementNode *loop = candidate->loop;
+
+        if (loop != NULL && ((type == JUMP_EXIT_FOR) ? loop->type == ITERATION_FOR : (loop->type != ITERATION_FOR && !loop->isWend))) {
+            target = candidate;
+        }
+    }
+
+    if (target == NULL || target == breakTargets->contents[breakTargets->size - 1]) {
+        appendOutputLine(output, "break;");
+        return;
+    }
+
+    if (target->exitLabel == 0) {
+        target->exitLabel = ++emitter->exitCount;
+    }
+
+    const bool hasCopyBack = (target->accumulatorCount < emitter->accumulators->size || target->arrayCount < emitter->growableArrays->size);
+
+    if (hasCopyBack) {
+        appendOutputLine(output, "{");
+        indentOutput(output);
+        emitLoopCopyBack(emitter, target->accumulatorCount, target->arrayCount);
+    }
+
+    appendOutputFormat(output, "goto _exit%d;\n", target->exitLabel);
+
+    if (hasCopyBack) {
+        dedentOutput(output);
+        appendOutputLine(output, "}");
+    }
+}
+
+void emitJumpStatement(Emitter *emitter, const JumpStatementNode *jumpStatementNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+
+    switch (jumpStatementNode->type) {
+        case JUMP_CONTINUE: {
+            appendOutputLine(output, "continue;");
+            break;
+        }
+        case JUMP_STOP: {
+            appendOutputLine(output, "System.Diagnostics.Debugger.Break();");
+            break;
+        }
+        case JUMP_EXIT_FOR:
+        case JUMP_EXIT_DO: {
+            emitExitStatement(emitter, jumpStatementNode->type);
+            break;
+        }
+        case JUMP_GOTO: {
+            appendOutputFormat(output, "goto %s;\n", jumpStatementNode->identifier);
+            break;
+        }
+        case JUMP_ON_ERROR_RESUME_NEXT:
+        case JUMP_ON_ERROR_GOTO: {
+            // the graph says which statements Resume Next reaches; only where that depends on the path is it tracked
+            if (emitter->isResumeFlagged) {
+                appendOutputFormat(output, "_resumeNext = %s;\n", (jumpStatementNode->type == JUMP_ON_ERROR_RESUME_NEXT) ? "true" : "false");
+            }
+
+            break;
+        }
+        case JUMP_RESUME:
+        case JUMP_RESUME_NEXT: {
+            emitResumeStatement(emitter, jumpStatementNode);
+            break;
+        }
+        case JUMP_RETURN: {
+            appendOutput(output, "return");
+
+            if (jumpStatementNode->expressionNode != NULL) {
+                appendOutputLength(output, " ", 1);
+                emitExpression(emitter, jumpStatementNode->expressionNode);
+            }
+            else if (emitter->resultName != NULL) {
+                appendOutput(output, " _result");
+            }
+
+            appendOutputLine(output, ";");
+            break;
+        }
+    }
+}
+
+void emitLabelStatement(Emitter *emitter, const LabelStatementNode *labelStatementNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+
+    if (labelStatementNode->labeledStatementType == LABEL_NAMED) {
+        // C# labels are statements' prefixes, so an empty one needs a statement to label
+        appendOutputFormat(output, "%s:\n", labelStatementNode->identifier);
+
+        if (labelStatementNode->statementNode != NULL) {
+            emitStatement(emitter, labelStatementNode->statementNode);
+        }
+        else {
+            appendOutputLine(output, ";");
+        }
+
+        return;
+    }
+
+    if (labelStatementNode->labeledStatementType == LABEL_CASE) {
+        appendOutput(output, "case ");
+        emitConditionalExpression(emitter, labelStatementNode->conditionalExpressionNode);
+        appendOutputLine(output, ":");
+    }
+    else {
+        appendOutputLine(output, "default:");
+    }
+
+    indentOutput(output);
+
+    if (labelStatementNode->statementNode != NULL) {
+        emitStatement(emitter, labelStatementNode->statementNode);
+    }
+
+    // "Case 1, 2" nests the labels, and only the innermost holds the body
+    if (labelStatementNode->statementNode == NULL || labelStatementNode->statementNode->labeledStatementNode == NULL) {
+        appendOutputLine(output, "break;");
+    }
+
+    dedentOutput(output);
+}
+
+void emitAppendOperands(Emitter *emitter, const ShiftExpressionNode *shiftExpressionNode, bool skipFirst) {
+    OutputBuffer *output = emitter->output;
+
+    if (isConcatenation(shiftExpressionNode->shiftExpressionNode)) {
+        emitAppendOperands(emitter, shiftExpressionNode->shiftExpressionNode, skipFirst);
+    }
+    else if (!skipFirst) {
+        appendOutput(output, ".Append(");
+        emitShiftExpression(emitter, shiftExpressionNode->shiftExpressionNode);
+        appendOutputLength(output, ")", 1);
+    }
+
+    appendOutput(output, ".Append(");
+    emitAdditionExpression(emitter, shiftExpressionNode->additionExpressionNode);
+    appendOutputLength(output, ")", 1);
+}
+
+// "s = s & a & b" and "s &= a & b" both become _sBuilder.Append(a).Append(b)
+void emitAppendStatement(Emitter *emitter, const char *accumulator, const AssignmentExpressionNode *assignmentExpressionNode) {
+    OutputBuffer *output = emitter->output;
+    const ShiftExpressionNode *concatenation = getConcatenation(assignmentExpressionNode->assignExpressionNode);
+
+    appendOutputFormat(output, "_%sBuilder", accumulator);
+
+    if (assignmentExpressionNode->assignOperator != OPERATOR_CONCAT_EQUAL) {
+        emitAppendOperands(emitter, concatenation, true);
+    }
+    else if (concatenation != NULL) {
+        emitAppendOperands(emitter, concatenation, false);
+    }
+    else {
+        appendOutput(output, ".Append(");
+        emitAssignmentExpression(emitter, assignmentExpressionNode->assignExpressionNode);
+        appendOutputLength(output, ")", 1);
+    }
+
+    appendOutputLine(output, ";");
+}
+
+// k when a ReDim appends k elements, as in "ReDim Preserve a(UBound(a) + k)", or 0 for any other
+// resize; name is the array resized, or NULL when it is not a plain variable
+int getRedimGrowth(const RedimStatementNode *redimStatementNode, const char **name) {
+    const PostfixExpressionNode *postfixExpressionNode = redimStatementNode->postfixExpressionNode;
+    const Vector *bounds = postfixExpressionNode->assignExpressionNodes;
+
+    *name = (postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS) ? getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode) : NULL;
+
+    if (*name == NULL || !redimStatementNode->isPreserve || bounds == NULL || bounds->size != 1) {
+        return 0;
+    }
+
+    const AdditionExpressionNode *additionExpressionNode = getAssignmentAddition(bounds->contents[0]);
+
+    if (additionExpressionNode == NULL || additionExpressionNode->operatorType != OPERATOR_ADD || additionExpressionNode->additionExpressionNode == NULL) {
+        return 0;
+    }
+
+    const PostfixExpressionNode *upperBound = getAdditionPostfix(additionExpressionNode->additionExpressionNode);
+    const char *boundArray = (upperBound != NULL) ? getBoundArray(upperBound, "UBound") : NULL;
+    const MultiplicationExpressionNode *multiplicationExpressionNode = additionExpressionNode->multiplicationExpressionNode;
+    const CastExpressionNode *castExpressionNode = (multiplicationExpressionNode->multiplicationExpressionNode == NULL) ? multiplicationExpressionNode->castExpressionNode : NULL;
+    const PostfixExpressionNode *step = (castExpressionNode != NULL && castExpressionNode->typeNameNode == NULL) ? getUnaryPostfix(castExpressionNode->unaryExpressionNode) : NULL;
+    const ConstantNode *constantNode = (step != NULL && step->postfixExpressionType == POSTFIX_PRIMARY && step->primaryExpressionNode != NULL) ? step->primaryExpressionNode->constantNode : NULL;
+
+    if (boundArray == NULL || strcasecmp(boundArray, *name) != 0 || constantNode == NULL || constantNode->constantType != CONSTANT_SI32) {
+        return 0;
+    }
+
+    return (constantNode->integerConstant > 0) ? constantNode->integerConstant : 0;
+}
+
+// What a loop does to the strings and arrays it could rewrite. accumulatorUses counts the appearances
+// of each string its appends account for; arrayGrowths is -1 for an array some ReDim resizes other
+// than by appending. Any jump that could leave the loop without passing its end rules the loop out,
+// since the rewritten variables are only copied back there.
+typedef struct LoopScan {
+    Vector *accumulators;
+    int *accumulatorUses;
+    Vector *arrays;
+    int *arrayGrowths;
+    bool hasJump;
+} LoopScan;
+
+int addLoopName(Vector *names, int **counts, const char *name) {
+    int i = 0;
+
+    while (i < names->size && strcasecmp(names->contents[i], name) != 0) {
+        i++;
+    }
+
+    if (i == names->size) {
+        pushVector(names, (void *)name);
+        *counts = realloc(*counts, names->size * sizeof(int));
+        (*counts)[i] = 0;
+    }
+
+    return i;
+}
+
+void scanLoopStatement(const StatementNode *statementNode, void *context) {
+    LoopScan *scan = context;
+
+    if (statementNode->jumpStatementNode != NULL) {
+        const int type = statementNode->jumpStatementNode->type;
+        scan->hasJump |= (type != JUMP_CONTINUE && type != JUMP_STOP && type != JUMP_EXIT_FOR && type != JUMP_EXIT_DO);
+        return;
+    }
+
+    if (statementNode->labeledStatementNode != NULL) {
+        scan->hasJump |= (statementNode->labeledStatementNode->labeledStatementType == LABEL_NAMED);
+        return;
+    }
+
+    if (statementNode->redimStatementNode != NULL) {
+        const char *name = NULL;
+        const int growth = getRedimGrowth(statementNode->redimStatementNode, &name);
+
+        if (name != NULL) {
+            const int i = addLoopName(scan->arrays, &scan->arrayGrowths, name);
+            scan->arrayGrowths[i] = (growth == 0 || scan->arrayGrowths[i] < 0) ? -1 : 1;
+        }
+
+        return;
+    }
+
+    const char *name = getAccumulatedIdentifier(statementNode);
+
+    if (name != NULL) {
+        const int i = addLoopName(scan->accumulators, &scan->accumulatorUses, name);
+        scan->accumulatorUses[i] += (statementNode->expressionStatementNode->expressionNode->assignExpressionNode->assignOperator == OPERATOR_CONCAT_EQUAL) ? 1 : 2;
+    }
+}
+
+// appearances of an array as a(i), UBound(a) or LBound(a), the uses that cannot see its spare capacity
+typedef struct ArrayUses {
+    const char *name;
+    int count;
+} ArrayUses;
+
+void countArrayUse(const PostfixExpressionNode *postfixExpressionNode, void *context) {
+    ArrayUses *uses = context;
+    const int type = postfixExpressionNode->postfixExpressionType;
+    const char *indexed = (type == POSTFIX_LEFT_PARENTHESIS || type == POSTFIX_LEFT_SQUARE) ? getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode) : NULL;
+    const char *bounded = getBoundArray(postfixExpressionNode, "UBound");
+
+    if (bounded == NULL) {
+        bounded = getBoundArray(postfixExpressionNode, "LBound");
+    }
+
+    uses->count += (indexed != NULL && strcasecmp(indexed, uses->name) == 0) || (bounded != NULL && strcasecmp(bounded, uses->name) == 0);
+}
+
+// the array declarator that declares name, or NULL when declarationNode declares no array by that name
+const DirectDeclaratorNode *findArrayDeclarator(const DeclarationNode *declarationNode, const char *name) {
+    for (int i = 0; declarationNode != NULL && i < declarationNode->initializeDeclaratorNodes->size; i++) {
+        const InitializeDeclaratorNode *initializeDeclaratorNode = declarationNode->initializeDeclaratorNodes->contents[i];
+
+        if (strcasecmp(getDeclaratorName(initializeDeclaratorNode->declaratorNode), name) == 0) {
+            return isArrayDeclarator(initializeDeclaratorNode->declaratorNode) ? getNamedDirectDeclarator(initializeDeclaratorNode->declaratorNode->directDeclaratorNode) : NULL;
+        }
+    }
+
+    return NULL;
+}
+
+// the dimensions of a fixed array, a local's or else a member's; 1 for any other array
+int getArrayRank(Emitter *emitter, const char *name) {
+    const DirectDeclaratorNode *directDeclaratorNode = NULL;
+    bool isLocal = false;
+
+    if (emitter->procedure != NULL) {
+        const ControlFlowGraph *graph = getControlFlowGraph(emitter->procedure);
+        const int variable = findCfgVariable(graph, name);
+
+        isLocal = (findParameter(emitter->procedure, name) != NULL || variable >= 0);
+        directDeclaratorNode = (variable >= 0 && graph->variables[variable].kind == VARIABLE_LOCAL) ? findArrayDeclarator(graph->variables[variable].declarationNode, name) : NULL;
+    }
+
+    for (int i = 0; !isLocal && directDeclaratorNode == NULL && i < emitter->memberDeclarations->size; i++) {
+        directDeclaratorNode = findArrayDeclarator(emitter->memberDeclarations->contents[i], name);
+    }
+
+    return (directDeclaratorNode != NULL && directDeclaratorNode->dimensionNodes != NULL) ? directDeclaratorNode->dimensionNodes->size + 1 : 1;
+}
+
+// the lower bound every ReDim of a dynamic array sizes it from, or -1 when they differ or one is not known
+typedef struct RedimBases {
+    const char *name;
+    int lowerBound;
+    bool isResized;
+} RedimBases;
+
+void scanRedimBase(const StatementNode *statementNode, void *context) {
+    RedimBases *bases = context;
+    const RedimStatementNode *redimStatementNode = statementNode->redimStatementNode;
+    const PostfixExpressionNode *postfixExpressionNode = (redimStatementNode != NULL) ? redimStatementNode->postfixExpressionNode : NULL;
+    const char *name = (postfixExpressionNode != NULL && postfixExpressionNode->postfixExpressionType == POSTFIX_LEFT_PARENTHESIS) ? getPostfixIdentifier(postfixExpressionNode->postfixExpressionNode) : NULL;
+
+    if (name != NULL && strcasecmp(name, bases->name) == 0) {
+        bases->lowerBound = (!bases->isResized || bases->lowerBound == redimStatementNode->lowerBound) ? redimStatementNode->lowerBound : -1;
+        bases->isResized = true;
+    }
+}
+
+// An array's lower bound where it is known, or -1. A fixed array says so in its declaration. A dynamic local
+// must be sized from the same bound by every ReDim in the procedure and never be assigned or passed whole,
+// where a callee could size it from elsewhere; parameters and dynamic fields could come from anywhere.
+int getArrayLowerBound(Emitter *emitter, const char *name) {
+    if (emitter->procedure != NULL) {
+        if (findParameter(emitter->procedure, name) != NULL) {
+            return -1;
+        }
+
+        const ControlFlowGraph *graph = getControlFlowGraph(emitter->procedure);
+        const int variable = findCfgVariable(graph, name);
+
+        if (variable >= 0) {
+            const DirectDeclaratorNode *directDeclaratorNode = (graph->variables[variable].kind == VARIABLE_LOCAL) ? findArrayDeclarator(graph->variables[variable].declarationNode, name) : NULL;
+
+            if (directDeclaratorNode == NULL || !directDeclaratorNode->isDynamic) {
+                return (directDeclaratorNode != NULL) ? directDeclaratorNode->lowerBound : -1;
+            }
+
+            const Vector *blockItemNodes = emitter->procedure->compoundStatementNode->blockItemNodes;
+            RedimBases bases = { name, 0, false };
+            ArrayUses uses = { name, 0 };
+            int identifierUses = 0;
+
+            for (int i = 0; blockItemNodes != NULL && i < blockItemNodes->size; i++) {
+                const StatementNode *statementNode = ((const BlockItemNode *)blockItemNodes->contents[i])->statementNode;
+
+                walkStatements(statementNode, scanRedimBase, &bases);
+
+                if (statementNode != NULL) {
+                    walkStatementPostfixes(statementNode, countArrayUse, &uses);
+                    identifierUses += countIdentifierUses(statementNode, name);
+                }
+            }
+
+            return (uses.count == identifierUses) ? bases.lowerBound : -1;
+        }
+    }
+
+    for (int i = 0; i < emitter->memberDeclarations->size; i++) {
+        const DirectDeclaratorNode *directDeclaratorNode = findArrayDeclarator(emitter->memberDeclarations->contents[i], name);
+
+        if (directDeclaratorNode != NULL) {
+            return directDeclaratorNode->isDynamic ? -1 : directDeclaratorNode->lowerBound;
+        }
+    }
+
+    return -1;
+}
+
+bool hasErrorHandler(const ControlFlowGraph *graph) {
+    for (int i = 0; i < graph->instructionCount; i++) {
+        if (graph->instructions[i].kind == CFG_ERROR_HANDLER) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A string local or ByVal parameter that a loop only ever appends to is built in _sBuilder for the length
+// of the loop, and a local array it only ever grows with "ReDim Preserve a(UBound(a) + k)" gets spare capacity
+// that doubles as it fills, with its length kept aside in _aCount. Only an array known to start at 0
+// qualifies, since its count is its upper bound plus one. Either way n appends copy O(n) characters or
+// elements rather than O(n^2). Pushes each rewritten variable's declared name.
+void pushLoopRewrites(Emitter *emitter, const StatementNode *statementNode, int *builderCount, int *arrayCount) {
+    LoopScan scan = { buildVectorList(), NULL, buildVectorList(), NULL, false };
+
+    if (emitter->procedure != NULL) {
+        walkStatements(statementNode, scanLoopStatement, &scan);
+    }
+
+    if (scan.accumulators->size + scan.arrays->size > 0 && !scan.hasJump && !hasErrorHandler(getControlFlowGraph(emitter->procedure))) {
+        ControlFlowGraph *graph = emitter->procedure->controlFlowGraph;
+
+        if (scan.accumulators->size > 0 && emitter->types == NULL) {
+            emitter->types = getInferredTypes(graph, emitter->symbols);
+        }
+
+        for (int i = 0; i < scan.accumulators->size; i++) {
+            const int variable = findCfgVariable(graph, scan.accumulators->contents[i]);
+            const CfgVariable *cfgVariable = (variable >= 0) ? &graph->variables[variable] : NULL;
+            const ParameterDeclarationNode *parameterDeclarationNode = (cfgVariable != NULL && cfgVariable->kind == VARIABLE_PARAMETER) ? findParameter(emitter->procedure, cfgVariable->name) : NULL;
+
+            // a ByRef parameter is the caller's variable and a Function's result is its return value, both of
+            // which other code may read while the loop runs, so only locals and ByVal parameters are rewritten
+            const bool isRewritable = cfgVariable != NULL && (cfgVariable->kind == VARIABLE_LOCAL || (parameterDeclarationNode != NULL && parameterDeclarationNode->isByVal));
+            const char *name = isRewritable ? cfgVariable->name : NULL;
+
+            // any other read or write of the string inside the loop would see a stale value
+            if (name != NULL && emitter->types->variables[variable].kind == INFERRED_STRING && findLoopVariable(emitter->accumulators, name) == NULL
+                && countIdentifierUses(statementNode, name) == scan.accumulatorUses[i]) {
+                pushVector(emitter->accumulators, (void *)name);
+                (*builderCount)++;
+            }
+        }
+
+        for (int i = 0; i < scan.arrays->size; i++) {
+            const int variable = findCfgVariable(graph, scan.arrays->contents[i]);
+            const char *name = (variable >= 0 && graph->variables[variable].kind == VARIABLE_LOCAL) ? graph->variables[variable].name : NULL;
+            ArrayUses uses = { name, 0 };
+
+            if (name == NULL || scan.arrayGrowths[i] < 0 || findLoopVariable(emitter->growableArrays, name) != NULL || getArrayLowerBound(emitter, name) != 0) {
+                continue;
+            }
+
+            // passing the array itself anywhere would expose the spare capacity
+            walkStatementPostfixes(statementNode, countArrayUse, &uses);
+
+            if (uses.count == countIdentifierUses(statementNode, name)) {
+                pushVector(emitter->growableArrays, (void *)name);
+                (*arrayCount)++;
+            }
+        }
+    }
+
+    free(scan.accumulators->contents);
+    free(scan.accumulators);
+    free(scan.accumulatorUses);
+    free(scan.arrays->contents);
+    free(scan.arrays);
+    free(scan.arrayGrowths);
+}
+
+// the rewritten variables from firstBuilder and firstArray on get their final values back
+void emitLoopCopyBack(Emitter *emitter, int firstBuilder, int firstArray) {
+    OutputBuffer *output = emitter->output;
+
+    for (int i = firstBuilder; i < emitter->accumulators->size; i++) {
+        const char *name = emitter->accumulators->contents[i];
+        appendOutputFormat(output, "%s = _%sBuilder.ToString();\n", name, name);
+    }
+
+    for (int i = firstArray; i < emitter->growableArrays->size; i++) {
+        const char *name = emitter->growableArrays->contents[i];
+
+        appendOutputFormat(output, "if (%s != null && %s.Length != _%sCount)\n", name, name, name);
+        appendOutputLine(output, "{");
+        indentOutput(output);
+        appendOutputFormat(output, "Array.Resize(ref %s, _%sCount);\n", name, name);
+        dedentOutput(output);
+        appendOutputLine(output, "}");
+    }
+}
+
+// The rewritten variables live in a block around the loop, so that sibling loops can each declare
+// their own; they are set up before the loop and copied back after it.
+void emitLoopStatement(Emitter *emitter, const StatementNode *statementNode) {
+    OutputBuffer *output = emitter->output;
+    int builderCount = 0;
+    int arrayCount = 0;
+
+    pushLoopRewrites(emitter, statementNode, &builderCount, &arrayCount);
+
+    if (builderCount + arrayCount == 0) {
+        emitIterationStatement(emitter, statementNode->iterationStatementNode);
+        return;
+    }
+
+    const int firstBuilder = emitter->accumulators->size - builderCount;
+    const int firstArray = emitter->growableArrays->size - arrayCount;
+
+    appendOutputLine(output, "{");
+    indentOutput(output);
+
+    for (int i = firstBuilder; i < emitter->accumulators->size; i++) {
+        const char *name = emitter->accumulators->contents[i];
+        appendOutputFormat(output, "var _%sBuilder = new System.Text.StringBuilder(%s);\n", name, name);
+    }
+
+    for (int i = firstArray; i < emitter->growableArrays->size; i++) {
+        const char *name = emitter->growableArrays->contents[i];
+        appendOutputFormat(output, "var _%sCount = (%s != null) ? %s.Length : 0;\n", name, name, name);
+    }
+
+    emitIterationStatement(emitter, statementNode->iterationStatementNode);
+    emitLoopCopyBack(emitter, firstBuilder, firstArray);
+
+    emitter->accumulators->size = firstBuilder;
+    emitter->growableArrays->size = firstArray;
+
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+}
+
+// the element type of an array a ReDim sizes: a local's from its Dim, a module or class array's from
+// the declarations emitted before the procedure
+const char *getArrayTypeName(Emitter *emitter, const char *name) {
+    bool isConstant = false;
+
+    if (name != NULL && emitter->procedure != NULL) {
+        const ControlFlowGraph *graph = getControlFlowGraph(emitter->procedure);
+        const int variable = findCfgVariable(graph, name);
+
+        if (variable >= 0) {
+            const DeclarationNode *declarationNode = graph->variables[variable].declarationNode;
+            return (declarationNode != NULL) ? getCSharpTypeName(findTypeSpecifier(declarationNode->declarationSpecifierNodes, &isConstant)) : "object";
+        }
+    }
+
+    for (int i = 0; name != NULL && i < emitter->memberDeclarations->size; i++) {
+        const DeclarationNode *declarationNode = emitter->memberDeclarations->contents[i];
+
+        for (int j = 0; j < declarationNode->initializeDeclaratorNodes->size; j++) {
+            const InitializeDeclaratorNode *initializeDeclaratorNode = declarationNode->initializeDeclaratorNodes->contents[j];
+
+            if (strcasecmp(getDeclaratorName(initializeDeclaratorNode->declaratorNode), name) == 0) {
+                return getCSharpTypeName(findTypeSpecifier(declarationNode->declarationSpecifierNodes, &isConstant));
+            }
+        }
+    }
+
+    return "object";
+}
+
+void emitRedimStatement(Emitter *emitter, const RedimStatementNode *redimStatementNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+    const PostfixExpressionNode *postfixExpressionNode = redimStatementNode->postfixExpressionNode;
+    const PostfixExpressionNode *array = postfixExpressionNode->postfixExpressionNode;
+    const Vector *bounds = postfixExpressionNode->assignExpressionNodes;
+    const char *name = NULL;
+    const int growth = getRedimGrowth(redimStatementNode, &name);
+    const char *growable = (growth > 0) ? findLoopVariable(emitter->growableArrays, name) : NULL;
+
+    if (growable != NULL) {
+        appendOutputFormat(output, "_%sCount += %d;\n", growable, growth);
+        appendOutputFormat(output, "if (_%sCount > %s.Length)\n", growable, growable);
+        appendOutputLine(output, "{");
+        indentOutput(output);
+        appendOutputFormat(output, "Array.Resize(ref %s, Math.Max(_%sCount, 2 * %s.Length));\n", growable, growable, growable);
+        dedentOutput(output);
+        appendOutputLine(output, "}");
+        return;
+    }
+
+    if (array == NULL || bounds == NULL || bounds->size == 0) {
+        return;
+    }
+
+    if (redimStatementNode->isPreserve && bounds->size == 1) {
+        appendOutput(output, "Array.Resize(ref ");
+        emitPostfixExpression(emitter, array);
+        appendOutputLength(output, ", ", 2);
+        emitAssignmentExpression(emitter, bounds->contents[0]);
+        appendOutputLine(output, " + 1);");
+        return;
+    }
+
+    const char *typeName = getArrayTypeName(emitter, getPostfixIdentifier(array));
+
+    emitPostfixExpression(emitter, array);
+    appendOutputLength(output, " = ", 3);
+
+    // Array.Resize only handles one dimension; VB lets Preserve change the last of several
+    if (redimStatementNode->isPreserve) {
+        appendOutputFormat(output, "(%s[", typeName);
+
+        for (int i = 1; i < bounds->size; i++) {
+            appendOutputLength(output, ",", 1);
+        }
+
+        appendOutput(output, "])Microsoft.VisualBasic.CompilerServices.Utils.CopyArray(");
+        emitPostfixExpression(emitter, array);
+        appendOutputLength(output, ", ", 2);
+    }
+
+    appendOutputFormat(output, "new %s[", typeName);
+
+    for (int i = 0; i < bounds->size; i++) {
+        if (i > 0) {
+            appendOutputLength(output, ", ", 2);
+        }
+
+        // VB array bounds are inclusive
+        emitAssignmentExpression(emitter, bounds->contents[i]);
+        appendOutput(output, " + 1");
+    }
+
+    appendOutputLine(output, redimStatementNode->isPreserve ? "]);" : "];");
+}
+
+bool isCompareModeStatement(const Emitter *emitter, const StatementNode *statementNode) {
+    const ExpressionNode *expressionNode = statementNode->expressionStatementNode->expressionNode;
+    CollectionUse use;
+
+    if (expressionNode == NULL || expressionNode->assignExpressionNode->assignExpressionNode == NULL) {
+        return false;
+    }
+
+    return findCollectionUse(emitter, getUnaryPostfix(expressionNode->assignExpressionNode->unaryExpressionNode), &use) != NULL && use.member == MEMBER_COMPARE_MODE;
+}
+
+void emitStatement(Emitter *emitter, const StatementNode *statementNode) {
+    const int resumeState = emitter->isGuarded ? RESUME_OFF : getResumeState(emitter, statementNode);
+
+    if (resumeState != RESUME_OFF && canEmittedStatementThrow(emitter, statementNode, false)) {
+        emitGuardedStatement(emitter, statementNode, resumeState == RESUME_UNKNOWN);
+        return;
+    }
+
+    emitter->nodeCount++;
+
+    if (statementNode->compoundStatementNode != NULL) {
+        emitCompoundStatement(emitter, statementNode->compoundStatementNode);
+    }
+    else if (statementNode->expressionStatementNode != NULL) {
+        const char *accumulator = findLoopVariable(emitter->accumulators, getAccumulatedIdentifier(statementNode));
+
+        if (accumulator != NULL) {
+            emitAppendStatement(emitter, accumulator, statementNode->expressionStatementNode->expressionNode->assignExpressionNode);
+            return;
+        }
+
+        // a lowered Dictionary's CompareMode is the comparer it was constructed with
+        if (isCompareModeStatement(emitter, statementNode)) {
+            return;
+        }
+
+        if (statementNode->expressionStatementNode->expressionNode != NULL) {
+            emitExpression(emitter, statementNode->expressionStatementNode->expressionNode);
+        }
+
+        appendOutputLine(emitter->output, ";");
+    }
+    else if (statementNode->selectionStatementNode != NULL) {
+        emitSelectionStatement(emitter, statementNode->selectionStatementNode);
+    }
+    else if (statementNode->iterationStatementNode != NULL) {
+        emitLoopStatement(emitter, statementNode);
+    }
+    else if (statementNode->jumpStatementNode != NULL) {
+        emitJumpStatement(emitter, statementNode->jumpStatementNode);
+    }
+    else if (statementNode->labeledStatementNode != NULL) {
+        emitLabelStatement(emitter, statementNode->labeledStatementNode);
+    }
+    else if (statementNode->redimStatementNode != NULL) {
+        emitRedimStatement(emitter, statementNode->redimStatementNode);
+    }
+}
+
+void emitTransUnit(Emitter *emitter, const TransUnitNode *transUnitNode) {
+    emitter->nodeCount++;
+
+    OutputBuffer *output = emitter->output;
+
+    appendOutputFormat(output, "// <auto-generated from %s />\n", emitter->file->path);
+    appendOutputLine(output, "using System;");
+    appendOutputLine(output, "using Microsoft.VisualBasic;");
+    appendOutputLine(output, "using Microsoft.VisualBasic.CompilerServices;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.Constants;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.Conversion;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.DateAndTime;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.FileSystem;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.Information;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.Interaction;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.Strings;");
+    appendOutputLine(output, "using static Microsoft.VisualBasic.VBMath;");
+    appendOutputLength(output, "\n", 1);
+    appendOutputFormat(output, "namespace %s\n", emitter->namespaceName);
+    appendOutputLine(output, "{");
+    indentOutput(output);
+
+    appendOutput(output, emitter->isStatic ? "public static class " : "public partial class ");
+    appendOutputLine(output, getModuleName(emitter->symbols, emitter->file));
+    appendOutputLine(output, "{");
+    indentOutput(output);
+
+    for (int i = 0; i < transUnitNode->externalDeclarationNodes->size; i++) {
+        const ExternalDeclarationNode *externalDeclarationNode = transUnitNode->externalDeclarationNodes->contents[i];
+
+        if (externalDeclarationNode == NULL) {
+            continue;
+        }
+
+        const int partner = (externalDeclarationNode->functionDefinitionNode != NULL && externalDeclarationNode->functionDefinitionNode->accessor != 0)
+            ? findPropertyPartner(transUnitNode->externalDeclarationNodes, i) : -1;
+
+        if (partner >= 0) {
+            const ExternalDeclarationNode *partnerNode = transUnitNode->externalDeclarationNodes->contents[partner];
+
+            // the pair is emitted where its first half stands
+            if (partner > i) {
+                FunctionDefinitionNode *first = externalDeclarationNode->functionDefinitionNode;
+                FunctionDefinitionNode *second = partnerNode->functionDefinitionNode;
+                emitProperty(emitter, (first->accessor == TK_GET) ? first : second, (first->accessor == TK_GET) ? second : first);
+            }
+        }
+        else if (externalDeclarationNode->functionDefinitionNode != NULL) {
+            emitFunctionDefinition(emitter, externalDeclarationNode->functionDefinitionNode);
+        }
+        else if (externalDeclarationNode->declarationNode != NULL) {
+            emitDeclaration(emitter, externalDeclarationNode->declarationNode, true);
+        }
+    }
+
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+    dedentOutput(output);
+    appendOutputLine(output, "}");
+}
\ No newline at end of file
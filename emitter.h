@@ -0,0 +1,74 @@
+#pragma once
+
+#include "collection.h"
+#include "guard.h"
+#include "infer.h"
+#include "output.h"
+#include "parser.h"
+#include "project.h"
+#include "symbols.h"
+#include "walk.h"
+
+// A C# loop or switch around the statement being emitted, where loop is the VB loop it came from or NULL
+// for a Select Case. exitLabel numbers the label after the loop that an Exit from further in jumps to, once
+// one needs it, and accumulatorCount and arrayCount are how many rewritten variables were live inside it.
+typedef struct BreakTarget {
+    const IterationStatementNode *loop;
+    int exitLabel;
+    int accumulatorCount;
+    int arrayCount;
+} BreakTarget;
+
+// nodeCount is the number of AST nodes visited, for throughput reports. procedure is the one being
+// emitted; its types are inferred on the first Variant it declares, and collections says what its
+// Collection and Dictionary locals lower to once it declares one. accumulators names the strings the
+// enclosing loops append to through a StringBuilder and growableArrays the arrays they grow with spare
+// capacity, innermost last, and breakTargets the loops and switches around the statement, also innermost last;
+// exitCount numbers the procedure's exit labels. hasResumeNext is whether the procedure has an On Error Resume
+// Next, whose reach its graph works out, and isResumeFlagged whether some statement may run with or without it,
+// so _resumeNext tracks it at run time. isGuarded is whether a try around the statement being emitted already
+// records what it raises, and isChecked whether any try for On Error encloses it, so its arithmetic overflows as
+// VB's does rather than wrapping; regionCount numbers the procedure's guarded regions, and handlerLabel names its On
+// Error GoTo handler while that is emitted. memberDeclarations holds the module or class fields emitted so far.
+// resultName is the Function or Property Get being emitted, whose result the body assigns through its name,
+// and resultTypeName that result's type; propertyValue is the parameter of the Property Let or Set being emitted
+// as a C# setter. Names the emitter makes up start with an underscore, which no VB
+// name can, so they never clash with the procedure's locals and labels or the module's members.
+typedef struct Emitter {
+    OutputBuffer *output;
+    const ProjectFile *file;
+    const char *namespaceName;
+    const SymbolIndex *symbols;
+    bool isStatic;
+    long nodeCount;
+    FunctionDefinitionNode *procedure;
+    const InferredTypes *types;
+    const CollectionLowering *collections;
+    int variantCount;
+    int narrowedVariantCount;
+    bool hasResumeNext;
+    bool isResumeFlagged;
+    bool isGuarded;
+    bool isChecked;
+    int regionCount;
+    int exitCount;
+    const char *handlerLabel;
+    const char *resultName;
+    const char *resultTypeName;
+    const ParameterDeclarationNode *propertyValue;
+    Vector *accumulators;
+    Vector *growableArrays;
+    Vector *breakTargets;
+    Vector *memberDeclarations;
+} Emitter;
+
+Emitter *buildEmitter(const ProjectFile *file, const char *namespaceName);
+void freeEmitter(Emitter *emitter);
+void emitTransUnit(Emitter *emitter, const TransUnitNode *transUnitNode);
+void emitExpression(Emitter *emitter, const ExpressionNode *expressionNode);
+void emitAssignmentExpression(Emitter *emitter, const AssignmentExpressionNode *assignmentExpressionNode);
+void emitStatement(Emitter *emitter, const StatementNode *statementNode);
+void emitCompoundStatement(Emitter *emitter, const CompoundStatementNode *compoundStatementNode);
+void emitDeclaration(Emitter *emitter, const DeclarationNode *declarationNode, bool isMember);
+void emitFunctionDefinition(Emitter *emitter, FunctionDefinitionNode *functionDefinitionNode);
+const char *getCSharpTypeName(const TypeSpecifierNode *typeSpecifierNode);
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "guard.h"
+
+typedef struct ThrowScan {
+    const ControlFlowGraph *graph;
+    const SymbolIndex *symbols;
+} ThrowScan;
+
+bool canCastThrow(const ThrowScan *scan, const CastExpressionNode *castExpressionNode);
+bool canExpressionThrow(const ThrowScan *scan, const ExpressionNode *expressionNode);
+bool canAssignmentThrow(const ThrowScan *scan, const AssignmentExpressionNode *assignmentExpressionNode);
+
+// a bare name a read or write of which cannot fail; anything else may be a call without parentheses
+bool isPlainVariable(const ThrowScan *scan, const char *name) {
+    if (findCfgVariable(scan->graph, name) >= 0) {
+        return true;
+    }
+
+    if (scan->symbols == NULL) {
+        return false;
+    }
+
+    const IndexedSymbol *symbol = findSymbol(scan->symbols, name);
+
+    if (symbol == NULL) {
+        return false;
+    }
+
+    for (; symbol != NULL; symbol = getNextSymbol(scan->symbols, symbol)) {
+        if (symbol->kind != SYMBOL_VARIABLE && symbol->kind != SYMBOL_CONST && symbol->kind != SYMBOL_ENUM_MEMBER) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool canPostfixThrow(const ThrowScan *scan, const PostfixExpressionNode *postfixExpressionNode) {
+    switch (postfixExpressionNode->postfixExpressionType) {
+        case POSTFIX_PRIMARY: {
+            const PrimaryExpressionNode *primaryExpressionNode = postfixExpressionNode->primaryExpressionNode;
+
+            if (primaryExpressionNode == NULL) {
+                return true;
+            }
+
+            if (primaryExpressionNode->expressionNode != NULL) {
+                return canExpressionThrow(scan, primaryExpressionNode->expressionNode);
+            }
+
+            return primaryExpressionNode->identifier != NULL && !isPlainVariable(scan, primaryExpressionNode->identifier);
+        }
+        case POSTFIX_INCREMENT:
+        case POSTFIX_DECREMENT: {
+            return canPostfixThrow(scan, postfixExpressionNode->postfixExpressionNode);
+        }
+        default: {
+            return true;
+        }
+    }
+}
+
+bool canUnaryThrow(const ThrowScan *scan, const UnaryExpressionNode *unaryExpressionNode) {
+    switch (unaryExpressionNode->type) {
+        case UNARY_INCREMENT:
+        case UNARY_DECREMENT: {
+            return canUnaryThrow(scan, unaryExpressionNode->unaryExpressionNode);
+        }
+        case UNARY_OPERATOR: {
+            return canCastThrow(scan, unaryExpressionNode->castExpressionNode);
+        }
+        case UNARY_SIZE_IDENTIFIER:
+        case UNARY_SIZE_TYPE: {
+            return false;
+        }
+        case UNARY_NEW: {
+            return true;
+        }
+        default: {
+            return unaryExpressionNode->postfixExpressionNode == NULL || canPostfixThrow(scan, unaryExpressionNode->postfixExpressionNode);
+        }
+    }
+}
+
+// a conversion can overflow or find the wrong type
+bool canCastThrow(const ThrowScan *scan, const CastExpressionNode *castExpressionNode) {
+    if (castExpressionNode->typeNameNode != NULL) {
+        return true;
+    }
+
+    return castExpressionNode->unaryExpressionNode == NULL || canUnaryThrow(scan, castExpressionNode->unaryExpressionNode);
+}
+
+// a product overflows as VB's does, and division and Mod raise on a zero divisor
+bool canMultiplicationThrow(const ThrowScan *scan, const MultiplicationExpressionNode *node) {
+    if (node->multiplicationExpressionNode != NULL) {
+        return true;
+    }
+
+    return canCastThrow(scan, node->castExpressionNode);
+}
+
+// so does a sum or a difference
+bool canAdditionThrow(const ThrowScan *scan, const AdditionExpressionNode *node) {
+    if (node->additionExpressionNode != NULL) {
+        return true;
+    }
+
+    return canMultiplicationThrow(scan, node->multiplicationExpressionNode);
+}
+
+// The binary levels below all check left operand, then right; only the node types differ.
+
+bool canShiftThrow(const ThrowScan *scan, const ShiftExpressionNode *node) {
+    if (node->shiftExpressionNode != NULL && canShiftThrow(scan, node->shiftExpressionNode)) {
+        return true;
+    }
+
+    return canAdditionThrow(scan, node->additionExpressionNode);
+}
+
+bool canRelationalThrow(const ThrowScan *scan, const RelationalExpressionNode *node) {
+    if (node->relationalExpressionNode != NULL && canRelationalThrow(scan, node->relationalExpressionNode)) {
+        return true;
+    }
+
+    return canShiftThrow(scan, node->shiftExpressionNode);
+}
+
+bool canEqualThrow(const ThrowScan *scan, const EqualExpressionNode *node) {
+    if (node->equalExpressionNode != NULL && canEqualThrow(scan, node->equalExpressionNode)) {
+        return true;
+    }
+
+    return canRelationalThrow(scan, node->relationalExpressionNode);
+}
+
+bool canAndThrow(const ThrowScan *scan, const AndExpressionNode *node) {
+    if (node->andExpressionNode != NULL && canAndThrow(scan, node->andExpressionNode)) {
+        return true;
+    }
+
+    return canEqualThrow(scan, node->equalExpressionNode);
+}
+
+bool canExclusiveOrThrow(const ThrowScan *scan, const ExclusiveOrExpressionNode *node) {
+    if (node->exclusiveOrExpressionNode != NULL && canExclusiveOrThrow(scan, node->exclusiveOrExpressionNode)) {
+        return true;
+    }
+
+    return canAndThrow(scan, node->andExpressionNode);
+}
+
+bool canInclusiveOrThrow(const ThrowScan *scan, const InclusiveOrExpressionNode *node) {
+    if (node->inclusiveOrExpressionNode != NULL && canInclusiveOrThrow(scan, node->inclusiveOrExpressionNode)) {
+        return true;
+    }
+
+    return canExclusiveOrThrow(scan, node->exclusiveOrExpressionNode);
+}
+
+bool canLogicalAndThrow(const ThrowScan *scan, const LogicalAndExpressionNode *node) {
+    if (node->logicalAndExpressionNode != NULL && canLogicalAndThrow(scan, node->logicalAndExpressionNode)) {
+        return true;
+    }
+
+    return canInclusiveOrThrow(scan, node->inclusiveOrExpressionNode);
+}
+
+bool canOrThrow(const ThrowScan *scan, const OrExpressionNode *node) {
+    if (node->orExpressionNode != NULL && canOrThrow(scan, node->orExpressionNode)) {
+        return true;
+    }
+
+    return canLogicalAndThrow(scan, node->logicalAndExpressionNode);
+}
+
+bool canConditionalThrow(const ThrowScan *scan, const ConditionalExpressionNode *conditionalExpressionNode) {
+    if (canOrThrow(scan, conditionalExpressionNode->orExpressionNode)) {
+        return true;
+    }
+
+    if (conditionalExpressionNode->expressionNode != NULL && conditionalExpressionNode->conditionalExpressionNode != NULL) {
+        return canExpressionThrow(scan, conditionalExpressionNode->expressionNode) || canConditionalThrow(scan, conditionalExpressionNode->conditionalExpressionNode);
+    }
+
+    return false;
+}
+
+bool canAssignmentThrow(const ThrowScan *scan, const AssignmentExpressionNode *assignmentExpressionNode) {
+    if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL) {
+        // a store into an element or a property runs code that can fail, as does dividing into the target
+        const char *name = getUnaryIdentifier(assignmentExpressionNode->unaryExpressionNode);
+
+        if (name == NULL || !isPlainVariable(scan, name)) {
+            return true;
+        }
+
+        if (assignmentExpressionNode->assignOperator == OPERATOR_DIVIDE_EQUAL || assignmentExpressionNode->assignOperator == OPERATOR_MODULO_EQUAL) {
+            return true;
+        }
+
+        return canAssignmentThrow(scan, assignmentExpressionNode->assignExpressionNode);
+    }
+
+    return assignmentExpressionNode->conditionalExpressionNode == NULL || canConditionalThrow(scan, assignmentExpressionNode->conditionalExpressionNode);
+}
+
+bool canExpressionThrow(const ThrowScan *scan, const ExpressionNode *expressionNode) {
+    for (; expressionNode != NULL; expressionNode = expressionNode->expressionNode) {
+        if (canAssignmentThrow(scan, expressionNode->assignExpressionNode)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool canStatementThrow(const ControlFlowGraph *graph, const SymbolIndex *symbols, const StatementNode *statementNode, bool isNested) {
+    const ThrowScan scan = {graph, symbols};
+
+    if (statementNode == NULL) {
+        return false;
+    }
+
+    if (statementNode->expressionStatementNode != NULL) {
+        return canExpressionThrow(&scan, statementNode->expressionStatementNode->expressionNode);
+    }
+
+    if (statementNode->selectionStatementNode != NULL) {
+        const SelectionStatementNode *selectionStatementNode = statementNode->selectionStatementNode;
+
+        return canExpressionThrow(&scan, selectionStatementNode->expressionNode)
+            || (isNested && (canStatementThrow(graph, symbols, selectionStatementNode->statementNode1, true) || canStatementThrow(graph, symbols, selectionStatementNode->statementNode2, true)));
+    }
+
+    if (statementNode->iterationStatementNode != NULL) {
+        const IterationStatementNode *iterationStatementNode = statementNode->iterationStatementNode;
+
+        if (iterationStatementNode->declarationNodes != NULL && iterationStatementNode->declarationNodes->size > 0) {
+            return true;
+        }
+
+        return canExpressionThrow(&scan, iterationStatementNode->expressionNode1) || canExpressionThrow(&scan, iterationStatementNode->expressionNode2)
+            || canExpressionThrow(&scan, iterationStatementNode->expressionNode3) || (isNested && canStatementThrow(graph, symbols, iterationStatementNode->statementNode, true));
+    }
+
+    if (statementNode->jumpStatementNode != NULL) {
+        return statementNode->jumpStatementNode->type == JUMP_RETURN && canExpressionThrow(&scan, statementNode->jumpStatementNode->expressionNode);
+    }
+
+    if (statementNode->labeledStatementNode != NULL) {
+        return isNested && canStatementThrow(graph, symbols, statementNode->labeledStatementNode->statementNode, true);
+    }
+
+    if (statementNode->compoundStatementNode != NULL) {
+        const Vector *blockItemNodes = statementNode->compoundStatementNode->blockItemNodes;
+
+        for (int i = 0; isNested && blockItemNodes != NULL && i < blockItemNodes->size; i++) {
+            const BlockItemNode *blockItemNode = blockItemNodes->contents[i];
+
+            if (canStatementThrow(graph, symbols, blockItemNode->statementNode, true)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // ReDim allocates, and can find a fixed array or a bad bound
+    return statementNode->redimStatementNode != NULL;
+}
\ No newline at end of file
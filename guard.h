@@ -0,0 +1,12 @@
+#pragma once
+
+#include "cfg.h"
+#include "symbols.h"
+#include "walk.h"
+
+// Whether a statement can raise a run-time error in the C# it lowers to, so On Error has to guard it.
+// Reading and writing procedure variables, module variables and constants cannot, nor can comparisons
+// and concatenation on them; calls, member access, indexing, arithmetic, which overflows in VB and is
+// emitted checked where a guard catches it, conversions and New can. With isNested the statements nested
+// in an If or a loop count as well; without it only the statement's own expressions do.
+bool canStatementThrow(const ControlFlowGraph *graph, const SymbolIndex *symbols, const StatementNode *statementNode, bool isNested);
\ No newline at end of file
@@ -0,0 +1,642 @@
+#include "infer.h"
+#include "walk.h"
+
+// One inference run, kept in the graph's arena for typing expressions afterwards. declared and isArray
+// are per variable; uses maps each read's PrimaryExpressionNode to the SSA value it reads, by open addressing.
+// elements, when a caller supplies it, is each variable's collection item type; otherwise items are objects.
+struct TypeInference {
+    const ControlFlowGraph *graph;
+    const SsaForm *ssa;
+    const SymbolIndex *symbols;
+    InferredTypes *types;
+    InferredType *declared;
+    bool *isArray;
+    const void **useNodes;
+    int *useValues;
+    int useMask;
+    const InferredType *elements;
+};
+
+InferredType inferExpressionType(const TypeInference *inference, const ExpressionNode *expressionNode);
+InferredType inferAssignmentType(const TypeInference *inference, const AssignmentExpressionNode *assignmentExpressionNode);
+InferredType inferConditionalType(const TypeInference *inference, const ConditionalExpressionNode *conditionalExpressionNode);
+InferredType inferCastType(const TypeInference *inference, const CastExpressionNode *castExpressionNode);
+
+InferredType makeInferredType(int kind) {
+    return (InferredType){ kind, NULL };
+}
+
+bool isNumericType(InferredType type) {
+    return type.kind == INFERRED_INT || type.kind == INFERRED_DOUBLE;
+}
+
+InferredType joinInferredTypes(InferredType left, InferredType right) {
+    if (left.kind == INFERRED_UNKNOWN) {
+        return right;
+    }
+
+    if (right.kind == INFERRED_UNKNOWN) {
+        return left;
+    }
+
+    if (left.kind == right.kind && (left.kind != INFERRED_CLASS || strcasecmp(left.className, right.className) == 0)) {
+        return left;
+    }
+
+    return makeInferredType((isNumericType(left) && isNumericType(right)) ? INFERRED_DOUBLE : INFERRED_OBJECT);
+}
+
+// An unknown operand takes the other's type, as Empty does in VB: Empty + 1 is 1 and Empty + "a" is "a".
+InferredType combineArithmeticTypes(InferredType left, InferredType right, int operatorType) {
+    if (left.kind == INFERRED_UNKNOWN) {
+        left = right;
+    }
+
+    if (right.kind == INFERRED_UNKNOWN) {
+        right = left;
+    }
+
+    if (left.kind == INFERRED_UNKNOWN) {
+        return left;
+    }
+
+    if (operatorType == OPERATOR_ADD && left.kind == INFERRED_STRING && right.kind == INFERRED_STRING) {
+        return left;
+    }
+
+    if (!isNumericType(left) || !isNumericType(right)) {
+        return makeInferredType(INFERRED_OBJECT);
+    }
+
+    // VB's / reaches here with its left operand already cast to Double, and \ divides integers as integers
+    if (left.kind == INFERRED_DOUBLE || right.kind == INFERRED_DOUBLE) {
+        return makeInferredType(INFERRED_DOUBLE);
+    }
+
+    return left;
+}
+
+// And, Or and Xor are logical on Booleans and bitwise on integers
+InferredType combineLogicalTypes(InferredType left, InferredType right) {
+    if (left.kind == INFERRED_UNKNOWN) {
+        return right;
+    }
+
+    if (right.kind == INFERRED_UNKNOWN || (left.kind == right.kind && (left.kind == INFERRED_BOOL || left.kind == INFERRED_INT))) {
+        return left;
+    }
+
+    return makeInferredType(INFERRED_OBJECT);
+}
+
+InferredType getDeclaredType(const TypeSpecifierNode *typeSpecifierNode) {
+    if (typeSpecifierNode == NULL) {
+        return makeInferredType(INFERRED_OBJECT);
+    }
+
+    switch (typeSpecifierNode->typeSpecifier) {
+        case TYPE_SI32: {
+            return makeInferredType(INFERRED_INT);
+        }
+        case TYPE_FP64: {
+            return makeInferredType(INFERRED_DOUBLE);
+        }
+        case TYPE_SC8: {
+            return makeInferredType(INFERRED_STRING);
+        }
+        case TYPE_B8: {
+            return makeInferredType(INFERRED_BOOL);
+        }
+        case TYPE_FLOCK:
+        case TYPE_GAGGLE:
+        case TYPENAME: {
+            const char *name = typeSpecifierNode->flockName;
+
+            if (name == NULL && typeSpecifierNode->flockSpecifierNode != NULL) {
+                name = typeSpecifierNode->flockSpecifierNode->identifier;
+            }
+
+            return (name != NULL) ? (InferredType){ INFERRED_CLASS, name } : makeInferredType(INFERRED_OBJECT);
+        }
+        default: {
+            return makeInferredType(INFERRED_OBJECT);
+        }
+    }
+}
+
+// The "As" clause of a scanned declaration's first line, after its parameter list if it has one.
+// Signatures are lower-cased by the scanner.
+InferredType getSignatureType(const char *signature) {
+    const char *end = strpbrk(signature, "\r\n");
+    const char *p = strchr(signature, '(');
+    int depth = 0;
+
+    end = (end != NULL) ? end : signature + strlen(signature);
+
+    for (; p != NULL && p < end; p++) {
+        depth += (*p == '(') - (*p == ')');
+
+        if (depth == 0) {
+            break;
+        }
+    }
+
+    const char *clause = strstr((p != NULL && p < end) ? p : signature, " as ");
+
+    if (clause == NULL || clause >= end) {
+        return makeInferredType(INFERRED_OBJECT);
+    }
+
+    clause += 4;
+
+    const int length = strcspn(clause, " \t\r\n=");
+    const char *const intNames[] = { "long", "integer", "byte" };
+    const char *const doubleNames[] = { "double", "single", "currency" };
+
+    for (int i = 0; i < 3; i++) {
+        if (length == (int)strlen(intNames[i]) && strncmp(clause, intNames[i], length) == 0) {
+            return makeInferredType(INFERRED_INT);
+        }
+
+        if (length == (int)strlen(doubleNames[i]) && strncmp(clause, doubleNames[i], length) == 0) {
+            return makeInferredType(INFERRED_DOUBLE);
+        }
+    }
+
+    if (length == 6 && strncmp(clause, "string", length) == 0) {
+        return makeInferredType(INFERRED_STRING);
+    }
+
+    if (length == 7 && strncmp(clause, "boolean", length) == 0) {
+        return makeInferredType(INFERRED_BOOL);
+    }
+
+    return makeInferredType(INFERRED_OBJECT);
+}
+
+// module-level functions, properties, variables and constants, through the project's symbol index
+InferredType getSymbolType(const TypeInference *inference, const char *name) {
+    const IndexedSymbol *symbol = (inference->symbols != NULL) ? findSymbol(inference->symbols, name) : NULL;
+
+    if (symbol == NULL || symbol->next >= 0) {
+        return makeInferredType(INFERRED_OBJECT);
+    }
+
+    switch (symbol->kind) {
+        case SYMBOL_FUNCTION:
+        case SYMBOL_PROPERTY:
+        case SYMBOL_VARIABLE:
+        case SYMBOL_CONST: {
+            return getSignatureType(getIndexedSymbolSignature(inference->symbols, symbol));
+        }
+        default: {
+            return makeInferredType(INFERRED_OBJECT);
+        }
+    }
+}
+
+int hashUseNode(const void *node, int mask) {
+    return (int)((((uintptr_t)node >> 4) * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+int findUseValue(const TypeInference *inference, const void *node) {
+    for (int slot = hashUseNode(node, inference->useMask); inference->useNodes[slot] != NULL; slot = (slot + 1) & inference->useMask) {
+        if (inference->useNodes[slot] == node) {
+            return inference->useValues[slot];
+        }
+    }
+
+    return -1;
+}
+
+InferredType inferPrimaryType(const TypeInference *inference, const PrimaryExpressionNode *primaryExpressionNode) {
+    if (primaryExpressionNode->identifier != NULL) {
+        const int value = findUseValue(inference, primaryExpressionNode);
+
+        if (value < 0) {
+            return getSymbolType(inference, primaryExpressionNode->identifier);
+        }
+
+        // a whole array is not its element type
+        if (inference->isArray[inference->ssa->values[value].variable]) {
+            return makeInferredType(INFERRED_OBJECT);
+        }
+
+        return inference->types->values[value];
+    }
+
+    if (primaryExpressionNode->constantNode != NULL) {
+        switch (primaryExpressionNode->constantNode->constantType) {
+            case CONSTANT_STRING: {
+                return makeInferredType(INFERRED_STRING);
+            }
+            case CONSTANT_FP64: {
+                return makeInferredType(INFERRED_DOUBLE);
+            }
+            case CONSTANT_B8: {
+                return makeInferredType(INFERRED_BOOL);
+            }
+            default: {
+                return makeInferredType(INFERRED_INT);
+            }
+        }
+    }
+
+    if (primaryExpressionNode->expressionNode != NULL) {
+        return inferExpressionType(inference, primaryExpressionNode->expressionNode);
+    }
+
+    return makeInferredType((primaryExpressionNode->str != NULL) ? INFERRED_STRING : INFERRED_OBJECT);
+}
+
+InferredType inferPostfixType(const TypeInference *inference, const PostfixExpressionNode *postfixExpressionNode) {
+    const int type = postfixExpressionNode->postfixExpressionType;
+    const PostfixExpressionNode *base = postfixExpressionNode->postfixExpressionNode;
+
+    if (type == POSTFIX_PRIMARY || base == NULL) {
+        return (postfixExpressionNode->primaryExpressionNode != NULL) ? inferPrimaryType(inference, postfixExpressionNode->primaryExpressionNode) : makeInferredType(INFERRED_OBJECT);
+    }
+
+    if (type == POSTFIX_INCREMENT || type == POSTFIX_DECREMENT) {
+        return inferPostfixType(inference, base);
+    }
+
+    // "c.Item(k)" is the same read as "c(k)"
+    if (type == POSTFIX_LEFT_PARENTHESIS && base->postfixExpressionType == POSTFIX_DOT && base->identifier != NULL && strcasecmp(base->identifier, "Item") == 0
+        && inference->elements != NULL && getPostfixIdentifier(base->postfixExpressionNode) != NULL) {
+        const int variable = findCfgVariable(inference->graph, getPostfixIdentifier(base->postfixExpressionNode));
+        return (variable >= 0) ? inference->elements[variable] : makeInferredType(INFERRED_OBJECT);
+    }
+
+    const bool isNamed = (base->postfixExpressionType == POSTFIX_PRIMARY && base->primaryExpressionNode != NULL && base->primaryExpressionNode->identifier != NULL);
+
+    if (!isNamed || (type != POSTFIX_LEFT_PARENTHESIS && type != POSTFIX_LEFT_SQUARE)) {
+        return makeInferredType(INFERRED_OBJECT);
+    }
+
+    // VB indexes arrays, calls functions and reads a collection's default member with the same parentheses
+    const int variable = findCfgVariable(inference->graph, base->primaryExpressionNode->identifier);
+
+    if (variable >= 0 && inference->isArray[variable]) {
+        return inference->declared[variable];
+    }
+
+    if (variable >= 0) {
+        return (inference->elements != NULL) ? inference->elements[variable] : makeInferredType(INFERRED_OBJECT);
+    }
+
+    return getSymbolType(inference, base->primaryExpressionNode->identifier);
+}
+
+InferredType inferUnaryType(const TypeInference *inference, const UnaryExpressionNode *unaryExpressionNode) {
+    switch (unaryExpressionNode->type) {
+        case UNARY_INCREMENT:
+        case UNARY_DECREMENT: {
+            return inferUnaryType(inference, unaryExpressionNode->unaryExpressionNode);
+        }
+        case UNARY_OPERATOR: {
+            const InferredType operand = inferCastType(inference, unaryExpressionNode->castExpressionNode);
+
+            if (unaryExpressionNode->operatorType == OPERATOR_EXCLAMATION) {
+                return combineLogicalTypes(operand, operand);
+            }
+
+            return (operand.kind == INFERRED_UNKNOWN || isNumericType(operand)) ? operand : makeInferredType(INFERRED_OBJECT);
+        }
+        case UNARY_SIZE_IDENTIFIER:
+        case UNARY_SIZE_TYPE: {
+            return makeInferredType(INFERRED_INT);
+        }
+        case UNARY_NEW: {
+            const SpecifierQualifierNode *specifierQualifierNode = unaryExpressionNode->typeNameNode->specifierQualifierNode;
+            return getDeclaredType((specifierQualifierNode != NULL) ? specifierQualifierNode->typeSpecifierNode : NULL);
+        }
+        default: {
+            return (unaryExpressionNode->postfixExpressionNode != NULL) ? inferPostfixType(inference, unaryExpressionNode->postfixExpressionNode) : makeInferredType(INFERRED_OBJECT);
+        }
+    }
+}
+
+InferredType inferCastType(const TypeInference *inference, const CastExpressionNode *castExpressionNode) {
+    if (castExpressionNode->typeNameNode != NULL && castExpressionNode->castExpressionNode != NULL) {
+        const SpecifierQualifierNode *specifierQualifierNode = castExpressionNode->typeNameNode->specifierQualifierNode;
+        return getDeclaredType((specifierQualifierNode != NULL) ? specifierQualifierNode->typeSpecifierNode : NULL);
+    }
+
+    return inferUnaryType(inference, castExpressionNode->unaryExpressionNode);
+}
+
+InferredType inferMultiplicationType(const TypeInference *inference, const MultiplicationExpressionNode *node) {
+    const InferredType right = inferCastType(inference, node->castExpressionNode);
+
+    if (node->multiplicationExpressionNode == NULL) {
+        return right;
+    }
+
+    const int operatorType = (node->operatorType == OPERATOR_DIVIDE || node->operatorType == OPERATOR_MODULO) ? node->operatorType : OPERATOR_MULTIPLY;
+    return combineArithmeticTypes(inferMultiplicationType(inference, node->multiplicationExpressionNode), right, operatorType);
+}
+
+InferredType inferAdditionType(const TypeInference *inference, const AdditionExpressionNode *node) {
+    const InferredType right = inferMultiplicationType(inference, node->multiplicationExpressionNode);
+
+    if (node->additionExpressionNode == NULL) {
+        return right;
+    }
+
+    const int operatorType = (node->operatorType == OPERATOR_SUBTRACT) ? OPERATOR_SUBTRACT : OPERATOR_ADD;
+    return combineArithmeticTypes(inferAdditionType(inference, node->additionExpressionNode), right, operatorType);
+}
+
+InferredType inferShiftType(const TypeInference *inference, const ShiftExpressionNode *node) {
+    if (node->shiftExpressionNode == NULL) {
+        return inferAdditionType(inference, node->additionExpressionNode);
+    }
+
+    return makeInferredType((node->operatorType == OPERATOR_CONCAT) ? INFERRED_STRING : INFERRED_INT);
+}
+
+InferredType inferRelationalType(const TypeInference *inference, const RelationalExpressionNode *node) {
+    return (node->relationalExpressionNode != NULL) ? makeInferredType(INFERRED_BOOL) : inferShiftType(inference, node->shiftExpressionNode);
+}
+
+InferredType inferEqualType(const TypeInference *inference, const EqualExpressionNode *node) {
+    return (node->equalExpressionNode != NULL) ? makeInferredType(INFERRED_BOOL) : inferRelationalType(inference, node->relationalExpressionNode);
+}
+
+InferredType inferAndType(const TypeInference *inference, const AndExpressionNode *node) {
+    const InferredType right = inferEqualType(inference, node->equalExpressionNode);
+    return (node->andExpressionNode != NULL) ? combineLogicalTypes(inferAndType(inference, node->andExpressionNode), right) : right;
+}
+
+InferredType inferExclusiveOrType(const TypeInference *inference, const ExclusiveOrExpressionNode *node) {
+    const InferredType right = inferAndType(inference, node->andExpressionNode);
+    return (node->exclusiveOrExpressionNode != NULL) ? combineLogicalTypes(inferExclusiveOrType(inference, node->exclusiveOrExpressionNode), right) : right;
+}
+
+InferredType inferInclusiveOrType(const TypeInference *inference, const InclusiveOrExpressionNode *node) {
+    const InferredType right = inferExclusiveOrType(inference, node->exclusiveOrExpressionNode);
+    return (node->inclusiveOrExpressionNode != NULL) ? combineLogicalTypes(inferInclusiveOrType(inference, node->inclusiveOrExpressionNode), right) : right;
+}
+
+InferredType inferLogicalAndType(const TypeInference *inference, const LogicalAndExpressionNode *node) {
+    return (node->logicalAndExpressionNode != NULL) ? makeInferredType(INFERRED_BOOL) : inferInclusiveOrType(inference, node->inclusiveOrExpressionNode);
+}
+
+InferredType inferOrType(const TypeInference *inference, const OrExpressionNode *node) {
+    return (node->orExpressionNode != NULL) ? makeInferredType(INFERRED_BOOL) : inferLogicalAndType(inference, node->logicalAndExpressionNode);
+}
+
+InferredType inferConditionalType(const TypeInference *inference, const ConditionalExpressionNode *conditionalExpressionNode) {
+    if (conditionalExpressionNode->expressionNode != NULL && conditionalExpressionNode->conditionalExpressionNode != NULL) {
+        return joinInferredTypes(inferExpressionType(inference, conditionalExpressionNode->expressionNode), inferConditionalType(inference, conditionalExpressionNode->conditionalExpressionNode));
+    }
+
+    return inferOrType(inference, conditionalExpressionNode->orExpressionNode);
+}
+
+InferredType inferAssignmentType(const TypeInference *inference, const AssignmentExpressionNode *assignmentExpressionNode) {
+    if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL) {
+        return inferAssignmentType(inference, assignmentExpressionNode->assignExpressionNode);
+    }
+
+    return (assignmentExpressionNode->conditionalExpressionNode != NULL) ? inferConditionalType(inference, assignmentExpressionNode->conditionalExpressionNode) : makeInferredType(INFERRED_OBJECT);
+}
+
+InferredType inferExpressionType(const TypeInference *inference, const ExpressionNode *expressionNode) {
+    return inferAssignmentType(inference, expressionNode->assignExpressionNode);
+}
+
+// The value a compound assignment, ++ or -- starts from: the read of the same variable just before it.
+InferredType getPriorType(const TypeInference *inference, int reference) {
+    const CfgReference *references = inference->graph->references;
+
+    for (int i = reference - 1; i >= 0 && references[i].instruction == references[reference].instruction; i--) {
+        if (!references[i].isDefinition && references[i].variable == references[reference].variable && references[i].value >= 0) {
+            return inference->types->values[references[i].value];
+        }
+    }
+
+    return makeInferredType(INFERRED_UNKNOWN);
+}
+
+InferredType inferDefinitionType(const TypeInference *inference, int reference) {
+    const CfgReference *definition = &inference->graph->references[reference];
+
+    switch (definition->operatorType) {
+        case OPERATOR_NONE: {
+            return makeInferredType(INFERRED_UNKNOWN);
+        }
+        case OPERATOR_ASSIGN: {
+            return (definition->node != NULL) ? inferAssignmentType(inference, definition->node) : makeInferredType(INFERRED_OBJECT);
+        }
+        case OPERATOR_CONCAT_EQUAL: {
+            return makeInferredType(INFERRED_STRING);
+        }
+        default: {
+            const InferredType right = (definition->node != NULL) ? inferAssignmentType(inference, definition->node) : makeInferredType(INFERRED_INT);
+            const int operatorType = (definition->operatorType == OPERATOR_ADD_EQUAL) ? OPERATOR_ADD
+                : (definition->operatorType == OPERATOR_DIVIDE_EQUAL) ? OPERATOR_DIVIDE
+                : OPERATOR_SUBTRACT;
+
+            return combineArithmeticTypes(getPriorType(inference, reference), right, operatorType);
+        }
+    }
+}
+
+InferredType inferValueType(const TypeInference *inference, int value) {
+    const SsaForm *ssa = inference->ssa;
+    const SsaValue *ssaValue = &ssa->values[value];
+
+    if (!inference->types->isVariant[ssaValue->variable]) {
+        return inference->declared[ssaValue->variable];
+    }
+
+    switch (ssaValue->kind) {
+        case SSA_PHI: {
+            const SsaPhi *phi = &ssa->phis[ssaValue->definition];
+            InferredType type = makeInferredType(INFERRED_UNKNOWN);
+
+            for (int i = 0; i < inference->graph->blocks[phi->block].predecessorCount; i++) {
+                if (phi->operands[i] >= 0) {
+                    type = joinInferredTypes(type, inference->types->values[phi->operands[i]]);
+                }
+            }
+
+            return type;
+        }
+        case SSA_DEFINITION: {
+            return inferDefinitionType(inference, ssaValue->definition);
+        }
+        default: {
+            // an unassigned Variant is Empty, which reads as whatever it is combined with
+            return makeInferredType(INFERRED_UNKNOWN);
+        }
+    }
+}
+
+bool isArrayDeclarator(const DeclaratorNode *declaratorNode) {
+    const DirectDeclaratorNode *directDeclaratorNode = getNamedDirectDeclarator(declaratorNode->directDeclaratorNode);
+    return directDeclaratorNode != NULL && (directDeclaratorNode->conditionalExpressionNode != NULL || directDeclaratorNode->isDynamic);
+}
+
+// what each variable was declared as, and which of them are Variants that inference may narrow
+void declareInferredVariables(TypeInference *inference) {
+    const ControlFlowGraph *graph = inference->graph;
+    const ParameterTypeListNode *parameterTypeListNode = getParameterTypeList(graph->procedure->declaratorNode);
+    bool isConstant = false;
+
+    for (int variable = 0; variable < graph->variableCount; variable++) {
+        const CfgVariable *cfgVariable = &graph->variables[variable];
+        const TypeSpecifierNode *typeSpecifierNode = NULL;
+        bool isArray = false;
+
+        if (cfgVariable->kind == VARIABLE_RESULT) {
+            // other modules see a Public or Friend result as declared, so only a Private one narrows
+            typeSpecifierNode = findTypeSpecifier(graph->procedure->declarationSpecifierNodes, &isConstant);
+            inference->types->isVariant[variable] = graph->procedure->isPrivate && typeSpecifierNode != NULL && typeSpecifierNode->typeSpecifier == TYPE_VARIANT;
+        }
+        else if (cfgVariable->kind == VARIABLE_LOCAL) {
+            const Vector *initializeDeclaratorNodes = cfgVariable->declarationNode->initializeDeclaratorNodes;
+            typeSpecifierNode = findTypeSpecifier(cfgVariable->declarationNode->declarationSpecifierNodes, &isConstant);
+
+            for (int i = 0; initializeDeclaratorNodes != NULL && i < initializeDeclaratorNodes->size; i++) {
+                const InitializeDeclaratorNode *initializeDeclaratorNode = initializeDeclaratorNodes->contents[i];
+
+                if (initializeDeclaratorNode->declaratorNode != NULL && strcasecmp(getDeclaratorName(initializeDeclaratorNode->declaratorNode), cfgVariable->name) == 0) {
+                    isArray = isArrayDeclarator(initializeDeclaratorNode->declaratorNode);
+                }
+            }
+
+            inference->types->isVariant[variable] = !isArray && (typeSpecifierNode == NULL || typeSpecifierNode->typeSpecifier == TYPE_VARIANT);
+        }
+        else {
+            for (const ParameterListNode *parameterListNode = (parameterTypeListNode != NULL) ? parameterTypeListNode->parameterListNode : NULL; parameterListNode != NULL; parameterListNode = parameterListNode->parameterListNode) {
+                const ParameterDeclarationNode *parameterDeclarationNode = parameterListNode->parameterDeclarationNode;
+
+                if (parameterDeclarationNode != NULL && parameterDeclarationNode->declaratorNode != NULL && strcasecmp(getDeclaratorName(parameterDeclarationNode->declaratorNode), cfgVariable->name) == 0) {
+                    typeSpecifierNode = findTypeSpecifier(parameterDeclarationNode->declaratorSpecifierNodes, &isConstant);
+                }
+            }
+        }
+
+        inference->declared[variable] = getDeclaredType(typeSpecifierNode);
+        inference->isArray[variable] = isArray;
+    }
+}
+
+void indexUseNodes(TypeInference *inference) {
+    const ControlFlowGraph *graph = inference->graph;
+    int capacity = 16;
+
+    while (capacity < graph->referenceCount * 2) {
+        capacity *= 2;
+    }
+
+    inference->useNodes = allocateArena(graph->arena, sizeof(void *) * capacity);
+    inference->useValues = allocateArena(graph->arena, sizeof(int) * capacity);
+    inference->useMask = capacity - 1;
+
+    for (int i = 0; i < graph->referenceCount; i++) {
+        const CfgReference *reference = &graph->references[i];
+
+        if (reference->isDefinition || reference->node == NULL || reference->value < 0) {
+            continue;
+        }
+
+        int slot = hashUseNode(reference->node, inference->useMask);
+
+        while (inference->useNodes[slot] != NULL) {
+            slot = (slot + 1) & inference->useMask;
+        }
+
+        inference->useNodes[slot] = reference->node;
+        inference->useValues[slot] = reference->value;
+    }
+}
+
+// Optimistic fixpoint over the SSA values: every Variant value starts unknown and only moves up the
+// lattice, so a loop whose every assignment agrees settles on that type instead of object.
+InferredTypes *buildInferredTypes(ControlFlowGraph *graph, const SymbolIndex *symbols) {
+    const SsaForm *ssa = getSsaForm(graph);
+    InferredTypes *types = allocateArena(graph->arena, sizeof(InferredTypes));
+    TypeInference *inference = allocateArena(graph->arena, sizeof(TypeInference));
+
+    *inference = (TypeInference){ graph, ssa, symbols, types, NULL, NULL, NULL, NULL, 0, NULL };
+    types->values = allocateArena(graph->arena, sizeof(InferredType) * (ssa->valueCount + 1));
+    types->variables = allocateArena(graph->arena, sizeof(InferredType) * (graph->variableCount + 1));
+    types->isVariant = allocateArena(graph->arena, sizeof(bool) * (graph->variableCount + 1));
+    types->inference = inference;
+    inference->declared = allocateArena(graph->arena, sizeof(InferredType) * (graph->variableCount + 1));
+    inference->isArray = allocateArena(graph->arena, sizeof(bool) * (graph->variableCount + 1));
+
+    declareInferredVariables(inference);
+    indexUseNodes(inference);
+
+    for (bool isChanged = true; isChanged;) {
+        isChanged = false;
+
+        for (int value = 0; value < ssa->valueCount; value++) {
+            const InferredType type = inferValueType(inference, value);
+
+            if (type.kind != types->values[value].kind) {
+                types->values[value] = type;
+                isChanged = true;
+            }
+        }
+    }
+
+    for (int value = 0; value < ssa->valueCount; value++) {
+        const int variable = ssa->values[value].variable;
+        types->variables[variable] = joinInferredTypes(types->variables[variable], types->values[value]);
+    }
+
+    return types;
+}
+
+// Built on first request into the graph's arena, so it goes away with the graph.
+const InferredTypes *getInferredTypes(ControlFlowGraph *graph, const SymbolIndex *symbols) {
+    if (graph->types == NULL) {
+        graph->types = buildInferredTypes(graph, symbols);
+    }
+
+    return graph->types;
+}
+
+// What an expression of the graph's procedure evaluates to, given the types its variables settled on
+// and, unless NULL, the item type of each variable read as a collection.
+InferredType getExpressionInferredType(const InferredTypes *types, const InferredType *elements, const AssignmentExpressionNode *assignmentExpressionNode) {
+    TypeInference inference = *types->inference;
+
+    inference.elements = elements;
+    return inferAssignmentType(&inference, assignmentExpressionNode);
+}
+
+// the C# name of a concrete type, or NULL for unknown and object
+const char *getCSharpInferredName(InferredType type) {
+    switch (type.kind) {
+        case INFERRED_INT: {
+            return "int";
+        }
+        case INFERRED_DOUBLE: {
+            return "double";
+        }
+        case INFERRED_STRING: {
+            return "string";
+        }
+        case INFERRED_BOOL: {
+            return "bool";
+        }
+        case INFERRED_CLASS: {
+            return type.className;
+        }
+        default: {
+            return NULL;
+        }
+    }
+}
+
+// the C# type a Variant narrows to, or NULL when it has to stay object
+const char *getInferredTypeName(const InferredTypes *types, int variable) {
+    return (variable >= 0 && types->isVariant[variable]) ? getCSharpInferredName(types->variables[variable]) : NULL;
+}
\ No newline at end of file
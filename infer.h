@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ssa.h"
+#include "symbols.h"
+
+// A flat lattice: unknown is below every concrete type and object is above them all. Int and double
+// join to double, since C# widens one to the other without losing a value.
+enum InferredTypeKind {
+    INFERRED_UNKNOWN,
+    INFERRED_INT,
+    INFERRED_DOUBLE,
+    INFERRED_STRING,
+    INFERRED_BOOL,
+    INFERRED_CLASS,
+    INFERRED_OBJECT
+};
+
+typedef struct InferredType {
+    int kind;
+    const char *className;
+} InferredType;
+
+typedef struct TypeInference TypeInference;
+
+// values has one type per SSA value and variables the join over each variable's values;
+// isVariant marks the locals and result declared without a type or As Variant
+typedef struct InferredTypes {
+    InferredType *values;
+    InferredType *variables;
+    bool *isVariant;
+    const TypeInference *inference;
+} InferredTypes;
+
+InferredType joinInferredTypes(InferredType left, InferredType right);
+const InferredTypes *getInferredTypes(ControlFlowGraph *graph, const SymbolIndex *symbols);
+InferredType getExpressionInferredType(const InferredTypes *types, const InferredType *elements, const AssignmentExpressionNode *assignmentExpressionNode);
+const char *getCSharpInferredName(InferredType type);
+const char *getInferredTypeName(const InferredTypes *types, int variable);
+bool isArrayDeclarator(const DeclaratorNode *declaratorNode);
\ No newline at end of file
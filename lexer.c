@@ -1,7 +1,36 @@
+#include <limits.h>
 #include "lexer.h"
 
+#define LEXER_ARENA_BLOCK_SIZE 16384
+
+// A file's tokens and their strings live in one arena, which freeTokens releases with the vector.
+typedef struct TokenVector {
+    Vector vector;
+    Arena *arena;
+} TokenVector;
+
+// the arena of the file being lexed, which the read functions allocate from
+_Thread_local Arena *tokenArena;
+
+Token *buildToken() {
+    return allocateArena(tokenArena, sizeof(Token));
+}
+
+char *buildTokenString(int length) {
+    return allocateArena(tokenArena, length + 1);
+}
+
+// Sources are decoded to UTF-8 before lexing, so every byte >= 0x80 is part of a name.
+bool isIdentifierStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || (unsigned char)c >= 0x80;
+}
+
+bool isIdentifierCharacter(char c) {
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+}
+
 bool determineTokenType(const char *str, const char *pos, int stringLength) {
-    if (strncmp(str, pos, stringLength) == 0) {
+    if (strncmp(str, pos, stringLength) == 0 && !isIdentifierCharacter(pos[stringLength])) {
         return true;
     }
     else {
@@ -9,53 +38,124 @@ bool determineTokenType(const char *str, const char *pos, int stringLength) {
     }
 }
 
+// VB has no escapes: a doubled quote stands for one. A literal cannot span lines, so one left open stops
+// at the end of its line and is NULL, with pos on the line's end so lexing picks up again on the next one.
 Token *readString(const char *p, int *pos) {
     (*pos)++;
     int len = 0;
-    bool escape = false;
+    int quoteCount = 0;
 
     while (true) {
-        if (!escape && p[*pos + len] == '"') {
-            break;
+        if (p[*pos + len] == '\0' || p[*pos + len] == '\n' || p[*pos + len] == '\r') {
+            *pos += len;
+            return NULL;
         }
 
-        if (p[*pos + len] == '\\') {
-            escape = true;
-            len++;
-        }
-        else {
-            escape = false;
+        if (p[*pos + len] == '"') {
+            if (p[*pos + len + 1] != '"') {
+                break;
+            }
+
+            quoteCount++;
             len++;
         }
+
+        len++;
+    }
+
+    Token *token  = buildToken();
+    token->type   = TK_STRING_LITERAL;
+    token->strlen = len - quoteCount;
+    token->string = buildTokenString(token->strlen);
+
+    for (int i = 0, j = 0; i < len; i++, j++) {
+        token->string[j] = p[*pos + i];
+        i += (p[*pos + i] == '"');
     }
 
-    Token *token  = calloc(1, sizeof(Token));
-    token->type   = TK_STRING;
-    token->strlen = len;
-    token->string = malloc(sizeof(char) * token->strlen + 1);
-    strncpy(token->string, &p[*pos], token->strlen);
     token->string[token->strlen] = '\0';
 
     *pos += (len + 1);
     return token;
 }
 
+bool isRadixPrefix(const char *p, int pos) {
+    const char radix = p[pos + 1];
+    return p[pos] == '&' && (radix == 'H' || radix == 'h' || radix == 'O' || radix == 'o') && isxdigit((unsigned char)p[pos + 2]);
+}
+
+// &H and &O literals without a & suffix are Integers, so the high half of 16 bits is a sign
+Token *readRadixNumber(const char *p, int *pos) {
+    const int base = (p[*pos + 1] == 'H' || p[*pos + 1] == 'h') ? 16 : 8;
+    char *end = NULL;
+    const unsigned long value = strtoul(&p[*pos + 2], &end, base);
+
+    Token *token = buildToken();
+    token->type = TK_NUMBER;
+    token->num = (int)value;
+    *pos = end - p;
+
+    if (p[*pos] == '&') {
+        (*pos)++;
+    }
+    else if (value <= 0xFFFF) {
+        token->num = (int16_t)value;
+    }
+
+    return token;
+}
+
+// A number with a fraction, an exponent, a floating-point suffix or more than a Long holds keeps its text
+// in string; any other is num alone. Type suffixes are dropped.
 Token *readNumber(const char *p, int *pos) {
-    Token *token = calloc(1, sizeof(Token));
+    Token *token = buildToken();
     token->type = TK_NUMBER;
 
     int len = 0;
+    bool isFloat = false;
+
+    while (isdigit((unsigned char)p[*pos + len])) {
+        len++;
+    }
 
-    while (isdigit(p[*pos + len])) {
+    if (p[*pos + len] == '.' && isdigit((unsigned char)p[*pos + len + 1])) {
+        isFloat = true;
         len++;
+
+        while (isdigit((unsigned char)p[*pos + len])) {
+            len++;
+        }
+    }
+
+    if ((p[*pos + len] == 'E' || p[*pos + len] == 'e') && (isdigit((unsigned char)p[*pos + len + 1])
+        || ((p[*pos + len + 1] == '+' || p[*pos + len + 1] == '-') && isdigit((unsigned char)p[*pos + len + 2])))) {
+        isFloat = true;
+        len += 2;
+
+        while (isdigit((unsigned char)p[*pos + len])) {
+            len++;
+        }
     }
 
-    char buf[32];
-    strncpy(buf, &p[*pos], 32);
-    buf[len] = '\0';
+    const long long value = strtoll(&p[*pos], NULL, 10);
+    const char suffix = p[*pos + len];
+
+    isFloat |= (suffix == '!' || suffix == '#' || suffix == '@' || value > INT_MAX);
+
+    if (isFloat) {
+        token->strlen = len;
+        token->string = buildTokenString(len);
+        memcpy(token->string, &p[*pos], len);
+        token->string[len] = '\0';
+    }
 
-    token->num = atoi(buf);
+    token->num = (int)value;
     *pos += len;
+
+    if ((suffix == '%' || suffix == '&' || suffix == '!' || suffix == '#' || suffix == '@') && !isIdentifierCharacter(p[*pos + 1])) {
+        (*pos)++;
+    }
+
     return token;
 }
 
@@ -65,67 +165,213 @@ int getTokenType(const Vector *vec, int index) {
 }
 
 Vector *lex(char *addr) {
-    Vector *vector = buildVectorList();
+    return lexWithDefines(addr, NULL);
+}
+
+// every token is charged to the file's budget, string included
+void pushToken(Vector *vector, Token *token, int offset) {
+    token->offset = offset;
+    pushVector(vector, token);
+    chargeBudget(sizeof(Token) + sizeof(void*) + ((token->string != NULL) ? token->strlen + 1 : 0));
+}
+
+// one TK_NEWLINE ends each logical line; blank lines and the start of the file add none
+void pushNewline(Vector *vector, int offset) {
+    if (vector->size == 0 || getTokenType(vector, vector->size - 1) == TK_NEWLINE) {
+        return;
+    }
+
+    pushToken(vector, buildToken(), offset);
+    ((Token *)vector->contents[vector->size - 1])->type = TK_NEWLINE;
+}
+
+// a " _" ending the line joins the next one to it
+bool isLineContinuation(const char *p, int pos) {
+    if (p[pos] != '_' || isIdentifierCharacter(p[pos + 1]) || (pos > 0 && !isspace((unsigned char)p[pos - 1]))) {
+        return false;
+    }
+
+    for (pos++; p[pos] == ' ' || p[pos] == '\t' || p[pos] == '\r'; pos++) {
+    }
+
+    return p[pos] == '\n';
+}
+
+// the end of a ' or Rem comment, which a line continuation carries onto the next line as well
+int skipLineComment(const char *p, int pos) {
+    while (p[pos] != '\0' && p[pos] != '\n') {
+        if (isLineContinuation(p, pos)) {
+            pos = strchr(&p[pos], '\n') - p + 1;
+        }
+        else {
+            pos++;
+        }
+    }
+
+    return pos;
+}
+
+// After a . or ! every word is a member name, keyword or not, as in rs.Open or .Left
+void readMemberName(const Vector *vector, Token *token, const char *word) {
+    const int previous = (vector->size > 0) ? getTokenType(vector, vector->size - 1) : -1;
+    int len = 0;
+
+    if (token->type == TK_IDENTIFIER || (previous != TK_DOT && previous != TK_EXCLAMATION)) {
+        return;
+    }
+
+    while (isIdentifierCharacter(word[len])) {
+        len++;
+    }
+
+    token->type = TK_IDENTIFIER;
+    token->strlen = len + 1;
+    token->string = buildTokenString(len);
+    memcpy(token->string, word, len);
+    token->string[len] = '\0';
+}
+
+// Bad characters and directives are reported and skipped so one pass finds them all; the file still fails.
+// A form's or class's designer header is not code and is skipped first.
+Vector *lexWithDefines(char *addr, StringIntegerMap *defines) {
+    TokenVector *tokenVector = malloc(sizeof(TokenVector));
+    Vector *vector = &tokenVector->vector;
+    vector->contents = calloc(16, sizeof(void*));
+    vector->capacity = 16;
+    vector->size = 0;
+    tokenVector->arena = buildArena(LEXER_ARENA_BLOCK_SIZE);
+    tokenArena = tokenVector->arena;
 
-    int pos = 0;
     const char *p = addr;
+    const long length = strlen(addr);
+    int pos = skipDesignerBlock(addr, length);
     Token *token = NULL;
+    ConditionalState conditions;
+    int errorCount = 0;
+
+    initializeConditionalState(&conditions, defines);
 
     while (p[pos]) {
-        if (isspace(p[pos])) {
+        const int start = pos;
+
+        if (isOverBudget()) {
+            errorCount++;
+            break;
+        }
+
+        if (isspace((unsigned char)p[pos])) {
+            if (p[pos] == '\n') {
+                pushNewline(vector, start);
+            }
+
             pos++;
         }
+        else if (p[pos] == '\'') {
+            pos = skipLineComment(p, pos);
+        }
+        else if (isLineContinuation(p, pos)) {
+            pos = strchr(&p[pos], '\n') - p + 1;
+        }
+        else if (p[pos] == '#' && isDirectiveStart(p, pos)) {
+            if (!readDirective(p, &pos, &conditions)) {
+                errorCount++;
+            }
+
+            if (!isConditionActive(&conditions)) {
+                pos = skipInactiveLines(p, pos, length);
+            }
+        }
         else if (p[pos] == '"') {
             token = readString(p, &pos);
 
             if (token == NULL) {
-                printf("Failed to read string/char.\n");
-                return NULL;
+                reportDiagnostic(DIAGNOSTIC_UNTERMINATED_STRING, start, "unterminated string literal");
+                errorCount++;
+                continue;
             }
 
-            pushVector(vector, token);
+            pushToken(vector, token, start);
+        }
+        else if (isRadixPrefix(p, pos)) {
+            pushToken(vector, readRadixNumber(p, &pos), start);
+        }
+        else if (p[pos] == '.' && isdigit((unsigned char)p[pos + 1])) {
+            pushToken(vector, readNumber(p, &pos), start);
         }
         else if (isSymbol(p[pos])) {
             token = readSymbol(p, &pos);
 
             if (token == NULL) {
-                printf("Failed to read symbol.\n");
-                return NULL;
+                reportDiagnostic(DIAGNOSTIC_INVALID_TOKEN, start, "could not read symbol '%c'", p[start]);
+                errorCount++;
+                break;
             }
 
-            pushVector(vector, token);
+            pushToken(vector, token, start);
         }
-        else if (isalpha(p[pos]) || p[pos] == '_') {
+        else if (isIdentifierStart(p[pos])) {
             token = readKeyword(p, &pos);
 
             if (token == NULL) {
-                printf("Failed to read identifier.\n");
-                return NULL;
+                reportDiagnostic(DIAGNOSTIC_INVALID_TOKEN, start, "could not read identifier");
+                errorCount++;
+                break;
+            }
+
+            if (token->type == TK_REM) {
+                pos = skipLineComment(p, pos);
+                continue;
             }
 
-            pushVector(vector, token);
+            readMemberName(vector, token, &p[start]);
+            pushToken(vector, token, start);
         }
-        else if (isdigit(p[pos])) {
+        else if (p[pos] >= '0' && p[pos] <= '9') {
             token = readNumber(p, &pos);
 
             if (token == NULL) {
-                printf("Failed to read number.\n");
-                return NULL;
+                reportDiagnostic(DIAGNOSTIC_INVALID_TOKEN, start, "could not read number");
+                errorCount++;
+                break;
             }
 
-            pushVector(vector, token);
+            pushToken(vector, token, start);
         }
         else {
-            printf("Invalid character [token %d] = '%c'\n", pos, p[pos]);
-            return NULL;
+            reportDiagnostic(DIAGNOSTIC_INVALID_CHARACTER, start, "invalid character 0x%02x", (unsigned char)p[pos]);
+            errorCount++;
+            pos++;
         }
     }
 
+    finishConditionalState(&conditions);
+
+    if (conditions.depth > 0 && errorCount == 0) {
+        reportDiagnostic(DIAGNOSTIC_UNBALANCED_DIRECTIVE, length, "#If without #End If");
+        errorCount++;
+    }
+
+    tokenArena = NULL;
+
+    if (errorCount > 0) {
+        freeTokens(vector);
+        return NULL;
+    }
+
     return vector;
 }
 
+// tokens is what lexWithDefines returned
+void freeTokens(Vector *tokens) {
+    TokenVector *tokenVector = (TokenVector *)tokens;
+
+    freeArena(tokenVector->arena);
+    free(tokens->contents);
+    free(tokenVector);
+}
+
 Token *readSymbol(const char *p, int *pos) {
-    Token *token = calloc(1, sizeof(Token));
+    Token *token = buildToken();
 
     const char first = p[*pos];
     (*pos)++;
@@ -243,7 +489,7 @@ Token *readSymbol(const char *p, int *pos) {
                 token->type = TK_SHIFT_LEFT;
                 (*pos)++;
             }
-            if (second == '>') {
+            else if (second == '>') {
                 token->type = TK_NOT_EQUAL;
                 (*pos)++;
             }
@@ -288,6 +534,11 @@ Token *readSymbol(const char *p, int *pos) {
             token->type = TK_BACKSLASH;
             return token;
         }
+        case '#': {
+            // a file number, as in "Print #1"; a # starting a directive is read before this
+            token->type = TK_POUND;
+            return token;
+        }
         default: {
             return NULL;
         }
@@ -305,6 +556,7 @@ bool isSymbol(char p) {
         case '*':
         case '/':
         case '+':
+        case '^':
         case '-':
         case '=':
         case '!':
@@ -316,7 +568,101 @@ bool isSymbol(char p) {
         case ',':
         case '.':
         case '\'':
-        case '\\': {
+        case '\\':
+        case '#': {
+            return true;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+// VB6's own keywords; the rest of the table is VB.NET's, or form properties, which VB6 code uses as names
+bool isReservedWord(int type) {
+    switch (type) {
+        case TK_ADDRESS_OF:
+        case TK_ALIAS:
+        case TK_AND:
+        case TK_AS:
+        case TK_BOOLEAN:
+        case TK_BY_REF:
+        case TK_BYTE:
+        case TK_BY_VAL:
+        case TK_CALL:
+        case TK_CASE:
+        case TK_CONST:
+        case TK_DATE:
+        case TK_DECIMAL:
+        case TK_DECLARE:
+        case TK_DIM:
+        case TK_DO:
+        case TK_DOUBLE:
+        case TK_EACH:
+        case TK_ELSE:
+        case TK_ELSE_IF:
+        case TK_END:
+        case TK_END_IF:
+        case TK_ENUM:
+        case TK_ERASE:
+        case TK_ERROR:
+        case TK_EVENT:
+        case TK_EXIT:
+        case TK_FALSE:
+        case TK_FOR:
+        case TK_FRIEND:
+        case TK_FUNCTION:
+        case TK_GET:
+        case TK_GLOBAL:
+        case TK_GO_SUB:
+        case TK_GO_TO:
+        case TK_IF:
+        case TK_IMPLEMENTS:
+        case TK_IN:
+        case TK_INTEGER:
+        case TK_IS:
+        case TK_LET:
+        case TK_LIB:
+        case TK_LIKE:
+        case TK_LONG:
+        case TK_LOOP:
+        case TK_ME:
+        case TK_MOD:
+        case TK_NEW:
+        case TK_NEXT:
+        case TK_NOT:
+        case TK_NOTHING:
+        case TK_OBJECT:
+        case TK_ON:
+        case TK_OPTION:
+        case TK_OPTIONAL:
+        case TK_OR:
+        case TK_PARAM_ARRAY:
+        case TK_PRIVATE:
+        case TK_PROPERTY:
+        case TK_PUBLIC:
+        case TK_RAISE_EVENT:
+        case TK_REDIM:
+        case TK_REM:
+        case TK_RESUME:
+        case TK_RETURN:
+        case TK_SELECT:
+        case TK_SET:
+        case TK_SINGLE:
+        case TK_STATIC:
+        case TK_STEP:
+        case TK_STOP:
+        case TK_STRING:
+        case TK_SUB:
+        case TK_THEN:
+        case TK_TO:
+        case TK_TRUE:
+        case TK_VARIANT:
+        case TK_WEND:
+        case TK_WHILE:
+        case TK_WITH:
+        case TK_WITH_EVENTS:
+        case TK_XOR: {
             return true;
         }
         default: {
@@ -326,11 +672,11 @@ bool isSymbol(char p) {
 }
 
 Token *readKeyword(const char *p, int *pos) {
-    Token *token = malloc(sizeof(Token));
+    Token *token = buildToken();
 
     int len = 0;
     
-    while (isalpha(p[*pos + len]) || isdigit(p[*pos + len]) || p[*pos + len] == '_') {
+    while (isIdentifierCharacter(p[*pos + len])) {
         len++;
     }
 
@@ -950,8 +1296,15 @@ Token *readKeyword(const char *p, int *pos) {
         token->type = TK_IDENTIFIER;
     }
 
+    const char suffix = p[*pos + len];
+
+    // String$ and Date$ are the functions, not the types; other type suffixes only follow a name
+    if (!isReservedWord(token->type) || suffix == '$') {
+        token->type = TK_IDENTIFIER;
+    }
+
     if (token->type == TK_IDENTIFIER) {
-        token->string = malloc(sizeof(char) * len + 1);
+        token->string = buildTokenString(len);
         token->strlen = len + 1;
         strncpy(token->string, &p[*pos], len);
         token->string[len] = '\0';
@@ -959,5 +1312,9 @@ Token *readKeyword(const char *p, int *pos) {
 
     *(pos) += len;
 
+    if (token->type == TK_IDENTIFIER && (suffix == '$' || suffix == '%' || suffix == '@' || suffix == '!' || suffix == '#') && !isIdentifierCharacter(p[*pos + 1])) {
+        (*pos)++;
+    }
+
     return token;
 }
\ No newline at end of file
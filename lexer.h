@@ -1,5 +1,9 @@
 #pragma once
 
+#include "budget.h"
+#include "diagnostics.h"
+#include "directive.h"
+#include "scan.h"
 #include "util.h"
 
 // keywords
@@ -162,6 +166,7 @@
 
 // symbols
 #define TK_LEFT_SQUARE         156
+#define TK_POUND               157
 #define TK_RIGHT_SQUARE        167
 #define TK_LEFT_PARENTHESIS    168
 #define TK_RIGHT_PARENTHESIS   169
@@ -248,19 +253,28 @@
 #define TK_WIDTH               266
 #define TK_WINDOWSTATE         267
 
+// literals
+#define TK_STRING_LITERAL      268
+
 typedef struct Token {
     int   type;
     int   num;
     char *string;
     int   strlen;
     bool  hasValue;
+    int   offset;
 } Token;
 
+Vector *lex(char *addr);
+Vector *lexWithDefines(char *addr, StringIntegerMap *defines);
+void freeTokens(Vector *tokens);
 Token *readKeyword(const char *p, int *pos);
 Token *readString(const char *p, int *pos);
 Token *readSymbol(const char *p, int *pos);
 Token *readNumber(const char *p, int *pos);
+Token *readRadixNumber(const char *p, int *pos);
 int getTokenType(const Vector *vec, int index);
+bool isIdentifierStart(char c);
+bool isIdentifierCharacter(char c);
 bool isSymbol(char p);
-
-Vector *lex(char *addr);
\ No newline at end of file
+bool isReservedWord(int type);
\ No newline at end of file
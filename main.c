@@ -0,0 +1,384 @@
+#include <errno.h>
+#include <getopt.h>
+#include <strings.h>
+
+#include "buildstate.h"
+#include "directive.h"
+#include "pipeline.h"
+#include "shard.h"
+#include "symbols.h"
+#include "transpile.h"
+#include "watch.h"
+
+enum LongOption {
+    OPTION_WATCH = 256,
+    OPTION_DEBOUNCE,
+    OPTION_PIPELINE,
+    OPTION_STAGE_WORKERS,
+    OPTION_QUEUE_DEPTH,
+    OPTION_TYPELIB_DIR,
+    OPTION_CODE_PAGE,
+    OPTION_INDEX_ONLY,
+    OPTION_TIME_BUDGET,
+    OPTION_MEMORY_BUDGET,
+    OPTION_PROCESSES,
+    OPTION_WORKER_MEMORY,
+    OPTION_PROCESS_SCALING,
+    OPTION_DIAGNOSTICS,
+    OPTION_TRACE,
+    OPTION_TIME_REPORT
+};
+
+static const struct option longOptions[] = {
+    { "watch", no_argument, NULL, OPTION_WATCH },
+    { "debounce", required_argument, NULL, OPTION_DEBOUNCE },
+    { "pipeline", no_argument, NULL, OPTION_PIPELINE },
+    { "stage-workers", required_argument, NULL, OPTION_STAGE_WORKERS },
+    { "queue-depth", required_argument, NULL, OPTION_QUEUE_DEPTH },
+    { "typelib-dir", required_argument, NULL, OPTION_TYPELIB_DIR },
+    { "codepage", required_argument, NULL, OPTION_CODE_PAGE },
+    { "index-only", no_argument, NULL, OPTION_INDEX_ONLY },
+    { "time-budget", required_argument, NULL, OPTION_TIME_BUDGET },
+    { "memory-budget", required_argument, NULL, OPTION_MEMORY_BUDGET },
+    { "processes", required_argument, NULL, OPTION_PROCESSES },
+    { "worker-memory", required_argument, NULL, OPTION_WORKER_MEMORY },
+    { "process-scaling", no_argument, NULL, OPTION_PROCESS_SCALING },
+    { "diagnostics", required_argument, NULL, OPTION_DIAGNOSTICS },
+    { "trace", required_argument, NULL, OPTION_TRACE },
+    { "time-report", no_argument, NULL, OPTION_TIME_REPORT },
+    { NULL, 0, NULL, 0 }
+};
+
+void printUsage(const char *program) {
+    printf("usage: %s [-j workers] [-q] [-i] [-s state] [-o dir] [-D name[=value]] [--watch] [--debounce ms]\n", program);
+    printf("       [--pipeline] [--stage-workers r,l,p,e] [--queue-depth n] [--typelib-dir dir]\n");
+    printf("       [--codepage 1252|932|936|949|950|utf8] [--index-only]\n");
+    printf("       [--time-budget ms] [--memory-budget MB] [--processes n] [--worker-memory MB] [--process-scaling]\n");
+    printf("       [--diagnostics text|json] [--trace file.json] [--time-report]\n");
+    printf("       <project.vbp | file...>\n");
+}
+
+bool hasExtension(const char *path, const char *extension) {
+    const char *dot = strrchr(path, '.');
+    return (dot != NULL && strcasecmp(dot, extension) == 0);
+}
+
+int main(int argc, char **argv) {
+    int workerCount = getCoreCount();
+    bool perFile = true;
+    bool incremental = false;
+    bool watch = false;
+    int debounceTime = 10;
+    bool pipelined = false;
+    char *stageWorkers = NULL;
+    int queueDepth = 64;
+    char *statePath = NULL;
+    char *outputDirectory = NULL;
+    char *typeLibraryDirectory = NULL;
+    Vector *defines = buildVectorList();
+    int codePage = DEFAULT_CODE_PAGE;
+    bool indexOnly = false;
+    double fileTimeLimit = 0;
+    long fileMemoryLimit = 0;
+    int processCount = 0;
+    long workerMemoryLimit = 0;
+    bool processScaling = false;
+    int diagnosticFormat = DIAGNOSTIC_FORMAT_TEXT;
+    char *tracePath = NULL;
+    bool timeReport = false;
+    int option;
+
+    while ((option = getopt_long(argc, argv, "j:qis:o:D:h", longOptions, NULL)) != -1) {
+        switch (option) {
+            case 'j': {
+                workerCount = atoi(optarg);
+                break;
+            }
+            case 'q': {
+                perFile = false;
+                break;
+            }
+            case 'i': {
+                incremental = true;
+                break;
+            }
+            case 's': {
+                incremental = true;
+                statePath = optarg;
+                break;
+            }
+            case 'o': {
+                outputDirectory = optarg;
+                break;
+            }
+            case 'D': {
+                pushVector(defines, optarg);
+                break;
+            }
+            case OPTION_WATCH: {
+                watch = true;
+                break;
+            }
+            case OPTION_DEBOUNCE: {
+                debounceTime = atoi(optarg);
+                break;
+            }
+            case OPTION_PIPELINE: {
+                pipelined = true;
+                break;
+            }
+            case OPTION_STAGE_WORKERS: {
+                pipelined = true;
+                stageWorkers = optarg;
+                break;
+            }
+            case OPTION_QUEUE_DEPTH: {
+                pipelined = true;
+                queueDepth = atoi(optarg);
+                break;
+            }
+            case OPTION_TYPELIB_DIR: {
+                typeLibraryDirectory = optarg;
+                break;
+            }
+            case OPTION_CODE_PAGE: {
+                codePage = parseCodePage(optarg);
+
+                if (codePage < 0) {
+                    printf("error: unsupported code page \"%s\".\n", optarg);
+                    return 1;
+                }
+
+                break;
+            }
+            case OPTION_INDEX_ONLY: {
+                indexOnly = true;
+                break;
+            }
+            case OPTION_TIME_BUDGET: {
+                fileTimeLimit = atof(optarg) / 1e3;
+                break;
+            }
+            case OPTION_MEMORY_BUDGET: {
+                fileMemoryLimit = atof(optarg) * (1 << 20);
+                break;
+            }
+            case OPTION_PROCESSES: {
+                processCount = atoi(optarg);
+                break;
+            }
+            case OPTION_WORKER_MEMORY: {
+                workerMemoryLimit = atof(optarg) * (1 << 20);
+                break;
+            }
+            case OPTION_PROCESS_SCALING: {
+                processScaling = true;
+                break;
+            }
+            case OPTION_TRACE: {
+                tracePath = optarg;
+                traceEnabled = true;
+                break;
+            }
+            case OPTION_TIME_REPORT: {
+                timeReport = true;
+                traceEnabled = true;
+                break;
+            }
+            case OPTION_DIAGNOSTICS: {
+                diagnosticFormat = parseDiagnosticFormat(optarg);
+
+                if (diagnosticFormat < 0) {
+                    printf("error: unknown diagnostic format \"%s\".\n", optarg);
+                    return 1;
+                }
+
+                break;
+            }
+            default: {
+                printUsage(argv[0]);
+                return (option == 'h') ? 0 : 1;
+            }
+        }
+    }
+
+    if (optind >= argc) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Project *project = NULL;
+
+    if (argc - optind == 1 && hasExtension(argv[optind], ".vbp")) {
+        project = readProject(argv[optind]);
+    }
+    else {
+        project = buildProjectFromFiles(&argv[optind], argc - optind);
+    }
+
+    if (project == NULL) {
+        return 1;
+    }
+
+    project->codePage = codePage;
+    project->fileTimeLimit = fileTimeLimit;
+    project->fileMemoryLimit = fileMemoryLimit;
+
+    // command-line constants override the project's CondComp
+    for (int i = 0; i < defines->size; i++) {
+        if (!parseConditionalDefine(project->defines, defines->contents[i])) {
+            return 1;
+        }
+    }
+
+    if (outputDirectory != NULL) {
+        if (mkdir(outputDirectory, 0755) != 0 && errno != EEXIST) {
+            printf("error: could not create output directory \"%s\".\n", outputDirectory);
+            return 1;
+        }
+
+        project->outputDirectory = outputDirectory;
+    }
+
+    ThreadPool *pool = buildThreadPool(workerCount);
+    RebuildPlan *plan = NULL;
+
+    if (typeLibraryDirectory != NULL) {
+        const long traceStart = beginTrace();
+        const double loadStart = getCurrentTime();
+        project->typeLibraries = loadProjectTypeLibraries(project, typeLibraryDirectory);
+        endTrace(traceStart, TRACE_PROJECT, -1, "typelibs");
+
+        printf("typelibs: %d of %d references mapped (%.3f ms)\n", project->typeLibraries->size, project->references->size, (getCurrentTime() - loadStart) * 1e3);
+    }
+
+    if (indexOnly) {
+        const int status = reportProjectHeaders(project, pool, perFile);
+        freeThreadPool(pool);
+        return status;
+    }
+
+    long traceStart = beginTrace();
+    const double indexStart = getCurrentTime();
+    project->symbols = buildSymbolIndex(project, pool);
+    endTrace(traceStart, TRACE_PROJECT, -1, "index");
+
+    printf("symbols: %d indexed from %d files (%.3f ms)\n", project->symbols->symbolCount, project->files->size, (getCurrentTime() - indexStart) * 1e3);
+
+    if (incremental && statePath == NULL) {
+        statePath = getDefaultStatePath(project);
+    }
+
+    // watch mode keeps the dependency graph in memory even without a state file
+    if (incremental || watch) {
+        traceStart = beginTrace();
+        const double planStart = getCurrentTime();
+        BuildState *previous = (statePath != NULL) ? readBuildState(statePath) : NULL;
+        plan = planRebuild(project, previous, pool);
+
+        if (previous != NULL) {
+            freeBuildState(previous);
+        }
+
+        endTrace(traceStart, TRACE_PROJECT, -1, "plan");
+
+        printf("incremental: %d dirty, %d dependent, %d unchanged (%.3f ms)\n",
+            plan->dirtyCount,
+            plan->dependentCount,
+            plan->fileCount - plan->dirtyCount - plan->dependentCount,
+            (getCurrentTime() - planStart) * 1e3);
+    }
+
+    TranspileSummary summary;
+    TranspileResult *results = NULL;
+    const bool *selection = (plan != NULL) ? plan->selection : NULL;
+
+    if (processScaling) {
+        ShardOptions options;
+        initializeShardOptions(&options, (processCount > 0) ? processCount : workerCount);
+        options.memoryLimit = workerMemoryLimit;
+        reportShardScaling(project, &options, selection);
+    }
+
+    traceStart = beginTrace();
+
+    if (processCount > 0 || processScaling) {
+        ShardOptions options;
+        ShardMetrics metrics;
+        initializeShardOptions(&options, (processCount > 0) ? processCount : workerCount);
+        options.memoryLimit = workerMemoryLimit;
+
+        results = transpileProjectSharded(project, &options, selection, &summary, &metrics);
+        flushDiagnostics(project, diagnosticFormat);
+        printTranspileReport(results, &summary, perFile);
+        printShardReport(&metrics);
+    }
+    else if (pipelined) {
+        PipelineOptions options;
+        PipelineMetrics metrics;
+        initializePipelineOptions(&options, workerCount);
+        options.queueCapacity = queueDepth;
+
+        if (stageWorkers != NULL && !parsePipelineWorkers(&options, stageWorkers)) {
+            return 1;
+        }
+
+        results = transpileProjectPipelined(project, &options, selection, &summary, &metrics);
+        flushDiagnostics(project, diagnosticFormat);
+        printTranspileReport(results, &summary, perFile);
+        printPipelineReport(&metrics);
+    }
+    else {
+        results = transpileProject(project, pool, selection, &summary);
+        flushDiagnostics(project, diagnosticFormat);
+        printTranspileReport(results, &summary, perFile);
+    }
+
+    endTrace(traceStart, TRACE_PROJECT, -1, "transpile");
+
+    if (tracePath != NULL) {
+        writeTraceFile(project, tracePath);
+    }
+
+    if (timeReport) {
+        printTimeReport(project, 10);
+    }
+
+    BuildState *state = NULL;
+
+    if (plan != NULL) {
+        bool *succeeded = calloc(summary.fileCount + 1, sizeof(bool));
+
+        for (int i = 0; i < summary.fileCount; i++) {
+            succeeded[i] = results[i].succeeded;
+        }
+
+        state = makeNextBuildState(plan, succeeded);
+        freeRebuildPlan(plan);
+        free(succeeded);
+
+        if (statePath != NULL) {
+            writeBuildState(statePath, state);
+        }
+    }
+
+    int status = (summary.failureCount == 0) ? 0 : 1;
+
+    if (watch) {
+        WatchContext context = { 0 };
+        context.project = project;
+        context.pool = pool;
+        context.results = results;
+        context.state = state;
+        context.statePath = statePath;
+        context.debounceTime = debounceTime;
+        context.perFile = perFile;
+        context.diagnosticFormat = diagnosticFormat;
+
+        status = watchProject(&context);
+    }
+
+    freeThreadPool(pool);
+
+    return status;
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#include "output.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+OutputBuffer *buildOutputBuffer() {
+    OutputBuffer *buffer = calloc(1, sizeof(OutputBuffer));
+    buffer->atLineStart = true;
+
+    return buffer;
+}
+
+void freeOutputBuffer(OutputBuffer *buffer) {
+    OutputChunk *chunk = buffer->head;
+
+    while (chunk != NULL) {
+        OutputChunk *next = chunk->next;
+        free(chunk->data);
+        free(chunk);
+        chunk = next;
+    }
+
+    free(buffer);
+}
+
+void appendRawOutput(OutputBuffer *buffer, const char *text, long length) {
+    while (length > 0) {
+        OutputChunk *chunk = buffer->tail;
+
+        if (chunk == NULL || chunk->size == OUTPUT_CHUNK_SIZE) {
+            chunk = calloc(1, sizeof(OutputChunk));
+            chunk->data = malloc(OUTPUT_CHUNK_SIZE);
+
+            if (buffer->tail == NULL) {
+                buffer->head = chunk;
+            }
+            else {
+                buffer->tail->next = chunk;
+            }
+
+            buffer->tail = chunk;
+            buffer->chunkCount++;
+        }
+
+        const long space = OUTPUT_CHUNK_SIZE - chunk->size;
+        const long count = (length < space) ? length : space;
+
+        memcpy(&chunk->data[chunk->size], text, count);
+        chunk->size += count;
+        buffer->size += count;
+        text += count;
+        length -= count;
+    }
+}
+
+void appendIndentation(OutputBuffer *buffer) {
+    static const char spaces[] = "                                                                ";
+    long width = buffer->indentLevel * 4;
+
+    while (width > 0) {
+        const long count = (width < (long)sizeof(spaces) - 1) ? width : (long)sizeof(spaces) - 1;
+        appendRawOutput(buffer, spaces, count);
+        width -= count;
+    }
+}
+
+void appendOutputLength(OutputBuffer *buffer, const char *text, long length) {
+    while (length > 0) {
+        const char *newline = memchr(text, '\n', length);
+        const long lineLength = (newline != NULL) ? newline - text + 1 : length;
+
+        if (buffer->atLineStart && text[0] != '\n') {
+            appendIndentation(buffer);
+        }
+
+        appendRawOutput(buffer, text, lineLength);
+        buffer->atLineStart = (newline != NULL);
+        text += lineLength;
+        length -= lineLength;
+    }
+}
+
+void appendOutput(OutputBuffer *buffer, const char *text) {
+    appendOutputLength(buffer, text, strlen(text));
+}
+
+void appendOutputFormat(OutputBuffer *buffer, const char *format, ...) {
+    char text[512];
+    va_list arguments;
+
+    va_start(arguments, format);
+    const int length = vsnprintf(text, sizeof(text), format, arguments);
+    va_end(arguments);
+
+    if (length < (int)sizeof(text)) {
+        appendOutputLength(buffer, text, length);
+        return;
+    }
+
+    char *large = malloc(length + 1);
+    va_start(arguments, format);
+    vsnprintf(large, length + 1, format, arguments);
+    va_end(arguments);
+
+    appendOutputLength(buffer, large, length);
+    free(large);
+}
+
+void appendOutputInteger(OutputBuffer *buffer, long value) {
+    char text[24];
+    int pos = sizeof(text);
+    const bool negative = (value < 0);
+    unsigned long magnitude = negative ? -(unsigned long)value : (unsigned long)value;
+
+    do {
+        text[--pos] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    if (negative) {
+        text[--pos] = '-';
+    }
+
+    appendOutputLength(buffer, &text[pos], sizeof(text) - pos);
+}
+
+void appendOutputLine(OutputBuffer *buffer, const char *text) {
+    appendOutput(buffer, text);
+    appendOutputLength(buffer, "\n", 1);
+}
+
+void indentOutput(OutputBuffer *buffer) {
+    buffer->indentLevel++;
+}
+
+void dedentOutput(OutputBuffer *buffer) {
+    if (buffer->indentLevel > 0) {
+        buffer->indentLevel--;
+    }
+}
+
+uint64_t calculateOutputHash(const OutputBuffer *buffer) {
+    uint64_t hash = CONTENT_HASH_SEED;
+
+    for (const OutputChunk *chunk = buffer->head; chunk != NULL; chunk = chunk->next) {
+        hash = updateContentHash(hash, chunk->data, chunk->size);
+    }
+
+    return hash;
+}
+
+bool flushOutputBuffer(const OutputBuffer *buffer, int fd) {
+    struct iovec vectors[IOV_MAX];
+    const OutputChunk *chunk = buffer->head;
+
+    while (chunk != NULL) {
+        int count = 0;
+
+        for (; chunk != NULL && count < IOV_MAX; chunk = chunk->next) {
+            vectors[count].iov_base = chunk->data;
+            vectors[count].iov_len = chunk->size;
+            count++;
+        }
+
+        struct iovec *vector = vectors;
+
+        while (count > 0) {
+            ssize_t written = writev(fd, vector, count);
+
+            if (written < 0) {
+                return false;
+            }
+
+            while (count > 0 && written >= (ssize_t)vector->iov_len) {
+                written -= vector->iov_len;
+                vector++;
+                count--;
+            }
+
+            if (count > 0) {
+                vector->iov_base = (char*)vector->iov_base + written;
+                vector->iov_len -= written;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool hasSameContent(const OutputBuffer *buffer, const char *path) {
+    struct stat st;
+
+    if (stat(path, &st) != 0 || st.st_size != buffer->size) {
+        return false;
+    }
+
+    const int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    // one byte more than expected shows up a file that grew since the stat
+    char *content = malloc(st.st_size + 1);
+    long length = 0;
+    ssize_t count;
+
+    while (length <= st.st_size && (count = read(fd, &content[length], st.st_size + 1 - length)) > 0) {
+        length += count;
+    }
+
+    close(fd);
+
+    bool isSame = (length == st.st_size && calculateContentHash(content, length) == calculateOutputHash(buffer));
+    long offset = 0;
+
+    // equal hashes only make a match likely; a collision must not keep stale output, so the bytes decide
+    for (const OutputChunk *chunk = buffer->head; isSame && chunk != NULL; chunk = chunk->next) {
+        isSame = (memcmp(&content[offset], chunk->data, chunk->size) == 0);
+        offset += chunk->size;
+    }
+
+    free(content);
+    return isSame;
+}
+
+bool writeOutputIfChanged(const OutputBuffer *buffer, const char *path, bool *written) {
+    *written = false;
+
+    if (hasSameContent(buffer, path)) {
+        return true;
+    }
+
+    char *temporaryPath = malloc(strlen(path) + 5);
+    sprintf(temporaryPath, "%s.tmp", path);
+
+    const int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0) {
+        reportDiagnostic(DIAGNOSTIC_OUTPUT_FAILED, -1, "could not create \"%s\"", temporaryPath);
+        free(temporaryPath);
+        return false;
+    }
+
+    const bool flushed = flushOutputBuffer(buffer, fd);
+    const bool closed = (close(fd) == 0);
+
+    if (!flushed || !closed || rename(temporaryPath, path) != 0) {
+        reportDiagnostic(DIAGNOSTIC_OUTPUT_FAILED, -1, "could not write \"%s\"", path);
+        unlink(temporaryPath);
+        free(temporaryPath);
+        return false;
+    }
+
+    *written = true;
+    free(temporaryPath);
+    return true;
+}
\ No newline at end of file
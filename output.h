@@ -0,0 +1,35 @@
+#pragma once
+
+#include "diagnostics.h"
+#include "util.h"
+
+#define OUTPUT_CHUNK_SIZE 65536
+
+typedef struct OutputChunk {
+    char *data;
+    int size;
+    struct OutputChunk *next;
+} OutputChunk;
+
+// text is appended into fixed chunks so growth never copies, and flushing is one writev
+typedef struct OutputBuffer {
+    OutputChunk *head;
+    OutputChunk *tail;
+    int chunkCount;
+    long size;
+    int indentLevel;
+    bool atLineStart;
+} OutputBuffer;
+
+OutputBuffer *buildOutputBuffer();
+void freeOutputBuffer(OutputBuffer *buffer);
+void appendOutputLength(OutputBuffer *buffer, const char *text, long length);
+void appendOutput(OutputBuffer *buffer, const char *text);
+void appendOutputFormat(OutputBuffer *buffer, const char *format, ...);
+void appendOutputInteger(OutputBuffer *buffer, long value);
+void appendOutputLine(OutputBuffer *buffer, const char *text);
+void indentOutput(OutputBuffer *buffer);
+void dedentOutput(OutputBuffer *buffer);
+uint64_t calculateOutputHash(const OutputBuffer *buffer);
+bool flushOutputBuffer(const OutputBuffer *buffer, int fd);
+bool writeOutputIfChanged(const OutputBuffer *buffer, const char *path, bool *written);
\ No newline at end of file
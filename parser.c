@@ -1,191 +1,2942 @@
-#include "parser.h"
+#include <strings.h>
 
-FunctionDefinitionNode *makeFunctionDefinitionNode(const Vector *vectorList, int *index) {
-    FunctionDefinitionNode *functionDefinitionNode = calloc(1, sizeof(FunctionDefinitionNode));
-    functionDefinitionNode->declarationSpecifierNodes = buildVectorList();
+#include "cfg.h"
+
+#define PARSER_ARENA_BLOCK_SIZE 65536
+#define MAX_NESTING_DEPTH 256
+
+// the levels of the C-shaped tree, loosest first; a node of one level is the operand of the level above
+enum ExpressionLevel {
+    LEVEL_EXPRESSION,
+    LEVEL_ASSIGNMENT,
+    LEVEL_CONDITIONAL,
+    LEVEL_OR,
+    LEVEL_LOGICAL_AND,
+    LEVEL_INCLUSIVE_OR,
+    LEVEL_EXCLUSIVE_OR,
+    LEVEL_AND,
+    LEVEL_EQUAL,
+    LEVEL_RELATIONAL,
+    LEVEL_SHIFT,
+    LEVEL_ADDITION,
+    LEVEL_MULTIPLICATION,
+    LEVEL_CAST,
+    LEVEL_UNARY,
+    LEVEL_POSTFIX,
+    LEVEL_PRIMARY
+};
+
+// VB's binary precedence, loosest first; Not and negation are the unary steps between them
+enum Precedence {
+    PRECEDENCE_IMP,
+    PRECEDENCE_EQV,
+    PRECEDENCE_XOR,
+    PRECEDENCE_OR,
+    PRECEDENCE_AND,
+    PRECEDENCE_NOT,
+    PRECEDENCE_COMPARISON,
+    PRECEDENCE_CONCAT,
+    PRECEDENCE_ADDITION,
+    PRECEDENCE_MODULO,
+    PRECEDENCE_INTEGER_DIVISION,
+    PRECEDENCE_MULTIPLICATION,
+    PRECEDENCE_NEGATION
+};
+
+// a node of any level while an expression is parsed; node is the struct level names, NULL after an error
+typedef struct ParsedExpression {
+    int level;
+    void *node;
+} ParsedExpression;
+
+// How a VB operator maps onto the tree: word is for the operators the lexer leaves as names.
+// operatorType is the node's operator or comparison.
+typedef struct VbOperator {
+    int precedence;
+    int tokenType;
+    const char *word;
+    int level;
+    int operatorType;
+} VbOperator;
+
+static const VbOperator vbOperators[] = {
+    { PRECEDENCE_IMP, TK_IDENTIFIER, "Imp", LEVEL_INCLUSIVE_OR, OPERATOR_NONE },
+    { PRECEDENCE_EQV, TK_IDENTIFIER, "Eqv", LEVEL_EQUAL, COMPARE_EQUAL },
+    { PRECEDENCE_XOR, TK_XOR, NULL, LEVEL_EXCLUSIVE_OR, OPERATOR_NONE },
+    { PRECEDENCE_OR, TK_OR, NULL, LEVEL_INCLUSIVE_OR, OPERATOR_NONE },
+    { PRECEDENCE_AND, TK_AND, NULL, LEVEL_AND, OPERATOR_NONE },
+    { PRECEDENCE_COMPARISON, TK_ASSIGNMENT, NULL, LEVEL_EQUAL, COMPARE_EQUAL },
+    { PRECEDENCE_COMPARISON, TK_NOT_EQUAL, NULL, LEVEL_EQUAL, COMPARE_NOT_EQUAL },
+    { PRECEDENCE_COMPARISON, TK_IS, NULL, LEVEL_EQUAL, COMPARE_EQUAL },
+    { PRECEDENCE_COMPARISON, TK_LEFT_ANGLE, NULL, LEVEL_RELATIONAL, COMPARE_LESS_THAN },
+    { PRECEDENCE_COMPARISON, TK_RIGHT_ANGLE, NULL, LEVEL_RELATIONAL, COMPARE_GREATER_THAN },
+    { PRECEDENCE_COMPARISON, TK_LESS_OR_EQUAL, NULL, LEVEL_RELATIONAL, COMPARE_LESS_OR_EQUAL },
+    { PRECEDENCE_COMPARISON, TK_GREATER_OR_EQUAL, NULL, LEVEL_RELATIONAL, COMPARE_GREATER_OR_EQUAL },
+    { PRECEDENCE_COMPARISON, TK_LIKE, NULL, LEVEL_POSTFIX, OPERATOR_NONE },
+    { PRECEDENCE_CONCAT, TK_CONCAT, NULL, LEVEL_SHIFT, OPERATOR_CONCAT },
+    { PRECEDENCE_ADDITION, TK_PLUS, NULL, LEVEL_ADDITION, OPERATOR_ADD },
+    { PRECEDENCE_ADDITION, TK_MINUS, NULL, LEVEL_ADDITION, OPERATOR_SUBTRACT },
+    { PRECEDENCE_MODULO, TK_MOD, NULL, LEVEL_MULTIPLICATION, OPERATOR_MODULO },
+    { PRECEDENCE_INTEGER_DIVISION, TK_BACKSLASH, NULL, LEVEL_MULTIPLICATION, OPERATOR_DIVIDE },
+    { PRECEDENCE_MULTIPLICATION, TK_ASTERISK, NULL, LEVEL_MULTIPLICATION, OPERATOR_MULTIPLY },
+    { PRECEDENCE_MULTIPLICATION, TK_SLASH, NULL, LEVEL_MULTIPLICATION, OPERATOR_DIVIDE }
+};
+
+_Thread_local StringMap *classMap;
+_Thread_local bool isExternFunction;
+_Thread_local const SymbolIndex *symbolIndex;
+
+// the unit being parsed, which owns every node made for it
+_Thread_local TransUnitNode *currentUnit;
+// the objects of the enclosing With blocks, innermost last
+_Thread_local Vector *withObjects;
+// "Next j, i" closes more than one For; the outer ones it also closed
+_Thread_local int pendingNextCount;
+// the For Each loops so far, which number their enumerators
+_Thread_local int eachCount;
+_Thread_local int syntaxErrorCount;
+_Thread_local int nestingDepth;
+// the module's Option Base, the lower bound of an array bound given without "To"
+_Thread_local int optionBase;
+
+ParsedExpression parseBinaryExpression(const Vector *vectorList, int *index, int precedence);
+ParsedExpression parsePostfixExpression(const Vector *vectorList, int *index, bool isCallHead);
+
+void *allocateNode(size_t size) {
+    chargeBudget(size);
+    return allocateArena(currentUnit->arena, size);
+}
+
+Vector *buildNodeVector() {
+    Vector *vector = buildVectorList();
+    pushVector(currentUnit->nodeVectors, vector);
+    chargeBudget(sizeof(Vector));
+    return vector;
+}
+
+char *copyNodeString(const char *string) {
+    const size_t length = strlen(string);
+    char *copy = allocateNode(length + 1);
+    memcpy(copy, string, length + 1);
+    return copy;
+}
+
+// Statements report what they cannot parse and skip to the next line, so one pass finds every error;
+// the file still fails. Once the file is over budget the lookaheads stop short, so what fails then is
+// not the source's fault and is left to the one diagnostic that abandons the file.
+void reportSyntaxError(const Vector *vectorList, int index, const char *format, ...) {
+    char message[256];
+    va_list arguments;
+
+    if (isOverBudget()) {
+        syntaxErrorCount++;
+        return;
+    }
+
+    va_start(arguments, format);
+    vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+
+    syntaxErrorCount++;
+    reportDiagnostic(DIAGNOSTIC_SYNTAX_ERROR, getTokenOffset(vectorList, (index < vectorList->size) ? index : vectorList->size - 1), "%s", message);
+}
+
+// a construct with no C# lowering is warned about where it starts, and the caller gives up on the statement it
+// is in, which is left out while the rest of the module still transpiles
+void reportUnsupported(const Vector *vectorList, int index, const char *format, ...) {
+    char message[256];
+    va_list arguments;
+
+    if (isOverBudget()) {
+        return;
+    }
+
+    va_start(arguments, format);
+    vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+
+    reportWarning(DIAGNOSTIC_UNSUPPORTED_CONSTRUCT, getTokenOffset(vectorList, (index < vectorList->size) ? index : vectorList->size - 1), "%s", message);
+}
+
+const Token *peekToken(const Vector *vectorList, int index) {
+    return (index >= 0 && index < vectorList->size) ? vectorList->contents[index] : NULL;
+}
+
+int peekType(const Vector *vectorList, int index) {
+    const Token *token = peekToken(vectorList, index);
+    return (token != NULL) ? token->type : -1;
+}
+
+bool acceptToken(const Vector *vectorList, int *index, int type) {
+    if (peekType(vectorList, *index) != type) {
+        return false;
+    }
+
+    (*index)++;
+    return true;
+}
+
+bool expectToken(const Vector *vectorList, int *index, int type, const char *text) {
+    if (acceptToken(vectorList, index, type)) {
+        return true;
+    }
+
+    reportSyntaxError(vectorList, *index, "expected '%s'", text);
+    return false;
+}
+
+// words VB6 reserves only in context, like Preserve and Until, stay names to the lexer
+bool isTokenWord(const Vector *vectorList, int index, const char *word) {
+    const Token *token = peekToken(vectorList, index);
+    return token != NULL && token->type == TK_IDENTIFIER && strcasecmp(token->string, word) == 0;
+}
+
+bool acceptTokenWord(const Vector *vectorList, int *index, const char *word) {
+    if (!isTokenWord(vectorList, *index, word)) {
+        return false;
+    }
+
+    (*index)++;
+    return true;
+}
+
+bool isStatementEnd(const Vector *vectorList, int index) {
+    const int type = peekType(vectorList, index);
+    return type == -1 || type == TK_NEWLINE || type == TK_COLON;
+}
+
+bool isLineEnd(const Vector *vectorList, int index) {
+    const int type = peekType(vectorList, index);
+    return type == -1 || type == TK_NEWLINE;
+}
+
+void skipLine(const Vector *vectorList, int *index) {
+    while (!isLineEnd(vectorList, *index)) {
+        (*index)++;
+    }
+
+    acceptToken(vectorList, index, TK_NEWLINE);
+}
+
+bool isLineStart(const Vector *vectorList, int index) {
+    return index == 0 || peekType(vectorList, index - 1) == TK_NEWLINE;
+}
+
+// a node of the given level standing for the lower-level node expression holds, through single-operand nodes
+void *liftExpression(ParsedExpression expression, int level) {
+    void *node = expression.node;
+
+    for (int from = expression.level; node != NULL && from > level; from--) {
+        switch (from) {
+            case LEVEL_PRIMARY: {
+                PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+                postfixExpressionNode->postfixExpressionType = POSTFIX_PRIMARY;
+                postfixExpressionNode->primaryExpressionNode = node;
+                node = postfixExpressionNode;
+                break;
+            }
+            case LEVEL_POSTFIX: {
+                UnaryExpressionNode *unaryExpressionNode = allocateNode(sizeof(UnaryExpressionNode));
+                unaryExpressionNode->type = UNARY_NONE;
+                unaryExpressionNode->postfixExpressionNode = node;
+                node = unaryExpressionNode;
+                break;
+            }
+            case LEVEL_UNARY: {
+                CastExpressionNode *castExpressionNode = allocateNode(sizeof(CastExpressionNode));
+                castExpressionNode->unaryExpressionNode = node;
+                node = castExpressionNode;
+                break;
+            }
+            case LEVEL_CAST: {
+                MultiplicationExpressionNode *multiplicationExpressionNode = allocateNode(sizeof(MultiplicationExpressionNode));
+                multiplicationExpressionNode->castExpressionNode = node;
+                node = multiplicationExpressionNode;
+                break;
+            }
+            case LEVEL_MULTIPLICATION: {
+                AdditionExpressionNode *additionExpressionNode = allocateNode(sizeof(AdditionExpressionNode));
+                additionExpressionNode->multiplicationExpressionNode = node;
+                node = additionExpressionNode;
+                break;
+            }
+            case LEVEL_ADDITION: {
+                ShiftExpressionNode *shiftExpressionNode = allocateNode(sizeof(ShiftExpressionNode));
+                shiftExpressionNode->additionExpressionNode = node;
+                node = shiftExpressionNode;
+                break;
+            }
+            case LEVEL_SHIFT: {
+                RelationalExpressionNode *relationalExpressionNode = allocateNode(sizeof(RelationalExpressionNode));
+                relationalExpressionNode->shiftExpressionNode = node;
+                node = relationalExpressionNode;
+                break;
+            }
+            case LEVEL_RELATIONAL: {
+                EqualExpressionNode *equalExpressionNode = allocateNode(sizeof(EqualExpressionNode));
+                equalExpressionNode->relationalExpressionNode = node;
+                node = equalExpressionNode;
+                break;
+            }
+            case LEVEL_EQUAL: {
+                AndExpressionNode *andExpressionNode = allocateNode(sizeof(AndExpressionNode));
+                andExpressionNode->equalExpressionNode = node;
+                node = andExpressionNode;
+                break;
+            }
+            case LEVEL_AND: {
+                ExclusiveOrExpressionNode *exclusiveOrExpressionNode = allocateNode(sizeof(ExclusiveOrExpressionNode));
+                exclusiveOrExpressionNode->andExpressionNode = node;
+                node = exclusiveOrExpressionNode;
+                break;
+            }
+            case LEVEL_EXCLUSIVE_OR: {
+                InclusiveOrExpressionNode *inclusiveOrExpressionNode = allocateNode(sizeof(InclusiveOrExpressionNode));
+                inclusiveOrExpressionNode->exclusiveOrExpressionNode = node;
+                node = inclusiveOrExpressionNode;
+                break;
+            }
+            case LEVEL_INCLUSIVE_OR: {
+                LogicalAndExpressionNode *logicalAndExpressionNode = allocateNode(sizeof(LogicalAndExpressionNode));
+                logicalAndExpressionNode->inclusiveOrExpressionNode = node;
+                node = logicalAndExpressionNode;
+                break;
+            }
+            case LEVEL_LOGICAL_AND: {
+                OrExpressionNode *orExpressionNode = allocateNode(sizeof(OrExpressionNode));
+                orExpressionNode->logicalAndExpressionNode = node;
+                node = orExpressionNode;
+                break;
+            }
+            case LEVEL_OR: {
+                ConditionalExpressionNode *conditionalExpressionNode = allocateNode(sizeof(ConditionalExpressionNode));
+                conditionalExpressionNode->orExpressionNode = node;
+                node = conditionalExpressionNode;
+                break;
+            }
+            case LEVEL_CONDITIONAL: {
+                AssignmentExpressionNode *assignmentExpressionNode = allocateNode(sizeof(AssignmentExpressionNode));
+                assignmentExpressionNode->conditionalExpressionNode = node;
+                node = assignmentExpressionNode;
+                break;
+            }
+            case LEVEL_ASSIGNMENT: {
+                ExpressionNode *expressionNode = allocateNode(sizeof(ExpressionNode));
+                expressionNode->assignExpressionNode = node;
+                node = expressionNode;
+                break;
+            }
+        }
+    }
+
+    return node;
+}
+
+// As liftExpression, but an expression looser than level is parenthesized first, as VB's precedence implied
+void *lowerExpression(ParsedExpression expression, int level) {
+    if (expression.node != NULL && expression.level < level) {
+        PrimaryExpressionNode *primaryExpressionNode = allocateNode(sizeof(PrimaryExpressionNode));
+        primaryExpressionNode->expressionNode = liftExpression(expression, LEVEL_EXPRESSION);
+        expression = (ParsedExpression){ LEVEL_PRIMARY, primaryExpressionNode };
+    }
+
+    return liftExpression(expression, level);
+}
+
+// left operator right at one level of the tree: the left operand is that level's own node, the right the next's
+ParsedExpression makeBinaryExpression(int level, int operatorType, ParsedExpression left, ParsedExpression right) {
+    void *same = lowerExpression(left, level);
+    void *lower = lowerExpression(right, level + 1);
+    void *node = NULL;
+
+    switch (level) {
+        case LEVEL_MULTIPLICATION: {
+            MultiplicationExpressionNode *multiplicationExpressionNode = allocateNode(sizeof(MultiplicationExpressionNode));
+            multiplicationExpressionNode->operatorType = operatorType;
+            multiplicationExpressionNode->multiplicationExpressionNode = same;
+            multiplicationExpressionNode->castExpressionNode = lower;
+            node = multiplicationExpressionNode;
+            break;
+        }
+        case LEVEL_ADDITION: {
+            AdditionExpressionNode *additionExpressionNode = allocateNode(sizeof(AdditionExpressionNode));
+            additionExpressionNode->operatorType = operatorType;
+            additionExpressionNode->additionExpressionNode = same;
+            additionExpressionNode->multiplicationExpressionNode = lower;
+            node = additionExpressionNode;
+            break;
+        }
+        case LEVEL_SHIFT: {
+            ShiftExpressionNode *shiftExpressionNode = allocateNode(sizeof(ShiftExpressionNode));
+            shiftExpressionNode->operatorType = operatorType;
+            shiftExpressionNode->shiftExpressionNode = same;
+            shiftExpressionNode->additionExpressionNode = lower;
+            node = shiftExpressionNode;
+            break;
+        }
+        case LEVEL_RELATIONAL: {
+            RelationalExpressionNode *relationalExpressionNode = allocateNode(sizeof(RelationalExpressionNode));
+            relationalExpressionNode->compareType = operatorType;
+            relationalExpressionNode->relationalExpressionNode = same;
+            relationalExpressionNode->shiftExpressionNode = lower;
+            node = relationalExpressionNode;
+            break;
+        }
+        case LEVEL_EQUAL: {
+            EqualExpressionNode *equalExpressionNode = allocateNode(sizeof(EqualExpressionNode));
+            equalExpressionNode->compareType = operatorType;
+            equalExpressionNode->equalExpressionNode = same;
+            equalExpressionNode->relationalExpressionNode = lower;
+            node = equalExpressionNode;
+            break;
+        }
+        case LEVEL_AND: {
+            AndExpressionNode *andExpressionNode = allocateNode(sizeof(AndExpressionNode));
+            andExpressionNode->andExpressionNode = same;
+            andExpressionNode->equalExpressionNode = lower;
+            node = andExpressionNode;
+            break;
+        }
+        case LEVEL_EXCLUSIVE_OR: {
+            ExclusiveOrExpressionNode *exclusiveOrExpressionNode = allocateNode(sizeof(ExclusiveOrExpressionNode));
+            exclusiveOrExpressionNode->exclusiveOrExpressionNode = same;
+            exclusiveOrExpressionNode->andExpressionNode = lower;
+            node = exclusiveOrExpressionNode;
+            break;
+        }
+        case LEVEL_INCLUSIVE_OR: {
+            InclusiveOrExpressionNode *inclusiveOrExpressionNode = allocateNode(sizeof(InclusiveOrExpressionNode));
+            inclusiveOrExpressionNode->inclusiveOrExpressionNode = same;
+            inclusiveOrExpressionNode->exclusiveOrExpressionNode = lower;
+            node = inclusiveOrExpressionNode;
+            break;
+        }
+        case LEVEL_LOGICAL_AND: {
+            LogicalAndExpressionNode *logicalAndExpressionNode = allocateNode(sizeof(LogicalAndExpressionNode));
+            logicalAndExpressionNode->logicalAndExpressionNode = same;
+            logicalAndExpressionNode->inclusiveOrExpressionNode = lower;
+            node = logicalAndExpressionNode;
+            break;
+        }
+        case LEVEL_OR: {
+            OrExpressionNode *orExpressionNode = allocateNode(sizeof(OrExpressionNode));
+            orExpressionNode->orExpressionNode = same;
+            orExpressionNode->logicalAndExpressionNode = lower;
+            node = orExpressionNode;
+            break;
+        }
+    }
+
+    return (ParsedExpression){ level, node };
+}
+
+ParsedExpression makeUnaryExpression(int operatorType, ParsedExpression operand) {
+    UnaryExpressionNode *unaryExpressionNode = allocateNode(sizeof(UnaryExpressionNode));
+    unaryExpressionNode->type = UNARY_OPERATOR;
+    unaryExpressionNode->operatorType = operatorType;
+    unaryExpressionNode->castExpressionNode = lowerExpression(operand, LEVEL_CAST);
+
+    return (ParsedExpression){ LEVEL_UNARY, unaryExpressionNode };
+}
+
+ParsedExpression makeIdentifierExpression(const char *identifier) {
+    PrimaryExpressionNode *primaryExpressionNode = allocateNode(sizeof(PrimaryExpressionNode));
+    primaryExpressionNode->identifier = copyNodeString(identifier);
+
+    return (ParsedExpression){ LEVEL_PRIMARY, primaryExpressionNode };
+}
+
+ParsedExpression makeStringExpression(const char *text) {
+    PrimaryExpressionNode *primaryExpressionNode = allocateNode(sizeof(PrimaryExpressionNode));
+    primaryExpressionNode->str = copyNodeString(text);
+
+    return (ParsedExpression){ LEVEL_PRIMARY, primaryExpressionNode };
+}
+
+ParsedExpression makeConstantExpression(int constantType, int value) {
+    PrimaryExpressionNode *primaryExpressionNode = allocateNode(sizeof(PrimaryExpressionNode));
+    primaryExpressionNode->constantNode = allocateNode(sizeof(ConstantNode));
+    primaryExpressionNode->constantNode->constantType = constantType;
+    primaryExpressionNode->constantNode->integerConstant = value;
+
+    return (ParsedExpression){ LEVEL_PRIMARY, primaryExpressionNode };
+}
+
+// function(arguments...), for the operators C# spells as library calls
+ParsedExpression makeCallExpression(const char *function, int argumentCount, ...) {
+    PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+    va_list arguments;
+
+    postfixExpressionNode->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+    postfixExpressionNode->postfixExpressionNode = liftExpression(makeIdentifierExpression(function), LEVEL_POSTFIX);
+    postfixExpressionNode->assignExpressionNodes = buildNodeVector();
+
+    va_start(arguments, argumentCount);
+
+    for (int i = 0; i < argumentCount; i++) {
+        pushVector(postfixExpressionNode->assignExpressionNodes, lowerExpression(va_arg(arguments, ParsedExpression), LEVEL_ASSIGNMENT));
+    }
+
+    va_end(arguments);
+    return (ParsedExpression){ LEVEL_POSTFIX, postfixExpressionNode };
+}
+
+// object.member, read as a property, or called with no arguments when isCall is set
+ParsedExpression makeMemberExpression(ParsedExpression object, const char *member, bool isCall) {
+    PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+    postfixExpressionNode->postfixExpressionType = POSTFIX_DOT;
+    postfixExpressionNode->postfixExpressionNode = lowerExpression(object, LEVEL_POSTFIX);
+    postfixExpressionNode->identifier = copyNodeString(member);
+
+    if (!isCall) {
+        return (ParsedExpression){ LEVEL_POSTFIX, postfixExpressionNode };
+    }
+
+    PostfixExpressionNode *call = allocateNode(sizeof(PostfixExpressionNode));
+    call->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+    call->postfixExpressionNode = postfixExpressionNode;
+    call->assignExpressionNodes = buildNodeVector();
+
+    return (ParsedExpression){ LEVEL_POSTFIX, call };
+}
+
+// function(arguments), for a call whose argument list is built first
+ParsedExpression makeArgumentCall(const char *function, Vector *arguments) {
+    PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+    postfixExpressionNode->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+    postfixExpressionNode->postfixExpressionNode = liftExpression(makeIdentifierExpression(function), LEVEL_POSTFIX);
+    postfixExpressionNode->assignExpressionNodes = arguments;
+
+    return (ParsedExpression){ LEVEL_POSTFIX, postfixExpressionNode };
+}
+
+ParsedExpression makeAssignmentExpression(ParsedExpression target, int assignOperator, ParsedExpression value) {
+    AssignmentExpressionNode *assignmentExpressionNode = allocateNode(sizeof(AssignmentExpressionNode));
+    assignmentExpressionNode->unaryExpressionNode = lowerExpression(target, LEVEL_UNARY);
+    assignmentExpressionNode->assignOperator = assignOperator;
+    assignmentExpressionNode->assignExpressionNode = lowerExpression(value, LEVEL_ASSIGNMENT);
+
+    return (ParsedExpression){ LEVEL_ASSIGNMENT, assignmentExpressionNode };
+}
+
+TypeNameNode *makeTypeNameNode(TypeSpecifierNode *typeSpecifierNode) {
+    TypeNameNode *typeNameNode = allocateNode(sizeof(TypeNameNode));
+    typeNameNode->specifierQualifierNode = allocateNode(sizeof(SpecifierQualifierNode));
+    typeNameNode->specifierQualifierNode->typeSpecifierNode = typeSpecifierNode;
+
+    return typeNameNode;
+}
+
+TypeSpecifierNode *makeTypeSpecifier(int typeSpecifier, const char *name) {
+    TypeSpecifierNode *typeSpecifierNode = allocateNode(sizeof(TypeSpecifierNode));
+    typeSpecifierNode->typeSpecifier = typeSpecifier;
+    typeSpecifierNode->flockName = (name != NULL) ? copyNodeString(name) : NULL;
+
+    return typeSpecifierNode;
+}
+
+// VB's / always divides as Double, where C# divides integers as integers
+ParsedExpression makeDoubleCast(ParsedExpression operand) {
+    CastExpressionNode *castExpressionNode = allocateNode(sizeof(CastExpressionNode));
+    castExpressionNode->typeNameNode = makeTypeNameNode(makeTypeSpecifier(TYPE_FP64, NULL));
+    castExpressionNode->castExpressionNode = lowerExpression(operand, LEVEL_CAST);
+
+    return (ParsedExpression){ LEVEL_CAST, castExpressionNode };
+}
+
+// a dotted name such as ADODB.Recordset, as one string
+char *readQualifiedName(const Vector *vectorList, int *index) {
+    char name[256] = "";
+
+    do {
+        const Token *token = peekToken(vectorList, *index);
+
+        if (token == NULL || token->type != TK_IDENTIFIER) {
+            reportSyntaxError(vectorList, *index, "expected a name");
+            return NULL;
+        }
+
+        if (name[0] != '\0') {
+            strncat(name, ".", sizeof(name) - strlen(name) - 1);
+        }
+
+        strncat(name, token->string, sizeof(name) - strlen(name) - 1);
+        (*index)++;
+    } while (acceptToken(vectorList, index, TK_DOT));
+
+    return copyNodeString(name);
+}
+
+// Long and Integer both become int, and Single, Currency and Decimal all become double
+TypeSpecifierNode *makeTypeSpecifierNode(const Vector *vectorList, int *index) {
+    const bool isNew = acceptToken(vectorList, index, TK_NEW);
+    const int type = peekType(vectorList, *index);
+    TypeSpecifierNode *typeSpecifierNode = NULL;
+
+    switch (type) {
+        case TK_LONG:
+        case TK_INTEGER:
+        case TK_BYTE: {
+            typeSpecifierNode = makeTypeSpecifier(TYPE_SI32, NULL);
+            typeSpecifierNode->numericType = (type == TK_INTEGER) ? NUMERIC_INTEGER : (type == TK_BYTE) ? NUMERIC_BYTE : NUMERIC_DEFAULT;
+            break;
+        }
+        case TK_STRING: {
+            typeSpecifierNode = makeTypeSpecifier(TYPE_SC8, NULL);
+            break;
+        }
+        case TK_DOUBLE:
+        case TK_SINGLE:
+        case TK_DECIMAL: {
+            typeSpecifierNode = makeTypeSpecifier(TYPE_FP64, NULL);
+            typeSpecifierNode->numericType = (type == TK_SINGLE) ? NUMERIC_SINGLE : (type == TK_DECIMAL) ? NUMERIC_DECIMAL : NUMERIC_DEFAULT;
+            break;
+        }
+        case TK_BOOLEAN: {
+            typeSpecifierNode = makeTypeSpecifier(TYPE_B8, NULL);
+            break;
+        }
+        case TK_VARIANT: {
+            typeSpecifierNode = makeTypeSpecifier(TYPE_VARIANT, NULL);
+            break;
+        }
+        case TK_OBJECT: {
+            typeSpecifierNode = makeTypeSpecifier(TYPENAME, "Object");
+            break;
+        }
+        case TK_DATE: {
+            typeSpecifierNode = makeTypeSpecifier(TYPENAME, "DateTime");
+            break;
+        }
+        case TK_IDENTIFIER: {
+            if (isTokenWord(vectorList, *index, "Currency")) {
+                typeSpecifierNode = makeTypeSpecifier(TYPE_FP64, NULL);
+                typeSpecifierNode->numericType = NUMERIC_DECIMAL;
+                break;
+            }
+
+            char *name = readQualifiedName(vectorList, index);
+
+            if (name == NULL) {
+                return NULL;
+            }
+
+            typeSpecifierNode = makeTypeSpecifier(TYPENAME, NULL);
+            typeSpecifierNode->flockName = name;
+            typeSpecifierNode->isNew = isNew;
+            return typeSpecifierNode;
+        }
+        default: {
+            reportSyntaxError(vectorList, *index, "expected a type name");
+            return NULL;
+        }
+    }
+
+    (*index)++;
+    typeSpecifierNode->isNew = isNew;
+
+    // a fixed-length String * n is still a string
+    if (type == TK_STRING && acceptToken(vectorList, index, TK_ASTERISK)) {
+        (*index)++;
+    }
+
+    return typeSpecifierNode;
+}
+
+ExpressionNode *makeExpressionNode(const Vector *vectorList, int *index) {
+    return liftExpression(parseBinaryExpression(vectorList, index, PRECEDENCE_IMP), LEVEL_EXPRESSION);
+}
+
+// "lower To upper" in a bound or a Case keeps the parts apart; lower is NULL for a plain expression
+ParsedExpression parseRange(const Vector *vectorList, int *index, ParsedExpression *lower) {
+    ParsedExpression expression = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+    *lower = (ParsedExpression){ 0, NULL };
+
+    if (expression.node != NULL && acceptToken(vectorList, index, TK_TO)) {
+        *lower = expression;
+        expression = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+    }
+
+    return expression;
+}
+
+// A bound's lower part as a literal of 0 or more, or the Option Base when it has none. The C# array always runs
+// from 0 to the upper bound, so any other lower bound is reported and its LBound is not known.
+int getLowerBound(const Vector *vectorList, int index, ParsedExpression lower) {
+    if (lower.node == NULL) {
+        return optionBase;
+    }
+
+    const ConstantNode *constantNode = (lower.level == LEVEL_PRIMARY) ? ((const PrimaryExpressionNode *)lower.node)->constantNode : NULL;
+
+    if (constantNode == NULL || constantNode->constantType != CONSTANT_SI32 || constantNode->integerConstant < 0) {
+        reportWarning(DIAGNOSTIC_UNSUPPORTED_CONSTRUCT, getTokenOffset(vectorList, index), "only a constant lower bound of 0 or more is kept; the C# array runs from 0");
+        return -1;
+    }
+
+    return constantNode->integerConstant;
+}
+
+// name:=value
+bool isNamedArgument(const Vector *vectorList, int index) {
+    return peekType(vectorList, index) == TK_IDENTIFIER && peekType(vectorList, index + 1) == TK_COLON && peekType(vectorList, index + 2) == TK_ASSIGNMENT;
+}
+
+// (a, , c): an argument left out is C#'s default. isBounds takes "lower To upper" and keeps the upper bound;
+// lowerBound, given with it, is the lower bound every dimension shares, or -1.
+Vector *parseArguments(const Vector *vectorList, int *index, bool isBounds, int *lowerBound) {
+    Vector *arguments = buildNodeVector();
+
+    (*index)++;
+
+    if (acceptToken(vectorList, index, TK_RIGHT_PARENTHESIS)) {
+        return arguments;
+    }
+
+    while (true) {
+        const int type = peekType(vectorList, *index);
+        const int start = *index;
+        ParsedExpression lower;
+        ParsedExpression argument;
+
+        if (type == TK_COMMA || type == TK_RIGHT_PARENTHESIS) {
+            argument = makeIdentifierExpression("default");
+        }
+        else if (isNamedArgument(vectorList, *index)) {
+            reportUnsupported(vectorList, *index, "named arguments have no lowering; the statement is left out");
+            return NULL;
+        }
+        else {
+            acceptToken(vectorList, index, TK_BY_VAL);
+            argument = isBounds ? parseRange(vectorList, index, &lower) : parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+        }
+
+        if (argument.node == NULL) {
+            return NULL;
+        }
+
+        if (isBounds && lowerBound != NULL) {
+            const int bound = getLowerBound(vectorList, start, lower);
+            *lowerBound = (arguments->size == 0 || bound == *lowerBound) ? bound : -1;
+        }
+
+        pushVector(arguments, lowerExpression(argument, LEVEL_ASSIGNMENT));
+
+        if (acceptToken(vectorList, index, TK_RIGHT_PARENTHESIS)) {
+            return arguments;
+        }
+
+        if (!expectToken(vectorList, index, TK_COMMA, ",")) {
+            return NULL;
+        }
+    }
+}
+
+ParsedExpression parseNumber(const Token *token) {
+    if (token->string == NULL) {
+        return makeConstantExpression(CONSTANT_SI32, token->num);
+    }
+
+    ParsedExpression expression = makeConstantExpression(CONSTANT_FP64, token->num);
+    ConstantNode *constantNode = ((PrimaryExpressionNode *)expression.node)->constantNode;
+
+    // 1# or a number past a Long's range is a Double, which C# only reads as one with a fraction
+    if (strpbrk(token->string, ".eE") == NULL) {
+        constantNode->characterConstant = allocateNode(token->strlen + 3);
+        snprintf(constantNode->characterConstant, token->strlen + 3, "%s.0", token->string);
+    }
+    else {
+        constantNode->characterConstant = copyNodeString(token->string);
+    }
+
+    return expression;
+}
+
+ParsedExpression parsePrimaryExpression(const Vector *vectorList, int *index) {
+    const Token *token = peekToken(vectorList, *index);
+    const ParsedExpression error = { 0, NULL };
+
+    if (token == NULL) {
+        reportSyntaxError(vectorList, *index, "expected an expression");
+        return error;
+    }
+
+    switch (token->type) {
+        case TK_LEFT_PARENTHESIS: {
+            if (++nestingDepth > MAX_NESTING_DEPTH) {
+                reportSyntaxError(vectorList, *index, "expression is nested too deeply");
+                nestingDepth--;
+                return error;
+            }
+
+            (*index)++;
+            ParsedExpression inner = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+            nestingDepth--;
+
+            if (inner.node == NULL || !expectToken(vectorList, index, TK_RIGHT_PARENTHESIS, ")")) {
+                return error;
+            }
+
+            PrimaryExpressionNode *primaryExpressionNode = allocateNode(sizeof(PrimaryExpressionNode));
+            primaryExpressionNode->expressionNode = liftExpression(inner, LEVEL_EXPRESSION);
+            return (ParsedExpression){ LEVEL_PRIMARY, primaryExpressionNode };
+        }
+        case TK_NUMBER: {
+            (*index)++;
+            return parseNumber(token);
+        }
+        case TK_STRING_LITERAL: {
+            (*index)++;
+            return makeStringExpression(token->string);
+        }
+        case TK_TRUE:
+        case TK_FALSE: {
+            (*index)++;
+            return makeConstantExpression(CONSTANT_B8, (token->type == TK_TRUE) ? -1 : 0);
+        }
+        case TK_NOTHING: {
+            (*index)++;
+            return makeIdentifierExpression("null");
+        }
+        case TK_ME: {
+            (*index)++;
+            return makeIdentifierExpression("this");
+        }
+        case TK_STRING:
+        case TK_DATE:
+        case TK_ERROR: {
+            (*index)++;
+            return makeIdentifierExpression((token->type == TK_STRING) ? "String" : (token->type == TK_DATE) ? "Date" : "Error");
+        }
+        case TK_IDENTIFIER: {
+            (*index)++;
+            return makeIdentifierExpression(token->string);
+        }
+        case TK_NEW: {
+            (*index)++;
+            TypeSpecifierNode *typeSpecifierNode = makeTypeSpecifierNode(vectorList, index);
+
+            if (typeSpecifierNode == NULL) {
+                return error;
+            }
+
+            UnaryExpressionNode *unaryExpressionNode = allocateNode(sizeof(UnaryExpressionNode));
+            unaryExpressionNode->type = UNARY_NEW;
+            unaryExpressionNode->typeNameNode = makeTypeNameNode(typeSpecifierNode);
+            return (ParsedExpression){ LEVEL_UNARY, unaryExpressionNode };
+        }
+        case TK_NOT:
+        case TK_MINUS: {
+            return parseBinaryExpression(vectorList, index, (token->type == TK_NOT) ? PRECEDENCE_NOT : PRECEDENCE_NEGATION);
+        }
+        case TK_ADDRESS_OF: {
+            // C# converts the method group itself to the delegate
+            (*index)++;
+            return parsePostfixExpression(vectorList, index, false);
+        }
+        default: {
+            reportSyntaxError(vectorList, *index, "expected an expression");
+            return error;
+        }
+    }
+}
+
+// the ( at index closes with a ) that more of the same name follows, as in "a(1).Value = x"
+bool isChainedParenthesis(const Vector *vectorList, int index) {
+    int depth = 0;
+    const Token *token = peekToken(vectorList, index);
+
+    while (token != NULL && token->type != TK_NEWLINE) {
+        depth += (token->type == TK_LEFT_PARENTHESIS) - (token->type == TK_RIGHT_PARENTHESIS);
+
+        if (depth == 0) {
+            const int next = peekType(vectorList, index + 1);
+            return next == TK_DOT || next == TK_LEFT_PARENTHESIS || next == TK_EXCLAMATION;
+        }
+
+        token = readLookahead(vectorList, &index);
+    }
+
+    return false;
+}
+
+// Calls and array elements are both name(arguments); the emitter tells them apart. rs!Name is rs("Name"),
+// and a leading . is a member of the innermost With object. A call head stops before a parenthesized
+// argument, since "Foo (a), b" passes (a) and b.
+ParsedExpression parsePostfixExpression(const Vector *vectorList, int *index, bool isCallHead) {
+    const int first = peekType(vectorList, *index);
+    ParsedExpression expression;
+
+    if (first == TK_DOT || first == TK_EXCLAMATION) {
+        if (withObjects->size == 0) {
+            reportSyntaxError(vectorList, *index, "'.' outside a With block");
+            return (ParsedExpression){ 0, NULL };
+        }
+
+        expression = (ParsedExpression){ LEVEL_POSTFIX, withObjects->contents[withObjects->size - 1] };
+    }
+    else {
+        expression = parsePrimaryExpression(vectorList, index);
+
+        if (expression.node == NULL || expression.level != LEVEL_PRIMARY) {
+            return expression;
+        }
+    }
+
+    while (true) {
+        const int type = peekType(vectorList, *index);
+        const Token *name = peekToken(vectorList, *index + 1);
+
+        if (type == TK_LEFT_PARENTHESIS && !(isCallHead && !isChainedParenthesis(vectorList, *index))) {
+            PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+            postfixExpressionNode->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+            postfixExpressionNode->postfixExpressionNode = lowerExpression(expression, LEVEL_POSTFIX);
+            postfixExpressionNode->assignExpressionNodes = parseArguments(vectorList, index, false, NULL);
+
+            if (postfixExpressionNode->assignExpressionNodes == NULL) {
+                return (ParsedExpression){ 0, NULL };
+            }
+
+            expression = (ParsedExpression){ LEVEL_POSTFIX, postfixExpressionNode };
+        }
+        else if (type == TK_DOT && name != NULL && name->type == TK_IDENTIFIER) {
+            PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+            postfixExpressionNode->postfixExpressionType = POSTFIX_DOT;
+            postfixExpressionNode->postfixExpressionNode = lowerExpression(expression, LEVEL_POSTFIX);
+            postfixExpressionNode->identifier = copyNodeString(name->string);
+
+            expression = (ParsedExpression){ LEVEL_POSTFIX, postfixExpressionNode };
+            *index += 2;
+        }
+        else if (type == TK_EXCLAMATION && name != NULL && name->type == TK_IDENTIFIER) {
+            PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+            postfixExpressionNode->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+            postfixExpressionNode->postfixExpressionNode = lowerExpression(expression, LEVEL_POSTFIX);
+            postfixExpressionNode->assignExpressionNodes = buildNodeVector();
+            pushVector(postfixExpressionNode->assignExpressionNodes, lowerExpression(makeStringExpression(name->string), LEVEL_ASSIGNMENT));
+
+            expression = (ParsedExpression){ LEVEL_POSTFIX, postfixExpressionNode };
+            *index += 2;
+        }
+        else if (type == TK_DOT || type == TK_EXCLAMATION) {
+            reportSyntaxError(vectorList, *index + 1, "expected a member name");
+            return (ParsedExpression){ 0, NULL };
+        }
+        else {
+            return expression;
+        }
+    }
+}
+
+// a ^ b is Math.Pow(a, b); VB lets the exponent be negated without parentheses
+ParsedExpression parseExponentExpression(const Vector *vectorList, int *index) {
+    ParsedExpression left = parsePostfixExpression(vectorList, index, false);
+
+    while (left.node != NULL && acceptToken(vectorList, index, TK_HAT)) {
+        ParsedExpression right = (peekType(vectorList, *index) == TK_MINUS) ? parseBinaryExpression(vectorList, index, PRECEDENCE_NEGATION) : parsePostfixExpression(vectorList, index, false);
+
+        if (right.node == NULL) {
+            return right;
+        }
+
+        left = makeCallExpression("Math.Pow", 2, left, right);
+    }
+
+    return left;
+}
+
+const VbOperator *findOperator(const Vector *vectorList, int index, int precedence) {
+    const Token *token = peekToken(vectorList, index);
+
+    for (size_t i = 0; token != NULL && i < sizeof(vbOperators) / sizeof(vbOperators[0]); i++) {
+        const VbOperator *vbOperator = &vbOperators[i];
+
+        if (vbOperator->precedence == precedence && vbOperator->tokenType == token->type
+            && (vbOperator->word == NULL || strcasecmp(vbOperator->word, token->string) == 0)) {
+            return vbOperator;
+        }
+    }
+
+    return NULL;
+}
+
+// Imp is !a | b, Like is the runtime's LikeString, and the operands of / are divided as doubles
+ParsedExpression applyOperator(const VbOperator *vbOperator, ParsedExpression left, ParsedExpression right) {
+    if (vbOperator->tokenType == TK_IDENTIFIER && vbOperator->level == LEVEL_INCLUSIVE_OR) {
+        return makeBinaryExpression(LEVEL_INCLUSIVE_OR, OPERATOR_NONE, makeUnaryExpression(OPERATOR_EXCLAMATION, left), right);
+    }
+
+    if (vbOperator->tokenType == TK_LIKE) {
+        return makeCallExpression("Microsoft.VisualBasic.CompilerServices.LikeOperator.LikeString", 3, left, right, makeIdentifierExpression("Microsoft.VisualBasic.CompareMethod.Binary"));
+    }
+
+    if (vbOperator->tokenType == TK_SLASH) {
+        left = makeDoubleCast(left);
+    }
+
+    return makeBinaryExpression(vbOperator->level, vbOperator->operatorType, left, right);
+}
+
+// One VB precedence level and everything tighter. Each level's operators are left-associative and build the
+// tree's node for the same C# operator, so the tree parenthesizes wherever C#'s precedence differs.
+ParsedExpression parseBinaryExpression(const Vector *vectorList, int *index, int precedence) {
+    if (precedence == PRECEDENCE_NOT || precedence == PRECEDENCE_NEGATION) {
+        const int unaryToken = (precedence == PRECEDENCE_NOT) ? TK_NOT : TK_MINUS;
+
+        if (!acceptToken(vectorList, index, unaryToken)) {
+            return (precedence == PRECEDENCE_NOT) ? parseBinaryExpression(vectorList, index, precedence + 1) : parseExponentExpression(vectorList, index);
+        }
+
+        if (++nestingDepth > MAX_NESTING_DEPTH) {
+            reportSyntaxError(vectorList, *index, "expression is nested too deeply");
+            nestingDepth--;
+            return (ParsedExpression){ 0, NULL };
+        }
+
+        ParsedExpression operand = parseBinaryExpression(vectorList, index, precedence);
+        nestingDepth--;
+
+        if (operand.node == NULL) {
+            return operand;
+        }
+
+        return makeUnaryExpression((precedence == PRECEDENCE_NOT) ? OPERATOR_EXCLAMATION : OPERATOR_SUBTRACT, operand);
+    }
+
+    ParsedExpression left = parseBinaryExpression(vectorList, index, precedence + 1);
+    const VbOperator *vbOperator;
+
+    while (left.node != NULL && (vbOperator = findOperator(vectorList, *index, precedence)) != NULL) {
+        (*index)++;
+        ParsedExpression right = parseBinaryExpression(vectorList, index, precedence + 1);
+
+        if (right.node == NULL) {
+            return right;
+        }
+
+        left = applyOperator(vbOperator, left, right);
+    }
+
+    return left;
+}
+
+// the type a Const without an As clause takes from its literal
+TypeSpecifierNode *getLiteralType(ParsedExpression expression) {
+    if (expression.level == LEVEL_UNARY) {
+        const UnaryExpressionNode *unaryExpressionNode = expression.node;
+        const CastExpressionNode *castExpressionNode = unaryExpressionNode->castExpressionNode;
+
+        if (unaryExpressionNode->type != UNARY_OPERATOR || castExpressionNode == NULL || castExpressionNode->unaryExpressionNode == NULL
+            || castExpressionNode->unaryExpressionNode->postfixExpressionNode == NULL) {
+            return NULL;
+        }
+
+        expression = (ParsedExpression){ LEVEL_PRIMARY, castExpressionNode->unaryExpressionNode->postfixExpressionNode->primaryExpressionNode };
+    }
+
+    const PrimaryExpressionNode *primaryExpressionNode = (expression.level == LEVEL_PRIMARY) ? expression.node : NULL;
+
+    if (primaryExpressionNode == NULL) {
+        return NULL;
+    }
+
+    if (primaryExpressionNode->str != NULL) {
+        return makeTypeSpecifier(TYPE_SC8, NULL);
+    }
+
+    if (primaryExpressionNode->constantNode == NULL) {
+        return NULL;
+    }
+
+    switch (primaryExpressionNode->constantNode->constantType) {
+        case CONSTANT_FP64: {
+            return makeTypeSpecifier(TYPE_FP64, NULL);
+        }
+        case CONSTANT_B8: {
+            return makeTypeSpecifier(TYPE_B8, NULL);
+        }
+        default: {
+            return makeTypeSpecifier(TYPE_SI32, NULL);
+        }
+    }
+}
+
+DeclarationNode *makeSingleDeclarationNode(bool isConstant, TypeSpecifierNode *typeSpecifierNode, DirectDeclaratorNode *directDeclaratorNode, InitializerNode *initializerNode) {
+    DeclarationNode *declarationNode = allocateNode(sizeof(DeclarationNode));
+    DeclarationSpecifierNode *declarationSpecifierNode = allocateNode(sizeof(DeclarationSpecifierNode));
+    InitializeDeclaratorNode *initializeDeclaratorNode = allocateNode(sizeof(InitializeDeclaratorNode));
+
+    declarationSpecifierNode->isConstant = isConstant;
+    declarationSpecifierNode->typeSpecifierNode = typeSpecifierNode;
+    initializeDeclaratorNode->declaratorNode = allocateNode(sizeof(DeclaratorNode));
+    initializeDeclaratorNode->declaratorNode->directDeclaratorNode = directDeclaratorNode;
+    initializeDeclaratorNode->initializerNode = initializerNode;
+
+    declarationNode->declarationSpecifierNodes = buildNodeVector();
+    declarationNode->initializeDeclaratorNodes = buildNodeVector();
+    pushVector(declarationNode->declarationSpecifierNodes, declarationSpecifierNode);
+    pushVector(declarationNode->initializeDeclaratorNodes, initializeDeclaratorNode);
+
+    return declarationNode;
+}
+
+// name[(bounds)] [As [New] Type] [= value], for Dim, Private, Public, Static and Const. Each name becomes a
+// declaration of its own, since each has its own As clause; a name without one is a Variant.
+bool makeDeclarationNodes(const Vector *vectorList, int *index, bool isConstant, Vector *declarationNodes) {
+    do {
+        acceptToken(vectorList, index, TK_WITH_EVENTS);
+
+        const Token *token = peekToken(vectorList, *index);
+
+        if (token == NULL || token->type != TK_IDENTIFIER) {
+            reportSyntaxError(vectorList, *index, "expected a variable name");
+            return false;
+        }
+
+        DirectDeclaratorNode *directDeclaratorNode = allocateNode(sizeof(DirectDeclaratorNode));
+        TypeSpecifierNode *typeSpecifierNode = NULL;
+        InitializerNode *initializerNode = NULL;
+
+        directDeclaratorNode->identifier = copyNodeString(token->string);
+        (*index)++;
+
+        if (acceptToken(vectorList, index, TK_LEFT_PARENTHESIS)) {
+            if (acceptToken(vectorList, index, TK_RIGHT_PARENTHESIS)) {
+                directDeclaratorNode->isDynamic = true;
+            }
+            else {
+                const int start = *index;
+                ParsedExpression lower;
+                ParsedExpression upper = parseRange(vectorList, index, &lower);
+
+                if (upper.node == NULL) {
+                    return false;
+                }
+
+                directDeclaratorNode->conditionalExpressionNode = lowerExpression(upper, LEVEL_CONDITIONAL);
+                directDeclaratorNode->lowerBound = getLowerBound(vectorList, start, lower);
+
+                // the upper bounds of the dimensions after the first, which share its lower bound or leave it unknown
+                while (peekType(vectorList, *index) == TK_COMMA) {
+                    const int dimension = ++*index;
+
+                    if ((upper = parseRange(vectorList, index, &lower)).node == NULL) {
+                        return false;
+                    }
+
+                    if (directDeclaratorNode->dimensionNodes == NULL) {
+                        directDeclaratorNode->dimensionNodes = buildNodeVector();
+                    }
+
+                    if (getLowerBound(vectorList, dimension, lower) != directDeclaratorNode->lowerBound) {
+                        directDeclaratorNode->lowerBound = -1;
+                    }
+
+                    pushVector(directDeclaratorNode->dimensionNodes, lowerExpression(upper, LEVEL_CONDITIONAL));
+                }
+
+                if (!expectToken(vectorList, index, TK_RIGHT_PARENTHESIS, ")")) {
+                    return false;
+                }
+            }
+        }
+
+        if (acceptToken(vectorList, index, TK_AS) && (typeSpecifierNode = makeTypeSpecifierNode(vectorList, index)) == NULL) {
+            return false;
+        }
+
+        if (acceptToken(vectorList, index, TK_ASSIGNMENT)) {
+            ParsedExpression value = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+            if (value.node == NULL) {
+                return false;
+            }
+
+            initializerNode = allocateNode(sizeof(InitializerNode));
+            initializerNode->assignmentExpressionNode = lowerExpression(value, LEVEL_ASSIGNMENT);
+
+            if (typeSpecifierNode == NULL && isConstant) {
+                typeSpecifierNode = getLiteralType(value);
+            }
+        }
+
+        pushVector(declarationNodes, makeSingleDeclarationNode(isConstant, typeSpecifierNode, directDeclaratorNode, initializerNode));
+    } while (acceptToken(vectorList, index, TK_COMMA));
+
+    return true;
+}
+
+// [Optional] [ByVal | ByRef] [ParamArray] name[()] [As Type] [= default]; defaults are dropped
+ParameterTypeListNode *makeParameterTypeListNode(const Vector *vectorList, int *index) {
+    ParameterTypeListNode *parameterTypeListNode = allocateNode(sizeof(ParameterTypeListNode));
+    ParameterListNode **next = &parameterTypeListNode->parameterListNode;
+
+    if (!acceptToken(vectorList, index, TK_LEFT_PARENTHESIS) || acceptToken(vectorList, index, TK_RIGHT_PARENTHESIS)) {
+        return parameterTypeListNode;
+    }
+
+    do {
+        acceptToken(vectorList, index, TK_OPTIONAL);
+        const bool isByVal = acceptToken(vectorList, index, TK_BY_VAL);
+        acceptToken(vectorList, index, TK_BY_REF);
+        acceptToken(vectorList, index, TK_PARAM_ARRAY);
+
+        const Token *token = peekToken(vectorList, *index);
+
+        if (token == NULL || token->type != TK_IDENTIFIER) {
+            reportSyntaxError(vectorList, *index, "expected a parameter name");
+            return NULL;
+        }
+
+        ParameterDeclarationNode *parameterDeclarationNode = allocateNode(sizeof(ParameterDeclarationNode));
+        DirectDeclaratorNode *directDeclaratorNode = allocateNode(sizeof(DirectDeclaratorNode));
+        DeclarationSpecifierNode *declarationSpecifierNode = allocateNode(sizeof(DeclarationSpecifierNode));
+
+        directDeclaratorNode->identifier = copyNodeString(token->string);
+        (*index)++;
+
+        if (acceptToken(vectorList, index, TK_LEFT_PARENTHESIS)) {
+            directDeclaratorNode->isDynamic = true;
+
+            if (!expectToken(vectorList, index, TK_RIGHT_PARENTHESIS, ")")) {
+                return NULL;
+            }
+        }
+
+        if (acceptToken(vectorList, index, TK_AS) && (declarationSpecifierNode->typeSpecifierNode = makeTypeSpecifierNode(vectorList, index)) == NULL) {
+            return NULL;
+        }
+
+        if (acceptToken(vectorList, index, TK_ASSIGNMENT) && parseBinaryExpression(vectorList, index, PRECEDENCE_IMP).node == NULL) {
+            return NULL;
+        }
+
+        parameterDeclarationNode->declaratorSpecifierNodes = buildNodeVector();
+        parameterDeclarationNode->isByVal = isByVal;
+        pushVector(parameterDeclarationNode->declaratorSpecifierNodes, declarationSpecifierNode);
+        parameterDeclarationNode->declaratorNode = allocateNode(sizeof(DeclaratorNode));
+        parameterDeclarationNode->declaratorNode->directDeclaratorNode = directDeclaratorNode;
+
+        *next = allocateNode(sizeof(ParameterListNode));
+        (*next)->parameterDeclarationNode = parameterDeclarationNode;
+        next = &(*next)->parameterListNode;
+    } while (acceptToken(vectorList, index, TK_COMMA));
+
+    return expectToken(vectorList, index, TK_RIGHT_PARENTHESIS, ")") ? parameterTypeListNode : NULL;
+}
+
+StatementNode *makeCompoundStatement(CompoundStatementNode *compoundStatementNode) {
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+    statementNode->compoundStatementNode = compoundStatementNode;
+    return statementNode;
+}
+
+StatementNode *makeJumpStatement(int type, const char *identifier) {
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+    statementNode->jumpStatementNode = allocateNode(sizeof(JumpStatementNode));
+    statementNode->jumpStatementNode->type = type;
+    statementNode->jumpStatementNode->identifier = (identifier != NULL) ? copyNodeString(identifier) : NULL;
+    return statementNode;
+}
+
+StatementNode *makeExpressionStatement(ParsedExpression expression) {
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+    statementNode->expressionStatementNode = allocateNode(sizeof(ExpressionStatementNode));
+    statementNode->expressionStatementNode->expressionNode = liftExpression(expression, LEVEL_EXPRESSION);
+    return statementNode;
+}
+
+void pushStatement(Vector *blockItemNodes, StatementNode *statementNode) {
+    BlockItemNode *blockItemNode = allocateNode(sizeof(BlockItemNode));
+    blockItemNode->statementNode = statementNode;
+    pushVector(blockItemNodes, blockItemNode);
+}
+
+// a line number is a label too; C# needs it to start with a letter
+const char *getLabelName(const Token *token) {
+    static _Thread_local char name[32];
+
+    if (token->type == TK_NUMBER) {
+        snprintf(name, sizeof(name), "Line%d", token->num);
+        return name;
+    }
+
+    return (token->type == TK_IDENTIFIER) ? token->string : NULL;
+}
+
+// the keywords that close a block, left for the statement that opened it
+bool isBlockEnd(const Vector *vectorList, int index) {
+    if (pendingNextCount > 0) {
+        return true;
+    }
+
+    switch (peekType(vectorList, index)) {
+        case TK_ELSE:
+        case TK_ELSE_IF:
+        case TK_END_IF:
+        case TK_NEXT:
+        case TK_LOOP:
+        case TK_WEND:
+        case TK_CASE: {
+            return true;
+        }
+        case TK_END: {
+            const int next = peekType(vectorList, index + 1);
+            return next == TK_IF || next == TK_SELECT || next == TK_WITH || next == TK_SUB || next == TK_FUNCTION || next == TK_PROPERTY;
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+// "End If", also spelled EndIf
+bool acceptBlockEnd(const Vector *vectorList, int *index, int type, const char *text) {
+    if (type == TK_IF && acceptToken(vectorList, index, TK_END_IF)) {
+        return true;
+    }
+
+    if (peekType(vectorList, *index) == TK_END && peekType(vectorList, *index + 1) == type) {
+        *index += 2;
+        return true;
+    }
+
+    reportSyntaxError(vectorList, *index, "expected '%s'", text);
+    return false;
+}
+
+// Statements up to the keyword that ends the enclosing block, which is left for the caller to check.
+CompoundStatementNode *makeCompoundStatementNode(const Vector *vectorList, int *index) {
+    CompoundStatementNode *compoundStatementNode = allocateNode(sizeof(CompoundStatementNode));
+    compoundStatementNode->blockItemNodes = buildNodeVector();
+
+    if (++nestingDepth > MAX_NESTING_DEPTH) {
+        reportSyntaxError(vectorList, *index, "blocks are nested too deeply");
+        nestingDepth--;
+        return NULL;
+    }
+
+    while (!isOverBudget()) {
+        while (acceptToken(vectorList, index, TK_NEWLINE) || acceptToken(vectorList, index, TK_COLON)) {
+        }
+
+        if (*index >= vectorList->size || isBlockEnd(vectorList, *index)) {
+            break;
+        }
+
+        // a block statement stops after its closing keyword's line, a simple one at the end of its statement
+        if (!makeStatementNodes(vectorList, index, compoundStatementNode->blockItemNodes)) {
+            skipLine(vectorList, index);
+        }
+        else if (!isStatementEnd(vectorList, *index) && !isLineStart(vectorList, *index)) {
+            reportSyntaxError(vectorList, *index, "expected the end of the statement");
+            skipLine(vectorList, index);
+        }
+    }
+
+    nestingDepth--;
+    return compoundStatementNode;
+}
+
+// the statements of a single-line If's Then or Else part, up to its Else or the end of the line
+CompoundStatementNode *makeInlineStatements(const Vector *vectorList, int *index) {
+    CompoundStatementNode *compoundStatementNode = allocateNode(sizeof(CompoundStatementNode));
+    compoundStatementNode->blockItemNodes = buildNodeVector();
+
+    while (!isLineEnd(vectorList, *index) && peekType(vectorList, *index) != TK_ELSE) {
+        if (acceptToken(vectorList, index, TK_COLON)) {
+            continue;
+        }
+
+        if (!makeStatementNodes(vectorList, index, compoundStatementNode->blockItemNodes)) {
+            return NULL;
+        }
+
+        if (!isStatementEnd(vectorList, *index) && peekType(vectorList, *index) != TK_ELSE) {
+            reportSyntaxError(vectorList, *index, "expected the end of the statement");
+            return NULL;
+        }
+    }
+
+    return compoundStatementNode;
+}
+
+SelectionStatementNode *makeIfNode(ExpressionNode *condition, CompoundStatementNode *thenNode) {
+    SelectionStatementNode *selectionStatementNode = allocateNode(sizeof(SelectionStatementNode));
+    selectionStatementNode->selectionType = SELECTION_IF;
+    selectionStatementNode->expressionNode = condition;
+    selectionStatementNode->statementNode1 = makeCompoundStatement(thenNode);
+    return selectionStatementNode;
+}
+
+// If ... Then on one line, or a block with any ElseIf and Else parts, which chain as else-ifs
+bool makeIfStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    (*index)++;
+
+    ExpressionNode *condition = makeExpressionNode(vectorList, index);
+
+    if (condition == NULL || !expectToken(vectorList, index, TK_THEN, "Then")) {
+        return false;
+    }
+
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+
+    if (!isLineEnd(vectorList, *index)) {
+        CompoundStatementNode *thenNode = makeInlineStatements(vectorList, index);
+
+        if (thenNode == NULL) {
+            return false;
+        }
+
+        statementNode->selectionStatementNode = makeIfNode(condition, thenNode);
+
+        if (acceptToken(vectorList, index, TK_ELSE)) {
+            CompoundStatementNode *elseNode = makeInlineStatements(vectorList, index);
+
+            if (elseNode == NULL) {
+                return false;
+            }
+
+            statementNode->selectionStatementNode->selectionType = SELECTION_IF_ELSE;
+            statementNode->selectionStatementNode->statementNode2 = makeCompoundStatement(elseNode);
+        }
+
+        pushStatement(blockItemNodes, statementNode);
+        return true;
+    }
+
+    CompoundStatementNode *thenNode = makeCompoundStatementNode(vectorList, index);
+
+    if (thenNode == NULL) {
+        return false;
+    }
+
+    SelectionStatementNode *last = statementNode->selectionStatementNode = makeIfNode(condition, thenNode);
+
+    while (peekType(vectorList, *index) == TK_ELSE_IF) {
+        (*index)++;
+        condition = makeExpressionNode(vectorList, index);
+
+        if (condition == NULL || !expectToken(vectorList, index, TK_THEN, "Then") || (thenNode = makeCompoundStatementNode(vectorList, index)) == NULL) {
+            return false;
+        }
+
+        StatementNode *elseIfNode = allocateNode(sizeof(StatementNode));
+        elseIfNode->selectionStatementNode = makeIfNode(condition, thenNode);
+        last->selectionType = SELECTION_IF_ELSE;
+        last->statementNode2 = elseIfNode;
+        last = elseIfNode->selectionStatementNode;
+    }
+
+    if (acceptToken(vectorList, index, TK_ELSE)) {
+        CompoundStatementNode *elseNode = makeCompoundStatementNode(vectorList, index);
+
+        if (elseNode == NULL) {
+            return false;
+        }
+
+        last->selectionType = SELECTION_IF_ELSE;
+        last->statementNode2 = makeCompoundStatement(elseNode);
+    }
+
+    if (!acceptBlockEnd(vectorList, index, TK_IF, "End If")) {
+        return false;
+    }
+
+    pushStatement(blockItemNodes, statementNode);
+    return true;
+}
+
+// One Case clause's tests against the selector: "Is < 5", "1 To 3" and plain values, joined with ||.
+// isMatch is cleared by any test a C# case label cannot hold.
+ParsedExpression parseCaseTests(const Vector *vectorList, int *index, ParsedExpression selector, Vector *values, bool *isMatch) {
+    ParsedExpression tests = { 0, NULL };
+
+    do {
+        ParsedExpression test;
+
+        if (acceptToken(vectorList, index, TK_IS)) {
+            const VbOperator *vbOperator = findOperator(vectorList, *index, PRECEDENCE_COMPARISON);
+
+            if (vbOperator == NULL || vbOperator->tokenType == TK_LIKE || vbOperator->tokenType == TK_IS) {
+                reportSyntaxError(vectorList, *index, "expected a comparison after 'Is'");
+                return (ParsedExpression){ 0, NULL };
+            }
+
+            (*index)++;
+            ParsedExpression value = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+            if (value.node == NULL) {
+                return value;
+            }
+
+            test = makeBinaryExpression(vbOperator->level, vbOperator->operatorType, selector, value);
+            *isMatch = false;
+        }
+        else {
+            ParsedExpression lower;
+            ParsedExpression value = parseRange(vectorList, index, &lower);
+
+            if (value.node == NULL) {
+                return value;
+            }
+
+            if (lower.node != NULL) {
+                test = makeBinaryExpression(LEVEL_LOGICAL_AND, OPERATOR_NONE,
+                    makeBinaryExpression(LEVEL_RELATIONAL, COMPARE_GREATER_OR_EQUAL, selector, lower),
+                    makeBinaryExpression(LEVEL_RELATIONAL, COMPARE_LESS_OR_EQUAL, selector, value));
+                *isMatch = false;
+            }
+            else {
+                test = makeBinaryExpression(LEVEL_EQUAL, COMPARE_EQUAL, selector, value);
+                pushVector(values, lowerExpression(value, LEVEL_CONDITIONAL));
+            }
+        }
+
+        tests = (tests.node == NULL) ? test : makeBinaryExpression(LEVEL_OR, OPERATOR_NONE, tests, test);
+    } while (acceptToken(vectorList, index, TK_COMMA));
+
+    return tests;
+}
+
+// a selector the if-chain form can read once per test without evaluating anything twice
+bool isPlainSelector(ParsedExpression selector) {
+    const PostfixExpressionNode *postfixExpressionNode = (selector.level == LEVEL_POSTFIX) ? selector.node : NULL;
+
+    while (postfixExpressionNode != NULL && postfixExpressionNode->postfixExpressionType == POSTFIX_DOT) {
+        postfixExpressionNode = postfixExpressionNode->postfixExpressionNode;
+    }
+
+    return selector.level == LEVEL_PRIMARY || (postfixExpressionNode != NULL && postfixExpressionNode->postfixExpressionType == POSTFIX_PRIMARY);
+}
+
+// Select Case with only plain values is a switch: each Case is a case label around its body, and "Case 1, 2"
+// nests one label inside the other. Is and To tests need the if-chain form, which reads the selector once per
+// test and so only takes a variable or member.
+bool makeSelectStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const int start = *index;
+    *index += 1;
+
+    if (!expectToken(vectorList, index, TK_CASE, "Case")) {
+        return false;
+    }
+
+    ParsedExpression selector = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+    if (selector.node == NULL) {
+        return false;
+    }
+
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+    CompoundStatementNode *cases = allocateNode(sizeof(CompoundStatementNode));
+    SelectionStatementNode *last = NULL;
+    StatementNode **chain = &statementNode;
+    bool isMatch = true;
+
+    cases->blockItemNodes = buildNodeVector();
+
+    while (acceptToken(vectorList, index, TK_NEWLINE) || acceptToken(vectorList, index, TK_COLON)) {
+    }
+
+    while (acceptToken(vectorList, index, TK_CASE)) {
+        LabelStatementNode *labelStatementNode = allocateNode(sizeof(LabelStatementNode));
+        StatementNode *labelNode = allocateNode(sizeof(StatementNode));
+        Vector *values = buildNodeVector();
+        ParsedExpression tests = { 0, NULL };
+
+        if (acceptToken(vectorList, index, TK_ELSE)) {
+            labelStatementNode->labeledStatementType = LABEL_DEFAULT;
+        }
+        else if ((tests = parseCaseTests(vectorList, index, selector, values, &isMatch)).node == NULL) {
+            return false;
+        }
+
+        CompoundStatementNode *body = makeCompoundStatementNode(vectorList, index);
+
+        if (body == NULL) {
+            return false;
+        }
+
+        labelNode->labeledStatementNode = labelStatementNode;
+        labelStatementNode->statementNode = makeCompoundStatement(body);
+
+        for (int i = values->size - 1; i >= 0; i--) {
+            LabelStatementNode *caseNode = (i == values->size - 1) ? labelStatementNode : allocateNode(sizeof(LabelStatementNode));
+
+            if (caseNode != labelStatementNode) {
+                caseNode->statementNode = labelNode;
+                labelNode = allocateNode(sizeof(StatementNode));
+                labelNode->labeledStatementNode = caseNode;
+            }
+
+            caseNode->labeledStatementType = LABEL_CASE;
+            caseNode->conditionalExpressionNode = values->contents[i];
+        }
+
+        pushStatement(cases->blockItemNodes, labelNode);
+
+        // the same clause in the if-chain form, which is only kept when a clause turns out to need it
+        if (tests.node == NULL && chain != NULL) {
+            *chain = makeCompoundStatement(body);
+            chain = NULL;
+        }
+        else if (chain != NULL) {
+            StatementNode *ifNode = allocateNode(sizeof(StatementNode));
+            ifNode->selectionStatementNode = makeIfNode(liftExpression(tests, LEVEL_EXPRESSION), body);
+
+            if (last != NULL) {
+                last->selectionType = SELECTION_IF_ELSE;
+            }
+
+            *chain = ifNode;
+            last = ifNode->selectionStatementNode;
+            chain = &last->statementNode2;
+        }
+    }
+
+    if (!acceptBlockEnd(vectorList, index, TK_SELECT, "End Select")) {
+        return false;
+    }
+
+    if (isMatch) {
+        statementNode = allocateNode(sizeof(StatementNode));
+        statementNode->selectionStatementNode = allocateNode(sizeof(SelectionStatementNode));
+        statementNode->selectionStatementNode->selectionType = SELECTION_MATCH;
+        statementNode->selectionStatementNode->expressionNode = liftExpression(selector, LEVEL_EXPRESSION);
+        statementNode->selectionStatementNode->statementNode1 = makeCompoundStatement(cases);
+    }
+    else if (!isPlainSelector(selector)) {
+        reportSyntaxError(vectorList, start, "Select Case with Is or To needs a variable as its selector");
+        return false;
+    }
+    else if (last != NULL && last->statementNode2 != NULL) {
+        last->selectionType = SELECTION_IF_ELSE;
+    }
+
+    pushStatement(blockItemNodes, statementNode);
+    return true;
+}
+
+// true for a Step known to count down
+bool isNegativeStep(ParsedExpression step) {
+    if (step.node == NULL || step.level != LEVEL_UNARY) {
+        return false;
+    }
+
+    const UnaryExpressionNode *unaryExpressionNode = step.node;
+    return unaryExpressionNode->type == UNARY_OPERATOR && unaryExpressionNode->operatorType == OPERATOR_SUBTRACT;
+}
+
+bool isConstantStep(ParsedExpression step) {
+    if (isNegativeStep(step)) {
+        const CastExpressionNode *castExpressionNode = ((const UnaryExpressionNode *)step.node)->castExpressionNode;
+        const PostfixExpressionNode *postfixExpressionNode = (castExpressionNode->unaryExpressionNode != NULL) ? castExpressionNode->unaryExpressionNode->postfixExpressionNode : NULL;
+        return postfixExpressionNode != NULL && postfixExpressionNode->primaryExpressionNode != NULL && postfixExpressionNode->primaryExpressionNode->constantNode != NULL;
+    }
+
+    return step.level == LEVEL_PRIMARY && ((const PrimaryExpressionNode *)step.node)->constantNode != NULL;
+}
+
+bool isUnitStep(ParsedExpression step) {
+    const ParsedExpression magnitude = isNegativeStep(step) ? (ParsedExpression){ LEVEL_PRIMARY, ((const UnaryExpressionNode *)step.node)->castExpressionNode->unaryExpressionNode->postfixExpressionNode->primaryExpressionNode } : step;
+    const ConstantNode *constantNode = isConstantStep(step) ? ((const PrimaryExpressionNode *)magnitude.node)->constantNode : NULL;
+
+    return step.node == NULL || (constantNode != NULL && constantNode->constantType == CONSTANT_SI32 && constantNode->integerConstant == 1);
+}
+
+// the Next closing a For, or nothing when an inner "Next j, i" already closed it
+bool acceptNext(const Vector *vectorList, int *index) {
+    if (pendingNextCount > 0) {
+        pendingNextCount--;
+        return true;
+    }
+
+    if (!expectToken(vectorList, index, TK_NEXT, "Next")) {
+        return false;
+    }
+
+    if (peekType(vectorList, *index) == TK_IDENTIFIER) {
+        (*index)++;
+
+        while (acceptToken(vectorList, index, TK_COMMA) && acceptToken(vectorList, index, TK_IDENTIFIER)) {
+            pendingNextCount++;
+        }
+    }
+
+    return true;
+}
+
+// For Each v In items walks the enumerator of items, declared just ahead of the loop: the loop is
+// for (e = items.GetEnumerator(); e.MoveNext(); ) with v = e.Current first in its body, so Exit For leaves it
+bool makeForEachStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    (*index)++;
+
+    ParsedExpression element = parsePostfixExpression(vectorList, index, false);
+
+    if (element.node == NULL || !expectToken(vectorList, index, TK_IN, "In")) {
+        return false;
+    }
+
+    ParsedExpression items = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+    if (items.node == NULL) {
+        return false;
+    }
+
+    CompoundStatementNode *body = makeCompoundStatementNode(vectorList, index);
+
+    if (body == NULL || !acceptNext(vectorList, index)) {
+        return false;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "_each%d", ++eachCount);
+
+    DirectDeclaratorNode *directDeclaratorNode = allocateNode(sizeof(DirectDeclaratorNode));
+    directDeclaratorNode->identifier = copyNodeString(name);
+
+    BlockItemNode *declaration = allocateNode(sizeof(BlockItemNode));
+    declaration->declarationNode = makeSingleDeclarationNode(false, makeTypeSpecifier(TYPENAME, "System.Collections.IEnumerator"), directDeclaratorNode, NULL);
+    pushVector(blockItemNodes, declaration);
+
+    const ParsedExpression enumerator = makeIdentifierExpression(name);
+
+    // the element is set before the statements of the body
+    Vector *bodyItemNodes = buildNodeVector();
+    pushStatement(bodyItemNodes, makeExpressionStatement(makeAssignmentExpression(element, OPERATOR_ASSIGN, makeMemberExpression(enumerator, "Current", false))));
+
+    for (int i = 0; i < body->blockItemNodes->size; i++) {
+        pushVector(bodyItemNodes, body->blockItemNodes->contents[i]);
+    }
+
+    body->blockItemNodes = bodyItemNodes;
+
+    IterationStatementNode *iterationStatementNode = allocateNode(sizeof(IterationStatementNode));
+    iterationStatementNode->type = ITERATION_FOR;
+    iterationStatementNode->expressionNode1 = liftExpression(makeAssignmentExpression(enumerator, OPERATOR_ASSIGN, makeMemberExpression(items, "GetEnumerator", true)), LEVEL_EXPRESSION);
+    iterationStatementNode->expressionNode2 = liftExpression(makeMemberExpression(enumerator, "MoveNext", true), LEVEL_EXPRESSION);
+    iterationStatementNode->statementNode = makeCompoundStatement(body);
+
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+    statementNode->iterationStatementNode = iterationStatementNode;
+    pushStatement(blockItemNodes, statementNode);
+    return true;
+}
+
+// For i = a To b [Step s] is for (i = a; i <= b; i++), counting down with >= when s is negative, and testing
+// the sign at run time when s is not a constant. "Next j, i" also closes the enclosing For.
+bool makeForStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    (*index)++;
+
+    if (peekType(vectorList, *index) == TK_EACH) {
+        return makeForEachStatement(vectorList, index, blockItemNodes);
+    }
+
+    ParsedExpression counter = parsePostfixExpression(vectorList, index, false);
+
+    if (counter.node == NULL || !expectToken(vectorList, index, TK_ASSIGNMENT, "=")) {
+        return false;
+    }
+
+    ParsedExpression first = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+    if (first.node == NULL || !expectToken(vectorList, index, TK_TO, "To")) {
+        return false;
+    }
+
+    ParsedExpression last = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+    ParsedExpression step = { 0, NULL };
+
+    if (last.node == NULL || (acceptToken(vectorList, index, TK_STEP) && (step = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP)).node == NULL)) {
+        return false;
+    }
+
+    CompoundStatementNode *body = makeCompoundStatementNode(vectorList, index);
+
+    if (body == NULL || !acceptNext(vectorList, index)) {
+        return false;
+    }
+
+    const ParsedExpression upward = makeBinaryExpression(LEVEL_RELATIONAL, COMPARE_LESS_OR_EQUAL, counter, last);
+    const ParsedExpression downward = makeBinaryExpression(LEVEL_RELATIONAL, COMPARE_GREATER_OR_EQUAL, counter, last);
+    IterationStatementNode *iterationStatementNode = allocateNode(sizeof(IterationStatementNode));
+    ParsedExpression condition = isNegativeStep(step) ? downward : upward;
+    ParsedExpression increment;
+
+    if (step.node != NULL && !isConstantStep(step)) {
+        ConditionalExpressionNode *conditionalExpressionNode = allocateNode(sizeof(ConditionalExpressionNode));
+        conditionalExpressionNode->orExpressionNode = lowerExpression(makeBinaryExpression(LEVEL_RELATIONAL, COMPARE_GREATER_OR_EQUAL, step, makeConstantExpression(CONSTANT_SI32, 0)), LEVEL_OR);
+        conditionalExpressionNode->expressionNode = liftExpression(upward, LEVEL_EXPRESSION);
+        conditionalExpressionNode->conditionalExpressionNode = lowerExpression(downward, LEVEL_CONDITIONAL);
+        condition = (ParsedExpression){ LEVEL_CONDITIONAL, conditionalExpressionNode };
+    }
+
+    if (isUnitStep(step)) {
+        PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+        postfixExpressionNode->postfixExpressionType = isNegativeStep(step) ? POSTFIX_DECREMENT : POSTFIX_INCREMENT;
+        postfixExpressionNode->postfixExpressionNode = lowerExpression(counter, LEVEL_POSTFIX);
+        increment = (ParsedExpression){ LEVEL_POSTFIX, postfixExpressionNode };
+    }
+    else {
+        increment = makeAssignmentExpression(counter, OPERATOR_ADD_EQUAL, step);
+    }
+
+    iterationStatementNode->type = ITERATION_FOR;
+    iterationStatementNode->expressionNode1 = liftExpression(makeAssignmentExpression(counter, OPERATOR_ASSIGN, first), LEVEL_EXPRESSION);
+    iterationStatementNode->expressionNode2 = liftExpression(condition, LEVEL_EXPRESSION);
+    iterationStatementNode->expressionNode3 = liftExpression(increment, LEVEL_EXPRESSION);
+    iterationStatementNode->statementNode = makeCompoundStatement(body);
+
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+    statementNode->iterationStatementNode = iterationStatementNode;
+    pushStatement(blockItemNodes, statementNode);
+    return true;
+}
+
+// While or Until and its condition, negated for Until; NULL when neither follows
+ExpressionNode *parseLoopCondition(const Vector *vectorList, int *index, bool *isError) {
+    const bool isWhile = acceptToken(vectorList, index, TK_WHILE);
+
+    if (!isWhile && !acceptTokenWord(vectorList, index, "Until")) {
+        return NULL;
+    }
+
+    ParsedExpression condition = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+    if (condition.node == NULL) {
+        *isError = true;
+        return NULL;
+    }
+
+    return liftExpression(isWhile ? condition : makeUnaryExpression(OPERATOR_EXCLAMATION, condition), LEVEL_EXPRESSION);
+}
+
+// Do [While | Until c] ... Loop tests first and is a while; Do ... Loop While | Until c tests after the body
+// and is ITERATION_DO. While ... Wend is a while too.
+bool makeDoStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const bool isWend = (peekType(vectorList, *index) == TK_WHILE);
+    IterationStatementNode *iterationStatementNode = allocateNode(sizeof(IterationStatementNode));
+    bool isError = false;
+
+    if (isWend) {
+        ParsedExpression condition = (++*index, parseBinaryExpression(vectorList, index, PRECEDENCE_IMP));
+
+        if (condition.node == NULL) {
+            return false;
+        }
+
+        iterationStatementNode->expressionNode1 = liftExpression(condition, LEVEL_EXPRESSION);
+    }
+    else {
+        (*index)++;
+        iterationStatementNode->expressionNode1 = parseLoopCondition(vectorList, index, &isError);
+    }
+
+    CompoundStatementNode *body = isError ? NULL : makeCompoundStatementNode(vectorList, index);
+
+    if (body == NULL || !expectToken(vectorList, index, isWend ? TK_WEND : TK_LOOP, isWend ? "Wend" : "Loop")) {
+        return false;
+    }
+
+    iterationStatementNode->type = ITERATION_WHILE;
+    iterationStatementNode->isWend = isWend;
+    iterationStatementNode->statementNode = makeCompoundStatement(body);
+
+    if (!isWend) {
+        ExpressionNode *after = parseLoopCondition(vectorList, index, &isError);
+
+        if (isError || (after != NULL && iterationStatementNode->expressionNode1 != NULL)) {
+            if (!isError) {
+                reportSyntaxError(vectorList, *index, "a Do loop tests its condition either before or after the body");
+            }
+
+            return false;
+        }
+
+        if (after != NULL) {
+            iterationStatementNode->type = ITERATION_DO;
+            iterationStatementNode->expressionNode1 = after;
+        }
+        else if (iterationStatementNode->expressionNode1 == NULL) {
+            iterationStatementNode->expressionNode1 = liftExpression(makeConstantExpression(CONSTANT_B8, -1), LEVEL_EXPRESSION);
+        }
+    }
+
+    StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+    statementNode->iterationStatementNode = iterationStatementNode;
+    pushStatement(blockItemNodes, statementNode);
+    return true;
+}
+
+// With's object is read again by each .member inside, so the block is just its statements
+bool makeWithStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    (*index)++;
+
+    ParsedExpression object = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+    if (object.node == NULL) {
+        return false;
+    }
+
+    pushVector(withObjects, lowerExpression(object, LEVEL_POSTFIX));
+    CompoundStatementNode *body = makeCompoundStatementNode(vectorList, index);
+    withObjects->size--;
+
+    if (body == NULL || !acceptBlockEnd(vectorList, index, TK_WITH, "End With")) {
+        return false;
+    }
+
+    pushStatement(blockItemNodes, makeCompoundStatement(body));
+    return true;
+}
+
+// ReDim [Preserve] a(upper)[, b(upper)]: a statement per array, each the array called with its new bounds
+bool makeRedimStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    (*index)++;
+
+    const bool isPreserve = acceptTokenWord(vectorList, index, "Preserve");
+
+    do {
+        ParsedExpression array = parsePostfixExpression(vectorList, index, true);
+
+        if (array.node == NULL || peekType(vectorList, *index) != TK_LEFT_PARENTHESIS) {
+            if (array.node != NULL) {
+                reportSyntaxError(vectorList, *index, "expected the array's bounds");
+            }
+
+            return false;
+        }
+
+        PostfixExpressionNode *postfixExpressionNode = allocateNode(sizeof(PostfixExpressionNode));
+        postfixExpressionNode->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+        postfixExpressionNode->postfixExpressionNode = lowerExpression(array, LEVEL_POSTFIX);
+        int lowerBound = 0;
+        postfixExpressionNode->assignExpressionNodes = parseArguments(vectorList, index, true, &lowerBound);
+
+        if (postfixExpressionNode->assignExpressionNodes == NULL || (acceptToken(vectorList, index, TK_AS) && makeTypeSpecifierNode(vectorList, index) == NULL)) {
+            return false;
+        }
+
+        StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+        statementNode->redimStatementNode = allocateNode(sizeof(RedimStatementNode));
+        statementNode->redimStatementNode->isPreserve = isPreserve;
+        statementNode->redimStatementNode->lowerBound = lowerBound;
+        statementNode->redimStatementNode->postfixExpressionNode = postfixExpressionNode;
+        pushStatement(blockItemNodes, statementNode);
+    } while (acceptToken(vectorList, index, TK_COMMA));
+
+    return true;
+}
+
+// On x GoTo a, b, ... and On x GoSub jump to the x-th label, as an else-if chain testing x = 1, x = 2 and so
+// on, and so only take a variable or member; an x matching no label goes on to the next statement, as in VB
+bool makeComputedJump(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const int start = *index;
+    ParsedExpression selector = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+    const int type = peekType(vectorList, *index);
+
+    if (selector.node == NULL) {
+        return false;
+    }
+
+    if (type != TK_GO_TO && type != TK_GO_SUB) {
+        reportSyntaxError(vectorList, *index, "expected 'GoTo' or 'GoSub'");
+        return false;
+    }
+
+    if (!isPlainSelector(selector)) {
+        reportUnsupported(vectorList, start, "On ... %s needs a variable as its selector; the statement is left out", (type == TK_GO_TO) ? "GoTo" : "GoSub");
+        return false;
+    }
+
+    StatementNode *first = NULL;
+    SelectionStatementNode *last = NULL;
+
+    (*index)++;
+
+    for (int value = 1; first == NULL || acceptToken(vectorList, index, TK_COMMA); value++) {
+        const Token *token = peekToken(vectorList, *index);
+        const char *label = (token != NULL) ? getLabelName(token) : NULL;
+
+        if (label == NULL) {
+            reportSyntaxError(vectorList, *index, "expected a label");
+            return false;
+        }
+
+        CompoundStatementNode *thenNode = allocateNode(sizeof(CompoundStatementNode));
+        thenNode->blockItemNodes = buildNodeVector();
+        pushStatement(thenNode->blockItemNodes, makeJumpStatement((type == TK_GO_TO) ? JUMP_GOTO : JUMP_GOSUB, label));
+
+        const ParsedExpression test = makeBinaryExpression(LEVEL_EQUAL, COMPARE_EQUAL, selector, makeConstantExpression(CONSTANT_SI32, value));
+        StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+        statementNode->selectionStatementNode = makeIfNode(liftExpression(test, LEVEL_EXPRESSION), thenNode);
+
+        if (last == NULL) {
+            first = statementNode;
+        }
+        else {
+            last->selectionType = SELECTION_IF_ELSE;
+            last->statementNode2 = statementNode;
+        }
+
+        last = statementNode->selectionStatementNode;
+        (*index)++;
+    }
+
+    pushStatement(blockItemNodes, first);
+    return true;
+}
+
+// On Error GoTo label | 0, On Error Resume Next, or a computed On x GoTo
+bool makeOnStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    (*index)++;
+    acceptTokenWord(vectorList, index, "Local");
+
+    if (!acceptToken(vectorList, index, TK_ERROR)) {
+        return makeComputedJump(vectorList, index, blockItemNodes);
+    }
+
+    if (acceptToken(vectorList, index, TK_RESUME)) {
+        if (!expectToken(vectorList, index, TK_NEXT, "Next")) {
+            return false;
+        }
+
+        pushStatement(blockItemNodes, makeJumpStatement(JUMP_ON_ERROR_RESUME_NEXT, NULL));
+        return true;
+    }
+
+    if (!expectToken(vectorList, index, TK_GO_TO, "GoTo")) {
+        return false;
+    }
+
+    const Token *token = peekToken(vectorList, *index);
+    const char *label = (token != NULL && token->type == TK_NUMBER && token->num == 0) ? "0" : (token != NULL) ? getLabelName(token) : NULL;
+
+    if (label == NULL) {
+        reportSyntaxError(vectorList, *index, "expected a label");
+        return false;
+    }
+
+    (*index)++;
+    pushStatement(blockItemNodes, makeJumpStatement(JUMP_ON_ERROR_GOTO, label));
+    return true;
+}
+
+// GoTo, GoSub and Resume take a label; Resume alone retries and Resume Next goes on after the failure
+bool makeJumpStatementNodes(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const int type = peekType(vectorList, (*index)++);
+
+    if (type == TK_RESUME && (isStatementEnd(vectorList, *index) || acceptToken(vectorList, index, TK_NEXT))) {
+        pushStatement(blockItemNodes, makeJumpStatement((peekType(vectorList, *index - 1) == TK_NEXT) ? JUMP_RESUME_NEXT : JUMP_RESUME, NULL));
+        return true;
+    }
+
+    const Token *token = peekToken(vectorList, *index);
+    const char *label = (token != NULL && type == TK_RESUME && token->type == TK_NUMBER && token->num == 0) ? "0" : (token != NULL) ? getLabelName(token) : NULL;
+
+    if (label == NULL) {
+        reportSyntaxError(vectorList, *index, "expected a label");
+        return false;
+    }
+
+    (*index)++;
+    pushStatement(blockItemNodes, makeJumpStatement((type == TK_GO_TO) ? JUMP_GOTO : (type == TK_GO_SUB) ? JUMP_GOSUB : JUMP_RESUME, label));
+    return true;
+}
+
+// Exit Sub, Function and Property return; Exit For and Exit Do leave the loop
+bool makeExitStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const int type = peekType(vectorList, ++*index);
+
+    switch (type) {
+        case TK_SUB:
+        case TK_FUNCTION:
+        case TK_PROPERTY: {
+            pushStatement(blockItemNodes, makeJumpStatement(JUMP_RETURN, NULL));
+            break;
+        }
+        case TK_FOR:
+        case TK_DO: {
+            pushStatement(blockItemNodes, makeJumpStatement((type == TK_FOR) ? JUMP_EXIT_FOR : JUMP_EXIT_DO, NULL));
+            break;
+        }
+        default: {
+            reportSyntaxError(vectorList, *index, "expected Sub, Function, Property, For or Do after 'Exit'");
+            return false;
+        }
+    }
+
+    (*index)++;
+    return true;
+}
+
+// name(arguments) as a statement; a name or member alone is called with no arguments
+StatementNode *makeCallStatement(ParsedExpression callee) {
+    const PostfixExpressionNode *postfixExpressionNode = (callee.level == LEVEL_POSTFIX) ? callee.node : NULL;
+
+    if (postfixExpressionNode == NULL || postfixExpressionNode->postfixExpressionType != POSTFIX_LEFT_PARENTHESIS) {
+        PostfixExpressionNode *call = allocateNode(sizeof(PostfixExpressionNode));
+        call->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+        call->postfixExpressionNode = lowerExpression(callee, LEVEL_POSTFIX);
+        call->assignExpressionNodes = buildNodeVector();
+        callee = (ParsedExpression){ LEVEL_POSTFIX, call };
+    }
+
+    return makeExpressionStatement(callee);
+}
+
+// "x = value", "Foo(a)" or "Foo a, b": the target is read as a name first, and the line is read again as a
+// call with unparenthesized arguments when neither = nor the end of the statement follows it
+bool makeAssignmentOrCall(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const int start = *index;
+    ParsedExpression target = parsePostfixExpression(vectorList, index, false);
+
+    if (target.node == NULL) {
+        return false;
+    }
+
+    if (acceptToken(vectorList, index, TK_ASSIGNMENT)) {
+        ParsedExpression value = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+        if (value.node == NULL) {
+            return false;
+        }
+
+        pushStatement(blockItemNodes, makeExpressionStatement(makeAssignmentExpression(target, OPERATOR_ASSIGN, value)));
+        return true;
+    }
+
+    if (isStatementEnd(vectorList, *index) || peekType(vectorList, *index) == TK_ELSE) {
+        pushStatement(blockItemNodes, makeCallStatement(target));
+        return true;
+    }
+
+    *index = start;
+    target = parsePostfixExpression(vectorList, index, true);
+
+    PostfixExpressionNode *call = allocateNode(sizeof(PostfixExpressionNode));
+    call->postfixExpressionType = POSTFIX_LEFT_PARENTHESIS;
+    call->postfixExpressionNode = lowerExpression(target, LEVEL_POSTFIX);
+    call->assignExpressionNodes = buildNodeVector();
+
+    // Print-style lists separate with ; as well
+    do {
+        if (isNamedArgument(vectorList, *index)) {
+            reportUnsupported(vectorList, *index, "named arguments have no lowering; the statement is left out");
+            return false;
+        }
+
+        ParsedExpression argument = (peekType(vectorList, *index) == TK_COMMA) ? makeIdentifierExpression("default") : parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+        if (argument.node == NULL) {
+            return false;
+        }
+
+        pushVector(call->assignExpressionNodes, lowerExpression(argument, LEVEL_ASSIGNMENT));
+    } while (acceptToken(vectorList, index, TK_COMMA) || acceptToken(vectorList, index, TK_SEMI_COLON));
 
-    while (isDeclarationSpecifier(vectorList, *index)) {
-        DeclarationSpecifierNode *declarationSpecifierNode = makeDeclarationSpecifierNode(vectorList, index);
+    pushStatement(blockItemNodes, makeExpressionStatement((ParsedExpression){ LEVEL_POSTFIX, call }));
+    return true;
+}
 
-        if (declarationSpecifierNode == NULL) {
-            printf("error: could not create declaration-specifier-type node.\n");
-            return NULL;
-        }
-        
-        pushVector(functionDefinitionNode->declarationSpecifierNodes, declarationSpecifierNode);
+// the file statements VB reads as keywords, whose file numbers take a #: Open and Close anywhere, the others
+// only with the #
+bool isFileStatement(const Vector *vectorList, int index) {
+    static const char *const statements[] = { "Print", "Write", "Input", "Put", "Seek", "Lock", "Unlock" };
+    const int next = peekType(vectorList, index + 1);
+
+    if (next == TK_ASSIGNMENT || next == TK_DOT) {
+        return false;
     }
 
-    functionDefinitionNode->declaratorNode = makeDeclaratorNode(vectorList, index);
+    if (isTokenWord(vectorList, index, "Open")) {
+        for (int i = index + 1; !isLineEnd(vectorList, i); i++) {
+            if (peekType(vectorList, i) == TK_FOR) {
+                return true;
+            }
+        }
 
-    if (functionDefinitionNode->declaratorNode == NULL) {
-        printf("error: could not create declarator-type node.\n");
-        return NULL;
+        return false;
     }
 
-    functionDefinitionNode->compoundStatementNode = makeCompoundStatementNode(vectorList, index);
+    if (isTokenWord(vectorList, index, "Close") || (isTokenWord(vectorList, index, "Line") && isTokenWord(vectorList, index + 1, "Input"))) {
+        return true;
+    }
 
-    if (functionDefinitionNode->compoundStatementNode == NULL) {
-        printf("error: could not create compound-statement-type node\n");
-        return NULL;
+    for (size_t i = 0; next == TK_POUND && i < sizeof(statements) / sizeof(statements[0]); i++) {
+        if (isTokenWord(vectorList, index, statements[i])) {
+            return true;
+        }
     }
 
-    return functionDefinitionNode;
+    return next == TK_POUND && peekType(vectorList, index) == TK_GET;
+}
+
+// a file number, with or without its #
+ParsedExpression parseFileNumber(const Vector *vectorList, int *index) {
+    acceptToken(vectorList, index, TK_POUND);
+    return parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
 }
 
-bool isFunctionDefinition(const Vector *vectorList, int index) {
-    const Token *token = vectorList->contents[index];
+// Open path For mode [Access a] [Shared | Lock l] As #n [Len = r] is FileOpen, passing the access, sharing
+// and record length only as far as the statement gives them
+bool makeOpenStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    static const char *const modes[] = { "Input", "Output", "Append", "Binary", "Random" };
+    char mode[32], access[32], share[32];
+    int argumentCount = 3;
 
-    while (!(token->type == TK_IDENTIFIER && !stringMapContains(classMap, token->string))) {
-        token = vectorList->contents[++index];
+    (*index)++;
+
+    ParsedExpression path = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+    if (path.node == NULL || !expectToken(vectorList, index, TK_FOR, "For")) {
+        return false;
     }
 
-    token = vectorList->contents[++index];
+    mode[0] = '\0';
 
-    if (token->type != TK_LEFT_PARENTHESIS) {
+    for (size_t i = 0; mode[0] == '\0' && i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (acceptTokenWord(vectorList, index, modes[i])) {
+            snprintf(mode, sizeof(mode), "OpenMode.%s", modes[i]);
+        }
+    }
+
+    if (mode[0] == '\0') {
+        reportSyntaxError(vectorList, *index, "expected Input, Output, Append, Binary or Random");
         return false;
     }
 
-    while (token->type != TK_RIGHT_PARENTHESIS) {
-        token = vectorList->contents[++index];
+    snprintf(access, sizeof(access), "OpenAccess.Default");
+    snprintf(share, sizeof(share), "OpenShare.Default");
+
+    if (acceptTokenWord(vectorList, index, "Access")) {
+        const bool isRead = acceptTokenWord(vectorList, index, "Read");
+        const bool isWrite = acceptTokenWord(vectorList, index, "Write");
+
+        if (!isRead && !isWrite) {
+            reportSyntaxError(vectorList, *index, "expected Read or Write");
+            return false;
+        }
+
+        snprintf(access, sizeof(access), "OpenAccess.%s", (isRead && isWrite) ? "ReadWrite" : isRead ? "Read" : "Write");
+        argumentCount = 4;
+    }
+
+    if (acceptTokenWord(vectorList, index, "Shared")) {
+        snprintf(share, sizeof(share), "OpenShare.Shared");
+        argumentCount = 5;
     }
+    else if (acceptTokenWord(vectorList, index, "Lock")) {
+        const bool isRead = acceptTokenWord(vectorList, index, "Read");
+        const bool isWrite = acceptTokenWord(vectorList, index, "Write");
 
-    token = vectorList->contents[++index];
-    return (token->type == TK_LEFT_PARENTHESIS);
-}
+        if (!isRead && !isWrite) {
+            reportSyntaxError(vectorList, *index, "expected Read or Write");
+            return false;
+        }
 
-bool isFunctionDeclaration(const Vector *vectorList, int index) {
-    const Token *token = vectorList->contents[index];
+        snprintf(share, sizeof(share), "OpenShare.%s", (isRead && isWrite) ? "LockReadWrite" : isRead ? "LockRead" : "LockWrite");
+        argumentCount = 5;
+    }
 
-    while (!(token->type == TK_IDENTIFIER && !stringMapContains(classMap, token->string))) {
-        token = vectorList->contents[++index];
+    if (!expectToken(vectorList, index, TK_AS, "As")) {
+        return false;
     }
 
-    token = vectorList->contents[++index];
+    ParsedExpression number = parseFileNumber(vectorList, index);
+    ParsedExpression length = { 0, NULL };
 
-    if (token->type != TK_LEFT_PARENTHESIS) {
+    if (number.node == NULL) {
         return false;
     }
 
-    while (token->type != TK_RIGHT_PARENTHESIS) {
-        token = vectorList->contents[++index];
+    if (acceptTokenWord(vectorList, index, "Len")) {
+        if (!expectToken(vectorList, index, TK_ASSIGNMENT, "=") || (length = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP)).node == NULL) {
+            return false;
+        }
+
+        argumentCount = 6;
     }
 
-    token = vectorList->contents[++index];
-    return (token->type == TK_NEWLINE);
+    pushStatement(blockItemNodes, makeExpressionStatement(makeCallExpression("FileOpen", argumentCount, number, path, makeIdentifierExpression(mode),
+        makeIdentifierExpression(access), makeIdentifierExpression(share), length)));
+    return true;
 }
 
-bool isTypeSpecifier(const Vector *vectorList, int index) {
-    const Token *token   = vectorList->contents[index];
-    const Token *token2  = vectorList->contents[index + 1];
-    const int type       = token->type;
-    const int type2      = token2->type;
+// Print #n, a; b, c runs a and b together and puts c in the next print zone, as Print and PrintLine do with
+// an argument per zone; Write #n separates every item, as Write and WriteLine do. A trailing ; or , leaves the
+// line open, which is Print or Write rather than PrintLine or WriteLine.
+bool makeOutputStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const bool isPrint = isTokenWord(vectorList, (*index)++, "Print");
+    ParsedExpression number = parseFileNumber(vectorList, index);
+    ParsedExpression item = { 0, NULL };
+    bool isOpen = false;
+
+    if (number.node == NULL || (!isStatementEnd(vectorList, *index) && !expectToken(vectorList, index, TK_COMMA, ","))) {
+        return false;
+    }
+
+    Vector *arguments = buildNodeVector();
+    pushVector(arguments, lowerExpression(number, LEVEL_ASSIGNMENT));
+
+    while (!isStatementEnd(vectorList, *index) && peekType(vectorList, *index) != TK_ELSE) {
+        const int type = peekType(vectorList, *index);
+
+        if (type == TK_COMMA || type == TK_SEMI_COLON) {
+            (*index)++;
+
+            // Print's , ends a zone, an empty one included
+            if (type == TK_COMMA && isPrint) {
+                pushVector(arguments, lowerExpression((item.node != NULL) ? item : makeStringExpression(""), LEVEL_ASSIGNMENT));
+                item = (ParsedExpression){ 0, NULL };
+            }
+
+            isOpen = true;
+            continue;
+        }
+
+        ParsedExpression value = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+        if (value.node == NULL) {
+            return false;
+        }
+
+        if (!isPrint) {
+            pushVector(arguments, lowerExpression(value, LEVEL_ASSIGNMENT));
+        }
+        else {
+            item = (item.node != NULL) ? makeBinaryExpression(LEVEL_SHIFT, OPERATOR_CONCAT, item, value) : value;
+        }
+
+        isOpen = false;
+    }
 
-    return(type == TK_DIM || type2 == TK_AS);
+    if (item.node != NULL) {
+        pushVector(arguments, lowerExpression(item, LEVEL_ASSIGNMENT));
+    }
+
+    const char *function = isPrint ? (isOpen ? "Print" : "PrintLine") : (isOpen ? "Write" : "WriteLine");
+    pushStatement(blockItemNodes, makeExpressionStatement(makeArgumentCall(function, arguments)));
+    return true;
 }
 
-bool isDeclarationSpecifier(const Vector* vectorList, int index) {
-    const Token* token = vectorList->contents[index];
-    const int type = token->type;
+// The rest of the file statements, as the runtime's FileSystem functions: Close #a, #b is FileClose(a, b),
+// Line Input #n, v is v = LineInput(n), Seek, Lock and Unlock keep their arguments, and Put #n, r, v is
+// FilePut(n, v, r). Input # and Get # fill variables by reference, which has no lowering here.
+bool makeFileStatement(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const int start = *index;
+
+    if (isTokenWord(vectorList, start, "Open")) {
+        return makeOpenStatement(vectorList, index, blockItemNodes);
+    }
+
+    if (isTokenWord(vectorList, start, "Print") || isTokenWord(vectorList, start, "Write")) {
+        return makeOutputStatement(vectorList, index, blockItemNodes);
+    }
+
+    if (isTokenWord(vectorList, start, "Input") || peekType(vectorList, start) == TK_GET) {
+        reportUnsupported(vectorList, start, "%s # reads into its variables by reference, which has no lowering; the statement is left out",
+            (peekType(vectorList, start) == TK_GET) ? "Get" : "Input");
+        return false;
+    }
+
+    if (isTokenWord(vectorList, start, "Line")) {
+        *index += 2;
+        ParsedExpression number = parseFileNumber(vectorList, index);
+        ParsedExpression target = { 0, NULL };
+
+        if (number.node == NULL || !expectToken(vectorList, index, TK_COMMA, ",") || (target = parsePostfixExpression(vectorList, index, false)).node == NULL) {
+            return false;
+        }
+
+        pushStatement(blockItemNodes, makeExpressionStatement(makeAssignmentExpression(target, OPERATOR_ASSIGN, makeCallExpression("LineInput", 1, number))));
+        return true;
+    }
+
+    static const char *const functions[][2] = { { "Close", "FileClose" }, { "Put", "FilePut" }, { "Seek", "Seek" }, { "Lock", "Lock" }, { "Unlock", "Unlock" } };
+    const char *function = NULL;
+    Vector *arguments = buildNodeVector();
+
+    for (size_t i = 0; function == NULL && i < sizeof(functions) / sizeof(functions[0]); i++) {
+        function = isTokenWord(vectorList, start, functions[i][0]) ? functions[i][1] : NULL;
+    }
+
+    const bool isPut = (strcmp(function, "FilePut") == 0);
+    const bool isClose = (strcmp(function, "FileClose") == 0);
+
+    (*index)++;
+
+    // Close takes any number of files, and the others a file and then their own arguments; Put's record may be
+    // left out, and FilePut's is then its default
+    while (!isStatementEnd(vectorList, *index) && peekType(vectorList, *index) != TK_ELSE) {
+        const bool isNumber = (isClose || arguments->size == 0);
+
+        if (!isNumber && acceptToken(vectorList, index, TK_COMMA)) {
+            continue;
+        }
+
+        ParsedExpression argument = isNumber ? parseFileNumber(vectorList, index) : parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+        if (argument.node == NULL) {
+            return false;
+        }
+
+        pushVector(arguments, lowerExpression(argument, LEVEL_ASSIGNMENT));
+
+        // a record range, Lock #n, a To b, is two arguments
+        if (acceptToken(vectorList, index, TK_TO)) {
+            ParsedExpression last = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
 
-    return(isTypeSpecifier(vectorList, index) || type == TK_CONST);
+            if (last.node == NULL) {
+                return false;
+            }
+
+            pushVector(arguments, lowerExpression(last, LEVEL_ASSIGNMENT));
+        }
+
+        if (!isStatementEnd(vectorList, *index) && peekType(vectorList, *index) != TK_ELSE && !expectToken(vectorList, index, TK_COMMA, ",")) {
+            return false;
+        }
+    }
+
+    // Put's record comes before its value, where FilePut takes the value first
+    if (isPut && arguments->size == 3) {
+        void *record = arguments->contents[1];
+        arguments->contents[1] = arguments->contents[2];
+        arguments->contents[2] = record;
+    }
+
+    pushStatement(blockItemNodes, makeExpressionStatement(makeArgumentCall(function, arguments)));
+    return true;
 }
 
-DeclarationNode *makeDeclarationNode(const Vector *vectorList, int *index) {
-    DeclarationNode *declarationNode = malloc(sizeof(DeclarationNode));
-    declarationNode->declarationSpecifierNodes = buildVectorList();
-    declarationNode->initializeDeclaratorNodes = buildVectorList();
+// One statement, or a label and the statement after it, appended to blockItemNodes. Declarations are block
+// items of their own, one per name; ReDim of several arrays is a statement per array.
+bool makeStatementNodes(const Vector *vectorList, int *index, Vector *blockItemNodes) {
+    const Token *token = peekToken(vectorList, *index);
 
-    const Token* token = vectorList->contents[*index];
+    // a label is a name or line number starting the line, and is a statement of its own
+    if (isLineStart(vectorList, *index) && (token->type == TK_NUMBER || (token->type == TK_IDENTIFIER && peekType(vectorList, *index + 1) == TK_COLON && peekType(vectorList, *index + 2) != TK_ASSIGNMENT))) {
+        StatementNode *statementNode = allocateNode(sizeof(StatementNode));
+        statementNode->labeledStatementNode = allocateNode(sizeof(LabelStatementNode));
+        statementNode->labeledStatementNode->labeledStatementType = LABEL_NAMED;
+        statementNode->labeledStatementNode->identifier = copyNodeString(getLabelName(token));
+        pushStatement(blockItemNodes, statementNode);
 
-    while (isDeclarationSpecifier(vectorList, *index) && token->type != TK_NEWLINE) {
-        DeclarationSpecifierNode* declarationSpecifierNode = makeDeclarationSpecifierNode(vectorList, index);
+        (*index)++;
+        acceptToken(vectorList, index, TK_COLON);
+        return isStatementEnd(vectorList, *index) || makeStatementNodes(vectorList, index, blockItemNodes);
+    }
 
-        if (declarationSpecifierNode == NULL) {
-            printf("error: could not create declaration-specifier-type node.\n");
-            return NULL;
+    switch (token->type) {
+        case TK_DIM:
+        case TK_STATIC:
+        case TK_PRIVATE:
+        case TK_PUBLIC:
+        case TK_CONST: {
+            Vector *declarationNodes = buildNodeVector();
+            const bool isConstant = (token->type == TK_CONST);
+
+            (*index)++;
+
+            if (!makeDeclarationNodes(vectorList, index, isConstant || acceptToken(vectorList, index, TK_CONST), declarationNodes)) {
+                return false;
+            }
+
+            for (int i = 0; i < declarationNodes->size; i++) {
+                BlockItemNode *blockItemNode = allocateNode(sizeof(BlockItemNode));
+                blockItemNode->declarationNode = declarationNodes->contents[i];
+                pushVector(blockItemNodes, blockItemNode);
+            }
+
+            return true;
+        }
+        case TK_REDIM: {
+            return makeRedimStatement(vectorList, index, blockItemNodes);
         }
+        case TK_IF: {
+            return makeIfStatement(vectorList, index, blockItemNodes);
+        }
+        case TK_SELECT: {
+            return makeSelectStatement(vectorList, index, blockItemNodes);
+        }
+        case TK_FOR: {
+            return makeForStatement(vectorList, index, blockItemNodes);
+        }
+        case TK_DO:
+        case TK_WHILE: {
+            return makeDoStatement(vectorList, index, blockItemNodes);
+        }
+        case TK_WITH: {
+            return makeWithStatement(vectorList, index, blockItemNodes);
+        }
+        case TK_EXIT: {
+            return makeExitStatement(vectorList, index, blockItemNodes);
+        }
+        case TK_ON: {
+            return makeOnStatement(vectorList, index, blockItemNodes);
+        }
+        case TK_GO_TO:
+        case TK_GO_SUB:
+        case TK_RESUME: {
+            return makeJumpStatementNodes(vectorList, index, blockItemNodes);
+        }
+        case TK_RETURN: {
+            (*index)++;
+            pushStatement(blockItemNodes, makeJumpStatement(JUMP_GOSUB_RETURN, NULL));
+            return true;
+        }
+        case TK_STOP: {
+            (*index)++;
+            pushStatement(blockItemNodes, makeJumpStatement(JUMP_STOP, NULL));
+            return true;
+        }
+        case TK_END: {
+            // End on its own ends the program
+            (*index)++;
+            pushStatement(blockItemNodes, makeExpressionStatement(makeCallExpression("Environment.Exit", 1, makeConstantExpression(CONSTANT_SI32, 0))));
+            return true;
+        }
+        case TK_CALL:
+        case TK_RAISE_EVENT: {
+            (*index)++;
+            ParsedExpression callee = parsePostfixExpression(vectorList, index, false);
+
+            if (callee.node == NULL) {
+                return false;
+            }
+
+            pushStatement(blockItemNodes, makeCallStatement(callee));
+            return true;
+        }
+        case TK_ERASE: {
+            do {
+                (*index)++;
+                ParsedExpression array = parsePostfixExpression(vectorList, index, false);
+
+                if (array.node == NULL) {
+                    return false;
+                }
+
+                pushStatement(blockItemNodes, makeExpressionStatement(makeCallExpression("Array.Clear", 1, array)));
+            } while (peekType(vectorList, *index) == TK_COMMA);
+
+            return true;
+        }
+        case TK_ERROR: {
+            // the Error statement raises as Err.Raise does
+            (*index)++;
+            ParsedExpression number = parseBinaryExpression(vectorList, index, PRECEDENCE_IMP);
+
+            if (number.node == NULL) {
+                return false;
+            }
+
+            pushStatement(blockItemNodes, makeExpressionStatement(makeCallExpression("Err.Raise", 1, number)));
+            return true;
+        }
+        case TK_SET:
+        case TK_LET: {
+            (*index)++;
+            return makeAssignmentOrCall(vectorList, index, blockItemNodes);
+        }
+        case TK_IDENTIFIER: {
+            if (isTokenWord(vectorList, *index, "Attribute")) {
+                while (!isLineEnd(vectorList, *index)) {
+                    (*index)++;
+                }
+
+                return true;
+            }
+
+            if (isFileStatement(vectorList, *index)) {
+                return makeFileStatement(vectorList, index, blockItemNodes);
+            }
+
+            return makeAssignmentOrCall(vectorList, index, blockItemNodes);
+        }
+        case TK_DOT:
+        case TK_EXCLAMATION:
+        case TK_ME:
+        case TK_STRING:
+        case TK_DATE: {
+            return makeAssignmentOrCall(vectorList, index, blockItemNodes);
+        }
+        case TK_GET: {
+            if (isFileStatement(vectorList, *index)) {
+                return makeFileStatement(vectorList, index, blockItemNodes);
+            }
+
+            reportSyntaxError(vectorList, *index, "unsupported statement");
+            return false;
+        }
+        default: {
+            reportSyntaxError(vectorList, *index, "unsupported statement");
+            return false;
+        }
+    }
+}
 
-        pushVector(declarationNode->declarationSpecifierNodes, declarationSpecifierNode);
+// Sub, Function and Property Get, Let and Set, with the modifiers already read. A Function or Property Get
+// without an As clause returns a Variant; a Sub, Let or Set has no type and so is void.
+FunctionDefinitionNode *makeFunctionDefinitionNode(const Vector *vectorList, int *index) {
+    const int kind = peekType(vectorList, (*index)++);
+    const int accessor = (kind == TK_PROPERTY) ? peekType(vectorList, (*index)++) : -1;
+    const bool hasResult = (kind == TK_FUNCTION || accessor == TK_GET);
+    const Token *token = peekToken(vectorList, *index);
+
+    if (kind == TK_PROPERTY && accessor != TK_GET && accessor != TK_LET && accessor != TK_SET) {
+        reportSyntaxError(vectorList, *index - 1, "expected Get, Let or Set after 'Property'");
+        return NULL;
+    }
+
+    if (token == NULL || token->type != TK_IDENTIFIER) {
+        reportSyntaxError(vectorList, *index, "expected a procedure name");
+        return NULL;
     }
 
-    token = vectorList->contents[*index];
+    FunctionDefinitionNode *functionDefinitionNode = allocateNode(sizeof(FunctionDefinitionNode));
+    DirectDeclaratorNode *nameNode = allocateNode(sizeof(DirectDeclaratorNode));
+    DirectDeclaratorNode *directDeclaratorNode = allocateNode(sizeof(DirectDeclaratorNode));
+
+    nameNode->identifier = copyNodeString(token->string);
+    functionDefinitionNode->accessor = (kind == TK_PROPERTY) ? accessor : 0;
+    directDeclaratorNode->directDeclaratorNode = nameNode;
+    functionDefinitionNode->declaratorNode = allocateNode(sizeof(DeclaratorNode));
+    functionDefinitionNode->declaratorNode->directDeclaratorNode = directDeclaratorNode;
+    functionDefinitionNode->declarationSpecifierNodes = buildNodeVector();
+    (*index)++;
+
+    if ((directDeclaratorNode->parameterTypeListNode = makeParameterTypeListNode(vectorList, index)) == NULL) {
+        return NULL;
+    }
 
-    while (token->type != TK_NEWLINE) {
-        InitializeDeclaratorNode* initializeDeclaratorNode = makeInitializingDeclaratorNode(vectorList, index);
+    if (hasResult) {
+        DeclarationSpecifierNode *declarationSpecifierNode = allocateNode(sizeof(DeclarationSpecifierNode));
 
-        if (initializeDeclaratorNode == NULL) {
-            printf("error: could not create initialize-declarator-type node.\n");
+        if (!acceptToken(vectorList, index, TK_AS)) {
+            declarationSpecifierNode->typeSpecifierNode = makeTypeSpecifier(TYPE_VARIANT, NULL);
+        }
+        else if ((declarationSpecifierNode->typeSpecifierNode = makeTypeSpecifierNode(vectorList, index)) == NULL) {
             return NULL;
         }
+        else if (acceptToken(vectorList, index, TK_LEFT_PARENTHESIS) && !expectToken(vectorList, index, TK_RIGHT_PARENTHESIS, ")")) {
+            return NULL;
+        }
+
+        pushVector(functionDefinitionNode->declarationSpecifierNodes, declarationSpecifierNode);
+    }
 
-        pushVector(declarationNode->initializeDeclaratorNodes, initializeDeclaratorNode);
+    if (!isStatementEnd(vectorList, *index)) {
+        reportSyntaxError(vectorList, *index, "expected the end of the statement");
+        return NULL;
+    }
 
-        token = vectorList->contents[*index];
+    functionDefinitionNode->compoundStatementNode = makeCompoundStatementNode(vectorList, index);
 
-        if (token->type == TK_COMMA) {
-            token = vectorList->contents[++*index];
-        } 
+    if (functionDefinitionNode->compoundStatementNode == NULL
+        || !acceptBlockEnd(vectorList, index, kind, (kind == TK_SUB) ? "End Sub" : (kind == TK_FUNCTION) ? "End Function" : "End Property")) {
+        return NULL;
     }
 
-    (*index)++;
-    return declarationNode;
+    return functionDefinitionNode;
+}
+
+// file-local names first, then classes, UDTs and Enums from the shared project index and referenced libraries
+bool isTypeName(const char *name) {
+    if (stringMapContains(classMap, name)) {
+        return true;
+    }
+
+    if (symbolIndex == NULL) {
+        return false;
+    }
+
+    for (const IndexedSymbol *symbol = findSymbol(symbolIndex, name); symbol != NULL; symbol = getNextSymbol(symbolIndex, symbol)) {
+        if (isTypeSymbol(symbol)) {
+            return true;
+        }
+    }
+
+    return (findReferencedType(symbolIndex, name, NULL) != NULL);
 }
 
-ExternalDeclarationNode *makeExternalDeclarationNode(const Vector *vectorList, int *index) {
-    ExternalDeclarationNode *externalDeclarationNode = calloc(1, sizeof(ExternalDeclarationNode));
-    const Token *token = vectorList->contents[*index];
+// the name of the procedure a module-level line starts, for tracing: the first identifier that is not a type
+const char *findProcedureName(const Vector *vectorList, int index) {
+    for (; index < vectorList->size; index++) {
+        const Token *token = vectorList->contents[index];
+
+        if (token->type == TK_IDENTIFIER && !isTypeName(token->string)) {
+            return token->string;
+        }
+    }
 
-    if (isFunctionDefinition(vectorList, *index)) {
-        externalDeclarationNode->functionDefinitionNode = makeFunctionDefinitionNode(vectorList, index);
+    return "";
+}
 
-        if (externalDeclarationNode->functionDefinitionNode == NULL) {
-            printf("error: could not create function-definition-type node.\n");
+const DirectDeclaratorNode *getNamedDirectDeclarator(const DirectDeclaratorNode *directDeclaratorNode) {
+    while (directDeclaratorNode != NULL && directDeclaratorNode->identifier == NULL) {
+        if (directDeclaratorNode->directDeclaratorNode != NULL) {
+            directDeclaratorNode = directDeclaratorNode->directDeclaratorNode;
+        }
+        else if (directDeclaratorNode->declaratorNode != NULL) {
+            directDeclaratorNode = directDeclaratorNode->declaratorNode->directDeclaratorNode;
+        }
+        else {
             return NULL;
         }
     }
-    else if (isFunctionDeclaration(vectorList, *index)) {
-        token = vectorList->contents[*index];
-        printf("%s\n", token->string);
 
-        while (token->type != TK_NEWLINE) {
-            token = vectorList->contents[++*index];
+    return directDeclaratorNode;
+}
+
+const char *getDeclaratorName(const DeclaratorNode *declaratorNode) {
+    const DirectDeclaratorNode *directDeclaratorNode = getNamedDirectDeclarator(declaratorNode->directDeclaratorNode);
+    return (directDeclaratorNode != NULL) ? directDeclaratorNode->identifier : "_";
+}
+
+const ParameterTypeListNode *getParameterTypeList(const DeclaratorNode *declaratorNode) {
+    for (const DirectDeclaratorNode *directDeclaratorNode = declaratorNode->directDeclaratorNode; directDeclaratorNode != NULL; directDeclaratorNode = directDeclaratorNode->directDeclaratorNode) {
+        if (directDeclaratorNode->parameterTypeListNode != NULL) {
+            return directDeclaratorNode->parameterTypeListNode;
         }
+    }
 
-        (*index)++;
+    return NULL;
+}
+
+const TypeSpecifierNode *findTypeSpecifier(const Vector *declarationSpecifierNodes, bool *isConstant) {
+    const TypeSpecifierNode *typeSpecifierNode = NULL;
+    *isConstant = false;
+
+    for (int i = 0; declarationSpecifierNodes != NULL && i < declarationSpecifierNodes->size; i++) {
+        const DeclarationSpecifierNode *declarationSpecifierNode = declarationSpecifierNodes->contents[i];
+
+        if (declarationSpecifierNode->isConstant) {
+            *isConstant = true;
+        }
+
+        if (declarationSpecifierNode->typeSpecifierNode != NULL) {
+            typeSpecifierNode = declarationSpecifierNode->typeSpecifierNode;
+        }
+    }
+
+    return typeSpecifierNode;
+}
+
+long getTokenOffset(const Vector *vectorList, int index) {
+    if (index < 0 || index >= vectorList->size) {
+        return -1;
+    }
+
+    return ((const Token*)vectorList->contents[index])->offset;
+}
+
+// next token of a lookahead scan; NULL at the end of the file or once the file is over budget
+const Token *readLookahead(const Vector *vectorList, int *index) {
+    if (++*index >= vectorList->size || isOverBudget()) {
+        return NULL;
+    }
+
+    return vectorList->contents[*index];
+}
+
+// DefInt A-Z and the like only set default types, which every declaration here states or leaves Variant
+bool isDefaultTypeStatement(const Vector *vectorList, int index) {
+    static const char *const statements[] = { "DefBool", "DefByte", "DefInt", "DefLng", "DefCur", "DefSng", "DefDbl", "DefDec", "DefDate", "DefStr", "DefObj", "DefVar" };
+
+    for (size_t i = 0; i < sizeof(statements) / sizeof(statements[0]); i++) {
+        if (isTokenWord(vectorList, index, statements[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Type and Enum blocks only name a type here, through classMap, and are warned about as left out
+bool skipTypeBlock(const Vector *vectorList, int *index) {
+    const int start = *index;
+    const int kind = peekType(vectorList, (*index)++);
+    const Token *token = peekToken(vectorList, *index);
+
+    if (token == NULL || token->type != TK_IDENTIFIER) {
+        reportSyntaxError(vectorList, *index, "expected a type name");
+        return false;
+    }
+
+    if (kind == TK_ENUM) {
+        reportUnsupported(vectorList, start, "Enum %s is left out, so its members are not declared", token->string);
     }
     else {
-        externalDeclarationNode->declarationNode = makeDeclarationNode(vectorList, index);
+        reportUnsupported(vectorList, start, "Type %s is left out, so what is declared as it has no C# type", token->string);
+    }
 
-        if (externalDeclarationNode->declarationNode == NULL) {
-            printf("error: could not create declaration-definition-type node.\n");
-            return NULL;
+    if (!stringMapContains(classMap, token->string)) {
+        appendStringMap(classMap, token->string, NULL);
+    }
+
+    while (*index < vectorList->size) {
+        skipLine(vectorList, index);
+
+        if (peekType(vectorList, *index) == TK_END && ((kind == TK_ENUM) ? peekType(vectorList, *index + 1) == TK_ENUM : isTokenWord(vectorList, *index + 1, "Type"))) {
+            *index += 2;
+            return true;
         }
-    } 
+    }
+
+    reportSyntaxError(vectorList, *index, (kind == TK_ENUM) ? "expected 'End Enum'" : "expected 'End Type'");
+    return false;
+}
 
+ExternalDeclarationNode *makeExternalDeclarationNode(FunctionDefinitionNode *functionDefinitionNode, DeclarationNode *declarationNode) {
+    ExternalDeclarationNode *externalDeclarationNode = allocateNode(sizeof(ExternalDeclarationNode));
+    externalDeclarationNode->functionDefinitionNode = functionDefinitionNode;
+    externalDeclarationNode->declarationNode = declarationNode;
     return externalDeclarationNode;
 }
 
+// One module-level line or procedure. Attributes, options, Implements, Def types, Declare and Event lines
+// are dropped, a Declare with a warning; Type and Enum blocks are skipped once their names are noted; the rest
+// are declarations and procedures.
+bool makeExternalDeclarationNodes(const Vector *vectorList, int *index, Vector *externalDeclarationNodes) {
+    bool hasModifier = false;
+    bool isPrivate = false;
+
+    for (int modifier = peekType(vectorList, *index); modifier == TK_PUBLIC || modifier == TK_PRIVATE || modifier == TK_FRIEND
+        || modifier == TK_GLOBAL || modifier == TK_STATIC; modifier = peekType(vectorList, ++(*index))) {
+        isPrivate = isPrivate || modifier == TK_PRIVATE;
+        hasModifier = true;
+    }
+
+    const int type = peekType(vectorList, *index);
+
+    if (type == TK_OPTION && isTokenWord(vectorList, *index + 1, "Base") && peekType(vectorList, *index + 2) == TK_NUMBER) {
+        optionBase = ((const Token *)vectorList->contents[*index + 2])->num;
+    }
+
+    if (type == TK_DECLARE) {
+        const Token *token = peekToken(vectorList, *index + (isTokenWord(vectorList, *index + 1, "PtrSafe") ? 3 : 2));
+        reportUnsupported(vectorList, *index, "Declare %s is left out, so calls to it have no C# declaration", (token != NULL && token->type == TK_IDENTIFIER) ? token->string : "statement");
+    }
+
+    if (type == TK_OPTION || type == TK_IMPLEMENTS || type == TK_DECLARE || type == TK_EVENT || isTokenWord(vectorList, *index, "Attribute") || isDefaultTypeStatement(vectorList, *index)) {
+        while (!isLineEnd(vectorList, *index)) {
+            (*index)++;
+        }
+
+        return true;
+    }
+
+    if (type == TK_ENUM || isTokenWord(vectorList, *index, "Type")) {
+        return skipTypeBlock(vectorList, index);
+    }
+
+    if (type == TK_SUB || type == TK_FUNCTION || type == TK_PROPERTY) {
+        const long traceStart = beginTrace();
+        const char *procedureName = (traceStart != 0) ? findProcedureName(vectorList, *index) : NULL;
+        FunctionDefinitionNode *functionDefinitionNode = makeFunctionDefinitionNode(vectorList, index);
+
+        endTrace(traceStart, TRACE_PROCEDURE, getDiagnosticFile(), procedureName);
+
+        if (functionDefinitionNode == NULL) {
+            return false;
+        }
+
+        functionDefinitionNode->isPrivate = isPrivate;
+        pushVector(externalDeclarationNodes, makeExternalDeclarationNode(functionDefinitionNode, NULL));
+        return true;
+    }
+
+    if (type == TK_CONST || type == TK_DIM || (hasModifier && (type == TK_IDENTIFIER || type == TK_WITH_EVENTS))) {
+        Vector *declarationNodes = buildNodeVector();
+        const bool isConstant = acceptToken(vectorList, index, TK_CONST);
+
+        acceptToken(vectorList, index, TK_DIM);
+
+        if (!makeDeclarationNodes(vectorList, index, isConstant, declarationNodes)) {
+            return false;
+        }
+
+        for (int i = 0; i < declarationNodes->size; i++) {
+            pushVector(externalDeclarationNodes, makeExternalDeclarationNode(NULL, declarationNodes->contents[i]));
+        }
+
+        return true;
+    }
+
+    reportSyntaxError(vectorList, *index, "unexpected statement outside a procedure");
+    return false;
+}
+
 TransUnitNode *makeTransUnitNode() {
-    TransUnitNode *transUnitNode = malloc(sizeof(TransUnitNode));
+    TransUnitNode *transUnitNode = calloc(1, sizeof(TransUnitNode));
+    transUnitNode->arena = buildArena(PARSER_ARENA_BLOCK_SIZE);
+    transUnitNode->nodeVectors = buildVectorList();
     transUnitNode->externalDeclarationNodes = buildVectorList();
+    pushVector(transUnitNode->nodeVectors, transUnitNode->externalDeclarationNodes);
     return transUnitNode;
 }
 
+// control flow graphs an emitter left behind go with the tree
+void freeTransUnitNode(TransUnitNode *transUnitNode) {
+    for (int i = 0; i < transUnitNode->externalDeclarationNodes->size; i++) {
+        const ExternalDeclarationNode *externalDeclarationNode = transUnitNode->externalDeclarationNodes->contents[i];
+
+        if (externalDeclarationNode->functionDefinitionNode != NULL && externalDeclarationNode->functionDefinitionNode->controlFlowGraph != NULL) {
+            freeControlFlowGraph(externalDeclarationNode->functionDefinitionNode->controlFlowGraph);
+        }
+    }
+
+    for (int i = 0; i < transUnitNode->nodeVectors->size; i++) {
+        Vector *vector = transUnitNode->nodeVectors->contents[i];
+        free(vector->contents);
+        free(vector);
+    }
+
+    free(transUnitNode->nodeVectors->contents);
+    free(transUnitNode->nodeVectors);
+    freeArena(transUnitNode->arena);
+    free(transUnitNode);
+}
+
+// NULL once any line failed to parse, after every failing line has been reported, or once over budget
 TransUnitNode *parse(const Vector *vectorList) {
-    classMap = buildStringMap(1024);
+    classMap = buildStringMap(64);
     int index = 0;
 
     TransUnitNode *transUnitNode = makeTransUnitNode();
+    currentUnit = transUnitNode;
+    withObjects = buildVectorList();
+    pendingNextCount = 0;
+    eachCount = 0;
+    optionBase = 0;
+    syntaxErrorCount = 0;
+    nestingDepth = 0;
 
-    while (index < vectorList->size) {
-        ExternalDeclarationNode *externalDeclarationNode = makeExternalDeclarationNode(vectorList, &index);
+    while (index < vectorList->size && !isOverBudget()) {
+        if (acceptToken(vectorList, &index, TK_NEWLINE) || acceptToken(vectorList, &index, TK_COLON)) {
+            continue;
+        }
 
-        if (externalDeclarationNode == NULL) {
-            printf("error: could not create external-declaration-type node.\n");
-            return NULL;
+        if (!makeExternalDeclarationNodes(vectorList, &index, transUnitNode->externalDeclarationNodes)) {
+            skipLine(vectorList, &index);
         }
+        else if (!isStatementEnd(vectorList, index)) {
+            reportSyntaxError(vectorList, index, "expected the end of the statement");
+            skipLine(vectorList, &index);
+        }
+    }
 
-        pushVector(transUnitNode->externalDeclarationNodes, externalDeclarationNode);
+    free(withObjects->contents);
+    free(withObjects);
+    freeStringMap(classMap);
+    classMap = NULL;
+    currentUnit = NULL;
+
+    if (syntaxErrorCount > 0 || isOverBudget()) {
+        freeTransUnitNode(transUnitNode);
+        return NULL;
     }
 
     return transUnitNode;
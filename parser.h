@@ -1,6 +1,8 @@
 #pragma once
 
 #include "lexer.h"
+#include "symbols.h"
+#include "trace.h"
 
 typedef struct AsmStatementNode AsmStatementNode;
 typedef struct UnaryExpressionNode UnaryExpressionNode;
@@ -49,6 +51,7 @@ typedef struct ExpressionStatementNode ExpressionStatementNode;
 typedef struct JumpStatementNode JumpStatementNode;
 typedef struct SelectionStatementNode SelectionStatementNode;
 typedef struct IterationStatementNode IterationStatementNode;
+typedef struct RedimStatementNode RedimStatementNode;
 
 typedef struct PointerNode {
     int count;
@@ -61,8 +64,12 @@ typedef struct ConstantNode {
     char *characterConstant;  
 } ConstantNode; 
 
+// every node and string of the unit lives in arena, and every vector is in nodeVectors, so freeTransUnitNode
+// releases the whole tree at once
 struct TransUnitNode {
     Vector *externalDeclarationNodes;
+    Arena *arena;
+    Vector *nodeVectors;
 };
 
 struct AssignmentExpressionNode {
@@ -123,7 +130,9 @@ struct AdditionExpressionNode {
     AdditionExpressionNode *additionExpressionNode;
 };
 
+// operatorType is OPERATOR_CONCAT for VB's &, which binds between arithmetic and comparison as shifts do in C
 struct ShiftExpressionNode {
+    int operatorType;
     AdditionExpressionNode *additionExpressionNode;
     ShiftExpressionNode *shiftExpressionNode;
 };
@@ -171,13 +180,18 @@ struct ConditionalExpressionNode {
     ConditionalExpressionNode *conditionalExpressionNode;
 };
 
+// conditionalExpressionNode is an array's upper bound and lowerBound its lower one, or -1 when that is not a
+// constant of 0 or more; isDynamic marks "a()", which ReDim sizes later
 struct DirectDeclaratorNode {
     char *identifier;
     Vector *identifierList;
     DeclaratorNode *declaratorNode;
     DirectDeclaratorNode *directDeclaratorNode;
     ConditionalExpressionNode *conditionalExpressionNode;
+    Vector *dimensionNodes;
     ParameterTypeListNode *parameterTypeListNode;
+    bool isDynamic;
+    int lowerBound;
 };
 
 struct DeclaratorNode {
@@ -185,10 +199,15 @@ struct DeclaratorNode {
     DirectDeclaratorNode *directDeclaratorNode;     
 };
 
+// controlFlowGraph is built on first use by getControlFlowGraph. accessor is TK_GET, TK_LET or TK_SET for
+// a Property procedure and 0 for a Sub or Function; isPrivate is whether only its own module can call it.
 struct FunctionDefinitionNode {
+    int accessor;
+    bool isPrivate;
     Vector *declarationSpecifierNodes;
     DeclaratorNode *declaratorNode;
     CompoundStatementNode *compoundStatementNode;
+    struct ControlFlowGraph *controlFlowGraph;
 };
 
 struct ExternalDeclarationNode {
@@ -202,10 +221,13 @@ struct FlockSpecifierNode {
     Vector *flockDeclarationNodes; 
 };
 
+// isNew marks "Dim x As New T", which creates the object along with the variable
 struct TypeSpecifierNode {
     char *flockName;
     int typeSpecifier;
+    int numericType;
     FlockSpecifierNode *flockSpecifierNode;
+    bool isNew;
 };
 
 struct DeclarationSpecifierNode {
@@ -238,9 +260,11 @@ struct ParameterListNode {
     ParameterListNode *parameterListNode;  
 };
 
+// isByVal marks a parameter passed ByVal; any other is passed ByRef, VB's default
 struct ParameterDeclarationNode {
     Vector *declaratorSpecifierNodes;
     DeclaratorNode *declaratorNode;
+    bool isByVal;
 };
 
 struct GaggleSpecifierNode {
@@ -292,10 +316,12 @@ struct StatementNode {
     SelectionStatementNode *selectionStatementNode;
     IterationStatementNode *iterationStatementNode;
     JumpStatementNode *jumpStatementNode;
+    RedimStatementNode *redimStatementNode;
 };
 
 struct LabelStatementNode {
     int labeledStatementType;
+    char *identifier;
     ConditionalExpressionNode *conditionalExpressionNode;
     StatementNode *statementNode;
 };
@@ -311,8 +337,10 @@ struct SelectionStatementNode {
     StatementNode *statementNode2;
 };
 
+// isWend marks a While ... Wend, which Exit Do does not leave
 struct IterationStatementNode {
     int type;
+    bool isWend;
     Vector *declarationNodes;
     StatementNode *statementNode;
     ExpressionNode *expressionNode1;
@@ -326,6 +354,15 @@ struct JumpStatementNode {
     ExpressionNode *expressionNode;
 };
 
+// ReDim [Preserve] a(upper): postfixExpressionNode is the array called with its new upper bounds
+// lowerBound is the lower bound every dimension starts at, explicitly or through Option Base, or -1 when they
+// differ or one is not a constant of 0 or more
+struct RedimStatementNode {
+    bool isPreserve;
+    int lowerBound;
+    PostfixExpressionNode *postfixExpressionNode;
+};
+
 struct AsmStatementNode {
     ConstantNode *constantNode;
     ExpressionNode *expressionNode;
@@ -340,7 +377,18 @@ enum TypeSpecifier {
     TYPE_B8,
     TYPE_FLOCK,
     TYPE_GAGGLE,
-    TYPENAME
+    TYPENAME,
+    TYPE_VARIANT
+};
+
+// which VB type a TYPE_SI32 or TYPE_FP64 was written as: the inference and the graph only tell integers from
+// floating point, but C# keeps each width, Long and Double being the default ones
+enum NumericType {
+    NUMERIC_DEFAULT,
+    NUMERIC_INTEGER,
+    NUMERIC_BYTE,
+    NUMERIC_SINGLE,
+    NUMERIC_DECIMAL
 };
 
 enum OperatorType {
@@ -357,7 +405,9 @@ enum OperatorType {
     OPERATOR_MULTIPLY,
     OPERATOR_DIVIDE,
     OPERATOR_MODULO,
-    OPERATOR_EXCLAMATION
+    OPERATOR_EXCLAMATION,
+    OPERATOR_CONCAT,
+    OPERATOR_CONCAT_EQUAL
 };
 
 enum ComparisonOperatorType {
@@ -370,26 +420,40 @@ enum ComparisonOperatorType {
     COMPARE_GREATER_OR_EQUAL
 };
 
+// CONSTANT_B8 is True or False, with integerConstant -1 or 0 as in VB
 enum ConstantType {
     CONSTANT_SI32,
     CONSTANT_BYTE,
     CONSTANT_STRING,
-    CONSTANT_FP64
+    CONSTANT_FP64,
+    CONSTANT_B8
 };
 
+// GoTo, GoSub and On Error GoTo name their label in identifier; "On Error GoTo 0" has identifier "0"
 enum JumpType {
     JUMP_CONTINUE,
     JUMP_STOP,
-    JUMP_RETURN
-};
-
+    JUMP_RETURN,
+    JUMP_GOTO,
+    JUMP_GOSUB,
+    JUMP_GOSUB_RETURN,
+    JUMP_EXIT_FOR,
+    JUMP_EXIT_DO,
+    JUMP_ON_ERROR_GOTO,
+    JUMP_ON_ERROR_RESUME_NEXT,
+    JUMP_RESUME,
+    JUMP_RESUME_NEXT
+};
+
+// UNARY_NEW is "New T", with T in typeNameNode
 enum UnaryType {
     UNARY_NONE,
     UNARY_INCREMENT,
     UNARY_DECREMENT,
     UNARY_OPERATOR,
     UNARY_SIZE_IDENTIFIER,
-    UNARY_SIZE_TYPE
+    UNARY_SIZE_TYPE,
+    UNARY_NEW
 };
 
 enum SizeType {
@@ -415,68 +479,40 @@ enum SelectionStatementType {
     SELECTION_MATCH
 };
 
+// ITERATION_DO tests expressionNode1 after the body, as in "Do ... Loop While"
 enum IterationType {
     ITERATION_WHILE,
-    ITERATION_FOR
+    ITERATION_FOR,
+    ITERATION_DO
 };
 
 enum LabeledStatementType {
     LABEL_CASE,
-    LABEL_DEFAULT
+    LABEL_DEFAULT,
+    LABEL_NAMED
 };
 
-StringMap *classMap;
-bool isExternFunction;
+extern _Thread_local StringMap *classMap;
+extern _Thread_local bool isExternFunction;
+extern _Thread_local const SymbolIndex *symbolIndex;
 
 TransUnitNode *parse(const Vector *vectorList);
+void freeTransUnitNode(TransUnitNode *transUnitNode);
 
 ExpressionNode *makeExpressionNode(const Vector *vectorList, int *index);
-AssignmentExpressionNode *makeAssignmentExpressionNode(const Vector *vectorList, int *index);
-DeclarationSpecifierNode *makeDeclarationSpecifierNode(const Vector *vectorList, int *index);
-DeclaratorNode *makeDeclaratorNode(const Vector *vectorList, int *index);
-DeclarationNode *makeDeclarationNode(const Vector *vectorList, int *index);
-StatementNode *makeStatementNode(const Vector *vectorList, int *index);
-ConstantNode *makeConstantNode(const Vector *vectorList, int *index);
-CompoundStatementNode *makeCompoundStatementNode(const Vector *vectorList, int *index);
-SelectionStatementNode *makeSelectionStatementNode(const Vector *vectorList, int *index);
-ExpressionStatementNode *makeExpressionStatementNode(const Vector *vectorList, int *index);
-LabelStatementNode *makeLabelStatementNode(const Vector *vectorList, int *index);
-CastExpressionNode *makeCastExpressionNode(const Vector *vectorList, int *index);
-TypeNameNode *makeTypeNameNode(const Vector *vectorList, int *index);
-JumpStatementNode *makeJumpStatementNode(const Vector *vectorList, int *index);
-IterationStatementNode *makeIterationStatementNode(const Vector *vectorList, int *index);
-AsmStatementNode *makeAsmStatementNode(const Vector *vectorList, int *index);
 TypeSpecifierNode *makeTypeSpecifierNode(const Vector *vectorList, int *index);
-InitializerNode *makeInitializerNode(const Vector *vectorList, int *index);
-SpecifierQualifierNode *makeSpecifierQualifierNode(const Vector *vectorList, int *index);
-FlockDeclarationNode *makeFlockDeclarationNode(const Vector *vectorList, int *index);
-ExternalDeclarationNode *makeExternalDeclarationNode(const Vector *vectorList, int *index);
-DirectDeclaratorNode *makeDirectDeclaratorNode(const Vector *vectorList, int *index);
 ParameterTypeListNode *makeParameterTypeListNode(const Vector *vectorList, int *index);
-InitializeDeclaratorNode *makeInitializingDeclaratorNode(const Vector *vectorList, int *index);
-UnaryExpressionNode *makeUnaryExpressionNode(const Vector *vectorList, int *index);
-MultiplicationExpressionNode *makeMultiplicationExpressionNode(const Vector *vectorList, int *index);
+CompoundStatementNode *makeCompoundStatementNode(const Vector *vectorList, int *index);
 FunctionDefinitionNode *makeFunctionDefinitionNode(const Vector *vectorList, int *index);
-ShiftExpressionNode *makeShiftExpression(const Vector *vectorList, int *index);
-RelationalExpressionNode *makeRelationalExpressionNode(const Vector *vectorList, int *index);
-EqualExpressionNode *makeEqualExpressionNode(const Vector *vectorList, int *index);
-AndExpressionNode *makeAndExpressionNode(const Vector *vectorList, int *index);
-BlockItemNode *makeBlockItemNode(const Vector *vectorList, int *index);
-InclusiveOrExpressionNode *makeInclusiveOrExpressionNode(const Vector *vectorList, int *index);
-LogicalAndExpressionNode *makeLogicalAndExpressionNode(const Vector *vectorList, int *index);
-TypeSpecifierNode *makeTypeSpecifierNode(const Vector *vectorList, int *index);
-OrExpressionNode *makeLogicalOrExpressionNode(const Vector *vectorList, int *index);
-ConditionalExpressionNode *makeConditionalExpressionNode(const Vector *vectorList, int *index);
-GaggleSpecifierNode *makeGaggleSpecifierNode(const Vector *vectorList, int *index);
-PostfixExpressionNode *makePostfixExpressionNode(const Vector *vectorList, int *index);
-PointerNode *makePointerNode(const Vector *vectorList, int *index);
-PrimaryExpressionNode *makePrimaryExpressionNode(const Vector *vectorList, int *index);
-ExclusiveOrExpressionNode *makeExclusiveOrExpressionNode(const Vector *vectorList, int *index);
-AdditionExpressionNode *makeAdditiveExpressionNode(const Vector *vectorList, int *index);
-ParameterDeclarationNode *makeParameterDeclarationNode(const Vector *vectorList, int *index);
-
-bool isFunctionDefinition(const Vector *vectorList, int index);
-bool isDeclarator(const Vector *vectorList, int index);
-bool isFunctionDeclaration(const Vector *vectorList, int index);
-bool isDeclarationSpecifier(const Vector *vectorList, int index);
-bool isTypeSpecifier(const Vector *vectorList, int index);
\ No newline at end of file
+bool makeDeclarationNodes(const Vector *vectorList, int *index, bool isConstant, Vector *declarationNodes);
+bool makeStatementNodes(const Vector *vectorList, int *index, Vector *blockItemNodes);
+bool makeExternalDeclarationNodes(const Vector *vectorList, int *index, Vector *externalDeclarationNodes);
+
+bool isTypeName(const char *name);
+const char *findProcedureName(const Vector *vectorList, int index);
+const DirectDeclaratorNode *getNamedDirectDeclarator(const DirectDeclaratorNode *directDeclaratorNode);
+const char *getDeclaratorName(const DeclaratorNode *declaratorNode);
+const ParameterTypeListNode *getParameterTypeList(const DeclaratorNode *declaratorNode);
+const TypeSpecifierNode *findTypeSpecifier(const Vector *declarationSpecifierNodes, bool *isConstant);
+long getTokenOffset(const Vector *vectorList, int index);
+const Token *readLookahead(const Vector *vectorList, int *index);
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include <sched.h>
+
+#include "pipeline.h"
+
+typedef struct PipelineContext {
+    TranspileResult **order;
+    int count;
+    atomic_int nextFile;
+    PipelineMetrics *metrics;
+} PipelineContext;
+
+typedef struct StageWorker {
+    PipelineContext *context;
+    int stage;
+} StageWorker;
+
+static bool (*const stageFunctions[STAGE_COUNT])(TranspileResult *result) = {
+    readStage,
+    lexStage,
+    parseStage,
+    emitStage
+};
+
+static const char *const stageNames[STAGE_COUNT] = {
+    "read",
+    "lex",
+    "parse",
+    "emit"
+};
+
+long getCurrentNanoseconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+void initializeBoundedQueue(BoundedQueue *queue, int capacity) {
+    size_t size = 2;
+
+    while ((int)size < capacity) {
+        size *= 2;
+    }
+
+    queue->cells = malloc(sizeof(QueueCell) * size);
+    queue->mask = size - 1;
+
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&queue->cells[i].sequence, i);
+        queue->cells[i].data = NULL;
+    }
+
+    atomic_init(&queue->enqueuePosition, 0);
+    atomic_init(&queue->dequeuePosition, 0);
+    atomic_init(&queue->producers, 0);
+    atomic_init(&queue->depthTotal, 0);
+    atomic_init(&queue->depthSamples, 0);
+    atomic_init(&queue->depthMax, 0);
+}
+
+void freeBoundedQueue(BoundedQueue *queue) {
+    free(queue->cells);
+    queue->cells = NULL;
+}
+
+bool tryEnqueue(BoundedQueue *queue, void *data) {
+    size_t pos = atomic_load_explicit(&queue->enqueuePosition, memory_order_relaxed);
+    QueueCell *cell;
+
+    while (true) {
+        cell = &queue->cells[pos & queue->mask];
+        const size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        const intptr_t difference = (intptr_t)sequence - (intptr_t)pos;
+
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueuePosition, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (difference < 0) {
+            return false;
+        }
+        else {
+            pos = atomic_load_explicit(&queue->enqueuePosition, memory_order_relaxed);
+        }
+    }
+
+    cell->data = data;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+
+    const long depth = pos + 1 - atomic_load_explicit(&queue->dequeuePosition, memory_order_relaxed);
+    long max = atomic_load_explicit(&queue->depthMax, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&queue->depthTotal, depth, memory_order_relaxed);
+    atomic_fetch_add_explicit(&queue->depthSamples, 1, memory_order_relaxed);
+
+    while (depth > max && !atomic_compare_exchange_weak_explicit(&queue->depthMax, &max, depth, memory_order_relaxed, memory_order_relaxed)) {
+    }
+
+    return true;
+}
+
+bool tryDequeue(BoundedQueue *queue, void **data) {
+    size_t pos = atomic_load_explicit(&queue->dequeuePosition, memory_order_relaxed);
+    QueueCell *cell;
+
+    while (true) {
+        cell = &queue->cells[pos & queue->mask];
+        const size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        const intptr_t difference = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+        if (difference == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeuePosition, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (difference < 0) {
+            return false;
+        }
+        else {
+            pos = atomic_load_explicit(&queue->dequeuePosition, memory_order_relaxed);
+        }
+    }
+
+    *data = cell->data;
+    atomic_store_explicit(&cell->sequence, pos + queue->mask + 1, memory_order_release);
+    return true;
+}
+
+void backoffPipeline(int *spins) {
+    if (*spins < 16) {
+        sched_yield();
+    }
+    else {
+        const struct timespec delay = { 0, 50000 };
+        nanosleep(&delay, NULL);
+    }
+
+    (*spins)++;
+}
+
+bool takePipelineItem(PipelineContext *context, int stage, TranspileResult **result) {
+    if (stage == STAGE_READ) {
+        const int index = atomic_fetch_add(&context->nextFile, 1);
+
+        if (index >= context->count) {
+            return false;
+        }
+
+        *result = context->order[index];
+        return true;
+    }
+
+    BoundedQueue *input = &context->metrics->queues[stage - 1];
+    const long startTime = getCurrentNanoseconds();
+    int spins = 0;
+    bool taken = false;
+
+    while (!(taken = tryDequeue(input, (void**)result))) {
+        // producers finish only after their last enqueue, so one more look decides
+        if (atomic_load(&input->producers) == 0) {
+            taken = tryDequeue(input, (void**)result);
+            break;
+        }
+
+        backoffPipeline(&spins);
+    }
+
+    atomic_fetch_add(&context->metrics->stages[stage].starvedTime, getCurrentNanoseconds() - startTime);
+    return taken;
+}
+
+void putPipelineItem(PipelineContext *context, int stage, TranspileResult *result) {
+    BoundedQueue *output = &context->metrics->queues[stage];
+    long startTime = 0;
+    int spins = 0;
+
+    while (!tryEnqueue(output, result)) {
+        if (spins == 0) {
+            startTime = getCurrentNanoseconds();
+        }
+
+        backoffPipeline(&spins);
+    }
+
+    if (spins > 0) {
+        atomic_fetch_add(&context->metrics->stages[stage].blockedTime, getCurrentNanoseconds() - startTime);
+    }
+}
+
+void *runStageWorker(void *argument) {
+    StageWorker *worker = argument;
+    PipelineContext *context = worker->context;
+    const int stage = worker->stage;
+    StageMetrics *metrics = &context->metrics->stages[stage];
+    TranspileResult *result = NULL;
+
+    while (takePipelineItem(context, stage, &result)) {
+        const long startTime = getCurrentNanoseconds();
+        const bool succeeded = stageFunctions[stage](result);
+
+        atomic_fetch_add(&metrics->busyTime, getCurrentNanoseconds() - startTime);
+        atomic_fetch_add(&metrics->itemCount, 1);
+
+        if (succeeded && stage < STAGE_EMIT) {
+            putPipelineItem(context, stage, result);
+        }
+    }
+
+    if (stage < STAGE_EMIT) {
+        atomic_fetch_sub(&context->metrics->queues[stage].producers, 1);
+    }
+
+    return NULL;
+}
+
+void initializePipelineOptions(PipelineOptions *options, int workerCount) {
+    const int half = (workerCount > 1) ? workerCount / 2 : 1;
+
+    options->stageWorkers[STAGE_READ] = 2;
+    options->stageWorkers[STAGE_LEX] = half;
+    options->stageWorkers[STAGE_PARSE] = half;
+    options->stageWorkers[STAGE_EMIT] = 1;
+    options->queueCapacity = 64;
+}
+
+bool parsePipelineWorkers(PipelineOptions *options, const char *text) {
+    int workers[STAGE_COUNT];
+
+    if (sscanf(text, "%d,%d,%d,%d", &workers[0], &workers[1], &workers[2], &workers[3]) != STAGE_COUNT) {
+        printf("error: expected four comma-separated worker counts, got \"%s\".\n", text);
+        return false;
+    }
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        if (workers[i] < 1) {
+            printf("error: the %s stage needs at least one worker.\n", stageNames[i]);
+            return false;
+        }
+
+        options->stageWorkers[i] = workers[i];
+    }
+
+    return true;
+}
+
+TranspileResult *transpileProjectPipelined(const Project *project, const PipelineOptions *options, const bool *selection, TranspileSummary *summary, PipelineMetrics *metrics) {
+    PipelineContext context;
+    context.metrics = metrics;
+    atomic_init(&context.nextFile, 0);
+
+    TranspileResult *results = buildTranspileResults(project, selection, &context.order, &context.count);
+
+    memset(metrics, 0, sizeof(PipelineMetrics));
+
+    int threadCount = 0;
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        metrics->stages[i].workerCount = options->stageWorkers[i];
+        threadCount += options->stageWorkers[i];
+
+        if (i < STAGE_EMIT) {
+            initializeBoundedQueue(&metrics->queues[i], options->queueCapacity);
+            atomic_store(&metrics->queues[i].producers, options->stageWorkers[i]);
+        }
+    }
+
+    pthread_t *threads = malloc(sizeof(pthread_t) * threadCount);
+    StageWorker *workers = malloc(sizeof(StageWorker) * threadCount);
+    const double startTime = getCurrentTime();
+    int thread = 0;
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        for (int j = 0; j < options->stageWorkers[i]; j++, thread++) {
+            workers[thread].context = &context;
+            workers[thread].stage = i;
+
+            if (pthread_create(&threads[thread], NULL, runStageWorker, &workers[thread]) != 0) {
+                printf("error: could not create %s stage worker.\n", stageNames[i]);
+                exit(-1);
+            }
+        }
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    const double endTime = getCurrentTime();
+    metrics->wallTime = endTime - startTime;
+
+    for (int i = 0; i < STAGE_EMIT; i++) {
+        freeBoundedQueue(&metrics->queues[i]);
+    }
+
+    summarizeTranspileResults(results, project->files->size, startTime, endTime, summary);
+
+    free(threads);
+    free(workers);
+    free(context.order);
+
+    return results;
+}
+
+void printPipelineReport(const PipelineMetrics *metrics) {
+    int bottleneck = 0;
+    double bottleneckUtilization = -1;
+
+    printf("%-6s %8s %8s %10s %7s %12s %12s\n", "stage", "workers", "items", "busy(ms)", "util", "starved(ms)", "blocked(ms)");
+
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const StageMetrics *stage = &metrics->stages[i];
+        const double busy = atomic_load(&stage->busyTime) / 1e9;
+        const double utilization = (metrics->wallTime > 0) ? busy / (metrics->wallTime * stage->workerCount) : 0;
+
+        printf("%-6s %8d %8ld %10.3f %6.1f%% %12.3f %12.3f\n",
+            stageNames[i],
+            stage->workerCount,
+            atomic_load(&stage->itemCount),
+            busy * 1e3,
+            utilization * 100,
+            atomic_load(&stage->starvedTime) / 1e6,
+            atomic_load(&stage->blockedTime) / 1e6);
+
+        if (utilization > bottleneckUtilization) {
+            bottleneck = i;
+            bottleneckUtilization = utilization;
+        }
+    }
+
+    for (int i = 0; i < STAGE_EMIT; i++) {
+        const BoundedQueue *queue = &metrics->queues[i];
+        const long samples = atomic_load(&queue->depthSamples);
+
+        printf("queue %s->%s: capacity %d, mean depth %.2f, max depth %ld\n",
+            stageNames[i],
+            stageNames[i + 1],
+            (int)(queue->mask + 1),
+            (samples > 0) ? (double)atomic_load(&queue->depthTotal) / samples : 0.0,
+            atomic_load(&queue->depthMax));
+    }
+
+    printf("bottleneck: %s (%.1f%% utilized)\n", stageNames[bottleneck], bottleneckUtilization * 100);
+}
\ No newline at end of file
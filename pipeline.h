@@ -0,0 +1,60 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "transpile.h"
+
+enum PipelineStage {
+    STAGE_READ,
+    STAGE_LEX,
+    STAGE_PARSE,
+    STAGE_EMIT,
+    STAGE_COUNT
+};
+
+typedef struct QueueCell {
+    atomic_size_t sequence;
+    void *data;
+} QueueCell;
+
+// bounded multi-producer multi-consumer ring (Vyukov); positions sit on separate cache lines
+typedef struct BoundedQueue {
+    QueueCell *cells;
+    size_t mask;
+    _Alignas(64) atomic_size_t enqueuePosition;
+    _Alignas(64) atomic_size_t dequeuePosition;
+    _Alignas(64) atomic_int producers;
+    atomic_long depthTotal;
+    atomic_long depthSamples;
+    atomic_long depthMax;
+} BoundedQueue;
+
+typedef struct StageMetrics {
+    int workerCount;
+    atomic_long itemCount;
+    atomic_long busyTime;
+    atomic_long starvedTime;
+    atomic_long blockedTime;
+} StageMetrics;
+
+typedef struct PipelineOptions {
+    int stageWorkers[STAGE_COUNT];
+    int queueCapacity;
+} PipelineOptions;
+
+typedef struct PipelineMetrics {
+    double wallTime;
+    StageMetrics stages[STAGE_COUNT];
+    BoundedQueue queues[STAGE_COUNT - 1];
+} PipelineMetrics;
+
+void initializeBoundedQueue(BoundedQueue *queue, int capacity);
+void freeBoundedQueue(BoundedQueue *queue);
+bool tryEnqueue(BoundedQueue *queue, void *data);
+bool tryDequeue(BoundedQueue *queue, void **data);
+
+void initializePipelineOptions(PipelineOptions *options, int workerCount);
+bool parsePipelineWorkers(PipelineOptions *options, const char *text);
+TranspileResult *transpileProjectPipelined(const Project *project, const PipelineOptions *options, const bool *selection, TranspileSummary *summary, PipelineMetrics *metrics);
+void printPipelineReport(const PipelineMetrics *metrics);
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include "decode.h"
+#include "directive.h"
+#include "project.h"
+
+char *trimProjectValue(char *value) {
+    while (*value == ' ' || *value == '\t' || *value == '"') {
+        value++;
+    }
+
+    int len = strlen(value);
+
+    while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t' || value[len - 1] == '\r' || value[len - 1] == '"')) {
+        len--;
+    }
+
+    value[len] = '\0';
+    return value;
+}
+
+char *getDirectoryName(const char *path) {
+    const char *slash = strrchr(path, '/');
+
+    if (slash == NULL) {
+        return strdup(".");
+    }
+
+    return strndup(path, slash - path);
+}
+
+// the .cs file a module is emitted to, or NULL when the project writes no output
+char *getOutputPath(const ProjectFile *file) {
+    const char *outputDirectory = file->project->outputDirectory;
+
+    if (outputDirectory == NULL) {
+        return NULL;
+    }
+
+    char *outputPath = malloc(strlen(outputDirectory) + strlen(file->name) + 5);
+    sprintf(outputPath, "%s/%s.cs", outputDirectory, file->name);
+    return outputPath;
+}
+
+char *getStemName(const char *path) {
+    const char *slash = strrchr(path, '/');
+    const char *start = (slash == NULL) ? path : slash + 1;
+    const char *dot = strrchr(start, '.');
+
+    if (dot == NULL) {
+        return strdup(start);
+    }
+
+    return strndup(start, dot - start);
+}
+
+char *resolveProjectPath(const char *directory, const char *relative) {
+    char *path = malloc(strlen(directory) + strlen(relative) + 2);
+
+    if (relative[0] == '/') {
+        strcpy(path, relative);
+    }
+    else {
+        sprintf(path, "%s/%s", directory, relative);
+    }
+
+    for (char *p = path; *p; p++) {
+        if (*p == '\\') {
+            *p = '/';
+        }
+    }
+
+    return path;
+}
+
+ProjectFile *buildProjectFile(int type, const char *name, char *path) {
+    ProjectFile *file = calloc(1, sizeof(ProjectFile));
+    file->type = type;
+    file->path = path;
+    file->name = (name != NULL) ? strdup(name) : getStemName(path);
+    file->size = getFileSize(path);
+
+    return file;
+}
+
+void pushProjectFile(Project *project, ProjectFile *file) {
+    file->project = project;
+    file->index = project->files->size;
+    pushVector(project->files, file);
+}
+
+ProjectReference *readProjectReference(char *value) {
+    char *open = strchr(value, '{');
+    char *close = (open != NULL) ? strchr(open, '}') : NULL;
+
+    if (close == NULL) {
+        return NULL;
+    }
+
+    ProjectReference *reference = calloc(1, sizeof(ProjectReference));
+    reference->guid = strndup(open + 1, close - open - 1);
+
+    char *savePointer = NULL;
+    char *field = strtok_r(close + 1, "#", &savePointer);
+
+    for (int i = 0; field != NULL; i++) {
+        if (i == 0) {
+            reference->version = strdup(field);
+        }
+        else if (i == 2) {
+            reference->path = strdup(field);
+        }
+        else if (i == 3) {
+            reference->description = strdup(field);
+        }
+
+        field = strtok_r(NULL, "#", &savePointer);
+    }
+
+    return reference;
+}
+
+Project *readProject(const char *path) {
+    char *source = readFile(path);
+
+    if (source == NULL) {
+        printf("error: could not read project file \"%s\".\n", path);
+        return NULL;
+    }
+
+    Project *project = calloc(1, sizeof(Project));
+    project->path = strdup(path);
+    project->directory = getDirectoryName(path);
+    project->name = getStemName(path);
+    project->files = buildVectorList();
+    project->references = buildVectorList();
+    project->defines = buildStringIntegerMap(64);
+    project->codePage = DEFAULT_CODE_PAGE;
+
+    char *savePointer = NULL;
+    char *line = strtok_r(source, "\n", &savePointer);
+
+    while (line != NULL) {
+        char *equal = strchr(line, '=');
+
+        if (equal != NULL) {
+            *equal = '\0';
+            char *key = trimProjectValue(line);
+            char *value = trimProjectValue(equal + 1);
+            char *semicolon = strchr(value, ';');
+
+            if (strcmp(key, "Module") == 0 || strcmp(key, "Class") == 0) {
+                if (semicolon == NULL) {
+                    printf("error: malformed \"%s\" entry in \"%s\".\n", key, path);
+                    free(source);
+                    return NULL;
+                }
+
+                *semicolon = '\0';
+                const int type = (key[0] == 'M') ? PROJECT_MODULE : PROJECT_CLASS;
+                char *filePath = resolveProjectPath(project->directory, trimProjectValue(semicolon + 1));
+
+                pushProjectFile(project, buildProjectFile(type, trimProjectValue(value), filePath));
+            }
+            else if (strcmp(key, "Form") == 0) {
+                pushProjectFile(project, buildProjectFile(PROJECT_FORM, NULL, resolveProjectPath(project->directory, value)));
+            }
+            else if (strcmp(key, "UserControl") == 0) {
+                pushProjectFile(project, buildProjectFile(PROJECT_USER_CONTROL, NULL, resolveProjectPath(project->directory, value)));
+            }
+            else if (strcmp(key, "Reference") == 0) {
+                ProjectReference *reference = readProjectReference(value);
+
+                if (reference != NULL) {
+                    pushVector(project->references, reference);
+                }
+            }
+            else if (strcmp(key, "CondComp") == 0) {
+                parseConditionalDefine(project->defines, value);
+            }
+            else if (strcmp(key, "Name") == 0) {
+                project->name = strdup(value);
+            }
+        }
+
+        line = strtok_r(NULL, "\n", &savePointer);
+    }
+
+    free(source);
+    return project;
+}
+
+Project *buildProjectFromFiles(char **paths, int count) {
+    Project *project = calloc(1, sizeof(Project));
+    project->path = NULL;
+    project->directory = strdup(".");
+    project->name = strdup("Project");
+    project->files = buildVectorList();
+    project->references = buildVectorList();
+    project->defines = buildStringIntegerMap(64);
+    project->codePage = DEFAULT_CODE_PAGE;
+
+    for (int i = 0; i < count; i++) {
+        const char *extension = strrchr(paths[i], '.');
+        int type = PROJECT_MODULE;
+
+        if (extension != NULL && strcmp(extension, ".cls") == 0) {
+            type = PROJECT_CLASS;
+        }
+        else if (extension != NULL && strcmp(extension, ".frm") == 0) {
+            type = PROJECT_FORM;
+        }
+        else if (extension != NULL && strcmp(extension, ".ctl") == 0) {
+            type = PROJECT_USER_CONTROL;
+        }
+
+        pushProjectFile(project, buildProjectFile(type, NULL, strdup(paths[i])));
+    }
+
+    return project;
+}
+
+ProjectFile *getProjectFile(const Project *project, int index) {
+    return project->files->contents[index];
+}
+
+const char *getProjectFileTypeName(int type) {
+    switch (type) {
+        case PROJECT_MODULE: {
+            return "Module";
+        }
+        case PROJECT_CLASS: {
+            return "Class";
+        }
+        case PROJECT_FORM: {
+            return "Form";
+        }
+        case PROJECT_USER_CONTROL: {
+            return "UserControl";
+        }
+        default: {
+            return "Unknown";
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "util.h"
+
+enum ProjectFileType {
+    PROJECT_MODULE,
+    PROJECT_CLASS,
+    PROJECT_FORM,
+    PROJECT_USER_CONTROL
+};
+
+typedef struct ProjectFile {
+    struct Project *project;
+    int type;
+    int index;
+    char *name;
+    char *path;
+    long size;
+} ProjectFile;
+
+// a "Reference=*\G{guid}#version#lcid#path#description" line from the .vbp
+typedef struct ProjectReference {
+    char *guid;
+    char *version;
+    char *path;
+    char *description;
+} ProjectReference;
+
+typedef struct Project {
+    char *path;
+    char *directory;
+    char *name;
+    char *outputDirectory;
+    struct SymbolIndex *symbols;
+    Vector *files;
+    Vector *references;
+    Vector *typeLibraries;
+    StringIntegerMap *defines;
+    int codePage;
+    double fileTimeLimit;
+    long fileMemoryLimit;
+} Project;
+
+Project *readProject(const char *path);
+Project *buildProjectFromFiles(char **paths, int count);
+ProjectFile *getProjectFile(const Project *project, int index);
+const char *getProjectFileTypeName(int type);
+char *getDirectoryName(const char *path);
+char *getOutputPath(const ProjectFile *file);
\ No newline at end of file
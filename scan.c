@@ -0,0 +1,700 @@
+#include <strings.h>
+
+#include "scan.h"
+
+enum ScanBlock {
+    BLOCK_NONE,
+    BLOCK_PROCEDURE,
+    BLOCK_TYPE,
+    BLOCK_ENUM
+};
+
+typedef struct ScanState {
+    ModuleScan *scan;
+    int block;
+    ScannedSymbol *blockSymbol;
+    char *blockText;
+    int blockLength;
+    int blockCapacity;
+    int referenceCapacity;
+} ScanState;
+
+bool isNameStart(char c) {
+    return isalpha((unsigned char)c) || c == '_' || (unsigned char)c >= 0x80;
+}
+
+bool isNameCharacter(char c) {
+    return isalnum((unsigned char)c) || c == '_' || (unsigned char)c >= 0x80;
+}
+
+int readWord(const char *line, int *pos, const char **word) {
+    while (line[*pos] == ' ' || line[*pos] == '\t') {
+        (*pos)++;
+    }
+
+    *word = &line[*pos];
+
+    if (!isNameStart(line[*pos])) {
+        return 0;
+    }
+
+    int len = 0;
+
+    while (isNameCharacter(line[*pos + len])) {
+        len++;
+    }
+
+    *pos += len;
+    return len;
+}
+
+bool isWord(const char *word, int length, const char *keyword) {
+    return (length == (int)strlen(keyword) && strncasecmp(word, keyword, length) == 0);
+}
+
+char *normalizeSignature(const char *text, int length) {
+    char *signature = malloc(length + 1);
+    int len = 0;
+    bool space = false;
+
+    for (int i = 0; i < length; i++) {
+        if (text[i] == ' ' || text[i] == '\t') {
+            space = (len > 0);
+            continue;
+        }
+
+        if (space) {
+            signature[len++] = ' ';
+            space = false;
+        }
+
+        signature[len++] = tolower((unsigned char)text[i]);
+    }
+
+    signature[len] = '\0';
+    return signature;
+}
+
+ScannedSymbol *pushScannedSymbol(ScanState *state, int kind, const char *name, int nameLength, const char *text, int textLength) {
+    ScannedSymbol *symbol = calloc(1, sizeof(ScannedSymbol));
+    symbol->kind = kind;
+    symbol->name = strndup(name, nameLength);
+    symbol->nameHash = calculateNameHash(name, nameLength);
+    symbol->signature = normalizeSignature(text, textLength);
+    symbol->signatureHash = calculateNameHash(symbol->signature, strlen(symbol->signature));
+
+    pushVector(state->scan->symbols, symbol);
+    return symbol;
+}
+
+void pushReference(ScanState *state, uint64_t hash) {
+    ModuleScan *scan = state->scan;
+
+    if (scan->referenceCount == state->referenceCapacity) {
+        state->referenceCapacity = (state->referenceCapacity == 0) ? 256 : state->referenceCapacity * 2;
+        scan->references = realloc(scan->references, sizeof(uint64_t) * state->referenceCapacity);
+    }
+
+    scan->references[scan->referenceCount++] = hash;
+}
+
+void collectReferences(ScanState *state, const char *line) {
+    int pos = 0;
+
+    while (line[pos]) {
+        if (line[pos] == '"') {
+            pos++;
+
+            while (line[pos] && line[pos] != '"') {
+                pos++;
+            }
+
+            if (line[pos]) {
+                pos++;
+            }
+        }
+        else if (isNameStart(line[pos]) && (pos == 0 || line[pos - 1] != '&')) {
+            const int start = pos;
+
+            while (isNameCharacter(line[pos])) {
+                pos++;
+            }
+
+            pushReference(state, calculateNameHash(&line[start], pos - start));
+        }
+        else if (isNameCharacter(line[pos])) {
+            while (isNameCharacter(line[pos])) {
+                pos++;
+            }
+        }
+        else {
+            pos++;
+        }
+    }
+}
+
+void appendBlockText(ScanState *state, const char *text) {
+    const int length = strlen(text);
+
+    if (state->blockLength + length + 2 > state->blockCapacity) {
+        state->blockCapacity = (state->blockLength + length + 2) * 2;
+        state->blockText = realloc(state->blockText, state->blockCapacity);
+    }
+
+    memcpy(&state->blockText[state->blockLength], text, length);
+    state->blockLength += length;
+    state->blockText[state->blockLength++] = ' ';
+    state->blockText[state->blockLength] = '\0';
+}
+
+// Const and variable declarations may list several names separated by commas.
+void scanDeclarationList(ScanState *state, int kind, const char *line, int pos) {
+    while (line[pos]) {
+        const char *name;
+        int nameLength = readWord(line, &pos, &name);
+
+        if (isWord(name, nameLength, "WithEvents")) {
+            nameLength = readWord(line, &pos, &name);
+        }
+
+        const int start = name - line;
+        int depth = 0;
+        bool inString = false;
+
+        while (line[pos] && (inString || depth > 0 || line[pos] != ',')) {
+            if (line[pos] == '"') {
+                inString = !inString;
+            }
+            else if (!inString && line[pos] == '(') {
+                depth++;
+            }
+            else if (!inString && line[pos] == ')') {
+                depth--;
+            }
+
+            pos++;
+        }
+
+        if (nameLength > 0) {
+            pushScannedSymbol(state, kind, name, nameLength, &line[start], pos - start);
+        }
+
+        if (line[pos] == ',') {
+            pos++;
+        }
+    }
+}
+
+void scanBlockLine(ScanState *state, const char *line) {
+    int pos = 0;
+    const char *word;
+    int length = readWord(line, &pos, &word);
+
+    if (isWord(word, length, "End")) {
+        const char *next;
+        const int nextLength = readWord(line, &pos, &next);
+
+        if ((state->block == BLOCK_PROCEDURE && (isWord(next, nextLength, "Sub") || isWord(next, nextLength, "Function") || isWord(next, nextLength, "Property")))
+            || (state->block == BLOCK_TYPE && isWord(next, nextLength, "Type"))
+            || (state->block == BLOCK_ENUM && isWord(next, nextLength, "Enum"))) {
+            if (state->blockSymbol != NULL) {
+                char *signature = normalizeSignature(state->blockText, state->blockLength);
+                free(state->blockSymbol->signature);
+                state->blockSymbol->signature = signature;
+                state->blockSymbol->signatureHash = calculateNameHash(signature, strlen(signature));
+            }
+
+            state->block = BLOCK_NONE;
+            state->blockSymbol = NULL;
+            return;
+        }
+    }
+
+    if (state->block == BLOCK_PROCEDURE || state->blockSymbol == NULL) {
+        return;
+    }
+
+    appendBlockText(state, line);
+
+    if (state->block == BLOCK_ENUM && length > 0) {
+        pushScannedSymbol(state, SYMBOL_ENUM_MEMBER, word, length, line, strlen(line));
+    }
+}
+
+bool isTrueAttribute(const char *line, int pos) {
+    const char *equal = strchr(&line[pos], '=');
+    const char *value;
+
+    if (equal == NULL) {
+        return false;
+    }
+
+    pos = equal - line + 1;
+    const int length = readWord(line, &pos, &value);
+
+    return isWord(value, length, "True");
+}
+
+void scanOptionLine(ScanState *state, const char *line, int pos) {
+    const char *word;
+    const int length = readWord(line, &pos, &word);
+
+    if (isWord(word, length, "Explicit")) {
+        state->scan->options |= MODULE_OPTION_EXPLICIT;
+    }
+    else if (isWord(word, length, "Private")) {
+        state->scan->options |= MODULE_OPTION_PRIVATE_MODULE;
+    }
+    else if (isWord(word, length, "Compare")) {
+        const char *mode;
+        const int modeLength = readWord(line, &pos, &mode);
+
+        if (isWord(mode, modeLength, "Text")) {
+            state->scan->options |= MODULE_OPTION_COMPARE_TEXT;
+        }
+    }
+    else if (isWord(word, length, "Base")) {
+        while (line[pos] == ' ') {
+            pos++;
+        }
+
+        state->scan->optionBase = atoi(&line[pos]);
+    }
+}
+
+void scanDeclarationLine(ScanState *state, const char *line) {
+    int pos = 0;
+    const char *word;
+    int length = readWord(line, &pos, &word);
+    bool isPublic = true;
+    bool hasModifier = false;
+
+    if (isWord(word, length, "Attribute")) {
+        const char *name;
+        const int nameLength = readWord(line, &pos, &name);
+        const char *quote = strchr(&line[pos], '"');
+
+        if (isWord(name, nameLength, "VB_Name") && quote != NULL) {
+            const char *end = strchr(quote + 1, '"');
+            state->scan->moduleName = (end != NULL) ? strndup(quote + 1, end - quote - 1) : strdup(quote + 1);
+        }
+        else if (isWord(name, nameLength, "VB_Creatable")) {
+            state->scan->isCreatable = isTrueAttribute(line, pos);
+        }
+        else if (isWord(name, nameLength, "VB_Exposed")) {
+            state->scan->isExposed = isTrueAttribute(line, pos);
+        }
+        else if (isWord(name, nameLength, "VB_PredeclaredId")) {
+            state->scan->isPredeclared = isTrueAttribute(line, pos);
+        }
+
+        return;
+    }
+
+    if (isWord(word, length, "Option")) {
+        scanOptionLine(state, line, pos);
+        return;
+    }
+
+    if (isWord(word, length, "Implements")) {
+        const char *name;
+        const int nameLength = readWord(line, &pos, &name);
+
+        if (nameLength > 0) {
+            pushVector(state->scan->implements, strndup(name, nameLength));
+        }
+
+        return;
+    }
+
+    while (true) {
+        if (isWord(word, length, "Public") || isWord(word, length, "Global") || isWord(word, length, "Friend")) {
+            isPublic = true;
+        }
+        else if (isWord(word, length, "Private") || isWord(word, length, "Dim")) {
+            isPublic = false;
+        }
+        else if (!isWord(word, length, "Static")) {
+            break;
+        }
+
+        hasModifier = true;
+        length = readWord(line, &pos, &word);
+    }
+
+    const char *keyword = word;
+    const char *name;
+    int nameLength;
+    int kind = -1;
+
+    if (isWord(word, length, "Sub") || isWord(word, length, "Function") || isWord(word, length, "Property")) {
+        kind = (word[0] == 'S' || word[0] == 's') ? SYMBOL_SUB : (word[0] == 'F' || word[0] == 'f') ? SYMBOL_FUNCTION : SYMBOL_PROPERTY;
+        state->block = BLOCK_PROCEDURE;
+        state->blockSymbol = NULL;
+
+        if (kind == SYMBOL_PROPERTY) {
+            readWord(line, &pos, &name);
+        }
+    }
+    else if (isWord(word, length, "Declare")) {
+        kind = SYMBOL_DECLARE;
+        readWord(line, &pos, &name);
+    }
+    else if (isWord(word, length, "Event")) {
+        kind = SYMBOL_EVENT;
+    }
+    else if (isWord(word, length, "Type") || isWord(word, length, "Enum")) {
+        kind = (word[0] == 'T' || word[0] == 't') ? SYMBOL_TYPE : SYMBOL_ENUM;
+        state->block = (kind == SYMBOL_TYPE) ? BLOCK_TYPE : BLOCK_ENUM;
+        state->blockLength = 0;
+        state->blockSymbol = NULL;
+    }
+    else if (isWord(word, length, "Const")) {
+        if (isPublic && hasModifier) {
+            scanDeclarationList(state, SYMBOL_CONST, line, pos);
+        }
+
+        return;
+    }
+    else if (hasModifier && length > 0) {
+        if (isPublic) {
+            scanDeclarationList(state, SYMBOL_VARIABLE, line, keyword - line);
+        }
+
+        return;
+    }
+    else {
+        return;
+    }
+
+    nameLength = readWord(line, &pos, &name);
+
+    if (nameLength == 0 || !isPublic) {
+        return;
+    }
+
+    ScannedSymbol *symbol = pushScannedSymbol(state, kind, name, nameLength, keyword, strlen(keyword));
+
+    if (state->block == BLOCK_TYPE || state->block == BLOCK_ENUM) {
+        state->blockSymbol = symbol;
+        appendBlockText(state, keyword);
+    }
+}
+
+// Copies one logical line into the buffer: continuations are joined and the comment is dropped.
+int readLogicalLine(const char *source, long length, long *pos, char **buffer, int *capacity) {
+    int len = 0;
+    bool inString = false;
+    bool inComment = false;
+
+    while (*pos < length) {
+        const char c = source[*pos];
+        (*pos)++;
+
+        if (c == '\n') {
+            int end = len;
+
+            while (end > 0 && (*buffer)[end - 1] == ' ') {
+                end--;
+            }
+
+            if (!inComment && end >= 2 && (*buffer)[end - 1] == '_' && (*buffer)[end - 2] == ' ') {
+                len = end - 1;
+                continue;
+            }
+
+            break;
+        }
+
+        if (c == '\r' || inComment) {
+            continue;
+        }
+
+        if (c == '"') {
+            inString = !inString;
+        }
+        else if (c == '\'' && !inString) {
+            inComment = true;
+            continue;
+        }
+
+        if (len + 2 > *capacity) {
+            *capacity *= 2;
+            *buffer = realloc(*buffer, *capacity);
+        }
+
+        (*buffer)[len++] = (c == '\t') ? ' ' : c;
+    }
+
+    (*buffer)[len] = '\0';
+    return len;
+}
+
+int compareReference(const void *left, const void *right) {
+    const uint64_t a = *(const uint64_t*)left;
+    const uint64_t b = *(const uint64_t*)right;
+
+    return (a > b) - (a < b);
+}
+
+ModuleScan *buildModuleScan(bool isClass) {
+    ModuleScan *scan = calloc(1, sizeof(ModuleScan));
+    scan->isClass = isClass;
+    scan->symbols = buildVectorList();
+    scan->implements = buildVectorList();
+
+    return scan;
+}
+
+void finishModuleScan(ScanState *state) {
+    ModuleScan *scan = state->scan;
+
+    if (scan->moduleName != NULL) {
+        const int kind = scan->isClass ? SYMBOL_CLASS : SYMBOL_MODULE;
+        pushScannedSymbol(state, kind, scan->moduleName, strlen(scan->moduleName), scan->moduleName, strlen(scan->moduleName));
+    }
+
+    free(state->blockText);
+}
+
+ModuleScan *scanModule(const char *source, long length, bool isClass) {
+    ModuleScan *scan = buildModuleScan(isClass);
+
+    ScanState state = { 0 };
+    state.scan = scan;
+
+    int capacity = 256;
+    char *buffer = malloc(capacity);
+    long pos = 0;
+
+    while (pos < length) {
+        readLogicalLine(source, length, &pos, &buffer, &capacity);
+
+        char *line = buffer;
+
+        while (*line == ' ') {
+            line++;
+        }
+
+        if (*line == '\0' || strncasecmp(line, "Rem ", 4) == 0) {
+            continue;
+        }
+
+        collectReferences(&state, line);
+
+        if (state.block == BLOCK_NONE) {
+            scanDeclarationLine(&state, line);
+        }
+        else {
+            scanBlockLine(&state, line);
+        }
+    }
+
+    finishModuleScan(&state);
+    qsort(scan->references, scan->referenceCount, sizeof(uint64_t), compareReference);
+
+    int unique = 0;
+
+    for (int i = 0; i < scan->referenceCount; i++) {
+        if (unique == 0 || scan->references[unique - 1] != scan->references[i]) {
+            scan->references[unique++] = scan->references[i];
+        }
+    }
+
+    scan->referenceCount = unique;
+
+    free(buffer);
+    return scan;
+}
+
+bool isLineWord(const char *line, const char *end, const char **next, const char *keyword) {
+    const int length = strlen(keyword);
+
+    while (line < end && (*line == ' ' || *line == '\t')) {
+        line++;
+    }
+
+    if (end - line < length || strncasecmp(line, keyword, length) != 0 || (line + length < end && isNameCharacter(line[length]))) {
+        return false;
+    }
+
+    *next = line + length;
+    return true;
+}
+
+// Skips raw lines up to the procedure's End Sub/Function/Property without copying or tokenizing them.
+long skipProcedureBody(const char *source, long length, long pos) {
+    while (pos < length) {
+        const char *line = &source[pos];
+        const char *newline = memchr(line, '\n', length - pos);
+        const char *end = (newline != NULL) ? newline : &source[length];
+        const char *next;
+
+        pos = (newline != NULL) ? newline - source + 1 : length;
+
+        if (isLineWord(line, end, &next, "End")
+            && (isLineWord(next, end, &next, "Sub") || isLineWord(next, end, &next, "Function") || isLineWord(next, end, &next, "Property"))) {
+            break;
+        }
+    }
+
+    return pos;
+}
+
+// Skips the designer block of a .frm/.ctl (VERSION, Begin ... End, Object = lines) before the first Attribute.
+long skipDesignerBlock(const char *source, long length) {
+    long pos = 0;
+    int depth = 0;
+
+    while (pos < length) {
+        const char *line = &source[pos];
+        const char *newline = memchr(line, '\n', length - pos);
+        const char *end = (newline != NULL) ? newline : &source[length];
+        const char *next;
+
+        if (depth == 0 && !isLineWord(line, end, &next, "VERSION") && !isLineWord(line, end, &next, "Object") && !isLineWord(line, end, &next, "Begin")) {
+            break;
+        }
+
+        if (isLineWord(line, end, &next, "Begin") || isLineWord(line, end, &next, "BeginProperty")) {
+            depth++;
+        }
+        else if (isLineWord(line, end, &next, "End") || isLineWord(line, end, &next, "EndProperty")) {
+            depth--;
+        }
+
+        pos = (newline != NULL) ? newline - source + 1 : length;
+    }
+
+    return pos;
+}
+
+// Header-only scan: module attributes, options, Implements and the public declarations, with no references
+// and no look at procedure bodies.
+ModuleScan *scanModuleHeader(const char *source, long length, bool isClass) {
+    ModuleScan *scan = buildModuleScan(isClass);
+
+    ScanState state = { 0 };
+    state.scan = scan;
+
+    int capacity = 256;
+    char *buffer = malloc(capacity);
+    long pos = skipDesignerBlock(source, length);
+
+    while (pos < length) {
+        readLogicalLine(source, length, &pos, &buffer, &capacity);
+
+        char *line = buffer;
+
+        while (*line == ' ') {
+            line++;
+        }
+
+        if (*line == '\0' || strncasecmp(line, "Rem ", 4) == 0) {
+            continue;
+        }
+
+        if (state.block == BLOCK_NONE) {
+            scanDeclarationLine(&state, line);
+        }
+        else {
+            scanBlockLine(&state, line);
+        }
+
+        if (state.block == BLOCK_PROCEDURE) {
+            pos = skipProcedureBody(source, length, pos);
+            state.block = BLOCK_NONE;
+        }
+    }
+
+    finishModuleScan(&state);
+
+    free(buffer);
+    return scan;
+}
+
+void freeModuleScan(ModuleScan *scan) {
+    for (int i = 0; i < scan->symbols->size; i++) {
+        ScannedSymbol *symbol = scan->symbols->contents[i];
+        free(symbol->name);
+        free(symbol->signature);
+        free(symbol);
+    }
+
+    for (int i = 0; i < scan->implements->size; i++) {
+        free(scan->implements->contents[i]);
+    }
+
+    free(scan->symbols->contents);
+    free(scan->symbols);
+    free(scan->implements->contents);
+    free(scan->implements);
+    free(scan->references);
+    free(scan->moduleName);
+    free(scan);
+}
+
+bool moduleScanReferences(const ModuleScan *scan, uint64_t nameHash) {
+    int low = 0;
+    int high = scan->referenceCount - 1;
+
+    while (low <= high) {
+        const int middle = (low + high) / 2;
+
+        if (scan->references[middle] == nameHash) {
+            return true;
+        }
+        else if (scan->references[middle] < nameHash) {
+            low = middle + 1;
+        }
+        else {
+            high = middle - 1;
+        }
+    }
+
+    return false;
+}
+
+const char *getSymbolKindName(int kind) {
+    switch (kind) {
+        case SYMBOL_MODULE: {
+            return "Module";
+        }
+        case SYMBOL_CLASS: {
+            return "Class";
+        }
+        case SYMBOL_SUB: {
+            return "Sub";
+        }
+        case SYMBOL_FUNCTION: {
+            return "Function";
+        }
+        case SYMBOL_PROPERTY: {
+            return "Property";
+        }
+        case SYMBOL_VARIABLE: {
+            return "Variable";
+        }
+        case SYMBOL_CONST: {
+            return "Const";
+        }
+        case SYMBOL_TYPE: {
+            return "Type";
+        }
+        case SYMBOL_ENUM: {
+            return "Enum";
+        }
+        case SYMBOL_ENUM_MEMBER: {
+            return "EnumMember";
+        }
+        case SYMBOL_DECLARE: {
+            return "Declare";
+        }
+        case SYMBOL_EVENT: {
+            return "Event";
+        }
+        default: {
+            return "Unknown";
+        }
+    }
+}
\ No newline at end of file
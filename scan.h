@@ -0,0 +1,53 @@
+#pragma once
+
+#include "util.h"
+
+enum SymbolKind {
+    SYMBOL_MODULE,
+    SYMBOL_CLASS,
+    SYMBOL_SUB,
+    SYMBOL_FUNCTION,
+    SYMBOL_PROPERTY,
+    SYMBOL_VARIABLE,
+    SYMBOL_CONST,
+    SYMBOL_TYPE,
+    SYMBOL_ENUM,
+    SYMBOL_ENUM_MEMBER,
+    SYMBOL_DECLARE,
+    SYMBOL_EVENT
+};
+
+enum ModuleOption {
+    MODULE_OPTION_EXPLICIT = 1,
+    MODULE_OPTION_COMPARE_TEXT = 2,
+    MODULE_OPTION_PRIVATE_MODULE = 4
+};
+
+typedef struct ScannedSymbol {
+    int kind;
+    char *name;
+    char *signature;
+    uint64_t nameHash;
+    uint64_t signatureHash;
+} ScannedSymbol;
+
+typedef struct ModuleScan {
+    char *moduleName;
+    bool isClass;
+    bool isCreatable;
+    bool isExposed;
+    bool isPredeclared;
+    int options;
+    int optionBase;
+    Vector *implements;
+    Vector *symbols;
+    int referenceCount;
+    uint64_t *references;
+} ModuleScan;
+
+ModuleScan *scanModule(const char *source, long length, bool isClass);
+ModuleScan *scanModuleHeader(const char *source, long length, bool isClass);
+long skipDesignerBlock(const char *source, long length);
+void freeModuleScan(ModuleScan *scan);
+bool moduleScanReferences(const ModuleScan *scan, uint64_t nameHash);
+const char *getSymbolKindName(int kind);
\ No newline at end of file
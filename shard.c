@@ -0,0 +1,541 @@
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "shard.h"
+
+typedef struct ShardContext {
+    const Project *project;
+    const ShardOptions *options;
+    TranspileResult *results;
+    TranspileResult **order;
+    ShardWorker *workers;
+    ShardMetrics *metrics;
+    int count;
+    int next;
+    int completed;
+    long remainingBytes;
+    int *retry;
+    int retryCount;
+} ShardContext;
+
+bool readFully(int fd, void *data, size_t length) {
+    char *p = data;
+
+    while (length > 0) {
+        const ssize_t count = read(fd, p, length);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (count <= 0) {
+            return false;
+        }
+
+        p += count;
+        length -= count;
+    }
+
+    return true;
+}
+
+bool writeFully(int fd, const void *data, size_t length) {
+    const char *p = data;
+
+    while (length > 0) {
+        const ssize_t count = write(fd, p, length);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (count <= 0) {
+            return false;
+        }
+
+        p += count;
+        length -= count;
+    }
+
+    return true;
+}
+
+void initializeShardOptions(ShardOptions *options, int processCount) {
+    options->processCount = (processCount > 0) ? processCount : 1;
+    options->memoryLimit = 0;
+}
+
+long getAddressSpaceSize() {
+    FILE *fp = fopen("/proc/self/statm", "r");
+    long pages = 0;
+
+    if (fp == NULL) {
+        return 0;
+    }
+
+    if (fscanf(fp, "%ld", &pages) != 1) {
+        pages = 0;
+    }
+
+    fclose(fp);
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+// The limit is on growth past what the worker inherited at fork; running into it crashes the worker, which gets restarted.
+void limitWorkerMemory(long memoryLimit) {
+    if (memoryLimit <= 0) {
+        return;
+    }
+
+    const rlim_t size = getAddressSpaceSize() + memoryLimit;
+    const struct rlimit limit = { size, size };
+
+    if (setrlimit(RLIMIT_AS, &limit) != 0) {
+        printf("error: could not limit worker memory.\n");
+    }
+}
+
+bool writeShardDiagnostics(int fd, const Vector *diagnostics) {
+    for (int i = 0; i < diagnostics->size; i++) {
+        const Diagnostic *diagnostic = diagnostics->contents[i];
+        const ShardDiagnostic header = { diagnostic->offset, diagnostic->severity, diagnostic->code, strlen(diagnostic->message) };
+
+        if (!writeFully(fd, &header, sizeof(header)) || !writeFully(fd, diagnostic->message, header.length)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool readShardDiagnostics(int fd, int fileIndex, int count) {
+    for (int i = 0; i < count; i++) {
+        ShardDiagnostic header;
+
+        if (!readFully(fd, &header, sizeof(header)) || header.length < 0) {
+            return false;
+        }
+
+        char *message = malloc(header.length + 1);
+
+        if (!readFully(fd, message, header.length)) {
+            free(message);
+            return false;
+        }
+
+        message[header.length] = '\0';
+        recordDiagnostic(fileIndex, header.offset, header.severity, header.code, message);
+        free(message);
+    }
+
+    return true;
+}
+
+void runShardWorker(TranspileResult *results, int slot, int requestPipe, int resultPipe, long memoryLimit) {
+    int shard[SHARD_MAX_FILES];
+    int count;
+
+    limitWorkerMemory(memoryLimit);
+
+    // whatever the coordinator had recorded before the fork is its own to report
+    int traceEventCount;
+    freeDiagnostics(collectDiagnostics());
+    free(takeTraceEvents(&traceEventCount));
+
+    while (readFully(requestPipe, &count, sizeof(count)) && count > 0 && count <= SHARD_MAX_FILES) {
+        if (!readFully(requestPipe, shard, sizeof(int) * count)) {
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            TranspileResult *result = &results[shard[i]];
+            transpileFile(result);
+
+            Vector *diagnostics = collectDiagnostics();
+            TraceEvent *traceEvents = takeTraceEvents(&traceEventCount);
+
+            ShardRecord record = {
+                .index = shard[i],
+                .succeeded = result->succeeded,
+                .abandoned = result->abandoned,
+                .outputWritten = result->outputWritten,
+                .tokenCount = result->tokenCount,
+                .declarationCount = result->declarationCount,
+                .variantCount = result->variantCount,
+                .narrowedVariantCount = result->narrowedVariantCount,
+                .diagnosticCount = diagnostics->size,
+                .traceEventCount = traceEventCount,
+                .emittedBytes = result->emittedBytes,
+                .nodeCount = result->nodeCount,
+                .startTime = result->startTime,
+                .endTime = result->endTime,
+                .readTime = result->readTime,
+                .lexTime = result->lexTime,
+                .parseTime = result->parseTime,
+                .emitTime = result->emitTime
+            };
+
+            if (!writeFully(resultPipe, &record, sizeof(record)) || !writeShardDiagnostics(resultPipe, diagnostics) || !writeFully(resultPipe, traceEvents, sizeof(TraceEvent) * traceEventCount)) {
+                _exit(1);
+            }
+
+            freeDiagnostics(diagnostics);
+            free(traceEvents);
+        }
+    }
+
+    _exit(0);
+}
+
+bool readShardTraceEvents(int fd, int slot, int count) {
+    if (count <= 0) {
+        return true;
+    }
+
+    TraceEvent *events = malloc(sizeof(TraceEvent) * count);
+    const bool succeeded = readFully(fd, events, sizeof(TraceEvent) * count);
+
+    if (succeeded) {
+        appendTraceEvents(events, count, 100 * (slot + 1));
+    }
+
+    free(events);
+    return succeeded;
+}
+
+bool spawnShardWorker(ShardContext *context, ShardWorker *worker) {
+    int request[2];
+    int result[2];
+
+    if (pipe(request) != 0) {
+        printf("error: could not create worker pipes.\n");
+        return false;
+    }
+
+    if (pipe(result) != 0) {
+        printf("error: could not create worker pipes.\n");
+        close(request[0]);
+        close(request[1]);
+        return false;
+    }
+
+    fflush(stdout);
+    const pid_t pid = fork();
+
+    if (pid < 0) {
+        printf("error: could not start worker process %d.\n", worker->slot);
+        close(request[0]);
+        close(request[1]);
+        close(result[0]);
+        close(result[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        // siblings must see EOF when the coordinator closes their pipes, so the child holds none of them
+        for (int i = 0; i < context->options->processCount; i++) {
+            if (context->workers[i].pid > 0) {
+                close(context->workers[i].requestPipe);
+                close(context->workers[i].resultPipe);
+            }
+        }
+
+        close(request[1]);
+        close(result[0]);
+        runShardWorker(context->results, worker->slot, request[0], result[1], context->options->memoryLimit);
+    }
+
+    close(request[0]);
+    close(result[1]);
+
+    worker->pid = pid;
+    worker->requestPipe = request[1];
+    worker->resultPipe = result[0];
+    worker->shardSize = 0;
+    worker->received = 0;
+    return true;
+}
+
+// Guided schedule: a shard is the next run of largest-first files up to a share of the bytes still unassigned,
+// so early shards are big and the tail is handed out in small pieces. Files left over by a crash go out one at a time.
+int takeShard(ShardContext *context, ShardWorker *worker) {
+    worker->shardSize = 0;
+    worker->received = 0;
+
+    if (context->retryCount > 0) {
+        worker->shard[worker->shardSize++] = context->retry[--context->retryCount];
+        return worker->shardSize;
+    }
+
+    long target = context->remainingBytes / (context->options->processCount * 4);
+    long bytes = 0;
+
+    if (target < SHARD_MIN_BYTES) {
+        target = SHARD_MIN_BYTES;
+    }
+
+    while (context->next < context->count && worker->shardSize < SHARD_MAX_FILES) {
+        const TranspileResult *result = context->order[context->next];
+        const long size = (result->file->size > 0) ? result->file->size : 0;
+
+        if (worker->shardSize > 0 && bytes + size > target) {
+            break;
+        }
+
+        worker->shard[worker->shardSize++] = result - context->results;
+        bytes += size;
+        context->next++;
+    }
+
+    context->remainingBytes -= bytes;
+
+    if (worker->shardSize > 0) {
+        context->metrics->shardCount++;
+    }
+
+    return worker->shardSize;
+}
+
+bool sendShard(const ShardWorker *worker) {
+    int message[SHARD_MAX_FILES + 1];
+    message[0] = worker->shardSize;
+    memcpy(&message[1], worker->shard, sizeof(int) * worker->shardSize);
+
+    return writeFully(worker->requestPipe, message, sizeof(int) * (worker->shardSize + 1));
+}
+
+void applyShardRecord(ShardContext *context, const ShardWorker *worker, const ShardRecord *record) {
+    TranspileResult *result = &context->results[record->index];
+
+    result->worker = worker->slot;
+    result->succeeded = record->succeeded;
+    result->abandoned = record->abandoned;
+    result->outputWritten = record->outputWritten;
+    result->tokenCount = record->tokenCount;
+    result->declarationCount = record->declarationCount;
+    result->variantCount = record->variantCount;
+    result->narrowedVariantCount = record->narrowedVariantCount;
+    result->emittedBytes = record->emittedBytes;
+    result->nodeCount = record->nodeCount;
+    result->startTime = record->startTime;
+    result->endTime = record->endTime;
+    result->readTime = record->readTime;
+    result->lexTime = record->lexTime;
+    result->parseTime = record->parseTime;
+    result->emitTime = record->emitTime;
+
+    context->completed++;
+}
+
+void describeExitStatus(int status, char *text, size_t size) {
+    if (WIFSIGNALED(status)) {
+        snprintf(text, size, "%s", strsignal(WTERMSIG(status)));
+    }
+    else {
+        snprintf(text, size, "exit status %d", WEXITSTATUS(status));
+    }
+}
+
+// The file in flight is charged with the crash; the rest of the shard is queued again.
+void handleWorkerExit(ShardContext *context, ShardWorker *worker) {
+    int status = 0;
+    char reason[64];
+
+    close(worker->requestPipe);
+    close(worker->resultPipe);
+    waitpid(worker->pid, &status, 0);
+    worker->pid = -1;
+
+    describeExitStatus(status, reason, sizeof(reason));
+
+    if (worker->received < worker->shardSize) {
+        TranspileResult *result = &context->results[worker->shard[worker->received]];
+
+        char message[128];
+        snprintf(message, sizeof(message), "worker %d died (%s)", worker->slot, reason);
+        recordDiagnostic(result - context->results, -1, DIAGNOSTIC_ERROR, DIAGNOSTIC_WORKER_CRASHED, message);
+
+        result->worker = worker->slot;
+        result->succeeded = false;
+        result->startTime = getCurrentTime();
+        result->endTime = result->startTime;
+        context->completed++;
+        context->metrics->crashCount++;
+
+        for (int i = worker->shardSize - 1; i > worker->received; i--) {
+            context->retry[context->retryCount++] = worker->shard[i];
+        }
+    }
+
+    worker->shardSize = 0;
+    worker->received = 0;
+
+    if (context->completed < context->count) {
+        if (spawnShardWorker(context, worker)) {
+            context->metrics->restartCount++;
+        }
+    }
+}
+
+void stopShardWorkers(ShardContext *context) {
+    for (int i = 0; i < context->options->processCount; i++) {
+        ShardWorker *worker = &context->workers[i];
+
+        if (worker->pid > 0) {
+            close(worker->requestPipe);
+            close(worker->resultPipe);
+            waitpid(worker->pid, NULL, 0);
+            worker->pid = -1;
+        }
+    }
+}
+
+TranspileResult *transpileProjectSharded(const Project *project, const ShardOptions *options, const bool *selection, TranspileSummary *summary, ShardMetrics *metrics) {
+    const int processCount = options->processCount;
+    ShardContext context = { 0 };
+    context.project = project;
+    context.options = options;
+    context.metrics = metrics;
+    context.results = buildTranspileResults(project, selection, &context.order, &context.count);
+    context.workers = calloc(processCount, sizeof(ShardWorker));
+    context.retry = malloc(sizeof(int) * (project->files->size + 1));
+
+    memset(metrics, 0, sizeof(ShardMetrics));
+    metrics->processCount = processCount;
+
+    for (int i = 0; i < context.count; i++) {
+        context.remainingBytes += (context.order[i]->file->size > 0) ? context.order[i]->file->size : 0;
+    }
+
+    // a worker that dies between shards shows up as a failed write, not a signal
+    signal(SIGPIPE, SIG_IGN);
+
+    const double startTime = getCurrentTime();
+    struct pollfd *fds = malloc(sizeof(struct pollfd) * processCount);
+    ShardWorker **polled = malloc(sizeof(ShardWorker*) * processCount);
+
+    for (int i = 0; i < processCount; i++) {
+        context.workers[i].slot = i;
+        context.workers[i].pid = -1;
+
+        if (!spawnShardWorker(&context, &context.workers[i])) {
+            break;
+        }
+    }
+
+    while (context.completed < context.count) {
+        int pollCount = 0;
+
+        for (int i = 0; i < processCount; i++) {
+            ShardWorker *worker = &context.workers[i];
+
+            if (worker->pid <= 0) {
+                continue;
+            }
+
+            if (worker->received == worker->shardSize && takeShard(&context, worker) > 0 && !sendShard(worker)) {
+                handleWorkerExit(&context, worker);
+                continue;
+            }
+
+            if (worker->received < worker->shardSize) {
+                fds[pollCount].fd = worker->resultPipe;
+                fds[pollCount].events = POLLIN;
+                polled[pollCount++] = worker;
+            }
+        }
+
+        if (pollCount == 0) {
+            printf("error: no worker processes left with %d files outstanding.\n", context.count - context.completed);
+            break;
+        }
+
+        if (poll(fds, pollCount, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            printf("error: could not wait for worker processes.\n");
+            break;
+        }
+
+        for (int i = 0; i < pollCount; i++) {
+            ShardWorker *worker = polled[i];
+            ShardRecord record;
+
+            if (fds[i].revents == 0) {
+                continue;
+            }
+
+            if ((fds[i].revents & POLLIN) && readFully(worker->resultPipe, &record, sizeof(record)) && readShardDiagnostics(worker->resultPipe, record.index, record.diagnosticCount) && readShardTraceEvents(worker->resultPipe, worker->slot, record.traceEventCount)) {
+                applyShardRecord(&context, worker, &record);
+                worker->received++;
+            }
+            else {
+                handleWorkerExit(&context, worker);
+            }
+        }
+    }
+
+    stopShardWorkers(&context);
+
+    const double endTime = getCurrentTime();
+    metrics->wallTime = endTime - startTime;
+
+    // results are indexed by file, so the summary does not depend on which process finished first
+    summarizeTranspileResults(context.results, project->files->size, startTime, endTime, summary);
+
+    free(fds);
+    free(polled);
+    free(context.retry);
+    free(context.workers);
+    free(context.order);
+
+    return context.results;
+}
+
+void printShardReport(const ShardMetrics *metrics) {
+    printf("processes: %d, shards: %d, crashes: %d, restarts: %d\n",
+        metrics->processCount,
+        metrics->shardCount,
+        metrics->crashCount,
+        metrics->restartCount);
+}
+
+void reportShardScaling(const Project *project, const ShardOptions *options, const bool *selection) {
+    double baselineTime = 0;
+
+    printf("%9s %10s %10s %10s %8s %10s\n", "processes", "wall(ms)", "files/s", "MB/s", "speedup", "efficiency");
+
+    for (int processCount = 1; processCount <= options->processCount; processCount++) {
+        ShardOptions scaled = *options;
+        ShardMetrics metrics;
+        TranspileSummary summary;
+        int traceEventCount;
+        scaled.processCount = processCount;
+
+        TranspileResult *results = transpileProjectSharded(project, &scaled, selection, &summary, &metrics);
+        const double wallTime = summary.wallTime;
+        const int fileCount = summary.fileCount - summary.skippedCount;
+
+        if (processCount == 1) {
+            baselineTime = wallTime;
+        }
+
+        printf("%9d %10.3f %10.1f %10.1f %7.2fx %9.1f%%\n",
+            processCount,
+            wallTime * 1e3,
+            (wallTime > 0) ? fileCount / wallTime : 0.0,
+            (wallTime > 0) ? summary.sourceBytes / wallTime / 1e6 : 0.0,
+            (wallTime > 0) ? baselineTime / wallTime : 0.0,
+            (wallTime > 0) ? 100.0 * baselineTime / wallTime / processCount : 0.0);
+
+        fflush(stdout);
+        freeDiagnostics(collectDiagnostics());
+        free(takeTraceEvents(&traceEventCount));
+        free(results);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include "diagnostics.h"
+#include "transpile.h"
+
+#define SHARD_MAX_FILES 64
+#define SHARD_MIN_BYTES (64 << 10)
+
+typedef struct ShardOptions {
+    int processCount;
+    long memoryLimit;
+} ShardOptions;
+
+// what a worker process sends back for each file; times are CLOCK_MONOTONIC and so comparable across processes
+typedef struct ShardRecord {
+    int index;
+    bool succeeded;
+    bool abandoned;
+    bool outputWritten;
+    int tokenCount;
+    int declarationCount;
+    int variantCount;
+    int narrowedVariantCount;
+    int diagnosticCount;
+    int traceEventCount;
+    long emittedBytes;
+    long nodeCount;
+    double startTime;
+    double endTime;
+    double readTime;
+    double lexTime;
+    double parseTime;
+    double emitTime;
+} ShardRecord;
+
+// followed on the pipe by the message bytes
+typedef struct ShardDiagnostic {
+    long offset;
+    int severity;
+    int code;
+    int length;
+} ShardDiagnostic;
+
+typedef struct ShardWorker {
+    int slot;
+    pid_t pid;
+    int requestPipe;
+    int resultPipe;
+    int shard[SHARD_MAX_FILES];
+    int shardSize;
+    int received;
+} ShardWorker;
+
+typedef struct ShardMetrics {
+    int processCount;
+    int shardCount;
+    int crashCount;
+    int restartCount;
+    double wallTime;
+} ShardMetrics;
+
+void initializeShardOptions(ShardOptions *options, int processCount);
+TranspileResult *transpileProjectSharded(const Project *project, const ShardOptions *options, const bool *selection, TranspileSummary *summary, ShardMetrics *metrics);
+void printShardReport(const ShardMetrics *metrics);
+void reportShardScaling(const Project *project, const ShardOptions *options, const bool *selection);
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "ssa.h"
+
+// Cooper, Harvey and Kennedy's iterative algorithm: intersect the processed predecessors'
+// dominator chains, walking by reverse postorder index, until nothing changes.
+void computeDominators(const ControlFlowGraph *graph, int *dominators) {
+    for (int i = 0; i < graph->blockCount; i++) {
+        dominators[i] = -1;
+    }
+
+    dominators[CFG_ENTRY] = CFG_ENTRY;
+
+    for (bool isChanged = true; isChanged;) {
+        isChanged = false;
+
+        for (int i = 1; i < graph->reachableCount; i++) {
+            const int block = graph->order[i];
+            const CfgBlock *node = &graph->blocks[block];
+            int dominator = -1;
+
+            for (int j = 0; j < node->predecessorCount; j++) {
+                int other = graph->predecessors[node->firstPredecessor + j].from;
+
+                if (dominators[other] < 0) {
+                    continue;
+                }
+
+                if (dominator < 0) {
+                    dominator = other;
+                    continue;
+                }
+
+                while (dominator != other) {
+                    while (graph->blocks[dominator].order > graph->blocks[other].order) {
+                        dominator = dominators[dominator];
+                    }
+
+                    while (graph->blocks[other].order > graph->blocks[dominator].order) {
+                        other = dominators[other];
+                    }
+                }
+            }
+
+            if (dominators[block] != dominator) {
+                dominators[block] = dominator;
+                isChanged = true;
+            }
+        }
+    }
+}
+
+// Groups (key, value) pairs by key into firstByKey/values, as a counting sort.
+void groupSsaPairs(const int *keys, const int *pairValues, int pairCount, int keyCount, int *firstByKey, int *values) {
+    memset(firstByKey, 0, sizeof(int) * (keyCount + 1));
+
+    for (int i = 0; i < pairCount; i++) {
+        firstByKey[keys[i] + 1]++;
+    }
+
+    for (int i = 0; i < keyCount; i++) {
+        firstByKey[i + 1] += firstByKey[i];
+    }
+
+    int *next = malloc(sizeof(int) * (keyCount + 1));
+    memcpy(next, firstByKey, sizeof(int) * (keyCount + 1));
+
+    for (int i = 0; i < pairCount; i++) {
+        values[next[keys[i]]++] = pairValues[i];
+    }
+
+    free(next);
+}
+
+// Dominance frontiers as (block, frontier block) pairs: each join point is in the frontier of
+// every block from its predecessors up to, but excluding, its immediate dominator.
+int collectFrontierPairs(const ControlFlowGraph *graph, const int *dominators, int **blocks, int **frontiers) {
+    int capacity = graph->edgeCount + 16, count = 0;
+    *blocks = malloc(sizeof(int) * capacity);
+    *frontiers = malloc(sizeof(int) * capacity);
+
+    for (int i = 0; i < graph->reachableCount; i++) {
+        const int block = graph->order[i];
+        const CfgBlock *node = &graph->blocks[block];
+
+        if (node->predecessorCount < 2) {
+            continue;
+        }
+
+        for (int j = 0; j < node->predecessorCount; j++) {
+            for (int runner = graph->predecessors[node->firstPredecessor + j].from; dominators[runner] >= 0 && runner != dominators[block];) {
+                if (count == capacity) {
+                    capacity *= 2;
+                    *blocks = realloc(*blocks, sizeof(int) * capacity);
+                    *frontiers = realloc(*frontiers, sizeof(int) * capacity);
+                }
+
+                (*blocks)[count] = runner;
+                (*frontiers)[count++] = block;
+
+                if (runner == CFG_ENTRY) {
+                    break;
+                }
+
+                runner = dominators[runner];
+            }
+        }
+    }
+
+    return count;
+}
+
+// Minimal phi placement: a variable needs a phi in the iterated dominance frontier of its definitions.
+// Returns the phis' blocks and variables in placement order.
+int placePhis(const ControlFlowGraph *graph, const int *dominators, int **phiBlocks, int **phiVariables) {
+    int *frontierBlocks, *frontierValues;
+    const int pairCount = collectFrontierPairs(graph, dominators, &frontierBlocks, &frontierValues);
+    int *firstFrontier = malloc(sizeof(int) * (graph->blockCount + 1));
+    int *frontiers = malloc(sizeof(int) * (pairCount + 1));
+
+    groupSsaPairs(frontierBlocks, frontierValues, pairCount, graph->blockCount, firstFrontier, frontiers);
+    free(frontierBlocks);
+    free(frontierValues);
+
+    int *definitionVariables = malloc(sizeof(int) * (graph->referenceCount + 1));
+    int *definitionBlocks = malloc(sizeof(int) * (graph->referenceCount + 1));
+    int definitionCount = 0;
+
+    for (int i = 0; i < graph->referenceCount; i++) {
+        const CfgReference *reference = &graph->references[i];
+        const int block = graph->instructions[reference->instruction].block;
+
+        if (reference->isDefinition && dominators[block] >= 0) {
+            definitionVariables[definitionCount] = reference->variable;
+            definitionBlocks[definitionCount++] = block;
+        }
+    }
+
+    int *firstDefinition = malloc(sizeof(int) * (graph->variableCount + 1));
+    int *definitions = malloc(sizeof(int) * (definitionCount + 1));
+
+    groupSsaPairs(definitionVariables, definitionBlocks, definitionCount, graph->variableCount, firstDefinition, definitions);
+    free(definitionVariables);
+    free(definitionBlocks);
+
+    // stamps hold variable + 1, so neither array needs clearing between variables
+    int *hasPhi = calloc(graph->blockCount, sizeof(int));
+    int *isQueued = calloc(graph->blockCount, sizeof(int));
+    int *worklist = malloc(sizeof(int) * (graph->blockCount + definitionCount + 1));
+    int capacity = 16, count = 0;
+
+    *phiBlocks = malloc(sizeof(int) * capacity);
+    *phiVariables = malloc(sizeof(int) * capacity);
+
+    for (int variable = 0; variable < graph->variableCount; variable++) {
+        const int stamp = variable + 1;
+        int top = 0;
+
+        for (int i = firstDefinition[variable]; i < firstDefinition[variable + 1]; i++) {
+            if (isQueued[definitions[i]] != stamp) {
+                isQueued[definitions[i]] = stamp;
+                worklist[top++] = definitions[i];
+            }
+        }
+
+        while (top > 0) {
+            const int block = worklist[--top];
+
+            for (int i = firstFrontier[block]; i < firstFrontier[block + 1]; i++) {
+                const int frontier = frontiers[i];
+
+                if (hasPhi[frontier] == stamp) {
+                    continue;
+                }
+
+                hasPhi[frontier] = stamp;
+
+                if (count == capacity) {
+                    capacity *= 2;
+                    *phiBlocks = realloc(*phiBlocks, sizeof(int) * capacity);
+                    *phiVariables = realloc(*phiVariables, sizeof(int) * capacity);
+                }
+
+                (*phiBlocks)[count] = frontier;
+                (*phiVariables)[count++] = variable;
+
+                if (isQueued[frontier] != stamp) {
+                    isQueued[frontier] = stamp;
+                    worklist[top++] = frontier;
+                }
+            }
+        }
+    }
+
+    free(firstFrontier);
+    free(frontiers);
+    free(firstDefinition);
+    free(definitions);
+    free(hasPhi);
+    free(isQueued);
+    free(worklist);
+
+    return count;
+}
+
+// Walks the dominator tree keeping each variable's current value; the undo log restores
+// the values a subtree overwrote once the walk leaves it.
+void renameSsaValues(ControlFlowGraph *graph, SsaForm *ssa) {
+    int *firstChild = malloc(sizeof(int) * (graph->blockCount + 1));
+    int *children = malloc(sizeof(int) * (graph->blockCount + 1));
+    int *parents = malloc(sizeof(int) * (graph->blockCount + 1));
+    int *childBlocks = malloc(sizeof(int) * (graph->blockCount + 1));
+    int childCount = 0;
+
+    for (int i = 1; i < graph->reachableCount; i++) {
+        parents[childCount] = ssa->dominators[graph->order[i]];
+        childBlocks[childCount++] = graph->order[i];
+    }
+
+    groupSsaPairs(parents, childBlocks, childCount, graph->blockCount, firstChild, children);
+    free(parents);
+    free(childBlocks);
+
+    int *current = malloc(sizeof(int) * (graph->variableCount + 1));
+    int *undoVariables = malloc(sizeof(int) * (graph->referenceCount + ssa->phiCount + 1));
+    int *undoValues = malloc(sizeof(int) * (graph->referenceCount + ssa->phiCount + 1));
+    int *stack = malloc(sizeof(int) * (graph->blockCount + 1));
+    int *stackMarks = malloc(sizeof(int) * (graph->blockCount + 1));
+    int *nextChild = malloc(sizeof(int) * (graph->blockCount + 1));
+    int undoCount = 0, top = 0;
+
+    for (int variable = 0; variable < graph->variableCount; variable++) {
+        current[variable] = variable;
+    }
+
+    stack[0] = CFG_ENTRY;
+
+    for (bool isEntering = true; top >= 0;) {
+        const int block = stack[top];
+
+        if (isEntering) {
+            const CfgBlock *node = &graph->blocks[block];
+
+            stackMarks[top] = undoCount;
+            nextChild[top] = firstChild[block];
+
+            for (int i = ssa->firstPhi[block]; i < ssa->firstPhi[block + 1]; i++) {
+                const SsaPhi *phi = &ssa->phis[i];
+
+                undoVariables[undoCount] = phi->variable;
+                undoValues[undoCount++] = current[phi->variable];
+                current[phi->variable] = phi->value;
+            }
+
+            for (int i = node->firstInstruction; i < node->firstInstruction + node->instructionCount; i++) {
+                const CfgInstruction *instruction = &graph->instructions[i];
+
+                for (int j = instruction->firstReference; j < instruction->firstReference + instruction->referenceCount; j++) {
+                    CfgReference *reference = &graph->references[j];
+
+                    if (!reference->isDefinition) {
+                        reference->value = current[reference->variable];
+                        continue;
+                    }
+
+                    reference->value = ssa->valueCount;
+                    ssa->values[ssa->valueCount++] = (SsaValue){ SSA_DEFINITION, reference->variable, block, j };
+                    undoVariables[undoCount] = reference->variable;
+                    undoValues[undoCount++] = current[reference->variable];
+                    current[reference->variable] = reference->value;
+                }
+            }
+
+            for (int i = node->firstSuccessor; i < node->firstSuccessor + node->successorCount; i++) {
+                const CfgEdge *edge = &graph->successors[i];
+                const int slot = edge->mate - graph->blocks[edge->to].firstPredecessor;
+
+                for (int j = ssa->firstPhi[edge->to]; j < ssa->firstPhi[edge->to + 1]; j++) {
+                    ssa->phis[j].operands[slot] = current[ssa->phis[j].variable];
+                }
+            }
+        }
+
+        if (nextChild[top] < firstChild[block + 1]) {
+            stack[top + 1] = children[nextChild[top]++];
+            top++;
+            isEntering = true;
+            continue;
+        }
+
+        while (undoCount > stackMarks[top]) {
+            undoCount--;
+            current[undoVariables[undoCount]] = undoValues[undoCount];
+        }
+
+        top--;
+        isEntering = false;
+    }
+
+    free(firstChild);
+    free(children);
+    free(current);
+    free(undoVariables);
+    free(undoValues);
+    free(stack);
+    free(stackMarks);
+    free(nextChild);
+}
+
+SsaForm *buildSsaForm(ControlFlowGraph *graph) {
+    SsaForm *ssa = allocateArena(graph->arena, sizeof(SsaForm));
+    ssa->dominators = allocateArena(graph->arena, sizeof(int) * (graph->blockCount + 1));
+    computeDominators(graph, ssa->dominators);
+
+    int *phiBlocks, *phiVariables;
+    ssa->phiCount = placePhis(graph, ssa->dominators, &phiBlocks, &phiVariables);
+
+    int *sortedPhis = malloc(sizeof(int) * (ssa->phiCount + 1));
+    int *phiIndices = malloc(sizeof(int) * (ssa->phiCount + 1));
+
+    for (int i = 0; i < ssa->phiCount; i++) {
+        phiIndices[i] = i;
+    }
+
+    ssa->firstPhi = allocateArena(graph->arena, sizeof(int) * (graph->blockCount + 1));
+    groupSsaPairs(phiBlocks, phiIndices, ssa->phiCount, graph->blockCount, ssa->firstPhi, sortedPhis);
+
+    int definitionCount = 0;
+
+    for (int i = 0; i < graph->referenceCount; i++) {
+        definitionCount += graph->references[i].isDefinition;
+    }
+
+    ssa->phis = allocateArena(graph->arena, sizeof(SsaPhi) * (ssa->phiCount + 1));
+    ssa->values = allocateArena(graph->arena, sizeof(SsaValue) * (graph->variableCount + ssa->phiCount + definitionCount + 1));
+
+    for (int variable = 0; variable < graph->variableCount; variable++) {
+        ssa->values[ssa->valueCount++] = (SsaValue){ SSA_ENTRY, variable, CFG_ENTRY, -1 };
+    }
+
+    for (int i = 0; i < ssa->phiCount; i++) {
+        const int block = phiBlocks[sortedPhis[i]];
+        SsaPhi *phi = &ssa->phis[i];
+
+        phi->value = ssa->valueCount;
+        phi->variable = phiVariables[sortedPhis[i]];
+        phi->block = block;
+        phi->operands = allocateArena(graph->arena, sizeof(int) * (graph->blocks[block].predecessorCount + 1));
+
+        for (int j = 0; j < graph->blocks[block].predecessorCount; j++) {
+            phi->operands[j] = -1;
+        }
+
+        ssa->values[ssa->valueCount++] = (SsaValue){ SSA_PHI, phi->variable, block, i };
+    }
+
+    free(phiBlocks);
+    free(phiVariables);
+    free(sortedPhis);
+    free(phiIndices);
+
+    renameSsaValues(graph, ssa);
+    return ssa;
+}
+
+// Built on first request into the graph's arena, so it goes away with the graph.
+const SsaForm *getSsaForm(ControlFlowGraph *graph) {
+    if (graph->ssa == NULL) {
+        graph->ssa = buildSsaForm(graph);
+    }
+
+    return graph->ssa;
+}
+
+bool dominatesBlock(const SsaForm *ssa, int dominator, int block) {
+    if (ssa->dominators[block] < 0 || ssa->dominators[dominator] < 0) {
+        return false;
+    }
+
+    while (block != dominator && block != CFG_ENTRY) {
+        block = ssa->dominators[block];
+    }
+
+    return block == dominator;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "cfg.h"
+
+enum SsaValueKind {
+    SSA_ENTRY,
+    SSA_DEFINITION,
+    SSA_PHI
+};
+
+// definition is the defining CfgReference for SSA_DEFINITION and the phi for SSA_PHI; values 0 to
+// variableCount - 1 are each variable's SSA_ENTRY value, the parameter or uninitialized local on entry
+typedef struct SsaValue {
+    int kind;
+    int variable;
+    int block;
+    int definition;
+} SsaValue;
+
+// operands line up with the block's predecessors; an unreachable predecessor's operand is -1
+typedef struct SsaPhi {
+    int value;
+    int variable;
+    int block;
+    int *operands;
+} SsaPhi;
+
+// dominators holds each block's immediate dominator (-1 if unreachable); a block's phis are
+// phis[firstPhi[block]] up to phis[firstPhi[block + 1]]
+typedef struct SsaForm {
+    int *dominators;
+    int *firstPhi;
+    SsaPhi *phis;
+    int phiCount;
+    SsaValue *values;
+    int valueCount;
+} SsaForm;
+
+const SsaForm *getSsaForm(ControlFlowGraph *graph);
+bool dominatesBlock(const SsaForm *ssa, int dominator, int block);
\ No newline at end of file
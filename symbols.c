@@ -0,0 +1,346 @@
+#include <strings.h>
+
+#include "decode.h"
+#include "symbols.h"
+
+typedef struct SymbolCollection {
+    const ProjectFile *file;
+    ModuleScan *scan;
+    long length;
+    double readTime;
+    double scanTime;
+} SymbolCollection;
+
+void collectModuleSymbols(void *argument) {
+    SymbolCollection *collection = argument;
+    const long traceStart = beginTrace();
+    const double startTime = getCurrentTime();
+    setDiagnosticFile(collection->file->index);
+    char *source = readFile(collection->file->path);
+
+    if (source == NULL) {
+        endTrace(traceStart, TRACE_PHASE, collection->file->index, "symbols");
+        return;
+    }
+
+    // names are indexed in the same UTF-8 form the lexer sees
+    source = decodeSource(source, strlen(source), collection->file->project->codePage, &collection->length);
+
+    const double scanStart = getCurrentTime();
+    collection->scan = scanModuleHeader(source, collection->length, collection->file->type != PROJECT_MODULE);
+    collection->readTime = scanStart - startTime;
+    collection->scanTime = getCurrentTime() - scanStart;
+    free(source);
+    endTrace(traceStart, TRACE_PHASE, collection->file->index, "symbols");
+}
+
+// scans the selected files' headers, or every file's without a selection
+SymbolCollection *collectProjectSymbols(const Project *project, ThreadPool *pool, const bool *selection) {
+    const int count = project->files->size;
+    SymbolCollection *collections = calloc(count + 1, sizeof(SymbolCollection));
+
+    for (int i = 0; i < count; i++) {
+        collections[i].file = getProjectFile(project, i);
+
+        if (selection == NULL || selection[i]) {
+            submitThreadPool(pool, collectModuleSymbols, &collections[i]);
+        }
+    }
+
+    waitThreadPool(pool);
+    return collections;
+}
+
+int appendSymbolString(SymbolIndex *index, const char *text) {
+    const int offset = index->stringSize;
+    const long length = strlen(text) + 1;
+
+    memcpy(&index->strings[offset], text, length);
+    index->stringSize += length;
+
+    return offset;
+}
+
+void insertSymbol(SymbolIndex *index, int kind, int fileIndex, const char *name, const char *signature) {
+    const int position = index->symbolCount++;
+    IndexedSymbol *symbol = &index->symbols[position];
+
+    symbol->nameHash = calculateNameHash(name, strlen(name));
+    symbol->kind = kind;
+    symbol->fileIndex = fileIndex;
+    symbol->nameOffset = appendSymbolString(index, name);
+    symbol->signatureOffset = appendSymbolString(index, signature);
+    symbol->next = -1;
+
+    if ((kind == SYMBOL_MODULE || kind == SYMBOL_CLASS) && fileIndex < index->fileCount) {
+        index->moduleSymbols[fileIndex] = position;
+    }
+
+    int slot = symbol->nameHash & index->slotMask;
+
+    while (index->slots[slot] >= 0) {
+        IndexedSymbol *head = &index->symbols[index->slots[slot]];
+
+        // symbols sharing a name hang off one slot, in project order
+        if (head->nameHash == symbol->nameHash && strcasecmp(&index->strings[head->nameOffset], name) == 0) {
+            while (head->next >= 0) {
+                head = &index->symbols[head->next];
+            }
+
+            head->next = position;
+            return;
+        }
+
+        slot = (slot + 1) & index->slotMask;
+    }
+
+    index->slots[slot] = position;
+}
+
+// Indexes what was collected. A file outside the selection keeps the symbols previous indexed for it,
+// which sit in previous in project order like everything else, so names shared across files stay chained
+// in project order.
+SymbolIndex *indexProjectSymbols(const Project *project, SymbolCollection *collections, const bool *selection, const SymbolIndex *previous) {
+    const int count = project->files->size;
+    int symbolCount = 0;
+    long stringSize = 0;
+
+    for (int i = 0; i < count; i++) {
+        const ModuleScan *scan = collections[i].scan;
+
+        // one extra entry for the module itself when it has no VB_Name attribute
+        symbolCount++;
+        stringSize += 2 * (strlen(collections[i].file->name) + 1);
+
+        for (int j = 0; scan != NULL && j < scan->symbols->size; j++) {
+            const ScannedSymbol *symbol = scan->symbols->contents[j];
+            stringSize += strlen(symbol->name) + strlen(symbol->signature) + 2;
+            symbolCount++;
+        }
+    }
+
+    for (int i = 0; previous != NULL && i < previous->symbolCount; i++) {
+        const IndexedSymbol *symbol = &previous->symbols[i];
+
+        if (symbol->fileIndex < count && !selection[symbol->fileIndex]) {
+            stringSize += strlen(getIndexedSymbolName(previous, symbol)) + strlen(getIndexedSymbolSignature(previous, symbol)) + 2;
+            symbolCount++;
+        }
+    }
+
+    int slotCount = 16;
+
+    while (slotCount < symbolCount * 2) {
+        slotCount *= 2;
+    }
+
+    SymbolIndex *index = calloc(1, sizeof(SymbolIndex));
+    index->fileCount = count;
+    index->moduleSymbols = malloc(sizeof(int) * (count + 1));
+    memset(index->moduleSymbols, -1, sizeof(int) * (count + 1));
+    index->symbols = malloc(sizeof(IndexedSymbol) * (symbolCount + 1));
+    index->slotMask = slotCount - 1;
+    index->slots = malloc(sizeof(int) * slotCount);
+    index->strings = malloc(stringSize + 1);
+    memset(index->slots, -1, sizeof(int) * slotCount);
+
+    int kept = 0;
+
+    for (int i = 0; i < count; i++) {
+        const ProjectFile *file = collections[i].file;
+        ModuleScan *scan = collections[i].scan;
+
+        if (previous != NULL && !selection[i]) {
+            while (kept < previous->symbolCount && previous->symbols[kept].fileIndex < i) {
+                kept++;
+            }
+
+            for (; kept < previous->symbolCount && previous->symbols[kept].fileIndex == i; kept++) {
+                const IndexedSymbol *symbol = &previous->symbols[kept];
+                insertSymbol(index, symbol->kind, i, getIndexedSymbolName(previous, symbol), getIndexedSymbolSignature(previous, symbol));
+            }
+
+            continue;
+        }
+
+        if (scan == NULL) {
+            continue;
+        }
+
+        for (int j = 0; j < scan->symbols->size; j++) {
+            const ScannedSymbol *symbol = scan->symbols->contents[j];
+            insertSymbol(index, symbol->kind, file->index, symbol->name, symbol->signature);
+        }
+
+        if (scan->moduleName == NULL) {
+            insertSymbol(index, (file->type == PROJECT_MODULE) ? SYMBOL_MODULE : SYMBOL_CLASS, file->index, file->name, file->name);
+        }
+
+        freeModuleScan(scan);
+    }
+
+    index->libraries = project->typeLibraries;
+
+    free(collections);
+    return index;
+}
+
+SymbolIndex *buildSymbolIndex(const Project *project, ThreadPool *pool) {
+    return indexProjectSymbols(project, collectProjectSymbols(project, pool, NULL), NULL, NULL);
+}
+
+// A new index for a project in which only the changed files were edited: their headers are scanned again
+// and every other file's symbols are copied from previous rather than read from disk.
+SymbolIndex *patchSymbolIndex(const SymbolIndex *previous, const Project *project, const bool *changed, ThreadPool *pool) {
+    return indexProjectSymbols(project, collectProjectSymbols(project, pool, changed), changed, previous);
+}
+
+void printModuleHeader(const ProjectFile *file, const ModuleScan *scan) {
+    int procedureCount = 0;
+
+    for (int i = 0; i < scan->symbols->size; i++) {
+        const ScannedSymbol *symbol = scan->symbols->contents[i];
+        procedureCount += (symbol->kind == SYMBOL_SUB || symbol->kind == SYMBOL_FUNCTION || symbol->kind == SYMBOL_PROPERTY);
+    }
+
+    printf("%-11s %-24s %c%c%c %c%c%c base=%d %5d %5d  ",
+        getProjectFileTypeName(file->type),
+        (scan->moduleName != NULL) ? scan->moduleName : file->name,
+        scan->isCreatable ? 'C' : '-',
+        scan->isExposed ? 'X' : '-',
+        scan->isPredeclared ? 'P' : '-',
+        (scan->options & MODULE_OPTION_EXPLICIT) ? 'E' : '-',
+        (scan->options & MODULE_OPTION_COMPARE_TEXT) ? 'T' : '-',
+        (scan->options & MODULE_OPTION_PRIVATE_MODULE) ? 'M' : '-',
+        scan->optionBase,
+        procedureCount,
+        scan->symbols->size);
+
+    for (int i = 0; i < scan->implements->size; i++) {
+        printf("%s%s", (i > 0) ? "," : "", (char*)scan->implements->contents[i]);
+    }
+
+    printf("\n");
+}
+
+// Index-only run: header scans of every file and where the time went.
+int reportProjectHeaders(const Project *project, ThreadPool *pool, bool perFile) {
+    const double startTime = getCurrentTime();
+    SymbolCollection *collections = collectProjectSymbols(project, pool, NULL);
+    const double wallTime = getCurrentTime() - startTime;
+    double readTime = 0, scanTime = 0;
+    long bytes = 0;
+    int failureCount = 0;
+
+    if (perFile) {
+        printf("%-11s %-24s %-3s %-3s %-6s %5s %5s  %s\n", "type", "name", "cxp", "etm", "option", "procs", "syms", "implements");
+    }
+
+    for (int i = 0; i < project->files->size; i++) {
+        SymbolCollection *collection = &collections[i];
+
+        if (collection->scan == NULL) {
+            printf("error: could not read \"%s\".\n", collection->file->path);
+            failureCount++;
+            continue;
+        }
+
+        if (perFile) {
+            printModuleHeader(collection->file, collection->scan);
+        }
+
+        readTime += collection->readTime;
+        scanTime += collection->scanTime;
+        bytes += collection->length;
+        freeModuleScan(collection->scan);
+    }
+
+    printf("indexed %d files, %ld bytes in %.3f ms (%.1f MB/s); read+decode %.3f ms, scan %.3f ms\n",
+        project->files->size - failureCount,
+        bytes,
+        wallTime * 1e3,
+        (wallTime > 0) ? bytes / wallTime / 1e6 : 0.0,
+        readTime * 1e3,
+        scanTime * 1e3);
+
+    free(collections);
+    return (failureCount == 0) ? 0 : 1;
+}
+
+void freeSymbolIndex(SymbolIndex *index) {
+    free(index->moduleSymbols);
+    free(index->symbols);
+    free(index->slots);
+    free(index->strings);
+    free(index);
+}
+
+const IndexedSymbol *findSymbol(const SymbolIndex *index, const char *name) {
+    const uint64_t nameHash = calculateNameHash(name, strlen(name));
+    int slot = nameHash & index->slotMask;
+
+    while (index->slots[slot] >= 0) {
+        const IndexedSymbol *symbol = &index->symbols[index->slots[slot]];
+
+        if (symbol->nameHash == nameHash && strcasecmp(&index->strings[symbol->nameOffset], name) == 0) {
+            return symbol;
+        }
+
+        slot = (slot + 1) & index->slotMask;
+    }
+
+    return NULL;
+}
+
+const IndexedSymbol *findSymbolOfKind(const SymbolIndex *index, const char *name, int kind) {
+    const IndexedSymbol *symbol = findSymbol(index, name);
+
+    while (symbol != NULL && symbol->kind != kind) {
+        symbol = getNextSymbol(index, symbol);
+    }
+
+    return symbol;
+}
+
+// The name C# knows the file's class by: its VB_Name attribute where it has one, as VB itself uses, or else the
+// file name. index may be NULL when there is no project to consult.
+const char *getModuleName(const SymbolIndex *index, const ProjectFile *file) {
+    if (index == NULL || file->index >= index->fileCount || index->moduleSymbols[file->index] < 0) {
+        return file->name;
+    }
+
+    return getIndexedSymbolName(index, &index->symbols[index->moduleSymbols[file->index]]);
+}
+
+const IndexedSymbol *getNextSymbol(const SymbolIndex *index, const IndexedSymbol *symbol) {
+    return (symbol->next >= 0) ? &index->symbols[symbol->next] : NULL;
+}
+
+const char *getIndexedSymbolName(const SymbolIndex *index, const IndexedSymbol *symbol) {
+    return &index->strings[symbol->nameOffset];
+}
+
+const char *getIndexedSymbolSignature(const SymbolIndex *index, const IndexedSymbol *symbol) {
+    return &index->strings[symbol->signatureOffset];
+}
+
+bool isTypeSymbol(const IndexedSymbol *symbol) {
+    return (symbol->kind == SYMBOL_CLASS || symbol->kind == SYMBOL_TYPE || symbol->kind == SYMBOL_ENUM);
+}
+
+// referenced libraries are searched in .vbp order, as VB does
+const LibraryType *findReferencedType(const SymbolIndex *index, const char *name, const TypeLibrary **library) {
+    for (int i = 0; index->libraries != NULL && i < index->libraries->size; i++) {
+        const LibraryType *type = findLibraryType(index->libraries->contents[i], name);
+
+        if (type != NULL) {
+            if (library != NULL) {
+                *library = index->libraries->contents[i];
+            }
+
+            return type;
+        }
+    }
+
+    return NULL;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "project.h"
+#include "scan.h"
+#include "threadpool.h"
+#include "trace.h"
+#include "typelib.h"
+
+typedef struct IndexedSymbol {
+    uint64_t nameHash;
+    int kind;
+    int fileIndex;
+    int nameOffset;
+    int signatureOffset;
+    int next;
+} IndexedSymbol;
+
+// built once per project and never written again, so workers share it without locks. moduleSymbols holds,
+// for each of the fileCount files, the position of the symbol naming its module or class, or -1.
+typedef struct SymbolIndex {
+    int fileCount;
+    int *moduleSymbols;
+    int symbolCount;
+    IndexedSymbol *symbols;
+    int slotMask;
+    int *slots;
+    long stringSize;
+    char *strings;
+    const Vector *libraries;
+} SymbolIndex;
+
+SymbolIndex *buildSymbolIndex(const Project *project, ThreadPool *pool);
+SymbolIndex *patchSymbolIndex(const SymbolIndex *previous, const Project *project, const bool *changed, ThreadPool *pool);
+void freeSymbolIndex(SymbolIndex *index);
+int reportProjectHeaders(const Project *project, ThreadPool *pool, bool perFile);
+const IndexedSymbol *findSymbol(const SymbolIndex *index, const char *name);
+const IndexedSymbol *findSymbolOfKind(const SymbolIndex *index, const char *name, int kind);
+const IndexedSymbol *getNextSymbol(const SymbolIndex *index, const IndexedSymbol *symbol);
+const char *getIndexedSymbolName(const SymbolIndex *index, const IndexedSymbol *symbol);
+const char *getIndexedSymbolSignature(const SymbolIndex *index, const IndexedSymbol *symbol);
+bool isTypeSymbol(const IndexedSymbol *symbol);
+const char *getModuleName(const SymbolIndex *index, const ProjectFile *file);
+const LibraryType *findReferencedType(const SymbolIndex *index, const char *name, const TypeLibrary **library);
\ No newline at end of file
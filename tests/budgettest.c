@@ -0,0 +1,147 @@
+#include "../transpile.h"
+#include "check.h"
+
+// One long module in a scratch directory, which a small budget runs out on partway through.
+static char directory[] = "/tmp/budgettestXXXXXX";
+
+#define FUNCTION_COUNT 200
+
+char *buildLongSource() {
+    const int lineSize = 128;
+    char *source = malloc(FUNCTION_COUNT * lineSize);
+    int length = 0;
+
+    for (int i = 0; i < FUNCTION_COUNT; i++) {
+        length += snprintf(&source[length], lineSize, "Public Function Step%d(n As Long) As Long\n    Step%d = n + %d\nEnd Function\n", i, i, i);
+    }
+
+    return source;
+}
+
+int countDiagnostics(const Vector *diagnostics, int code) {
+    int count = 0;
+
+    for (int i = 0; i < diagnostics->size; i++) {
+        count += (((const Diagnostic *)diagnostics->contents[i])->code == code);
+    }
+
+    return count;
+}
+
+// the bytes lexing the source charges, which the budgets below are set against
+long measureLexing(const char *source) {
+    char *copy = strdup(source);
+    Budget budget;
+
+    initializeBudget(&budget, 0, 0);
+    beginBudget(&budget);
+    freeTokens(lex(copy));
+    endBudget(&budget);
+    free(copy);
+
+    return budget.memoryUsed;
+}
+
+void testLexerBudget(const char *source) {
+    char *copy = strdup(source);
+    Budget budget;
+
+    initializeBudget(&budget, 0, 4096);
+    beginBudget(&budget);
+    Vector *tokens = lex(copy);
+    endBudget(&budget);
+
+    CHECK(tokens == NULL);
+    CHECK(budget.status == BUDGET_MEMORY_EXCEEDED);
+    free(copy);
+}
+
+// a parse cut short by the budget fails without blaming the source for the statements it could not finish
+void testParserBudget(const char *source) {
+    char *copy = strdup(source);
+    Vector *tokens = lex(copy);
+    Budget budget;
+
+    freeDiagnostics(collectDiagnostics());
+    initializeBudget(&budget, 0, 4096);
+    beginBudget(&budget);
+    TransUnitNode *transUnitNode = parse(tokens);
+    endBudget(&budget);
+    Vector *diagnostics = collectDiagnostics();
+
+    CHECK(transUnitNode == NULL);
+    CHECK(budget.status == BUDGET_MEMORY_EXCEEDED);
+    CHECK(diagnostics->size == 0);
+    freeDiagnostics(diagnostics);
+
+    // with room to finish, the same tokens parse
+    transUnitNode = parse(tokens);
+    CHECK(transUnitNode != NULL);
+
+    freeTransUnitNode(transUnitNode);
+    freeTokens(tokens);
+    free(copy);
+}
+
+// a file abandoned in either stage, the lexer's at half what lexing takes and the parser's just past it, gets
+// one diagnostic that says so and no other, and the rest of the batch carries on
+void testAbandonedFiles(const char *source, long lexingBytes) {
+    char paths[2][256];
+    char *files[2] = { paths[0], paths[1] };
+    const long limits[2] = { lexingBytes / 2, lexingBytes + 4096 };
+
+    snprintf(paths[0], sizeof(paths[0]), "%s/Long.bas", directory);
+    snprintf(paths[1], sizeof(paths[1]), "%s/Short.bas", directory);
+
+    FILE *fp = fopen(paths[0], "w");
+    fputs(source, fp);
+    fclose(fp);
+
+    fp = fopen(paths[1], "w");
+    fputs("Public Sub Main()\nEnd Sub\n", fp);
+    fclose(fp);
+
+    for (int i = 0; i < 2; i++) {
+        ThreadPool *pool = buildThreadPool(1);
+        Project *project = buildProjectFromFiles(files, 2);
+        TranspileSummary summary;
+
+        project->outputDirectory = directory;
+        project->fileMemoryLimit = limits[i];
+        freeDiagnostics(collectDiagnostics());
+        TranspileResult *results = transpileProject(project, pool, NULL, &summary);
+        Vector *diagnostics = collectDiagnostics();
+
+        CHECK(summary.abandonedCount == 1 && summary.failureCount == 1);
+        CHECK(results[0].abandoned && results[1].succeeded);
+        CHECK(diagnostics->size == 1 && countDiagnostics(diagnostics, DIAGNOSTIC_BUDGET_EXCEEDED) == 1);
+
+        freeDiagnostics(diagnostics);
+        free(results);
+        freeThreadPool(pool);
+    }
+}
+
+int main() {
+    if (mkdtemp(directory) == NULL) {
+        printf("error: could not create a scratch directory.\n");
+        return 1;
+    }
+
+    char *source = buildLongSource();
+    const long lexingBytes = measureLexing(source);
+
+    testLexerBudget(source);
+    testParserBudget(source);
+    testAbandonedFiles(source, lexingBytes);
+    free(source);
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        printf("warning: could not remove \"%s\".\n", directory);
+    }
+
+    return finishChecks("budgettest");
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "../buildstate.h"
+#include "../directive.h"
+#include "check.h"
+
+// Three modules in a scratch directory: Shapes defines Area, Report calls it and Clock stands alone.
+static char directory[] = "/tmp/buildstatetestXXXXXX";
+
+void writeModule(const char *name, const char *source) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+
+    FILE *fp = fopen(path, "w");
+    fputs(source, fp);
+    fclose(fp);
+}
+
+Project *buildTestProject() {
+    char paths[3][256];
+    char *files[3] = { paths[0], paths[1], paths[2] };
+    snprintf(paths[0], sizeof(paths[0]), "%s/Shapes.bas", directory);
+    snprintf(paths[1], sizeof(paths[1]), "%s/Report.bas", directory);
+    snprintf(paths[2], sizeof(paths[2]), "%s/Clock.bas", directory);
+
+    return buildProjectFromFiles(files, 3);
+}
+
+// plans against the previous state and replaces it with the state a fully successful build would leave
+RebuildPlan *planNext(const Project *project, BuildState **state, ThreadPool *pool) {
+    RebuildPlan *plan = planRebuild(project, *state, pool);
+    bool succeeded[3] = { true, true, true };
+
+    if (*state != NULL) {
+        freeBuildState(*state);
+    }
+
+    *state = makeNextBuildState(plan, succeeded);
+    return plan;
+}
+
+void checkPlan(RebuildPlan *plan, int shapes, int report, int clock) {
+    CHECK(plan->status[0] == shapes);
+    CHECK(plan->status[1] == report);
+    CHECK(plan->status[2] == clock);
+    freeRebuildPlan(plan);
+}
+
+void testPropagation(ThreadPool *pool) {
+    writeModule("Shapes.bas", "Public Function Area(w As Long) As Long\n    Area = w * w\nEnd Function\n");
+    writeModule("Report.bas", "Public Sub Show()\n    Debug.Print Area(2)\nEnd Sub\n");
+    writeModule("Clock.bas", "Public Function Ticks() As Long\n    Ticks = 1\nEnd Function\n");
+
+    Project *project = buildTestProject();
+    BuildState *state = NULL;
+
+    checkPlan(planNext(project, &state, pool), MODULE_DIRTY, MODULE_DIRTY, MODULE_DIRTY);
+    checkPlan(planNext(project, &state, pool), MODULE_CLEAN, MODULE_CLEAN, MODULE_CLEAN);
+
+    // a new body keeps the signature, so only the module itself is rebuilt
+    writeModule("Shapes.bas", "Public Function Area(w As Long) As Long\n    Area = w * w * 1\nEnd Function\n");
+    checkPlan(planNext(project, &state, pool), MODULE_DIRTY, MODULE_CLEAN, MODULE_CLEAN);
+
+    // a new signature reaches the modules that reference the name
+    writeModule("Shapes.bas", "Public Function Area(w As Double) As Double\n    Area = w * w\nEnd Function\n");
+    checkPlan(planNext(project, &state, pool), MODULE_DIRTY, MODULE_DEPENDENT, MODULE_CLEAN);
+
+    // and so does the name disappearing
+    writeModule("Shapes.bas", "Public Function Volume(w As Double) As Double\n    Volume = w * w * w\nEnd Function\n");
+    checkPlan(planNext(project, &state, pool), MODULE_DIRTY, MODULE_DEPENDENT, MODULE_CLEAN);
+
+    freeBuildState(state);
+}
+
+void testOptions(ThreadPool *pool) {
+    Project *project = buildTestProject();
+    BuildState *state = NULL;
+    char path[256];
+    snprintf(path, sizeof(path), "%s/state", directory);
+
+    freeRebuildPlan(planNext(project, &state, pool));
+    CHECK(writeBuildState(path, state));
+    freeBuildState(state);
+
+    // the options hash survives the round trip through the state file
+    state = readBuildState(path);
+    CHECK(state != NULL && state->optionsHash == calculateOptionsHash(project));
+    checkPlan(planNext(project, &state, pool), MODULE_CLEAN, MODULE_CLEAN, MODULE_CLEAN);
+
+    // a -D define changes every module's output, whichever modules use it
+    parseConditionalDefine(project->defines, "DEBUG=1");
+    checkPlan(planNext(project, &state, pool), MODULE_DIRTY, MODULE_DIRTY, MODULE_DIRTY);
+    checkPlan(planNext(project, &state, pool), MODULE_CLEAN, MODULE_CLEAN, MODULE_CLEAN);
+
+    project->codePage = 932;
+    checkPlan(planNext(project, &state, pool), MODULE_DIRTY, MODULE_DIRTY, MODULE_DIRTY);
+
+    freeBuildState(state);
+}
+
+int main() {
+    ThreadPool *pool = buildThreadPool(2);
+
+    if (mkdtemp(directory) == NULL) {
+        printf("error: could not create a scratch directory.\n");
+        return 1;
+    }
+
+    testPropagation(pool);
+    testOptions(pool);
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        printf("warning: could not remove \"%s\".\n", directory);
+    }
+
+    freeThreadPool(pool);
+
+    return finishChecks("buildstatetest");
+}
\ No newline at end of file
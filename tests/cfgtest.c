@@ -0,0 +1,156 @@
+#include "../ssa.h"
+#include "check.h"
+#include "source.h"
+
+const char *const branchSource =
+    "Function Pick(ByVal c As Boolean) As Long\n"
+    "    Dim x\n"
+    "    If c Then\n"
+    "        x = 1\n"
+    "    Else\n"
+    "        x = 2\n"
+    "    End If\n"
+    "    Pick = x\n"
+    "End Function\n";
+
+const char *const nestedLoopSource =
+    "Sub Nest()\n"
+    "    Dim i As Long, j As Long\n"
+    "    For i = 1 To 3\n"
+    "        Do While j < 5\n"
+    "            If j = 2 Then Exit For\n"
+    "            j = j + 1\n"
+    "        Loop\n"
+    "    Next i\n"
+    "End Sub\n"
+    "\n"
+    "Sub Halt()\n"
+    "    Stop\n"
+    "    Halt\n"
+    "End Sub\n";
+
+// the block block reaches along its first edge of kind, or -1
+int findSuccessor(const ControlFlowGraph *graph, int block, int kind) {
+    for (int i = 0; i < graph->blocks[block].successorCount; i++) {
+        const CfgEdge *edge = &graph->successors[graph->blocks[block].firstSuccessor + i];
+
+        if (edge->kind == kind) {
+            return edge->to;
+        }
+    }
+
+    return -1;
+}
+
+// the single block that jumps somewhere, as Exit does, or -1
+int findJumpingBlock(const ControlFlowGraph *graph) {
+    int found = -1;
+
+    for (int block = 0; block < graph->blockCount; block++) {
+        if (graph->blocks[block].order >= 0 && findSuccessor(graph, block, EDGE_JUMP) >= 0) {
+            found = (found < 0) ? block : -2;
+        }
+    }
+
+    return found;
+}
+
+bool hasPhi(const ControlFlowGraph *graph, const SsaForm *ssa, int block, const char *name) {
+    for (int i = ssa->firstPhi[block]; i < ssa->firstPhi[block + 1]; i++) {
+        if (strcasecmp(graph->variables[ssa->phis[i].variable].name, name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void testBranchShape() {
+    TransUnitNode *transUnitNode = parseSource(branchSource);
+    ControlFlowGraph *graph = getControlFlowGraph(findProcedure(transUnitNode, "Pick"));
+    const SsaForm *ssa = getSsaForm(graph);
+    const int thenBlock = findSuccessor(graph, CFG_ENTRY, EDGE_TRUE);
+    const int elseBlock = findSuccessor(graph, CFG_ENTRY, EDGE_FALSE);
+    const int join = findSuccessor(graph, thenBlock, EDGE_FALLTHROUGH);
+
+    CHECK(thenBlock >= 0 && elseBlock >= 0 && thenBlock != elseBlock);
+    CHECK(join >= 0 && findSuccessor(graph, elseBlock, EDGE_FALLTHROUGH) == join);
+    CHECK(graph->blocks[join].predecessorCount == 2);
+    CHECK(findSuccessor(graph, join, EDGE_FALLTHROUGH) == CFG_EXIT);
+
+    // neither arm dominates the join, so its immediate dominator is the branch
+    CHECK(ssa->dominators[thenBlock] == CFG_ENTRY);
+    CHECK(ssa->dominators[elseBlock] == CFG_ENTRY);
+    CHECK(ssa->dominators[join] == CFG_ENTRY);
+    CHECK(ssa->dominators[CFG_EXIT] == join);
+    CHECK(!dominatesBlock(ssa, thenBlock, join));
+
+    // x has a definition on each arm and meets at the join; nothing else does
+    CHECK(hasPhi(graph, ssa, join, "x"));
+    CHECK(ssa->phiCount == 1);
+
+    freeTransUnitNode(transUnitNode);
+}
+
+void testNestedLoopShape() {
+    TransUnitNode *transUnitNode = parseSource(nestedLoopSource);
+    ControlFlowGraph *graph = getControlFlowGraph(findProcedure(transUnitNode, "Nest"));
+    const SsaForm *ssa = getSsaForm(graph);
+    const int forHeader = findSuccessor(graph, CFG_ENTRY, EDGE_FALLTHROUGH);
+    const int forExit = findSuccessor(graph, forHeader, EDGE_FALSE);
+    const int exitFor = findJumpingBlock(graph);
+
+    CHECK(forHeader >= 0 && forExit >= 0);
+
+    // Exit For leaves both loops at once, for the block after the For rather than the one after the Do
+    CHECK(exitFor >= 0 && findSuccessor(graph, exitFor, EDGE_JUMP) == forExit);
+    CHECK(graph->blocks[forExit].predecessorCount == 2);
+    CHECK(dominatesBlock(ssa, forHeader, exitFor));
+    CHECK(ssa->dominators[forExit] == forHeader);
+
+    // i and j both change in the loop, so both meet at its header; j also at the exit the jump reaches
+    CHECK(hasPhi(graph, ssa, forHeader, "i"));
+    CHECK(hasPhi(graph, ssa, forHeader, "j"));
+    CHECK(hasPhi(graph, ssa, forExit, "j"));
+    CHECK(!hasPhi(graph, ssa, forExit, "i"));
+
+    // Stop pauses and carries on, so the recursive call after it is still reachable
+    ControlFlowGraph *halt = getControlFlowGraph(findProcedure(transUnitNode, "Halt"));
+    CHECK(halt->reachableCount == 2);
+    CHECK(findSuccessor(halt, CFG_ENTRY, EDGE_FALLTHROUGH) == CFG_EXIT);
+
+    freeTransUnitNode(transUnitNode);
+}
+
+void testExitLowering() {
+    char *text = emitSource(nestedLoopSource);
+
+    CHECK_CONTAINS(text,
+        "            for (i = 1; i <= 3; i++)\n"
+        "            {\n"
+        "                while (j < 5)\n"
+        "                {\n"
+        "                    if (j == 2)\n"
+        "                    {\n"
+        "                        goto _exit1;\n"
+        "                    }\n"
+        "                    j = j + 1;\n"
+        "                }\n"
+        "            }\n"
+        "            _exit1:\n"
+        "            ;\n");
+    CHECK_CONTAINS(text,
+        "        public static void Halt()\n"
+        "        {\n"
+        "            System.Diagnostics.Debugger.Break();\n");
+
+    free(text);
+}
+
+int main() {
+    testBranchShape();
+    testNestedLoopShape();
+    testExitLowering();
+
+    return finishChecks("cfgtest");
+}
\ No newline at end of file
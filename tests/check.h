@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+// Each test program is one translation unit: checks count their failures and keep going, so one run lists
+// every broken expectation, and main returns finishChecks so make test stops on the first failing program.
+static int checkCount;
+static int checkFailureCount;
+
+#define CHECK(condition) do { \
+    checkCount++; \
+    if (!(condition)) { \
+        checkFailureCount++; \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+    } \
+} while (0)
+
+#define CHECK_STRING(actual, expected) do { \
+    const char *checkActual = (actual); \
+    const char *checkExpected = (expected); \
+    checkCount++; \
+    if (checkActual == NULL || strcmp(checkActual, checkExpected) != 0) { \
+        checkFailureCount++; \
+        printf("%s:%d: check failed: %s\n--- expected\n%s\n--- actual\n%s\n", __FILE__, __LINE__, #actual, checkExpected, (checkActual != NULL) ? checkActual : "(null)"); \
+    } \
+} while (0)
+
+#define CHECK_CONTAINS(text, part) do { \
+    const char *checkText = (text); \
+    const char *checkPart = (part); \
+    checkCount++; \
+    if (checkText == NULL || strstr(checkText, checkPart) == NULL) { \
+        checkFailureCount++; \
+        printf("%s:%d: check failed: %s\n--- expected to contain\n%s\n--- actual\n%s\n", __FILE__, __LINE__, #text, checkPart, (checkText != NULL) ? checkText : "(null)"); \
+    } \
+} while (0)
+
+static inline int finishChecks(const char *name) {
+    printf("%s: %d checks, %d failed\n", name, checkCount, checkFailureCount);
+    return (checkFailureCount > 0) ? 1 : 0;
+}
\ No newline at end of file
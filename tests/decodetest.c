@@ -0,0 +1,58 @@
+#include "../decode.h"
+#include "check.h"
+
+// decodes a copy of source, as the transpiler does a file it has read
+char *decodeCopy(const char *source, int codePage, long *decodedLength) {
+    return decodeSource(strdup(source), strlen(source), codePage, decodedLength);
+}
+
+void testUtf8Detection() {
+    long length = 0;
+    char *text = decodeCopy("s = \"caf\xC3\xA9 \xE2\x82\xAC\"", CODE_PAGE_WESTERN, &length);
+    CHECK_STRING(text, "s = \"caf\xC3\xA9 \xE2\x82\xAC\"");
+    CHECK(length == 15);
+    free(text);
+
+    // the byte order mark goes, and the text after it is not decoded again
+    text = decodeCopy("\xEF\xBB\xBFs = \"\xC3\xA9\"", CODE_PAGE_WESTERN, &length);
+    CHECK_STRING(text, "s = \"\xC3\xA9\"");
+    CHECK(length == 8);
+    free(text);
+
+    text = decodeCopy("\xEF\xBB\xBFx", CODE_PAGE_WESTERN, &length);
+    CHECK_STRING(text, "x");
+    free(text);
+}
+
+void testCodePageFallback() {
+    long length = 0;
+
+    // a lone 0xE9 is Windows-1252 e-acute, not the start of a UTF-8 sequence
+    char *text = decodeCopy("s = \"caf\xE9\"", CODE_PAGE_WESTERN, &length);
+    CHECK_STRING(text, "s = \"caf\xC3\xA9\"");
+    free(text);
+
+    // 0x80 is the euro sign there, and a trail byte with no lead in UTF-8
+    text = decodeCopy("\x80 1", CODE_PAGE_WESTERN, &length);
+    CHECK_STRING(text, "\xE2\x82\xAC 1");
+    free(text);
+}
+
+void testInvalidUtf8() {
+    CHECK(isValidUtf8("abc", 3));
+    CHECK(isValidUtf8("\xF0\x9F\x98\x80", 4));
+    CHECK(!isValidUtf8("\xC0\xAF", 2));
+    CHECK(!isValidUtf8("\xE0\x80\xAF", 3));
+    CHECK(!isValidUtf8("\xED\xA0\x80", 3));
+    CHECK(!isValidUtf8("\xF4\x90\x80\x80", 4));
+    CHECK(!isValidUtf8("\xE2\x82", 2));
+    CHECK(!isValidUtf8("\xE2\x28\xA1", 3));
+}
+
+int main() {
+    testUtf8Detection();
+    testCodePageFallback();
+    testInvalidUtf8();
+
+    return finishChecks("decodetest");
+}
\ No newline at end of file
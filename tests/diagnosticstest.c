@@ -0,0 +1,151 @@
+#include <unistd.h>
+
+#include "../diagnostics.h"
+#include "../threadpool.h"
+#include "check.h"
+
+// One module in a scratch directory, for printing diagnostics against; stdout is captured in a file there.
+static char directory[] = "/tmp/diagnosticstestXXXXXX";
+
+#define FILE_COUNT 8
+
+// each file's diagnostics are reported out of order, from whichever worker runs it
+void reportFileDiagnostics(void *argument) {
+    const int fileIndex = (int)(intptr_t)argument;
+    const long offsets[3] = { 30, 10, 20 };
+
+    setDiagnosticFile(fileIndex);
+
+    for (int i = 0; i < 3; i++) {
+        reportDiagnostic(DIAGNOSTIC_SYNTAX_ERROR, offsets[i], "file %d offset %ld", fileIndex, offsets[i]);
+    }
+
+    reportWarning(DIAGNOSTIC_UNSUPPORTED_CONSTRUCT, 10, "file %d warning", fileIndex);
+}
+
+void testOrdering() {
+    ThreadPool *pool = buildThreadPool(4);
+
+    freeDiagnostics(collectDiagnostics());
+
+    for (int i = FILE_COUNT - 1; i >= 0; i--) {
+        submitThreadPool(pool, reportFileDiagnostics, (void *)(intptr_t)i);
+    }
+
+    waitThreadPool(pool);
+    freeThreadPool(pool);
+
+    // whatever thread reported them, they come out by file and offset, and in report order at one offset
+    Vector *diagnostics = collectDiagnostics();
+    bool isOrdered = (diagnostics->size == FILE_COUNT * 4);
+
+    for (int i = 0; isOrdered && i < diagnostics->size; i++) {
+        const Diagnostic *diagnostic = diagnostics->contents[i];
+        const int fileIndex = i / 4;
+        const long offsets[4] = { 10, 10, 20, 30 };
+        char message[64];
+
+        if (i % 4 == 1) {
+            snprintf(message, sizeof(message), "file %d warning", fileIndex);
+        }
+        else {
+            snprintf(message, sizeof(message), "file %d offset %ld", fileIndex, offsets[i % 4]);
+        }
+
+        isOrdered = diagnostic->fileIndex == fileIndex && diagnostic->offset == offsets[i % 4] && strcmp(diagnostic->message, message) == 0
+            && diagnostic->severity == ((i % 4 == 1) ? DIAGNOSTIC_WARNING : DIAGNOSTIC_ERROR);
+    }
+
+    CHECK(isOrdered);
+    freeDiagnostics(diagnostics);
+
+    // collecting takes them, so the next collection starts empty
+    diagnostics = collectDiagnostics();
+    CHECK(diagnostics->size == 0);
+    freeDiagnostics(diagnostics);
+}
+
+// what printDiagnostics writes to stdout for everything recorded so far
+char *printRecorded(const Project *project, int format) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/stdout", directory);
+
+    fflush(stdout);
+    const int saved = dup(STDOUT_FILENO);
+    FILE *fp = fopen(path, "w");
+    dup2(fileno(fp), STDOUT_FILENO);
+
+    Vector *diagnostics = collectDiagnostics();
+    printDiagnostics(project, diagnostics, format);
+    freeDiagnostics(diagnostics);
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    fclose(fp);
+
+    return readFile(path);
+}
+
+void testPrinting() {
+    char path[256];
+    char *files[1] = { path };
+    snprintf(path, sizeof(path), "%s/Test.bas", directory);
+
+    FILE *fp = fopen(path, "w");
+    fputs("Sub A()\n    x = \"\nEnd Sub\n", fp);
+    fclose(fp);
+
+    Project *project = buildProjectFromFiles(files, 1);
+    char expected[1024];
+
+    // an offset is shown as the line and column it falls on; a diagnostic about the whole file has neither
+    recordDiagnostic(0, 12, DIAGNOSTIC_ERROR, DIAGNOSTIC_SYNTAX_ERROR, "expected \"=\"");
+    recordDiagnostic(0, -1, DIAGNOSTIC_WARNING, DIAGNOSTIC_BUDGET_EXCEEDED, "whole file");
+    char *text = printRecorded(project, DIAGNOSTIC_FORMAT_TEXT);
+
+    snprintf(expected, sizeof(expected), "%s: warning: whole file [budget-exceeded]\n%s:2:5: error: expected \"=\" [syntax-error]\n", path, path);
+    CHECK_STRING(text, expected);
+    free(text);
+
+    // JSON escapes the message and carries the same fields
+    recordDiagnostic(0, 12, DIAGNOSTIC_ERROR, DIAGNOSTIC_SYNTAX_ERROR, "expected \"=\"");
+    text = printRecorded(project, DIAGNOSTIC_FORMAT_JSON);
+
+    snprintf(expected, sizeof(expected), "[\n  {\"file\": \"%s\", \"offset\": 12, \"line\": 2, \"column\": 5, \"severity\": \"error\", \"code\": \"syntax-error\", \"message\": \"expected \\\"=\\\"\"}\n]\n", path);
+    CHECK_STRING(text, expected);
+    free(text);
+
+    // and an empty run is still a JSON array
+    text = printRecorded(project, DIAGNOSTIC_FORMAT_JSON);
+    CHECK_STRING(text, "[]\n");
+    free(text);
+}
+
+void testNames() {
+    CHECK(parseDiagnosticFormat("text") == DIAGNOSTIC_FORMAT_TEXT);
+    CHECK(parseDiagnosticFormat("json") == DIAGNOSTIC_FORMAT_JSON);
+    CHECK(parseDiagnosticFormat("xml") == -1);
+    CHECK_STRING(getDiagnosticCodeName(DIAGNOSTIC_UNSUPPORTED_CONSTRUCT), "unsupported-construct");
+    CHECK_STRING(getDiagnosticCodeName(DIAGNOSTIC_CODE_COUNT), "unknown");
+}
+
+int main() {
+    if (mkdtemp(directory) == NULL) {
+        printf("error: could not create a scratch directory.\n");
+        return 1;
+    }
+
+    testOrdering();
+    testPrinting();
+    testNames();
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        printf("warning: could not remove \"%s\".\n", directory);
+    }
+
+    return finishChecks("diagnosticstest");
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "../transpile.h"
+#include "../typelib.h"
+#include "check.h"
+
+// Name resolution and the C# surface of whole modules, which needs the project's symbol index: the
+// modules are written to a scratch directory and transpiled as a project, and one module's output is read back.
+static char directory[] = "/tmp/emittertestXXXXXX";
+// the referenced libraries of the next project transpileModules builds, if any
+static Vector *typeLibraries;
+
+// the C# of the module at index which, or NULL when it does not transpile; the caller frees it
+char *transpileModules(const char **names, const char **sources, int count, int which) {
+    char paths[8][256];
+    char *files[8];
+
+    for (int i = 0; i < count; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%s", directory, names[i]);
+        files[i] = paths[i];
+
+        FILE *fp = fopen(paths[i], "w");
+        fputs(sources[i], fp);
+        fclose(fp);
+    }
+
+    ThreadPool *pool = buildThreadPool(1);
+    Project *project = buildProjectFromFiles(files, count);
+    TranspileSummary summary;
+
+    project->outputDirectory = directory;
+    project->typeLibraries = typeLibraries;
+    project->symbols = buildSymbolIndex(project, pool);
+    free(transpileProject(project, pool, NULL, &summary));
+    freeThreadPool(pool);
+
+    char *outputPath = getOutputPath(getProjectFile(project, which));
+    char *text = readFile(outputPath);
+    free(outputPath);
+    return text;
+}
+
+void testLocalsHideProcedures() {
+    const char *names[2] = { "Test.bas", "Totals.bas" };
+    const char *sources[2] = {
+        "Public Sub A()\n"
+        "End Sub\n"
+        "\n"
+        "Public Sub Fill()\n"
+        "    Dim a(3) As Long\n"
+        "    Dim total As Long\n"
+        "    a(1) = 2\n"
+        "    total = a(1)\n"
+        "End Sub\n"
+        "\n"
+        "Public Sub Report()\n"
+        "    Total\n"
+        "End Sub\n",
+        "Public Sub Total()\n"
+        "End Sub\n"
+    };
+    char *text = transpileModules(names, sources, 2, 0);
+
+    // the local array is indexed and the local total is not the other module's Sub, whatever their case;
+    // where no local hides it, the Sub is qualified with its module
+    CHECK_CONTAINS(text, "            a[1] = 2;\n");
+    CHECK_CONTAINS(text, "            total = a[1];\n");
+    CHECK_CONTAINS(text, "            Totals.Total();\n");
+    free(text);
+}
+
+void testRuntimeNames() {
+    const char *names[1] = { "Test.bas" };
+    const char *sources[1] = {
+        "Public Function Describe(ByVal x As Long) As String\n"
+        "    Dim s As String\n"
+        "    Describe = Left(CStr(x), 2) & CLng(\"7\")\n"
+        "    If Err.Number <> 0 Then Err.Clear\n"
+        "    s = \"local\"\n"
+        "    Debug.Print Describe, UBound(Split(s, \",\"))\n"
+        "End Function\n"
+    };
+    char *text = transpileModules(names, sources, 1, 0);
+
+    // the runtime's modules are imported as VB imports them; conversions and Err are spelled as C# needs them
+    CHECK_CONTAINS(text, "using static Microsoft.VisualBasic.Strings;\n");
+    CHECK_CONTAINS(text, "using static Microsoft.VisualBasic.Information;\n");
+    CHECK_CONTAINS(text, "            _result = string.Concat(Left(Conversions.ToString(x), 2), Conversions.ToInteger(\"7\"));\n");
+    CHECK_CONTAINS(text, "            if (Err().Number != 0)\n");
+    CHECK_CONTAINS(text, "                Err().Clear();\n");
+    CHECK_CONTAINS(text, "            s = \"local\";\n");
+    CHECK_CONTAINS(text, "            System.Diagnostics.Debug.WriteLine(string.Join(\"\\t\", _result, UBound(Split(s, \",\"))));\n");
+    free(text);
+}
+
+void testNumericWidths() {
+    const char *names[1] = { "Test.bas" };
+    const char *sources[1] = {
+        "Private mTotal As Currency\n"
+        "\n"
+        "Public Function Scale(ByVal x As Long, ByVal n As Integer) As Integer\n"
+        "    Dim b As Byte, f As Single, k As Long\n"
+        "    Scale = 10 / x\n"
+        "    b = n\n"
+        "    n = b\n"
+        "    b = 7\n"
+        "    k = x \\ 3\n"
+        "    f = 1.5\n"
+        "    mTotal = f * 2\n"
+        "End Function\n"
+    };
+    char *text = transpileModules(names, sources, 1, 0);
+
+    // each VB type keeps its width, and a store that narrows rounds and checks as VB does
+    CHECK_CONTAINS(text, "        internal static decimal mTotal;\n");
+    CHECK_CONTAINS(text, "        public static short Scale(int x, short n)\n");
+    CHECK_CONTAINS(text,
+        "            short _result = default;\n"
+        "            byte b = default;\n"
+        "            float f = default;\n"
+        "            int k = default;\n"
+        "            _result = checked((short)Math.Round((double)10 / x));\n"
+        "            b = checked((byte)(n));\n"
+        "            n = b;\n"
+        "            b = 7;\n"
+        "            k = x / 3;\n"
+        "            f = (float)(1.5);\n"
+        "            mTotal = (decimal)(f * 2);\n");
+    free(text);
+}
+
+void testProperties() {
+    const char *names[2] = { "Test.cls", "Caller.bas" };
+    const char *sources[2] = {
+        "Private mCount As Long\n"
+        "\n"
+        "Public Property Get Count() As Long\n"
+        "    If mCount < 0 Then Exit Property\n"
+        "    Count = mCount\n"
+        "End Property\n"
+        "\n"
+        "Public Property Let Count(ByVal n As Long)\n"
+        "    mCount = n\n"
+        "End Property\n"
+        "\n"
+        "Public Property Get Item(ByVal i As Long) As Long\n"
+        "    Item = i\n"
+        "End Property\n"
+        "\n"
+        "Public Sub Bump()\n"
+        "    Count = Count + 1\n"
+        "End Sub\n",
+        "Public Sub Main()\n"
+        "End Sub\n"
+    };
+    char *text = transpileModules(names, sources, 2, 0);
+
+    // a Get and its Let are one C# property, so reads and stores through the name compile; an indexed Get stays a method
+    CHECK_CONTAINS(text,
+        "        public int Count\n"
+        "        {\n"
+        "            get\n"
+        "            {\n"
+        "                int _result = default;\n"
+        "                if (mCount < 0)\n"
+        "                {\n"
+        "                    return _result;\n"
+        "                }\n"
+        "                _result = mCount;\n"
+        "                return _result;\n"
+        "            }\n"
+        "            set\n"
+        "            {\n"
+        "                int n = value;\n"
+        "                mCount = n;\n"
+        "            }\n"
+        "        }\n");
+    CHECK_CONTAINS(text, "        public int Item(int i)\n");
+    CHECK_CONTAINS(text, "            Count = Count + 1;\n");
+    free(text);
+}
+
+void testModuleNames() {
+    const char *names[2] = { "Test.bas", "modTotals.bas" };
+    const char *sources[2] = {
+        "Public Sub Report()\n"
+        "    Total\n"
+        "End Sub\n",
+        "Attribute VB_Name = \"Totals\"\n"
+        "Public Sub Total()\n"
+        "End Sub\n"
+    };
+    char *caller = transpileModules(names, sources, 2, 0);
+    char *callee = transpileModules(names, sources, 2, 1);
+
+    // VB knows a module by its VB_Name, whatever its file is called, and so does C#
+    CHECK_CONTAINS(caller, "            Totals.Total();\n");
+    CHECK_CONTAINS(callee, "    public static class Totals\n");
+    free(caller);
+    free(callee);
+}
+
+void testCollectionShim() {
+    const char *names[1] = { "Test.bas" };
+    const char *sources[1] = {
+        "Private mItems As Collection\n"
+        "\n"
+        "Public Sub Fill(ByVal v As Variant)\n"
+        "    Dim c As Collection, i As Long\n"
+        "    Set c = New Collection\n"
+        "    c.Add v\n"
+        "    For i = 1 To c.Count\n"
+        "        Debug.Print c(i), c.Item(i)\n"
+        "    Next i\n"
+        "    Debug.Print mItems(1)\n"
+        "End Sub\n"
+    };
+    char *text = transpileModules(names, sources, 1, 0);
+
+    // a Collection whose items are not proven keeps the runtime's, and is indexed from 1 as in VB
+    CHECK_CONTAINS(text, "            Microsoft.VisualBasic.Collection c = default;\n");
+    CHECK_CONTAINS(text, "                System.Diagnostics.Debug.WriteLine(string.Join(\"\\t\", c[i], c[i]));\n");
+    CHECK_CONTAINS(text, "            System.Diagnostics.Debug.WriteLine(mItems[1]);\n");
+    free(text);
+}
+
+void testLibraryMembers() {
+    const char *names[1] = { "Test.bas" };
+    const char *sources[1] = {
+        "Public Sub Walk(ByVal rs As Recordset)\n"
+        "    Dim n As Long, v As Variant\n"
+        "    rs.movenext\n"
+        "    n = rs.RecordCount\n"
+        "    v = rs.GetRows\n"
+        "    Debug.Print rs.Fields(1), rs.Other(2)\n"
+        "End Sub\n"
+    };
+    TypeLibrary *library = compileTypeLibrary(
+        "library ADODB {00000201-0000-0010-8000-00AA006D2EA4} 2.8\n"
+        "type Recordset class\n"
+        "member MoveNext method Sub MoveNext()\n"
+        "member GetRows method Function GetRows() As Variant\n"
+        "member RecordCount property Property RecordCount As Long\n"
+        "member Fields property Property Fields(Index As Variant) As Field\n", "adodb.txt");
+
+    typeLibraries = buildVectorList();
+    pushVector(typeLibraries, library);
+    char *text = transpileModules(names, sources, 1, 0);
+
+    // the library says which members are methods, called even without VB's parentheses, and which are
+    // properties, indexed where they take arguments; a member it does not list is left as written
+    CHECK_CONTAINS(text, "            rs.MoveNext();\n");
+    CHECK_CONTAINS(text, "            n = rs.RecordCount;\n");
+    CHECK_CONTAINS(text, "            v = rs.GetRows();\n");
+    CHECK_CONTAINS(text, "            System.Diagnostics.Debug.WriteLine(string.Join(\"\\t\", rs.Fields[1], rs.Other(2)));\n");
+
+    free(text);
+    freeTypeLibrary(library);
+    free(typeLibraries->contents);
+    free(typeLibraries);
+    typeLibraries = NULL;
+}
+
+int main() {
+    if (mkdtemp(directory) == NULL) {
+        printf("error: could not create a scratch directory.\n");
+        return 1;
+    }
+
+    testLocalsHideProcedures();
+    testRuntimeNames();
+    testNumericWidths();
+    testProperties();
+    testModuleNames();
+    testCollectionShim();
+    testLibraryMembers();
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        printf("warning: could not remove \"%s\".\n", directory);
+    }
+
+    return finishChecks("emittertest");
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "../infer.h"
+#include "check.h"
+#include "source.h"
+
+const char *const variantSource =
+    "Private Function Name()\n"
+    "    Name = \"x\"\n"
+    "End Function\n"
+    "\n"
+    "Public Function Label()\n"
+    "    Label = \"x\"\n"
+    "End Function\n"
+    "\n"
+    "Sub Kinds(ByVal c As Boolean)\n"
+    "    Dim n, d, s, o, f\n"
+    "    n = 1\n"
+    "    If c Then d = 1 Else d = 2.5\n"
+    "    s = \"a\"\n"
+    "    s = s & n\n"
+    "    o = 1\n"
+    "    o = \"b\"\n"
+    "    f = n > 0\n"
+    "    Dim k As Long\n"
+    "    k = d\n"
+    "End Sub\n";
+
+int getVariableType(const ControlFlowGraph *graph, const InferredTypes *types, const char *name) {
+    const int variable = findCfgVariable(graph, name);
+    return (variable >= 0) ? types->variables[variable].kind : -1;
+}
+
+void testInferredTypes() {
+    TransUnitNode *transUnitNode = parseSource(variantSource);
+    ControlFlowGraph *graph = getControlFlowGraph(findProcedure(transUnitNode, "Kinds"));
+    const InferredTypes *types = getInferredTypes(graph, NULL);
+
+    CHECK(getVariableType(graph, types, "n") == INFERRED_INT);
+    CHECK(getVariableType(graph, types, "s") == INFERRED_STRING);
+    CHECK(getVariableType(graph, types, "f") == INFERRED_BOOL);
+
+    // an Integer on one arm and a Double on the other meet at the join as a Double
+    CHECK(getVariableType(graph, types, "d") == INFERRED_DOUBLE);
+
+    // a number and then a string have no common type short of object
+    CHECK(getVariableType(graph, types, "o") == INFERRED_OBJECT);
+
+    // the parameter is declared, so only the locals are Variants to narrow
+    CHECK(types->isVariant[findCfgVariable(graph, "n")]);
+    CHECK(!types->isVariant[findCfgVariable(graph, "c")]);
+
+    ControlFlowGraph *name = getControlFlowGraph(findProcedure(transUnitNode, "Name"));
+    CHECK(getVariableType(name, getInferredTypes(name, NULL), "Name") == INFERRED_STRING);
+
+    // other modules call a Public function as declared, so its result stays a Variant
+    ControlFlowGraph *label = getControlFlowGraph(findProcedure(transUnitNode, "Label"));
+    CHECK(!getInferredTypes(label, NULL)->isVariant[findCfgVariable(label, "Label")]);
+
+    freeTransUnitNode(transUnitNode);
+}
+
+void testNarrowedDeclarations() {
+    char *text = emitSource(variantSource);
+
+    CHECK_CONTAINS(text,
+        "        public static string Name()\n"
+        "        {\n"
+        "            string _result = \"\";\n"
+        "            _result = \"x\";\n"
+        "            return _result;\n"
+        "        }\n");
+    CHECK_CONTAINS(text, "        public static object Label()\n");
+    CHECK_CONTAINS(text,
+        "            int n = default;\n"
+        "            double d = default;\n"
+        "            string s = \"\";\n"
+        "            object o = default;\n"
+        "            bool f = default;\n");
+
+    // a Variant narrowed to double still rounds where it is stored into an integer, as VB's conversion does
+    CHECK_CONTAINS(text, "            k = checked((int)Math.Round(d));\n");
+
+    free(text);
+}
+
+int main() {
+    testInferredTypes();
+    testNarrowedDeclarations();
+
+    return finishChecks("infertest");
+}
\ No newline at end of file
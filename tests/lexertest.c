@@ -0,0 +1,105 @@
+#include "../lexer.h"
+#include "check.h"
+
+// whether lexing source with defines keeps the identifier name, i.e. whether its branch was active
+bool isIdentifierLexed(const char *source, StringIntegerMap *defines, const char *name) {
+    char *copy = strdup(source);
+    Vector *tokens = lexWithDefines(copy, defines);
+    bool found = false;
+
+    for (int i = 0; tokens != NULL && i < tokens->size; i++) {
+        const Token *token = tokens->contents[i];
+        found |= (token->type == TK_IDENTIFIER && strcasecmp(token->string, name) == 0);
+    }
+
+    if (tokens != NULL) {
+        freeTokens(tokens);
+    }
+
+    free(copy);
+    return found;
+}
+
+void testIntrinsicConstants() {
+    CHECK(isIdentifierLexed("#If Win32 Then\nA = 1\n#Else\nB = 1\n#End If\n", NULL, "A"));
+    CHECK(!isIdentifierLexed("#If Win32 Then\nA = 1\n#Else\nB = 1\n#End If\n", NULL, "B"));
+    CHECK(isIdentifierLexed("#If Win16 Then\nA = 1\n#Else\nB = 1\n#End If\n", NULL, "B"));
+    CHECK(isIdentifierLexed("#If VBA6 Then\nA = 1\n#End If\n", NULL, "A"));
+    CHECK(isIdentifierLexed("#If Win32 = -1 And VBA6 = True Then\nA = 1\n#End If\n", NULL, "A"));
+
+    // a project or command-line value overrides the intrinsic one
+    StringIntegerMap *defines = buildStringIntegerMap(16);
+    CHECK(parseConditionalDefine(defines, "Win32=0"));
+    CHECK(!isIdentifierLexed("#If Win32 Then\nA = 1\n#End If\n", defines, "A"));
+    freeStringIntegerMap(defines);
+}
+
+void testBareDefine() {
+    StringIntegerMap *defines = buildStringIntegerMap(16);
+
+    CHECK(parseConditionalDefine(defines, "Debugging"));
+    CHECK(stringIntegerMapContains(defines, "debugging"));
+    CHECK(getIntegerMap(defines, "debugging") == -1);
+    CHECK(isIdentifierLexed("#If DEBUGGING = True Then\nA = 1\n#End If\n", defines, "A"));
+    CHECK(isIdentifierLexed("#If Not Debugging Then\nA = 1\n#Else\nB = 1\n#End If\n", defines, "B"));
+    CHECK(!isIdentifierLexed("#If Debugging = 1 Then\nA = 1\n#End If\n", defines, "A"));
+
+    CHECK(parseConditionalDefine(defines, "Level = 2 : Trace"));
+    CHECK(getIntegerMap(defines, "level") == 2);
+    CHECK(getIntegerMap(defines, "trace") == -1);
+    freeStringIntegerMap(defines);
+}
+
+// each unterminated literal is reported where it starts, and the lines after it are still lexed
+void testUnterminatedString() {
+    char source[] = "A = \"open\r\nB = \"x\" & \"also open\nC = 1 $\n";
+    Vector *tokens = lex(source);
+    Vector *diagnostics = collectDiagnostics();
+
+    CHECK(tokens == NULL);
+    CHECK(diagnostics->size == 3);
+
+    if (diagnostics->size == 3) {
+        const Diagnostic *first = diagnostics->contents[0];
+        const Diagnostic *second = diagnostics->contents[1];
+        const Diagnostic *third = diagnostics->contents[2];
+
+        CHECK(first->code == DIAGNOSTIC_UNTERMINATED_STRING && first->offset == 4);
+        CHECK(second->code == DIAGNOSTIC_UNTERMINATED_STRING && second->offset == 21);
+        CHECK(third->code == DIAGNOSTIC_INVALID_CHARACTER && third->offset == 38);
+    }
+
+    freeDiagnostics(diagnostics);
+
+    char closed[] = "A = \"say \"\"hi\"\"\"\nB = 1\n";
+    tokens = lex(closed);
+    CHECK(tokens != NULL && tokens->size == 8);
+    CHECK(tokens != NULL && ((Token *)tokens->contents[2])->type == TK_STRING_LITERAL);
+    CHECK_STRING((tokens != NULL) ? ((Token *)tokens->contents[2])->string : NULL, "say \"hi\"");
+
+    if (tokens != NULL) {
+        freeTokens(tokens);
+    }
+}
+
+// a # that does not start a directive is a file number's, and one that does still opens the directive
+void testFileNumbers() {
+    char source[] = "#If Win32 Then\nPrint #1, x\n#End If\n";
+    Vector *tokens = lex(source);
+
+    CHECK(tokens != NULL && tokens->size == 6);
+    CHECK(tokens != NULL && ((Token *)tokens->contents[1])->type == TK_POUND && ((Token *)tokens->contents[2])->type == TK_NUMBER);
+
+    if (tokens != NULL) {
+        freeTokens(tokens);
+    }
+}
+
+int main() {
+    testIntrinsicConstants();
+    testBareDefine();
+    testUnterminatedString();
+    testFileNumbers();
+
+    return finishChecks("lexertest");
+}
\ No newline at end of file
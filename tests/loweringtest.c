@@ -0,0 +1,527 @@
+#include "check.h"
+#include "source.h"
+
+// Each lowering of a loop or an error handler, checked against the exact C# it emits.
+
+void testStringBuilderLowering() {
+    char *text = emitSource(
+        "Function Build(ByVal n As Long, ByVal t As String, r As String) As String\n"
+        "    Dim i As Long, s As String\n"
+        "    For i = 1 To n\n"
+        "        s = s & \"a\" & i\n"
+        "        t = t & \"b\"\n"
+        "        r = r & \"c\"\n"
+        "        Build = Build & \"d\"\n"
+        "    Next i\n"
+        "    Build = s & t & r & \"e\" & \"f\"\n"
+        "End Function\n");
+
+    // the local and the ByVal parameter are built up; the ByRef parameter and the result stay strings,
+    // since code the loop calls could read either, and a chain outside any loop is one Concat
+    CHECK_CONTAINS(text,
+        "            {\n"
+        "                var _sBuilder = new System.Text.StringBuilder(s);\n"
+        "                var _tBuilder = new System.Text.StringBuilder(t);\n"
+        "                for (i = 1; i <= n; i++)\n"
+        "                {\n"
+        "                    _sBuilder.Append(\"a\").Append(i);\n"
+        "                    _tBuilder.Append(\"b\");\n"
+        "                    r = string.Concat(r, \"c\");\n"
+        "                    _result = string.Concat(_result, \"d\");\n"
+        "                }\n"
+        "                s = _sBuilder.ToString();\n"
+        "                t = _tBuilder.ToString();\n"
+        "            }\n"
+        "            _result = string.Concat(s, t, r, \"e\", \"f\");\n");
+
+    free(text);
+}
+
+void testStringBuilderReads() {
+    char *text = emitSource(
+        "Sub Peek(ByVal n As Long)\n"
+        "    Dim i As Long, s As String\n"
+        "    For i = 1 To n\n"
+        "        s = s & \"a\"\n"
+        "        Debug.Print Len(s)\n"
+        "    Next i\n"
+        "End Sub\n");
+
+    // a read inside the loop would see the builder's stale string, so s is left alone
+    CHECK_CONTAINS(text,
+        "            for (i = 1; i <= n; i++)\n"
+        "            {\n"
+        "                s = string.Concat(s, \"a\");\n");
+    CHECK(text != NULL && strstr(text, "StringBuilder") == NULL);
+
+    free(text);
+}
+
+void testArrayGrowthLowering() {
+    char *text = emitSource(
+        "Sub Grow(ByVal n As Long)\n"
+        "    Dim a() As Long, i As Long, aCount As Long\n"
+        "    ReDim a(0)\n"
+        "    For i = 1 To n\n"
+        "        ReDim Preserve a(UBound(a) + 1)\n"
+        "        a(UBound(a)) = i\n"
+        "    Next i\n"
+        "    aCount = UBound(a)\n"
+        "End Sub\n");
+
+    // the loop grows a with spare capacity through _aCount, which the local aCount does not clash with,
+    // and trims it back after the loop so the array has the length VB would give it
+    CHECK_CONTAINS(text,
+        "            a = new int[0 + 1];\n"
+        "            {\n"
+        "                var _aCount = (a != null) ? a.Length : 0;\n"
+        "                for (i = 1; i <= n; i++)\n"
+        "                {\n"
+        "                    _aCount += 1;\n"
+        "                    if (_aCount > a.Length)\n"
+        "                    {\n"
+        "                        Array.Resize(ref a, Math.Max(_aCount, 2 * a.Length));\n"
+        "                    }\n"
+        "                    a[(_aCount - 1)] = i;\n"
+        "                }\n"
+        "                if (a != null && a.Length != _aCount)\n"
+        "                {\n"
+        "                    Array.Resize(ref a, _aCount);\n"
+        "                }\n"
+        "            }\n"
+        "            aCount = (a.Length - 1);\n");
+
+    free(text);
+}
+
+void testArrayGrowthBounds() {
+    char *text = emitSource(
+        "Sub Shifted(ByVal n As Long)\n"
+        "    Dim b() As Long, i As Long\n"
+        "    ReDim b(1 To 1)\n"
+        "    For i = 1 To n\n"
+        "        ReDim Preserve b(UBound(b) + 1)\n"
+        "    Next i\n"
+        "End Sub\n");
+
+    // only an array sized from 0 grows with spare capacity; one that starts at 1 is resized each time
+    CHECK_CONTAINS(text,
+        "            for (i = 1; i <= n; i++)\n"
+        "            {\n"
+        "                Array.Resize(ref b, (b.Length - 1) + 1 + 1);\n"
+        "            }\n");
+    CHECK(text != NULL && strstr(text, "_bCount") == NULL);
+    free(text);
+
+    text = emitSource(
+        "Option Base 1\n"
+        "Dim m(10) As Long\n"
+        "Sub Bounds()\n"
+        "    Dim z(0 To 3) As Long\n"
+        "    Debug.Print UBound(m), UBound(z), LBound(m), LBound(z)\n"
+        "End Sub\n");
+
+    // the C# array runs from 0 to the upper bound whatever the lower one, which LBound still reports
+    CHECK_CONTAINS(text, "            System.Diagnostics.Debug.WriteLine(string.Join(\"\\t\", (m.Length - 1), (z.Length - 1), 1, 0));\n");
+    free(text);
+
+    freeDiagnostics(collectDiagnostics());
+    free(emitSource(
+        "Sub Offset(ByVal n As Long)\n"
+        "    Dim c() As Long\n"
+        "    ReDim c(n To 4)\n"
+        "End Sub\n"));
+
+    // a lower bound the C# array cannot keep still transpiles, with a warning where it stands
+    Vector *diagnostics = collectDiagnostics();
+    const Diagnostic *diagnostic = (diagnostics->size == 1) ? diagnostics->contents[0] : NULL;
+    CHECK(diagnostic != NULL && diagnostic->severity == DIAGNOSTIC_WARNING && diagnostic->code == DIAGNOSTIC_UNSUPPORTED_CONSTRUCT && diagnostic->offset == 60);
+    freeDiagnostics(diagnostics);
+}
+
+void testCollectionLowering() {
+    char *text = emitSource(
+        "Sub Tally()\n"
+        "    Dim c As New Collection, d As Object, i As Long, total As Long\n"
+        "    Set d = CreateObject(\"Scripting.Dictionary\")\n"
+        "    c.Add 5\n"
+        "    c.Add 7\n"
+        "    d.Add \"a\", 1\n"
+        "    If d.Exists(\"a\") Then d(\"a\") = d(\"a\") + 1\n"
+        "    For i = 1 To c.Count\n"
+        "        total = total + c(i)\n"
+        "    Next i\n"
+        "    Debug.Print c.Count, d.Count, c(1), d.Item(\"a\")\n"
+        "    d.Remove \"a\"\n"
+        "End Sub\n");
+
+    // an unkeyed Collection of Longs is a List read from 1, and a Dictionary of Strings to Longs a
+    // Dictionary that compares its keys ordinally, as Scripting.Dictionary does by default
+    CHECK_CONTAINS(text,
+        "            System.Collections.Generic.List<int> c = new System.Collections.Generic.List<int>();\n"
+        "            System.Collections.Generic.Dictionary<string, int> d = default;\n"
+        "            int i = default;\n"
+        "            int total = default;\n"
+        "            d = new System.Collections.Generic.Dictionary<string, int>();\n"
+        "            c.Add(5);\n"
+        "            c.Add(7);\n"
+        "            d.Add(\"a\", 1);\n"
+        "            if (d.ContainsKey(\"a\"))\n"
+        "            {\n"
+        "                d[\"a\"] = System.Collections.Generic.CollectionExtensions.GetValueOrDefault(d, \"a\") + 1;\n"
+        "            }\n"
+        "            for (i = 1; i <= c.Count; i++)\n"
+        "            {\n"
+        "                total = total + c[i - 1];\n"
+        "            }\n"
+        "            System.Diagnostics.Debug.WriteLine(string.Join(\"\\t\", c.Count, d.Count, c[0], System.Collections.Generic.CollectionExtensions.GetValueOrDefault(d, \"a\")));\n"
+        "            d.Remove(\"a\");\n");
+
+    free(text);
+}
+
+void testCollectionFallback() {
+    char *text = emitSource(
+        "Sub Keyed()\n"
+        "    Dim c As New Collection\n"
+        "    c.Add 5, \"k\"\n"
+        "    Debug.Print c(\"K\")\n"
+        "End Sub\n"
+        "\n"
+        "Sub Mixed()\n"
+        "    Dim c As New Collection\n"
+        "    c.Add 5\n"
+        "    c.Add \"x\"\n"
+        "End Sub\n");
+
+    // a keyed Collection looks its keys up without regard to case
+    CHECK_CONTAINS(text,
+        "            System.Collections.Generic.Dictionary<string, int> c = new System.Collections.Generic.Dictionary<string, int>(StringComparer.OrdinalIgnoreCase);\n"
+        "            c.Add(\"k\", 5);\n"
+        "            System.Diagnostics.Debug.WriteLine(c[\"K\"]);\n");
+
+    // items of more than one type keep the late-bound Collection
+    CHECK_CONTAINS(text,
+        "            Microsoft.VisualBasic.Collection c = new Microsoft.VisualBasic.Collection();\n"
+        "            c.Add(5);\n"
+        "            c.Add(\"x\");\n");
+
+    free(text);
+}
+
+void testResumeNextLowering() {
+    char *text = emitSource(
+        "Sub Plain(ByVal d As Long)\n"
+        "    Dim x As Long\n"
+        "    On Error Resume Next\n"
+        "    x = 1 \\ d\n"
+        "    x = 2 \\ d\n"
+        "    On Error GoTo 0\n"
+        "    x = 3 \\ d\n"
+        "End Sub\n");
+
+    // every statement under Resume Next is on, so the region's catch needs no flag; it goes back to the
+    // top of the region, which jumps past the statement that raised, and On Error GoTo 0 ends the region
+    CHECK_CONTAINS(text,
+        "            int x = default;\n"
+        "            int _resume1 = 0;\n"
+        "            _region1:\n"
+        "            try\n"
+        "            {\n"
+        "                switch (_resume1)\n"
+        "                {\n"
+        "                    case 1: goto _next1_1;\n"
+        "                    case 2: goto _next1_2;\n"
+        "                }\n"
+        "                _resume1 = 1;\n"
+        "                x = checked(1 / d);\n"
+        "                _next1_1:\n"
+        "                _resume1 = 2;\n"
+        "                x = checked(2 / d);\n"
+        "                _next1_2:\n"
+        "                ;\n"
+        "            }\n"
+        "            catch (Exception _exception)\n"
+        "            {\n"
+        "                Microsoft.VisualBasic.CompilerServices.ProjectData.SetProjectError(_exception);\n"
+        "                goto _region1;\n"
+        "            }\n"
+        "            x = 3 / d;\n"
+        "        }\n");
+    CHECK(text != NULL && strstr(text, "_resumeNext") == NULL);
+
+    free(text);
+}
+
+void testConditionalResumeNext() {
+    char *text = emitSource(
+        "Sub Maybe(ByVal d As Long, ByVal q As Boolean)\n"
+        "    Dim x As Long\n"
+        "    If q Then\n"
+        "        On Error Resume Next\n"
+        "    End If\n"
+        "    x = 1 \\ d\n"
+        "End Sub\n");
+
+    // after the If, Resume Next may or may not be on, so _resumeNext says which at run time
+    CHECK_CONTAINS(text,
+        "            bool _resumeNext = false;\n"
+        "            int x = default;\n"
+        "            if (q)\n"
+        "            {\n"
+        "                _resumeNext = true;\n"
+        "            }\n"
+        "            try\n"
+        "            {\n"
+        "                x = checked(1 / d);\n"
+        "            }\n"
+        "            catch (Exception _exception) when (_resumeNext)\n"
+        "            {\n"
+        "                Microsoft.VisualBasic.CompilerServices.ProjectData.SetProjectError(_exception);\n"
+        "            }\n");
+
+    free(text);
+}
+
+void testErrorHandlerLowering() {
+    freeDiagnostics(collectDiagnostics());
+    char *text = emitSource(
+        "Function Ratio(ByVal a As Long, ByVal b As Long) As Long\n"
+        "    Dim t As Long\n"
+        "    On Error GoTo Fail\n"
+        "    t = a * b\n"
+        "    If b > 0 Then\n"
+        "        t = a \\ b\n"
+        "    Else\n"
+        "        On Error GoTo Fail\n"
+        "        t = 0\n"
+        "    End If\n"
+        "    Ratio = t\n"
+        "    Exit Function\n"
+        "Fail:\n"
+        "    t = -1\n"
+        "    Resume Next\n"
+        "End Function\n");
+
+    // the If is flattened, so Resume Next goes on inside it; arithmetic overflows as in VB, the repeated
+    // On Error GoTo changes nothing, and nothing follows the handler's jump back into the try
+    CHECK_CONTAINS(text,
+        "                _errorLine = 1;\n"
+        "                t = checked(a * b);\n"
+        "                _next1:\n"
+        "                if (!(b > 0)) goto _else1;\n"
+        "                _errorLine = 2;\n"
+        "                t = checked(a / b);\n"
+        "                _next2:\n"
+        "                goto _endIf1;\n"
+        "                _else1:\n"
+        "                t = 0;\n"
+        "                _endIf1:\n"
+        "                _result = t;\n"
+        "                return _result;\n"
+        "            }\n");
+    CHECK_CONTAINS(text,
+        "            _errorResume = _errorLine;\n"
+        "            goto _try;\n"
+        "        }\n");
+
+    Vector *diagnostics = collectDiagnostics();
+    CHECK(diagnostics->size == 0);
+    freeDiagnostics(diagnostics);
+    free(text);
+
+    free(emitSource(
+        "Sub Fill(ByVal n As Long)\n"
+        "    Dim i As Long, t As Long\n"
+        "    On Error GoTo Fail\n"
+        "    For i = 1 To n\n"
+        "        t = t + i\n"
+        "    Next i\n"
+        "    Exit Sub\n"
+        "Fail:\n"
+        "    Resume Next\n"
+        "End Sub\n"
+        "\n"
+        "Sub Twice(ByVal n As Long)\n"
+        "    On Error GoTo First\n"
+        "    n = n * 2\n"
+        "    On Error GoTo Second\n"
+        "    n = n * 3\n"
+        "First:\n"
+        "Second:\n"
+        "End Sub\n"));
+
+    // an error inside a loop resumes after the whole loop, and a second handler leaves the first unlowered; both are said
+    diagnostics = collectDiagnostics();
+    CHECK(diagnostics->size == 2);
+
+    for (int i = 0; i < diagnostics->size; i++) {
+        const Diagnostic *diagnostic = diagnostics->contents[i];
+        CHECK(diagnostic->severity == DIAGNOSTIC_WARNING && diagnostic->code == DIAGNOSTIC_UNSUPPORTED_CONSTRUCT);
+    }
+
+    freeDiagnostics(diagnostics);
+}
+
+void testGeneratedNames() {
+    char *text = emitSource(
+        "Function Calc(ByVal d As Long) As Long\n"
+        "    Dim vbResult As Long\n"
+        "    vbResult = 2\n"
+        "    Calc = vbResult \\ d\n"
+        "End Function\n");
+
+    // the result variable the emitter makes up cannot clash with a local of any VB name
+    CHECK_CONTAINS(text,
+        "            int _result = default;\n"
+        "            int vbResult = default;\n"
+        "            vbResult = 2;\n"
+        "            _result = vbResult / d;\n"
+        "            return _result;\n");
+
+    free(text);
+}
+
+void testForEachLowering() {
+    char *text = emitSource(
+        "Sub Walk(ByVal items As Collection)\n"
+        "    Dim v As Variant, total As Long\n"
+        "    For Each v In items\n"
+        "        If IsEmpty(v) Then Exit For\n"
+        "        total = total + 1\n"
+        "    Next\n"
+        "End Sub\n");
+
+    // the enumerator is declared ahead of a for loop, so Exit For still breaks out of it
+    CHECK_CONTAINS(text,
+        "            System.Collections.IEnumerator _each1 = default;\n"
+        "            for (_each1 = items.GetEnumerator(); _each1.MoveNext(); )\n"
+        "            {\n"
+        "                v = _each1.Current;\n"
+        "                if (IsEmpty(v))\n"
+        "                {\n"
+        "                    break;\n"
+        "                }\n");
+
+    free(text);
+}
+
+void testComputedGoTo() {
+    char *text = emitSource(
+        "Sub Jump(ByVal k As Long)\n"
+        "    On k GoTo One, Two\n"
+        "    Exit Sub\n"
+        "One:\n"
+        "    k = 1\n"
+        "Two:\n"
+        "End Sub\n");
+
+    CHECK_CONTAINS(text,
+        "            if (k == 1)\n"
+        "            {\n"
+        "                goto One;\n"
+        "            }\n"
+        "            else if (k == 2)\n"
+        "            {\n"
+        "                goto Two;\n"
+        "            }\n"
+        "            return;\n");
+
+    free(text);
+}
+
+void testMultidimensionalArrays() {
+    char *text = emitSource(
+        "Sub Grid(ByVal n As Long)\n"
+        "    Dim g(2, n) As Double\n"
+        "    g(1, 2) = UBound(g)\n"
+        "End Sub\n");
+
+    CHECK_CONTAINS(text,
+        "            double[,] g = new double[2 + 1, n + 1];\n"
+        "            g[1, 2] = g.GetUpperBound(0);\n");
+
+    free(text);
+}
+
+void testFileStatements() {
+    char *text = emitSource(
+        "Sub Save(ByVal path As String, ByVal n As Long)\n"
+        "    Dim s As String\n"
+        "    Open path For Append Access Write Lock Read As #1 Len = 64\n"
+        "    Print #1, \"n =\"; n, \"done\"\n"
+        "    Print #1, \"more\";\n"
+        "    Write #1, s, n\n"
+        "    Put #1, , n\n"
+        "    Close #1\n"
+        "    Open path For Input As 2\n"
+        "    Line Input #2, s\n"
+        "    Close\n"
+        "End Sub\n");
+
+    // each is a call into the runtime's FileSystem; Print's ; runs items together and its , starts a zone
+    CHECK_CONTAINS(text,
+        "            FileOpen(1, path, OpenMode.Append, OpenAccess.Write, OpenShare.LockRead, 64);\n"
+        "            PrintLine(1, string.Concat(\"n =\", n), \"done\");\n"
+        "            Print(1, \"more\");\n"
+        "            WriteLine(1, s, n);\n"
+        "            FilePut(1, n);\n"
+        "            FileClose(1);\n"
+        "            FileOpen(2, path, OpenMode.Input);\n"
+        "            s = LineInput(2);\n"
+        "            FileClose();\n");
+
+    free(text);
+}
+
+// what has no lowering is warned about a statement at a time, and the module around it still transpiles
+void testUnsupportedConstructs() {
+    freeDiagnostics(collectDiagnostics());
+    char *text = emitSource(
+        "Private Type Point\n"
+        "    X As Long\n"
+        "End Type\n"
+        "Private Declare Function GetTickCount Lib \"kernel32\" () As Long\n"
+        "\n"
+        "Sub Load(ByVal n As Long)\n"
+        "    Dim s As String\n"
+        "    MsgBox Prompt:=\"hi\", Title:=\"t\"\n"
+        "    Input #1, s, n\n"
+        "    n = 2\n"
+        "End Sub\n");
+
+    CHECK_CONTAINS(text,
+        "            string s = \"\";\n"
+        "            n = 2;\n");
+
+    Vector *diagnostics = collectDiagnostics();
+    CHECK(diagnostics->size == 4);
+
+    for (int i = 0; i < diagnostics->size; i++) {
+        const Diagnostic *diagnostic = diagnostics->contents[i];
+        CHECK(diagnostic->severity == DIAGNOSTIC_WARNING && diagnostic->code == DIAGNOSTIC_UNSUPPORTED_CONSTRUCT);
+    }
+
+    freeDiagnostics(diagnostics);
+    free(text);
+}
+
+int main() {
+    testStringBuilderLowering();
+    testStringBuilderReads();
+    testArrayGrowthLowering();
+    testArrayGrowthBounds();
+    testCollectionLowering();
+    testCollectionFallback();
+    testResumeNextLowering();
+    testConditionalResumeNext();
+    testErrorHandlerLowering();
+    testGeneratedNames();
+    testForEachLowering();
+    testComputedGoTo();
+    testMultidimensionalArrays();
+    testFileStatements();
+    testUnsupportedConstructs();
+
+    return finishChecks("loweringtest");
+}
\ No newline at end of file
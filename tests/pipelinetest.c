@@ -0,0 +1,104 @@
+#include "../pipeline.h"
+#include "check.h"
+
+// Six modules in a scratch directory, the last of which does not parse.
+static char directory[] = "/tmp/pipelinetestXXXXXX";
+
+#define MODULE_COUNT 6
+
+Project *buildModuleProject() {
+    char paths[MODULE_COUNT][256];
+    char *files[MODULE_COUNT];
+
+    for (int i = 0; i < MODULE_COUNT; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/Module%d.bas", directory, i);
+        files[i] = paths[i];
+
+        FILE *fp = fopen(paths[i], "w");
+
+        for (int j = 0; j <= i; j++) {
+            fprintf(fp, "Public Function Step%d(n As Long) As Long\n    Step%d = n + %d\nEnd Function\n", j, j, j);
+        }
+
+        if (i == MODULE_COUNT - 1) {
+            fputs("Public Sub Broken(\n", fp);
+        }
+
+        fclose(fp);
+    }
+
+    return buildProjectFromFiles(files, MODULE_COUNT);
+}
+
+void testQueue() {
+    BoundedQueue queue;
+    int values[3] = { 1, 2, 3 };
+    void *data = NULL;
+
+    initializeBoundedQueue(&queue, 2);
+
+    CHECK(tryEnqueue(&queue, &values[0]));
+    CHECK(tryEnqueue(&queue, &values[1]));
+    CHECK(!tryEnqueue(&queue, &values[2]));
+    CHECK(tryDequeue(&queue, &data) && data == &values[0]);
+    CHECK(tryEnqueue(&queue, &values[2]));
+    CHECK(tryDequeue(&queue, &data) && data == &values[1]);
+    CHECK(tryDequeue(&queue, &data) && data == &values[2]);
+    CHECK(!tryDequeue(&queue, &data));
+
+    freeBoundedQueue(&queue);
+}
+
+// the pipeline and the pool give the same results, and neither keeps a file's tokens or tree once it is done
+void testModes(const Project *project) {
+    ThreadPool *pool = buildThreadPool(2);
+    PipelineOptions options;
+    PipelineMetrics metrics;
+    TranspileSummary pooledSummary, pipelinedSummary;
+
+    initializePipelineOptions(&options, 4);
+    options.queueCapacity = 2;
+
+    TranspileResult *pooled = transpileProject(project, pool, NULL, &pooledSummary);
+    TranspileResult *pipelined = transpileProjectPipelined(project, &options, NULL, &pipelinedSummary, &metrics);
+
+    CHECK(pooledSummary.fileCount == MODULE_COUNT && pooledSummary.failureCount == 1);
+    CHECK(pipelinedSummary.fileCount == MODULE_COUNT && pipelinedSummary.failureCount == 1);
+    CHECK(metrics.stages[STAGE_READ].itemCount == MODULE_COUNT);
+    CHECK(metrics.stages[STAGE_EMIT].itemCount == MODULE_COUNT - 1);
+
+    bool isSame = true, isReleased = true;
+
+    for (int i = 0; i < MODULE_COUNT; i++) {
+        isSame = isSame && pooled[i].succeeded == pipelined[i].succeeded && pooled[i].emittedBytes == pipelined[i].emittedBytes;
+        isReleased = isReleased && pooled[i].tokens == NULL && pooled[i].transUnitNode == NULL;
+        isReleased = isReleased && pipelined[i].tokens == NULL && pipelined[i].transUnitNode == NULL;
+    }
+
+    CHECK(isSame);
+    CHECK(isReleased);
+    CHECK(!pooled[MODULE_COUNT - 1].succeeded);
+
+    free(pooled);
+    free(pipelined);
+    freeThreadPool(pool);
+}
+
+int main() {
+    if (mkdtemp(directory) == NULL) {
+        printf("error: could not create a scratch directory.\n");
+        return 1;
+    }
+
+    testQueue();
+    testModes(buildModuleProject());
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        printf("warning: could not remove \"%s\".\n", directory);
+    }
+
+    return finishChecks("pipelinetest");
+}
\ No newline at end of file
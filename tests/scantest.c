@@ -0,0 +1,94 @@
+#include "../scan.h"
+#include "check.h"
+
+// A class with a designer block, every kind of public declaration, private ones that stay out of the
+// index, and a body whose string mentions the line that ends it.
+const char *const moduleText =
+    "VERSION 1.0 CLASS\n"
+    "BEGIN\n"
+    "  MultiUse = -1\n"
+    "END\n"
+    "Attribute VB_Name = \"Shape\"\n"
+    "Attribute VB_Creatable = True\n"
+    "Attribute VB_Exposed = True\n"
+    "Attribute VB_PredeclaredId = False\n"
+    "Option Explicit\n"
+    "Option Base 1\n"
+    "Option Compare Text\n"
+    "Implements IDrawable\n"
+    "Private mSides As Long\n"
+    "Public Total As Double\n"
+    "Public Const Limit = 10\n"
+    "Public Enum Kind\n"
+    "    Round\n"
+    "    Square\n"
+    "End Enum\n"
+    "Private Type Point\n"
+    "    X As Long\n"
+    "End Type\n"
+    "Public Function Area(ByVal w As Double) As Double\n"
+    "    Area = Helper(w) * Total\n"
+    "    Debug.Print \"End Function\"\n"
+    "End Function\n"
+    "Private Sub Helper()\n"
+    "End Sub\n"
+    "Public Property Get Sides() As Long\n"
+    "    Sides = mSides\n"
+    "End Property\n"
+    "Public Event Changed(ByVal n As Long)\n";
+
+const ScannedSymbol *findScannedSymbol(const ModuleScan *scan, const char *name) {
+    for (int i = 0; i < scan->symbols->size; i++) {
+        const ScannedSymbol *symbol = scan->symbols->contents[i];
+
+        if (strcmp(symbol->name, name) == 0) {
+            return symbol;
+        }
+    }
+
+    return NULL;
+}
+
+void testModuleHeader() {
+    ModuleScan *header = scanModuleHeader(moduleText, strlen(moduleText), true);
+
+    CHECK_STRING(header->moduleName, "Shape");
+    CHECK(header->isClass && header->isCreatable && header->isExposed && !header->isPredeclared);
+    CHECK(header->options == (MODULE_OPTION_EXPLICIT | MODULE_OPTION_COMPARE_TEXT) && header->optionBase == 1);
+    CHECK(header->implements->size == 1 && strcmp(header->implements->contents[0], "IDrawable") == 0);
+
+    // the body is skipped whole, so nothing it names is a reference, and private names are not the project's
+    CHECK(header->referenceCount == 0);
+    CHECK(findScannedSymbol(header, "Helper") == NULL && findScannedSymbol(header, "Point") == NULL && findScannedSymbol(header, "mSides") == NULL);
+    CHECK(findScannedSymbol(header, "Area") != NULL && findScannedSymbol(header, "Area")->kind == SYMBOL_FUNCTION);
+    CHECK(findScannedSymbol(header, "Sides") != NULL && findScannedSymbol(header, "Sides")->kind == SYMBOL_PROPERTY);
+    CHECK(findScannedSymbol(header, "Changed") != NULL && findScannedSymbol(header, "Changed")->kind == SYMBOL_EVENT);
+
+    freeModuleScan(header);
+}
+
+// the index built from headers alone is the one the full scan would build
+void testMatchesFullScan() {
+    ModuleScan *header = scanModuleHeader(moduleText, strlen(moduleText), true);
+    ModuleScan *full = scanModule(moduleText, strlen(moduleText), true);
+    bool isSame = (header->symbols->size == full->symbols->size);
+
+    for (int i = 0; isSame && i < header->symbols->size; i++) {
+        const ScannedSymbol *left = header->symbols->contents[i];
+        const ScannedSymbol *right = full->symbols->contents[i];
+        isSame = left->kind == right->kind && left->nameHash == right->nameHash && left->signatureHash == right->signatureHash;
+    }
+
+    CHECK(isSame);
+    CHECK(full->referenceCount > 0);
+
+    freeModuleScan(header);
+    freeModuleScan(full);
+}
+
+int main() {
+    testModuleHeader();
+    testMatchesFullScan();
+
+    return finishChecks("scantest");
+}
\ No newline at end of file
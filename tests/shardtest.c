@@ -0,0 +1,97 @@
+#include "../shard.h"
+#include "check.h"
+
+// Six modules in a scratch directory, the last of which does not parse.
+static char directory[] = "/tmp/shardtestXXXXXX";
+
+#define MODULE_COUNT 6
+
+Project *buildModuleProject() {
+    char paths[MODULE_COUNT][256];
+    char *files[MODULE_COUNT];
+
+    for (int i = 0; i < MODULE_COUNT; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/Module%d.bas", directory, i);
+        files[i] = paths[i];
+
+        FILE *fp = fopen(paths[i], "w");
+
+        for (int j = 0; j <= i; j++) {
+            fprintf(fp, "Public Function Step%d(n As Long) As Long\n    Step%d = n + %d\nEnd Function\n", j, j, j);
+        }
+
+        if (i == MODULE_COUNT - 1) {
+            fputs("Public Sub Broken(\n", fp);
+        }
+
+        fclose(fp);
+    }
+
+    return buildProjectFromFiles(files, MODULE_COUNT);
+}
+
+// the worker processes give the pool's results, and what they report reaches the coordinator against the right file
+void testSharded(const Project *project) {
+    ThreadPool *pool = buildThreadPool(2);
+    ShardOptions options;
+    ShardMetrics metrics;
+    TranspileSummary pooledSummary, shardedSummary;
+
+    initializeShardOptions(&options, 3);
+    freeDiagnostics(collectDiagnostics());
+
+    TranspileResult *pooled = transpileProject(project, pool, NULL, &pooledSummary);
+    Vector *pooledDiagnostics = collectDiagnostics();
+    TranspileResult *sharded = transpileProjectSharded(project, &options, NULL, &shardedSummary, &metrics);
+    Vector *shardedDiagnostics = collectDiagnostics();
+
+    CHECK(shardedSummary.fileCount == MODULE_COUNT && shardedSummary.failureCount == 1);
+    CHECK(metrics.processCount == 3 && metrics.shardCount > 0 && metrics.crashCount == 0);
+
+    bool isSame = true;
+
+    for (int i = 0; i < MODULE_COUNT; i++) {
+        isSame = isSame && pooled[i].succeeded == sharded[i].succeeded && pooled[i].emittedBytes == sharded[i].emittedBytes
+            && pooled[i].tokenCount == sharded[i].tokenCount && pooled[i].declarationCount == sharded[i].declarationCount;
+    }
+
+    CHECK(isSame);
+    CHECK(!sharded[MODULE_COUNT - 1].succeeded);
+
+    // the diagnostics come back through the pipe in the order and with the offsets the pool records
+    bool isForwarded = (shardedDiagnostics->size == pooledDiagnostics->size && shardedDiagnostics->size > 0);
+
+    for (int i = 0; isForwarded && i < shardedDiagnostics->size; i++) {
+        const Diagnostic *left = pooledDiagnostics->contents[i];
+        const Diagnostic *right = shardedDiagnostics->contents[i];
+        isForwarded = left->fileIndex == right->fileIndex && left->offset == right->offset && left->code == right->code
+            && left->severity == right->severity && strcmp(left->message, right->message) == 0;
+    }
+
+    CHECK(isForwarded);
+    CHECK(((const Diagnostic *)shardedDiagnostics->contents[0])->fileIndex == MODULE_COUNT - 1);
+
+    freeDiagnostics(pooledDiagnostics);
+    freeDiagnostics(shardedDiagnostics);
+    free(pooled);
+    free(sharded);
+    freeThreadPool(pool);
+}
+
+int main() {
+    if (mkdtemp(directory) == NULL) {
+        printf("error: could not create a scratch directory.\n");
+        return 1;
+    }
+
+    testSharded(buildModuleProject());
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+
+    if (system(command) != 0) {
+        printf("warning: could not remove \"%s\".\n", directory);
+    }
+
+    return finishChecks("shardtest");
+}
\ No newline at end of file
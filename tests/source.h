@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../decode.h"
+#include "../emitter.h"
+#include "../lexer.h"
+
+// For the tests that start from VB source: the module it parses to, one of its procedures, and the C# the
+// emitter writes for it, as a standard module named Test in a project named Project.
+static Project testProject = { .name = "Project", .codePage = DEFAULT_CODE_PAGE };
+static ProjectFile testFile = { .project = &testProject, .type = PROJECT_MODULE, .name = "Test", .path = "Test.bas" };
+
+static inline TransUnitNode *parseSource(const char *source) {
+    char *copy = strdup(source);
+    Vector *tokens = lex(copy);
+    TransUnitNode *transUnitNode = (tokens != NULL) ? parse(tokens) : NULL;
+
+    if (tokens != NULL) {
+        freeTokens(tokens);
+    }
+
+    free(copy);
+    return transUnitNode;
+}
+
+static inline FunctionDefinitionNode *findProcedure(const TransUnitNode *transUnitNode, const char *name) {
+    for (int i = 0; transUnitNode != NULL && i < transUnitNode->externalDeclarationNodes->size; i++) {
+        const ExternalDeclarationNode *externalDeclarationNode = transUnitNode->externalDeclarationNodes->contents[i];
+
+        if (externalDeclarationNode != NULL && externalDeclarationNode->functionDefinitionNode != NULL
+            && strcasecmp(getDeclaratorName(externalDeclarationNode->functionDefinitionNode->declaratorNode), name) == 0) {
+            return externalDeclarationNode->functionDefinitionNode;
+        }
+    }
+
+    return NULL;
+}
+
+// the whole module as C#, or NULL when the source does not parse; the caller frees it
+static inline char *emitSource(const char *source) {
+    TransUnitNode *transUnitNode = parseSource(source);
+
+    if (transUnitNode == NULL) {
+        return NULL;
+    }
+
+    Emitter *emitter = buildEmitter(&testFile, testProject.name);
+    emitTransUnit(emitter, transUnitNode);
+
+    char *text = malloc(emitter->output->size + 1);
+    long length = 0;
+
+    for (const OutputChunk *chunk = emitter->output->head; chunk != NULL; chunk = chunk->next) {
+        memcpy(&text[length], chunk->data, chunk->size);
+        length += chunk->size;
+    }
+
+    text[length] = '\0';
+    freeEmitter(emitter);
+    freeTransUnitNode(transUnitNode);
+    return text;
+}
\ No newline at end of file
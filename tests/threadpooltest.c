@@ -0,0 +1,101 @@
+#include "../threadpool.h"
+#include "check.h"
+
+// Tasks record the order they ran in; a spawning task submits more from inside a worker.
+typedef struct RunLog {
+    pthread_mutex_t lock;
+    int order[64];
+    int count;
+    ThreadPool *pool;
+} RunLog;
+
+typedef struct LoggedTask {
+    RunLog *log;
+    int id;
+    int spawnCount;
+} LoggedTask;
+
+void runLoggedTask(void *argument) {
+    LoggedTask *task = argument;
+    RunLog *log = task->log;
+
+    pthread_mutex_lock(&log->lock);
+    log->order[log->count++] = task->id;
+    pthread_mutex_unlock(&log->lock);
+
+    for (int i = 0; i < task->spawnCount; i++) {
+        submitThreadPool(log->pool, runLoggedTask, &task[i + 1]);
+    }
+}
+
+void testSubmissionOrder() {
+    RunLog log = { PTHREAD_MUTEX_INITIALIZER, { 0 }, 0, buildThreadPool(1) };
+    LoggedTask tasks[8];
+
+    for (int i = 0; i < 8; i++) {
+        tasks[i] = (LoggedTask){ &log, i, 0 };
+    }
+
+    for (int i = 0; i < 8; i++) {
+        submitThreadPool(log.pool, runLoggedTask, &tasks[i]);
+    }
+
+    waitThreadPool(log.pool);
+
+    // submitted largest first, so the worker has to run them in the order they came in
+    bool isInOrder = (log.count == 8);
+
+    for (int i = 0; isInOrder && i < 8; i++) {
+        isInOrder = (log.order[i] == i);
+    }
+
+    CHECK(isInOrder);
+    freeThreadPool(log.pool);
+}
+
+void testSpawnedTasks() {
+    RunLog log = { PTHREAD_MUTEX_INITIALIZER, { 0 }, 0, buildThreadPool(1) };
+    LoggedTask tasks[4] = { { &log, 0, 3 }, { &log, 1, 0 }, { &log, 2, 0 }, { &log, 3, 0 } };
+
+    submitThreadPool(log.pool, runLoggedTask, &tasks[0]);
+    waitThreadPool(log.pool);
+
+    // a worker's own tasks run newest first, while what they touch is still in its cache
+    CHECK(log.count == 4);
+    CHECK(log.order[0] == 0 && log.order[1] == 3 && log.order[2] == 2 && log.order[3] == 1);
+    freeThreadPool(log.pool);
+}
+
+void testEveryTaskRuns() {
+    RunLog log = { PTHREAD_MUTEX_INITIALIZER, { 0 }, 0, buildThreadPool(4) };
+    LoggedTask tasks[48];
+    bool seen[48] = { false };
+    bool isComplete = true;
+
+    for (int i = 0; i < 48; i++) {
+        tasks[i] = (LoggedTask){ &log, i, 0 };
+        submitThreadPool(log.pool, runLoggedTask, &tasks[i]);
+    }
+
+    waitThreadPool(log.pool);
+
+    for (int i = 0; i < log.count; i++) {
+        seen[log.order[i]] = true;
+    }
+
+    for (int i = 0; i < 48; i++) {
+        isComplete &= seen[i];
+    }
+
+    CHECK(log.count == 48);
+    CHECK(isComplete);
+    freeThreadPool(log.pool);
+}
+
+int main() {
+    testSubmissionOrder();
+    testSpawnedTasks();
+    testEveryTaskRuns();
+
+    return finishChecks("threadpooltest");
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <unistd.h>
+
+#include "../diagnostics.h"
+#include "../typelib.h"
+#include "check.h"
+
+const char *const libraryText =
+    "library Shapes {11111111-2222-3333-4444-555555555555} 1.0\n"
+    "type Circle class\n"
+    "member Radius property Property Radius As Double\n"
+    "member Draw method Sub Draw()\n"
+    "type Kind enum\n"
+    "member Round const Const Round = 1\n";
+
+// writes image to a temporary file with one corruption applied and maps it back
+TypeLibrary *mapCorruptedLibrary(const TypeLibrary *library, void (*corrupt)(char *data, long size)) {
+    char path[] = "/tmp/typelibtestXXXXXX";
+    const int fd = mkstemp(path);
+    char *data = malloc(library->size);
+
+    memcpy(data, library->data, library->size);
+
+    if (corrupt != NULL) {
+        corrupt(data, library->size);
+    }
+
+    const bool written = (write(fd, data, library->size) == library->size);
+    close(fd);
+    free(data);
+
+    TypeLibrary *mapped = written ? mapTypeLibrary(path) : NULL;
+    unlink(path);
+    return mapped;
+}
+
+void fillSlots(char *data, long size) {
+    LibraryHeader *header = (LibraryHeader*)data;
+    header->slotCount = 2;
+}
+
+void pointMemberPastStrings(char *data, long size) {
+    LibraryHeader *header = (LibraryHeader*)data;
+    LibraryMember *members = (LibraryMember*)&data[header->membersOffset];
+    members[1].nameOffset = size;
+}
+
+void overrunMembers(char *data, long size) {
+    LibraryHeader *header = (LibraryHeader*)data;
+    LibraryType *types = (LibraryType*)&data[header->typesOffset];
+    types[0].memberCount = header->memberCount + 1;
+}
+
+void pointSlotPastTypes(char *data, long size) {
+    LibraryHeader *header = (LibraryHeader*)data;
+    int32_t *slots = (int32_t*)&data[header->slotsOffset];
+
+    for (uint32_t i = 0; i < header->slotCount; i++) {
+        if (slots[i] >= 0) {
+            slots[i] = header->typeCount;
+            return;
+        }
+    }
+}
+
+void unterminateStrings(char *data, long size) {
+    data[size - 1] = 0x41;
+}
+
+void testMappedLibrary(const TypeLibrary *library) {
+    TypeLibrary *mapped = mapCorruptedLibrary(library, NULL);
+    CHECK(mapped != NULL);
+
+    if (mapped == NULL) {
+        return;
+    }
+
+    const LibraryType *circle = findLibraryType(mapped, "circle");
+    CHECK(circle != NULL);
+    CHECK(circle != NULL && findLibraryMember(mapped, circle, "Draw") != NULL);
+    CHECK(circle != NULL && findLibraryMember(mapped, circle, "Round") == NULL);
+    CHECK(findLibraryType(mapped, "Square") == NULL);
+    CHECK_STRING(getLibraryGuid(mapped), "11111111-2222-3333-4444-555555555555");
+    freeTypeLibrary(mapped);
+}
+
+// each corrupted image is refused with a warning against the project
+void testCorruptedLibraries(const TypeLibrary *library) {
+    void (*corruptions[])(char *data, long size) = { fillSlots, pointMemberPastStrings, overrunMembers, pointSlotPastTypes, unterminateStrings };
+    const int count = sizeof(corruptions) / sizeof(corruptions[0]);
+
+    freeDiagnostics(collectDiagnostics());
+
+    for (int i = 0; i < count; i++) {
+        TypeLibrary *mapped = mapCorruptedLibrary(library, corruptions[i]);
+        CHECK(mapped == NULL);
+
+        if (mapped != NULL) {
+            freeTypeLibrary(mapped);
+        }
+    }
+
+    Vector *diagnostics = collectDiagnostics();
+    bool isIgnored = (diagnostics->size == count);
+
+    for (int i = 0; i < diagnostics->size; i++) {
+        const Diagnostic *diagnostic = diagnostics->contents[i];
+        isIgnored = isIgnored && diagnostic->fileIndex == -1 && diagnostic->severity == DIAGNOSTIC_WARNING && diagnostic->code == DIAGNOSTIC_TYPE_LIBRARY_IGNORED;
+    }
+
+    CHECK(isIgnored);
+    freeDiagnostics(diagnostics);
+}
+
+int main() {
+    TypeLibrary *library = compileTypeLibrary(libraryText, "shapes.txt");
+    CHECK(library != NULL);
+
+    if (library != NULL) {
+        testMappedLibrary(library);
+        testCorruptedLibraries(library);
+        freeTypeLibrary(library);
+    }
+
+    return finishChecks("typelibtest");
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <limits.h>
+#include <sys/inotify.h>
+
+#include "../watch.h"
+#include "check.h"
+
+// The project names its file relative to the working directory, the way "vbt M.bas" does.
+static char directory[] = "/tmp/watchtestXXXXXX";
+
+void touchFile(const char *path) {
+    FILE *fp = fopen(path, "w");
+    fputs("Public Sub Main()\nEnd Sub\n", fp);
+    fclose(fp);
+}
+
+void testWatchPaths() {
+    char *bare = getWatchPath("M.bas");
+    char *dotted = getWatchPath("./M.bas");
+    char expected[PATH_MAX + 8];
+    char *canonical = realpath(".", NULL);
+    snprintf(expected, sizeof(expected), "%s/M.bas", canonical);
+
+    CHECK_STRING(bare, expected);
+    CHECK_STRING(dotted, expected);
+
+    free(bare);
+    free(dotted);
+    free(canonical);
+}
+
+void testBareFileEvents() {
+    char *paths[1] = { "M.bas" };
+    Project *project = buildProjectFromFiles(paths, 1);
+    const int fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    Vector *directories = addWatchDirectories(fd, project);
+    StringMap *fileMap = buildWatchFileMap(project);
+
+    CHECK(directories != NULL && directories->size == 1);
+
+    // only a save of a project file counts
+    touchFile("notes.txt");
+    CHECK(readWatchEvents(fd, directories, fileMap) == 0);
+
+    touchFile("M.bas");
+    CHECK(readWatchEvents(fd, directories, fileMap) == 1);
+
+    freeStringMap(fileMap);
+    close(fd);
+}
+
+int main() {
+    if (mkdtemp(directory) == NULL || chdir(directory) != 0) {
+        printf("error: could not create a scratch directory.\n");
+        return 1;
+    }
+
+    touchFile("M.bas");
+
+    testWatchPaths();
+    testBareFileEvents();
+
+    char command[300];
+    snprintf(command, sizeof(command), "rm -rf %s", directory);
+
+    if (chdir("/") != 0 || system(command) != 0) {
+        printf("warning: could not remove \"%s\".\n", directory);
+    }
+
+    return finishChecks("watchtest");
+}
\ No newline at end of file
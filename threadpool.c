@@ -0,0 +1,224 @@
+#include "threadpool.h"
+
+typedef struct WorkerContext {
+    ThreadPool *pool;
+    int id;
+} WorkerContext;
+
+static _Thread_local int currentWorker = -1;
+
+void initializeTaskDeque(TaskDeque *deque) {
+    deque->capacity = 64;
+    deque->tasks = malloc(sizeof(Task) * deque->capacity);
+    deque->head = 0;
+    deque->tail = 0;
+    deque->stealCount = 0;
+    pthread_mutex_init(&deque->lock, NULL);
+}
+
+void pushTaskDeque(TaskDeque *deque, Task task) {
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->tail - deque->head == deque->capacity) {
+        Task *tasks = malloc(sizeof(Task) * deque->capacity * 2);
+
+        for (int i = deque->head; i < deque->tail; i++) {
+            tasks[i - deque->head] = deque->tasks[i % deque->capacity];
+        }
+
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->tail -= deque->head;
+        deque->head = 0;
+        deque->capacity *= 2;
+    }
+
+    deque->tasks[deque->tail % deque->capacity] = task;
+    deque->tail++;
+
+    pthread_mutex_unlock(&deque->lock);
+}
+
+bool popTaskDeque(TaskDeque *deque, Task *task) {
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->tail == deque->head) {
+        pthread_mutex_unlock(&deque->lock);
+        return false;
+    }
+
+    if (deque->tasks[(deque->tail - 1) % deque->capacity].isSubmitted) {
+        *task = deque->tasks[deque->head % deque->capacity];
+        deque->head++;
+    }
+    else {
+        deque->tail--;
+        *task = deque->tasks[deque->tail % deque->capacity];
+    }
+
+    pthread_mutex_unlock(&deque->lock);
+    return true;
+}
+
+bool stealTaskDeque(TaskDeque *deque, Task *task) {
+    if (pthread_mutex_trylock(&deque->lock) != 0) {
+        return false;
+    }
+
+    if (deque->tail == deque->head) {
+        pthread_mutex_unlock(&deque->lock);
+        return false;
+    }
+
+    *task = deque->tasks[deque->head % deque->capacity];
+    deque->head++;
+    deque->stealCount++;
+
+    pthread_mutex_unlock(&deque->lock);
+    return true;
+}
+
+bool takeTask(ThreadPool *pool, int id, Task *task) {
+    if (popTaskDeque(&pool->deques[id], task)) {
+        return true;
+    }
+
+    for (int i = 1; i < pool->workerCount; i++) {
+        if (stealTaskDeque(&pool->deques[(id + i) % pool->workerCount], task)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void *runWorker(void *argument) {
+    WorkerContext *context = argument;
+    ThreadPool *pool = context->pool;
+    const int id = context->id;
+    free(context);
+
+    currentWorker = id;
+    Task task;
+
+    while (true) {
+        if (atomic_load(&pool->queued) > 0 && takeTask(pool, id, &task)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            task.function(task.argument);
+
+            if (atomic_fetch_sub(&pool->pending, 1) == 1) {
+                pthread_mutex_lock(&pool->lock);
+                pthread_cond_broadcast(&pool->allDone);
+                pthread_mutex_unlock(&pool->lock);
+            }
+
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+
+        while (atomic_load(&pool->queued) == 0 && !pool->shutdown) {
+            pthread_cond_wait(&pool->taskAvailable, &pool->lock);
+        }
+
+        const bool shutdown = pool->shutdown && atomic_load(&pool->queued) == 0;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (shutdown) {
+            return NULL;
+        }
+    }
+}
+
+ThreadPool *buildThreadPool(int workerCount) {
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    pool->workerCount = (workerCount < 1) ? getCoreCount() : workerCount;
+    pool->threads = calloc(pool->workerCount, sizeof(pthread_t));
+    pool->deques = calloc(pool->workerCount, sizeof(TaskDeque));
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->pending, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->taskAvailable, NULL);
+    pthread_cond_init(&pool->allDone, NULL);
+
+    for (int i = 0; i < pool->workerCount; i++) {
+        initializeTaskDeque(&pool->deques[i]);
+    }
+
+    for (int i = 0; i < pool->workerCount; i++) {
+        WorkerContext *context = malloc(sizeof(WorkerContext));
+        context->pool = pool;
+        context->id = i;
+
+        if (pthread_create(&pool->threads[i], NULL, runWorker, context) != 0) {
+            printf("error: could not create worker thread %d.\n", i);
+            exit(-1);
+        }
+    }
+
+    return pool;
+}
+
+void submitThreadPool(ThreadPool *pool, void (*function)(void *argument), void *argument) {
+    int id = currentWorker;
+    Task task = { function, argument, id < 0 || id >= pool->workerCount };
+
+    // tasks spawned by a worker stay local, outside submissions are dealt round-robin and so still run in
+    // the order they came in
+    if (task.isSubmitted) {
+        id = pool->nextDeque;
+        pool->nextDeque = (pool->nextDeque + 1) % pool->workerCount;
+    }
+
+    atomic_fetch_add(&pool->pending, 1);
+    pushTaskDeque(&pool->deques[id], task);
+    atomic_fetch_add(&pool->queued, 1);
+
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->taskAvailable);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void waitThreadPool(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+
+    while (atomic_load(&pool->pending) > 0) {
+        pthread_cond_wait(&pool->allDone, &pool->lock);
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void freeThreadPool(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->taskAvailable);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->workerCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+        free(pool->deques[i].tasks);
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->taskAvailable);
+    pthread_cond_destroy(&pool->allDone);
+    free(pool->threads);
+    free(pool->deques);
+    free(pool);
+}
+
+int getCurrentWorker() {
+    return currentWorker;
+}
+
+long getStealCount(const ThreadPool *pool) {
+    long count = 0;
+
+    for (int i = 0; i < pool->workerCount; i++) {
+        count += pool->deques[i].stealCount;
+    }
+
+    return count;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "util.h"
+
+// isSubmitted marks a task submitted from outside the pool rather than spawned by a worker
+typedef struct Task {
+    void (*function)(void *argument);
+    void *argument;
+    bool isSubmitted;
+} Task;
+
+// Owner pushes at the tail and thieves take from the head. The owner pops its own spawned tasks from the
+// tail, newest first, and submitted ones from the head, in the order they were submitted.
+typedef struct TaskDeque {
+    Task *tasks;
+    int head;
+    int tail;
+    int capacity;
+    long stealCount;
+    pthread_mutex_t lock;
+} TaskDeque;
+
+typedef struct ThreadPool {
+    int workerCount;
+    int nextDeque;
+    bool shutdown;
+    pthread_t *threads;
+    TaskDeque *deques;
+    atomic_int queued;
+    atomic_int pending;
+    pthread_mutex_t lock;
+    pthread_cond_t taskAvailable;
+    pthread_cond_t allDone;
+} ThreadPool;
+
+ThreadPool *buildThreadPool(int workerCount);
+void submitThreadPool(ThreadPool *pool, void (*function)(void *argument), void *argument);
+void waitThreadPool(ThreadPool *pool);
+void freeThreadPool(ThreadPool *pool);
+int getCurrentWorker();
+long getStealCount(const ThreadPool *pool);
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <math.h>
+
+#include "baseline.h"
+
+bool writeBaseline(const char *path, const Baseline *baseline) {
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        printf("error: could not write baseline \"%s\".\n", path);
+        return false;
+    }
+
+    fprintf(fp, "{\n  \"sourceBytes\": %ld,\n  \"tokens\": %ld,\n  \"stages\": {\n", baseline->sourceBytes, baseline->tokenCount);
+
+    for (int i = 0; i < baseline->stageCount; i++) {
+        const BaselineStage *stage = &baseline->stages[i];
+
+        fprintf(fp, "    \"%s\": [", stage->name);
+
+        for (int j = 0; j < stage->count; j++) {
+            fprintf(fp, "%s%.6g", (j > 0) ? ", " : "", stage->rates[j]);
+        }
+
+        fprintf(fp, "]%s\n", (i + 1 < baseline->stageCount) ? "," : "");
+    }
+
+    fprintf(fp, "  }\n}\n");
+    fclose(fp);
+    return true;
+}
+
+const char *skipJsonSpace(const char *p) {
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+
+    return p;
+}
+
+// Reads only what writeBaseline writes: two counts and an object of number arrays, in any order or spacing.
+bool readBaseline(const char *path, Baseline *baseline) {
+    char *text = readFile(path);
+
+    if (text == NULL) {
+        printf("error: could not read baseline \"%s\".\n", path);
+        return false;
+    }
+
+    memset(baseline, 0, sizeof(Baseline));
+
+    const char *bytes = strstr(text, "\"sourceBytes\":");
+    const char *tokens = strstr(text, "\"tokens\":");
+    const char *p = strstr(text, "\"stages\":");
+
+    if (bytes == NULL || tokens == NULL || p == NULL || *(p = skipJsonSpace(p + 9)) != '{') {
+        printf("error: \"%s\" is not a vbbench baseline.\n", path);
+        free(text);
+        return false;
+    }
+
+    baseline->sourceBytes = strtol(bytes + 14, NULL, 10);
+    baseline->tokenCount = strtol(tokens + 9, NULL, 10);
+    p = skipJsonSpace(p + 1);
+
+    while (*p == '"' && baseline->stageCount < 8) {
+        BaselineStage *stage = &baseline->stages[baseline->stageCount++];
+        const char *end = strchr(p + 1, '"');
+
+        if (end == NULL) {
+            break;
+        }
+
+        snprintf(stage->name, sizeof(stage->name), "%.*s", (int)(end - p - 1), p + 1);
+        p = skipJsonSpace(end + 1);
+        p = (*p == ':') ? skipJsonSpace(p + 1) : p;
+        p = (*p == '[') ? skipJsonSpace(p + 1) : p;
+
+        while (*p != ']' && *p != '\0') {
+            char *next;
+            const double rate = strtod(p, &next);
+
+            if (next == p) {
+                break;
+            }
+
+            if (stage->count < BASELINE_MAX_SAMPLES) {
+                stage->rates[stage->count++] = rate;
+            }
+
+            p = skipJsonSpace(next);
+            p = (*p == ',') ? skipJsonSpace(p + 1) : p;
+        }
+
+        p = (*p == ']') ? skipJsonSpace(p + 1) : p;
+        p = (*p == ',') ? skipJsonSpace(p + 1) : p;
+    }
+
+    free(text);
+    return true;
+}
+
+const BaselineStage *findBaselineStage(const Baseline *baseline, const char *name) {
+    for (int i = 0; i < baseline->stageCount; i++) {
+        if (strcmp(baseline->stages[i].name, name) == 0) {
+            return &baseline->stages[i];
+        }
+    }
+
+    return NULL;
+}
+
+int compareDoubles(const void *left, const void *right) {
+    const double a = *(const double*)left;
+    const double b = *(const double*)right;
+
+    return (a < b) ? -1 : (a > b) ? 1 : 0;
+}
+
+double getMedian(const double *values, int count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    double *sorted = malloc(sizeof(double) * count);
+    memcpy(sorted, values, sizeof(double) * count);
+    qsort(sorted, count, sizeof(double), compareDoubles);
+
+    const double median = (count % 2 == 1) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+
+    free(sorted);
+    return median;
+}
+
+typedef struct RankedValue {
+    double value;
+    bool current;
+} RankedValue;
+
+int compareRankedValues(const void *left, const void *right) {
+    return compareDoubles(&((const RankedValue*)left)->value, &((const RankedValue*)right)->value);
+}
+
+// One-sided Mann-Whitney U: the chance of the current rates ranking this low if nothing changed. Normal
+// approximation with tie and continuity corrections, which holds from about eight passes a side.
+double getMannWhitneyLowerP(const double *current, int currentCount, const double *previous, int previousCount) {
+    const int total = currentCount + previousCount;
+
+    if (currentCount == 0 || previousCount == 0) {
+        return 1;
+    }
+
+    RankedValue *values = malloc(sizeof(RankedValue) * total);
+
+    for (int i = 0; i < total; i++) {
+        values[i].current = (i < currentCount);
+        values[i].value = values[i].current ? current[i] : previous[i - currentCount];
+    }
+
+    qsort(values, total, sizeof(RankedValue), compareRankedValues);
+
+    double rankSum = 0, ties = 0;
+
+    for (int i = 0; i < total;) {
+        int j = i;
+
+        while (j < total && values[j].value == values[i].value) {
+            j++;
+        }
+
+        // positions i..j-1 share the average of ranks i+1..j
+        const double rank = (i + 1 + j) / 2.0;
+        const double run = j - i;
+
+        for (int k = i; k < j; k++) {
+            rankSum += values[k].current ? rank : 0;
+        }
+
+        ties += run * run * run - run;
+        i = j;
+    }
+
+    free(values);
+
+    const double u = rankSum - currentCount * (currentCount + 1) / 2.0;
+    const double mean = currentCount * (double)previousCount / 2;
+    const double variance = currentCount * (double)previousCount / 12 * ((total + 1) - ties / (total * (double)(total - 1)));
+
+    if (variance <= 0) {
+        return 1;
+    }
+
+    const double z = (u - mean + 0.5) / sqrt(variance);
+    return 0.5 * erfc(-z / sqrt(2));
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "../util.h"
+
+#define BASELINE_MAX_SAMPLES 256
+
+// per-stage throughput of every measured pass, as saved by vbbench -s
+typedef struct BaselineStage {
+    char name[16];
+    double rates[BASELINE_MAX_SAMPLES];
+    int count;
+} BaselineStage;
+
+typedef struct Baseline {
+    long sourceBytes;
+    long tokenCount;
+    BaselineStage stages[8];
+    int stageCount;
+} Baseline;
+
+bool writeBaseline(const char *path, const Baseline *baseline);
+bool readBaseline(const char *path, Baseline *baseline);
+const BaselineStage *findBaselineStage(const Baseline *baseline, const char *name);
+double getMannWhitneyLowerP(const double *current, int currentCount, const double *previous, int previousCount);
+double getMedian(const double *values, int count);
\ No newline at end of file
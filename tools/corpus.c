@@ -0,0 +1,641 @@
+#include <errno.h>
+
+#include "corpus.h"
+
+static const char *const statementNames[STATEMENT_KIND_COUNT] = {
+    "assign",
+    "if",
+    "loop",
+    "call",
+    "select"
+};
+
+static const char *const operandNames[] = { "a", "b", "x", "y", "total", "count" };
+static const char *const operatorNames[] = { "+", "-", "*", "\\", "Mod" };
+static const char *const commentWords[] = { "update", "the", "running", "total", "check", "bounds", "before", "next", "pass", "value" };
+
+void initializeCorpusOptions(CorpusOptions *options) {
+    const int mix[STATEMENT_KIND_COUNT] = { 40, 20, 15, 15, 10 };
+
+    options->seed = 1;
+    options->moduleCount = 40;
+    options->classCount = 8;
+    options->formCount = 4;
+    options->procedureCount = 20;
+    options->statementCount = 12;
+    options->expressionDepth = 3;
+    options->commentPercent = 15;
+    options->variantPercent = 0;
+    options->reportCount = 0;
+    options->appendCount = 0;
+    options->lookupCount = 0;
+    options->guardCount = 0;
+    memcpy(options->statementMix, mix, sizeof(mix));
+}
+
+// "assign,if,loop,call,select" weights, e.g. "40,20,15,15,10"
+bool parseStatementMix(CorpusOptions *options, const char *text) {
+    int *mix = options->statementMix;
+
+    if (sscanf(text, "%d,%d,%d,%d,%d", &mix[0], &mix[1], &mix[2], &mix[3], &mix[4]) != STATEMENT_KIND_COUNT) {
+        printf("error: expected five statement weights (assign,if,loop,call,select), got \"%s\".\n", text);
+        return false;
+    }
+
+    return true;
+}
+
+bool parseCorpusOption(CorpusOptions *options, const char *name, const char *value) {
+    if (strcmp(name, "seed") == 0) {
+        options->seed = strtoull(value, NULL, 10);
+    }
+    else if (strcmp(name, "modules") == 0) {
+        options->moduleCount = atoi(value);
+    }
+    else if (strcmp(name, "classes") == 0) {
+        options->classCount = atoi(value);
+    }
+    else if (strcmp(name, "forms") == 0) {
+        options->formCount = atoi(value);
+    }
+    else if (strcmp(name, "procedures") == 0) {
+        options->procedureCount = atoi(value);
+    }
+    else if (strcmp(name, "statements") == 0) {
+        options->statementCount = atoi(value);
+    }
+    else if (strcmp(name, "depth") == 0) {
+        options->expressionDepth = atoi(value);
+    }
+    else if (strcmp(name, "comments") == 0) {
+        options->commentPercent = atoi(value);
+    }
+    else if (strcmp(name, "variants") == 0) {
+        options->variantPercent = atoi(value);
+    }
+    else if (strcmp(name, "reports") == 0) {
+        options->reportCount = atoi(value);
+    }
+    else if (strcmp(name, "appends") == 0) {
+        options->appendCount = atoi(value);
+    }
+    else if (strcmp(name, "lookups") == 0) {
+        options->lookupCount = atoi(value);
+    }
+    else if (strcmp(name, "guards") == 0) {
+        options->guardCount = atoi(value);
+    }
+    else if (strcmp(name, "mix") == 0) {
+        return parseStatementMix(options, value);
+    }
+    else {
+        printf("error: unknown corpus option \"%s\".\n", name);
+        return false;
+    }
+
+    return true;
+}
+
+// splitmix64; each file gets its own stream so adding modules does not change the ones before it
+uint64_t nextRandom(CorpusGenerator *generator) {
+    uint64_t z = (generator->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int randomBelow(CorpusGenerator *generator, int bound) {
+    return (bound > 0) ? (int)(nextRandom(generator) % bound) : 0;
+}
+
+void initializeCorpusGenerator(CorpusGenerator *generator, const CorpusOptions *options, uint64_t stream) {
+    generator->options = options;
+    generator->state = options->seed * 0x2545F4914F6CDD1DULL + stream;
+    generator->capacity = 1 << 16;
+    generator->text = malloc(generator->capacity);
+    generator->size = 0;
+    generator->mixTotal = 0;
+
+    for (int i = 0; i < STATEMENT_KIND_COUNT; i++) {
+        generator->mixTotal += options->statementMix[i];
+    }
+}
+
+void appendCorpusText(CorpusGenerator *generator, const char *format, ...) {
+    va_list arguments;
+
+    while (true) {
+        const long available = generator->capacity - generator->size;
+
+        va_start(arguments, format);
+        const int length = vsnprintf(&generator->text[generator->size], available, format, arguments);
+        va_end(arguments);
+
+        if (length < available) {
+            generator->size += length;
+            return;
+        }
+
+        generator->capacity *= 2;
+        generator->text = realloc(generator->text, generator->capacity);
+    }
+}
+
+void appendIndent(CorpusGenerator *generator, int indent) {
+    appendCorpusText(generator, "%*s", indent * 4, "");
+}
+
+void generateExpression(CorpusGenerator *generator, int depth) {
+    if (depth <= 0 || randomBelow(generator, 4) == 0) {
+        if (randomBelow(generator, 3) == 0) {
+            appendCorpusText(generator, "%d", randomBelow(generator, 1000));
+        }
+        else {
+            appendCorpusText(generator, "%s", operandNames[randomBelow(generator, 6)]);
+        }
+
+        return;
+    }
+
+    appendCorpusText(generator, "(");
+    generateExpression(generator, depth - 1);
+    appendCorpusText(generator, " %s ", operatorNames[randomBelow(generator, 5)]);
+    generateExpression(generator, depth - 1);
+    appendCorpusText(generator, ")");
+}
+
+void generateComment(CorpusGenerator *generator, int indent) {
+    if (randomBelow(generator, 100) >= generator->options->commentPercent) {
+        return;
+    }
+
+    const int wordCount = 3 + randomBelow(generator, 8);
+    appendIndent(generator, indent);
+    appendCorpusText(generator, "'");
+
+    for (int i = 0; i < wordCount; i++) {
+        appendCorpusText(generator, " %s", commentWords[randomBelow(generator, 10)]);
+    }
+
+    appendCorpusText(generator, "\r\n");
+}
+
+int pickStatementKind(CorpusGenerator *generator) {
+    int pick = randomBelow(generator, generator->mixTotal);
+
+    for (int i = 0; i < STATEMENT_KIND_COUNT; i++) {
+        if (pick < generator->options->statementMix[i]) {
+            return i;
+        }
+
+        pick -= generator->options->statementMix[i];
+    }
+
+    return STATEMENT_ASSIGN;
+}
+
+void generateStatements(CorpusGenerator *generator, int count, int indent, int nesting);
+
+void generateStatement(CorpusGenerator *generator, int indent, int nesting) {
+    const CorpusOptions *options = generator->options;
+    const int depth = options->expressionDepth;
+    int kind = pickStatementKind(generator);
+
+    // nested blocks stay shallow so statement counts mean roughly what they say
+    if (nesting >= 2 && kind != STATEMENT_CALL) {
+        kind = STATEMENT_ASSIGN;
+    }
+
+    generateComment(generator, indent);
+    appendIndent(generator, indent);
+
+    switch (kind) {
+        case STATEMENT_IF: {
+            appendCorpusText(generator, "If ");
+            generateExpression(generator, depth);
+            appendCorpusText(generator, " > %d Then\r\n", randomBelow(generator, 100));
+            generateStatements(generator, 1 + randomBelow(generator, 2), indent + 1, nesting + 1);
+            appendIndent(generator, indent);
+            appendCorpusText(generator, "Else\r\n");
+            generateStatements(generator, 1 + randomBelow(generator, 2), indent + 1, nesting + 1);
+            appendIndent(generator, indent);
+            appendCorpusText(generator, "End If\r\n");
+            break;
+        }
+        case STATEMENT_LOOP: {
+            if (randomBelow(generator, 2) == 0) {
+                appendCorpusText(generator, "For i = 1 To %d\r\n", 2 + randomBelow(generator, 50));
+                generateStatements(generator, 1 + randomBelow(generator, 3), indent + 1, nesting + 1);
+                appendIndent(generator, indent);
+                appendCorpusText(generator, "Next i\r\n");
+            }
+            else {
+                appendCorpusText(generator, "Do While count < %d\r\n", 2 + randomBelow(generator, 50));
+                generateStatements(generator, 1 + randomBelow(generator, 3), indent + 1, nesting + 1);
+                appendIndent(generator, indent + 1);
+                appendCorpusText(generator, "count = count + 1\r\n");
+                appendIndent(generator, indent);
+                appendCorpusText(generator, "Loop\r\n");
+            }
+
+            break;
+        }
+        case STATEMENT_CALL: {
+            appendCorpusText(generator, "total = Compute%d_%d(",
+                randomBelow(generator, (options->moduleCount > 0) ? options->moduleCount : 1),
+                randomBelow(generator, (options->procedureCount > 0) ? options->procedureCount : 1));
+            generateExpression(generator, depth - 1);
+            appendCorpusText(generator, ", ");
+            generateExpression(generator, depth - 1);
+            appendCorpusText(generator, ")\r\n");
+            break;
+        }
+        case STATEMENT_SELECT: {
+            const int caseCount = 2 + randomBelow(generator, 3);
+            appendCorpusText(generator, "Select Case x\r\n");
+
+            for (int i = 0; i < caseCount; i++) {
+                appendIndent(generator, indent + 1);
+                appendCorpusText(generator, "Case %d\r\n", i);
+                generateStatements(generator, 1, indent + 2, nesting + 1);
+            }
+
+            appendIndent(generator, indent + 1);
+            appendCorpusText(generator, "Case Else\r\n");
+            generateStatements(generator, 1, indent + 2, nesting + 1);
+            appendIndent(generator, indent);
+            appendCorpusText(generator, "End Select\r\n");
+            break;
+        }
+        default: {
+            appendCorpusText(generator, "%s = ", operandNames[2 + randomBelow(generator, 4)]);
+            generateExpression(generator, depth);
+            appendCorpusText(generator, "\r\n");
+            break;
+        }
+    }
+}
+
+void generateStatements(CorpusGenerator *generator, int count, int indent, int nesting) {
+    for (int i = 0; i < count; i++) {
+        generateStatement(generator, indent, nesting);
+    }
+}
+
+// x, y and total only ever hold integers, so when declared As Variant type inference can narrow them
+void generateProcedureBody(CorpusGenerator *generator) {
+    const char *const localNames[] = { "x", "y", "i", "count", "total" };
+    const bool isNarrowable[] = { true, true, false, false, true };
+
+    for (int i = 0; i < 5; i++) {
+        // no draw when the knob is off, so default corpora keep their bytes
+        const bool isVariant = isNarrowable[i] && generator->options->variantPercent > 0 && randomBelow(generator, 100) < generator->options->variantPercent;
+        appendCorpusText(generator, "    Dim %s As %s\r\n", localNames[i], isVariant ? "Variant" : "Long");
+    }
+
+    appendCorpusText(generator, "\r\n");
+    generateStatements(generator, generator->options->statementCount, 1, 0);
+}
+
+char *finishCorpusGenerator(CorpusGenerator *generator, long *length) {
+    *length = generator->size;
+    return generator->text;
+}
+
+char *generateModule(const CorpusOptions *options, int moduleIndex, long *length) {
+    CorpusGenerator generator;
+    initializeCorpusGenerator(&generator, options, 0x100000 + moduleIndex);
+
+    appendCorpusText(&generator, "Attribute VB_Name = \"Module%d\"\r\nOption Explicit\r\n\r\n", moduleIndex);
+    appendCorpusText(&generator, "Public Const LIMIT_%d As Long = %d\r\n", moduleIndex, 100 + randomBelow(&generator, 900));
+    appendCorpusText(&generator, "Private calls%d As Long\r\n\r\n", moduleIndex);
+
+    for (int i = 0; i < options->procedureCount; i++) {
+        generateComment(&generator, 0);
+        appendCorpusText(&generator, "Public Function Compute%d_%d(ByVal a As Long, ByVal b As Long) As Long\r\n", moduleIndex, i);
+        generateProcedureBody(&generator);
+        appendCorpusText(&generator, "    Compute%d_%d = total\r\nEnd Function\r\n\r\n", moduleIndex, i);
+    }
+
+    return finishCorpusGenerator(&generator, length);
+}
+
+char *generateClass(const CorpusOptions *options, int classIndex, long *length) {
+    CorpusGenerator generator;
+    initializeCorpusGenerator(&generator, options, 0x200000 + classIndex);
+
+    appendCorpusText(&generator, "VERSION 1.0 CLASS\r\nBEGIN\r\n  MultiUse = -1  'True\r\nEND\r\n");
+    appendCorpusText(&generator, "Attribute VB_Name = \"Class%d\"\r\nAttribute VB_Creatable = True\r\nAttribute VB_Exposed = False\r\nOption Explicit\r\n\r\n", classIndex);
+    appendCorpusText(&generator, "Private m_value As Long\r\n\r\n");
+    appendCorpusText(&generator, "Public Property Get Value() As Long\r\n    Value = m_value\r\nEnd Property\r\n\r\n");
+    appendCorpusText(&generator, "Public Property Let Value(ByVal newValue As Long)\r\n    m_value = newValue\r\nEnd Property\r\n\r\n");
+
+    for (int i = 0; i < options->procedureCount; i++) {
+        generateComment(&generator, 0);
+        appendCorpusText(&generator, "Public Function Method%d(ByVal a As Long, ByVal b As Long) As Long\r\n", i);
+        generateProcedureBody(&generator);
+        appendCorpusText(&generator, "    Method%d = total + m_value\r\nEnd Function\r\n\r\n", i);
+    }
+
+    return finishCorpusGenerator(&generator, length);
+}
+
+char *generateForm(const CorpusOptions *options, int formIndex, long *length) {
+    CorpusGenerator generator;
+    const int buttonCount = 2 + formIndex % 4;
+    initializeCorpusGenerator(&generator, options, 0x300000 + formIndex);
+
+    appendCorpusText(&generator, "VERSION 5.00\r\nBegin VB.Form Form%d\r\n   Caption = \"Form%d\"\r\n   ClientHeight = 3195\r\n   ClientWidth = 4680\r\n", formIndex, formIndex);
+
+    for (int i = 0; i < buttonCount; i++) {
+        appendCorpusText(&generator, "   Begin VB.CommandButton Command%d\r\n      Caption = \"Command%d\"\r\n      Height = 495\r\n      Left = %d\r\n      Top = %d\r\n      Width = 1215\r\n   End\r\n", i, i, 120 + i * 1320, 120);
+    }
+
+    appendCorpusText(&generator, "End\r\nAttribute VB_Name = \"Form%d\"\r\nAttribute VB_PredeclaredId = True\r\nOption Explicit\r\n\r\n", formIndex);
+
+    for (int i = 0; i < buttonCount; i++) {
+        appendCorpusText(&generator, "Private Sub Command%d_Click()\r\n    Dim a As Long\r\n    Dim b As Long\r\n", i);
+        generateProcedureBody(&generator);
+        appendCorpusText(&generator, "End Sub\r\n\r\n");
+    }
+
+    return finishCorpusGenerator(&generator, length);
+}
+
+// Report modules build their text a line at a time in loops, the shape that string concatenation
+// makes quadratic and that the emitter lowers to a StringBuilder.
+char *generateReport(const CorpusOptions *options, int reportIndex, long *length) {
+    CorpusGenerator generator;
+    initializeCorpusGenerator(&generator, options, 0x400000 + reportIndex);
+
+    appendCorpusText(&generator, "Attribute VB_Name = \"Report%d\"\r\nOption Explicit\r\n\r\n", reportIndex);
+
+    for (int i = 0; i < options->procedureCount; i++) {
+        generateComment(&generator, 0);
+        appendCorpusText(&generator, "Public Function BuildReport%d_%d(ByVal rows As Long, ByVal k As Long) As String\r\n", reportIndex, i);
+        appendCorpusText(&generator, "    Dim report As String\r\n    Dim i As Long\r\n    Dim subtotal As Long\r\n\r\n");
+        appendCorpusText(&generator, "    report = \"Report %d\" & vbCrLf\r\n", i);
+        appendCorpusText(&generator, "    For i = 1 To rows\r\n");
+        appendCorpusText(&generator, "        subtotal = subtotal + i * k\r\n");
+        appendCorpusText(&generator, "        report = report & \"row \" & i & \": \" & (i * k) & vbCrLf\r\n");
+        appendCorpusText(&generator, "        If i Mod %d = 0 Then\r\n", 2 + randomBelow(&generator, 9));
+        appendCorpusText(&generator, "            report = report & \"subtotal \" & subtotal & vbCrLf\r\n");
+        appendCorpusText(&generator, "        End If\r\n    Next i\r\n\r\n");
+        appendCorpusText(&generator, "    BuildReport%d_%d = report\r\nEnd Function\r\n\r\n", reportIndex, i);
+    }
+
+    return finishCorpusGenerator(&generator, length);
+}
+
+// Append modules grow arrays one element at a time with ReDim Preserve, which is quadratic when each
+// resize copies the whole array.
+char *generateAppend(const CorpusOptions *options, int appendIndex, long *length) {
+    CorpusGenerator generator;
+    initializeCorpusGenerator(&generator, options, 0x500000 + appendIndex);
+
+    appendCorpusText(&generator, "Attribute VB_Name = \"Append%d\"\r\nOption Explicit\r\n\r\n", appendIndex);
+
+    for (int i = 0; i < options->procedureCount; i++) {
+        generateComment(&generator, 0);
+        appendCorpusText(&generator, "Public Function Collect%d_%d(ByVal n As Long) As Long\r\n", appendIndex, i);
+        appendCorpusText(&generator, "    Dim values() As Long\r\n    Dim i As Long\r\n\r\n");
+        appendCorpusText(&generator, "    ReDim values(0)\r\n");
+        appendCorpusText(&generator, "    For i = 1 To n\r\n");
+        appendCorpusText(&generator, "        If i Mod %d <> 0 Then\r\n", 2 + randomBelow(&generator, 9));
+        appendCorpusText(&generator, "            ReDim Preserve values(UBound(values) + 1)\r\n");
+        appendCorpusText(&generator, "            values(UBound(values)) = i * i\r\n");
+        appendCorpusText(&generator, "        End If\r\n    Next i\r\n\r\n");
+        appendCorpusText(&generator, "    Collect%d_%d = UBound(values)\r\nEnd Function\r\n\r\n", appendIndex, i);
+    }
+
+    return finishCorpusGenerator(&generator, length);
+}
+
+// Lookup modules fill a Scripting.Dictionary and a Collection, then look up and walk them by position,
+// which is late-bound and Variant-valued unless the emitter proves their key and item types.
+char *generateLookup(const CorpusOptions *options, int lookupIndex, long *length) {
+    CorpusGenerator generator;
+    initializeCorpusGenerator(&generator, options, 0x600000 + lookupIndex);
+
+    appendCorpusText(&generator, "Attribute VB_Name = \"Lookup%d\"\r\nOption Explicit\r\n\r\n", lookupIndex);
+
+    for (int i = 0; i < options->procedureCount; i++) {
+        generateComment(&generator, 0);
+        appendCorpusText(&generator, "Public Function Tally%d_%d(ByVal n As Long) As Long\r\n", lookupIndex, i);
+        appendCorpusText(&generator, "    Dim counts As Object\r\n    Dim order As New Collection\r\n    Dim key As String\r\n    Dim i As Long\r\n    Dim total As Long\r\n\r\n");
+        appendCorpusText(&generator, "    Set counts = CreateObject(\"Scripting.Dictionary\")\r\n");
+        appendCorpusText(&generator, "    counts.CompareMode = vbTextCompare\r\n");
+        appendCorpusText(&generator, "    For i = 1 To n\r\n");
+        appendCorpusText(&generator, "        key = \"k\" & (i Mod %d)\r\n", 5 + randomBelow(&generator, 50));
+        appendCorpusText(&generator, "        If Not counts.Exists(key) Then\r\n            order.Add key\r\n        End If\r\n");
+        appendCorpusText(&generator, "        counts(key) = counts(key) + i\r\n    Next i\r\n\r\n");
+        appendCorpusText(&generator, "    For i = 1 To order.Count\r\n");
+        appendCorpusText(&generator, "        total = total + counts(order(i))\r\n    Next i\r\n\r\n");
+        appendCorpusText(&generator, "    Tally%d_%d = total\r\nEnd Function\r\n\r\n", lookupIndex, i);
+    }
+
+    return finishCorpusGenerator(&generator, length);
+}
+
+// Guard modules run mostly arithmetic under On Error Resume Next and under an On Error GoTo handler that
+// resumes. Each procedure takes the divisor of its one Mod, so passing 0 benchmarks the error path and
+// anything else the path that never raises.
+char *generateGuard(const CorpusOptions *options, int guardIndex, long *length) {
+    CorpusGenerator generator;
+    initializeCorpusGenerator(&generator, options, 0x700000 + guardIndex);
+
+    appendCorpusText(&generator, "Attribute VB_Name = \"Guard%d\"\r\nOption Explicit\r\n\r\n", guardIndex);
+
+    for (int i = 0; i < options->procedureCount; i++) {
+        generateComment(&generator, 0);
+        appendCorpusText(&generator, "Public Function Skip%d_%d(ByVal n As Long, ByVal d As Long) As Long\r\n", guardIndex, i);
+        appendCorpusText(&generator, "    Dim i As Long\r\n    Dim part As Long\r\n    Dim total As Long\r\n\r\n");
+        appendCorpusText(&generator, "    On Error Resume Next\r\n");
+        appendCorpusText(&generator, "    For i = 1 To n\r\n");
+        appendCorpusText(&generator, "        part = i * %d + total\r\n", 2 + randomBelow(&generator, 9));
+        appendCorpusText(&generator, "        total = total + (part Mod d)\r\n");
+        appendCorpusText(&generator, "        total = total + 1\r\n    Next i\r\n\r\n");
+        appendCorpusText(&generator, "    Skip%d_%d = total\r\nEnd Function\r\n\r\n", guardIndex, i);
+
+        appendCorpusText(&generator, "Public Function Handle%d_%d(ByVal n As Long, ByVal d As Long) As Long\r\n", guardIndex, i);
+        appendCorpusText(&generator, "    Dim i As Long\r\n    Dim total As Long\r\n\r\n");
+        appendCorpusText(&generator, "    On Error GoTo Failed\r\n");
+        appendCorpusText(&generator, "    For i = 1 To n\r\n");
+        appendCorpusText(&generator, "        total = total + i * %d\r\n    Next i\r\n", 2 + randomBelow(&generator, 9));
+        appendCorpusText(&generator, "    total = total + (n Mod d)\r\n");
+        appendCorpusText(&generator, "    Handle%d_%d = total\r\n    Exit Function\r\n\r\n", guardIndex, i);
+        appendCorpusText(&generator, "Failed:\r\n    total = total - 1\r\n    Resume Next\r\nEnd Function\r\n\r\n");
+    }
+
+    return finishCorpusGenerator(&generator, length);
+}
+
+bool writeCorpusFile(const char *directory, const char *name, char *text, long length) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL) {
+        printf("error: could not write \"%s\".\n", path);
+        free(text);
+        return false;
+    }
+
+    fwrite(text, 1, length, fp);
+    fclose(fp);
+    free(text);
+    return true;
+}
+
+// Writes the project into directory and returns the path of its .vbp, or NULL.
+char *writeCorpus(const CorpusOptions *options, const char *directory) {
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("error: could not create corpus directory \"%s\".\n", directory);
+        return NULL;
+    }
+
+    char *projectPath = malloc(strlen(directory) + 16);
+    sprintf(projectPath, "%s/Corpus.vbp", directory);
+
+    FILE *fp = fopen(projectPath, "wb");
+
+    if (fp == NULL) {
+        printf("error: could not write \"%s\".\n", projectPath);
+        free(projectPath);
+        return NULL;
+    }
+
+    fprintf(fp, "Type=Exe\r\nName=\"Corpus\"\r\n");
+
+    for (int i = 0; i < options->moduleCount; i++) {
+        char name[64];
+        long length;
+        char *text = generateModule(options, i, &length);
+
+        snprintf(name, sizeof(name), "Module%d.bas", i);
+        fprintf(fp, "Module=Module%d; %s\r\n", i, name);
+
+        if (!writeCorpusFile(directory, name, text, length)) {
+            fclose(fp);
+            free(projectPath);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < options->classCount; i++) {
+        char name[64];
+        long length;
+        char *text = generateClass(options, i, &length);
+
+        snprintf(name, sizeof(name), "Class%d.cls", i);
+        fprintf(fp, "Class=Class%d; %s\r\n", i, name);
+
+        if (!writeCorpusFile(directory, name, text, length)) {
+            fclose(fp);
+            free(projectPath);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < options->formCount; i++) {
+        char name[64];
+        long length;
+        char *text = generateForm(options, i, &length);
+
+        snprintf(name, sizeof(name), "Form%d.frm", i);
+        fprintf(fp, "Form=%s\r\n", name);
+
+        if (!writeCorpusFile(directory, name, text, length)) {
+            fclose(fp);
+            free(projectPath);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < options->reportCount; i++) {
+        char name[64];
+        long length;
+        char *text = generateReport(options, i, &length);
+
+        snprintf(name, sizeof(name), "Report%d.bas", i);
+        fprintf(fp, "Module=Report%d; %s\r\n", i, name);
+
+        if (!writeCorpusFile(directory, name, text, length)) {
+            fclose(fp);
+            free(projectPath);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < options->appendCount; i++) {
+        char name[64];
+        long length;
+        char *text = generateAppend(options, i, &length);
+
+        snprintf(name, sizeof(name), "Append%d.bas", i);
+        fprintf(fp, "Module=Append%d; %s\r\n", i, name);
+
+        if (!writeCorpusFile(directory, name, text, length)) {
+            fclose(fp);
+            free(projectPath);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < options->lookupCount; i++) {
+        char name[64];
+        long length;
+        char *text = generateLookup(options, i, &length);
+
+        snprintf(name, sizeof(name), "Lookup%d.bas", i);
+        fprintf(fp, "Module=Lookup%d; %s\r\n", i, name);
+
+        if (!writeCorpusFile(directory, name, text, length)) {
+            fclose(fp);
+            free(projectPath);
+            return NULL;
+        }
+    }
+
+    for (int i = 0; i < options->guardCount; i++) {
+        char name[64];
+        long length;
+        char *text = generateGuard(options, i, &length);
+
+        snprintf(name, sizeof(name), "Guard%d.bas", i);
+        fprintf(fp, "Module=Guard%d; %s\r\n", i, name);
+
+        if (!writeCorpusFile(directory, name, text, length)) {
+            fclose(fp);
+            free(projectPath);
+            return NULL;
+        }
+    }
+
+    fclose(fp);
+    return projectPath;
+}
+
+void printCorpusOptions(const CorpusOptions *options) {
+    printf("corpus: seed %llu, %d modules, %d classes, %d forms, %d procedures x %d statements, depth %d, %d%% comments, %d%% variants, %d reports, %d appends, %d lookups, %d guards, mix",
+        (unsigned long long)options->seed,
+        options->moduleCount,
+        options->classCount,
+        options->formCount,
+        options->procedureCount,
+        options->statementCount,
+        options->expressionDepth,
+        options->commentPercent,
+        options->variantPercent,
+        options->reportCount,
+        options->appendCount,
+        options->lookupCount,
+        options->guardCount);
+
+    for (int i = 0; i < STATEMENT_KIND_COUNT; i++) {
+        printf(" %s=%d", statementNames[i], options->statementMix[i]);
+    }
+
+    printf("\n");
+}
\ No newline at end of file
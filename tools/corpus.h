@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../util.h"
+
+enum StatementKind {
+    STATEMENT_ASSIGN,
+    STATEMENT_IF,
+    STATEMENT_LOOP,
+    STATEMENT_CALL,
+    STATEMENT_SELECT,
+    STATEMENT_KIND_COUNT
+};
+
+// every knob of a synthetic project; the same options and seed always give the same bytes
+typedef struct CorpusOptions {
+    uint64_t seed;
+    int moduleCount;
+    int classCount;
+    int formCount;
+    int procedureCount;
+    int statementCount;
+    int statementMix[STATEMENT_KIND_COUNT];
+    int expressionDepth;
+    int commentPercent;
+    int variantPercent;
+    int reportCount;
+    int appendCount;
+    int lookupCount;
+    int guardCount;
+} CorpusOptions;
+
+typedef struct CorpusGenerator {
+    const CorpusOptions *options;
+    uint64_t state;
+    char *text;
+    long size;
+    long capacity;
+    int mixTotal;
+} CorpusGenerator;
+
+void initializeCorpusOptions(CorpusOptions *options);
+bool parseStatementMix(CorpusOptions *options, const char *text);
+bool parseCorpusOption(CorpusOptions *options, const char *name, const char *value);
+char *generateModule(const CorpusOptions *options, int moduleIndex, long *length);
+char *generateClass(const CorpusOptions *options, int classIndex, long *length);
+char *generateForm(const CorpusOptions *options, int formIndex, long *length);
+char *generateReport(const CorpusOptions *options, int reportIndex, long *length);
+char *generateAppend(const CorpusOptions *options, int appendIndex, long *length);
+char *generateLookup(const CorpusOptions *options, int lookupIndex, long *length);
+char *generateGuard(const CorpusOptions *options, int guardIndex, long *length);
+char *writeCorpus(const CorpusOptions *options, const char *directory);
+void printCorpusOptions(const CorpusOptions *options);
\ No newline at end of file
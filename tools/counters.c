@@ -0,0 +1,122 @@
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#include "counters.h"
+
+const char *const counterNames[COUNTER_KIND_COUNT] = {
+    "cycles",
+    "instructions",
+    "cache-misses",
+    "branch-misses",
+    "dTLB-misses"
+};
+
+static const uint32_t counterTypes[COUNTER_KIND_COUNT] = {
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HARDWARE,
+    PERF_TYPE_HW_CACHE
+};
+
+static const uint64_t counterConfigs[COUNTER_KIND_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+};
+
+// Every kind the kernel accepts joins one group, so they are scheduled together; user space only, which
+// is all perf_event_paranoid 2 allows and all the transpiler's own time is.
+bool openCounterGroup(CounterGroup *group) {
+    int leader = -1;
+
+    group->memberCount = 0;
+    group->error = 0;
+
+    for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+        struct perf_event_attr attribute;
+
+        memset(&attribute, 0, sizeof(attribute));
+        attribute.size = sizeof(attribute);
+        attribute.type = counterTypes[kind];
+        attribute.config = counterConfigs[kind];
+        attribute.disabled = (leader == -1);
+        attribute.exclude_kernel = 1;
+        attribute.exclude_hv = 1;
+        attribute.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        const int descriptor = syscall(SYS_perf_event_open, &attribute, 0, -1, leader, 0);
+        group->descriptors[kind] = descriptor;
+        group->slots[kind] = -1;
+
+        if (descriptor == -1) {
+            group->error = (group->error != 0) ? group->error : errno;
+            continue;
+        }
+
+        if (leader == -1) {
+            leader = descriptor;
+        }
+
+        group->slots[kind] = group->memberCount++;
+    }
+
+    if (leader == -1) {
+        return false;
+    }
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+int getCounterLeader(const CounterGroup *group) {
+    for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+        if (group->slots[kind] == 0) {
+            return group->descriptors[kind];
+        }
+    }
+
+    return -1;
+}
+
+// Running totals, one per kind, scaled up if the kernel had to multiplex the group; unavailable kinds read zero.
+void readCounters(const CounterGroup *group, uint64_t *values) {
+    uint64_t buffer[3 + COUNTER_KIND_COUNT];
+    const int leader = getCounterLeader(group);
+
+    memset(values, 0, sizeof(uint64_t) * COUNTER_KIND_COUNT);
+
+    if (leader == -1 || read(leader, buffer, sizeof(buffer)) < (ssize_t)(sizeof(uint64_t) * 3)) {
+        return;
+    }
+
+    const double scale = (buffer[2] > 0 && buffer[2] < buffer[1]) ? (double)buffer[1] / buffer[2] : 1.0;
+
+    for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+        if (group->slots[kind] >= 0 && group->slots[kind] < (int)buffer[0]) {
+            values[kind] = (uint64_t)(buffer[3 + group->slots[kind]] * scale);
+        }
+    }
+}
+
+bool isCounterAvailable(const CounterGroup *group, int kind) {
+    return group->slots[kind] >= 0;
+}
+
+void closeCounterGroup(CounterGroup *group) {
+    for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+        if (group->descriptors[kind] != -1) {
+            close(group->descriptors[kind]);
+        }
+
+        group->descriptors[kind] = -1;
+        group->slots[kind] = -1;
+    }
+
+    group->memberCount = 0;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "../util.h"
+
+enum CounterKind {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_CACHE_MISSES,
+    COUNTER_BRANCH_MISSES,
+    COUNTER_DTLB_MISSES,
+    COUNTER_KIND_COUNT
+};
+
+// hardware counters opened as one perf_event group on this thread; kinds the machine lacks stay unavailable
+typedef struct CounterGroup {
+    int descriptors[COUNTER_KIND_COUNT];
+    int slots[COUNTER_KIND_COUNT];
+    int memberCount;
+    int error;
+} CounterGroup;
+
+extern const char *const counterNames[COUNTER_KIND_COUNT];
+
+bool openCounterGroup(CounterGroup *group);
+void readCounters(const CounterGroup *group, uint64_t *values);
+bool isCounterAvailable(const CounterGroup *group, int kind);
+void closeCounterGroup(CounterGroup *group);
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <iconv.h>
+
+#include "../decode.h"
+
+typedef struct Corpus {
+    const char *name;
+    int codePage;
+    const char *comment;
+    const char *literal;
+} Corpus;
+
+// sample lines are written in UTF-8 and encoded into each corpus's code page
+static const Corpus corpora[] = {
+    { "ascii", CODE_PAGE_WESTERN, "' update the running total", "\"Total:\"" },
+    { "western", CODE_PAGE_WESTERN, "' Größe der Einträge prüfen, façade coûts", "\"Résumé – €\"" },
+    { "shift-jis", CODE_PAGE_SHIFT_JIS, "' 合計を更新する ｶﾀｶﾅ表示", "\"合計：\"" },
+    { "gbk", CODE_PAGE_GBK, "' 更新运行总计", "\"总计：\"" },
+    { "big5", CODE_PAGE_BIG5, "' 更新執行總計", "\"總計：\"" }
+};
+
+char *encodeLine(const char *text, int codePage) {
+    const char *names[] = { "CP932", "GBK", "BIG5" };
+    const char *name = (codePage == CODE_PAGE_SHIFT_JIS) ? names[0] : (codePage == CODE_PAGE_GBK) ? names[1] : (codePage == CODE_PAGE_BIG5) ? names[2] : "CP1252";
+    iconv_t descriptor = iconv_open(name, "UTF-8");
+    char *input = (char*)text;
+    size_t inputLeft = strlen(text);
+    char *output = calloc(inputLeft * 2 + 1, 1);
+    char *target = output;
+    size_t targetLeft = inputLeft * 2;
+
+    iconv(descriptor, &input, &inputLeft, &target, &targetLeft);
+    iconv_close(descriptor);
+
+    return output;
+}
+
+char *buildCorpus(const Corpus *corpus, long size, long *length) {
+    char *comment = encodeLine(corpus->comment, corpus->codePage);
+    char *literal = encodeLine(corpus->literal, corpus->codePage);
+    char *text = malloc(size + 512);
+    long pos = 0;
+
+    for (int i = 0; pos < size; i++) {
+        pos += sprintf(&text[pos], "Public Sub Update%d(ByVal value As Long)\n    %s\n    total = total + value\n    Debug.Print %s & total\nEnd Sub\n\n", i, comment, literal);
+    }
+
+    free(comment);
+    free(literal);
+
+    *length = pos;
+    return text;
+}
+
+int main(int argc, char **argv) {
+    const long size = (argc > 1) ? atol(argv[1]) << 20 : 16 << 20;
+    const int iterations = (argc > 2) ? atoi(argv[2]) : 10;
+
+    printf("%-10s %8s %10s %10s %10s\n", "corpus", "MB", "non-ascii", "MB/s", "growth");
+
+    for (int i = 0; i < (int)(sizeof(corpora) / sizeof(corpora[0])); i++) {
+        long length;
+        char *text = buildCorpus(&corpora[i], size, &length);
+        long nonAscii = 0, decodedLength = 0;
+        double elapsed = 0;
+
+        for (long j = 0; j < length; j++) {
+            nonAscii += ((unsigned char)text[j] >= 0x80);
+        }
+
+        for (int j = 0; j < iterations; j++) {
+            char *source = malloc(length + 1);
+            memcpy(source, text, length + 1);
+
+            const double startTime = getCurrentTime();
+            char *decoded = decodeSource(source, length, corpora[i].codePage, &decodedLength);
+            elapsed += getCurrentTime() - startTime;
+
+            free(decoded);
+        }
+
+        printf("%-10s %8.1f %9.2f%% %10.1f %9.2fx\n",
+            corpora[i].name,
+            length / 1e6,
+            100.0 * nonAscii / length,
+            length * (double)iterations / elapsed / 1e6,
+            (double)decodedLength / length);
+
+        free(text);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "../typelib.h"
+
+void printUsage(const char *program) {
+    printf("usage: %s <dump.txt> [output.vbtlb]\n", program);
+    printf("       %s -b <dump.txt> [iterations]\n", program);
+}
+
+// Resolves every type and member once; returns the number of hits so the loop is not optimized away.
+long resolveAllMembers(const TypeLibrary *library, const TypeLibrary *names) {
+    long hits = 0;
+
+    for (uint32_t i = 0; i < names->header->typeCount; i++) {
+        const LibraryType *nameType = &names->types[i];
+        const LibraryType *type = findLibraryType(library, getLibraryString(names, nameType->nameOffset));
+
+        if (type == NULL) {
+            continue;
+        }
+
+        hits++;
+
+        for (uint32_t j = 0; j < nameType->memberCount; j++) {
+            const LibraryMember *member = &names->members[nameType->firstMember + j];
+            hits += (findLibraryMember(library, type, getLibraryString(names, member->nameOffset)) != NULL);
+        }
+    }
+
+    return hits;
+}
+
+int runBenchmark(const char *dumpPath, int iterations) {
+    TypeLibrary *reference = readTypeLibraryText(dumpPath);
+
+    if (reference == NULL) {
+        return 1;
+    }
+
+    char databasePath[] = "/tmp/tlbconv-XXXXXX";
+    const int fd = mkstemp(databasePath);
+
+    if (fd < 0 || !writeTypeLibrary(databasePath, reference)) {
+        return 1;
+    }
+
+    close(fd);
+
+    double textLoadTime = 0, mapLoadTime = 0, textResolveTime = 0, mapResolveTime = 0;
+    long lookups = 0;
+
+    for (int i = 0; i < iterations; i++) {
+        double startTime = getCurrentTime();
+        TypeLibrary *text = readTypeLibraryText(dumpPath);
+        textLoadTime += getCurrentTime() - startTime;
+
+        startTime = getCurrentTime();
+        lookups = resolveAllMembers(text, reference);
+        textResolveTime += getCurrentTime() - startTime;
+
+        startTime = getCurrentTime();
+        TypeLibrary *mapped = mapTypeLibrary(databasePath);
+        mapLoadTime += getCurrentTime() - startTime;
+
+        startTime = getCurrentTime();
+        resolveAllMembers(mapped, reference);
+        mapResolveTime += getCurrentTime() - startTime;
+
+        freeTypeLibrary(text);
+        freeTypeLibrary(mapped);
+    }
+
+    printf("library: %s {%s}, %u types, %u members, %ld bytes\n",
+        getLibraryName(reference),
+        getLibraryGuid(reference),
+        reference->header->typeCount,
+        reference->header->memberCount,
+        reference->size);
+    printf("%-6s %14s %14s\n", "", "load(us)", "resolve(ns)");
+    printf("%-6s %14.3f %14.1f\n", "text", textLoadTime / iterations * 1e6, (lookups > 0) ? textResolveTime / iterations / lookups * 1e9 : 0.0);
+    printf("%-6s %14.3f %14.1f\n", "mmap", mapLoadTime / iterations * 1e6, (lookups > 0) ? mapResolveTime / iterations / lookups * 1e9 : 0.0);
+
+    unlink(databasePath);
+    freeTypeLibrary(reference);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 3 && strcmp(argv[1], "-b") == 0) {
+        const int iterations = (argc >= 4) ? atoi(argv[3]) : 100;
+        return runBenchmark(argv[2], (iterations > 0) ? iterations : 1);
+    }
+
+    if (argc < 2 || argc > 3 || argv[1][0] == '-') {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    TypeLibrary *library = readTypeLibraryText(argv[1]);
+
+    if (library == NULL) {
+        return 1;
+    }
+
+    char *outputPath = (argc == 3) ? strdup(argv[2]) : getTypeLibraryPath(".", getLibraryGuid(library));
+    const bool succeeded = writeTypeLibrary(outputPath, library);
+
+    if (succeeded) {
+        printf("%s: %u types, %u members, %ld bytes\n", outputPath, library->header->typeCount, library->header->memberCount, library->size);
+    }
+
+    free(outputPath);
+    freeTypeLibrary(library);
+    return succeeded ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,477 @@
+#include <math.h>
+
+#include "../ssa.h"
+#include "../symbols.h"
+#include "../transpile.h"
+#include "baseline.h"
+#include "corpus.h"
+#include "counters.h"
+
+enum BenchStage {
+    BENCH_READ,
+    BENCH_LEX,
+    BENCH_PARSE,
+    BENCH_EMIT,
+    BENCH_TOTAL,
+    BENCH_STAGE_COUNT
+};
+
+static const char *const stageNames[BENCH_STAGE_COUNT] = { "read", "lex", "parse", "emit", "total" };
+// a regression in these fails a baseline comparison; read is dominated by the page cache and only reported
+static const bool gatedStages[BENCH_STAGE_COUNT] = { false, true, true, true, true };
+
+// rates are in millions: source bytes, tokens, AST nodes visited by the emitter, emitted bytes, source bytes
+static const char *const unitNames[BENCH_STAGE_COUNT] = { "MB", "Mtokens", "Mnodes", "MB", "MB" };
+
+// two-sided 95% Student t for 1..30 degrees of freedom; past that the normal value is close enough
+static const double studentT[31] = {
+    0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+typedef bool (*BenchStageFunction)(TranspileResult *result);
+
+static const BenchStageFunction stageFunctions[BENCH_TOTAL] = { readStage, lexStage, parseStage, emitStage };
+
+typedef struct BenchSample {
+    double time[BENCH_STAGE_COUNT];
+    long quantity[BENCH_STAGE_COUNT];
+    uint64_t counters[BENCH_STAGE_COUNT][COUNTER_KIND_COUNT];
+    double cfgTime;
+    long cfgStatements;
+    long variantCount;
+    long narrowedVariantCount;
+} BenchSample;
+
+void printUsage(const char *program) {
+    printf("usage: %s [-w warmup] [-r repetitions] [-d corpus-dir] [-g] [-c] [-s baseline.json] [-b baseline.json [-t percent]]\n", program);
+    printf("       [--knob=value...] [project.vbp]\n");
+    printf("       knobs: seed, modules, classes, forms, procedures, statements, mix (assign,if,loop,call,select), depth, comments (%%), variants (%%), reports, appends, lookups, guards\n");
+    printf("       -g only writes the corpus; a project argument benchmarks that project instead of a generated one\n");
+    printf("       -c also counts cycles, instructions and cache, branch and dTLB misses per stage\n");
+    printf("       -s saves every pass's throughput; -b compares against a saved run and fails on a significant\n");
+    printf("       slowdown of more than -t percent (default 5) in lex, parse, emit or total\n");
+}
+
+// Control-flow graph and SSA construction for every procedure of a parsed file. It is timed on its own,
+// outside the stages, since the emitter does not need it yet.
+void timeControlFlowGraphs(const TranspileResult *result, BenchSample *sample) {
+    const Vector *externalDeclarationNodes = result->transUnitNode->externalDeclarationNodes;
+
+    for (int i = 0; externalDeclarationNodes != NULL && i < externalDeclarationNodes->size; i++) {
+        const ExternalDeclarationNode *externalDeclarationNode = externalDeclarationNodes->contents[i];
+
+        if (externalDeclarationNode == NULL || externalDeclarationNode->functionDefinitionNode == NULL) {
+            continue;
+        }
+
+        FunctionDefinitionNode *functionDefinitionNode = externalDeclarationNode->functionDefinitionNode;
+        const double startTime = getCurrentTime();
+        ControlFlowGraph *graph = getControlFlowGraph(functionDefinitionNode);
+        getSsaForm(graph);
+        sample->cfgTime += getCurrentTime() - startTime;
+        sample->cfgStatements += graph->instructionCount;
+
+        freeControlFlowGraph(graph);
+        functionDefinitionNode->controlFlowGraph = NULL;
+    }
+}
+
+// One pass over every file, one stage at a time per file, on this thread only. Counters, when given, are
+// read around each stage so that a stage's misses are its own.
+void runBenchPass(const Project *project, const CounterGroup *counters, BenchSample *sample) {
+    uint64_t before[COUNTER_KIND_COUNT], after[COUNTER_KIND_COUNT];
+
+    memset(sample, 0, sizeof(BenchSample));
+
+    for (int i = 0; i < project->files->size; i++) {
+        TranspileResult result = { 0 };
+        result.file = getProjectFile(project, i);
+        result.worker = -1;
+        initializeBudget(&result.budget, 0, 0);
+
+        bool succeeded = true;
+
+        for (int stage = 0; stage < BENCH_TOTAL && succeeded; stage++) {
+            if (counters != NULL) {
+                readCounters(counters, before);
+            }
+
+            succeeded = stageFunctions[stage](&result);
+
+            if (counters != NULL) {
+                readCounters(counters, after);
+
+                for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+                    sample->counters[stage][kind] += after[kind] - before[kind];
+                }
+            }
+
+            // the emit stage frees the tree, so the graphs are built from it before then
+            if (stage == BENCH_PARSE && succeeded) {
+                timeControlFlowGraphs(&result, sample);
+            }
+        }
+
+        sample->time[BENCH_READ] += result.readTime;
+        sample->time[BENCH_LEX] += result.lexTime;
+        sample->time[BENCH_PARSE] += result.parseTime;
+        sample->time[BENCH_EMIT] += result.emitTime;
+        sample->quantity[BENCH_READ] += (result.file->size > 0) ? result.file->size : 0;
+        sample->quantity[BENCH_LEX] += result.tokenCount;
+        sample->quantity[BENCH_PARSE] += result.nodeCount;
+        sample->quantity[BENCH_EMIT] += result.emittedBytes;
+        sample->variantCount += result.variantCount;
+        sample->narrowedVariantCount += result.narrowedVariantCount;
+        freeTranspileTrees(&result);
+
+        if (!succeeded) {
+            printf("warning: \"%s\" did not transpile.\n", result.file->path);
+        }
+    }
+
+    sample->quantity[BENCH_TOTAL] = sample->quantity[BENCH_READ];
+
+    for (int i = 0; i < BENCH_TOTAL; i++) {
+        sample->time[BENCH_TOTAL] += sample->time[i];
+
+        for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+            sample->counters[BENCH_TOTAL][kind] += sample->counters[i][kind];
+        }
+    }
+}
+
+double getStageRate(const BenchSample *sample, int stage) {
+    return (sample->time[stage] > 0) ? sample->quantity[stage] / sample->time[stage] / 1e6 : 0;
+}
+
+void printBenchStatistics(const BenchSample *samples, int count) {
+    const double t = (count - 1 <= 30) ? studentT[(count > 1) ? count - 1 : 1] : 1.96;
+
+    printf("%-6s %-8s %12s %10s %7s %12s %12s\n", "stage", "unit", "mean/s", "+-95%", "rsd", "min/s", "max/s");
+
+    for (int stage = 0; stage < BENCH_STAGE_COUNT; stage++) {
+        double sum = 0, squares = 0, minimum = INFINITY, maximum = 0;
+
+        for (int i = 0; i < count; i++) {
+            const double rate = getStageRate(&samples[i], stage);
+            sum += rate;
+            squares += rate * rate;
+            minimum = (rate < minimum) ? rate : minimum;
+            maximum = (rate > maximum) ? rate : maximum;
+        }
+
+        const double mean = sum / count;
+        const double deviation = (count > 1) ? sqrt((squares - count * mean * mean) / (count - 1)) : 0;
+        const double interval = (count > 1) ? t * deviation / sqrt(count) : 0;
+
+        printf("%-6s %-8s %12.2f %10.2f %6.2f%% %12.2f %12.2f\n",
+            stageNames[stage],
+            unitNames[stage],
+            mean,
+            interval,
+            (mean > 0) ? 100 * deviation / mean : 0.0,
+            minimum,
+            maximum);
+    }
+}
+
+// Construction cost per 1000 CFG instructions, roughly one per statement or declarator.
+void printControlFlowStatistics(const BenchSample *samples, int count) {
+    const double t = (count - 1 <= 30) ? studentT[(count > 1) ? count - 1 : 1] : 1.96;
+    double sum = 0, squares = 0;
+
+    if (samples[0].cfgStatements == 0) {
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const double cost = 1e9 * samples[i].cfgTime / samples[i].cfgStatements;
+        sum += cost;
+        squares += cost * cost;
+    }
+
+    const double mean = sum / count;
+    const double deviation = (count > 1) ? sqrt((squares - count * mean * mean) / (count - 1)) : 0;
+
+    printf("cfg+ssa: %ld statements, %.2f us +- %.2f per 1k statements\n",
+        samples[0].cfgStatements,
+        mean,
+        (count > 1) ? t * deviation / sqrt(count) : 0);
+}
+
+// Mean counts per source byte and per token; the ratios rather than raw counts let corpora of any size compare.
+void printCounterStatistics(const CounterGroup *counters, const BenchSample *samples, int count) {
+    const char *const titles[2] = { "per source byte", "per token" };
+
+    for (int unit = 0; unit < 2; unit++) {
+        printf("counters %s:\n%-6s", titles[unit], "stage");
+
+        for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+            printf(" %14s", counterNames[kind]);
+        }
+
+        printf(" %7s\n", "IPC");
+
+        for (int stage = 0; stage < BENCH_STAGE_COUNT; stage++) {
+            double means[COUNTER_KIND_COUNT] = { 0 };
+
+            for (int i = 0; i < count; i++) {
+                const long divisor = (unit == 0) ? samples[i].quantity[BENCH_READ] : samples[i].quantity[BENCH_LEX];
+
+                for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+                    means[kind] += (divisor > 0) ? (double)samples[i].counters[stage][kind] / divisor / count : 0;
+                }
+            }
+
+            printf("%-6s", stageNames[stage]);
+
+            for (int kind = 0; kind < COUNTER_KIND_COUNT; kind++) {
+                if (isCounterAvailable(counters, kind)) {
+                    printf(" %14.4f", means[kind]);
+                }
+                else {
+                    printf(" %14s", "-");
+                }
+            }
+
+            if (means[COUNTER_CYCLES] > 0 && isCounterAvailable(counters, COUNTER_INSTRUCTIONS)) {
+                printf(" %7.2f\n", means[COUNTER_INSTRUCTIONS] / means[COUNTER_CYCLES]);
+            }
+            else {
+                printf(" %7s\n", "-");
+            }
+        }
+    }
+}
+
+void buildBaseline(const BenchSample *samples, int count, Baseline *baseline) {
+    memset(baseline, 0, sizeof(Baseline));
+    baseline->sourceBytes = samples[0].quantity[BENCH_READ];
+    baseline->tokenCount = samples[0].quantity[BENCH_LEX];
+    baseline->stageCount = BENCH_STAGE_COUNT;
+
+    for (int stage = 0; stage < BENCH_STAGE_COUNT; stage++) {
+        BaselineStage *baselineStage = &baseline->stages[stage];
+        snprintf(baselineStage->name, sizeof(baselineStage->name), "%s", stageNames[stage]);
+
+        for (int i = 0; i < count && i < BASELINE_MAX_SAMPLES; i++) {
+            baselineStage->rates[baselineStage->count++] = getStageRate(&samples[i], stage);
+        }
+    }
+}
+
+// A stage regresses when its median rate fell by more than the threshold and the fall is significant at 1%.
+// Both conditions matter: noise alone can move a median past a few percent, and a significant 0.5% is not worth a failure.
+bool compareWithBaseline(const Baseline *previous, const Baseline *current, double threshold) {
+    bool regressed = false;
+
+    if (previous->sourceBytes != current->sourceBytes || previous->tokenCount != current->tokenCount) {
+        printf("warning: the baseline measured %ld bytes and %ld tokens per pass, this run %ld and %ld; rates are per unit but the corpora differ.\n",
+            previous->sourceBytes,
+            previous->tokenCount,
+            current->sourceBytes,
+            current->tokenCount);
+    }
+
+    printf("%-6s %12s %12s %9s %9s  %s\n", "stage", "baseline", "current", "change", "p", "verdict");
+
+    for (int stage = 0; stage < BENCH_STAGE_COUNT; stage++) {
+        const BaselineStage *before = findBaselineStage(previous, stageNames[stage]);
+        const BaselineStage *after = &current->stages[stage];
+
+        if (before == NULL || before->count == 0) {
+            printf("%-6s %12s %12.2f %9s %9s  not in baseline\n", stageNames[stage], "-", getMedian(after->rates, after->count), "-", "-");
+            continue;
+        }
+
+        const double previousMedian = getMedian(before->rates, before->count);
+        const double currentMedian = getMedian(after->rates, after->count);
+        const double change = (previousMedian > 0) ? (currentMedian - previousMedian) / previousMedian : 0;
+        const double slower = getMannWhitneyLowerP(after->rates, after->count, before->rates, before->count);
+        const double faster = getMannWhitneyLowerP(before->rates, before->count, after->rates, after->count);
+        const char *verdict = "unchanged";
+
+        if (change < -threshold && slower < 0.01) {
+            verdict = gatedStages[stage] ? "REGRESSED" : "slower (not gated)";
+            regressed = regressed || gatedStages[stage];
+        }
+        else if (change > threshold && faster < 0.01) {
+            verdict = "improved";
+        }
+
+        printf("%-6s %12.2f %12.2f %+8.1f%% %9.4f  %s\n",
+            stageNames[stage],
+            previousMedian,
+            currentMedian,
+            100 * change,
+            (change < 0) ? slower : faster,
+            verdict);
+    }
+
+    printf("%s\n", regressed ? "result: throughput regressed beyond the threshold." : "result: no significant regression.");
+    return !regressed;
+}
+
+int main(int argc, char **argv) {
+    CorpusOptions options;
+    int warmupCount = 2;
+    int repetitionCount = 10;
+    bool generateOnly = false;
+    bool countEvents = false;
+    const char *savePath = NULL;
+    const char *comparePath = NULL;
+    double threshold = 0.05;
+    char *projectPath = NULL;
+    char corpusDirectory[4096] = "";
+
+    initializeCorpusOptions(&options);
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) == 0 && strchr(argv[i], '=') != NULL) {
+            char name[64];
+            const char *equal = strchr(argv[i], '=');
+            snprintf(name, sizeof(name), "%.*s", (int)(equal - argv[i] - 2), argv[i] + 2);
+
+            if (!parseCorpusOption(&options, name, equal + 1)) {
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            warmupCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repetitionCount = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            snprintf(corpusDirectory, sizeof(corpusDirectory), "%s", argv[++i]);
+        }
+        else if (strcmp(argv[i], "-g") == 0) {
+            generateOnly = true;
+        }
+        else if (strcmp(argv[i], "-c") == 0) {
+            countEvents = true;
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            savePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            comparePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]) / 100;
+        }
+        else if (argv[i][0] != '-') {
+            projectPath = strdup(argv[i]);
+        }
+        else {
+            printUsage(argv[0]);
+            return (strcmp(argv[i], "-h") == 0) ? 0 : 1;
+        }
+    }
+
+    if (repetitionCount < 1) {
+        repetitionCount = 1;
+    }
+
+    if (projectPath == NULL) {
+        if (corpusDirectory[0] == '\0') {
+            snprintf(corpusDirectory, sizeof(corpusDirectory), "/tmp/vbbench-%llu", (unsigned long long)options.seed);
+        }
+
+        printCorpusOptions(&options);
+        projectPath = writeCorpus(&options, corpusDirectory);
+
+        if (projectPath == NULL) {
+            return 1;
+        }
+
+        printf("corpus: %s\n", projectPath);
+    }
+
+    if (generateOnly) {
+        return 0;
+    }
+
+    Project *project = readProject(projectPath);
+
+    if (project == NULL) {
+        return 1;
+    }
+
+    ThreadPool *pool = buildThreadPool(1);
+    project->symbols = buildSymbolIndex(project, pool);
+    freeThreadPool(pool);
+
+    CounterGroup group;
+    const CounterGroup *counters = NULL;
+
+    // containers and locked-down kernels refuse perf_event_open; the timings are still worth having
+    if (countEvents) {
+        if (openCounterGroup(&group)) {
+            counters = &group;
+        }
+        else {
+            printf("warning: hardware counters unavailable (%s); reporting times only.\n", strerror(group.error));
+        }
+    }
+
+    BenchSample *samples = calloc(repetitionCount, sizeof(BenchSample));
+    BenchSample warmup;
+
+    for (int i = 0; i < warmupCount; i++) {
+        runBenchPass(project, counters, &warmup);
+    }
+
+    for (int i = 0; i < repetitionCount; i++) {
+        runBenchPass(project, counters, &samples[i]);
+    }
+
+    printf("files: %d, %ld bytes, %ld tokens, %ld AST nodes, %ld bytes emitted per pass\n",
+        project->files->size,
+        samples[0].quantity[BENCH_READ],
+        samples[0].quantity[BENCH_LEX],
+        samples[0].quantity[BENCH_PARSE],
+        samples[0].quantity[BENCH_EMIT]);
+    printf("passes: %d warmup, %d measured\n", warmupCount, repetitionCount);
+
+    if (samples[0].variantCount > 0) {
+        printf("variants: %ld declared, %ld narrowed (%.1f%%)\n",
+            samples[0].variantCount,
+            samples[0].narrowedVariantCount,
+            100.0 * samples[0].narrowedVariantCount / samples[0].variantCount);
+    }
+
+    printBenchStatistics(samples, repetitionCount);
+    printControlFlowStatistics(samples, repetitionCount);
+
+    if (counters != NULL) {
+        printCounterStatistics(counters, samples, repetitionCount);
+        closeCounterGroup(&group);
+    }
+
+    Baseline current, previous;
+    bool passed = true;
+
+    buildBaseline(samples, repetitionCount, &current);
+
+    // read before saving, so comparing against and replacing the same file works
+    if (comparePath != NULL) {
+        if (!readBaseline(comparePath, &previous)) {
+            return 1;
+        }
+
+        passed = compareWithBaseline(&previous, &current, threshold);
+    }
+
+    if (savePath != NULL && !writeBaseline(savePath, &current)) {
+        return 1;
+    }
+
+    // stdout feeds diff-based comparisons, so the diagnostics of a broken corpus stay out of it
+    freeDiagnostics(collectDiagnostics());
+    free(samples);
+    free(projectPath);
+    return passed ? 0 : 1;
+}
\ No newline at end of file
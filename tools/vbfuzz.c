@@ -0,0 +1,515 @@
+#include <dirent.h>
+#include <errno.h>
+#include <math.h>
+
+#include "../lexer.h"
+#include "../parser.h"
+#include "../symbols.h"
+#include "corpus.h"
+
+// budget checks per input byte above which one run counts as pathological
+#define FUZZ_STEP_LIMIT 64
+// seconds a single run may take before the input counts as non-terminating
+#define FUZZ_TIME_LIMIT 2.0
+// exponent of the last doubling in the growth probe; linear work is 1, quadratic 2
+#define FUZZ_GROWTH_LIMIT 1.5
+#define FUZZ_GROWTH_STEPS 4
+#define FUZZ_GROWTH_BASE 1024
+#define FUZZ_POOL_SIZE 64
+#define FUZZ_MAX_INPUT 65536
+
+typedef struct FuzzCost {
+    long steps;
+    double time;
+    int status;
+} FuzzCost;
+
+typedef struct FuzzInput {
+    uint8_t *data;
+    size_t size;
+    double stepsPerByte;
+} FuzzInput;
+
+static Project *fuzzProject;
+static double fuzzTimeLimit = FUZZ_TIME_LIMIT;
+
+void initializeFuzzProject() {
+    ThreadPool *pool = buildThreadPool(1);
+
+    fuzzProject = buildProjectFromFiles(NULL, 0);
+    fuzzProject->symbols = buildSymbolIndex(fuzzProject, pool);
+    freeThreadPool(pool);
+}
+
+// Lexes and parses one input under a budget; steps are the budget checks both made, which unlike time repeat exactly.
+FuzzCost measureInput(const uint8_t *data, size_t size, double timeLimit) {
+    char *text = malloc(size + 1);
+    Budget budget;
+    FuzzCost cost;
+
+    memcpy(text, data, size);
+    text[size] = '\0';
+    initializeBudget(&budget, timeLimit, 0);
+    setDiagnosticFile(0);
+    symbolIndex = fuzzProject->symbols;
+
+    const double startTime = getCurrentTime();
+    beginBudget(&budget);
+    Vector *tokens = lexWithDefines(text, NULL);
+
+    TransUnitNode *transUnitNode = (tokens != NULL && budget.status == BUDGET_OK) ? parse(tokens) : NULL;
+
+    endBudget(&budget);
+
+    cost.time = getCurrentTime() - startTime;
+    cost.steps = budget.steps;
+    cost.status = budget.status;
+
+    if (tokens != NULL) {
+        freeTokens(tokens);
+    }
+
+    if (transUnitNode != NULL) {
+        freeTransUnitNode(transUnitNode);
+    }
+
+    free(text);
+    freeDiagnostics(collectDiagnostics());
+    return cost;
+}
+
+// input copied count times, a line break between copies so each starts a fresh statement
+uint8_t *repeatInput(const uint8_t *data, size_t size, int count, size_t *length) {
+    uint8_t *text = malloc((size + 2) * count + 1);
+
+    *length = 0;
+
+    for (int i = 0; i < count; i++) {
+        memcpy(&text[*length], data, size);
+        *length += size;
+        text[(*length)++] = '\r';
+        text[(*length)++] = '\n';
+    }
+
+    return text;
+}
+
+// Growth exponent of the cost over n, 2n, 4n and 8n copies, n enough for about a kilobyte so fixed costs do not
+// flatten the curve; a run over the time limit at any size returns INFINITY.
+double measureGrowth(const uint8_t *data, size_t size, FuzzCost *largest) {
+    const int base = (size < FUZZ_GROWTH_BASE) ? (int)((FUZZ_GROWTH_BASE + size + 1) / (size + 2)) : 1;
+    FuzzCost previous = { 0 };
+    double exponent = 0;
+
+    for (int i = 0; i < FUZZ_GROWTH_STEPS; i++) {
+        size_t length;
+        uint8_t *text = repeatInput(data, size, base << i, &length);
+        const FuzzCost cost = measureInput(text, length, fuzzTimeLimit);
+
+        free(text);
+        *largest = cost;
+
+        if (cost.status == BUDGET_TIME_EXCEEDED) {
+            return INFINITY;
+        }
+
+        // tiny counts are all fixed overhead, so the ratio only means something once there is work to compare
+        if (i > 0 && previous.steps >= 64) {
+            exponent = log2((double)cost.steps / previous.steps);
+        }
+
+        previous = cost;
+    }
+
+    return exponent;
+}
+
+bool isPathological(const uint8_t *data, size_t size) {
+    FuzzCost cost;
+    const double exponent = measureGrowth(data, size, &cost);
+
+    return exponent > FUZZ_GROWTH_LIMIT;
+}
+
+// libFuzzer and AFL++'s libFuzzer driver call this; superlinear cost shows up as many steps per byte at the sizes they try
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (fuzzProject == NULL) {
+        initializeFuzzProject();
+    }
+
+    const FuzzCost cost = measureInput(data, size, fuzzTimeLimit);
+
+    if (cost.status == BUDGET_TIME_EXCEEDED || cost.steps > FUZZ_STEP_LIMIT * (long)(size + 64)) {
+        printf("error: %zu byte input took %ld steps (%.1f per byte) in %.3f s%s.\n",
+            size,
+            cost.steps,
+            (double)cost.steps / (size + 1),
+            cost.time,
+            (cost.status == BUDGET_TIME_EXCEEDED) ? ", over the time limit" : "");
+        abort();
+    }
+
+    return 0;
+}
+
+#ifndef VBFUZZ_LIBFUZZER
+
+// fragments a VB6 file is made of; inserting them reaches the parser's scans far sooner than random bytes do
+static const char *const fuzzDictionary[] = {
+    "Sub ", "Function ", "End Sub", "End Function", "Private ", "Public ", "Declare ", "Lib \"k\" ", "Dim ", " As ",
+    "Long", "String", "Const ", "(", ")", ",", "\"", "'", " _\r\n", "\r\n", "#If X Then\r\n", "#End If\r\n",
+    "If ", " Then", "End If", "Select Case ", "Case ", "End Select", "For ", " To ", "Next", "Call ", "=", "&H", "1.5E"
+};
+
+uint64_t nextFuzzRandom(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// One random edit: flip a byte, insert a dictionary fragment, delete a run, duplicate a run or truncate.
+uint8_t *mutateInput(const FuzzInput *parent, uint64_t *state, size_t *length) {
+    const size_t size = parent->size;
+    uint8_t *text = malloc(size * 2 + 64);
+    const size_t at = (size > 0) ? nextFuzzRandom(state) % size : 0;
+    const size_t run = (size > at) ? 1 + nextFuzzRandom(state) % (size - at) : 0;
+
+    memcpy(text, parent->data, size);
+    *length = size;
+
+    switch (nextFuzzRandom(state) % 5) {
+        case 0: {
+            if (size > 0) {
+                text[at] = (uint8_t)nextFuzzRandom(state);
+            }
+
+            break;
+        }
+        case 1: {
+            const char *fragment = fuzzDictionary[nextFuzzRandom(state) % (sizeof(fuzzDictionary) / sizeof(fuzzDictionary[0]))];
+            const size_t fragmentLength = strlen(fragment);
+
+            memmove(&text[at + fragmentLength], &text[at], size - at);
+            memcpy(&text[at], fragment, fragmentLength);
+            *length = size + fragmentLength;
+            break;
+        }
+        case 2: {
+            memmove(&text[at], &text[at + run], size - at - run);
+            *length = size - run;
+            break;
+        }
+        case 3: {
+            const size_t copy = (run < size) ? run : size;
+
+            memmove(&text[at + copy], &text[at], size - at);
+            memcpy(&text[at], &parent->data[at], copy);
+            *length = size + copy;
+            break;
+        }
+        default: {
+            *length = at;
+            break;
+        }
+    }
+
+    return text;
+}
+
+// Delta debugging: drop ever smaller chunks while the input stays pathological.
+uint8_t *minimizeInput(const uint8_t *data, size_t size, size_t *length) {
+    uint8_t *text = malloc(size + 1);
+    uint8_t *candidate = malloc(size + 1);
+
+    memcpy(text, data, size);
+    *length = size;
+
+    for (size_t chunk = size / 2; chunk >= 1; chunk /= 2) {
+        size_t offset = 0;
+
+        while (offset + chunk <= *length) {
+            memcpy(candidate, text, offset);
+            memcpy(&candidate[offset], &text[offset + chunk], *length - offset - chunk);
+
+            if (isPathological(candidate, *length - chunk)) {
+                memcpy(text, candidate, *length - chunk);
+                *length -= chunk;
+            }
+            else {
+                offset += chunk;
+            }
+        }
+    }
+
+    free(candidate);
+    return text;
+}
+
+// Saved by content hash, so finding the same reproducer twice keeps one file.
+bool saveReproducer(const char *directory, const uint8_t *data, size_t size) {
+    char path[4096];
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ULL;
+    }
+
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("error: could not create regression corpus \"%s\".\n", directory);
+        return false;
+    }
+
+    snprintf(path, sizeof(path), "%s/slow-%016llx.bas", directory, (unsigned long long)hash);
+
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL) {
+        printf("error: could not write \"%s\".\n", path);
+        return false;
+    }
+
+    fwrite(data, 1, size, fp);
+    fclose(fp);
+    printf("saved %zu byte reproducer to %s\n", size, path);
+    return true;
+}
+
+void addPoolInput(FuzzInput *pool, int *count, uint8_t *data, size_t size) {
+    const FuzzCost cost = measureInput(data, size, fuzzTimeLimit);
+    const double stepsPerByte = (double)cost.steps / (size + 1);
+    int slot = *count;
+
+    // a full pool gives up its cheapest input, so the search keeps climbing towards costlier ones
+    if (*count == FUZZ_POOL_SIZE) {
+        slot = 0;
+
+        for (int i = 1; i < *count; i++) {
+            slot = (pool[i].stepsPerByte < pool[slot].stepsPerByte) ? i : slot;
+        }
+
+        if (pool[slot].stepsPerByte >= stepsPerByte) {
+            free(data);
+            return;
+        }
+
+        free(pool[slot].data);
+    }
+    else {
+        (*count)++;
+    }
+
+    pool[slot].data = data;
+    pool[slot].size = size;
+    pool[slot].stepsPerByte = stepsPerByte;
+}
+
+// Cost-guided search: mutants that need more steps per byte than their parent are probed for superlinear
+// growth and, if they pass, join the pool. Coverage guidance is libFuzzer's job when built with -DVBFUZZ_LIBFUZZER.
+int searchInputs(FuzzInput *pool, int count, long iterations, uint64_t seed, const char *directory, bool keepGoing) {
+    uint64_t state = seed;
+    int foundCount = 0;
+
+    for (long iteration = 0; iteration < iterations && count > 0 && (keepGoing || foundCount == 0); iteration++) {
+        const FuzzInput *parent = &pool[nextFuzzRandom(&state) % count];
+        size_t length;
+        uint8_t *text = mutateInput(parent, &state, &length);
+
+        if (length > FUZZ_MAX_INPUT) {
+            free(text);
+            continue;
+        }
+
+        const FuzzCost cost = measureInput(text, length, fuzzTimeLimit);
+
+        // only inputs that got costlier per byte than their parent are worth the growth probe
+        if (cost.status == BUDGET_OK && (double)cost.steps / (length + 1) <= parent->stepsPerByte) {
+            free(text);
+        }
+        else if (isPathological(text, length)) {
+            size_t minimizedLength;
+            uint8_t *minimized = minimizeInput(text, length, &minimizedLength);
+
+            if (saveReproducer(directory, minimized, minimizedLength)) {
+                foundCount++;
+            }
+
+            free(minimized);
+            free(text);
+        }
+        else {
+            addPoolInput(pool, &count, text, length);
+        }
+
+        if ((iteration + 1) % 1000 == 0) {
+            printf("%ld inputs, pool %d, %d found\n", iteration + 1, count, foundCount);
+        }
+    }
+
+    return foundCount;
+}
+
+// Replays one file and prints its cost; true when it is within bounds.
+bool replayFile(const char *path, bool abortOnFinding) {
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL) {
+        printf("error: could not read \"%s\".\n", path);
+        return false;
+    }
+
+    uint8_t *data = malloc(FUZZ_MAX_INPUT * 16);
+    const size_t size = fread(data, 1, FUZZ_MAX_INPUT * 16, fp);
+    FuzzCost cost;
+
+    fclose(fp);
+
+    const double exponent = measureGrowth(data, size, &cost);
+    const bool bounded = (exponent <= FUZZ_GROWTH_LIMIT);
+
+    cost = measureInput(data, size, fuzzTimeLimit);
+
+    printf("%s: %zu bytes, %.1f steps per byte, growth exponent %.2f, %s\n",
+        path,
+        size,
+        (double)cost.steps / (size + 1),
+        exponent,
+        bounded ? "ok" : "SUPERLINEAR");
+    free(data);
+
+    // AFL and honggfuzz only notice signals
+    if (!bounded && abortOnFinding) {
+        abort();
+    }
+
+    return bounded;
+}
+
+bool replayPath(const char *path, bool abortOnFinding) {
+    DIR *directory = opendir(path);
+
+    if (directory == NULL) {
+        return replayFile(path, abortOnFinding);
+    }
+
+    bool bounded = true;
+    struct dirent *entry;
+
+    while ((entry = readdir(directory)) != NULL) {
+        char child[4096];
+
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        bounded = replayFile(child, abortOnFinding) && bounded;
+    }
+
+    closedir(directory);
+    return bounded;
+}
+
+void printUsage(const char *program) {
+    printf("usage: %s [-t seconds] [-x] <file|directory>...\n", program);
+    printf("       %s -s [-n iterations] [-o regression-dir] [-k] [--knob=value...] [seed files...]\n", program);
+    printf("       replays inputs, failing on superlinear lex+parse cost; -x aborts instead, for AFL (vbfuzz -x @@)\n");
+    printf("       -s searches for such inputs from the seeds or a small generated corpus and saves a minimized reproducer;\n");
+    printf("       -k keeps searching after the first\n");
+}
+
+int main(int argc, char **argv) {
+    CorpusOptions options;
+    bool search = false;
+    bool abortOnFinding = false;
+    bool keepGoing = false;
+    long iterations = 10000;
+    const char *directory = "fuzz-regressions";
+    FuzzInput *pool = calloc(FUZZ_POOL_SIZE, sizeof(FuzzInput));
+    int count = 0;
+    char **paths = malloc(sizeof(char*) * argc);
+    int pathCount = 0;
+
+    initializeCorpusOptions(&options);
+    options.procedureCount = 1;
+    options.statementCount = 4;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) == 0 && strchr(argv[i], '=') != NULL) {
+            char name[64];
+            const char *equal = strchr(argv[i], '=');
+            snprintf(name, sizeof(name), "%.*s", (int)(equal - argv[i] - 2), argv[i] + 2);
+
+            if (!parseCorpusOption(&options, name, equal + 1)) {
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-s") == 0) {
+            search = true;
+        }
+        else if (strcmp(argv[i], "-x") == 0) {
+            abortOnFinding = true;
+        }
+        else if (strcmp(argv[i], "-k") == 0) {
+            keepGoing = true;
+        }
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            fuzzTimeLimit = atof(argv[++i]);
+        }
+        else if (argv[i][0] != '-') {
+            paths[pathCount++] = argv[i];
+        }
+        else {
+            printUsage(argv[0]);
+            return (strcmp(argv[i], "-h") == 0) ? 0 : 1;
+        }
+    }
+
+    initializeFuzzProject();
+
+    if (!search) {
+        bool bounded = true;
+
+        if (pathCount == 0) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        for (int i = 0; i < pathCount; i++) {
+            bounded = replayPath(paths[i], abortOnFinding) && bounded;
+        }
+
+        return bounded ? 0 : 1;
+    }
+
+    for (int i = 0; i < pathCount; i++) {
+        char *text = readFile(paths[i]);
+
+        if (text == NULL) {
+            printf("error: could not read \"%s\".\n", paths[i]);
+            return 1;
+        }
+
+        addPoolInput(pool, &count, (uint8_t*)text, strlen(text));
+    }
+
+    for (int i = 0; pathCount == 0 && i < 4; i++) {
+        long length;
+        char *text = generateModule(&options, i, &length);
+
+        addPoolInput(pool, &count, (uint8_t*)text, length);
+    }
+
+    const int foundCount = searchInputs(pool, count, iterations, options.seed, directory, keepGoing);
+
+    printf("%d pathological input%s saved to %s\n", foundCount, (foundCount == 1) ? "" : "s", directory);
+    return (foundCount > 0) ? 1 : 0;
+}
+
+#endif
\ No newline at end of file
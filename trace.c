@@ -0,0 +1,281 @@
+#include "trace.h"
+
+bool traceEnabled;
+
+static _Atomic(TraceBuffer*) traceBuffers;
+static atomic_int traceThreadCount;
+static _Thread_local TraceBuffer *traceBuffer;
+
+static const char *const categoryNames[] = {
+    "phase",
+    "procedure",
+    "project"
+};
+
+long getTraceTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+TraceBuffer *getTraceBuffer() {
+    if (traceBuffer == NULL) {
+        TraceBuffer *buffer = calloc(1, sizeof(TraceBuffer));
+        buffer->thread = atomic_fetch_add(&traceThreadCount, 1);
+        buffer->next = atomic_load(&traceBuffers);
+
+        while (!atomic_compare_exchange_weak(&traceBuffers, &buffer->next, buffer)) {
+        }
+
+        traceBuffer = buffer;
+    }
+
+    return traceBuffer;
+}
+
+// Zero when tracing is off, which endTrace takes as "record nothing"; that branch is the whole disabled cost.
+long beginTrace() {
+    return traceEnabled ? getTraceTime() : 0;
+}
+
+void pushTraceEvent(TraceBuffer *buffer, const TraceEvent *event) {
+    if (buffer->size == buffer->capacity) {
+        buffer->capacity = (buffer->capacity > 0) ? buffer->capacity * 2 : 1024;
+        buffer->events = realloc(buffer->events, sizeof(TraceEvent) * buffer->capacity);
+    }
+
+    buffer->events[buffer->size++] = *event;
+}
+
+void endTrace(long startTime, int category, int fileIndex, const char *name) {
+    if (startTime == 0) {
+        return;
+    }
+
+    TraceBuffer *buffer = getTraceBuffer();
+    TraceEvent event;
+
+    event.duration = getTraceTime() - startTime;
+    event.startTime = startTime;
+    event.category = category;
+    event.fileIndex = fileIndex;
+    event.thread = buffer->thread;
+    snprintf(event.name, sizeof(event.name), "%s", name);
+
+    pushTraceEvent(buffer, &event);
+}
+
+// Events from another process; threadOffset keeps their thread ids apart from ours.
+void appendTraceEvents(const TraceEvent *events, int count, int threadOffset) {
+    TraceBuffer *buffer = getTraceBuffer();
+
+    for (int i = 0; i < count; i++) {
+        TraceEvent event = events[i];
+        event.thread += threadOffset;
+        pushTraceEvent(buffer, &event);
+    }
+}
+
+// Everything recorded so far, in no particular order; the buffers are left empty. No thread may be tracing meanwhile.
+TraceEvent *takeTraceEvents(int *count) {
+    int total = 0;
+
+    for (TraceBuffer *buffer = atomic_load(&traceBuffers); buffer != NULL; buffer = buffer->next) {
+        total += buffer->size;
+    }
+
+    TraceEvent *events = malloc(sizeof(TraceEvent) * (total + 1));
+    *count = 0;
+
+    for (TraceBuffer *buffer = atomic_load(&traceBuffers); buffer != NULL; buffer = buffer->next) {
+        memcpy(&events[*count], buffer->events, sizeof(TraceEvent) * buffer->size);
+        *count += buffer->size;
+        buffer->size = 0;
+    }
+
+    return events;
+}
+
+void writeJsonString(FILE *fp, const char *text) {
+    fputc('"', fp);
+
+    for (const unsigned char *p = (const unsigned char*)text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(fp, "\\%c", *p);
+        }
+        else if (*p < 0x20) {
+            fprintf(fp, "\\u%04x", *p);
+        }
+        else {
+            fputc(*p, fp);
+        }
+    }
+
+    fputc('"', fp);
+}
+
+// Chrome trace-event JSON (chrome://tracing, Perfetto); timestamps are microseconds from the first event.
+bool writeTraceFile(const Project *project, const char *path) {
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        printf("error: could not write trace \"%s\".\n", path);
+        return false;
+    }
+
+    int count;
+    TraceEvent *events = takeTraceEvents(&count);
+    long origin = (count > 0) ? events[0].startTime : 0;
+    IntegerStack *threads = initializeIntegerStack();
+
+    for (int i = 0; i < count; i++) {
+        origin = (events[i].startTime < origin) ? events[i].startTime : origin;
+        int j = 0;
+
+        while (j <= threads->top && threads->elements[j] != events[i].thread) {
+            j++;
+        }
+
+        if (j > threads->top) {
+            pushIntegerStack(threads, events[i].thread);
+        }
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    // shard workers' threads are numbered from 100 * (slot + 1)
+    for (int i = 0; i <= threads->top; i++) {
+        const int thread = threads->elements[i];
+
+        if (thread >= 100) {
+            fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"process %d\"}},\n", thread, thread / 100 - 1);
+        }
+        else {
+            fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}},\n", thread, thread);
+        }
+    }
+
+    free(threads->elements);
+    free(threads);
+
+    for (int i = 0; i < count; i++) {
+        const TraceEvent *event = &events[i];
+
+        fprintf(fp, "{\"name\": ");
+        writeJsonString(fp, event->name);
+        fprintf(fp, ", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+            categoryNames[event->category],
+            event->thread,
+            (event->startTime - origin) / 1e3,
+            event->duration / 1e3);
+
+        if (event->fileIndex >= 0) {
+            fprintf(fp, ", \"args\": {\"file\": ");
+            writeJsonString(fp, getProjectFile(project, event->fileIndex)->path);
+            fprintf(fp, "}");
+        }
+
+        fprintf(fp, "}%s\n", (i + 1 < count) ? "," : "");
+    }
+
+    fprintf(fp, "]}\n");
+    fclose(fp);
+
+    // the events were taken; hand them back so a time report can still follow
+    appendTraceEvents(events, count, 0);
+    free(events);
+    return true;
+}
+
+typedef struct TimeReportRow {
+    const char *name;
+    int fileIndex;
+    long total;
+    long maximum;
+    int count;
+} TimeReportRow;
+
+int compareTimeReportRows(const void *left, const void *right) {
+    const TimeReportRow *a = left;
+    const TimeReportRow *b = right;
+
+    return (a->total < b->total) ? 1 : (a->total > b->total) ? -1 : 0;
+}
+
+void printTimeReportRows(const Project *project, const char *title, TimeReportRow *rows, int count, int rowCount) {
+    qsort(rows, count, sizeof(TimeReportRow), compareTimeReportRows);
+
+    printf("%s\n", title);
+
+    for (int i = 0; i < count && i < rowCount; i++) {
+        const TimeReportRow *row = &rows[i];
+
+        printf("  %10.3f ms %8d x %10.3f ms max  %s%s%s\n",
+            row->total / 1e6,
+            row->count,
+            row->maximum / 1e6,
+            (row->name != NULL) ? row->name : "",
+            (row->name != NULL && row->fileIndex >= 0) ? " in " : "",
+            (row->fileIndex >= 0) ? getProjectFile(project, row->fileIndex)->path : "");
+    }
+}
+
+void addTimeReportRow(TimeReportRow *row, const TraceEvent *event) {
+    row->total += event->duration;
+    row->maximum = (event->duration > row->maximum) ? event->duration : row->maximum;
+    row->count++;
+}
+
+// Phase totals, the files that took longest over all their phases, and the slowest procedures.
+void printTimeReport(const Project *project, int rowCount) {
+    const int fileCount = project->files->size;
+    int count;
+    TraceEvent *events = takeTraceEvents(&count);
+    TimeReportRow *phases = calloc(count + 1, sizeof(TimeReportRow));
+    TimeReportRow *files = calloc(fileCount + 1, sizeof(TimeReportRow));
+    TimeReportRow *procedures = calloc(count + 1, sizeof(TimeReportRow));
+    int phaseCount = 0, procedureCount = 0;
+
+    for (int i = 0; i < fileCount; i++) {
+        files[i].fileIndex = i;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const TraceEvent *event = &events[i];
+
+        if (event->category == TRACE_PROCEDURE) {
+            TimeReportRow *row = &procedures[procedureCount++];
+            row->name = event->name;
+            row->fileIndex = event->fileIndex;
+            addTimeReportRow(row, event);
+            continue;
+        }
+
+        int phase = 0;
+
+        while (phase < phaseCount && strcmp(phases[phase].name, event->name) != 0) {
+            phase++;
+        }
+
+        if (phase == phaseCount) {
+            phases[phaseCount].name = event->name;
+            phases[phaseCount++].fileIndex = -1;
+        }
+
+        addTimeReportRow(&phases[phase], event);
+
+        if (event->category == TRACE_PHASE && event->fileIndex >= 0 && event->fileIndex < fileCount) {
+            addTimeReportRow(&files[event->fileIndex], event);
+        }
+    }
+
+    printTimeReportRows(project, "phases:", phases, phaseCount, phaseCount);
+    printTimeReportRows(project, "slowest files:", files, fileCount, rowCount);
+    printTimeReportRows(project, "slowest procedures:", procedures, procedureCount, rowCount);
+
+    free(phases);
+    free(files);
+    free(procedures);
+    free(events);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "project.h"
+
+#define TRACE_NAME_LENGTH 40
+
+enum TraceCategory {
+    TRACE_PHASE,
+    TRACE_PROCEDURE,
+    TRACE_PROJECT
+};
+
+// one complete ("X") event; plain data so shard workers can send them over a pipe as is
+typedef struct TraceEvent {
+    char name[TRACE_NAME_LENGTH];
+    int category;
+    int fileIndex;
+    int thread;
+    long startTime;
+    long duration;
+} TraceEvent;
+
+typedef struct TraceBuffer {
+    int thread;
+    TraceEvent *events;
+    int size;
+    int capacity;
+    struct TraceBuffer *next;
+} TraceBuffer;
+
+extern bool traceEnabled;
+
+long beginTrace();
+void endTrace(long startTime, int category, int fileIndex, const char *name);
+void appendTraceEvents(const TraceEvent *events, int count, int threadOffset);
+TraceEvent *takeTraceEvents(int *count);
+bool writeTraceFile(const Project *project, const char *path);
+void printTimeReport(const Project *project, int rowCount);
\ No newline at end of file
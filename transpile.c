@@ -0,0 +1,299 @@
+#include "transpile.h"
+
+bool readStage(TranspileResult *result) {
+    const ProjectFile *file = result->file;
+    const long traceStart = beginTrace();
+    setDiagnosticFile(file->index);
+    result->startTime = getCurrentTime();
+    result->source = readFile(file->path);
+
+    if (result->source == NULL) {
+        reportDiagnostic(DIAGNOSTIC_READ_FAILED, -1, "could not read file");
+        result->endTime = getCurrentTime();
+        result->readTime = result->endTime - result->startTime;
+        endTrace(traceStart, TRACE_PHASE, file->index, "read");
+        return false;
+    }
+
+    long decodedLength;
+    result->source = decodeSource(result->source, strlen(result->source), file->project->codePage, &decodedLength);
+    result->readTime = getCurrentTime() - result->startTime;
+    endTrace(traceStart, TRACE_PHASE, file->index, "read");
+
+    return true;
+}
+
+// tokens and the tree are only needed until the file is emitted, so every stage that ends a file frees them
+void freeTranspileTrees(TranspileResult *result) {
+    if (result->tokens != NULL) {
+        freeTokens(result->tokens);
+        result->tokens = NULL;
+    }
+
+    if (result->transUnitNode != NULL) {
+        freeTransUnitNode(result->transUnitNode);
+        result->transUnitNode = NULL;
+    }
+}
+
+// the file is dropped with what it has allocated so far; the rest of the batch carries on
+void abandonFile(TranspileResult *result) {
+    const Budget *budget = &result->budget;
+    result->abandoned = true;
+
+    reportDiagnostic(DIAGNOSTIC_BUDGET_EXCEEDED, -1, "abandoned over its %s budget (%.3f ms, %ld bytes)",
+        getBudgetStatusName(budget->status),
+        budget->timeUsed * 1e3,
+        budget->memoryUsed);
+
+    freeTranspileTrees(result);
+}
+
+bool lexStage(TranspileResult *result) {
+    setDiagnosticFile(result->file->index);
+
+    const long traceStart = beginTrace();
+    const double startTime = getCurrentTime();
+    beginBudget(&result->budget);
+    Vector *tokens = lexWithDefines(result->source, result->file->project->defines);
+    endBudget(&result->budget);
+    const double endTime = getCurrentTime();
+    endTrace(traceStart, TRACE_PHASE, result->file->index, "lex");
+
+    result->lexTime = endTime - startTime;
+    free(result->source);
+    result->source = NULL;
+
+    if (tokens == NULL) {
+        if (result->budget.status != BUDGET_OK) {
+            abandonFile(result);
+        }
+
+        result->endTime = endTime;
+        return false;
+    }
+
+    result->tokens = tokens;
+    result->tokenCount = tokens->size;
+    return true;
+}
+
+bool parseStage(TranspileResult *result) {
+    setDiagnosticFile(result->file->index);
+    symbolIndex = result->file->project->symbols;
+
+    const long traceStart = beginTrace();
+    const double startTime = getCurrentTime();
+    beginBudget(&result->budget);
+    TransUnitNode *transUnitNode = parse(result->tokens);
+    endBudget(&result->budget);
+    const double endTime = getCurrentTime();
+    endTrace(traceStart, TRACE_PHASE, result->file->index, "parse");
+
+    result->parseTime = endTime - startTime;
+
+    if (transUnitNode == NULL) {
+        if (result->budget.status != BUDGET_OK) {
+            abandonFile(result);
+        }
+
+        freeTranspileTrees(result);
+        result->endTime = endTime;
+        return false;
+    }
+
+    result->transUnitNode = transUnitNode;
+    result->declarationCount = transUnitNode->externalDeclarationNodes->size;
+    return true;
+}
+
+bool emitStage(TranspileResult *result) {
+    const ProjectFile *file = result->file;
+    const Project *project = file->project;
+    setDiagnosticFile(file->index);
+
+    const long traceStart = beginTrace();
+    const double startTime = getCurrentTime();
+    Emitter *emitter = buildEmitter(file, project->name);
+    bool succeeded = true;
+
+    emitTransUnit(emitter, result->transUnitNode);
+    result->emittedBytes = emitter->output->size;
+    result->nodeCount = emitter->nodeCount;
+    result->variantCount = emitter->variantCount;
+    result->narrowedVariantCount = emitter->narrowedVariantCount;
+
+    char *outputPath = getOutputPath(file);
+
+    if (outputPath != NULL) {
+        succeeded = writeOutputIfChanged(emitter->output, outputPath, &result->outputWritten);
+        free(outputPath);
+    }
+
+    freeEmitter(emitter);
+    freeTranspileTrees(result);
+
+    result->endTime = getCurrentTime();
+    result->emitTime = result->endTime - startTime;
+    result->succeeded = succeeded;
+    endTrace(traceStart, TRACE_PHASE, file->index, "emit");
+    return succeeded;
+}
+
+void transpileFile(TranspileResult *result) {
+    result->worker = getCurrentWorker();
+
+    if (readStage(result) && lexStage(result) && parseStage(result)) {
+        emitStage(result);
+    }
+}
+
+void runTranspileTask(void *argument) {
+    transpileFile(argument);
+}
+
+int compareFileSizeDescending(const void *left, const void *right) {
+    const TranspileResult *a = *(TranspileResult *const *)left;
+    const TranspileResult *b = *(TranspileResult *const *)right;
+
+    if (a->file->size != b->file->size) {
+        return (a->file->size < b->file->size) ? 1 : -1;
+    }
+
+    return a->file->index - b->file->index;
+}
+
+TranspileResult *buildTranspileResults(const Project *project, const bool *selection, TranspileResult ***order, int *selectedCount) {
+    const int count = project->files->size;
+    TranspileResult *results = calloc(count, sizeof(TranspileResult));
+    *order = malloc(sizeof(TranspileResult*) * (count + 1));
+    *selectedCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        results[i].file = getProjectFile(project, i);
+        results[i].worker = -1;
+        results[i].selected = (selection == NULL || selection[i]);
+        initializeBudget(&results[i].budget, project->fileTimeLimit, project->fileMemoryLimit);
+
+        if (results[i].selected) {
+            (*order)[(*selectedCount)++] = &results[i];
+        }
+    }
+
+    // largest files first so the longest job never starts last
+    qsort(*order, *selectedCount, sizeof(TranspileResult*), compareFileSizeDescending);
+
+    return results;
+}
+
+void summarizeTranspileResults(TranspileResult *results, int count, double startTime, double endTime, TranspileSummary *summary) {
+    memset(summary, 0, sizeof(TranspileSummary));
+    summary->fileCount = count;
+    summary->wallTime = endTime - startTime;
+
+    for (int i = 0; i < count; i++) {
+        TranspileResult *result = &results[i];
+
+        if (!result->selected) {
+            summary->skippedCount++;
+            continue;
+        }
+
+        const double elapsed = result->endTime - result->startTime;
+
+        result->startTime -= startTime;
+        result->endTime -= startTime;
+        summary->workTime += elapsed;
+        summary->tokenCount += result->tokenCount;
+        summary->emittedBytes += result->emittedBytes;
+        summary->nodeCount += result->nodeCount;
+        summary->variantCount += result->variantCount;
+        summary->narrowedVariantCount += result->narrowedVariantCount;
+        summary->emitTime += result->emitTime;
+        summary->writtenCount += result->outputWritten;
+
+        if (result->file->size > 0) {
+            summary->sourceBytes += result->file->size;
+        }
+
+        if (!result->succeeded) {
+            summary->failureCount++;
+            summary->abandonedCount += result->abandoned;
+        }
+        else if (result->file->project->outputDirectory != NULL && !result->outputWritten) {
+            summary->unchangedCount++;
+        }
+
+        if (elapsed > summary->criticalPathTime) {
+            summary->criticalPathTime = elapsed;
+            summary->criticalPathResult = result;
+        }
+    }
+}
+
+TranspileResult *transpileProject(const Project *project, ThreadPool *pool, const bool *selection, TranspileSummary *summary) {
+    TranspileResult **order = NULL;
+    int selectedCount = 0;
+    TranspileResult *results = buildTranspileResults(project, selection, &order, &selectedCount);
+    const double startTime = getCurrentTime();
+
+    for (int i = 0; i < selectedCount; i++) {
+        submitThreadPool(pool, runTranspileTask, order[i]);
+    }
+
+    waitThreadPool(pool);
+
+    summarizeTranspileResults(results, project->files->size, startTime, getCurrentTime(), summary);
+    free(order);
+
+    return results;
+}
+
+void printTranspileReport(const TranspileResult *results, const TranspileSummary *summary, bool perFile) {
+    if (perFile) {
+        printf("%10s %10s %10s %10s %10s %8s %6s  %s\n", "total(ms)", "read(ms)", "lex(ms)", "parse(ms)", "emit(ms)", "tokens", "worker", "file");
+
+        for (int i = 0; i < summary->fileCount; i++) {
+            const TranspileResult *result = &results[i];
+
+            if (!result->selected) {
+                continue;
+            }
+
+            printf("%10.3f %10.3f %10.3f %10.3f %10.3f %8d %6d  %s%s\n",
+                (result->endTime - result->startTime) * 1e3,
+                result->readTime * 1e3,
+                result->lexTime * 1e3,
+                result->parseTime * 1e3,
+                result->emitTime * 1e3,
+                result->tokenCount,
+                result->worker,
+                result->file->path,
+                result->succeeded ? "" : result->abandoned ? " (abandoned)" : " (failed)");
+        }
+    }
+
+    printf("files: %d (%d failed, %d abandoned, %d skipped), %ld bytes, %ld tokens\n", summary->fileCount, summary->failureCount, summary->abandonedCount, summary->skippedCount, summary->sourceBytes, summary->tokenCount);
+    // work over wall is how busy the workers were on average, not a speedup over a single worker
+    printf("wall: %.3f ms, work: %.3f ms, parallel work ratio: %.2fx\n",
+        summary->wallTime * 1e3,
+        summary->workTime * 1e3,
+        (summary->wallTime > 0) ? summary->workTime / summary->wallTime : 0.0);
+
+    printf("emit: %ld bytes, %.1f MB/s, %d written, %d unchanged\n",
+        summary->emittedBytes,
+        (summary->emitTime > 0) ? summary->emittedBytes / summary->emitTime / 1e6 : 0.0,
+        summary->writtenCount,
+        summary->unchangedCount);
+
+    if (summary->variantCount > 0) {
+        printf("variants: %ld declared, %ld narrowed (%.1f%%)\n",
+            summary->variantCount,
+            summary->narrowedVariantCount,
+            100.0 * summary->narrowedVariantCount / summary->variantCount);
+    }
+
+    if (summary->criticalPathResult != NULL) {
+        printf("critical path: %.3f ms (%s)\n", summary->criticalPathTime * 1e3, summary->criticalPathResult->file->path);
+    }
+}
\ No newline at end of file
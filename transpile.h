@@ -0,0 +1,65 @@
+#pragma once
+
+#include "budget.h"
+#include "decode.h"
+#include "emitter.h"
+#include "parser.h"
+#include "project.h"
+#include "threadpool.h"
+#include "trace.h"
+
+typedef struct TranspileResult {
+    ProjectFile *file;
+    bool selected;
+    bool succeeded;
+    int worker;
+    int tokenCount;
+    int declarationCount;
+    long emittedBytes;
+    long nodeCount;
+    int variantCount;
+    int narrowedVariantCount;
+    bool outputWritten;
+    bool abandoned;
+    Budget budget;
+    char *source;
+    Vector *tokens;
+    TransUnitNode *transUnitNode;
+    double startTime;
+    double endTime;
+    double readTime;
+    double lexTime;
+    double parseTime;
+    double emitTime;
+} TranspileResult;
+
+typedef struct TranspileSummary {
+    int fileCount;
+    int failureCount;
+    int skippedCount;
+    int abandonedCount;
+    long sourceBytes;
+    long tokenCount;
+    long emittedBytes;
+    long nodeCount;
+    long variantCount;
+    long narrowedVariantCount;
+    int writtenCount;
+    int unchangedCount;
+    double emitTime;
+    double wallTime;
+    double workTime;
+    double criticalPathTime;
+    TranspileResult *criticalPathResult;
+} TranspileSummary;
+
+void freeTranspileTrees(TranspileResult *result);
+bool readStage(TranspileResult *result);
+bool lexStage(TranspileResult *result);
+bool parseStage(TranspileResult *result);
+bool emitStage(TranspileResult *result);
+void transpileFile(TranspileResult *result);
+TranspileResult *buildTranspileResults(const Project *project, const bool *selection, TranspileResult ***order, int *selectedCount);
+void summarizeTranspileResults(TranspileResult *results, int count, double startTime, double endTime, TranspileSummary *summary);
+TranspileResult *transpileProject(const Project *project, ThreadPool *pool, const bool *selection, TranspileSummary *summary);
+void printTranspileReport(const TranspileResult *results, const TranspileSummary *summary, bool perFile);
\ No newline at end of file
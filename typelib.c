@@ -0,0 +1,527 @@
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+
+#include "diagnostics.h"
+#include "typelib.h"
+
+#define LIBRARY_ALIGN(x) (((x) + 7) & ~(uint64_t)7)
+
+typedef struct TextMember {
+    char *name;
+    int kind;
+    char *signature;
+} TextMember;
+
+typedef struct TextType {
+    char *name;
+    int kind;
+    Vector *members;
+} TextType;
+
+typedef struct TextLibrary {
+    char *name;
+    char *guid;
+    char *version;
+    Vector *types;
+    int memberCount;
+    long stringSize;
+} TextLibrary;
+
+int getLibraryTypeKind(const char *word) {
+    static const char *names[] = { "class", "interface", "enum", "record", "module" };
+
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcasecmp(word, names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+int getLibraryMemberKind(const char *word) {
+    static const char *names[] = { "method", "property", "const", "field", "event" };
+
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcasecmp(word, names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+char *readLibraryWord(char **line) {
+    while (**line == ' ' || **line == '\t') {
+        (*line)++;
+    }
+
+    if (**line == '\0') {
+        return NULL;
+    }
+
+    char *word = *line;
+
+    while (**line != '\0' && **line != ' ' && **line != '\t') {
+        (*line)++;
+    }
+
+    if (**line != '\0') {
+        *(*line)++ = '\0';
+    }
+
+    return word;
+}
+
+char *pushLibraryString(TextLibrary *text, const char *value) {
+    text->stringSize += strlen(value) + 1;
+    return strdup(value);
+}
+
+void freeTextLibrary(TextLibrary *text) {
+    for (int i = 0; i < text->types->size; i++) {
+        TextType *type = text->types->contents[i];
+
+        for (int j = 0; j < type->members->size; j++) {
+            TextMember *member = type->members->contents[j];
+            free(member->name);
+            free(member->signature);
+            free(member);
+        }
+
+        free(type->members->contents);
+        free(type->members);
+        free(type->name);
+        free(type);
+    }
+
+    free(text->types->contents);
+    free(text->types);
+    free(text->name);
+    free(text->guid);
+    free(text->version);
+}
+
+bool readTextLibrary(TextLibrary *text, char *source, const char *path) {
+    char *savePointer = NULL;
+    char *line = strtok_r(source, "\n", &savePointer);
+    TextType *current = NULL;
+    int lineNumber = 0;
+
+    text->types = buildVectorList();
+    text->stringSize = 1;
+
+    for (; line != NULL; line = strtok_r(NULL, "\n", &savePointer)) {
+        lineNumber++;
+
+        int len = strlen(line);
+
+        while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ')) {
+            line[--len] = '\0';
+        }
+
+        char *keyword = readLibraryWord(&line);
+
+        if (keyword == NULL || keyword[0] == '#') {
+            continue;
+        }
+
+        char *name = readLibraryWord(&line);
+        char *kind = readLibraryWord(&line);
+
+        if (strcmp(keyword, "library") == 0 && name != NULL && kind != NULL && text->name == NULL) {
+            char *version = readLibraryWord(&line);
+            const int guidLength = strlen(kind);
+
+            // guids are stored bare, the way .vbp Reference lines are parsed
+            if (kind[0] == '{' && kind[guidLength - 1] == '}') {
+                kind[guidLength - 1] = '\0';
+                kind++;
+            }
+
+            text->name = pushLibraryString(text, name);
+            text->guid = pushLibraryString(text, kind);
+            text->version = pushLibraryString(text, (version != NULL) ? version : "0.0");
+        }
+        else if (strcmp(keyword, "type") == 0 && name != NULL && kind != NULL && getLibraryTypeKind(kind) >= 0) {
+            current = calloc(1, sizeof(TextType));
+            current->name = pushLibraryString(text, name);
+            current->kind = getLibraryTypeKind(kind);
+            current->members = buildVectorList();
+            pushVector(text->types, current);
+        }
+        else if (strcmp(keyword, "member") == 0 && name != NULL && kind != NULL && getLibraryMemberKind(kind) >= 0 && current != NULL) {
+            while (*line == ' ' || *line == '\t') {
+                line++;
+            }
+
+            TextMember *member = malloc(sizeof(TextMember));
+            member->name = pushLibraryString(text, name);
+            member->kind = getLibraryMemberKind(kind);
+            member->signature = pushLibraryString(text, line);
+            pushVector(current->members, member);
+            text->memberCount++;
+        }
+        else {
+            printf("error: %s:%d: malformed type library entry.\n", path, lineNumber);
+            return false;
+        }
+    }
+
+    if (text->name == NULL) {
+        printf("error: %s: missing library line.\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t copyLibraryString(char *strings, long *stringSize, const char *value) {
+    const uint32_t offset = *stringSize;
+    const long length = strlen(value) + 1;
+
+    memcpy(&strings[offset], value, length);
+    *stringSize += length;
+
+    return offset;
+}
+
+int compareLibraryMember(const void *left, const void *right) {
+    const LibraryMember *a = left;
+    const LibraryMember *b = right;
+
+    return (a->nameHash > b->nameHash) - (a->nameHash < b->nameHash);
+}
+
+void attachLibraryImage(TypeLibrary *library) {
+    library->header = (const LibraryHeader*)library->data;
+    library->types = (const LibraryType*)&library->data[library->header->typesOffset];
+    library->members = (const LibraryMember*)&library->data[library->header->membersOffset];
+    library->slots = (const int32_t*)&library->data[library->header->slotsOffset];
+    library->strings = &library->data[library->header->stringsOffset];
+}
+
+TypeLibrary *compileTypeLibrary(const char *source, const char *path) {
+    TextLibrary text = { 0 };
+    char *copy = strdup(source);
+
+    if (!readTextLibrary(&text, copy, path)) {
+        free(copy);
+        freeTextLibrary(&text);
+        return NULL;
+    }
+
+    free(copy);
+
+    const uint32_t typeCount = text.types->size;
+    uint32_t slotCount = 16;
+
+    while (slotCount < typeCount * 2) {
+        slotCount *= 2;
+    }
+
+    const uint64_t typesOffset = LIBRARY_ALIGN(sizeof(LibraryHeader));
+    const uint64_t membersOffset = LIBRARY_ALIGN(typesOffset + sizeof(LibraryType) * typeCount);
+    const uint64_t slotsOffset = LIBRARY_ALIGN(membersOffset + sizeof(LibraryMember) * text.memberCount);
+    const uint64_t stringsOffset = LIBRARY_ALIGN(slotsOffset + sizeof(int32_t) * slotCount);
+    const uint64_t size = LIBRARY_ALIGN(stringsOffset + text.stringSize);
+
+    TypeLibrary *library = calloc(1, sizeof(TypeLibrary));
+    library->size = size;
+    library->data = calloc(1, size);
+
+    LibraryHeader *header = (LibraryHeader*)library->data;
+    LibraryType *types = (LibraryType*)&library->data[typesOffset];
+    LibraryMember *members = (LibraryMember*)&library->data[membersOffset];
+    int32_t *slots = (int32_t*)&library->data[slotsOffset];
+    char *strings = &library->data[stringsOffset];
+    long stringSize = 1;
+
+    header->magic = TYPE_LIBRARY_MAGIC;
+    header->version = TYPE_LIBRARY_VERSION;
+    header->size = size;
+    header->nameOffset = copyLibraryString(strings, &stringSize, text.name);
+    header->guidOffset = copyLibraryString(strings, &stringSize, text.guid);
+    header->versionOffset = copyLibraryString(strings, &stringSize, text.version);
+    header->typeCount = typeCount;
+    header->memberCount = text.memberCount;
+    header->slotCount = slotCount;
+    header->typesOffset = typesOffset;
+    header->membersOffset = membersOffset;
+    header->slotsOffset = slotsOffset;
+    header->stringsOffset = stringsOffset;
+
+    memset(slots, -1, sizeof(int32_t) * slotCount);
+
+    uint32_t memberIndex = 0;
+
+    for (uint32_t i = 0; i < typeCount; i++) {
+        const TextType *textType = text.types->contents[i];
+        LibraryType *type = &types[i];
+
+        type->nameHash = calculateNameHash(textType->name, strlen(textType->name));
+        type->nameOffset = copyLibraryString(strings, &stringSize, textType->name);
+        type->kind = textType->kind;
+        type->firstMember = memberIndex;
+        type->memberCount = textType->members->size;
+
+        for (int j = 0; j < textType->members->size; j++) {
+            const TextMember *textMember = textType->members->contents[j];
+            LibraryMember *member = &members[memberIndex++];
+
+            member->nameHash = calculateNameHash(textMember->name, strlen(textMember->name));
+            member->nameOffset = copyLibraryString(strings, &stringSize, textMember->name);
+            member->signatureOffset = copyLibraryString(strings, &stringSize, textMember->signature);
+            member->kind = textMember->kind;
+            member->typeIndex = i;
+        }
+
+        qsort(&members[type->firstMember], type->memberCount, sizeof(LibraryMember), compareLibraryMember);
+
+        // a later type with the same name never shadows the first one
+        uint32_t slot = type->nameHash & (slotCount - 1);
+
+        while (slots[slot] >= 0 && strcasecmp(&strings[types[slots[slot]].nameOffset], textType->name) != 0) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+
+        if (slots[slot] < 0) {
+            slots[slot] = i;
+        }
+    }
+
+    freeTextLibrary(&text);
+    attachLibraryImage(library);
+
+    return library;
+}
+
+TypeLibrary *readTypeLibraryText(const char *path) {
+    char *source = readFile(path);
+
+    if (source == NULL) {
+        printf("error: could not read type library dump \"%s\".\n", path);
+        return NULL;
+    }
+
+    TypeLibrary *library = compileTypeLibrary(source, path);
+    free(source);
+
+    return library;
+}
+
+// the pool ends in a NUL, so any offset inside it reads a terminated string
+bool isLibraryStringOffset(const LibraryHeader *header, uint32_t offset) {
+    return header->stringsOffset + offset < header->size;
+}
+
+// A mapped image comes from disk, so before anything reads it every table has to fit in it, every offset and
+// index has to stay inside its table, and the slot table has to keep a free slot for lookups to stop at. That
+// is one pass over the tables at load; nothing is copied.
+bool isValidLibraryImage(const char *data, long size) {
+    const LibraryHeader *header = (const LibraryHeader*)data;
+
+    if (size < (long)sizeof(LibraryHeader) || header->magic != TYPE_LIBRARY_MAGIC || header->version != TYPE_LIBRARY_VERSION || header->size != (uint64_t)size) {
+        return false;
+    }
+
+    if (header->slotCount == 0 || (header->slotCount & (header->slotCount - 1)) != 0 || header->slotCount <= header->typeCount) {
+        return false;
+    }
+
+    const bool isLaidOut = header->typesOffset >= sizeof(LibraryHeader)
+        && header->typesOffset % 8 == 0 && header->membersOffset % 8 == 0 && header->slotsOffset % 8 == 0
+        && header->typesOffset + sizeof(LibraryType) * (uint64_t)header->typeCount <= header->membersOffset
+        && header->membersOffset + sizeof(LibraryMember) * (uint64_t)header->memberCount <= header->slotsOffset
+        && header->slotsOffset + sizeof(int32_t) * (uint64_t)header->slotCount <= header->stringsOffset
+        && header->stringsOffset < (uint64_t)size
+        && data[size - 1] == '\0';
+
+    if (!isLaidOut || !isLibraryStringOffset(header, header->nameOffset) || !isLibraryStringOffset(header, header->guidOffset) || !isLibraryStringOffset(header, header->versionOffset)) {
+        return false;
+    }
+
+    const LibraryType *types = (const LibraryType*)&data[header->typesOffset];
+    const LibraryMember *members = (const LibraryMember*)&data[header->membersOffset];
+    const int32_t *slots = (const int32_t*)&data[header->slotsOffset];
+
+    for (uint32_t i = 0; i < header->typeCount; i++) {
+        if (!isLibraryStringOffset(header, types[i].nameOffset) || (uint64_t)types[i].firstMember + types[i].memberCount > header->memberCount) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->memberCount; i++) {
+        if (!isLibraryStringOffset(header, members[i].nameOffset) || !isLibraryStringOffset(header, members[i].signatureOffset) || members[i].typeIndex >= header->typeCount) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->slotCount; i++) {
+        if (slots[i] < -1 || slots[i] >= (int64_t)header->typeCount) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// The image is used straight from the page cache: nothing is parsed or copied at startup. One that cannot
+// be used is left out with a warning against the project, so the build goes on without it as VB's would.
+TypeLibrary *mapTypeLibrary(const char *path) {
+    const int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(LibraryHeader)) {
+        reportWarning(DIAGNOSTIC_TYPE_LIBRARY_IGNORED, -1, "ignoring unreadable type library \"%s\"", path);
+        close(fd);
+        return NULL;
+    }
+
+    char *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        reportWarning(DIAGNOSTIC_TYPE_LIBRARY_IGNORED, -1, "could not map type library \"%s\"", path);
+        return NULL;
+    }
+
+    if (!isValidLibraryImage(data, st.st_size)) {
+        reportWarning(DIAGNOSTIC_TYPE_LIBRARY_IGNORED, -1, "ignoring incompatible type library \"%s\"", path);
+        munmap(data, st.st_size);
+        return NULL;
+    }
+
+    TypeLibrary *library = calloc(1, sizeof(TypeLibrary));
+    library->data = data;
+    library->size = st.st_size;
+    library->mapped = true;
+    attachLibraryImage(library);
+
+    return library;
+}
+
+bool writeTypeLibrary(const char *path, const TypeLibrary *library) {
+    char *temporaryPath = malloc(strlen(path) + 5);
+    sprintf(temporaryPath, "%s.tmp", path);
+
+    FILE *fp = fopen(temporaryPath, "wb");
+
+    if (fp == NULL) {
+        printf("error: could not write type library \"%s\".\n", temporaryPath);
+        free(temporaryPath);
+        return false;
+    }
+
+    const bool written = (fwrite(library->data, 1, library->size, fp) == (size_t)library->size);
+    const bool succeeded = (fclose(fp) == 0 && written && rename(temporaryPath, path) == 0);
+
+    if (!succeeded) {
+        printf("error: could not replace type library \"%s\".\n", path);
+        unlink(temporaryPath);
+    }
+
+    free(temporaryPath);
+    return succeeded;
+}
+
+void freeTypeLibrary(TypeLibrary *library) {
+    if (library->mapped) {
+        munmap(library->data, library->size);
+    }
+    else {
+        free(library->data);
+    }
+
+    free(library);
+}
+
+const LibraryType *findLibraryType(const TypeLibrary *library, const char *name) {
+    const uint64_t nameHash = calculateNameHash(name, strlen(name));
+    const uint32_t mask = library->header->slotCount - 1;
+    uint32_t slot = nameHash & mask;
+
+    while (library->slots[slot] >= 0) {
+        const LibraryType *type = &library->types[library->slots[slot]];
+
+        if (type->nameHash == nameHash && strcasecmp(&library->strings[type->nameOffset], name) == 0) {
+            return type;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return NULL;
+}
+
+const LibraryMember *findLibraryMember(const TypeLibrary *library, const LibraryType *type, const char *name) {
+    const uint64_t nameHash = calculateNameHash(name, strlen(name));
+    uint32_t low = type->firstMember;
+    uint32_t high = type->firstMember + type->memberCount;
+
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+
+        if (library->members[middle].nameHash < nameHash) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    for (uint32_t i = low; i < type->firstMember + type->memberCount && library->members[i].nameHash == nameHash; i++) {
+        if (strcasecmp(&library->strings[library->members[i].nameOffset], name) == 0) {
+            return &library->members[i];
+        }
+    }
+
+    return NULL;
+}
+
+const char *getLibraryString(const TypeLibrary *library, uint32_t offset) {
+    return &library->strings[offset];
+}
+
+const char *getLibraryName(const TypeLibrary *library) {
+    return &library->strings[library->header->nameOffset];
+}
+
+const char *getLibraryGuid(const TypeLibrary *library) {
+    return &library->strings[library->header->guidOffset];
+}
+
+char *getTypeLibraryPath(const char *directory, const char *guid) {
+    char *path = malloc(strlen(directory) + strlen(guid) + 8);
+    sprintf(path, "%s/%s.vbtlb", directory, guid);
+
+    for (char *p = &path[strlen(directory) + 1]; *p != '.'; p++) {
+        *p = toupper((unsigned char)*p);
+    }
+
+    return path;
+}
+
+Vector *loadProjectTypeLibraries(const Project *project, const char *directory) {
+    Vector *libraries = buildVectorList();
+
+    for (int i = 0; project->references != NULL && i < project->references->size; i++) {
+        const ProjectReference *reference = project->references->contents[i];
+        char *path = getTypeLibraryPath(directory, reference->guid);
+        TypeLibrary *library = mapTypeLibrary(path);
+
+        if (library != NULL) {
+            pushVector(libraries, library);
+        }
+
+        free(path);
+    }
+
+    return libraries;
+}
\ No newline at end of file
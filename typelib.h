@@ -0,0 +1,84 @@
+#pragma once
+
+#include "project.h"
+
+#define TYPE_LIBRARY_MAGIC 0x4c544256
+#define TYPE_LIBRARY_VERSION 1
+
+enum LibraryTypeKind {
+    LIBRARY_CLASS,
+    LIBRARY_INTERFACE,
+    LIBRARY_ENUM,
+    LIBRARY_RECORD,
+    LIBRARY_MODULE
+};
+
+enum LibraryMemberKind {
+    LIBRARY_METHOD,
+    LIBRARY_PROPERTY,
+    LIBRARY_CONST,
+    LIBRARY_FIELD,
+    LIBRARY_EVENT
+};
+
+// Text dumps are line based:
+//   library <name> <guid> <version>
+//   type <name> class|interface|enum|record|module
+//   member <name> method|property|const|field|event <signature...>
+// and compile to one flat image that is used in place, whether it came from the text or from mmap.
+typedef struct LibraryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t guidOffset;
+    uint32_t versionOffset;
+    uint32_t typeCount;
+    uint32_t memberCount;
+    uint32_t slotCount;
+    uint64_t typesOffset;
+    uint64_t membersOffset;
+    uint64_t slotsOffset;
+    uint64_t stringsOffset;
+} LibraryHeader;
+
+typedef struct LibraryType {
+    uint64_t nameHash;
+    uint32_t nameOffset;
+    uint32_t kind;
+    uint32_t firstMember;
+    uint32_t memberCount;
+} LibraryType;
+
+// members of a type are sorted by name hash
+typedef struct LibraryMember {
+    uint64_t nameHash;
+    uint32_t nameOffset;
+    uint32_t signatureOffset;
+    uint32_t kind;
+    uint32_t typeIndex;
+} LibraryMember;
+
+typedef struct TypeLibrary {
+    char *data;
+    long size;
+    bool mapped;
+    const LibraryHeader *header;
+    const LibraryType *types;
+    const LibraryMember *members;
+    const int32_t *slots;
+    const char *strings;
+} TypeLibrary;
+
+TypeLibrary *compileTypeLibrary(const char *source, const char *path);
+TypeLibrary *readTypeLibraryText(const char *path);
+TypeLibrary *mapTypeLibrary(const char *path);
+bool writeTypeLibrary(const char *path, const TypeLibrary *library);
+void freeTypeLibrary(TypeLibrary *library);
+const LibraryType *findLibraryType(const TypeLibrary *library, const char *name);
+const LibraryMember *findLibraryMember(const TypeLibrary *library, const LibraryType *type, const char *name);
+const char *getLibraryString(const TypeLibrary *library, uint32_t offset);
+const char *getLibraryName(const TypeLibrary *library);
+const char *getLibraryGuid(const TypeLibrary *library);
+Vector *loadProjectTypeLibraries(const Project *project, const char *directory);
+char *getTypeLibraryPath(const char *directory, const char *guid);
\ No newline at end of file
@@ -18,6 +18,33 @@ char *readFile(const char *path) {
     return addr;
 }
 
+long getFileSize(const char *path) {
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        return -1;
+    }
+
+    return st.st_size;
+}
+
+double getCurrentTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int getCoreCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (count < 1) {
+        return 1;
+    }
+
+    return count;
+}
+
 Vector *buildVectorList() {
     Vector *vectorList = malloc(sizeof(Vector));
     vectorList->contents = calloc(16, sizeof(void*));
@@ -122,6 +149,30 @@ int calculateHash(const char *string) {
     return h;
 }
 
+uint64_t calculateNameHash(const char *string, int length) {
+    uint64_t h = 14695981039346656037ULL;
+
+    for (int i = 0; i < length; i++) {
+        h ^= (unsigned char)tolower((unsigned char)string[i]);
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+uint64_t updateContentHash(uint64_t h, const char *data, long length) {
+    for (long i = 0; i < length; i++) {
+        h ^= (unsigned char)data[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+uint64_t calculateContentHash(const char *data, long length) {
+    return updateContentHash(CONTENT_HASH_SEED, data, length);
+}
+
 void appendStringMap(StringMap *map, const char *key, void *value) {
     const int hash = calculateHash(key);
     const int index = hash % map->capacity;
@@ -192,6 +243,23 @@ void *getStringMap(StringMap *map, const char *key) {
     }
 }
 
+// the values belong to whoever appended them
+void freeStringMap(StringMap *map) {
+    for (int i = 0; i < map->capacity; i++) {
+        StringPointerMapEntry *current = map->entries[i];
+
+        while (current != NULL) {
+            StringPointerMapEntry *next = current->next;
+            free(current->key);
+            free(current);
+            current = next;
+        }
+    }
+
+    free(map->entries);
+    free(map);
+}
+
 StringIntegerMap *buildStringIntegerMap(int capacity) {
     StringIntegerMap *map = malloc(sizeof(StringIntegerMap));
     map->size = 0;
@@ -270,4 +338,85 @@ int getIntegerMap(StringIntegerMap *map, const char *key) {
         printf("no key=\"%s\"\n", key);
         exit(-1);
     }
+}
+
+void setStringIntegerMap(StringIntegerMap *map, const char *key, int value) {
+    const int hash = calculateHash(key);
+    const int index = hash % map->capacity;
+
+    for (StringIntegerMapEntry *current = map->entries[index]; current != NULL; current = current->next) {
+        if (strcmp(current->key, key) == 0) {
+            current->value = value;
+            return;
+        }
+    }
+
+    appendStringIntegerMap(map, key, value);
+}
+
+void freeStringIntegerMap(StringIntegerMap *map) {
+    for (int i = 0; i < map->capacity; i++) {
+        StringIntegerMapEntry *current = map->entries[i];
+
+        while (current != NULL) {
+            StringIntegerMapEntry *next = current->next;
+            free(current->key);
+            free(current);
+            current = next;
+        }
+    }
+
+    free(map->entries);
+    free(map);
+}
+
+Arena *buildArena(size_t blockSize) {
+    Arena *arena = calloc(1, sizeof(Arena));
+    arena->blockSize = blockSize;
+
+    return arena;
+}
+
+// Zeroed memory aligned for any type; a request larger than the block size gets a block of its own.
+void *allocateArena(Arena *arena, size_t size) {
+    const size_t alignment = sizeof(max_align_t);
+    size = (size + alignment - 1) & ~(alignment - 1);
+
+    ArenaBlock *block = arena->blocks;
+
+    if (block == NULL || block->used + size > block->size) {
+        const bool isOversized = (size > arena->blockSize);
+
+        block = malloc(sizeof(ArenaBlock) + (isOversized ? size : arena->blockSize));
+        block->size = isOversized ? size : arena->blockSize;
+        block->used = 0;
+
+        // an oversized block goes behind the current one, which still has room for the small requests
+        if (isOversized && arena->blocks != NULL) {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        }
+        else {
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+
+    void *memory = (char*)block->data + block->used;
+    block->used += size;
+    arena->allocated += size;
+
+    return memset(memory, 0, size);
+}
+
+void freeArena(Arena *arena) {
+    ArenaBlock *block = arena->blocks;
+
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    free(arena);
 }
\ No newline at end of file
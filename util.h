@@ -2,10 +2,20 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define CONTENT_HASH_SEED 14695981039346656037ULL
+
+// recorded in the build state, so a new vbt rebuilds everything its predecessor emitted
+#define TOOL_VERSION "1.3.0"
 
 typedef struct Vector {
     void** contents;
@@ -49,6 +59,20 @@ typedef struct StringIntegerMap {
     StringIntegerMapEntry** entries;
 } StringIntegerMap;
 
+// Bump allocator: many small, same-lifetime allocations released together by freeArena.
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    max_align_t data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* blocks;
+    size_t blockSize;
+    size_t allocated;
+} Arena;
+
 Vector* buildVectorList();
 Stack* buildStack();
 IntegerStack* initializeIntegerStack();
@@ -56,6 +80,9 @@ StringMap* buildStringMap(int capacity);
 StringIntegerMap* buildStringIntegerMap(int capacity);
 
 char* readFile(const char* path);
+long getFileSize(const char* path);
+double getCurrentTime();
+int getCoreCount();
 void pushVector(Vector* vec, void* e);
 void pushStack(Stack* stack, void* e);
 void* topOfStack(Stack* stack);
@@ -63,10 +90,19 @@ void popStack(Stack* stack);
 void pushIntegerStack(IntegerStack* stack, int e);
 int topOfIntegerStack(IntegerStack* stack);
 int calculateHash(const char* string);
+uint64_t calculateNameHash(const char* string, int length);
+uint64_t updateContentHash(uint64_t hash, const char* data, long length);
+uint64_t calculateContentHash(const char* data, long length);
 void popIntegerStack(IntegerStack* stack);
 void appendStringMap(StringMap* map, const char* key, void* value);
 bool stringMapContains(StringMap* map, const char* key);
 void* getStringMap(StringMap* map, const char* key);
+void freeStringMap(StringMap* map);
 void appendStringIntegerMap(StringIntegerMap* map, const char* key, int value);
 bool stringIntegerMapContains(StringIntegerMap* map, const char* key);
-int getIntegerMap(StringIntegerMap* map, const char* key);
\ No newline at end of file
+int getIntegerMap(StringIntegerMap* map, const char* key);
+void setStringIntegerMap(StringIntegerMap* map, const char* key, int value);
+void freeStringIntegerMap(StringIntegerMap* map);
+Arena* buildArena(size_t blockSize);
+void* allocateArena(Arena* arena, size_t size);
+void freeArena(Arena* arena);
\ No newline at end of file
@@ -0,0 +1,408 @@
+#include "walk.h"
+
+void walkCastPostfixes(const CastExpressionNode *castExpressionNode, PostfixVisitor visitor, void *context);
+
+void walkPostfixes(const PostfixExpressionNode *postfixExpressionNode, PostfixVisitor visitor, void *context) {
+    visitor(postfixExpressionNode, context);
+
+    if (postfixExpressionNode->postfixExpressionType == POSTFIX_PRIMARY || postfixExpressionNode->postfixExpressionNode == NULL) {
+        const PrimaryExpressionNode *primaryExpressionNode = postfixExpressionNode->primaryExpressionNode;
+
+        if (primaryExpressionNode != NULL && primaryExpressionNode->expressionNode != NULL) {
+            walkExpressionPostfixes(primaryExpressionNode->expressionNode, visitor, context);
+        }
+
+        return;
+    }
+
+    walkPostfixes(postfixExpressionNode->postfixExpressionNode, visitor, context);
+
+    if (postfixExpressionNode->expressionNode != NULL) {
+        walkExpressionPostfixes(postfixExpressionNode->expressionNode, visitor, context);
+    }
+
+    for (int i = 0; postfixExpressionNode->assignExpressionNodes != NULL && i < postfixExpressionNode->assignExpressionNodes->size; i++) {
+        walkAssignmentPostfixes(postfixExpressionNode->assignExpressionNodes->contents[i], visitor, context);
+    }
+}
+
+void walkUnaryPostfixes(const UnaryExpressionNode *unaryExpressionNode, PostfixVisitor visitor, void *context) {
+    switch (unaryExpressionNode->type) {
+        case UNARY_INCREMENT:
+        case UNARY_DECREMENT: {
+            walkUnaryPostfixes(unaryExpressionNode->unaryExpressionNode, visitor, context);
+            break;
+        }
+        case UNARY_OPERATOR: {
+            walkCastPostfixes(unaryExpressionNode->castExpressionNode, visitor, context);
+            break;
+        }
+        case UNARY_SIZE_IDENTIFIER:
+        case UNARY_SIZE_TYPE:
+        case UNARY_NEW: {
+            break;
+        }
+        default: {
+            if (unaryExpressionNode->postfixExpressionNode != NULL) {
+                walkPostfixes(unaryExpressionNode->postfixExpressionNode, visitor, context);
+            }
+
+            break;
+        }
+    }
+}
+
+void walkCastPostfixes(const CastExpressionNode *castExpressionNode, PostfixVisitor visitor, void *context) {
+    if (castExpressionNode->typeNameNode != NULL && castExpressionNode->castExpressionNode != NULL) {
+        walkCastPostfixes(castExpressionNode->castExpressionNode, visitor, context);
+    }
+    else if (castExpressionNode->unaryExpressionNode != NULL) {
+        walkUnaryPostfixes(castExpressionNode->unaryExpressionNode, visitor, context);
+    }
+}
+
+// The binary levels below all walk left operand, then right; only the node types differ.
+void walkMultiplicationPostfixes(const MultiplicationExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->multiplicationExpressionNode != NULL) {
+        walkMultiplicationPostfixes(node->multiplicationExpressionNode, visitor, context);
+    }
+
+    walkCastPostfixes(node->castExpressionNode, visitor, context);
+}
+
+void walkAdditionPostfixes(const AdditionExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->additionExpressionNode != NULL) {
+        walkAdditionPostfixes(node->additionExpressionNode, visitor, context);
+    }
+
+    walkMultiplicationPostfixes(node->multiplicationExpressionNode, visitor, context);
+}
+
+void walkShiftPostfixes(const ShiftExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->shiftExpressionNode != NULL) {
+        walkShiftPostfixes(node->shiftExpressionNode, visitor, context);
+    }
+
+    walkAdditionPostfixes(node->additionExpressionNode, visitor, context);
+}
+
+void walkRelationalPostfixes(const RelationalExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->relationalExpressionNode != NULL) {
+        walkRelationalPostfixes(node->relationalExpressionNode, visitor, context);
+    }
+
+    walkShiftPostfixes(node->shiftExpressionNode, visitor, context);
+}
+
+void walkEqualPostfixes(const EqualExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->equalExpressionNode != NULL) {
+        walkEqualPostfixes(node->equalExpressionNode, visitor, context);
+    }
+
+    walkRelationalPostfixes(node->relationalExpressionNode, visitor, context);
+}
+
+void walkAndPostfixes(const AndExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->andExpressionNode != NULL) {
+        walkAndPostfixes(node->andExpressionNode, visitor, context);
+    }
+
+    walkEqualPostfixes(node->equalExpressionNode, visitor, context);
+}
+
+void walkExclusiveOrPostfixes(const ExclusiveOrExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->exclusiveOrExpressionNode != NULL) {
+        walkExclusiveOrPostfixes(node->exclusiveOrExpressionNode, visitor, context);
+    }
+
+    walkAndPostfixes(node->andExpressionNode, visitor, context);
+}
+
+void walkInclusiveOrPostfixes(const InclusiveOrExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->inclusiveOrExpressionNode != NULL) {
+        walkInclusiveOrPostfixes(node->inclusiveOrExpressionNode, visitor, context);
+    }
+
+    walkExclusiveOrPostfixes(node->exclusiveOrExpressionNode, visitor, context);
+}
+
+void walkLogicalAndPostfixes(const LogicalAndExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->logicalAndExpressionNode != NULL) {
+        walkLogicalAndPostfixes(node->logicalAndExpressionNode, visitor, context);
+    }
+
+    walkInclusiveOrPostfixes(node->inclusiveOrExpressionNode, visitor, context);
+}
+
+void walkOrPostfixes(const OrExpressionNode *node, PostfixVisitor visitor, void *context) {
+    if (node->orExpressionNode != NULL) {
+        walkOrPostfixes(node->orExpressionNode, visitor, context);
+    }
+
+    walkLogicalAndPostfixes(node->logicalAndExpressionNode, visitor, context);
+}
+
+void walkConditionalPostfixes(const ConditionalExpressionNode *conditionalExpressionNode, PostfixVisitor visitor, void *context) {
+    walkOrPostfixes(conditionalExpressionNode->orExpressionNode, visitor, context);
+
+    if (conditionalExpressionNode->expressionNode != NULL && conditionalExpressionNode->conditionalExpressionNode != NULL) {
+        walkExpressionPostfixes(conditionalExpressionNode->expressionNode, visitor, context);
+        walkConditionalPostfixes(conditionalExpressionNode->conditionalExpressionNode, visitor, context);
+    }
+}
+
+void walkAssignmentPostfixes(const AssignmentExpressionNode *assignmentExpressionNode, PostfixVisitor visitor, void *context) {
+    if (assignmentExpressionNode->unaryExpressionNode != NULL && assignmentExpressionNode->assignExpressionNode != NULL) {
+        walkUnaryPostfixes(assignmentExpressionNode->unaryExpressionNode, visitor, context);
+        walkAssignmentPostfixes(assignmentExpressionNode->assignExpressionNode, visitor, context);
+    }
+    else if (assignmentExpressionNode->conditionalExpressionNode != NULL) {
+        walkConditionalPostfixes(assignmentExpressionNode->conditionalExpressionNode, visitor, context);
+    }
+}
+
+void walkExpressionPostfixes(const ExpressionNode *expressionNode, PostfixVisitor visitor, void *context) {
+    if (expressionNode == NULL) {
+        return;
+    }
+
+    if (expressionNode->expressionNode != NULL) {
+        walkExpressionPostfixes(expressionNode->expressionNode, visitor, context);
+    }
+
+    walkAssignmentPostfixes(expressionNode->assignExpressionNode, visitor, context);
+}
+
+void walkInitializerPostfixes(const InitializerNode *initializerNode, PostfixVisitor visitor, void *context) {
+    if (initializerNode->assignmentExpressionNode != NULL) {
+        walkAssignmentPostfixes(initializerNode->assignmentExpressionNode, visitor, context);
+        return;
+    }
+
+    for (int i = 0; initializerNode->initializerListNode != NULL && i < initializerNode->initializerListNode->initializerNodes->size; i++) {
+        walkInitializerPostfixes(initializerNode->initializerListNode->initializerNodes->contents[i], visitor, context);
+    }
+}
+
+void walkDeclarationPostfixes(const DeclarationNode *declarationNode, PostfixVisitor visitor, void *context) {
+    for (int i = 0; declarationNode->initializeDeclaratorNodes != NULL && i < declarationNode->initializeDeclaratorNodes->size; i++) {
+        const InitializeDeclaratorNode *initializeDeclaratorNode = declarationNode->initializeDeclaratorNodes->contents[i];
+
+        if (initializeDeclaratorNode->initializerNode != NULL) {
+            walkInitializerPostfixes(initializeDeclaratorNode->initializerNode, visitor, context);
+        }
+    }
+}
+
+void walkStatementPostfixes(const StatementNode *statementNode, PostfixVisitor visitor, void *context) {
+    if (statementNode == NULL) {
+        return;
+    }
+
+    if (statementNode->compoundStatementNode != NULL) {
+        const Vector *blockItemNodes = statementNode->compoundStatementNode->blockItemNodes;
+
+        for (int i = 0; blockItemNodes != NULL && i < blockItemNodes->size; i++) {
+            const BlockItemNode *blockItemNode = blockItemNodes->contents[i];
+
+            if (blockItemNode->declarationNode != NULL) {
+                walkDeclarationPostfixes(blockItemNode->declarationNode, visitor, context);
+            }
+            else {
+                walkStatementPostfixes(blockItemNode->statementNode, visitor, context);
+            }
+        }
+    }
+    else if (statementNode->expressionStatementNode != NULL) {
+        walkExpressionPostfixes(statementNode->expressionStatementNode->expressionNode, visitor, context);
+    }
+    else if (statementNode->selectionStatementNode != NULL) {
+        walkExpressionPostfixes(statementNode->selectionStatementNode->expressionNode, visitor, context);
+        walkStatementPostfixes(statementNode->selectionStatementNode->statementNode1, visitor, context);
+        walkStatementPostfixes(statementNode->selectionStatementNode->statementNode2, visitor, context);
+    }
+    else if (statementNode->iterationStatementNode != NULL) {
+        const IterationStatementNode *iterationStatementNode = statementNode->iterationStatementNode;
+
+        for (int i = 0; iterationStatementNode->declarationNodes != NULL && i < iterationStatementNode->declarationNodes->size; i++) {
+            walkDeclarationPostfixes(iterationStatementNode->declarationNodes->contents[i], visitor, context);
+        }
+
+        walkExpressionPostfixes(iterationStatementNode->expressionNode1, visitor, context);
+        walkExpressionPostfixes(iterationStatementNode->expressionNode2, visitor, context);
+        walkExpressionPostfixes(iterationStatementNode->expressionNode3, visitor, context);
+        walkStatementPostfixes(iterationStatementNode->statementNode, visitor, context);
+    }
+    else if (statementNode->jumpStatementNode != NULL) {
+        walkExpressionPostfixes(statementNode->jumpStatementNode->expressionNode, visitor, context);
+    }
+    else if (statementNode->labeledStatementNode != NULL) {
+        if (statementNode->labeledStatementNode->conditionalExpressionNode != NULL) {
+            walkConditionalPostfixes(statementNode->labeledStatementNode->conditionalExpressionNode, visitor, context);
+        }
+
+        walkStatementPostfixes(statementNode->labeledStatementNode->statementNode, visitor, context);
+    }
+    else if (statementNode->redimStatementNode != NULL) {
+        walkPostfixes(statementNode->redimStatementNode->postfixExpressionNode, visitor, context);
+    }
+}
+
+void walkStatements(const StatementNode *statementNode, StatementVisitor visitor, void *context) {
+    if (statementNode == NULL) {
+        return;
+    }
+
+    visitor(statementNode, context);
+
+    if (statementNode->compoundStatementNode != NULL) {
+        const Vector *blockItemNodes = statementNode->compoundStatementNode->blockItemNodes;
+
+        for (int i = 0; blockItemNodes != NULL && i < blockItemNodes->size; i++) {
+            walkStatements(((const BlockItemNode *)blockItemNodes->contents[i])->statementNode, visitor, context);
+        }
+    }
+    else if (statementNode->selectionStatementNode != NULL) {
+        walkStatements(statementNode->selectionStatementNode->statementNode1, visitor, context);
+        walkStatements(statementNode->selectionStatementNode->statementNode2, visitor, context);
+    }
+    else if (statementNode->iterationStatementNode != NULL) {
+        walkStatements(statementNode->iterationStatementNode->statementNode, visitor, context);
+    }
+    else if (statementNode->labeledStatementNode != NULL) {
+        walkStatements(statementNode->labeledStatementNode->statementNode, visitor, context);
+    }
+}
+
+typedef struct IdentifierCount {
+    const char *name;
+    int count;
+} IdentifierCount;
+
+void countIdentifier(const PostfixExpressionNode *postfixExpressionNode, void *context) {
+    IdentifierCount *identifierCount = context;
+    const char *identifier = getPostfixIdentifier(postfixExpressionNode);
+
+    identifierCount->count += (identifier != NULL && strcasecmp(identifier, identifierCount->name) == 0);
+}
+
+// VB names are case-insensitive
+int countIdentifierUses(const StatementNode *statementNode, const char *name) {
+    IdentifierCount identifierCount = { name, 0 };
+    walkStatementPostfixes(statementNode, countIdentifier, &identifierCount);
+    return identifierCount.count;
+}
+
+// the name a postfix expression refers to when it is a bare identifier, or NULL
+const char *getPostfixIdentifier(const PostfixExpressionNode *postfixExpressionNode) {
+    if (postfixExpressionNode == NULL || (postfixExpressionNode->postfixExpressionType != POSTFIX_PRIMARY && postfixExpressionNode->postfixExpressionNode != NULL)) {
+        return NULL;
+    }
+
+    return (postfixExpressionNode->primaryExpressionNode != NULL) ? postfixExpressionNode->primaryExpressionNode->identifier : NULL;
+}
+
+const PostfixExpressionNode *getUnaryPostfix(const UnaryExpressionNode *unaryExpressionNode) {
+    return (unaryExpressionNode != NULL && unaryExpressionNode->type == UNARY_NONE) ? unaryExpressionNode->postfixExpressionNode : NULL;
+}
+
+// the name of a bare variable reference, or NULL for anything else
+const char *getUnaryIdentifier(const UnaryExpressionNode *unaryExpressionNode) {
+    return getPostfixIdentifier(getUnaryPostfix(unaryExpressionNode));
+}
+
+// the unary expression a sum consists of, or NULL when it has an operator above that level
+const UnaryExpressionNode *getAdditionUnary(const AdditionExpressionNode *additionExpressionNode) {
+    if (additionExpressionNode->additionExpressionNode != NULL || additionExpressionNode->multiplicationExpressionNode->multiplicationExpressionNode != NULL) {
+        return NULL;
+    }
+
+    const CastExpressionNode *castExpressionNode = additionExpressionNode->multiplicationExpressionNode->castExpressionNode;
+    return (castExpressionNode->typeNameNode == NULL) ? castExpressionNode->unaryExpressionNode : NULL;
+}
+
+const PostfixExpressionNode *getAdditionPostfix(const AdditionExpressionNode *additionExpressionNode) {
+    return getUnaryPostfix(getAdditionUnary(additionExpressionNode));
+}
+
+const char *getAdditionIdentifier(const AdditionExpressionNode *additionExpressionNode) {
+    return getPostfixIdentifier(getAdditionPostfix(additionExpressionNode));
+}
+
+// the shift level of an expression with no operator above it, or NULL
+const ShiftExpressionNode *getAssignmentShift(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const ConditionalExpressionNode *conditionalExpressionNode = assignmentExpressionNode->conditionalExpressionNode;
+
+    if (assignmentExpressionNode->assignExpressionNode != NULL || conditionalExpressionNode == NULL || conditionalExpressionNode->expressionNode != NULL) {
+        return NULL;
+    }
+
+    const OrExpressionNode *orExpressionNode = conditionalExpressionNode->orExpressionNode;
+    const LogicalAndExpressionNode *logicalAndExpressionNode = (orExpressionNode->orExpressionNode == NULL) ? orExpressionNode->logicalAndExpressionNode : NULL;
+    const InclusiveOrExpressionNode *inclusiveOrExpressionNode = (logicalAndExpressionNode != NULL && logicalAndExpressionNode->logicalAndExpressionNode == NULL) ? logicalAndExpressionNode->inclusiveOrExpressionNode : NULL;
+    const ExclusiveOrExpressionNode *exclusiveOrExpressionNode = (inclusiveOrExpressionNode != NULL && inclusiveOrExpressionNode->inclusiveOrExpressionNode == NULL) ? inclusiveOrExpressionNode->exclusiveOrExpressionNode : NULL;
+    const AndExpressionNode *andExpressionNode = (exclusiveOrExpressionNode != NULL && exclusiveOrExpressionNode->exclusiveOrExpressionNode == NULL) ? exclusiveOrExpressionNode->andExpressionNode : NULL;
+    const EqualExpressionNode *equalExpressionNode = (andExpressionNode != NULL && andExpressionNode->andExpressionNode == NULL) ? andExpressionNode->equalExpressionNode : NULL;
+    const RelationalExpressionNode *relationalExpressionNode = (equalExpressionNode != NULL && equalExpressionNode->equalExpressionNode == NULL) ? equalExpressionNode->relationalExpressionNode : NULL;
+
+    return (relationalExpressionNode != NULL && relationalExpressionNode->relationalExpressionNode == NULL) ? relationalExpressionNode->shiftExpressionNode : NULL;
+}
+
+// the sum an expression consists of, or NULL when it has any operator above addition
+const AdditionExpressionNode *getAssignmentAddition(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const ShiftExpressionNode *shiftExpressionNode = getAssignmentShift(assignmentExpressionNode);
+    return (shiftExpressionNode != NULL && shiftExpressionNode->shiftExpressionNode == NULL) ? shiftExpressionNode->additionExpressionNode : NULL;
+}
+
+const UnaryExpressionNode *getAssignmentUnary(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const AdditionExpressionNode *additionExpressionNode = getAssignmentAddition(assignmentExpressionNode);
+    return (additionExpressionNode != NULL) ? getAdditionUnary(additionExpressionNode) : NULL;
+}
+
+const char *getAssignmentIdentifier(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const AdditionExpressionNode *additionExpressionNode = getAssignmentAddition(assignmentExpressionNode);
+    return (additionExpressionNode != NULL) ? getAdditionIdentifier(additionExpressionNode) : NULL;
+}
+
+// the & chain an expression consists of, or NULL when it is anything else at the top
+const ShiftExpressionNode *getConcatenation(const AssignmentExpressionNode *assignmentExpressionNode) {
+    const ShiftExpressionNode *shiftExpressionNode = getAssignmentShift(assignmentExpressionNode);
+    return (shiftExpressionNode != NULL && shiftExpressionNode->shiftExpressionNode != NULL && shiftExpressionNode->operatorType == OPERATOR_CONCAT) ? shiftExpressionNode : NULL;
+}
+
+// The variable a statement appends to, as "s = s & ..." or "s &= ...", or NULL.
+const char *getAccumulatedIdentifier(const StatementNode *statementNode) {
+    const ExpressionNode *expressionNode = (statementNode->expressionStatementNode != NULL) ? statementNode->expressionStatementNode->expressionNode : NULL;
+
+    if (expressionNode == NULL || expressionNode->expressionNode != NULL) {
+        return NULL;
+    }
+
+    const AssignmentExpressionNode *assignmentExpressionNode = expressionNode->assignExpressionNode;
+    const char *name = getUnaryIdentifier(assignmentExpressionNode->unaryExpressionNode);
+
+    if (name == NULL || assignmentExpressionNode->assignExpressionNode == NULL) {
+        return NULL;
+    }
+
+    if (assignmentExpressionNode->assignOperator == OPERATOR_CONCAT_EQUAL) {
+        return name;
+    }
+
+    const ShiftExpressionNode *shiftExpressionNode = (assignmentExpressionNode->assignOperator == OPERATOR_ASSIGN) ? getConcatenation(assignmentExpressionNode->assignExpressionNode) : NULL;
+
+    if (shiftExpressionNode == NULL) {
+        return NULL;
+    }
+
+    while (shiftExpressionNode->shiftExpressionNode != NULL && shiftExpressionNode->operatorType == OPERATOR_CONCAT) {
+        shiftExpressionNode = shiftExpressionNode->shiftExpressionNode;
+    }
+
+    if (shiftExpressionNode->shiftExpressionNode != NULL) {
+        return NULL;
+    }
+
+    const char *first = getAdditionIdentifier(shiftExpressionNode->additionExpressionNode);
+    return (first != NULL && strcasecmp(first, name) == 0) ? name : NULL;
+}
\ No newline at end of file
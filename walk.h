@@ -0,0 +1,30 @@
+#pragma once
+
+#include "parser.h"
+
+// called for every postfix expression, before the ones nested in it; bare identifiers and
+// constants are postfix expressions of type POSTFIX_PRIMARY
+typedef void (*PostfixVisitor)(const PostfixExpressionNode *postfixExpressionNode, void *context);
+
+// called for a statement before the statements nested in it
+typedef void (*StatementVisitor)(const StatementNode *statementNode, void *context);
+
+void walkPostfixes(const PostfixExpressionNode *postfixExpressionNode, PostfixVisitor visitor, void *context);
+void walkExpressionPostfixes(const ExpressionNode *expressionNode, PostfixVisitor visitor, void *context);
+void walkAssignmentPostfixes(const AssignmentExpressionNode *assignmentExpressionNode, PostfixVisitor visitor, void *context);
+void walkConditionalPostfixes(const ConditionalExpressionNode *conditionalExpressionNode, PostfixVisitor visitor, void *context);
+void walkStatementPostfixes(const StatementNode *statementNode, PostfixVisitor visitor, void *context);
+void walkStatements(const StatementNode *statementNode, StatementVisitor visitor, void *context);
+int countIdentifierUses(const StatementNode *statementNode, const char *name);
+const char *getPostfixIdentifier(const PostfixExpressionNode *postfixExpressionNode);
+const PostfixExpressionNode *getUnaryPostfix(const UnaryExpressionNode *unaryExpressionNode);
+const char *getUnaryIdentifier(const UnaryExpressionNode *unaryExpressionNode);
+const UnaryExpressionNode *getAdditionUnary(const AdditionExpressionNode *additionExpressionNode);
+const PostfixExpressionNode *getAdditionPostfix(const AdditionExpressionNode *additionExpressionNode);
+const char *getAdditionIdentifier(const AdditionExpressionNode *additionExpressionNode);
+const ShiftExpressionNode *getAssignmentShift(const AssignmentExpressionNode *assignmentExpressionNode);
+const AdditionExpressionNode *getAssignmentAddition(const AssignmentExpressionNode *assignmentExpressionNode);
+const UnaryExpressionNode *getAssignmentUnary(const AssignmentExpressionNode *assignmentExpressionNode);
+const char *getAssignmentIdentifier(const AssignmentExpressionNode *assignmentExpressionNode);
+const ShiftExpressionNode *getConcatenation(const AssignmentExpressionNode *assignmentExpressionNode);
+const char *getAccumulatedIdentifier(const StatementNode *statementNode);
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include <limits.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#include "watch.h"
+
+#define WATCH_BUFFER_SIZE 65536
+
+typedef struct WatchDirectory {
+    int descriptor;
+    char *path;
+} WatchDirectory;
+
+// The directory part through realpath and the file name as it is, so "M.bas", "./M.bas" and an absolute
+// path all give the key that an event's directory and name are joined into.
+char *getWatchPath(const char *path) {
+    char *directory = getDirectoryName(path);
+    char *canonical = realpath(directory, NULL);
+    const char *slash = strrchr(path, '/');
+    const char *name = (slash != NULL) ? slash + 1 : path;
+    free(directory);
+
+    if (canonical == NULL) {
+        return strdup(path);
+    }
+
+    char *watchPath = malloc(strlen(canonical) + strlen(name) + 2);
+    sprintf(watchPath, "%s/%s", canonical, name);
+    free(canonical);
+
+    return watchPath;
+}
+
+Vector *addWatchDirectories(int fd, const Project *project) {
+    Vector *directories = buildVectorList();
+
+    for (int i = 0; i < project->files->size; i++) {
+        char *directoryName = getDirectoryName(getProjectFile(project, i)->path);
+        char *path = realpath(directoryName, NULL);
+        bool found = false;
+
+        if (path == NULL) {
+            printf("error: could not watch \"%s\".\n", directoryName);
+            free(directoryName);
+            return NULL;
+        }
+
+        free(directoryName);
+
+        for (int j = 0; j < directories->size && !found; j++) {
+            const WatchDirectory *directory = directories->contents[j];
+            found = (strcmp(directory->path, path) == 0);
+        }
+
+        if (found) {
+            free(path);
+            continue;
+        }
+
+        WatchDirectory *directory = malloc(sizeof(WatchDirectory));
+        directory->path = path;
+        directory->descriptor = inotify_add_watch(fd, path, IN_CLOSE_WRITE | IN_MOVED_TO);
+
+        if (directory->descriptor < 0) {
+            printf("error: could not watch \"%s\".\n", path);
+            return NULL;
+        }
+
+        pushVector(directories, directory);
+    }
+
+    return directories;
+}
+
+StringMap *buildWatchFileMap(const Project *project) {
+    StringMap *fileMap = buildStringMap(project->files->size * 2 + 1);
+
+    for (int i = 0; i < project->files->size; i++) {
+        ProjectFile *file = getProjectFile(project, i);
+        char *path = getWatchPath(file->path);
+        appendStringMap(fileMap, path, file);
+        free(path);
+    }
+
+    return fileMap;
+}
+
+int readWatchEvents(int fd, const Vector *directories, StringMap *fileMap) {
+    char buffer[WATCH_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const ssize_t length = read(fd, buffer, sizeof(buffer));
+    int count = 0;
+
+    for (ssize_t pos = 0; pos < length; ) {
+        const struct inotify_event *event = (const struct inotify_event*)&buffer[pos];
+        pos += sizeof(struct inotify_event) + event->len;
+
+        if (event->len == 0) {
+            continue;
+        }
+
+        for (int i = 0; i < directories->size; i++) {
+            const WatchDirectory *directory = directories->contents[i];
+
+            if (directory->descriptor != event->wd) {
+                continue;
+            }
+
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s", directory->path, event->name);
+
+            if (stringMapContains(fileMap, path)) {
+                count++;
+            }
+
+            break;
+        }
+    }
+
+    return count;
+}
+
+void rebuildWatchedProject(WatchContext *context, double eventTime, double quietTime) {
+    Project *project = context->project;
+    RebuildPlan *plan = planRebuild(project, context->state, context->pool);
+
+    if (plan->dirtyCount == 0) {
+        freeRebuildPlan(plan);
+        return;
+    }
+
+    // the index is immutable, so it is replaced once no worker is reading it; only the edited files are
+    // scanned again, the rest keep their symbols
+    if (project->symbols != NULL) {
+        bool *changed = calloc(project->files->size + 1, sizeof(bool));
+
+        for (int i = 0; i < project->files->size; i++) {
+            changed[i] = (plan->status[i] == MODULE_DIRTY);
+        }
+
+        SymbolIndex *symbols = patchSymbolIndex(project->symbols, project, changed, context->pool);
+        freeSymbolIndex(project->symbols);
+        project->symbols = symbols;
+        free(changed);
+    }
+
+    TranspileSummary summary;
+    TranspileResult *results = transpileProject(project, context->pool, plan->selection, &summary);
+    bool *succeeded = calloc(project->files->size + 1, sizeof(bool));
+
+    for (int i = 0; i < project->files->size; i++) {
+        // a rebuild lexes and parses the changed files again; the results hold no trees to reuse
+        if (plan->selection[i]) {
+            context->results[i] = results[i];
+        }
+
+        succeeded[i] = context->results[i].succeeded;
+    }
+
+    if (context->state != NULL) {
+        freeBuildState(context->state);
+    }
+
+    context->state = makeNextBuildState(plan, succeeded);
+
+    if (context->statePath != NULL) {
+        writeBuildState(context->statePath, context->state);
+    }
+
+    const double endTime = getCurrentTime();
+
+    flushDiagnostics(project, context->diagnosticFormat);
+
+    for (int i = 0; i < project->files->size && context->perFile; i++) {
+        if (plan->status[i] != MODULE_CLEAN) {
+            printf("  %s %s%s\n", (plan->status[i] == MODULE_DIRTY) ? "changed:  " : "dependent:", getProjectFile(project, i)->path, context->results[i].succeeded ? "" : " (failed)");
+        }
+    }
+
+    printf("rebuilt %d dirty, %d dependent in %.3f ms (save to output %.3f ms, debounce %.3f ms)\n",
+        plan->dirtyCount,
+        plan->dependentCount,
+        (endTime - quietTime) * 1e3,
+        (endTime - eventTime) * 1e3,
+        (quietTime - eventTime) * 1e3);
+    fflush(stdout);
+
+    freeRebuildPlan(plan);
+    free(succeeded);
+    free(results);
+}
+
+int watchProject(WatchContext *context) {
+    const int fd = inotify_init1(IN_CLOEXEC);
+
+    if (fd < 0) {
+        printf("error: inotify is not available.\n");
+        return 1;
+    }
+
+    Vector *directories = addWatchDirectories(fd, context->project);
+
+    if (directories == NULL) {
+        close(fd);
+        return 1;
+    }
+
+    StringMap *fileMap = buildWatchFileMap(context->project);
+
+    printf("watching %d files in %d directories\n", context->project->files->size, directories->size);
+    fflush(stdout);
+
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    while (true) {
+        if (poll(&pfd, 1, -1) < 0) {
+            break;
+        }
+
+        const double eventTime = getCurrentTime();
+        int count = readWatchEvents(fd, directories, fileMap);
+
+        // editors save in bursts, wait until the directory goes quiet
+        while (poll(&pfd, 1, context->debounceTime) > 0) {
+            count += readWatchEvents(fd, directories, fileMap);
+        }
+
+        if (count > 0) {
+            rebuildWatchedProject(context, eventTime, getCurrentTime());
+        }
+    }
+
+    close(fd);
+    return 0;
+}
\ No newline at end of file
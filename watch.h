@@ -0,0 +1,21 @@
+#pragma once
+
+#include "buildstate.h"
+#include "transpile.h"
+
+typedef struct WatchContext {
+    Project *project;
+    ThreadPool *pool;
+    TranspileResult *results;
+    BuildState *state;
+    const char *statePath;
+    int debounceTime;
+    bool perFile;
+    int diagnosticFormat;
+} WatchContext;
+
+char *getWatchPath(const char *path);
+Vector *addWatchDirectories(int fd, const Project *project);
+StringMap *buildWatchFileMap(const Project *project);
+int readWatchEvents(int fd, const Vector *directories, StringMap *fileMap);
+int watchProject(WatchContext *context);
\ No newline at end of file